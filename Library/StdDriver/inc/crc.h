@@ -49,9 +49,38 @@ extern "C"
 #define CRC_CPU_WDATA_16    (1UL << CRC_CTL_DATLEN_Pos) /*!<CRC CPU Write Data length is 16-bit \hideinitializer */
 #define CRC_CPU_WDATA_32    (2UL << CRC_CTL_DATLEN_Pos) /*!<CRC CPU Write Data length is 32-bit \hideinitializer */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Streaming CRC Constant Definitions                                                                     */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CRC_PDMA_NONE       0xFFUL                      /*!<CRC_Update feeds data by CPU instead of PDMA \hideinitializer */
+#define CRC_PDMA_MIN_LEN    64UL                        /*!<Shortest run in bytes CRC_Update hands to PDMA \hideinitializer */
+#define CRC_PDMA_MAX_CNT    65536UL                     /*!<Transfers per PDMA request, limited by TXCNT \hideinitializer */
+#define CRC_TIMEOUT_ERR     (-1L)                       /*!<CRC PDMA transfer abort due to timeout error \hideinitializer */
+
 /*@}*/ /* end of group CRC_EXPORTED_CONSTANTS */
 
 
+/** @addtogroup CRC_EXPORTED_STRUCTS CRC Exported Structs
+  @{
+*/
+
+/**
+  * @brief  Streaming CRC context.
+  * @details The running checksum is kept as the raw engine state, without checksum reverse or complement,
+  *          so it can be reloaded as the seed by the next CRC_Update and several contexts can share the
+  *          CRC engine. CRC_Final applies the checksum attributes.
+  */
+typedef struct
+{
+    uint32_t u32Mode;           /*!< CRC polynomial mode, CRC_CCITT, CRC_8, CRC_16 or CRC_32 */
+    uint32_t u32Attribute;      /*!< Combination of CRC_CHECKSUM_COM, CRC_CHECKSUM_RVS, CRC_WDATA_COM and CRC_WDATA_RVS */
+    uint32_t u32Checksum;       /*!< Raw running checksum */
+    uint32_t u32PdmaCh;         /*!< PDMA channel used by CRC_Update, or CRC_PDMA_NONE */
+} CRC_CTX_T;
+
+/*@}*/ /* end of group CRC_EXPORTED_STRUCTS */
+
+
 /** @addtogroup CRC_EXPORTED_FUNCTIONS CRC Exported Functions
   @{
 */
@@ -97,6 +126,10 @@ extern "C"
 
 void CRC_Open(uint32_t u32Mode, uint32_t u32Attribute, uint32_t u32Seed, uint32_t u32DataLen);
 uint32_t CRC_GetChecksum(void);
+void CRC_Init(CRC_CTX_T *psCtx, uint32_t u32Mode, uint32_t u32Attribute, uint32_t u32Seed, uint32_t u32PdmaCh);
+int32_t CRC_Update(CRC_CTX_T *psCtx, const void *pvData, uint32_t u32Len);
+void CRC_SwUpdate(CRC_CTX_T *psCtx, const void *pvData, uint32_t u32Len);
+uint32_t CRC_Final(CRC_CTX_T *psCtx);
 
 /*@}*/ /* end of group CRC_EXPORTED_FUNCTIONS */
 
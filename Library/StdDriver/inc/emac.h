@@ -29,8 +29,12 @@ extern "C"
 */
 
 #define EMAC_PHY_ADDR      1UL    /*!<  PHY address, this address is board dependent \hideinitializer */
-#define EMAC_RX_DESC_SIZE  4UL    /*!<  Number of Rx Descriptors, should be 2 at least \hideinitializer */
-#define EMAC_TX_DESC_SIZE  4UL    /*!<  Number of Tx Descriptors, should be 2 at least \hideinitializer */
+#ifndef EMAC_RX_DESC_SIZE
+#define EMAC_RX_DESC_SIZE  4UL    /*!<  Number of Rx Descriptors, should be 2 at least. Could be overridden at compile time \hideinitializer */
+#endif
+#ifndef EMAC_TX_DESC_SIZE
+#define EMAC_TX_DESC_SIZE  4UL    /*!<  Number of Tx Descriptors, should be 2 at least. Could be overridden at compile time \hideinitializer */
+#endif
 #define EMAC_CAMENTRY_NB   16UL   /*!<  Number of CAM \hideinitializer */
 #define EMAC_MAX_PKT_SIZE  1524UL /*!<  Number of HDR + EXTRA + VLAN_TAG + PAYLOAD + CRC \hideinitializer */
 
@@ -334,6 +338,7 @@ void EMAC_DisableTS(void);
 void EMAC_GetTime(uint32_t *pu32Sec, uint32_t *pu32Nsec);
 void EMAC_SetTime(uint32_t u32Sec, uint32_t u32Nsec);
 void EMAC_UpdateTime(uint32_t u32Neg, uint32_t u32Sec, uint32_t u32Nsec);
+void EMAC_AdjustFreq(int32_t i32Ppb);
 void EMAC_EnableAlarm(uint32_t u32Sec, uint32_t u32Nsec);
 void EMAC_DisableAlarm(void);
 
@@ -345,6 +350,10 @@ uint8_t *EMAC_ClaimFreeTXBuf(void);
 uint32_t EMAC_GetAvailRXBufSize(void);
 uint32_t EMAC_SendPktWoCopy(uint32_t u32Size);
 void EMAC_RecvPktDoneWoRxTrigger(void);
+uint32_t EMAC_SendPktReclaim(uint32_t *pu32Err);
+uint32_t EMAC_SendPktReclaimTS(uint32_t *pu32Sec, uint32_t *pu32Nsec, uint32_t *pu32Err);
+uint32_t EMAC_SendPktBurst(uint8_t *apu8Data[], uint32_t au32Size[], uint32_t u32Num);
+uint32_t EMAC_RecvPktBurst(uint8_t *apu8Data[], uint32_t au32Size[], uint32_t u32Num);
 
 /*@}*/ /* end of group EMAC_EXPORTED_FUNCTIONS */
 
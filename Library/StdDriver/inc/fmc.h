@@ -133,6 +133,26 @@ extern "C"
 
 /*@}*/ /* end of group FMC_EXPORTED_MACROS */
 
+
+/** @addtogroup FMC_EXPORTED_STRUCTS FMC Exported Structs
+  @{
+*/
+
+/**
+  * @brief  Counters of FMC_WriteImage. They are added to by each call, so clear them before an image.
+  */
+typedef struct
+{
+    uint32_t u32Pages;          /*!< Pages of the image                                    */
+    uint32_t u32SamePages;      /*!< Pages that already held the data and were left alone  */
+    uint32_t u32BlankPages;     /*!< Pages found all one, programmed without erase         */
+    uint32_t u32Erases;         /*!< Page erase commands                                   */
+    uint32_t u32ProgCalls;      /*!< Multi-word and single word program commands           */
+    uint32_t u32ProgBytes;      /*!< Bytes programmed; 0xFFFFFFFF-only bursts are skipped  */
+} FMC_IMG_STAT_T;
+
+/*@}*/ /* end of group FMC_EXPORTED_STRUCTS */
+
 /*---------------------------------------------------------------------------------------------------------*/
 /*  Global variables                                                                                       */
 /*---------------------------------------------------------------------------------------------------------*/
@@ -351,6 +371,7 @@ extern int32_t  FMC_ReadConfig(uint32_t u32Config[], uint32_t u32Count);
 extern int32_t  FMC_WriteConfig(uint32_t u32Config[], uint32_t u32Count);
 extern uint32_t FMC_GetChkSum(uint32_t u32addr, uint32_t u32count);
 extern uint32_t FMC_CheckAllOne(uint32_t u32addr, uint32_t u32count);
+extern int32_t  FMC_WriteImage(uint32_t u32Addr, const uint32_t pu32Buf[], uint32_t u32Len, FMC_IMG_STAT_T *psStat);
 extern int32_t  FMC_SetSPKey(uint32_t key[3], uint32_t kpmax, uint32_t kemax, const int32_t lock_CONFIG, const int32_t lock_SPROM);
 extern int32_t  FMC_CompareSPKey(uint32_t key[3]);
 
@@ -73,6 +73,10 @@ extern "C"
 #define SDH_ERR_FAIL        (-1L)          /*!< SDH operation failed \hideinitializer */
 #define SDH_ERR_TIMEOUT     (-2L)          /*!< SDH operation abort due to timeout error \hideinitializer */
 
+/*--- request direction of SDH_SubmitRequest() */
+#define SDH_REQ_READ        0ul            /*!< Read sectors from card \hideinitializer */
+#define SDH_REQ_WRITE       1ul            /*!< Write sectors to card \hideinitializer */
+
 /*@}*/ /* end of group SDH_EXPORTED_CONSTANTS */
 
 /** @addtogroup SDH_EXPORTED_TYPEDEF SDH Exported Type Defines
@@ -93,6 +97,18 @@ typedef struct SDH_info_t
     int32_t         i32ErrCode;     /*!< SDH global error code */
 } SDH_INFO_T;                       /*!< Structure holds SD card info */
 
+typedef struct SDH_req_t
+{
+    struct SDH_req_t *next;         /*!< Queue link, owned by the driver while the request is queued */
+    uint32_t        u32Dir;         /*!< \ref SDH_REQ_READ or \ref SDH_REQ_WRITE */
+    uint8_t         *pu8BufAddr;    /*!< Word aligned data buffer */
+    uint32_t        u32StartSec;    /*!< Start sector address */
+    uint32_t        u32SecCount;    /*!< Sector number of data */
+    int32_t         i32Status;      /*!< \ref Successful or error code, valid in pfnComplete */
+    void (*pfnComplete)(struct SDH_req_t *psReq);  /*!< Called from SDH IRQ handler when the request is done */
+    void            *pvUserData;    /*!< Free for the caller */
+} SDH_REQ_T;                        /*!< Structure holds an asynchronous sector request */
+
 /*@}*/ /* end of group SDH_EXPORTED_TYPEDEF */
 
 /** @cond HIDDEN_SYMBOLS */
@@ -196,6 +212,11 @@ int32_t SDH_CardDetection(SDH_T *sdh);
 int32_t SDH_Open_Disk(SDH_T *sdh, uint32_t u32CardDetSrc);
 void SDH_Close_Disk(SDH_T *sdh);
 
+int32_t SDH_SubmitRequest(SDH_T *sdh, SDH_REQ_T *psReq);
+void SDH_QueueHandler(SDH_T *sdh);
+int32_t SDH_FlushQueue(SDH_T *sdh);
+uint32_t SDH_IsQueueIdle(SDH_T *sdh);
+
 
 /*@}*/ /* end of group SDH_EXPORTED_FUNCTIONS */
 
@@ -49,6 +49,18 @@ extern "C"
 #define SPIM_CTL0_OPMODE_PAGEREAD       (2UL << SPIM_CTL0_OPMODE_Pos)           /*!< SPIM_CTL0: Page Read Mode \hideinitializer */
 #define SPIM_CTL0_OPMODE_DIRECTMAP      (3UL << SPIM_CTL0_OPMODE_Pos)           /*!< SPIM_CTL0: Direct Map Mode \hideinitializer */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/* DMM performance mode constant definitions                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+#define SPIM_DMM_CACHE_OFF              0UL     /*!< DMM mode: every read goes to SPI flash \hideinitializer */
+#define SPIM_DMM_CACHE_ON               1UL     /*!< DMM mode: reads are cached in lines of SPIM_DMM_LINE_SIZE bytes \hideinitializer */
+#define SPIM_DMM_CACHE_CCM              2UL     /*!< DMM mode: cache memory is used as CCM, reads are not cached \hideinitializer */
+#define SPIM_DMM_OPT_BURST_WRAP         0x1UL   /*!< DMM mode: fill cache lines by 16-byte burst wrap, needed word first (Winbond, 0xEB/0xE7, cache on) \hideinitializer */
+#define SPIM_DMM_OPT_CONT_READ          0x2UL   /*!< DMM mode: continuous read mode, no command phase after the first read (0xBB/0xEB/0xE7) \hideinitializer */
+#define SPIM_DMM_DEFAULT                0xFFUL  /*!< DMM mode: keep hardware default of a mode bits, dummy cycle or deselect time field \hideinitializer */
+#define SPIM_DMM_LINE_SIZE              16UL    /*!< DMM mode: cache line size in bytes \hideinitializer */
+#define SPIM_DMM_ERR_PARAM              (-1)    /*!< DMM mode: read command does not support the requested cache or option \hideinitializer */
+
 #define CMD_NORMAL_PAGE_PROGRAM         (0x02UL << SPIM_CTL0_CMDCODE_Pos)       /*!< SPIM_CTL0: Page Program (Page Write Mode Use) \hideinitializer */
 #define CMD_NORMAL_PAGE_PROGRAM_4B      (0x12UL << SPIM_CTL0_CMDCODE_Pos)       /*!< SPIM_CTL0: Page Program (Page Write Mode Use) \hideinitializer */
 #define CMD_QUAD_PAGE_PROGRAM_WINBOND   (0x32UL << SPIM_CTL0_CMDCODE_Pos)       /*!< SPIM_CTL0: Quad Page program (for Winbond) (Page Write Mode Use) \hideinitializer */
@@ -117,6 +129,8 @@ E_MFGID;
 #define OPCODE_ENQPI            0x38U
 #define OPCODE_EXQPI            0xFFU
 
+#define OPCODE_SBW              0x77U   /* Set burst with wrap (Winbond) */
+
 /* Status Register bits. */
 #define SR_WIP                  0x1U    /* Write in progress */
 #define SR_WEL                  0x2U    /* Write enable latch */
@@ -137,6 +151,28 @@ E_MFGID;
 /*@}*/ /* end of group SPIM_EXPORTED_CONSTANTS */
 
 
+/** @addtogroup SPIM_EXPORTED_STRUCTS SPIM Exported Structs
+  @{
+*/
+
+/**
+  * @brief  Direct Map mode performance settings, see SPIM_DMM_Configure.
+  */
+typedef struct
+{
+    uint32_t u32RdCmd;          /*!< Read command, CMD_DMA_NORMAL_READ, CMD_DMA_FAST_READ, ... CMD_DMA_FAST_QUAD_READ */
+    uint32_t u32Is4ByteAddr;    /*!< 1: 4-byte address, 0: 3-byte address                       */
+    uint32_t u32IdleIntvl;      /*!< Idle interval between DMM accesses                          */
+    uint32_t u32CacheMode;      /*!< SPIM_DMM_CACHE_OFF, SPIM_DMM_CACHE_ON or SPIM_DMM_CACHE_CCM */
+    uint32_t u32Opt;            /*!< SPIM_DMM_OPT_BURST_WRAP and/or SPIM_DMM_OPT_CONT_READ      */
+    uint32_t u32ModeBits;       /*!< Continuous read mode bits of the flash, or SPIM_DMM_DEFAULT */
+    uint32_t u32DummyCycles;    /*!< Dummy cycles of the read command, or SPIM_DMM_DEFAULT      */
+    uint32_t u32DeselTime;      /*!< Minimum SS deselect time in AHB clocks, or SPIM_DMM_DEFAULT */
+} SPIM_DMM_CFG_T;
+
+/*@}*/ /* end of group SPIM_EXPORTED_STRUCTS */
+
+
 /** @addtogroup SPIM_EXPORTED_FUNCTIONS SPIM Exported Functions
   @{
 */
@@ -605,15 +641,18 @@ int  SPIM_Is4ByteModeEnable(uint32_t u32NBit);
 
 void SPIM_ChipErase(uint32_t u32NBit, int isSync);
 void SPIM_EraseBlock(uint32_t u32Addr, int is4ByteAddr, uint8_t u8ErsCmd, uint32_t u32NBit, int isSync);
+int  SPIM_IsWriteDone(uint32_t u32NBit);
 
 void SPIM_IO_Write(uint32_t u32Addr, int is4ByteAddr, uint32_t u32NTx, uint8_t pu8TxBuf[], uint8_t wrCmd, uint32_t u32NBitCmd, uint32_t u32NBitAddr, uint32_t u32NBitDat);
 void SPIM_IO_Read(uint32_t u32Addr, int is4ByteAddr, uint32_t u32NRx, uint8_t pu8RxBuf[], uint8_t rdCmd, uint32_t u32NBitCmd, uint32_t u32NBitAddr, uint32_t u32NBitDat, int u32NDummy);
 
 void SPIM_DMA_Write(uint32_t u32Addr, int is4ByteAddr, uint32_t u32NTx, uint8_t pu8TxBuf[], uint32_t wrCmd);
+int  SPIM_DMA_WritePage(uint32_t u32Addr, int is4ByteAddr, uint32_t u32NTx, uint8_t pu8TxBuf[], uint32_t wrCmd, int isSync);
 void SPIM_DMA_Read(uint32_t u32Addr, int is4ByteAddr, uint32_t u32NRx, uint8_t pu8RxBuf[], uint32_t u32RdCmd, int isSync);
 
 void SPIM_EnterDirectMapMode(int is4ByteAddr, uint32_t u32RdCmd, uint32_t u32IdleIntvl);
 void SPIM_ExitDirectMapMode(void);
+int  SPIM_DMM_Configure(const SPIM_DMM_CFG_T *psCfg);
 
 void SPIM_SetQuadEnable(int isEn, uint32_t u32NBit);
 
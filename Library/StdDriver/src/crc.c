@@ -16,6 +16,123 @@
   @{
 */
 
+/** @cond HIDDEN_SYMBOLS */
+
+static uint32_t s_au32CrcTable[256];                /* Software CRC lookup table                  */
+static uint32_t s_u32CrcTableMode = 0xFFFFFFFFUL;   /* Polynomial mode s_au32CrcTable is built for */
+
+/**
+  * @brief      Get CRC width in bits of a polynomial mode
+  */
+static uint32_t CRC_Width(uint32_t u32Mode)
+{
+    uint32_t u32Width;
+
+    switch(u32Mode)
+    {
+    case CRC_8:
+        u32Width = 8UL;
+        break;
+    case CRC_32:
+        u32Width = 32UL;
+        break;
+    default:
+        u32Width = 16UL;
+        break;
+    }
+
+    return u32Width;
+}
+
+/**
+  * @brief      Reverse the lowest u32Bits bits of u32Data
+  */
+static uint32_t CRC_Reflect(uint32_t u32Data, uint32_t u32Bits)
+{
+    uint32_t i, u32Ret = 0UL;
+
+    for(i = 0UL; i < u32Bits; i++)
+    {
+        u32Ret = (u32Ret << 1) | (u32Data & 1UL);
+        u32Data >>= 1;
+    }
+
+    return u32Ret;
+}
+
+/**
+  * @brief      Load a context into the CRC engine
+  * @details    Checksum reverse and complement are left disabled so CRC_CHECKSUM keeps the raw state.
+  */
+static void CRC_Load(CRC_CTX_T *psCtx, uint32_t u32DataLen)
+{
+    CRC->SEED = psCtx->u32Checksum;
+    CRC->CTL = psCtx->u32Mode | (psCtx->u32Attribute & (CRC_WDATA_COM | CRC_WDATA_RVS)) | u32DataLen | CRC_CTL_CRCEN_Msk;
+    CRC->CTL |= CRC_CTL_CHKSINIT_Msk;
+}
+
+/**
+  * @brief      Save the raw CRC engine state into a context
+  */
+static void CRC_Save(CRC_CTX_T *psCtx)
+{
+    uint32_t u32Width = CRC_Width(psCtx->u32Mode);
+
+    psCtx->u32Checksum = CRC->CHECKSUM & (0xFFFFFFFFUL >> (32UL - u32Width));
+}
+
+/**
+  * @brief      Write u32Count items of u32Width to CRC_DAT by PDMA
+  * @return     0 on success, CRC_TIMEOUT_ERR if PDMA did not finish
+  * @details    PDMA registers are programmed directly so that crc.c does not depend on pdma.c.
+  */
+static int32_t CRC_PdmaWrite(uint32_t u32Ch, uint32_t u32Src, uint32_t u32Width, uint32_t u32Count)
+{
+    volatile uint32_t *pu32ReqSel = &PDMA->REQSEL0_3 + (u32Ch >> 2);
+    uint32_t u32Cnt, u32Delay;
+    uint32_t u32Step = (u32Width == PDMA_WIDTH_32) ? 4UL : 1UL;
+    int32_t i32Ret = 0;
+
+    /* Software request, memory to fixed CRC_DAT */
+    *pu32ReqSel &= ~(PDMA_REQSEL0_3_REQSRC0_Msk << ((u32Ch & 3UL) * 8UL));
+    PDMA->CHCTL |= (1UL << u32Ch);
+
+    while(u32Count)
+    {
+        u32Cnt = (u32Count > CRC_PDMA_MAX_CNT) ? CRC_PDMA_MAX_CNT : u32Count;
+
+        PDMA->DSCT[u32Ch].SA = u32Src;
+        PDMA->DSCT[u32Ch].DA = (uint32_t)&CRC->DAT;
+        PDMA->DSCT[u32Ch].CTL = ((u32Cnt - 1UL) << PDMA_DSCT_CTL_TXCNT_Pos) | u32Width |
+                                PDMA_SAR_INC | PDMA_DAR_FIX | PDMA_REQ_BURST | PDMA_BURST_128 | PDMA_OP_BASIC;
+        PDMA_CLR_TD_FLAG(PDMA, 1UL << u32Ch);
+        PDMA->SWREQ = (1UL << u32Ch);
+
+        u32Delay = SystemCoreClock;
+        while((PDMA_GET_TD_STS(PDMA) & (1UL << u32Ch)) == 0UL)
+        {
+            if(--u32Delay == 0UL)
+            {
+                PDMA_STOP(PDMA, u32Ch);
+                i32Ret = CRC_TIMEOUT_ERR;
+                break;
+            }
+        }
+        PDMA_CLR_TD_FLAG(PDMA, 1UL << u32Ch);
+        if(i32Ret != 0)
+            break;
+
+        u32Src += u32Cnt * u32Step;
+        u32Count -= u32Cnt;
+    }
+
+    PDMA->CHCTL &= ~(1UL << u32Ch);
+
+    return i32Ret;
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
 /** @addtogroup CRC_EXPORTED_FUNCTIONS CRC Exported Functions
   @{
 */
@@ -86,6 +203,205 @@ uint32_t CRC_GetChecksum(void)
     return ret;
 }
 
+/**
+  * @brief      Initialize a Streaming CRC Context
+  *
+  * @param[in]  psCtx           The pointer of the CRC context.
+  * @param[in]  u32Mode         CRC operation polynomial mode. Valid values are:
+  *                             - \ref CRC_CCITT
+  *                             - \ref CRC_8
+  *                             - \ref CRC_16
+  *                             - \ref CRC_32
+  * @param[in]  u32Attribute    CRC operation data attribute. Valid values are combined with:
+  *                             - \ref CRC_CHECKSUM_COM
+  *                             - \ref CRC_CHECKSUM_RVS
+  *                             - \ref CRC_WDATA_COM
+  *                             - \ref CRC_WDATA_RVS
+  * @param[in]  u32Seed         Seed value.
+  * @param[in]  u32PdmaCh       PDMA channel CRC_Update may use to feed the CRC engine, or \ref CRC_PDMA_NONE.
+  *
+  * @return     None
+  *
+  * @details    This function starts a new checksum. The CRC engine is not touched until CRC_Update is called,
+  *             so several contexts can be open at a time. \n
+  *             Data is fed by CRC_Update (CRC engine) or CRC_SwUpdate (table-driven software); both give the same result.
+  * @note       The PDMA clock must be enabled by the caller if u32PdmaCh is not CRC_PDMA_NONE.
+  */
+void CRC_Init(CRC_CTX_T *psCtx, uint32_t u32Mode, uint32_t u32Attribute, uint32_t u32Seed, uint32_t u32PdmaCh)
+{
+    uint32_t u32Width = CRC_Width(u32Mode);
+
+    psCtx->u32Mode = u32Mode;
+    psCtx->u32Attribute = u32Attribute;
+    psCtx->u32Checksum = u32Seed & (0xFFFFFFFFUL >> (32UL - u32Width));
+    psCtx->u32PdmaCh = u32PdmaCh;
+}
+
+/**
+  * @brief      Feed Data to a Streaming CRC Context by CRC Engine
+  *
+  * @param[in]  psCtx           The pointer of the CRC context.
+  * @param[in]  pvData          The pointer of data. No alignment is required.
+  * @param[in]  u32Len          Data length in bytes.
+  *
+  * @retval     0               Success
+  * @retval     CRC_TIMEOUT_ERR PDMA transfer did not finish in time. The context is not valid any more.
+  *
+  * @details    This function can be called any number of times, e.g. once for each f_read buffer. \n
+  *             Runs of at least \ref CRC_PDMA_MIN_LEN bytes are written to CRC_DAT by PDMA in chunks of up to
+  *             \ref CRC_PDMA_MAX_CNT transfers. With \ref CRC_WDATA_RVS the aligned body is written as 32-bit words,
+  *             which the CRC engine consumes lowest byte first; otherwise it is written byte by byte.
+  */
+int32_t CRC_Update(CRC_CTX_T *psCtx, const void *pvData, uint32_t u32Len)
+{
+    const uint8_t *pu8Data = (const uint8_t *)pvData;
+    uint32_t u32Cnt;
+    int32_t i32Ret = 0;
+
+    CRC_Load(psCtx, CRC_CPU_WDATA_8);
+
+    if(psCtx->u32Attribute & CRC_WDATA_RVS)
+    {
+        /* Feed leading bytes by CPU until the data is word aligned */
+        while(u32Len && ((uint32_t)pu8Data & 3UL))
+        {
+            CRC->DAT = *pu8Data++;
+            u32Len--;
+        }
+
+        u32Cnt = u32Len >> 2;
+        if(u32Cnt)
+        {
+            CRC_Save(psCtx);
+            CRC_Load(psCtx, CRC_CPU_WDATA_32);
+
+            if((psCtx->u32PdmaCh != CRC_PDMA_NONE) && (u32Len >= CRC_PDMA_MIN_LEN))
+            {
+                i32Ret = CRC_PdmaWrite(psCtx->u32PdmaCh, (uint32_t)pu8Data, PDMA_WIDTH_32, u32Cnt);
+            }
+            else
+            {
+                const uint32_t *pu32Data = (const uint32_t *)pu8Data;
+                uint32_t i;
+
+                for(i = 0UL; i < u32Cnt; i++)
+                    CRC->DAT = pu32Data[i];
+            }
+
+            pu8Data += u32Cnt << 2;
+            u32Len &= 3UL;
+
+            CRC_Save(psCtx);
+            CRC_Load(psCtx, CRC_CPU_WDATA_8);
+        }
+    }
+    else if((psCtx->u32PdmaCh != CRC_PDMA_NONE) && (u32Len >= CRC_PDMA_MIN_LEN))
+    {
+        i32Ret = CRC_PdmaWrite(psCtx->u32PdmaCh, (uint32_t)pu8Data, PDMA_WIDTH_8, u32Len);
+        u32Len = 0UL;
+    }
+
+    /* Feed the remaining bytes by CPU */
+    if(i32Ret == 0)
+    {
+        while(u32Len--)
+            CRC->DAT = *pu8Data++;
+    }
+
+    CRC_Save(psCtx);
+
+    return i32Ret;
+}
+
+/**
+  * @brief      Feed Data to a Streaming CRC Context by Software
+  *
+  * @param[in]  psCtx           The pointer of the CRC context.
+  * @param[in]  pvData          The pointer of data.
+  * @param[in]  u32Len          Data length in bytes.
+  *
+  * @return     None
+  *
+  * @details    This function is the table-driven software equivalent of CRC_Update. It does not use the CRC engine
+  *             and can be mixed with CRC_Update on the same context. The 1 KB lookup table is rebuilt whenever the
+  *             polynomial mode differs from the previous call.
+  */
+void CRC_SwUpdate(CRC_CTX_T *psCtx, const void *pvData, uint32_t u32Len)
+{
+    const uint8_t *pu8Data = (const uint8_t *)pvData;
+    uint32_t u32Width = CRC_Width(psCtx->u32Mode);
+    uint32_t u32Mask = 0xFFFFFFFFUL >> (32UL - u32Width);
+    uint32_t u32Shift = u32Width - 8UL;
+    uint32_t u32Crc = psCtx->u32Checksum;
+    uint32_t u32Byte, i, j;
+
+    if(s_u32CrcTableMode != psCtx->u32Mode)
+    {
+        uint32_t u32Poly, u32Top = 1UL << (u32Width - 1UL);
+
+        switch(psCtx->u32Mode)
+        {
+        case CRC_8:
+            u32Poly = 0x07UL;
+            break;
+        case CRC_16:
+            u32Poly = 0x8005UL;
+            break;
+        case CRC_32:
+            u32Poly = 0x04C11DB7UL;
+            break;
+        default:
+            u32Poly = 0x1021UL;
+            break;
+        }
+
+        for(i = 0UL; i < 256UL; i++)
+        {
+            u32Byte = i << u32Shift;
+            for(j = 0UL; j < 8UL; j++)
+                u32Byte = (u32Byte & u32Top) ? ((u32Byte << 1) ^ u32Poly) : (u32Byte << 1);
+            s_au32CrcTable[i] = u32Byte & u32Mask;
+        }
+        s_u32CrcTableMode = psCtx->u32Mode;
+    }
+
+    while(u32Len--)
+    {
+        u32Byte = *pu8Data++;
+        if(psCtx->u32Attribute & CRC_WDATA_COM)
+            u32Byte ^= 0xFFUL;
+        if(psCtx->u32Attribute & CRC_WDATA_RVS)
+            u32Byte = CRC_Reflect(u32Byte, 8UL);
+        u32Crc = ((u32Crc << 8) ^ s_au32CrcTable[((u32Crc >> u32Shift) ^ u32Byte) & 0xFFUL]) & u32Mask;
+    }
+
+    psCtx->u32Checksum = u32Crc;
+}
+
+/**
+  * @brief      Get the Checksum of a Streaming CRC Context
+  *
+  * @param[in]  psCtx           The pointer of the CRC context.
+  *
+  * @return     Checksum Result
+  *
+  * @details    This function applies \ref CRC_CHECKSUM_RVS and \ref CRC_CHECKSUM_COM to the running checksum, giving
+  *             the same value CRC_GetChecksum returns after CRC_Open and feeding the same data.
+  *             The context is not modified, so more data may still be added afterwards.
+  */
+uint32_t CRC_Final(CRC_CTX_T *psCtx)
+{
+    uint32_t u32Width = CRC_Width(psCtx->u32Mode);
+    uint32_t u32Ret = psCtx->u32Checksum;
+
+    if(psCtx->u32Attribute & CRC_CHECKSUM_RVS)
+        u32Ret = CRC_Reflect(u32Ret, u32Width);
+    if(psCtx->u32Attribute & CRC_CHECKSUM_COM)
+        u32Ret = ~u32Ret & (0xFFFFFFFFUL >> (32UL - u32Width));
+
+    return u32Ret;
+}
+
 /*@}*/ /* end of group CRC_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group CRC_Driver */
@@ -128,6 +128,7 @@ static volatile EMAC_FRAME_T tx_buf[EMAC_TX_DESC_SIZE];
 
 static uint32_t u32CurrentTxDesc, u32NextTxDesc, u32CurrentRxDesc;
 static uint32_t s_u32EnableTs = 0UL;
+static uint32_t s_u32TsAddend = 0UL;  /* Nominal addend set by EMAC_EnableTS */
 
 static void EMAC_MdioWrite(uint32_t u32Reg, uint32_t u32Addr, uint32_t u32Data);
 static uint32_t EMAC_MdioRead(uint32_t u32Reg, uint32_t u32Addr);
@@ -790,6 +791,8 @@ uint32_t EMAC_SendPktDone(void)
             /* restore descriptor link list and data pointer they will be overwrite if time stamp enabled */
             desc->u32Data = desc->u32Backup1;
             desc->u32Next = desc->u32Backup2;
+            /* mark it reclaimed for EMAC_SendPktReclaim */
+            desc->u32Status2 = 0UL;
             /* go to next descriptor in link */
             desc = (EMAC_DESCRIPTOR_T *)desc->u32Next;
         } while (last_tx_desc != (uint32_t)desc);    /* If we reach last sent Tx descriptor, leave the loop */
@@ -870,6 +873,8 @@ uint32_t EMAC_SendPktDoneTS(uint32_t *pu32Sec, uint32_t *pu32Nsec)
             /* restore descriptor link list and data pointer they will be overwrite if time stamp enabled */
             desc->u32Data = desc->u32Backup1;
             desc->u32Next = desc->u32Backup2;
+            /* mark it reclaimed for EMAC_SendPktReclaim */
+            desc->u32Status2 = 0UL;
             /* go to next descriptor in link */
             desc = (EMAC_DESCRIPTOR_T *)desc->u32Next;
 
@@ -906,7 +911,7 @@ void EMAC_EnableTS(uint32_t u32Sec, uint32_t u32Nsec)
     f = (100.0 * 2147483648.0) / (1000000000.0) + 0.5;
     EMAC->TSINC = (reg = (uint32_t)f);
     f = (double)9223372036854775808.0 / ((double)(CLK_GetHCLKFreq()) * (double)reg);
-    EMAC->TSADDEND = (uint32_t)f;
+    EMAC->TSADDEND = s_u32TsAddend = (uint32_t)f;
     EMAC->TSCTL |= (EMAC_TSCTL_TSUPDATE_Msk | EMAC_TSCTL_TSIEN_Msk | EMAC_TSCTL_TSMODE_Msk); /* Fine update */
 }
 
@@ -997,6 +1002,30 @@ void EMAC_UpdateTime(uint32_t u32Neg, uint32_t u32Sec, uint32_t u32Nsec)
 
 }
 
+/**
+  * @brief  Adjust the rate of time stamp counter
+  * @param[in]  i32Ppb Rate offset from the nominal rate set by \ref EMAC_EnableTS, in parts per billion.
+  *                    Positive value makes the counter run faster.
+  * @return None
+  * @details The addend register is rescaled so the counter keeps running with a new rate, while
+  *          \ref EMAC_UpdateTime steps the current time. A clock servo, e.g. of IEEE 1588, uses
+  *          both of them.
+  * @note Time stamp function must be enabled by \ref EMAC_EnableTS in fine update mode first.
+  */
+void EMAC_AdjustFreq(int32_t i32Ppb)
+{
+    int64_t i64Addend;
+
+    i64Addend = (int64_t)s_u32TsAddend + ((int64_t)s_u32TsAddend * i32Ppb) / 1000000000LL;
+
+    if (i64Addend > (int64_t)0xFFFFFFFFLL)
+    {
+        i64Addend = (int64_t)0xFFFFFFFFLL;
+    }
+
+    EMAC->TSADDEND = (uint32_t)i64Addend;
+}
+
 /**
   * @brief  Check Ethernet link status
   * @param  None
@@ -1214,6 +1243,238 @@ void EMAC_RecvPktDoneWoRxTrigger(void)
 }
 
 
+/**
+  * @brief Reclaim the Tx descriptors EMAC has finished with
+  * @param[out] pu32Err Number of reclaimed packets failed to send. Could be NULL.
+  * @return Number of descriptors reclaimed
+  * @details \ref EMAC_SendPktBurst calls this function before it fills descriptors, so a burst sender
+  *          needs neither the Tx interrupt nor \ref EMAC_SendPktDone to get its descriptors back.
+  * @note This function and \ref EMAC_SendPktDone share the reclaim position, do not call them from
+  *       different contexts, e.g. this one from main loop while the other one from EMAC_TX_IRQHandler.
+  */
+uint32_t EMAC_SendPktReclaim(uint32_t *pu32Err)
+{
+    EMAC_DESCRIPTOR_T *desc;
+    uint32_t status;
+    uint32_t u32Count = 0UL, u32Err = 0UL;
+
+    desc = (EMAC_DESCRIPTOR_T *)u32CurrentTxDesc;
+
+    /* A finished descriptor is owned by CPU and has its status written by EMAC */
+    while ((u32Count < EMAC_TX_DESC_SIZE) && ((desc->u32Status1 & EMAC_DESC_OWN_EMAC) != EMAC_DESC_OWN_EMAC))
+    {
+        status = desc->u32Status2 >> 16UL;
+
+        if (status == 0UL)
+        {
+            break;
+        }
+
+        if ((status & EMAC_TXFD_TXCP) == 0UL)
+        {
+            u32Err++;
+        }
+
+        /* restore descriptor link list and data pointer they will be overwrite if time stamp enabled */
+        desc->u32Data = desc->u32Backup1;
+        desc->u32Next = desc->u32Backup2;
+        desc->u32Status2 = 0UL;
+        desc = (EMAC_DESCRIPTOR_T *)desc->u32Next;
+        u32Count++;
+    }
+
+    u32CurrentTxDesc = (uint32_t)desc;
+
+    if (pu32Err != NULL)
+    {
+        *pu32Err = u32Err;
+    }
+
+    return (u32Count);
+}
+
+/**
+  * @brief Reclaim the next Tx descriptor EMAC has finished with, and get the time stamp of its packet
+  * @param[out] pu32Sec Second value while packet sent
+  * @param[out] pu32Nsec Nano second value while packet sent
+  * @param[out] pu32Err 1 if the reclaimed packet failed to send, and the value in *pu32Sec and *pu32Nsec
+  *                     are meaningless. 0 if it was sent. Could be NULL.
+  * @return Number of descriptors reclaimed, 0 or 1
+  * @details Unlike \ref EMAC_SendPktDoneTS, a packet that failed to send is still counted, so a caller
+  *          that keeps one record per queued packet can drop the record of a failed packet too.
+  *          Tx interrupt flags are cleared, so EMAC_TX_IRQHandler can call this function until it returns 0.
+  * @note Nothing is reclaimed after a bus error.
+  */
+uint32_t EMAC_SendPktReclaimTS(uint32_t *pu32Sec, uint32_t *pu32Nsec, uint32_t *pu32Err)
+{
+    EMAC_DESCRIPTOR_T *desc;
+    uint32_t status, reg;
+
+    reg = EMAC->INTSTS;
+    /* Clear Tx interrupt flags */
+    EMAC->INTSTS = reg & (0xFFFF0000UL & ~EMAC_INTSTS_TSALMIF_Msk);
+
+    if (reg & EMAC_INTSTS_TXBEIF_Msk)
+    {
+        return 0UL;
+    }
+
+    desc = (EMAC_DESCRIPTOR_T *)u32CurrentTxDesc;
+
+    /* A finished descriptor is owned by CPU and has its status written by EMAC */
+    if ((desc->u32Status1 & EMAC_DESC_OWN_EMAC) == EMAC_DESC_OWN_EMAC)
+    {
+        return 0UL;
+    }
+
+    status = desc->u32Status2 >> 16UL;
+
+    if (status == 0UL)
+    {
+        return 0UL;
+    }
+
+    if (status & EMAC_TXFD_TXCP)
+    {
+        *pu32Sec = desc->u32Next; /* second stores in descriptor's NEXT field */
+        *pu32Nsec = EMAC_Subsec2Nsec(desc->u32Data); /* Sub nano second store in DATA field */
+    }
+
+    if (pu32Err != NULL)
+    {
+        *pu32Err = ((status & EMAC_TXFD_TXCP) == 0UL) ? 1UL : 0UL;
+    }
+
+    /* restore descriptor link list and data pointer they will be overwrite if time stamp enabled */
+    desc->u32Data = desc->u32Backup1;
+    desc->u32Next = desc->u32Backup2;
+    desc->u32Status2 = 0UL;
+
+    u32CurrentTxDesc = (uint32_t)desc->u32Next;
+
+    return 1UL;
+}
+
+/**
+  * @brief Send a burst of Ethernet packets
+  * @param[in] apu8Data Pointers to the buffers hold the packets to transmit
+  * @param[in] au32Size Packet sizes (without 4 byte CRC)
+  * @param[in] u32Num Number of packets in apu8Data and au32Size
+  * @return Number of packets copied to descriptors, the first ones of the burst. 0 if no descriptor available.
+  * @details Sent descriptors are reclaimed by \ref EMAC_SendPktReclaim first. Then as many free descriptors
+  *          as possible, up to u32Num, are filled and Tx is triggered once for all of them.
+  * @note Packets not taken should be given again after some packets are sent.
+  */
+uint32_t EMAC_SendPktBurst(uint8_t *apu8Data[], uint32_t au32Size[], uint32_t u32Num)
+{
+    EMAC_DESCRIPTOR_T *desc;
+    uint32_t u32Count;
+
+    EMAC_SendPktReclaim(NULL);
+
+    for (u32Count = 0UL; u32Count < u32Num; u32Count++)
+    {
+        desc = (EMAC_DESCRIPTOR_T *)u32NextTxDesc;
+
+        /* Still owned by EMAC, or sent but not reclaimed yet */
+        if ((desc->u32Status1 & EMAC_DESC_OWN_EMAC) || (desc->u32Status2 >> 16UL))
+        {
+            break;
+        }
+
+        memcpy((uint8_t *)desc->u32Data, apu8Data[u32Count], au32Size[u32Count]);
+
+        /* Set Tx descriptor transmit byte count */
+        desc->u32Status2 = au32Size[u32Count];
+
+        /* Change descriptor ownership to EMAC */
+        desc->u32Status1 |= EMAC_DESC_OWN_EMAC;
+
+        /* Get next Tx descriptor */
+        u32NextTxDesc = (uint32_t)(desc->u32Next);
+    }
+
+    if (u32Count > 0UL)
+    {
+        /* Trigger EMAC once to send all of them */
+        EMAC_TRIGGER_TX();
+    }
+
+    return (u32Count);
+}
+
+/**
+  * @brief Receive a burst of Ethernet packets
+  * @param[out] apu8Data Pointers to the buffers to store received packets (4 byte CRC removed)
+  * @param[out] au32Size Received packet sizes (without 4 byte CRC)
+  * @param[in] u32Num Number of buffers in apu8Data
+  * @return Number of packets received
+  * @retval EMAC_BUS_ERR Bus error
+  * @details Received descriptors are drained in order, up to u32Num good packets. Each descriptor is given
+  *          back to EMAC after its packet is copied, bad packets are dropped. Rx is triggered once at the end,
+  *          there is no \ref EMAC_RecvPktDone to call.
+  * @note Largest Ethernet packet is 1514 bytes after stripped CRC, each buffer must be large enough to store such packet
+  */
+uint32_t EMAC_RecvPktBurst(uint8_t *apu8Data[], uint32_t au32Size[], uint32_t u32Num)
+{
+    EMAC_DESCRIPTOR_T *desc;
+    uint32_t status, reg, i;
+    uint32_t u32Count = 0UL;
+
+    /* Clear Rx interrupt flags */
+    reg = EMAC->INTSTS;
+    EMAC->INTSTS = reg & 0xFFFFUL;  /* Clear all RX related interrupt status */
+
+    if (reg & EMAC_INTSTS_RXBEIF_Msk)
+    {
+        /* Bus error occurred, this is usually a bad sign about software bug and will occur again... */
+        return (uint32_t)EMAC_BUS_ERR;
+    }
+
+    /* Get Rx Frame Descriptor */
+    desc = (EMAC_DESCRIPTOR_T *)u32CurrentRxDesc;
+
+    for (i = 0UL; (u32Count < u32Num) && (i < EMAC_RX_DESC_SIZE); i++)
+    {
+        /* If we reach last recv Rx descriptor, leave the loop */
+        if ((desc->u32Status1 & EMAC_DESC_OWN_EMAC) == EMAC_DESC_OWN_EMAC)
+        {
+            break;
+        }
+
+        status = desc->u32Status1 >> 16;
+
+        /* If Rx frame is good, process received frame */
+        if (status & EMAC_RXFD_RXGD)
+        {
+            /* lower 16 bit in descriptor status1 stores the Rx packet length */
+            au32Size[u32Count] = desc->u32Status1 & 0xFFFFUL;
+            memcpy(apu8Data[u32Count], (uint8_t *)desc->u32Backup1, au32Size[u32Count]);
+            u32Count++;
+        }
+
+        /* Restore descriptor link list and data pointer they will be overwrite if time stamp enabled */
+        desc->u32Data = desc->u32Backup1;
+        desc->u32Next = desc->u32Backup2;
+
+        /* Change ownership to DMA for next use */
+        desc->u32Status1 |= EMAC_DESC_OWN_EMAC;
+
+        desc = (EMAC_DESCRIPTOR_T *)desc->u32Next;
+    }
+
+    /* Save last processed Rx descriptor */
+    u32CurrentRxDesc = (uint32_t)desc;
+
+    if (i > 0UL)
+    {
+        /* Trigger EMAC once for all descriptors given back */
+        EMAC_TRIGGER_RX();
+    }
+
+    return (u32Count);
+}
+
 /*@}*/ /* end of group EMAC_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group EMAC_Driver */
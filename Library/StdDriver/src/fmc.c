@@ -1134,6 +1134,191 @@ uint32_t  FMC_CheckAllOne(uint32_t u32addr, uint32_t u32count)
 }
 
 
+/** @cond HIDDEN_SYMBOLS */
+
+/*
+ *  Check if a page already holds u32Len bytes of image data followed by all one.
+ */
+static int32_t FMC_IsImagePageSame(uint32_t u32PageAddr, const uint32_t pu32Buf[], uint32_t u32Len)
+{
+    uint32_t  i;
+
+    for (i = 0UL; i < u32Len; i += 4UL)
+    {
+        if (M32(u32PageAddr + i) != pu32Buf[i / 4UL])
+        {
+            return 0;
+        }
+    }
+    for (; i < FMC_FLASH_PAGE_SIZE; i += 4UL)
+    {
+        if (M32(u32PageAddr + i) != 0xFFFFFFFFUL)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ *  Program up to one multi-word burst, resuming where FMC_WriteMultiple stops early.
+ *  FMC_WriteMultiple starts with 16 bytes, so a shorter tail is programmed by 8 and 4 bytes.
+ */
+static int32_t FMC_WriteBurst(uint32_t u32Addr, const uint32_t pu32Buf[], uint32_t u32Len, FMC_IMG_STAT_T *psStat)
+{
+    int32_t   i32Cnt, tout;
+
+    while (u32Len >= 16UL)
+    {
+        i32Cnt = FMC_WriteMultiple(u32Addr, (uint32_t *)pu32Buf, u32Len);
+        psStat->u32ProgCalls++;
+        if (i32Cnt <= 0)
+        {
+            return -1;
+        }
+
+        /* An early return does not wait for the last words */
+        tout = FMC_TIMEOUT_WRITE;
+        while ((tout-- > 0) && (FMC->MPSTS & FMC_MPSTS_MPBUSY_Msk)) {}
+        if (tout <= 0)
+        {
+            return -1;
+        }
+
+        psStat->u32ProgBytes += (uint32_t)i32Cnt;
+        u32Addr += (uint32_t)i32Cnt;
+        pu32Buf += (uint32_t)i32Cnt / 4UL;
+        u32Len -= (uint32_t)i32Cnt;
+    }
+
+    if (u32Len >= 8UL)
+    {
+        psStat->u32ProgCalls++;
+        if (FMC_Write8Bytes(u32Addr, pu32Buf[0], pu32Buf[1]) != 0)
+        {
+            return -1;
+        }
+        psStat->u32ProgBytes += 8UL;
+        u32Addr += 8UL;
+        pu32Buf += 2;
+        u32Len -= 8UL;
+    }
+
+    if (u32Len)
+    {
+        psStat->u32ProgCalls++;
+        if (FMC_Write(u32Addr, pu32Buf[0]) != 0)
+        {
+            return -1;
+        }
+        psStat->u32ProgBytes += 4UL;
+    }
+    return 0;
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief Program an image into APROM page by page with multi-word program.
+  * @param[in]  u32Addr    Start address in APROM. It must be page aligned.
+  * @param[in]  pu32Buf    Image data.
+  * @param[in]  u32Len     Image length in bytes. It must be a multiple of 4.
+  * @param[out] psStat     Counters to add to, or NULL.
+  * @retval   0   Success
+  * @retval   -1  Erase or program failed.
+  * @retval   -2  Invalid address or length.
+  *
+  * @details  Each page is treated as the image data followed by 0xFF up to the page end, so FMC_GetChkSum
+  *           over whole pages can verify the result. A page that already holds this is skipped. A page that
+  *           FMC_CheckAllOne finds all one is not erased. The data is programmed in FMC_MULTI_WORD_PROG_LEN
+  *           bursts by FMC_WriteMultiple, and bursts of only 0xFFFFFFFF are skipped. \n
+  *           Code fetches from the bank being programmed stall multi-word program, so when the image goes
+  *           to the bank the code runs from, place fmc.o in SRAM. With dual bank, code in one bank can update
+  *           the other without that.
+  *
+  * @note     Global error code g_FMC_i32ErrCode
+  *           -1  Erase or program failed or time-out
+  *           -2  Invalid address or length
+  */
+int32_t FMC_WriteImage(uint32_t u32Addr, const uint32_t pu32Buf[], uint32_t u32Len, FMC_IMG_STAT_T *psStat)
+{
+    FMC_IMG_STAT_T  sStat;
+    uint32_t  u32Cnt, u32Off, u32Burst, i;
+
+    g_FMC_i32ErrCode = 0;
+
+    if (psStat == NULL)
+    {
+        psStat = &sStat;
+    }
+
+    if ((u32Addr & ~FMC_PAGE_ADDR_MASK) || (u32Len % 4UL) ||
+            (u32Addr >= FMC_APROM_END) || (u32Len > FMC_APROM_END - u32Addr))
+    {
+        g_FMC_i32ErrCode = -2;
+        return -2;
+    }
+
+    for (; u32Len > 0UL; u32Addr += FMC_FLASH_PAGE_SIZE)
+    {
+        u32Cnt = (u32Len < FMC_FLASH_PAGE_SIZE) ? u32Len : FMC_FLASH_PAGE_SIZE;
+        psStat->u32Pages++;
+
+        if (FMC_IsImagePageSame(u32Addr, pu32Buf, u32Cnt))
+        {
+            psStat->u32SamePages++;
+        }
+        else
+        {
+            if (FMC_CheckAllOne(u32Addr, FMC_FLASH_PAGE_SIZE) == READ_ALLONE_YES)
+            {
+                psStat->u32BlankPages++;
+            }
+            else
+            {
+                psStat->u32Erases++;
+                if (FMC_Erase(u32Addr) != 0)
+                {
+                    g_FMC_i32ErrCode = -1;
+                    return -1;
+                }
+            }
+
+            for (u32Off = 0UL; u32Off < u32Cnt; u32Off += u32Burst)
+            {
+                u32Burst = u32Cnt - u32Off;
+                if (u32Burst > FMC_MULTI_WORD_PROG_LEN)
+                {
+                    u32Burst = FMC_MULTI_WORD_PROG_LEN;
+                }
+
+                for (i = 0UL; i < u32Burst / 4UL; i++)
+                {
+                    if (pu32Buf[u32Off / 4UL + i] != 0xFFFFFFFFUL)
+                    {
+                        break;
+                    }
+                }
+                if (i == u32Burst / 4UL)
+                {
+                    continue;               /* erased flash already holds it */
+                }
+
+                if (FMC_WriteBurst(u32Addr + u32Off, &pu32Buf[u32Off / 4UL], u32Burst, psStat) != 0)
+                {
+                    g_FMC_i32ErrCode = -1;
+                    return -1;
+                }
+            }
+        }
+
+        pu32Buf += u32Cnt / 4UL;
+        u32Len -= u32Cnt;
+    }
+    return 0;
+}
+
+
 /**
   * @brief    Setup security key.
   * @param[in] key      Key 0~2 to be setup.
@@ -44,6 +44,22 @@ static uint8_t _SDH1_ucSDHCBuffer[512] __attribute__((aligned(4)));
 
 SDH_INFO_T SD0, SD1;
 
+/* Request queue of SDH_SubmitRequest() and the state of the open-ended CMD18/CMD25 it streams on */
+typedef struct
+{
+    SDH_REQ_T *volatile pHead;      /* pending requests */
+    SDH_REQ_T *pTail;
+    SDH_REQ_T *volatile pCur;       /* request on the bus */
+    uint32_t u32Done;               /* sectors of pCur already transferred */
+    uint32_t u32Chunk;              /* sectors of the running data phase, at most 255 (CTL[BLKCNT]) */
+    uint32_t volatile u32Phases;    /* completed data phases, lets SDH_FlushQueue() see progress */
+    uint32_t u32IsOpen;             /* card selected and multiple block command not yet stopped */
+    uint32_t u32Dir;                /* direction of the open command */
+    uint32_t u32NextSec;            /* sector the open command continues at */
+} SDH_QUEUE_T;
+
+static SDH_QUEUE_T _SDH0_Queue, _SDH1_Queue;
+
 static int32_t SDH_CheckRB(SDH_T *sdh)
 {
     uint32_t u32TimeOutCount1, u32TimeOutCount2;
@@ -1217,6 +1233,16 @@ uint32_t SDH_Probe(SDH_T *sdh)
 {
     uint32_t val;
 
+    /* card goes back to idle state, nothing is left to stop */
+    if (sdh == SDH0)
+    {
+        _SDH0_Queue.u32IsOpen = 0ul;
+    }
+    else
+    {
+        _SDH1_Queue.u32IsOpen = 0ul;
+    }
+
     sdh->GINTEN = 0ul;
     sdh->CTL &= ~SDH_CTL_SDNWR_Msk;
     sdh->CTL |=  0x09ul << SDH_CTL_SDNWR_Pos;   /* set SDNWR = 9 */
@@ -1289,6 +1315,12 @@ int32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t
         return SDH_SELECT_ERROR;
     }
 
+    /* let queued requests finish and stop their open multiple block command */
+    if ((status = SDH_FlushQueue(sdh)) != Successful)
+    {
+        return status;
+    }
+
     if ((status = SDH_SDCmdAndRsp(sdh, 7ul, pSD->RCA, 0ul)) != Successful)
     {
         return status;
@@ -1468,6 +1500,12 @@ int32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_
         return SDH_SELECT_ERROR;
     }
 
+    /* let queued requests finish and stop their open multiple block command */
+    if ((status = SDH_FlushQueue(sdh)) != Successful)
+    {
+        return status;
+    }
+
     if ((status = SDH_SDCmdAndRsp(sdh, 7ul, pSD->RCA, 0ul)) != Successful)
     {
         return status;
@@ -1593,6 +1631,478 @@ int32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_
     return Successful;
 }
 
+/** @cond HIDDEN_SYMBOLS */
+
+static SDH_QUEUE_T *SDH_GetQueue(SDH_T *sdh, SDH_INFO_T **ppSD)
+{
+    if (sdh == SDH0)
+    {
+        *ppSD = &SD0;
+        return &_SDH0_Queue;
+    }
+    else
+    {
+        *ppSD = &SD1;
+        return &_SDH1_Queue;
+    }
+}
+
+/* Select the card and load the start address for the multiple block command of psReq. */
+static int32_t SDH_StreamOpen(SDH_T *sdh, SDH_INFO_T *pSD, SDH_QUEUE_T *pQ, SDH_REQ_T *psReq)
+{
+    uint32_t status, u32PreErase;
+    SDH_REQ_T *psNext;
+
+    if ((status = SDH_SDCmdAndRsp(sdh, 7ul, pSD->RCA, 0ul)) != Successful)
+    {
+        return (int32_t)status;
+    }
+
+    if (SDH_CheckRB(sdh) != Successful)
+    {
+        return SDH_ERR_TIMEOUT;
+    }
+
+    /* Tell a SD card how many blocks the CMD25 is going to write so it can pre-erase them (ACMD23).
+       Contiguous write requests already queued behind psReq are counted too.
+       The count is only a hint, the stream may go on beyond it. */
+    if ((psReq->u32Dir == SDH_REQ_WRITE) &&
+            ((pSD->CardType == SDH_TYPE_SD_HIGH) || (pSD->CardType == SDH_TYPE_SD_LOW)))
+    {
+        u32PreErase = psReq->u32SecCount;
+        for (psNext = pQ->pHead; psNext != NULL; psNext = psNext->next)
+        {
+            if ((psNext->u32Dir != SDH_REQ_WRITE) || (psNext->u32StartSec != psReq->u32StartSec + u32PreErase))
+            {
+                break;
+            }
+            u32PreErase += psNext->u32SecCount;
+        }
+        if (u32PreErase > 0x7ffffful)
+        {
+            u32PreErase = 0x7ffffful;
+        }
+
+        if ((status = SDH_SDCmdAndRsp(sdh, 55ul, pSD->RCA, 0ul)) != Successful)
+        {
+            return (int32_t)status;
+        }
+        if ((status = SDH_SDCmdAndRsp(sdh, 23ul, u32PreErase, 0ul)) != Successful)
+        {
+            return (int32_t)status;
+        }
+    }
+
+    sdh->BLEN = SDH_BLOCK_SIZE - 1ul;
+
+    if ((pSD->CardType == SDH_TYPE_SD_HIGH) || (pSD->CardType == SDH_TYPE_EMMC))
+    {
+        sdh->CMDARG = psReq->u32StartSec;
+    }
+    else
+    {
+        sdh->CMDARG = psReq->u32StartSec * SDH_BLOCK_SIZE;
+    }
+
+    return Successful;
+}
+
+/* Stop the open multiple block command (CMD12) and deselect the card. */
+static int32_t SDH_StreamClose(SDH_T *sdh, SDH_INFO_T *pSD, SDH_QUEUE_T *pQ)
+{
+    uint32_t u32TimeOutCount;
+
+    pQ->u32IsOpen = 0ul;
+
+    if (pQ->u32Dir == SDH_REQ_WRITE)
+    {
+        sdh->INTSTS = SDH_INTSTS_CRCIF_Msk;
+    }
+
+    if (SDH_SDCmdAndRsp(sdh, 12ul, 0ul, 0ul))      /* stop command */
+    {
+        return SDH_CRC7_ERROR;
+    }
+
+    if (SDH_CheckRB(sdh) != Successful)
+    {
+        return SDH_ERR_TIMEOUT;
+    }
+
+    SDH_SDCommand(sdh, 7ul, 0ul);
+    sdh->CTL |= SDH_CTL_CLK8OEN_Msk;
+    u32TimeOutCount = SDH_TIMEOUT_CNT;
+    while ((sdh->CTL & SDH_CTL_CLK8OEN_Msk) == SDH_CTL_CLK8OEN_Msk)
+    {
+        if (--u32TimeOutCount == 0)
+        {
+            pSD->i32ErrCode = SDH_ERR_TIMEOUT;
+            break;
+        }
+    }
+
+    if (pSD->i32ErrCode != 0)
+        return Fail;
+
+    return Successful;
+}
+
+/* Start the next data phase of pQ->pCur. The first phase of a stream also sends CMD18/CMD25. */
+static void SDH_StartPhase(SDH_T *sdh, SDH_INFO_T *pSD, SDH_QUEUE_T *pQ, uint32_t bIsSendCmd)
+{
+    SDH_REQ_T *psReq = pQ->pCur;
+    uint32_t reg;
+
+    pQ->u32Chunk = psReq->u32SecCount - pQ->u32Done;
+    if (pQ->u32Chunk > 255ul)
+    {
+        pQ->u32Chunk = 255ul;
+    }
+
+    pSD->DataReadyFlag = (uint8_t)FALSE;
+    sdh->DMASA = (uint32_t)psReq->pu8BufAddr + pQ->u32Done * SDH_BLOCK_SIZE;
+
+    if (psReq->u32Dir == SDH_REQ_WRITE)
+    {
+        reg = (sdh->CTL & 0xff00c080) | (pQ->u32Chunk << 16);
+        if (bIsSendCmd)
+        {
+            sdh->CTL = reg|(25ul << 8)|(SDH_CTL_COEN_Msk | SDH_CTL_RIEN_Msk | SDH_CTL_DOEN_Msk);
+        }
+        else
+        {
+            sdh->CTL = reg | SDH_CTL_DOEN_Msk;
+        }
+    }
+    else
+    {
+        reg = sdh->CTL & ~(SDH_CTL_CMDCODE_Msk | SDH_CTL_BLKCNT_Msk);
+        reg |= (pQ->u32Chunk << 16);
+        if (bIsSendCmd)
+        {
+            sdh->CTL = reg|(18ul << 8)|(SDH_CTL_COEN_Msk | SDH_CTL_RIEN_Msk | SDH_CTL_DIEN_Msk);
+        }
+        else
+        {
+            sdh->CTL = reg | SDH_CTL_DIEN_Msk;
+        }
+    }
+}
+
+/* Report pQ->pCur done and make the next pending request current. */
+static void SDH_QueueComplete(SDH_QUEUE_T *pQ, int32_t i32Status)
+{
+    SDH_REQ_T *psReq = pQ->pCur;
+    uint32_t u32Primask;
+
+    /* pCur stays set during the callback, so a request submitted from it is only queued */
+    psReq->i32Status = i32Status;
+    if (psReq->pfnComplete != NULL)
+    {
+        psReq->pfnComplete(psReq);
+    }
+
+    u32Primask = __get_PRIMASK();
+    __disable_irq();
+    pQ->pCur = pQ->pHead;
+    if (pQ->pHead != NULL)
+    {
+        pQ->pHead = pQ->pHead->next;
+    }
+    pQ->u32Done = 0ul;
+    __set_PRIMASK(u32Primask);
+}
+
+/* Put pQ->pCur on the bus. The open command is reused when the request continues it,
+   otherwise it is stopped and a new one is opened. Requests failing to start are completed. */
+static void SDH_QueueRun(SDH_T *sdh, SDH_INFO_T *pSD, SDH_QUEUE_T *pQ)
+{
+    SDH_REQ_T *psReq;
+    int32_t i32Status;
+
+    while ((psReq = pQ->pCur) != NULL)
+    {
+        if (pSD->IsCardInsert == FALSE)
+        {
+            pQ->u32IsOpen = 0ul;
+            i32Status = (int32_t)SDH_NO_SD_CARD;
+        }
+        else if (pQ->u32IsOpen && (pQ->u32Dir == psReq->u32Dir) && (pQ->u32NextSec == psReq->u32StartSec))
+        {
+            SDH_StartPhase(sdh, pSD, pQ, FALSE);
+            return;
+        }
+        else
+        {
+            if (pQ->u32IsOpen)
+            {
+                /* a failed stop shows up again when the new command is opened */
+                SDH_StreamClose(sdh, pSD, pQ);
+            }
+
+            i32Status = SDH_StreamOpen(sdh, pSD, pQ, psReq);
+            if (i32Status == Successful)
+            {
+                pQ->u32IsOpen = 1ul;
+                pQ->u32Dir = psReq->u32Dir;
+                pQ->u32NextSec = psReq->u32StartSec;
+                SDH_StartPhase(sdh, pSD, pQ, TRUE);
+                return;
+            }
+            /* leave the card deselected */
+            SDH_SDCommand(sdh, 7ul, 0ul);
+        }
+
+        SDH_QueueComplete(pQ, i32Status);
+    }
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+ *  @brief  This function use to queue a sector request for interrupt driven transfer.
+ *
+ *  @param[in]    sdh      Select SDH0 or SDH1.
+ *  @param[in]    psReq    The request. u32Dir, pu8BufAddr, u32StartSec, u32SecCount and pfnComplete
+ *                         must be filled. It belongs to the driver until pfnComplete is called.
+ *
+ *  @return   \ref SDH_SELECT_ERROR : u32SecCount is zero. \n
+ *            \ref SDH_NO_SD_CARD : SD card be removed. \n
+ *            \ref Successful : Request queued.
+ *
+ *  @details  Requests are transferred in order by a multiple block command (CMD18 / CMD25) which is left
+ *            open after a request is done. A following request in the same direction that starts at the
+ *            next sector goes on with the same command, without selecting the card or sending a new
+ *            command. The command is stopped when a request does not continue it, by \ref SDH_FlushQueue,
+ *            or by \ref SDH_Read / \ref SDH_Write. A SD card is told the length of the queued write run
+ *            by ACMD23 before CMD25 so that it can pre-erase the blocks. \n
+ *            The SDHx_IRQHandler of application must call \ref SDH_QueueHandler on block transfer done.
+ *            pfnComplete is called in interrupt context, it can submit the next request.
+ */
+int32_t SDH_SubmitRequest(SDH_T *sdh, SDH_REQ_T *psReq)
+{
+    SDH_INFO_T *pSD;
+    SDH_QUEUE_T *pQ = SDH_GetQueue(sdh, &pSD);
+    uint32_t u32Primask, u32IsIdle;
+
+    if (psReq->u32SecCount == 0ul)
+    {
+        return SDH_SELECT_ERROR;
+    }
+
+    if (pSD->IsCardInsert == FALSE)
+    {
+        return SDH_NO_SD_CARD;
+    }
+
+    psReq->next = NULL;
+    psReq->i32Status = Successful;
+
+    u32Primask = __get_PRIMASK();
+    __disable_irq();
+    u32IsIdle = (pQ->pCur == NULL) ? TRUE : FALSE;
+    if (u32IsIdle)
+    {
+        pQ->pCur = psReq;
+        pQ->u32Done = 0ul;
+    }
+    else
+    {
+        if (pQ->pHead == NULL)
+        {
+            pQ->pHead = psReq;
+        }
+        else
+        {
+            pQ->pTail->next = psReq;
+        }
+        pQ->pTail = psReq;
+    }
+    __set_PRIMASK(u32Primask);
+
+    if (u32IsIdle)
+    {
+        SDH_QueueRun(sdh, pSD, pQ);
+    }
+
+    return Successful;
+}
+
+/**
+ *  @brief  This function use to move the request queue on, it must be called by SDHx_IRQHandler.
+ *
+ *  @param[in]    sdh    Select SDH0 or SDH1.
+ *
+ *  @return None
+ *
+ *  @details  Call it after \ref SDH_INTSTS_BLKDIF_Msk is handled and before \ref SDH_INTSTS_CRCIF_Msk
+ *            is cleared. It does nothing when no queued request is on the bus.
+ *            Starting a new command is done here, so the handler can poll the card for a while.
+ */
+void SDH_QueueHandler(SDH_T *sdh)
+{
+    SDH_INFO_T *pSD;
+    SDH_QUEUE_T *pQ = SDH_GetQueue(sdh, &pSD);
+    SDH_REQ_T *psReq = pQ->pCur;
+    int32_t i32Status = Successful;
+
+    if ((psReq == NULL) || (pQ->u32IsOpen == 0ul))
+    {
+        return;
+    }
+
+    if (psReq->u32Dir == SDH_REQ_WRITE)
+    {
+        if ((sdh->INTSTS & SDH_INTSTS_CRCIF_Msk) != 0ul)
+        {
+            sdh->INTSTS = SDH_INTSTS_CRCIF_Msk;
+            i32Status = (int32_t)SDH_CRC_ERROR;
+        }
+    }
+    else
+    {
+        if ((sdh->INTSTS & SDH_INTSTS_CRC7_Msk) != SDH_INTSTS_CRC7_Msk)      /* check CRC7 */
+        {
+            i32Status = (int32_t)SDH_CRC7_ERROR;
+        }
+        else if ((sdh->INTSTS & SDH_INTSTS_CRC16_Msk) != SDH_INTSTS_CRC16_Msk)     /* check CRC16 */
+        {
+            i32Status = (int32_t)SDH_CRC16_ERROR;
+        }
+    }
+
+    pQ->u32Phases++;
+
+    if (i32Status == Successful)
+    {
+        pQ->u32Done += pQ->u32Chunk;
+        pQ->u32NextSec += pQ->u32Chunk;
+        if (pQ->u32Done < psReq->u32SecCount)
+        {
+            SDH_StartPhase(sdh, pSD, pQ, FALSE);
+            return;
+        }
+    }
+    else
+    {
+        SDH_StreamClose(sdh, pSD, pQ);
+    }
+
+    SDH_QueueComplete(pQ, i32Status);
+    SDH_QueueRun(sdh, pSD, pQ);
+}
+
+/**
+ *  @brief  This function use to wait for all queued requests and stop the open multiple block command.
+ *
+ *  @param[in]    sdh    Select SDH0 or SDH1.
+ *
+ *  @return   \ref SDH_NO_SD_CARD : SD card be removed. \n
+ *            \ref SDH_ERR_TIMEOUT : Transfer does not go on, the remaining requests are aborted. \n
+ *            \ref SDH_CRC7_ERROR : Stop command fails. \n
+ *            \ref Successful : Queue is empty and card is deselected.
+ *
+ *  @details  Aborted requests are completed with the returned error code. On abort the SD engine
+ *            is reset and the open multiple block command is stopped by CMD12, so the card can take
+ *            new requests without being probed again.
+ *            It must not be called from pfnComplete.
+ */
+int32_t SDH_FlushQueue(SDH_T *sdh)
+{
+    SDH_INFO_T *pSD;
+    SDH_QUEUE_T *pQ = SDH_GetQueue(sdh, &pSD);
+    SDH_REQ_T *psAbort, *psReq;
+    uint32_t u32TimeOutCount, u32Phases, u32Primask;
+    int32_t i32Status = Successful;
+
+    u32Phases = pQ->u32Phases;
+    u32TimeOutCount = SDH_TIMEOUT_CNT;
+    while (pQ->pCur != NULL)
+    {
+        if (pSD->IsCardInsert == FALSE)
+        {
+            i32Status = (int32_t)SDH_NO_SD_CARD;
+            break;
+        }
+        if (u32Phases != pQ->u32Phases)
+        {
+            u32Phases = pQ->u32Phases;
+            u32TimeOutCount = SDH_TIMEOUT_CNT;
+        }
+        if (--u32TimeOutCount == 0)
+        {
+            i32Status = SDH_ERR_TIMEOUT;
+            break;
+        }
+    }
+
+    if (i32Status != Successful)
+    {
+        u32Primask = __get_PRIMASK();
+        __disable_irq();
+        psAbort = pQ->pCur;
+        if (psAbort != NULL)
+        {
+            psAbort->next = pQ->pHead;
+        }
+        pQ->pCur = NULL;
+        pQ->pHead = NULL;
+        __set_PRIMASK(u32Primask);
+
+        sdh->CTL |= SDH_CTL_CTLRST_Msk; /* reset SD engine */
+        u32TimeOutCount = SDH_TIMEOUT_CNT;
+        while ((sdh->CTL & SDH_CTL_CTLRST_Msk) == SDH_CTL_CTLRST_Msk)
+        {
+            if (--u32TimeOutCount == 0)
+            {
+                break;
+            }
+        }
+
+        /* the card is still in the open CMD18/CMD25, stop it so it takes new commands */
+        if ((pQ->u32IsOpen) && (pSD->IsCardInsert != FALSE))
+        {
+            (void)SDH_StreamClose(sdh, pSD, pQ);
+        }
+        pQ->u32IsOpen = 0ul;
+
+        while (psAbort != NULL)
+        {
+            psReq = psAbort;
+            psAbort = psAbort->next;
+            psReq->i32Status = i32Status;
+            if (psReq->pfnComplete != NULL)
+            {
+                psReq->pfnComplete(psReq);
+            }
+        }
+        return i32Status;
+    }
+
+    if (pQ->u32IsOpen)
+    {
+        i32Status = SDH_StreamClose(sdh, pSD, pQ);
+    }
+
+    return i32Status;
+}
+
+/**
+ *  @brief  This function use to check whether the request queue is empty.
+ *
+ *  @param[in]    sdh    Select SDH0 or SDH1.
+ *
+ *  @return   TRUE : No request is queued. The multiple block command may still be open. \n
+ *            FALSE : Requests are in progress.
+ */
+uint32_t SDH_IsQueueIdle(SDH_T *sdh)
+{
+    SDH_INFO_T *pSD;
+    SDH_QUEUE_T *pQ = SDH_GetQueue(sdh, &pSD);
+
+    return (pQ->pCur == NULL) ? TRUE : FALSE;
+}
+
 /*@}*/ /* end of group SDH_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group SDH_Driver */
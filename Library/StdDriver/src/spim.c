@@ -62,6 +62,9 @@ static void spim_set_write_enable(int isEn, uint32_t u32NBit);
 static void spim_enable_spansion_quad_mode(int isEn);
 static void spim_eon_set_qpi_mode(int isEn);
 static void SPIM_SPANSION_4Bytes_Enable(int isEn, uint32_t u32NBit);
+static void spim_set_burst_wrap(int isEn);
+static void spim_reset_cont_read(void);
+static uint32_t spim_dmm_default_dcnum(uint32_t u32Cmd);
 static void SPIM_WriteInPageDataByIo(uint32_t u32Addr, int is4ByteAddr, uint32_t u32NTx, uint8_t pu8TxBuf[], uint8_t wrCmd,
                                      uint32_t u32NBitCmd, uint32_t u32NBitAddr, uint32_t u32NBitDat, int isSync);
 static void SPIM_WriteInPageDataByPageWrite(uint32_t u32Addr, int is4ByteAddr, uint32_t u32NTx,
@@ -994,6 +997,24 @@ void SPIM_EraseBlock(uint32_t u32Addr, int is4ByteAddr, uint8_t u8ErsCmd, uint32
 }
 
 
+/**
+  * @brief      Check if an erase or page program started without waiting is done.
+  * @param      u32NBit     N-bit transmit/receive.
+  * @return     0: Not done. 1: Done.
+  * @details    This is one status poll of an operation started by SPIM_EraseBlock, SPIM_ChipErase or
+  *             SPIM_DMA_WritePage with isSync 0. While a DMA write is still on the bus it returns 0 without
+  *             touching the flash, otherwise it reads the status register once and checks WIP.
+  */
+int SPIM_IsWriteDone(uint32_t u32NBit)
+{
+    if (SPIM_IS_BUSY())
+    {
+        return 0;
+    }
+    return spim_is_write_done(u32NBit);
+}
+
+
 /** @cond HIDDEN_SYMBOLS */
 
 /**
@@ -1255,6 +1276,35 @@ void SPIM_DMA_Write(uint32_t u32Addr, int is4ByteAddr, uint32_t u32NTx, uint8_t
     }
 }
 
+/**
+  * @brief      Program data within one page by Page Write mode.
+  * @param      u32Addr     Start address to write.
+  * @param      is4ByteAddr 4-byte address or not.
+  * @param      u32NTx      Number of bytes to write. u32Addr to u32Addr+u32NTx-1 must be in one 256-byte page.
+  * @param      pu8TxBuf    Transmit buffer. It must not change until the program is done.
+  * @param      wrCmd       Write command.
+  * @param      isSync      Block or not.
+  * @return     0           Success.
+  * @return     -1          The data crosses a page boundary, or isSync is 0 with an EON quad command, which
+  *                         must leave QPI mode after the transfer.
+  * @details    With isSync 0 the function returns as soon as the transfer is started. Poll SPIM_IsWriteDone
+  *             for the end of the program, and do not start another SPIM operation before.
+  */
+int SPIM_DMA_WritePage(uint32_t u32Addr, int is4ByteAddr, uint32_t u32NTx, uint8_t pu8TxBuf[],
+                       uint32_t wrCmd, int isSync)
+{
+    if ((u32NTx == 0UL) || (((u32Addr % 256UL) + u32NTx) > 256UL))
+    {
+        return -1;
+    }
+    if ((!isSync) && (wrCmd == CMD_QUAD_PAGE_PROGRAM_EON))
+    {
+        return -1;
+    }
+    SPIM_WriteInPageDataByPageWrite(u32Addr, is4ByteAddr, u32NTx, pu8TxBuf, wrCmd, isSync);
+    return 0;
+}
+
 /**
   * @brief      Read data from SPI Flash by Page Read mode.
   * @param      u32Addr     Start address to read.
@@ -1307,6 +1357,159 @@ void SPIM_ExitDirectMapMode(void)
     SPIM_SET_OPMODE(SPIM_CTL0_OPMODE_IO);       /* Switch back to Normal mode.  */
 }
 
+/** @cond HIDDEN_SYMBOLS */
+
+/**
+  * @brief      Issue Winbond Set Burst with Wrap command.
+  * @param      isEn        1: 16-byte wrap around, 0: no wrap.
+  * @return     None.
+  */
+static void spim_set_burst_wrap(int isEn)
+{
+    uint8_t cmdBuf[] = {OPCODE_SBW};
+    uint8_t datBuf[] = {0x00U, 0x00U, 0x00U, 0x00U};    /* 3 dummy bytes + wrap bits, quad input. */
+
+    datBuf[3] = isEn ? 0x20U : 0x10U;           /* W6-W5 = 01: 16-byte wrap length; W4 = 1: wrap disabled. */
+
+    SPIM_SET_SS_EN(1);                          /* CS activated.    */
+    SwitchNBitOutput(1UL);
+    spim_write(cmdBuf, sizeof (cmdBuf));
+    SwitchNBitOutput(4UL);
+    spim_write(datBuf, sizeof (datBuf));
+    SPIM_SET_SS_EN(0);                          /* CS deactivated.  */
+}
+
+/**
+  * @brief      Take SPI flash out of continuous read mode.
+  * @return     None.
+  * @details    Hold IO0~IO3 high for 16 clocks, which resets the mode bits of both the
+  *             dual I/O and the quad I/O continuous read.
+  */
+static void spim_reset_cont_read(void)
+{
+    uint8_t cmdBuf[] = {0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU};
+
+    SPIM_SET_SS_EN(1);                          /* CS activated.    */
+    SwitchNBitOutput(4UL);
+    spim_write(cmdBuf, sizeof (cmdBuf));
+    SPIM_SET_SS_EN(0);                          /* CS deactivated.  */
+}
+
+/**
+  * @brief      Dummy cycle number the controller uses for a read command when USETEN is 0.
+  * @param      u32Cmd      Read command opcode.
+  * @return     Dummy cycle number.
+  */
+static uint32_t spim_dmm_default_dcnum(uint32_t u32Cmd)
+{
+    switch (u32Cmd)
+    {
+    case OPCODE_NORM_READ:
+    case 0xBBUL:
+        return 0UL;
+    case 0xEBUL:
+        return 4UL;
+    case 0xE7UL:
+        return 2UL;
+    default:
+        return 8UL;
+    }
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief      Set up Direct Map mode for code execution and enter it.
+  * @param      psCfg       Cache, read command, continuous read and burst wrap settings.
+  * @retval     0                       Success.
+  * @retval     SPIM_DMM_ERR_PARAM      The read command cannot be used with the requested option.
+  * @details    The controller is switched to Normal I/O mode while the cache, the DMM timing
+  *             and the flash wrap and continuous read states are changed, then the cache is
+  *             invalidated and Direct Map mode is entered again.
+  *             The function must run from APROM or SRAM, not from SPI flash.
+  *             Dual and quad read commands need the flash quad mode enabled by SPIM_SetQuadEnable first.
+  *             Burst wrap fills a missed cache line from the needed word on, so the CPU waits for
+  *             4 bytes instead of the whole line. Continuous read drops the 8-clock command phase
+  *             of every read after the first one.
+  */
+int SPIM_DMM_Configure(const SPIM_DMM_CFG_T *psCfg)
+{
+    uint32_t u32Cmd = (psCfg->u32RdCmd & SPIM_CTL0_CMDCODE_Msk) >> SPIM_CTL0_CMDCODE_Pos;
+    int isQuadIO = (u32Cmd == 0xEBUL) || (u32Cmd == 0xE7UL);
+    int isModeCmd = isQuadIO || (u32Cmd == 0xBBUL);
+
+    if ((psCfg->u32CacheMode > SPIM_DMM_CACHE_CCM) ||
+            ((psCfg->u32Opt & SPIM_DMM_OPT_CONT_READ) && !isModeCmd) ||
+            ((psCfg->u32Opt & SPIM_DMM_OPT_BURST_WRAP) && (!isQuadIO || (psCfg->u32CacheMode != SPIM_DMM_CACHE_ON))))
+    {
+        return SPIM_DMM_ERR_PARAM;
+    }
+
+    SPIM_WAIT_FREE();
+    SPIM_SET_OPMODE(SPIM_CTL0_OPMODE_IO);       /* No DMM read while the settings change. */
+
+    /* A flash left in continuous read mode would take the next command as address. */
+    if (SPIM->DMMCTL & SPIM_DMMCTL_CREN_Msk)
+    {
+        SPIM_DMM_DISABLE_CREN();
+        spim_reset_cont_read();
+    }
+
+    if (psCfg->u32Opt & SPIM_DMM_OPT_BURST_WRAP)
+    {
+        spim_set_burst_wrap(1);
+        SPIM_DMM_ENABLE_BWEN();
+    }
+    else if (SPIM->DMMCTL & SPIM_DMMCTL_BWEN_Msk)
+    {
+        SPIM_DMM_DISABLE_BWEN();
+        spim_set_burst_wrap(0);
+    }
+
+    if ((psCfg->u32ModeBits == SPIM_DMM_DEFAULT) && (psCfg->u32DummyCycles == SPIM_DMM_DEFAULT))
+    {
+        SPIM->CTL2 &= ~SPIM_CTL2_USETEN_Msk;    /* Controller defaults for the read command. */
+    }
+    else
+    {
+        SPIM->DMMCTL = (SPIM->DMMCTL & ~SPIM_DMMCTL_CRMDAT_Msk) |
+                       (((psCfg->u32ModeBits == SPIM_DMM_DEFAULT) ? 0x20UL : (psCfg->u32ModeBits & 0xFFUL)) << SPIM_DMMCTL_CRMDAT_Pos);
+        SPIM_SET_DCNUM((psCfg->u32DummyCycles == SPIM_DMM_DEFAULT) ? spim_dmm_default_dcnum(u32Cmd) : psCfg->u32DummyCycles);
+    }
+
+    if (psCfg->u32DeselTime != SPIM_DMM_DEFAULT)
+    {
+        SPIM_DMM_SET_DESELTIM(psCfg->u32DeselTime);
+    }
+
+    switch (psCfg->u32CacheMode)
+    {
+    case SPIM_DMM_CACHE_OFF:
+        SPIM_DISABLE_CCM();
+        SPIM_DISABLE_CACHE();
+        break;
+
+    case SPIM_DMM_CACHE_ON:
+        SPIM_DISABLE_CCM();
+        SPIM_ENABLE_CACHE();
+        break;
+
+    default:
+        SPIM_ENABLE_CCM();
+        while (!SPIM_IS_CCM_EN()) {}            /* CCM is usable once CCMEN reads back 1. */
+        break;
+    }
+
+    if (psCfg->u32Opt & SPIM_DMM_OPT_CONT_READ)
+    {
+        SPIM_DMM_ENABLE_CREN();
+    }
+
+    SPIM_INVALID_CACHE();
+    SPIM_EnterDirectMapMode((int)psCfg->u32Is4ByteAddr, psCfg->u32RdCmd, psCfg->u32IdleIntvl);
+    return 0;
+}
+
 
 /*@}*/ /* end of group SPIM_EXPORTED_FUNCTIONS */
 
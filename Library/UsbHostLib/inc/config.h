@@ -65,6 +65,35 @@
 #define MEM_POOL_UNIT_SIZE     64      /*!< A fixed hard coding setting. Do not change it!            */
 #define MEM_POOL_UNIT_NUM     256      /*!< Increase this or heap size if memory allocate failed.     */
 
+/*----------------------------------------------------------------------------------------*/
+/*   Mass storage class settings                                                          */
+/*----------------------------------------------------------------------------------------*/
+#define UMAS_PIPELINE          0       /*!< 1: send the CBW of the next command while the CSW of
+                                            the current one is pending. This is outside of
+                                            Bulk-Only Transport, only enable it for devices
+                                            known to accept it. 0: one command at a time.     */
+#define UMAS_READAHEAD_SECTORS 8       /*!< Default readahead window in sectors of each LUN,
+                                            filled on sequential reads. Change it with
+                                            usbh_umas_set_readahead(). 0: off.                */
+
+/*----------------------------------------------------------------------------------------*/
+/*   RTOS settings                                                                        */
+/*----------------------------------------------------------------------------------------*/
+#ifndef USBH_USE_RTOS
+#define USBH_USE_RTOS          0       /*!< 1: the USB IRQ handlers queue finished transfers and a
+                                            USB host task running usbh_task() calls them back,
+                                            polls hubs and enumerates devices. Tasks are
+                                            serialized by the usbh_os_xxx() port functions,
+                                            which user application must provide.
+                                            0: bare metal, callbacks run in the IRQ handlers.  */
+#endif
+#define USBH_HUB_POLL_MS       100     /*!< usbh_task() polls hubs at least this often        */
+#define USBH_IDLE_WAITERS      4       /*!< Tasks other than the USB host task waiting in class
+                                            drivers which are woken as soon as transfers have
+                                            been called back. Others poll every 1 ms.         */
+#define USBH_ABORT_WAIT_MS     20      /*!< How long a timed out transfer waits for its abort
+                                            to be called back before the UTR is released.     */
+
 /*----------------------------------------------------------------------------------------*/
 /*   Re-defined staff for various compiler                                                */
 /*----------------------------------------------------------------------------------------*/
@@ -395,6 +395,8 @@ typedef struct utr_t
     void        *context;             /*!< point to deivce proprietary data area \hideinitializer */
     FUNC_UTR_T  func;                 /*!< tansfer done call-back function       \hideinitializer */
     struct utr_t  *next;              /* point to the next UTR of the same endpoint. \hideinitializer */
+    struct utr_t  *done_next;         /*!< next UTR in the done queue (USBH_USE_RTOS) \hideinitializer */
+    void        *wait_task;           /*!< task blocked in usbh_utr_wait() (USBH_USE_RTOS) \hideinitializer */
 } UTR_T;
 
 
@@ -430,8 +432,26 @@ extern void usbh_dump_ep_info(EP_INFO_T *ep);
 /*
  *  Memory management functions
  */
+#define USBH_MEM_HEAP       0          /* heap memory allocated by USB core, in bytes     */
+#define USBH_MEM_POOL       1          /* hardware descriptor pool, in MEM_POOL_UNIT_SIZE */
+#define USBH_MEM_ED         2          /* OHCI ED                                         */
+#define USBH_MEM_TD         3          /* OHCI TD                                         */
+#define USBH_MEM_QH         4          /* EHCI QH                                         */
+#define USBH_MEM_QTD        5          /* EHCI qTD                                        */
+#define USBH_MEM_ITD        6          /* EHCI iTD, two pool units each                   */
+#define USBH_MEM_SITD       7          /* EHCI siTD                                       */
+#define USBH_MEM_STAT_NUM   8
+
+typedef struct
+{
+    int     cur;                       /* currently in use                                */
+    int     max;                       /* high-water mark since usbh_memory_init()        */
+    int     fail;                      /* number of failed allocations                    */
+}  USBH_MEM_STAT_T;
+
 extern void usbh_memory_init(void);
 extern uint32_t  usbh_memory_used(void);
+extern void usbh_memory_stat(int type, USBH_MEM_STAT_T *st);
 extern void * usbh_alloc_mem(int size);
 extern void usbh_free_mem(void *p, int size);
 extern int  alloc_dev_address(void);
@@ -476,6 +496,27 @@ extern int usbh_int_xfer(UTR_T *utr);
 extern int usbh_iso_xfer(UTR_T *utr);
 extern int usbh_quit_utr(UTR_T *utr);
 extern int usbh_quit_xfer(UDEV_T *udev, EP_INFO_T *ep);
+extern int usbh_bulk_xfer_wait(UTR_T *utr, uint32_t timeout);
+extern int usbh_int_xfer_wait(UTR_T *utr, uint32_t timeout);
+extern int usbh_utr_wait(UTR_T *utr, uint32_t timeout);
+extern void usbh_utr_done(UTR_T *utr);
+
+/*
+ *  Task serialization. Host controller driver calls are made with USBH_LOCK() held;
+ *  loops waiting for the USB stack call USBH_IDLE().
+ */
+#if USBH_USE_RTOS
+extern int  usbh_in_task(void);
+extern void usbh_hub_poll_request(void);
+extern void usbh_idle(void);
+#define USBH_LOCK()         usbh_os_lock()
+#define USBH_UNLOCK()       usbh_os_unlock()
+#define USBH_IDLE()         usbh_idle()
+#else
+#define USBH_LOCK()
+#define USBH_UNLOCK()
+#define USBH_IDLE()
+#endif
 
 
 /// @endcond HIDDEN_SYMBOLS
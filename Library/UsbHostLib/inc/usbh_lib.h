@@ -123,9 +123,35 @@ struct usbhid_dev;
 typedef void (HID_IR_FUNC)(struct usbhid_dev *hdev, uint16_t ep_addr, int status, uint8_t *rdata, uint32_t data_len);    /*!< interrupt in callback function \hideinitializer */
 typedef void (HID_IW_FUNC)(struct usbhid_dev *hdev, uint16_t ep_addr, int status, uint8_t *wbuff, uint32_t *data_len);   /*!< interrupt out callback function \hideinitializer */
 
+/*! Read/write statistics of a USB mass storage lun, see usbh_umas_get_stat(). Times are in get_ticks() units. */
+typedef struct umas_stat_t
+{
+    uint32_t  rd_cmd;                   /*!< Number of usbh_umas_read() calls               */
+    uint32_t  rd_sector;                /*!< Number of sectors read                         */
+    uint32_t  rd_ticks;                 /*!< Total time spent in usbh_umas_read()           */
+    uint32_t  rd_ticks_max;             /*!< Longest usbh_umas_read()                       */
+    uint32_t  wr_cmd;                   /*!< Number of usbh_umas_write() calls              */
+    uint32_t  wr_sector;                /*!< Number of sectors written                      */
+    uint32_t  wr_ticks;                 /*!< Total time spent in usbh_umas_write()          */
+    uint32_t  wr_ticks_max;             /*!< Longest usbh_umas_write()                      */
+    uint32_t  ra_hit;                   /*!< Reads served from the readahead buffer         */
+    uint32_t  ra_miss;                  /*!< Sequential reads not served from readahead     */
+    uint32_t  err;                      /*!< Failed reads and writes                        */
+}  UMAS_STAT_T;
+
 struct uac_dev_t;
 typedef int (UAC_CB_FUNC)(struct uac_dev_t *dev, uint8_t *data, int len);    /*!< audio in callback function \hideinitializer */
 
+/*! Statistics of a UAC PCM ring, see usbh_uac_ring_get_stat(). */
+typedef struct uac_ring_stat_t
+{
+    uint32_t  frames;                   /*!< Frames passed through the ring                 */
+    uint32_t  overrun;                  /*!< Audio in frames dropped as the ring was full    */
+    uint32_t  underrun;                 /*!< Audio out silent frames sent as the ring was empty */
+    uint32_t  latency;                  /*!< Audio buffered in ring, in micro-seconds       */
+    uint32_t  latency_max;              /*!< Maximum of latency                             */
+}  UAC_RING_STAT_T;
+
 /*@}*/ /* end of group USBH_EXPORTED_STRUCT */
 
 
@@ -154,6 +180,28 @@ extern struct udev_t * usbh_find_device(char *hub_id, int port);
  */
 extern uint32_t get_ticks(void);   /* This function must be provided by user application. */
 
+/*------------------------------------------------------------------*/
+/*                                                                  */
+/*  USB Host RTOS port (USBH_USE_RTOS = 1)                          */
+/*                                                                  */
+/*------------------------------------------------------------------*/
+extern void usbh_task(void *arg);
+/// @cond HIDDEN_SYMBOLS
+/*
+ *  The following functions must be provided by user application when USBH_USE_RTOS is 1.
+ *  usbh_os_lock() is a recursive mutex, created by usbh_os_init(). usbh_os_task_wait()
+ *  blocks the calling task until it is woken or ms milli-seconds elapsed; a wake which
+ *  arrives before the wait must not be lost.
+ */
+extern void usbh_os_init(void);
+extern void usbh_os_lock(void);
+extern void usbh_os_unlock(void);
+extern void *usbh_os_task_self(void);
+extern void usbh_os_task_wait(uint32_t ms);
+extern void usbh_os_task_wake(void *task);
+extern void usbh_os_task_wake_from_isr(void *task);
+/// @endcond HIDDEN_SYMBOLS
+
 /*------------------------------------------------------------------*/
 /*                                                                  */
 /*  USB Communication Device Class Library APIs                     */
@@ -200,6 +248,8 @@ extern int  usbh_umas_disk_status(int drv_no);
 extern int  usbh_umas_read(int drv_no, uint32_t sec_no, int sec_cnt, uint8_t *buff);
 extern int  usbh_umas_write(int drv_no, uint32_t sec_no, int sec_cnt, uint8_t *buff);
 extern int  usbh_umas_ioctl(int drv_no, int cmd, void *buff);
+extern int  usbh_umas_set_readahead(int drv_no, int sec_cnt);
+extern int  usbh_umas_get_stat(int drv_no, UMAS_STAT_T *stat, int clear);
 /// @cond HIDDEN_SYMBOLS
 extern int  usbh_umas_reset_disk(int drv_no);
 /// @endcond HIDDEN_SYMBOLS
@@ -222,6 +272,13 @@ extern int usbh_uac_start_audio_in(struct uac_dev_t *uac, UAC_CB_FUNC *func);
 extern int usbh_uac_stop_audio_in(struct uac_dev_t *audev);
 extern int usbh_uac_start_audio_out(struct uac_dev_t *uac, UAC_CB_FUNC *func);
 extern int usbh_uac_stop_audio_out(struct uac_dev_t *audev);
+extern int usbh_uac_start_audio_in_ring(struct uac_dev_t *uac, int blk_num);
+extern int usbh_uac_start_audio_out_ring(struct uac_dev_t *uac, int blk_num, int frame_len);
+extern int usbh_uac_ring_get_frame(struct uac_dev_t *uac, uint8_t target, uint8_t **frame);
+extern int usbh_uac_ring_put_frame(struct uac_dev_t *uac, uint8_t target, int len);
+extern int usbh_uac_ring_read(struct uac_dev_t *uac, uint8_t *buff, int len);
+extern int usbh_uac_ring_write(struct uac_dev_t *uac, uint8_t *buff, int len);
+extern int usbh_uac_ring_get_stat(struct uac_dev_t *uac, uint8_t target, UAC_RING_STAT_T *stat, int clear);
 
 
 /// @cond HIDDEN_SYMBOLS
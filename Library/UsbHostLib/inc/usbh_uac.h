@@ -31,6 +31,7 @@
 #define CONFIG_UAC_MAX_DEV           3      /*!< Maximum number of Audio Class device.                     */
 #define NUM_UTR                      2      /*!< Number of UTR used for audio in/out transfer.             */
 #define UAC_REQ_TIMEOUT              50     /*!< UAC control request timeout value in tick (10ms unit)     */
+#define UAC_RING_MAX_BLK             16     /*!< Maximum number of blocks of a PCM ring. Must be power of 2. */
 
 #define UAC_SPEAKER                  1      /*!< Control target is speaker of UAC device. \hideinitializer */
 #define UAC_MICROPHONE               2      /*!< Control target is microphone of UAC device. \hideinitializer */
@@ -86,6 +87,38 @@ typedef struct ac_if_t
     uint8_t        speaker_fuid;            /*!< Speaker Feature Unit ID                  */
 }  AC_IF_T;
 
+/*----------------------------------------------------------------------------------------*/
+/*  PCM ring                                                                              */
+/*----------------------------------------------------------------------------------------*/
+/*
+ *  A PCM ring is made of blocks. A block holds the IF_PER_UTR isochronous frames of one UTR,
+ *  so UTR frame buffers are mapped straight onto ring blocks. Blocks go round between the
+ *  USB interrupt and the application through two single-producer single-consumer queues.
+ */
+typedef struct uac_blk_q_t
+{
+    volatile uint32_t  head;                /*!< Written by producer only                 */
+    volatile uint32_t  tail;                /*!< Written by consumer only                 */
+    uint8_t        id[UAC_RING_MAX_BLK];    /*!< Block ids                                */
+}  UAC_BLK_Q_T;
+
+typedef struct uac_ring_t
+{
+    uint8_t        *buff;                   /*!< blk_num blocks followed by a silent block */
+    uint32_t       blk_size;                /*!< Bytes per block, IF_PER_UTR * pkt_size   */
+    uint16_t       pkt_size;                /*!< Bytes per frame slot, wMaxPacketSize     */
+    uint16_t       frame_len;               /*!< Audio out bytes per frame                */
+    uint16_t       frame_us;                /*!< Frame interval in micro-seconds          */
+    uint8_t        blk_num;                 /*!< Number of blocks, silent block excluded  */
+    UAC_BLK_Q_T    full_q;                  /*!< Blocks holding audio data                */
+    UAC_BLK_Q_T    free_q;                  /*!< Blocks free for audio data               */
+    uint16_t       xlen[(UAC_RING_MAX_BLK + 1) * IF_PER_UTR];  /*!< Frame data length     */
+    int            cur_blk;                 /*!< Application side current block, or -1    */
+    int            cur_frame;               /*!< Application side frame in cur_blk        */
+    int            cur_off;                 /*!< Application side offset in cur_frame     */
+    UAC_RING_STAT_T  stat;                  /*!< Statistics                               */
+}  UAC_RING_T;
+
 /*----------------------------------------------------------------------------------------*/
 /*  Audio Streaming Interface                                                             */
 /*----------------------------------------------------------------------------------------*/
@@ -100,6 +133,7 @@ typedef struct as_if_t
     AS_FT1_T       *ft;                     /*!< Point to Format type descriptor, support Type-I only */
     CS_EP_T        *cs_epd;                 /*!< Point to AS Isochronous Audio Data Endpoint Descriptor */
     uint8_t        flag_streaming;          /*!< audio is streaming or not                */
+    UAC_RING_T     *ring;                   /*!< PCM ring, NULL if callback is used       */
 }  AS_IF_T;
 
 
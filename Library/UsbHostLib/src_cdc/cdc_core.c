@@ -384,7 +384,6 @@ int32_t usbh_cdc_send_data(CDC_DEV_T *cdev, uint8_t *buff, int buff_len)
 {
     EP_INFO_T   *ep;
     UTR_T       *utr;
-    uint32_t    t0;
     int         ret;
 
     if ((cdev == NULL) || (cdev->iface_data == NULL))
@@ -417,27 +416,13 @@ int32_t usbh_cdc_send_data(CDC_DEV_T *cdev, uint8_t *buff, int buff_len)
     utr->func = cdc_bulk_out_irq;
     bulk_out_done = 0;
 
-    ret = usbh_bulk_xfer(utr);
+    /* bulk_out_done is shared by all CDC devices, so the status of this UTR is returned */
+    ret = usbh_bulk_xfer_wait(utr, USB_XFER_TIMEOUT);
     if (ret < 0)
-    {
-        CDC_DBGMSG("Error - failed to submit bulk in request (%d)", ret);
-        free_utr(utr);
-        return ret;
-    }
-
-    t0 = get_ticks();
-    while (bulk_out_done == 0)
-    {
-        if (get_ticks() - t0 > USB_XFER_TIMEOUT)
-        {
-            usbh_quit_utr(utr);
-            free_utr(utr);
-            return USBH_ERR_TIMEOUT;
-        }
-    }
+        CDC_DBGMSG("Error - bulk out transfer failed (%d)", ret);
 
     free_utr(utr);
-    return 0;
+    return ret;
 }
 
 /*@}*/ /* end of group USBH_EXPORTED_FUNCTIONS */
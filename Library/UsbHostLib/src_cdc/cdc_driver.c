@@ -213,7 +213,7 @@ static void  cdc_disconnect(IFACE_T *iface)
     {
         for (i = 0; i < if_cdc->aif->ifd->bNumEndpoints; i++)
         {
-            if_cdc->udev->hc_driver->quit_xfer(NULL, &(if_cdc->aif->ep[i]));
+            usbh_quit_xfer(if_cdc->udev, &(if_cdc->aif->ep[i]));
         }
     }
 
@@ -221,7 +221,7 @@ static void  cdc_disconnect(IFACE_T *iface)
     {
         for (i = 0; i < if_data->aif->ifd->bNumEndpoints; i++)
         {
-            if_data->udev->hc_driver->quit_xfer(NULL, &(if_data->aif->ep[i]));
+            usbh_quit_xfer(if_data->udev, &(if_data->aif->ep[i]));
         }
     }
 
@@ -963,9 +963,7 @@ static void scan_asynchronous_list()
             else
                 utr->ep->bToggle = 0;
 
-            utr->bIsTransferDone = 1;
-            if (utr->func)
-                utr->func(utr);
+            usbh_utr_done(utr);
 
             _ehci->UCMDR |= HSUSBH_UCMDR_IAAD_Msk;   /* trigger IAA to reclaim done_list  */
         }
@@ -1017,9 +1015,7 @@ static void scan_periodic_frame_list()
             else
                 utr->ep->bToggle = 0;
 
-            utr->bIsTransferDone = 1;
-            if (utr->func)
-                utr->func(utr);
+            usbh_utr_done(utr);
 
             _ehci->UCMDR |= HSUSBH_UCMDR_IAAD_Msk;   /* trigger IAA to reclaim done_list  */
 
@@ -1069,9 +1065,7 @@ void iaad_remove_qh()
                 free_ehci_qTD(qtd);
             }
             utr->status = USBH_ERR_ABORT;
-            utr->bIsTransferDone = 1;
-            if (utr->func)
-                utr->func(utr);             /* call back                                  */
+            usbh_utr_done(utr);             /* call back                                  */
         }
         free_ehci_QH(qh);                   /* free the QH                                */
     }
@@ -1164,13 +1158,15 @@ static int ehci_rh_port_reset(int port)
         _ehci->UPSCR[port] = (_ehci->UPSCR[port] | HSUSBH_UPSCR_PRST_Msk) & ~HSUSBH_UPSCR_PE_Msk;
 
         t0 = get_ticks();
-        while (get_ticks() - t0 <  (reset_time/10)+1) ;     /* wait at least 50 ms        */
+        while (get_ticks() - t0 <  (reset_time/10)+1)       /* wait at least 50 ms        */
+            USBH_IDLE();
 
         _ehci->UPSCR[port] &= ~HSUSBH_UPSCR_PRST_Msk;
 
         t0 = get_ticks();
         while (get_ticks() - t0 < (reset_time/10)+1)
         {
+            USBH_IDLE();
             if (!(_ehci->UPSCR[port] & HSUSBH_UPSCR_CCS_Msk) ||
                     ((_ehci->UPSCR[port] & (HSUSBH_UPSCR_CCS_Msk | HSUSBH_UPSCR_PE_Msk)) == (HSUSBH_UPSCR_CCS_Msk | HSUSBH_UPSCR_PE_Msk)))
                 goto port_reset_done;
@@ -1224,6 +1220,7 @@ static int ehci_rh_polling(void)
     connect_status = _ehci->UPSCR[0] & HSUSBH_UPSCR_CCS_Msk;
     while (get_ticks() - t0 < HUB_DEBOUNCE_TIME/10)
     {
+        USBH_IDLE();
         if (connect_status != (_ehci->UPSCR[0] & HSUSBH_UPSCR_CCS_Msk))
         {
             /* reset stable time counting                                             */
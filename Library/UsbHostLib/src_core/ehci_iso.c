@@ -106,9 +106,7 @@ static int  review_itd(iTD_T *itd)
 
     if (utr->td_cnt == 0)                   /* All iTD of this UTR done                   */
     {
-        utr->bIsTransferDone = 1;
-        if (utr->func)
-            utr->func(utr);
+        usbh_utr_done(utr);
     }
 
     return 1;                               /* to be reclaimed                            */
@@ -181,9 +179,7 @@ static int  review_sitd(siTD_T *sitd)
 
     if (utr->td_cnt == 0)                   /* All iTD of this UTR done                   */
     {
-        utr->bIsTransferDone = 1;
-        if (utr->func)
-            utr->func(utr);
+        usbh_utr_done(utr);
     }
     return 1;                               /* to be reclaimed                            */
 }
@@ -887,9 +883,7 @@ int ehci_quit_iso_xfer(UTR_T *utr, EP_INFO_T *ep)
 
         if (utr->td_cnt == 0)               /* All iTD of this UTR done                   */
         {
-            utr->bIsTransferDone = 1;
-            if (utr->func)
-                utr->func(utr);
+            usbh_utr_done(utr);
             utr->status = USBH_ERR_ABORT;
         }
         free_ehci_iTD(itd);
@@ -630,6 +630,8 @@ void usbh_hub_init(void)
   *           In this function, USB stack enumerates newly connected devices and remove staff
   *           of disconnected devices. User's application should periodically invoke this
   *           function.
+  *           If USBH_USE_RTOS is 1, hubs are polled by usbh_task(). Called by another task,
+  *           this function only wakes usbh_task() to poll hubs now, and returns 0.
   * @return   There's hub port change or not.
   * @retval   0   No any hub port status changes found.
   * @retval   1   There's hub port status changes.
@@ -638,6 +640,14 @@ int  usbh_pooling_hubs(void)
 {
     int   ret, change = 0;
 
+#if USBH_USE_RTOS
+    if (!usbh_in_task())
+    {
+        usbh_hub_poll_request();
+        return 0;
+    }
+#endif
+
 #ifdef ENABLE_EHCI
     if ((SYS->CSERVER & SYS_CSERVER_VERSION_Msk) == 0x0)    /* Only M480MD has EHCI. */
     {
@@ -32,11 +32,29 @@ static uint8_t  _mem_pool[MEM_POOL_UNIT_NUM][MEM_POOL_UNIT_SIZE];
 #else
 static uint8_t _mem_pool[MEM_POOL_UNIT_NUM][MEM_POOL_UNIT_SIZE] __attribute__((aligned(32)));
 #endif
-static uint8_t  _unit_used[MEM_POOL_UNIT_NUM];
+static uint8_t  _unit_used[MEM_POOL_UNIT_NUM];  /* owner of each unit, USBH_MEM_ED ~ USBH_MEM_SITD, 0 if free */
+
+/*
+ *  Pool units are handed out from two segregated free lists, one for single unit descriptors
+ *  (ED, TD, QH, qTD, siTD) and one for two unit iTD. A freed descriptor goes back to the list of
+ *  its size, so allocate and free are O(1). The links live in the free units themselves.
+ *  When single units run out, a free pair is split. When no free pair is left, two adjacent
+ *  free single units are searched and joined, the only path that scans the pool.
+ */
+#define MEM_UNIT_PAIR   0xFF            /* _unit_used[] mark of a unit in the free pair list */
+
+typedef struct mem_link_t
+{
+    struct mem_link_t  *next;
+    struct mem_link_t  *prev;
+} MEM_LINK_T;
+
+static MEM_LINK_T  *_free_unit;         /* free single units, doubly linked           */
+static MEM_LINK_T  *_free_pair;         /* free unit pairs, singly linked             */
 
-static volatile int  _usbh_mem_used;
-static volatile int  _usbh_max_mem_used;
-static volatile int  _mem_pool_used;
+#define MEM_UNIT(i)     ((MEM_LINK_T *)&_mem_pool[(i)][0])
+
+static USBH_MEM_STAT_T  _mem_stat[USBH_MEM_STAT_NUM];
 
 
 UDEV_T * g_udev_list;
@@ -44,14 +62,14 @@ UDEV_T * g_udev_list;
 uint8_t  _dev_addr_pool[128];
 static volatile int  _device_addr;
 
-static  int  _sidx = 0;;
-
 /*--------------------------------------------------------------------------*/
 /*   Memory alloc/free recording                                            */
 /*--------------------------------------------------------------------------*/
 
 void usbh_memory_init(void)
 {
+    int   i;
+
     if (sizeof(TD_T) > MEM_POOL_UNIT_SIZE)
     {
         USB_error("TD_T - MEM_POOL_UNIT_SIZE too small!\n");
@@ -64,12 +82,22 @@ void usbh_memory_init(void)
         while (1);
     }
 
-    _usbh_mem_used = 0L;
-    _usbh_max_mem_used = 0L;
+    if (sizeof(iTD_T) > 2 * MEM_POOL_UNIT_SIZE)
+    {
+        USB_error("iTD_T - MEM_POOL_UNIT_SIZE too small!\n");
+        while (1);
+    }
+
+    memset(_mem_stat, 0, sizeof(_mem_stat));
 
     memset(_unit_used, 0, sizeof(_unit_used));
-    _mem_pool_used = 0;
-    _sidx = 0;
+    for (i = 0; i < MEM_POOL_UNIT_NUM; i++)
+    {
+        MEM_UNIT(i)->next = (i + 1 < MEM_POOL_UNIT_NUM) ? MEM_UNIT(i + 1) : NULL;
+        MEM_UNIT(i)->prev = (i > 0) ? MEM_UNIT(i - 1) : NULL;
+    }
+    _free_unit = MEM_UNIT(0);
+    _free_pair = NULL;
 
     g_udev_list = NULL;
 
@@ -79,39 +107,209 @@ void usbh_memory_init(void)
 
 uint32_t  usbh_memory_used(void)
 {
-    printf("USB static memory: %d/%d, heap used: %d\n", _mem_pool_used, MEM_POOL_UNIT_NUM, _usbh_mem_used);
-    return _usbh_mem_used;
+    USBH_MEM_STAT_T  *st = _mem_stat;
+
+    printf("USB static memory: %d/%d (max %d), heap used: %d (max %d)\n",
+           st[USBH_MEM_POOL].cur, MEM_POOL_UNIT_NUM, st[USBH_MEM_POOL].max,
+           st[USBH_MEM_HEAP].cur, st[USBH_MEM_HEAP].max);
+    printf("    ED %d/%d, TD %d/%d, QH %d/%d, qTD %d/%d, iTD %d/%d, siTD %d/%d, failed %d\n",
+           st[USBH_MEM_ED].cur, st[USBH_MEM_ED].max, st[USBH_MEM_TD].cur, st[USBH_MEM_TD].max,
+           st[USBH_MEM_QH].cur, st[USBH_MEM_QH].max, st[USBH_MEM_QTD].cur, st[USBH_MEM_QTD].max,
+           st[USBH_MEM_ITD].cur, st[USBH_MEM_ITD].max, st[USBH_MEM_SITD].cur, st[USBH_MEM_SITD].max,
+           st[USBH_MEM_POOL].fail);
+    return st[USBH_MEM_HEAP].cur;
+}
+
+/**
+ *  @brief  Get memory usage statistics of USB Host Library.
+ *  @param[in]  type  USBH_MEM_HEAP, USBH_MEM_POOL, or descriptor type USBH_MEM_ED ~ USBH_MEM_SITD.
+ *  @param[out] st    Current usage, high-water mark and failed allocation count. Heap in bytes,
+ *                    descriptors in number of descriptors, and USBH_MEM_POOL in pool units.
+ *  @return None
+ */
+void usbh_memory_stat(int type, USBH_MEM_STAT_T *st)
+{
+    if ((type >= 0) && (type < USBH_MEM_STAT_NUM))
+        *st = _mem_stat[type];
 }
 
-static void  memory_counter(int size)
+static void  mem_stat_add(int type, int n)
 {
-    _usbh_mem_used += size;
-    if (_usbh_mem_used > _usbh_max_mem_used)
-        _usbh_max_mem_used = _usbh_mem_used;
+    _mem_stat[type].cur += n;
+    if (_mem_stat[type].cur > _mem_stat[type].max)
+        _mem_stat[type].max = _mem_stat[type].cur;
 }
 
+/* Heap calls of different tasks are serialized by USBH_LOCK() if USBH_USE_RTOS is 1. */
 void * usbh_alloc_mem(int size)
 {
     void  *p;
 
+    USBH_LOCK();
     p = malloc(size);
     if (p == NULL)
     {
+        _mem_stat[USBH_MEM_HEAP].fail++;
+        USBH_UNLOCK();
         USB_error("usbh_alloc_mem failed! %d\n", size);
         return NULL;
     }
+    mem_stat_add(USBH_MEM_HEAP, size);
+    USBH_UNLOCK();
 
     memset(p, 0, size);
-    memory_counter(size);
     return p;
 }
 
 void usbh_free_mem(void *p, int size)
 {
+    USBH_LOCK();
     free(p);
-    memory_counter(0-size);
+    mem_stat_add(USBH_MEM_HEAP, 0-size);
+    USBH_UNLOCK();
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Hardware descriptor pool                                               */
+/*--------------------------------------------------------------------------*/
+
+/* Both OHCI and EHCI interrupt handlers allocate and free descriptors. */
+static __INLINE uint32_t mem_lock(void)
+{
+    uint32_t  primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static __INLINE void mem_unlock(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+static void unit_list_remove(MEM_LINK_T *u)
+{
+    if (u->prev != NULL)
+        u->prev->next = u->next;
+    else
+        _free_unit = u->next;
+    if (u->next != NULL)
+        u->next->prev = u->prev;
+}
+
+static void unit_list_add(MEM_LINK_T *u)
+{
+    u->prev = NULL;
+    u->next = _free_unit;
+    if (_free_unit != NULL)
+        _free_unit->prev = u;
+    _free_unit = u;
 }
 
+/* Allocate <units> (1 or 2) contiguous units for descriptor <type>. */
+static void * mem_pool_alloc(int type, int units)
+{
+    MEM_LINK_T  *p = NULL;
+    uint32_t    primask;
+    int         i, idx;
+
+    primask = mem_lock();
+    if (units == 1)
+    {
+        if (_free_unit != NULL)
+        {
+            p = _free_unit;
+            unit_list_remove(p);
+        }
+        else if (_free_pair != NULL)
+        {
+            /* split a free pair, its second unit goes to the single unit list */
+            p = _free_pair;
+            _free_pair = p->next;
+            idx = (int)(((uint8_t *)p - &_mem_pool[0][0]) / MEM_POOL_UNIT_SIZE);
+            _unit_used[idx+1] = 0;
+            unit_list_add(MEM_UNIT(idx+1));
+        }
+    }
+    else
+    {
+        if (_free_pair != NULL)
+        {
+            p = _free_pair;
+            _free_pair = p->next;
+        }
+        else
+        {
+            /* join two adjacent free single units, searching from the top of the pool where
+               single units are least likely taken */
+            for (i = MEM_POOL_UNIT_NUM - 2; i >= 0; i--)
+            {
+                if ((_unit_used[i] == 0) && (_unit_used[i+1] == 0))
+                {
+                    p = MEM_UNIT(i);
+                    unit_list_remove(p);
+                    unit_list_remove(MEM_UNIT(i+1));
+                    break;
+                }
+            }
+        }
+    }
+
+    if (p == NULL)
+    {
+        _mem_stat[type].fail++;
+        _mem_stat[USBH_MEM_POOL].fail++;
+        mem_unlock(primask);
+        return NULL;
+    }
+
+    idx = (int)(((uint8_t *)p - &_mem_pool[0][0]) / MEM_POOL_UNIT_SIZE);
+    _unit_used[idx] = (uint8_t)type;
+    if (units == 2)
+        _unit_used[idx+1] = (uint8_t)type;
+    mem_stat_add(type, 1);
+    mem_stat_add(USBH_MEM_POOL, units);
+    mem_unlock(primask);
+
+    memset(p, 0, units * MEM_POOL_UNIT_SIZE);
+    return p;
+}
+
+/* Return descriptor <p> of <type>. Returns -1 if it is not an allocated descriptor of <type>. */
+static int mem_pool_free(void *p, int type, int units)
+{
+    MEM_LINK_T  *u = (MEM_LINK_T *)p;
+    uint32_t    primask;
+    int         ofs, idx;
+
+    ofs = (int)((uint8_t *)p - &_mem_pool[0][0]);
+    if ((p == NULL) || ((uint8_t *)p < &_mem_pool[0][0]) ||
+            (ofs >= MEM_POOL_UNIT_NUM * MEM_POOL_UNIT_SIZE) || (ofs % MEM_POOL_UNIT_SIZE))
+        return -1;
+
+    idx = ofs / MEM_POOL_UNIT_SIZE;
+
+    primask = mem_lock();
+    if (_unit_used[idx] != type)
+    {
+        mem_unlock(primask);
+        return -1;
+    }
+    if (units == 1)
+    {
+        _unit_used[idx] = 0;
+        unit_list_add(u);
+    }
+    else
+    {
+        _unit_used[idx] = _unit_used[idx+1] = MEM_UNIT_PAIR;
+        u->next = _free_pair;
+        _free_pair = u;
+    }
+    mem_stat_add(type, -1);
+    mem_stat_add(USBH_MEM_POOL, -units);
+    mem_unlock(primask);
+    return 0;
+}
 
 /*--------------------------------------------------------------------------*/
 /*   USB device allocate/free                                               */
@@ -121,14 +319,17 @@ UDEV_T * alloc_device(void)
 {
     UDEV_T  *udev;
 
+    USBH_LOCK();
     udev = malloc(sizeof(*udev));
+    if (udev != NULL)
+        mem_stat_add(USBH_MEM_HEAP, sizeof(*udev));
+    USBH_UNLOCK();
     if (udev == NULL)
     {
         USB_error("alloc_device failed!\n");
         return NULL;
     }
     memset(udev, 0, sizeof(*udev));
-    memory_counter(sizeof(*udev));
     udev->cur_conf = -1;                    /* must! used to identify the first SET CONFIGURATION */
     udev->next = g_udev_list;               /* chain to global device list */
     g_udev_list = udev;
@@ -166,8 +367,10 @@ void free_device(UDEV_T *udev)
         }
     }
 
+    USBH_LOCK();
     free(udev);
-    memory_counter(-sizeof(*udev));
+    mem_stat_add(USBH_MEM_HEAP, 0-(int)sizeof(*udev));
+    USBH_UNLOCK();
 }
 
 int  alloc_dev_address(void)
@@ -204,13 +407,16 @@ UTR_T * alloc_utr(UDEV_T *udev)
 {
     UTR_T  *utr;
 
+    USBH_LOCK();
     utr = malloc(sizeof(*utr));
+    if (utr != NULL)
+        mem_stat_add(USBH_MEM_HEAP, sizeof(*utr));
+    USBH_UNLOCK();
     if (utr == NULL)
     {
         USB_error("alloc_utr failed!\n");
         return NULL;
     }
-    memory_counter(sizeof(*utr));
     memset(utr, 0, sizeof(*utr));
     utr->udev = udev;
     mem_debug("[ALLOC] [UTR] - 0x%x\n", (int)utr);
@@ -223,8 +429,10 @@ void free_utr(UTR_T *utr)
         return;
 
     mem_debug("[FREE] [UTR] - 0x%x\n", (int)utr);
+    USBH_LOCK();
     free(utr);
-    memory_counter(0-(int)sizeof(*utr));
+    mem_stat_add(USBH_MEM_HEAP, 0-(int)sizeof(*utr));
+    USBH_UNLOCK();
 }
 
 /*--------------------------------------------------------------------------*/
@@ -233,40 +441,26 @@ void free_utr(UTR_T *utr)
 
 ED_T * alloc_ohci_ED(void)
 {
-    int    i;
     ED_T   *ed;
 
-    for (i = 0; i < MEM_POOL_UNIT_NUM; i++)
+    ed = (ED_T *)mem_pool_alloc(USBH_MEM_ED, 1);
+    if (ed == NULL)
     {
-        if (_unit_used[i] == 0)
-        {
-            _unit_used[i] = 1;
-            _mem_pool_used++;
-            ed = (ED_T *)&_mem_pool[i];
-            memset(ed, 0, sizeof(*ed));
-            mem_debug("[ALLOC] [ED] - 0x%x\n", (int)ed);
-            return ed;
-        }
+        USB_error("alloc_ohci_ED failed!\n");
+        return NULL;
     }
-    USB_error("alloc_ohci_ED failed!\n");
-    return NULL;
+    mem_debug("[ALLOC] [ED] - 0x%x\n", (int)ed);
+    return ed;
 }
 
 void free_ohci_ED(ED_T *ed)
 {
-    int      i;
-
-    for (i = 0; i < MEM_POOL_UNIT_NUM; i++)
+    if (mem_pool_free(ed, USBH_MEM_ED, 1) < 0)
     {
-        if ((uint32_t)&_mem_pool[i] == (uint32_t)ed)
-        {
-            mem_debug("[FREE]  [ED] - 0x%x\n", (int)ed);
-            _unit_used[i] = 0;
-            _mem_pool_used--;
-            return;
-        }
+        USB_debug("free_ohci_ED - not found! (ignored in case of multiple UTR)\n");
+        return;
     }
-    USB_debug("free_ohci_ED - not found! (ignored in case of multiple UTR)\n");
+    mem_debug("[FREE]  [ED] - 0x%x\n", (int)ed);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -274,42 +468,27 @@ void free_ohci_ED(ED_T *ed)
 /*--------------------------------------------------------------------------*/
 TD_T * alloc_ohci_TD(UTR_T *utr)
 {
-    int    i;
     TD_T   *td;
 
-    for (i = 0; i < MEM_POOL_UNIT_NUM; i++)
+    td = (TD_T *)mem_pool_alloc(USBH_MEM_TD, 1);
+    if (td == NULL)
     {
-        if (_unit_used[i] == 0)
-        {
-            _unit_used[i] = 1;
-            _mem_pool_used++;
-            td = (TD_T *)&_mem_pool[i];
-
-            memset(td, 0, sizeof(*td));
-            td->utr = utr;
-            mem_debug("[ALLOC] [TD] - 0x%x\n", (int)td);
-            return td;
-        }
+        USB_error("alloc_ohci_TD failed!\n");
+        return NULL;
     }
-    USB_error("alloc_ohci_TD failed!\n");
-    return NULL;
+    td->utr = utr;
+    mem_debug("[ALLOC] [TD] - 0x%x\n", (int)td);
+    return td;
 }
 
 void free_ohci_TD(TD_T *td)
 {
-    int   i;
-
-    for (i = 0; i < MEM_POOL_UNIT_NUM; i++)
+    if (mem_pool_free(td, USBH_MEM_TD, 1) < 0)
     {
-        if ((uint32_t)&_mem_pool[i] == (uint32_t)td)
-        {
-            mem_debug("[FREE]  [TD] - 0x%x\n", (int)td);
-            _unit_used[i] = 0;
-            _mem_pool_used--;
-            return;
-        }
+        USB_error("free_ohci_TD - not found!\n");
+        return;
     }
-    USB_error("free_ohci_TD - not found!\n");
+    mem_debug("[FREE]  [TD] - 0x%x\n", (int)td);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -317,27 +496,15 @@ void free_ohci_TD(TD_T *td)
 /*--------------------------------------------------------------------------*/
 QH_T * alloc_ehci_QH(void)
 {
-    int    i;
-    QH_T   *qh = NULL;
+    QH_T   *qh;
 
-    for (i = (_sidx+1) % MEM_POOL_UNIT_NUM; i != _sidx; i = (i+1) % MEM_POOL_UNIT_NUM)
-    {
-        if (_unit_used[i] == 0)
-        {
-            _unit_used[i] = 1;
-            _sidx = i;
-            _mem_pool_used++;
-            qh = (QH_T *)&_mem_pool[i];
-            memset(qh, 0, sizeof(*qh));
-            mem_debug("[ALLOC] [QH] - 0x%x\n", (int)qh);
-            break;
-        }
-    }
+    qh = (QH_T *)mem_pool_alloc(USBH_MEM_QH, 1);
     if (qh == NULL)
     {
         USB_error("alloc_ehci_QH failed!\n");
         return NULL;
     }
+    mem_debug("[ALLOC] [QH] - 0x%x\n", (int)qh);
     qh->Curr_qTD        = QTD_LIST_END;
     qh->OL_Next_qTD     = QTD_LIST_END;
     qh->OL_Alt_Next_qTD = QTD_LIST_END;
@@ -347,19 +514,12 @@ QH_T * alloc_ehci_QH(void)
 
 void free_ehci_QH(QH_T *qh)
 {
-    int      i;
-
-    for (i = 0; i < MEM_POOL_UNIT_NUM; i++)
+    if (mem_pool_free(qh, USBH_MEM_QH, 1) < 0)
     {
-        if ((uint32_t)&_mem_pool[i] == (uint32_t)qh)
-        {
-            mem_debug("[FREE]  [QH] - 0x%x\n", (int)qh);
-            _unit_used[i] = 0;
-            _mem_pool_used--;
-            return;
-        }
+        USB_debug("free_ehci_QH - not found! (ignored in case of multiple UTR)\n");
+        return;
     }
-    USB_debug("free_ehci_QH - not found! (ignored in case of multiple UTR)\n");
+    mem_debug("[FREE]  [QH] - 0x%x\n", (int)qh);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -367,46 +527,30 @@ void free_ehci_QH(QH_T *qh)
 /*--------------------------------------------------------------------------*/
 qTD_T * alloc_ehci_qTD(UTR_T *utr)
 {
-    int     i;
     qTD_T   *qtd;
 
-    for (i = (_sidx+1) % MEM_POOL_UNIT_NUM; i != _sidx; i = (i+1) % MEM_POOL_UNIT_NUM)
+    qtd = (qTD_T *)mem_pool_alloc(USBH_MEM_QTD, 1);
+    if (qtd == NULL)
     {
-        if (_unit_used[i] == 0)
-        {
-            _unit_used[i] = 1;
-            _sidx = i;
-            _mem_pool_used++;
-            qtd = (qTD_T *)&_mem_pool[i];
-
-            memset(qtd, 0, sizeof(*qtd));
-            qtd->Next_qTD     = QTD_LIST_END;
-            qtd->Alt_Next_qTD = QTD_LIST_END;
-            qtd->Token        = 0x1197B3F; // QTD_STS_HALT;  visit_qtd() will not remove a qTD with this mark. It means the qTD still not ready for transfer.
-            qtd->utr = utr;
-            mem_debug("[ALLOC] [qTD] - 0x%x\n", (int)qtd);
-            return qtd;
-        }
+        USB_error("alloc_ehci_qTD failed!\n");
+        return NULL;
     }
-    USB_error("alloc_ehci_qTD failed!\n");
-    return NULL;
+    qtd->Next_qTD     = QTD_LIST_END;
+    qtd->Alt_Next_qTD = QTD_LIST_END;
+    qtd->Token        = 0x1197B3F; // QTD_STS_HALT;  visit_qtd() will not remove a qTD with this mark. It means the qTD still not ready for transfer.
+    qtd->utr = utr;
+    mem_debug("[ALLOC] [qTD] - 0x%x\n", (int)qtd);
+    return qtd;
 }
 
 void free_ehci_qTD(qTD_T *qtd)
 {
-    int   i;
-
-    for (i = 0; i < MEM_POOL_UNIT_NUM; i++)
+    if (mem_pool_free(qtd, USBH_MEM_QTD, 1) < 0)
     {
-        if ((uint32_t)&_mem_pool[i] == (uint32_t)qtd)
-        {
-            mem_debug("[FREE]  [qTD] - 0x%x\n", (int)qtd);
-            _unit_used[i] = 0;
-            _mem_pool_used--;
-            return;
-        }
+        USB_error("free_ehci_qTD 0x%x - not found!\n", (int)qtd);
+        return;
     }
-    USB_error("free_ehci_qTD 0x%x - not found!\n", (int)qtd);
+    mem_debug("[FREE]  [qTD] - 0x%x\n", (int)qtd);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -414,86 +558,53 @@ void free_ehci_qTD(qTD_T *qtd)
 /*--------------------------------------------------------------------------*/
 iTD_T * alloc_ehci_iTD(void)
 {
-    int     i;
     iTD_T   *itd;
 
-    for (i = (_sidx+1) % MEM_POOL_UNIT_NUM; i != _sidx; i = (i+1) % MEM_POOL_UNIT_NUM)
+    itd = (iTD_T *)mem_pool_alloc(USBH_MEM_ITD, 2);
+    if (itd == NULL)
     {
-        if (i+2 >= MEM_POOL_UNIT_NUM)
-            continue;
-
-        if ((_unit_used[i] == 0) && (_unit_used[i+1] == 0))
-        {
-            _unit_used[i] = _unit_used[i+1] = 1;
-            _sidx = i+1;
-            _mem_pool_used += 2;
-            itd = (iTD_T *)&_mem_pool[i];
-            memset(itd, 0, sizeof(*itd));
-            mem_debug("[ALLOC] [iTD] - 0x%x\n", (int)itd);
-            return itd;
-        }
+        USB_error("alloc_ehci_iTD failed!\n");
+        return NULL;
     }
-    USB_error("alloc_ehci_iTD failed!\n");
-    return NULL;
+    mem_debug("[ALLOC] [iTD] - 0x%x\n", (int)itd);
+    return itd;
 }
 
 void free_ehci_iTD(iTD_T *itd)
 {
-    int   i;
-
-    for (i = 0; i+1 < MEM_POOL_UNIT_NUM; i++)
+    if (mem_pool_free(itd, USBH_MEM_ITD, 2) < 0)
     {
-        if ((uint32_t)&_mem_pool[i] == (uint32_t)itd)
-        {
-            mem_debug("[FREE]  [iTD] - 0x%x\n", (int)itd);
-            _unit_used[i] = _unit_used[i+1] = 0;
-            _mem_pool_used -= 2;
-            return;
-        }
+        USB_error("free_ehci_iTD 0x%x - not found!\n", (int)itd);
+        return;
     }
-    USB_error("free_ehci_iTD 0x%x - not found!\n", (int)itd);
+    mem_debug("[FREE]  [iTD] - 0x%x\n", (int)itd);
 }
 
 /*--------------------------------------------------------------------------*/
-/*   EHCI iTD allocate/free                                                 */
+/*   EHCI siTD allocate/free                                                */
 /*--------------------------------------------------------------------------*/
 siTD_T * alloc_ehci_siTD(void)
 {
-    int     i;
     siTD_T  *sitd;
 
-    for (i = (_sidx+1) % MEM_POOL_UNIT_NUM; i != _sidx; i = (i+1) % MEM_POOL_UNIT_NUM)
+    sitd = (siTD_T *)mem_pool_alloc(USBH_MEM_SITD, 1);
+    if (sitd == NULL)
     {
-        if (_unit_used[i] == 0)
-        {
-            _unit_used[i] = 1;
-            _sidx = i;
-            _mem_pool_used ++;
-            sitd = (siTD_T *)&_mem_pool[i];
-            memset(sitd, 0, sizeof(*sitd));
-            mem_debug("[ALLOC] [siTD] - 0x%x\n", (int)sitd);
-            return sitd;
-        }
+        USB_error("alloc_ehci_siTD failed!\n");
+        return NULL;
     }
-    USB_error("alloc_ehci_siTD failed!\n");
-    return NULL;
+    mem_debug("[ALLOC] [siTD] - 0x%x\n", (int)sitd);
+    return sitd;
 }
 
 void free_ehci_siTD(siTD_T *sitd)
 {
-    int   i;
-
-    for (i = 0; i < MEM_POOL_UNIT_NUM; i++)
+    if (mem_pool_free(sitd, USBH_MEM_SITD, 1) < 0)
     {
-        if ((uint32_t)&_mem_pool[i] == (uint32_t)sitd)
-        {
-            mem_debug("[FREE]  [siTD] - 0x%x\n", (int)sitd);
-            _unit_used[i] = 0;
-            _mem_pool_used--;
-            return;
-        }
+        USB_error("free_ehci_siTD 0x%x - not found!\n", (int)sitd);
+        return;
     }
-    USB_error("free_ehci_siTD 0x%x - not found!\n", (int)sitd);
+    mem_debug("[FREE]  [siTD] - 0x%x\n", (int)sitd);
 }
 
 /// @endcond HIDDEN_SYMBOLS
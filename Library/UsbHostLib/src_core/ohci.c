@@ -834,6 +834,7 @@ static int ohci_rh_port_reset(int port)
         t0 = get_ticks();
         while (get_ticks() - t0 < (reset_time/10)+1)
         {
+            USBH_IDLE();
             /*
              *  If device is disconnected or port enabled, we can stop port reset.
              */
@@ -1020,9 +1021,7 @@ td_out:
     /* If all TDs are done, call-back to requester. */
     if (utr->td_cnt == 0)
     {
-        utr->bIsTransferDone = 1;
-        if (utr->func)
-            utr->func(utr);
+        usbh_utr_done(utr);
     }
 }
 
@@ -1130,9 +1129,7 @@ static void remove_ed()
                     if (utr->td_cnt == 0)
                     {
                         utr->status = USBH_ERR_ABORT;
-                        utr->bIsTransferDone = 1;
-                        if (utr->func)
-                            utr->func(utr);
+                        usbh_utr_done(utr);
                     }
                 }
             }
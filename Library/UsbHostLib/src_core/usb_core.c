@@ -43,6 +43,10 @@ void  usbh_core_init()
 	NVIC_DisableIRQ(HSUSBH_IRQn);
 	NVIC_DisableIRQ(USBH_IRQn);
 
+#if USBH_USE_RTOS
+	usbh_os_init();
+#endif
+
 	_ohci = USBH;
 	_ehci = HSUSBH;
 
@@ -277,7 +281,6 @@ int usbh_ctrl_xfer(UDEV_T *udev, uint8_t bmRequestType, uint8_t bRequest, uint16
 				   uint16_t wLength, uint8_t *buff, uint32_t *xfer_len, uint32_t timeout)
 {
 	UTR_T      *utr;
-	uint32_t   t0;
 	int        status;
 
 	*xfer_len = 0;
@@ -298,7 +301,9 @@ int usbh_ctrl_xfer(UDEV_T *udev, uint8_t bmRequestType, uint8_t bRequest, uint16
 	utr->buff = buff;
 	utr->data_len = wLength;
 	utr->bIsTransferDone = 0;
+	USBH_LOCK();
 	status = udev->hc_driver->ctrl_xfer(utr);
+	USBH_UNLOCK();
 	if (status < 0)
 	{
 		udev->ep0.hw_pipe = NULL;
@@ -306,16 +311,11 @@ int usbh_ctrl_xfer(UDEV_T *udev, uint8_t bmRequestType, uint8_t bRequest, uint16
 		return status;
 	}
 
-	t0 = get_ticks();
-	while (utr->bIsTransferDone == 0)
+	if (usbh_utr_wait(utr, timeout) < 0)
 	{
-		if (get_ticks() - t0 > timeout)
-		{
-			usbh_quit_utr(utr);
-			free_utr(utr);
-			udev->ep0.hw_pipe = NULL;
-			return USBH_ERR_TIMEOUT;
-		}
+		free_utr(utr);
+		udev->ep0.hw_pipe = NULL;
+		return USBH_ERR_TIMEOUT;
 	}
 
 	status = utr->status;
@@ -340,7 +340,12 @@ int usbh_ctrl_xfer(UDEV_T *udev, uint8_t bmRequestType, uint8_t bRequest, uint16
   */
 int usbh_bulk_xfer(UTR_T *utr)
 {
-	return utr->udev->hc_driver->bulk_xfer(utr);
+	int   ret;
+
+	USBH_LOCK();
+	ret = utr->udev->hc_driver->bulk_xfer(utr);
+	USBH_UNLOCK();
+	return ret;
 }
 
 /**
@@ -353,7 +358,12 @@ int usbh_bulk_xfer(UTR_T *utr)
   */
 int usbh_int_xfer(UTR_T *utr)
 {
-	return utr->udev->hc_driver->int_xfer(utr);
+	int   ret;
+
+	USBH_LOCK();
+	ret = utr->udev->hc_driver->int_xfer(utr);
+	USBH_UNLOCK();
+	return ret;
 }
 
 /**
@@ -366,6 +376,8 @@ int usbh_int_xfer(UTR_T *utr)
   */
 int usbh_iso_xfer(UTR_T *utr)
 {
+	int   ret;
+
 	if (utr->udev->hc_driver == NULL)
 	{
 		printf("hc_driver - 0x%x\n", (int)utr->udev->hc_driver);
@@ -376,7 +388,10 @@ int usbh_iso_xfer(UTR_T *utr)
 		printf("iso_xfer - 0x%x\n", (int)utr->udev->hc_driver->iso_xfer);
 		return -1;
 	}
-	return utr->udev->hc_driver->iso_xfer(utr);
+	USBH_LOCK();
+	ret = utr->udev->hc_driver->iso_xfer(utr);
+	USBH_UNLOCK();
+	return ret;
 }
 
 /**
@@ -387,10 +402,15 @@ int usbh_iso_xfer(UTR_T *utr)
   */
 int usbh_quit_utr(UTR_T *utr)
 {
+	int   ret;
+
 	if (!utr || !utr->udev)
 		return USBH_ERR_NOT_FOUND;
 
-	return utr->udev->hc_driver->quit_xfer(utr, NULL);
+	USBH_LOCK();
+	ret = utr->udev->hc_driver->quit_xfer(utr, NULL);
+	USBH_UNLOCK();
+	return ret;
 }
 
 
@@ -403,9 +423,358 @@ int usbh_quit_utr(UTR_T *utr)
   */
 int usbh_quit_xfer(UDEV_T *udev, EP_INFO_T *ep)
 {
-	return udev->hc_driver->quit_xfer(NULL, ep);
+	int   ret;
+
+	USBH_LOCK();
+	ret = udev->hc_driver->quit_xfer(NULL, ep);
+	USBH_UNLOCK();
+	return ret;
+}
+
+
+/**
+  * @brief    Execute a bulk transfer request and wait until it was done or aborted.
+  * @param[in]  utr      The bulk transfer request. utr->func, if any, is called back as usual.
+  * @param[in]  timeout  Time-out limit (in 10ms - timer tick) of this transfer
+  * @retval   0     Transfer success
+  * @retval   < 0   Transfer failed. Refer to error code definitions.
+  */
+int usbh_bulk_xfer_wait(UTR_T *utr, uint32_t timeout)
+{
+	int   ret;
+
+	utr->bIsTransferDone = 0;
+	ret = usbh_bulk_xfer(utr);
+	if (ret < 0)
+		return ret;
+
+	ret = usbh_utr_wait(utr, timeout);
+	if (ret < 0)
+		return ret;
+	return utr->status;
+}
+
+/**
+  * @brief    Execute an interrupt transfer request and wait until it was done or aborted.
+  * @param[in]  utr      The interrupt transfer request. utr->func, if any, is called back as usual.
+  * @param[in]  timeout  Time-out limit (in 10ms - timer tick) of this transfer
+  * @retval   0     Transfer success
+  * @retval   < 0   Transfer failed. Refer to error code definitions.
+  */
+int usbh_int_xfer_wait(UTR_T *utr, uint32_t timeout)
+{
+	int   ret;
+
+	utr->bIsTransferDone = 0;
+	ret = usbh_int_xfer(utr);
+	if (ret < 0)
+		return ret;
+
+	ret = usbh_utr_wait(utr, timeout);
+	if (ret < 0)
+		return ret;
+	return utr->status;
+}
+
+
+/// @cond HIDDEN_SYMBOLS
+
+#if USBH_USE_RTOS
+
+static UTR_T * volatile  _done_head;         /* UTRs finished by the IRQ handlers, in order */
+static UTR_T * volatile  _done_tail;
+static void  * volatile  _usbh_task;         /* the task running usbh_task()                */
+static void  * volatile  _idle_task[USBH_IDLE_WAITERS];
+static volatile int      _hub_poll_req;
+
+static uint32_t  done_lock(void)
+{
+	uint32_t  primask = __get_PRIMASK();
+	__disable_irq();
+	return primask;
 }
 
+static void  done_unlock(uint32_t primask)
+{
+	__set_PRIMASK(primask);
+}
+
+/*
+ *  Called by the host controller drivers, in IRQ context, once a UTR was done or aborted.
+ *  The UTR is queued and called back by the USB host task.
+ */
+void  usbh_utr_done(UTR_T *utr)
+{
+	uint32_t  primask;
+
+	primask = done_lock();
+	utr->done_next = NULL;
+	if (_done_tail)
+		_done_tail->done_next = utr;
+	else
+		_done_head = utr;
+	_done_tail = utr;
+	done_unlock(primask);
+
+	if (_usbh_task == NULL)
+		return;
+	if (__get_IPSR())
+		usbh_os_task_wake_from_isr(_usbh_task);
+	else
+		usbh_os_task_wake(_usbh_task);
+}
+
+/*
+ *  Remove a UTR from the done queue without calling it back.
+ */
+static void  done_purge(UTR_T *utr)
+{
+	UTR_T     *p, *prev = NULL;
+	uint32_t  primask;
+
+	primask = done_lock();
+	for (p = _done_head; p != NULL; prev = p, p = p->done_next)
+	{
+		if (p != utr)
+			continue;
+		if (prev)
+			prev->done_next = p->done_next;
+		else
+			_done_head = p->done_next;
+		if (_done_tail == p)
+			_done_tail = prev;
+		break;
+	}
+	done_unlock(primask);
+}
+
+/*
+ *  Call back all queued UTRs. The lock is held while a UTR is called back, so a task
+ *  which sees the UTR done under the lock knows it is no longer used.
+ *  Return the number of UTRs called back.
+ */
+static int  usbh_process_done(void)
+{
+	UTR_T     *utr;
+	void      *waiter;
+	uint32_t  primask;
+	int       i, cnt = 0;
+
+	while (_done_head != NULL)
+	{
+		usbh_os_lock();
+		primask = done_lock();
+		utr = _done_head;
+		if (utr != NULL)
+		{
+			_done_head = utr->done_next;
+			if (_done_head == NULL)
+				_done_tail = NULL;
+		}
+		done_unlock(primask);
+
+		if (utr != NULL)
+		{
+			waiter = utr->wait_task;
+			utr->bIsTransferDone = 1;
+			if (utr->func)
+				utr->func(utr);
+			if (waiter)
+				usbh_os_task_wake(waiter);
+			cnt++;
+		}
+		usbh_os_unlock();
+	}
+
+	if (cnt)
+	{
+		for (i = 0; i < USBH_IDLE_WAITERS; i++)
+		{
+			if (_idle_task[i])
+				usbh_os_task_wake(_idle_task[i]);
+		}
+	}
+	return cnt;
+}
+
+/*
+ *  Is the caller the USB host task?
+ */
+int  usbh_in_task(void)
+{
+	return (_usbh_task != NULL) && (usbh_os_task_self() == _usbh_task);
+}
+
+/*
+ *  Called in loops waiting for the USB stack. The USB host task calls back queued UTRs
+ *  itself; other tasks sleep until something was called back, or for 1 ms.
+ */
+void  usbh_idle(void)
+{
+	void  *self;
+	int   i, slot = -1;
+
+	if (usbh_in_task())
+	{
+		if (usbh_process_done() == 0)
+			usbh_os_task_wait(1);
+		return;
+	}
+
+	self = usbh_os_task_self();
+	usbh_os_lock();
+	for (i = 0; i < USBH_IDLE_WAITERS; i++)
+	{
+		if (_idle_task[i] == NULL)
+		{
+			_idle_task[i] = self;
+			slot = i;
+			break;
+		}
+	}
+	usbh_os_unlock();
+
+	usbh_os_task_wait(1);
+
+	if (slot >= 0)
+		_idle_task[slot] = NULL;
+}
+
+/*
+ *  Wait until the UTR was called back or timeout ticks elapsed. On timeout the transfer is
+ *  quit, and its abort is waited for up to USBH_ABORT_WAIT_MS before the UTR is removed
+ *  from the done queue, so the caller may free it.
+ *  Return 0 if the UTR was called back, or USBH_ERR_TIMEOUT.
+ */
+int  usbh_utr_wait(UTR_T *utr, uint32_t timeout)
+{
+	uint32_t  t0, elapsed;
+	int       in_task, done, ret = 0;
+
+	in_task = usbh_in_task();
+	utr->wait_task = in_task ? NULL : usbh_os_task_self();
+
+	t0 = get_ticks();
+	while (1)
+	{
+		if (in_task)
+			usbh_process_done();
+
+		usbh_os_lock();
+		done = *(volatile uint8_t *)&utr->bIsTransferDone;
+		usbh_os_unlock();
+		if (done)
+			break;
+
+		elapsed = get_ticks() - t0;
+		if (ret == 0)
+		{
+			if (elapsed > timeout)
+			{
+				usbh_quit_utr(utr);
+				ret = USBH_ERR_TIMEOUT;
+				t0 = get_ticks();
+			}
+			else
+			{
+				usbh_os_task_wait(10);      /* woken early when the UTR was called back */
+			}
+		}
+		else
+		{
+			if (elapsed > USBH_ABORT_WAIT_MS / 10)
+				break;
+			usbh_os_task_wait(USBH_ABORT_WAIT_MS);
+		}
+	}
+
+	usbh_os_lock();
+	utr->wait_task = NULL;
+	done_purge(utr);
+	usbh_os_unlock();
+	return ret;
+}
+
+/*
+ *  usbh_pooling_hubs() called by a task other than the USB host task.
+ */
+void  usbh_hub_poll_request(void)
+{
+	_hub_poll_req = 1;
+	if (_usbh_task != NULL)
+		usbh_os_task_wake(_usbh_task);
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief    USB host task. Call back the transfers finished by the USB IRQ handlers, and poll
+  *           hubs for device connect and disconnect every USBH_HUB_POLL_MS or whenever
+  *           usbh_pooling_hubs() is called by another task. Devices are enumerated, and class
+  *           driver connect and disconnect callbacks run, in this task.
+  * @param[in]  arg   Not used.
+  * @return   Never returns.
+  * @details  Available if USBH_USE_RTOS is 1. User application creates a task running this
+  *           function after usbh_core_init() and class driver initialization.
+  */
+void  usbh_task(void *arg)
+{
+	uint32_t  t0;
+
+	(void)arg;
+	_usbh_task = usbh_os_task_self();
+
+	t0 = get_ticks();
+	while (1)
+	{
+		usbh_os_task_wait(USBH_HUB_POLL_MS);
+		usbh_process_done();
+
+		if (_hub_poll_req || (get_ticks() - t0 >= USBH_HUB_POLL_MS / 10))
+		{
+			_hub_poll_req = 0;
+			usbh_pooling_hubs();
+			t0 = get_ticks();
+		}
+	}
+}
+
+#else   /* USBH_USE_RTOS */
+
+/*
+ *  Called by the host controller drivers, in IRQ context, once a UTR was done or aborted.
+ */
+void  usbh_utr_done(UTR_T *utr)
+{
+	utr->bIsTransferDone = 1;
+	if (utr->func)
+		utr->func(utr);
+}
+
+/*
+ *  Wait until the UTR was called back or timeout ticks elapsed. On timeout the transfer is quit.
+ *  Return 0 if the UTR was called back, or USBH_ERR_TIMEOUT.
+ */
+int  usbh_utr_wait(UTR_T *utr, uint32_t timeout)
+{
+	uint32_t  t0;
+
+	t0 = get_ticks();
+	while (*(volatile uint8_t *)&utr->bIsTransferDone == 0)
+	{
+		if (get_ticks() - t0 > timeout)
+		{
+			usbh_quit_utr(utr);
+			return USBH_ERR_TIMEOUT;
+		}
+	}
+	return 0;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+#endif  /* USBH_USE_RTOS */
+
 
 void  dump_device_descriptor(DESC_DEV_T *desc)
 {
@@ -217,7 +217,9 @@ int32_t  usbh_hid_set_report_non_blocking(HID_DEV_T *hdev, int rtp_typ, int rtp_
     utr->func = led_ctrl_irq;
     utr->bIsTransferDone = 0;
 
+    USBH_LOCK();
     status = iface->udev->hc_driver->ctrl_xfer(utr);
+    USBH_UNLOCK();
     if (status < 0)
     {
         iface->udev->ep0.hw_pipe = NULL;
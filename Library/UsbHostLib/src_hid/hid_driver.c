@@ -125,7 +125,7 @@ static void  hid_disconnect(IFACE_T *iface)
 
     for (i = 0; i < iface->aif->ifd->bNumEndpoints; i++)
     {
-        iface->udev->hc_driver->quit_xfer(NULL, &(iface->aif->ep[i]));
+        usbh_quit_xfer(iface->udev, &(iface->aif->ep[i]));
     }
 
     /*
@@ -90,6 +90,49 @@ struct bulk_cs_wrap
 
 #define SCSI_BUFF_LEN             36
 
+/*
+ *  Bulk-only command pipeline. The CBW of a new command may be sent as soon as the
+ *  previous command is waiting for its CSW, so at most MSC_PIPE_DEPTH commands are in
+ *  flight on an interface. The bulk-in pipe is handed over from one command to the next.
+ */
+#define MSC_PIPE_DEPTH            2
+
+#define MSC_XFER_TIMEOUT          500    /* READ_10/WRITE_10 and data stage timeout in ticks  */
+
+#define MSC_CMD_FREE              0      /* slot not in use                               */
+#define MSC_CMD_CBW               1      /* CBW being sent                                */
+#define MSC_CMD_DATA              2      /* data stage in progress                        */
+#define MSC_CMD_CSW               3      /* waiting for CSW                               */
+#define MSC_CMD_DONE              4      /* finished, status valid                        */
+
+struct msc_t;
+struct msc_pipe_t;
+
+typedef struct msc_cmd_t
+{
+    struct bulk_cb_wrap  cbw;            /* CBW of this command                           */
+    struct bulk_cs_wrap  csw;            /* CSW received for this command                 */
+    struct msc_t       *msc;             /* LUN instance issued this command              */
+    struct msc_pipe_t  *pipe;            /* pipeline this slot belongs to                 */
+    UTR_T       *utr_out;                /* transfer request of bulk-out endpoint         */
+    UTR_T       *utr_in;                 /* transfer request of bulk-in endpoint          */
+    uint8_t     *buff;                   /* data stage buffer                             */
+    uint32_t    data_len;                /* data stage length                             */
+    uint8_t     bIsDataIn;               /* 1: data-in; 0: data-out                       */
+    uint8_t     bIsReadAhead;            /* 1: readahead issued by driver, no caller wait */
+    int         timeout_ticks;           /* CBW/CSW stage timeout                         */
+    volatile int       state;            /* MSC_CMD_FREE ~ MSC_CMD_DONE                   */
+    volatile int       status;           /* result, valid on MSC_CMD_DONE                 */
+    volatile uint32_t  t_phase;          /* get_ticks() when current stage started        */
+}  MSC_CMD_T;
+
+typedef struct msc_pipe_t
+{
+    MSC_CMD_T   cmd[MSC_PIPE_DEPTH];     /* command slots                                 */
+    MSC_CMD_T   * volatile in_owner;     /* command currently using the bulk-in pipe      */
+    MSC_CMD_T   * volatile in_wait;      /* command waiting for the bulk-in pipe          */
+}  MSC_PIPE_T;
+
 typedef struct msc_t
 {
     IFACE_T     *iface;
@@ -107,11 +150,24 @@ typedef struct msc_t
     uint32_t    uDiskSize;
     int         drv_no;                  /* Logical drive number associated with this instance */
     FATFS       fatfs_vol;               /* FATFS volumn                                  */
+    MSC_PIPE_T  *pipe;                   /* command pipeline, shared by all luns          */
+    uint8_t     *ra_buff;                /* readahead buffer                              */
+    uint32_t    ra_size;                 /* readahead window in sectors, 0 if disabled    */
+    uint32_t    ra_sec;                  /* first sector held in ra_buff                  */
+    uint32_t    ra_cnt;                  /* number of sectors held in ra_buff, 0: empty   */
+    MSC_CMD_T   *ra_cmd;                 /* readahead command in flight, or NULL          */
+    uint32_t    seq_next;                /* sector following the last read                */
+    UMAS_STAT_T stat;                    /* read/write statistics of this lun             */
     struct msc_t  *next;                 /* point to next MSC device                      */
 }  MSC_T;
 
 
 extern int  run_scsi_command(MSC_T *msc, uint8_t *buff, uint32_t data_len, int bIsDataIn, int timeout_ticks);
+extern int  msc_cmd_submit(MSC_T *msc, uint8_t *buff, uint32_t data_len, int bIsDataIn, int timeout_ticks, MSC_CMD_T **pcmd);
+extern int  msc_cmd_wait(MSC_CMD_T *cmd, int state);
+extern int  msc_cmd_release(MSC_CMD_T *cmd);
+extern void msc_pipe_abort(MSC_T *msc);
+extern void msc_pipe_drain(MSC_T *msc);
 
 
 /// @endcond
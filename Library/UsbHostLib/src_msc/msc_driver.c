@@ -239,6 +239,71 @@ static int  msc_test_unit_ready(MSC_T *msc)
     return ret;
 }
 
+static void  umas_set_rw_cmd(MSC_T *msc, uint8_t op, uint32_t sec_no, int sec_cnt)
+{
+    struct bulk_cb_wrap  *cmd_blk = &msc->cmd_blk;         /* MSC Bulk-only command block   */
+
+    memset(cmd_blk, 0, sizeof(*cmd_blk));
+
+    cmd_blk->Flags   = (op == READ_10) ? 0x80 : 0;
+    cmd_blk->Length  = 10;
+    cmd_blk->CDB[0]  = op;
+    cmd_blk->CDB[1]  = msc->lun << 5;
+    cmd_blk->CDB[2]  = (sec_no >> 24) & 0xFF;
+    cmd_blk->CDB[3]  = (sec_no >> 16) & 0xFF;
+    cmd_blk->CDB[4]  = (sec_no >> 8) & 0xFF;
+    cmd_blk->CDB[5]  = sec_no & 0xFF;
+    cmd_blk->CDB[7]  = (sec_cnt >> 8) & 0xFF;
+    cmd_blk->CDB[8]  = sec_cnt & 0xFF;
+}
+
+/*
+ *  Discard readahead data. A readahead still in flight is waited for, as the device
+ *  is going to send its data anyway.
+ */
+static void  umas_drop_read_ahead(MSC_T *msc)
+{
+    if (msc->ra_cmd != NULL)
+        msc_cmd_release(msc->ra_cmd);
+    msc->ra_cnt = 0;
+}
+
+/*
+ *  Start reading sectors following sec_no into the readahead buffer. Called while the
+ *  CSW of the current read is pending. With UMAS_PIPELINE the CBW of readahead overlaps
+ *  with it, otherwise msc_cmd_submit() sends the CBW once that CSW has arrived.
+ */
+static void  umas_read_ahead(MSC_T *msc, uint32_t sec_no)
+{
+    MSC_CMD_T  *cmd;
+    uint32_t   sec_cnt = msc->ra_size;
+
+    if ((sec_cnt == 0) || (msc->ra_buff == NULL) || (sec_no >= msc->uTotalSectorN))
+        return;
+
+    if (sec_no + sec_cnt > msc->uTotalSectorN)
+        sec_cnt = msc->uTotalSectorN - sec_no;
+
+    umas_set_rw_cmd(msc, READ_10, sec_no, sec_cnt);
+
+    if (msc_cmd_submit(msc, msc->ra_buff, sec_cnt * 512, 1, MSC_XFER_TIMEOUT, &cmd) < 0)
+        return;
+
+    cmd->bIsReadAhead = 1;
+    msc->ra_cmd = cmd;
+    msc->ra_sec = sec_no;
+    msc->ra_cnt = sec_cnt;
+}
+
+static void  umas_add_time(uint32_t *total, uint32_t *max, uint32_t t0)
+{
+    uint32_t   t = get_ticks() - t0;
+
+    *total += t;
+    if (t > *max)
+        *max = t;
+}
+
 /**
   * @brief       Read a number of contiguous sectors from mass storage device.
   *
@@ -253,9 +318,10 @@ static int  msc_test_unit_ready(MSC_T *msc)
   */
 int  usbh_umas_read(int drv_no, uint32_t sec_no, int sec_cnt, uint8_t *buff)
 {
-    MSC_T   *msc;
-    struct bulk_cb_wrap  *cmd_blk;         /* MSC Bulk-only command block   */
-    int   ret;
+    MSC_T      *msc;
+    MSC_CMD_T  *cmd;
+    uint32_t   t0, ra_end, n;
+    int        ret, ra_part = 0;
 
     //msc_debug_msg("usbh_umas_read - %d, %d\n", sec_no, sec_cnt);
 
@@ -263,28 +329,100 @@ int  usbh_umas_read(int drv_no, uint32_t sec_no, int sec_cnt, uint8_t *buff)
     if (msc == NULL)
         return UMAS_ERR_DRIVE_NOT_FOUND;
 
-    cmd_blk = &msc->cmd_blk;
+    t0 = get_ticks();
+    msc->stat.rd_cmd++;
 
-    //msc_debug_msg("read sector 0x%x\n", sector_no);
-    memset(cmd_blk, 0, sizeof(*cmd_blk));
+    if ((msc->ra_cnt > 0) && (sec_no >= msc->ra_sec) && (sec_no < msc->ra_sec + msc->ra_cnt))
+    {
+        /* Use the part of the request inside the window, read only the rest from the device */
+        ra_end = msc->ra_sec + msc->ra_cnt;
+        n = ra_end - sec_no;
+        if (n > (uint32_t)sec_cnt)
+            n = sec_cnt;
+
+        cmd = msc->ra_cmd;
+        ret = 0;
+        if (cmd != NULL)
+            ret = msc_cmd_wait(cmd, MSC_CMD_CSW);
+
+        if ((ret == 0) && (msc->ra_cnt > 0))
+        {
+            memcpy(buff, msc->ra_buff + (sec_no - msc->ra_sec) * 512, n * 512);
 
-    cmd_blk->Flags   = 0x80;
-    cmd_blk->Length  = 10;
-    cmd_blk->CDB[0]  = READ_10;
-    cmd_blk->CDB[1]  = msc->lun << 5;
-    cmd_blk->CDB[2]  = (sec_no >> 24) & 0xFF;
-    cmd_blk->CDB[3]  = (sec_no >> 16) & 0xFF;
-    cmd_blk->CDB[4]  = (sec_no >> 8) & 0xFF;
-    cmd_blk->CDB[5]  = sec_no & 0xFF;
-    cmd_blk->CDB[7]  = (sec_cnt >> 8) & 0xFF;
-    cmd_blk->CDB[8]  = sec_cnt & 0xFF;
+            if ((sec_no + n == ra_end) && (n == (uint32_t)sec_cnt))
+            {
+                /* Window used up. Read the next one while the CSW of this one is pending. */
+                if (cmd != NULL)
+                {
+                    cmd->bIsReadAhead = 0;
+                    msc->ra_cmd = NULL;
+                }
+                msc->ra_cnt = 0;
+                umas_read_ahead(msc, sec_no + sec_cnt);
+                if (cmd != NULL)
+                    ret = msc_cmd_release(cmd);
+            }
+            else if (cmd != NULL)
+            {
+                ret = msc_cmd_release(cmd);
+            }
 
-    ret = run_scsi_command(msc, buff, sec_cnt * 512, 1, 500);
+            if ((ret == 0) && (n == (uint32_t)sec_cnt))
+            {
+                msc->stat.ra_hit++;
+                msc->stat.rd_sector += sec_cnt;
+                msc->seq_next = sec_no + sec_cnt;
+                umas_add_time(&msc->stat.rd_ticks, &msc->stat.rd_ticks_max, t0);
+                return 0;
+            }
+
+            if (ret == 0)
+            {
+                /* The window ends inside the request. The remainder is a sequential read. */
+                msc->stat.ra_hit++;
+                msc->stat.rd_sector += n;
+                msc->ra_cnt = 0;
+                sec_no += n;
+                sec_cnt -= n;
+                buff += n * 512;
+                msc->seq_next = sec_no;
+                ra_part = 1;
+            }
+        }
+        if (!ra_part)
+            umas_drop_read_ahead(msc);      /* readahead failed, read it again       */
+    }
+
+    if ((msc->ra_size > 0) && (sec_no == msc->seq_next) && !ra_part)
+        msc->stat.ra_miss++;
+
+    umas_drop_read_ahead(msc);
+
+    //msc_debug_msg("read sector 0x%x\n", sector_no);
+    umas_set_rw_cmd(msc, READ_10, sec_no, sec_cnt);
+
+    ret = msc_cmd_submit(msc, buff, sec_cnt * 512, 1, MSC_XFER_TIMEOUT, &cmd);
+    if (ret == 0)
+    {
+        if ((msc->ra_size > 0) && (sec_no == msc->seq_next))
+        {
+            /* Sequential read. Issue the readahead once the data stage is over. */
+            if (msc_cmd_wait(cmd, MSC_CMD_CSW) == 0)
+                umas_read_ahead(msc, sec_no + sec_cnt);
+        }
+        ret = msc_cmd_release(cmd);
+    }
     if (ret != 0)
     {
         msc_debug_msg("usbh_umas_read failed! [%d]\n", ret);
+        umas_drop_read_ahead(msc);
+        msc->stat.err++;
         return UMAS_ERR_IO;
     }
+
+    msc->seq_next = sec_no + sec_cnt;
+    msc->stat.rd_sector += sec_cnt;
+    umas_add_time(&msc->stat.rd_ticks, &msc->stat.rd_ticks_max, t0);
     return 0;
 }
 
@@ -302,9 +440,9 @@ int  usbh_umas_read(int drv_no, uint32_t sec_no, int sec_cnt, uint8_t *buff)
   */
 int  usbh_umas_write(int drv_no, uint32_t sec_no, int sec_cnt, uint8_t *buff)
 {
-    MSC_T   *msc;
-    struct bulk_cb_wrap  *cmd_blk;         /* MSC Bulk-only command block   */
-    int   ret;
+    MSC_T      *msc;
+    uint32_t   t0;
+    int        ret;
 
     //msc_debug_msg("usbh_umas_write - %d, %d\n", sec_no, sec_cnt);
 
@@ -312,26 +450,23 @@ int  usbh_umas_write(int drv_no, uint32_t sec_no, int sec_cnt, uint8_t *buff)
     if (msc == NULL)
         return UMAS_ERR_DRIVE_NOT_FOUND;
 
-    cmd_blk = &msc->cmd_blk;
-    memset((uint8_t *)&(msc->cmd_blk), 0, sizeof(msc->cmd_blk));
+    t0 = get_ticks();
+    msc->stat.wr_cmd++;
 
-    cmd_blk->Flags   = 0;
-    cmd_blk->Length  = 10;
-    cmd_blk->CDB[0]  = WRITE_10;
-    cmd_blk->CDB[1]  = msc->lun << 5;
-    cmd_blk->CDB[2]  = (sec_no >> 24) & 0xFF;
-    cmd_blk->CDB[3]  = (sec_no >> 16) & 0xFF;
-    cmd_blk->CDB[4]  = (sec_no >> 8) & 0xFF;
-    cmd_blk->CDB[5]  = sec_no & 0xFF;
-    cmd_blk->CDB[7]  = (sec_cnt >> 8) & 0xFF;
-    cmd_blk->CDB[8]  = sec_cnt & 0xFF;
+    umas_drop_read_ahead(msc);
+
+    umas_set_rw_cmd(msc, WRITE_10, sec_no, sec_cnt);
 
-    ret = run_scsi_command(msc, buff, sec_cnt * 512, 0, 500);
+    ret = run_scsi_command(msc, buff, sec_cnt * 512, 0, MSC_XFER_TIMEOUT);
     if (ret < 0)
     {
         msc_debug_msg("usbh_umas_write failed!\n");
+        msc->stat.err++;
         return UMAS_ERR_IO;
     }
+
+    msc->stat.wr_sector += sec_cnt;
+    umas_add_time(&msc->stat.wr_ticks, &msc->stat.wr_ticks_max, t0);
     return 0;
 }
 
@@ -357,6 +492,7 @@ int  usbh_umas_ioctl(int drv_no, int cmd, void *buff)
     switch (cmd)
     {
     case CTRL_SYNC:
+        msc_pipe_drain(msc);
         return RES_OK;
 
     case GET_SECTOR_COUNT:
@@ -390,6 +526,71 @@ int  usbh_umas_disk_status(int drv_no)
     return 0;
 }
 
+/**
+ *  @brief    Set the readahead window of a USB disk drive.
+ *  @param[in] drv_no    USB disk drive number.
+ *  @param[in] sec_cnt   Number of sectors read ahead on sequential reads. 0 to disable readahead.
+ *  @retval    0          Success
+ *  @retval    - \ref UMAS_ERR_DRIVE_NOT_FOUND   There's no mass storage device mounted to this volume.
+ *  @retval    - \ref UMAS_ERR_IVALID_PARM       sec_cnt is out of range.
+ *  @retval    - \ref USBH_ERR_MEMORY_OUT        Failed to allocate the readahead buffer.
+ *  @note      The readahead buffer, sec_cnt * 512 bytes, is allocated from heap. Without
+ *             \ref UMAS_PIPELINE the readahead CBW waits for the CSW of the read before it.
+ */
+int  usbh_umas_set_readahead(int drv_no, int sec_cnt)
+{
+    MSC_T   *msc;
+
+    msc = find_msc_by_drive(drv_no);
+    if (msc == NULL)
+        return UMAS_ERR_DRIVE_NOT_FOUND;
+
+    if ((sec_cnt < 0) || (sec_cnt > 0xFFFF))
+        return UMAS_ERR_IVALID_PARM;
+
+    umas_drop_read_ahead(msc);
+
+    if (msc->ra_buff != NULL)
+    {
+        usbh_free_mem(msc->ra_buff, msc->ra_size * 512);
+        msc->ra_buff = NULL;
+        msc->ra_size = 0;
+    }
+
+    if (sec_cnt == 0)
+        return 0;
+
+    msc->ra_buff = usbh_alloc_mem(sec_cnt * 512);
+    if (msc->ra_buff == NULL)
+        return USBH_ERR_MEMORY_OUT;
+    msc->ra_size = sec_cnt;
+    return 0;
+}
+
+/**
+ *  @brief    Get read/write statistics of a USB disk drive.
+ *  @param[in]  drv_no   USB disk drive number.
+ *  @param[out] stat     Statistics of the drive.
+ *  @param[in]  clear    1: clear the statistics after read.
+ *  @retval    0          Success
+ *  @retval    - \ref UMAS_ERR_DRIVE_NOT_FOUND   There's no mass storage device mounted to this volume.
+ *  @note      Throughput is rd_sector * 512 / rd_ticks, or wr_sector * 512 / wr_ticks.
+ */
+int  usbh_umas_get_stat(int drv_no, UMAS_STAT_T *stat, int clear)
+{
+    MSC_T   *msc;
+
+    msc = find_msc_by_drive(drv_no);
+    if (msc == NULL)
+        return UMAS_ERR_DRIVE_NOT_FOUND;
+
+    if (stat != NULL)
+        memcpy(stat, &msc->stat, sizeof(*stat));
+    if (clear)
+        memset(&msc->stat, 0, sizeof(msc->stat));
+    return 0;
+}
+
 /**
  *  @brief    Reset a connected USB mass storage device.
  *  @param[in] drv_no    USB disk drive number.
@@ -498,6 +699,8 @@ disk_found:
 
         msc_list_add(try_msc);
 
+        usbh_umas_set_readahead(try_msc->drv_no, UMAS_READAHEAD_SECTORS);
+
         _path[0] =  try_msc->drv_no + '0';
         f_mount(&try_msc->fatfs_vol, _path, 1);
         bHasMedia = 1;
@@ -513,6 +716,11 @@ disk_found:
             break;
         }
         memcpy(try_msc, msc, sizeof(*msc));
+        try_msc->ra_buff = NULL;       /* readahead and statistics are per lun             */
+        try_msc->ra_size = 0;
+        try_msc->ra_cnt = 0;
+        try_msc->ra_cmd = NULL;
+        memset(&try_msc->stat, 0, sizeof(try_msc->stat));
     }
 
     if (bHasMedia)
@@ -529,7 +737,7 @@ static int msc_probe(IFACE_T *iface)
     ALT_IFACE_T   *aif = iface->aif;
     DESC_IF_T     *ifd;
     MSC_T         *msc;
-    int           i;
+    int           i, ret;
 
     ifd = aif->ifd;
 
@@ -574,17 +782,42 @@ static int msc_probe(IFACE_T *iface)
 
     msc->iface = iface;
 
+    msc->pipe = usbh_alloc_mem(sizeof(MSC_PIPE_T));
+    if (msc->pipe == NULL)
+    {
+        usbh_free_mem(msc, sizeof(*msc));
+        return USBH_ERR_MEMORY_OUT;
+    }
+
     msc_debug_msg("USB Mass Storage device found. Iface:%d, Alt Iface:%d, bep_in:0x%x, bep_out:0x%x\n", ifd->bInterfaceNumber, ifd->bAlternateSetting, msc->ep_bulk_in->bEndpointAddress, msc->ep_bulk_out->bEndpointAddress);
 
     get_max_lun(msc);
 
-    return umass_init_device(msc);
+    ret = umass_init_device(msc);
+    if (ret < 0)
+        usbh_free_mem(msc->pipe, sizeof(MSC_PIPE_T));
+    return ret;
 }
 
 static void msc_disconnect(IFACE_T *iface)
 {
-    int    i;
-    MSC_T  *msc_p, *msc;
+    int         i;
+    MSC_T       *msc_p, *msc;
+    MSC_PIPE_T  *pipe = NULL;
+
+    /*
+     *  Finish commands in flight and free their transfer requests.
+     */
+    for (msc = g_msc_list; msc != NULL; msc = msc->next)
+    {
+        if (msc->iface == iface)
+        {
+            pipe = msc->pipe;
+            msc_pipe_abort(msc);
+            msc_pipe_drain(msc);
+            break;
+        }
+    }
 
     /*
      *  Remove any hardware EP/QH from Host Controller hardware list.
@@ -592,7 +825,7 @@ static void msc_disconnect(IFACE_T *iface)
      */
     for (i = 0; i < iface->aif->ifd->bNumEndpoints; i++)
     {
-        iface->udev->hc_driver->quit_xfer(NULL, &(iface->aif->ep[i]));
+        usbh_quit_xfer(iface->udev, &(iface->aif->ep[i]));
     }
 
     /*
@@ -606,10 +839,15 @@ static void msc_disconnect(IFACE_T *iface)
         {
             fatfs_drive_free(msc->drv_no);
             msc_list_remove(msc);
+            if (msc->ra_buff != NULL)
+                usbh_free_mem(msc->ra_buff, msc->ra_size * 512);
             usbh_free_mem(msc, sizeof(*msc));
         }
         msc = msc_p;
     }
+
+    if (pipe != NULL)
+        usbh_free_mem(pipe, sizeof(MSC_PIPE_T));
 }
 
 UDEV_DRV_T  msc_driver =
@@ -28,7 +28,6 @@ static void bulk_xfer_done(UTR_T *utr)
 int msc_bulk_transfer(MSC_T *msc, EP_INFO_T *ep, uint8_t *data_buff, int data_len, int timeout_ticks)
 {
     UTR_T     *utr;
-    uint32_t  t0;
     int       ret;
 
     utr = alloc_utr(msc->iface->udev);
@@ -40,79 +39,420 @@ int msc_bulk_transfer(MSC_T *msc, EP_INFO_T *ep, uint8_t *data_buff, int data_le
     utr->data_len = data_len;
     utr->xfer_len = 0;
     utr->func = bulk_xfer_done;
+
+    ret = usbh_bulk_xfer_wait(utr, timeout_ticks);
+    msc_debug_msg("    <BULK> status: %d, xfer_len: %d\n", ret, utr->xfer_len);
+    free_utr(utr);
+
+    return ret;
+}
+
+
+static uint32_t msc_lock(void)
+{
+    uint32_t  primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static void msc_unlock(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+/*
+ *  Start the bulk-in stage of a command which owns the bulk-in pipe.
+ */
+static int  msc_start_in(MSC_CMD_T *cmd)
+{
+    UTR_T   *utr = cmd->utr_in;
+
+    if (cmd->state == MSC_CMD_DATA)
+    {
+        utr->buff = cmd->buff;
+        utr->data_len = cmd->data_len;
+    }
+    else
+    {
+        utr->buff = (uint8_t *)&cmd->csw;
+        utr->data_len = MSC_CS_WRAP_LEN;
+    }
+    utr->xfer_len = 0;
+    utr->status = 0;
     utr->bIsTransferDone = 0;
+    return usbh_bulk_xfer(utr);
+}
+
+static void msc_release_in(MSC_CMD_T *cmd);
+
+static void msc_cmd_fail(MSC_CMD_T *cmd, int status)
+{
+    MSC_PIPE_T  *pipe = cmd->pipe;
+    uint32_t    primask;
+
+    primask = msc_lock();
+    if (pipe->in_wait == cmd)
+        pipe->in_wait = NULL;
+    cmd->status = status;
+    cmd->state = MSC_CMD_DONE;
+    msc_unlock(primask);
+
+    msc_release_in(cmd);
+}
+
+/*
+ *  Hand the bulk-in pipe to the command waiting for it. Bulk-in stages must go in
+ *  command order, so a command can only wait behind the CSW of its predecessor.
+ */
+static void msc_release_in(MSC_CMD_T *cmd)
+{
+    MSC_PIPE_T  *pipe = cmd->pipe;
+    MSC_CMD_T   *next;
+    uint32_t    primask;
+    int         ret;
+
+    primask = msc_lock();
+    if (pipe->in_owner != cmd)
+    {
+        msc_unlock(primask);
+        return;
+    }
+    next = pipe->in_wait;
+    pipe->in_wait = NULL;
+    pipe->in_owner = next;
+    msc_unlock(primask);
 
-    ret = usbh_bulk_xfer(utr);
+    if (next != NULL)
+    {
+        next->t_phase = get_ticks();
+        ret = msc_start_in(next);
+        if (ret < 0)
+            msc_cmd_fail(next, ret);
+    }
+}
+
+static void msc_request_in(MSC_CMD_T *cmd)
+{
+    MSC_PIPE_T  *pipe = cmd->pipe;
+    uint32_t    primask;
+    int         ret;
+
+    primask = msc_lock();
+    if (pipe->in_owner != NULL)
+    {
+        pipe->in_wait = cmd;         /* started by msc_release_in() of the owner          */
+        msc_unlock(primask);
+        return;
+    }
+    pipe->in_owner = cmd;
+    msc_unlock(primask);
+
+    ret = msc_start_in(cmd);
     if (ret < 0)
-        return ret;
+        msc_cmd_fail(cmd, ret);
+}
+
+/*
+ *  Bulk-out completion, called in interrupt context. Next stage is started from here.
+ */
+static void msc_out_done(UTR_T *utr)
+{
+    MSC_CMD_T  *cmd = (MSC_CMD_T *)utr->context;
+    int        ret;
+
+    if (cmd->state == MSC_CMD_DONE)
+        return;                      /* aborted                                           */
+
+    if (utr->status != 0)
+    {
+        msc_cmd_fail(cmd, utr->status);
+        return;
+    }
 
-    t0 = get_ticks();
-    while (utr->bIsTransferDone == 0)
+    cmd->t_phase = get_ticks();
+
+    if ((cmd->state == MSC_CMD_CBW) && (cmd->data_len > 0))
     {
-        if (get_ticks() - t0 > timeout_ticks)
+        cmd->state = MSC_CMD_DATA;
+        if (cmd->bIsDataIn)
         {
-            usbh_quit_utr(utr);
-            free_utr(utr);
-            return USBH_ERR_TIMEOUT;
+            msc_request_in(cmd);
+            return;
         }
+        utr->buff = cmd->buff;
+        utr->data_len = cmd->data_len;
+        utr->xfer_len = 0;
+        utr->status = 0;
+        utr->bIsTransferDone = 0;
+        ret = usbh_bulk_xfer(utr);
+        if (ret < 0)
+            msc_cmd_fail(cmd, ret);
+        return;
     }
-    ret = utr->status;
-    free_utr(utr);
-    msc_debug_msg("    <BULK> status: %d, xfer_len: %d\n", utr->status, utr->xfer_len);
 
-    return ret;
+    cmd->state = MSC_CMD_CSW;
+    msc_request_in(cmd);
 }
 
-
-static int  do_scsi_command(MSC_T *msc, uint8_t *buff, uint32_t data_len, int bIsDataIn, int timeout_ticks)
+/*
+ *  Bulk-in completion, called in interrupt context.
+ */
+static void msc_in_done(UTR_T *utr)
 {
-    int   ret;
-    struct bulk_cb_wrap  *cmd_blk = &msc->cmd_blk;         /* MSC Bulk-only command block   */
-    struct bulk_cs_wrap  *cmd_status = &msc->cmd_status;;  /* MSC Bulk-only command status  */
+    MSC_CMD_T  *cmd = (MSC_CMD_T *)utr->context;
+    int        ret;
 
-    cmd_blk->Signature = MSC_CB_SIGN;
-    cmd_blk->Tag = __tag++;
-    cmd_blk->DataTransferLength = data_len;
-    cmd_blk->Lun = msc->lun;
+    if (cmd->state == MSC_CMD_DONE)
+        return;                      /* aborted                                           */
 
-    ret = msc_bulk_transfer(msc, msc->ep_bulk_out, (uint8_t *)cmd_blk, 31, timeout_ticks);
-    if (ret < 0)
-        return ret;
+    if (utr->status != 0)
+    {
+        msc_cmd_fail(cmd, utr->status);
+        return;
+    }
 
-    msc_debug_msg("    [XFER] MSC CMD OK.\n");
+    cmd->t_phase = get_ticks();
 
-    if (data_len > 0)
+    if (cmd->state == MSC_CMD_DATA)
     {
-        if (bIsDataIn)
-            ret = msc_bulk_transfer(msc, msc->ep_bulk_in, buff, data_len, 500);
-        else
-            ret = msc_bulk_transfer(msc, msc->ep_bulk_out, buff, data_len, 500);
+        /* keep the bulk-in pipe, CSW of this command must come first */
+        cmd->state = MSC_CMD_CSW;
+        ret = msc_start_in(cmd);
         if (ret < 0)
-            return ret;
-        msc_debug_msg("    [XFER] MSC DATA OK.\n");
+            msc_cmd_fail(cmd, ret);
+        return;
+    }
+
+    if (cmd->csw.Status != 0)
+    {
+        msc_debug_msg("    !! CSW status error.\n");
+        cmd->status = UMAS_ERR_CMD_STATUS;
+    }
+    else
+        cmd->status = 0;
+    cmd->state = MSC_CMD_DONE;
+    msc_release_in(cmd);
+}
+
+/*
+ *  Find a free command slot. A slot still holding a finished or running readahead can be
+ *  reclaimed; a command issued by a caller is always released by that caller itself.
+ */
+static MSC_CMD_T * msc_cmd_alloc(MSC_PIPE_T *pipe)
+{
+    int   i;
+
+    for (i = 0; i < MSC_PIPE_DEPTH; i++)
+    {
+        if (pipe->cmd[i].state == MSC_CMD_FREE)
+            return &pipe->cmd[i];
+    }
+    for (i = 0; i < MSC_PIPE_DEPTH; i++)
+    {
+        if (pipe->cmd[i].bIsReadAhead)
+        {
+            msc_cmd_release(&pipe->cmd[i]);
+            return &pipe->cmd[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ *  @brief  Send the command in msc->cmd_blk without waiting for it to complete.
+ *  @param[in]  msc            MSC lun the command is issued to.
+ *  @param[in]  buff           Data stage buffer.
+ *  @param[in]  data_len       Data stage length. 0 if no data stage.
+ *  @param[in]  bIsDataIn      1: data-in; 0: data-out.
+ *  @param[in]  timeout_ticks  CBW/CSW stage timeout.
+ *  @param[out] pcmd           The command slot. Caller must release it by msc_cmd_release().
+ *  @return  0 or USB Host error code.
+ *
+ *  With UMAS_PIPELINE the CBW is sent once all commands in flight have finished their
+ *  data stage, that is, it overlaps with the CSW of the previous command. Otherwise it
+ *  waits for that CSW, as Bulk-Only Transport requires.
+ */
+int  msc_cmd_submit(MSC_T *msc, uint8_t *buff, uint32_t data_len, int bIsDataIn, int timeout_ticks, MSC_CMD_T **pcmd)
+{
+    MSC_PIPE_T  *pipe = msc->pipe;
+    MSC_CMD_T   *cmd;
+    UDEV_T      *udev = msc->iface->udev;
+    int         i, ret;
+
+    /* bulk-out pipe must be free of CBW and data-out of earlier commands */
+    for (i = 0; i < MSC_PIPE_DEPTH; i++)
+    {
+        if (pipe->cmd[i].state != MSC_CMD_FREE)
+#if UMAS_PIPELINE
+            msc_cmd_wait(&pipe->cmd[i], MSC_CMD_CSW);
+#else
+            msc_cmd_wait(&pipe->cmd[i], MSC_CMD_DONE);
+#endif
     }
 
-    ret = msc_bulk_transfer(msc, msc->ep_bulk_in, (uint8_t *)cmd_status, 13, timeout_ticks);
+    cmd = msc_cmd_alloc(pipe);
+    if (cmd == NULL)
+        return USBH_ERR_MEMORY_OUT;
+
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->utr_out = alloc_utr(udev);
+    cmd->utr_in = alloc_utr(udev);
+    if ((cmd->utr_out == NULL) || (cmd->utr_in == NULL))
+    {
+        if (cmd->utr_out)
+            free_utr(cmd->utr_out);
+        if (cmd->utr_in)
+            free_utr(cmd->utr_in);
+        return USBH_ERR_MEMORY_OUT;
+    }
+
+    memcpy(&cmd->cbw, &msc->cmd_blk, sizeof(cmd->cbw));
+    cmd->cbw.Signature = MSC_CB_SIGN;
+    cmd->cbw.Tag = __tag++;
+    cmd->cbw.DataTransferLength = data_len;
+    cmd->cbw.Lun = msc->lun;
+
+    cmd->msc = msc;
+    cmd->pipe = pipe;
+    cmd->buff = buff;
+    cmd->data_len = data_len;
+    cmd->bIsDataIn = bIsDataIn ? 1 : 0;
+    cmd->timeout_ticks = timeout_ticks;
+
+    cmd->utr_out->ep = msc->ep_bulk_out;
+    cmd->utr_out->context = cmd;
+    cmd->utr_out->func = msc_out_done;
+    cmd->utr_out->buff = (uint8_t *)&cmd->cbw;
+    cmd->utr_out->data_len = MSC_CB_WRAP_LEN;
+    cmd->utr_in->ep = msc->ep_bulk_in;
+    cmd->utr_in->context = cmd;
+    cmd->utr_in->func = msc_in_done;
+
+    cmd->t_phase = get_ticks();
+    cmd->state = MSC_CMD_CBW;
+
+    ret = usbh_bulk_xfer(cmd->utr_out);
     if (ret < 0)
+    {
+        free_utr(cmd->utr_out);
+        free_utr(cmd->utr_in);
+        cmd->state = MSC_CMD_FREE;
         return ret;
+    }
+    *pcmd = cmd;
+    return 0;
+}
+
+/**
+ *  @brief  Wait until a command has reached a stage.
+ *  @param[in]  cmd     The command.
+ *  @param[in]  state   MSC_CMD_CSW to wait for the end of data stage, or MSC_CMD_DONE.
+ *  @return  0, or the command status if the command has finished with error.
+ *
+ *  A stage timeout aborts all commands in flight on the interface.
+ */
+int  msc_cmd_wait(MSC_CMD_T *cmd, int state)
+{
+    int   timeout;
+
+    while (cmd->state < state)
+    {
+        USBH_IDLE();
+        timeout = (cmd->state == MSC_CMD_DATA) ? MSC_XFER_TIMEOUT : cmd->timeout_ticks;
+        if (get_ticks() - cmd->t_phase > timeout)
+        {
+            msc_debug_msg("    [XFER] MSC command timeout, state %d\n", cmd->state);
+            msc_pipe_abort(cmd->msc);
+        }
+    }
+    if (cmd->state == MSC_CMD_DONE)
+        return cmd->status;
+    return 0;
+}
 
-    msc_debug_msg("    [XFER] MSC STATUS OK.\n");
+/**
+ *  @brief  Wait for a command to finish and free its slot.
+ *  @param[in]  cmd     The command.
+ *  @return  0 or the command status.
+ */
+int  msc_cmd_release(MSC_CMD_T *cmd)
+{
+    MSC_T   *msc = cmd->msc;
+    int     ret;
+
+    ret = msc_cmd_wait(cmd, MSC_CMD_DONE);
 
-    if (cmd_status->Status != 0)
+    memcpy(&msc->cmd_status, &cmd->csw, sizeof(msc->cmd_status));
+    free_utr(cmd->utr_out);
+    free_utr(cmd->utr_in);
+
+    if (cmd->bIsReadAhead)
     {
-        msc_debug_msg("    !! CSW status error.\n");
-        return UMAS_ERR_CMD_STATUS;
+        msc->ra_cmd = NULL;
+        if (ret != 0)
+            msc->ra_cnt = 0;         /* readahead data not valid                          */
     }
-    msc_debug_msg("    [CSW] status OK.\n");
+    cmd->state = MSC_CMD_FREE;
 
-    msc_debug_msg("SCSI command 0x%0x done.\n", cmd_blk->CDB[0]);
-    return 0;
+    if (ret == 0)
+        msc_debug_msg("SCSI command 0x%0x done.\n", cmd->cbw.CDB[0]);
+    return ret;
+}
+
+/**
+ *  @brief  Abort all commands in flight on the interface of a MSC lun.
+ *  @param[in]  msc     MSC lun.
+ *
+ *  Commands are finished with USBH_ERR_TIMEOUT. Their slots still have to be released.
+ */
+void msc_pipe_abort(MSC_T *msc)
+{
+    MSC_PIPE_T  *pipe = msc->pipe;
+    uint32_t    primask;
+    int         i;
+
+    primask = msc_lock();
+    for (i = 0; i < MSC_PIPE_DEPTH; i++)
+    {
+        if ((pipe->cmd[i].state != MSC_CMD_FREE) && (pipe->cmd[i].state != MSC_CMD_DONE))
+        {
+            pipe->cmd[i].status = USBH_ERR_TIMEOUT;
+            pipe->cmd[i].state = MSC_CMD_DONE;
+        }
+    }
+    pipe->in_owner = NULL;
+    pipe->in_wait = NULL;
+    msc_unlock(primask);
+
+    usbh_quit_xfer(msc->iface->udev, msc->ep_bulk_out);
+    usbh_quit_xfer(msc->iface->udev, msc->ep_bulk_in);
 }
 
+/**
+ *  @brief  Finish and release all commands in flight on the interface of a MSC lun.
+ *  @param[in]  msc     MSC lun.
+ */
+void msc_pipe_drain(MSC_T *msc)
+{
+    MSC_PIPE_T  *pipe = msc->pipe;
+    int         i;
+
+    for (i = 0; i < MSC_PIPE_DEPTH; i++)
+    {
+        if (pipe->cmd[i].state != MSC_CMD_FREE)
+            msc_cmd_release(&pipe->cmd[i]);
+    }
+}
 
 int  run_scsi_command(MSC_T *msc, uint8_t *buff, uint32_t data_len, int bIsDataIn, int timeout_ticks)
 {
-    return do_scsi_command(msc, buff, data_len, bIsDataIn, timeout_ticks);
+    MSC_CMD_T  *cmd;
+    int        ret;
+
+    ret = msc_cmd_submit(msc, buff, data_len, bIsDataIn, timeout_ticks, &cmd);
+    if (ret < 0)
+        return ret;
+    return msc_cmd_release(cmd);
 }
 
 /*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -502,9 +502,151 @@ int  usbh_uac_find_best_alt(IFACE_T *iface, uint8_t dir, uint8_t attr, int pkt_s
 }
 
 
+/*
+ *  Single-producer single-consumer block queue. The producer writes head and the consumer
+ *  writes tail, so no lock is needed between USB interrupt and application.
+ */
+static void  uac_q_push(UAC_BLK_Q_T *q, int id)
+{
+    q->id[q->head % UAC_RING_MAX_BLK] = id;
+    __DMB();                                /* block id visible before head moves         */
+    q->head++;
+}
+
+static int  uac_q_pop(UAC_BLK_Q_T *q)
+{
+    int   id;
+
+    if (q->tail == q->head)
+        return -1;
+    id = q->id[q->tail % UAC_RING_MAX_BLK];
+    __DMB();                                /* block id read before tail moves            */
+    q->tail++;
+    return id;
+}
+
+static void  uac_ring_latency(UAC_RING_T *ring, uint32_t frames)
+{
+    ring->stat.latency = frames * ring->frame_us;
+    if (ring->stat.latency > ring->stat.latency_max)
+        ring->stat.latency_max = ring->stat.latency;
+}
+
+/*
+ *  Map the frame buffers of a UTR onto a ring block.
+ */
+static void  uac_ring_map(UAC_RING_T *ring, UTR_T *utr, int id)
+{
+    int   i;
+
+    utr->buff = ring->buff + ring->blk_size * id;
+    utr->data_len = ring->blk_size;
+    for (i = 0; i < IF_PER_UTR; i++)
+        utr->iso_buff[i] = utr->buff + ring->pkt_size * i;
+}
+
+static int  uac_ring_blk_of(UAC_RING_T *ring, UTR_T *utr)
+{
+    return (utr->buff - ring->buff) / ring->blk_size;
+}
+
+static int  uac_ring_alloc(AS_IF_T *asif, EP_INFO_T *ep, int blk_num, int hw_blk)
+{
+    UAC_RING_T   *ring;
+    int          i;
+
+    ring = (UAC_RING_T *)usbh_alloc_mem(sizeof(UAC_RING_T));
+    if (ring == NULL)
+        return USBH_ERR_MEMORY_OUT;
+
+    ring->pkt_size = ep->wMaxPacketSize;
+    ring->blk_size = ep->wMaxPacketSize * IF_PER_UTR;
+    ring->blk_num = blk_num;
+    ring->buff = (uint8_t *)usbh_alloc_mem(ring->blk_size * (blk_num + 1));
+    if (ring->buff == NULL)
+    {
+        usbh_free_mem(ring, sizeof(UAC_RING_T));
+        return USBH_ERR_MEMORY_OUT;
+    }
+
+    if (asif->iface->udev->speed == SPEED_HIGH)
+        ring->frame_us = 125 << ((ep->bInterval > 0) ? (ep->bInterval - 1) : 0);
+    else
+        ring->frame_us = 1000;
+
+    ring->cur_blk = -1;
+    for (i = hw_blk; i < blk_num; i++)      /* the first hw_blk blocks are given to UTRs  */
+        uac_q_push(&ring->free_q, i);
+
+    asif->ring = ring;
+    return 0;
+}
+
+static void  uac_ring_free(AS_IF_T *asif)
+{
+    UAC_RING_T   *ring = asif->ring;
+
+    if (ring == NULL)
+        return;
+    asif->ring = NULL;
+    usbh_free_mem(ring->buff, ring->blk_size * (ring->blk_num + 1));
+    usbh_free_mem(ring, sizeof(UAC_RING_T));
+}
+
+/*
+ *  An audio in UTR completed. Queue its block to application and take a free one.
+ *  If application has not returned any block, the received block is reused and dropped.
+ */
+static void  uac_ring_in_irq(UAC_RING_T *ring, UTR_T *utr)
+{
+    int   cur, id;
+
+    cur = uac_ring_blk_of(ring, utr);
+    id = uac_q_pop(&ring->free_q);
+    if (id < 0)
+    {
+        ring->stat.overrun += IF_PER_UTR;
+        id = cur;
+    }
+    else
+    {
+        uac_q_push(&ring->full_q, cur);
+    }
+    uac_ring_map(ring, utr, id);
+}
+
+/*
+ *  An audio out UTR completed. Give its block back to application and send the next one.
+ *  If application has queued nothing, the silent block is sent.
+ */
+static void  uac_ring_out_irq(UAC_RING_T *ring, UTR_T *utr)
+{
+    int   cur, id, i;
+
+    cur = uac_ring_blk_of(ring, utr);
+    if (cur != ring->blk_num)               /* silent block is not returned               */
+        uac_q_push(&ring->free_q, cur);
+
+    id = uac_q_pop(&ring->full_q);
+    if (id < 0)
+    {
+        ring->stat.underrun += IF_PER_UTR;
+        id = ring->blk_num;
+    }
+    else
+    {
+        ring->stat.frames += IF_PER_UTR;
+        uac_ring_latency(ring, (ring->full_q.head - ring->full_q.tail + 1) * IF_PER_UTR);
+    }
+    uac_ring_map(ring, utr, id);
+    for (i = 0; i < IF_PER_UTR; i++)
+        utr->iso_xlen[i] = ring->xlen[id * IF_PER_UTR + i];
+}
+
 static void iso_in_irq(UTR_T *utr)
 {
     UAC_DEV_T   *uac = (UAC_DEV_T *)utr->context;
+    UAC_RING_T  *ring;
     int         i, ret;
 
     /* We don't want to do anything if we are about to be removed! */
@@ -518,11 +660,15 @@ static void iso_in_irq(UTR_T *utr)
 
     utr->bIsoNewSched = 0;
 
+    ring = uac->asif_in.ring;
+
     for (i = 0; i < IF_PER_UTR; i++)
     {
         if (utr->iso_status[i] == 0)
         {
-            if ((uac->func_au_in != NULL) && (utr->iso_xlen[i] > 0))
+            if (ring != NULL)
+                ring->xlen[uac_ring_blk_of(ring, utr) * IF_PER_UTR + i] = utr->iso_xlen[i];
+            else if ((uac->func_au_in != NULL) && (utr->iso_xlen[i] > 0))
                 uac->func_au_in(uac, utr->iso_buff[i], utr->iso_xlen[i]);
         }
         else
@@ -530,28 +676,22 @@ static void iso_in_irq(UTR_T *utr)
             UAC_DBGMSG("Iso %d err - %d\n", i, utr->iso_status[i]);
             if ((utr->iso_status[i] == USBH_ERR_NOT_ACCESS0) || (utr->iso_status[i] == USBH_ERR_NOT_ACCESS1))
                 utr->bIsoNewSched = 1;
+            if (ring != NULL)
+                ring->xlen[uac_ring_blk_of(ring, utr) * IF_PER_UTR + i] = 0;
         }
         utr->iso_xlen[i] = utr->ep->wMaxPacketSize;
     }
 
+    if (ring != NULL)
+        uac_ring_in_irq(ring, utr);
+
     /* schedule the following isochronous transfers */
     ret = usbh_iso_xfer(utr);
     if (ret < 0)
         UAC_DBGMSG("usbh_iso_xfer failed!\n");
 }
 
-/// @endcond HIDDEN_SYMBOLS
-
-
-/**
- *  @brief  Start to receive audio data from UAC device. (Microphone)
- *  @param[in] uac        Audio Class device
- *  @param[in] func       Audio in callback function.
- *  @return   Success or not.
- *  @retval    0          Success
- *  @retval    Otherwise  Failed
- */
-int usbh_uac_start_audio_in(UAC_DEV_T *uac, UAC_CB_FUNC *func)
+static int uac_start_audio_in(UAC_DEV_T *uac, UAC_CB_FUNC *func, int blk_num)
 {
     UDEV_T       *udev = uac->udev;
     AS_IF_T      *asif = &uac->asif_in;
@@ -627,23 +767,40 @@ int usbh_uac_start_audio_in(UAC_DEV_T *uac, UAC_CB_FUNC *func)
         }
     }
 
-    buff = (uint8_t *)usbh_alloc_mem(ep->wMaxPacketSize * IF_PER_UTR * NUM_UTR);
-    if (buff == NULL)
+    if (blk_num > 0)
     {
-        ret = USBH_ERR_MEMORY_OUT;          /* memory allocate failed                     */
-        goto err_out;                       /* abort                                      */
-    }
+        ret = uac_ring_alloc(asif, ep, blk_num, NUM_UTR);
+        if (ret < 0)
+            goto err_out;                   /* abort                                      */
 
-    for (i = 0; i < NUM_UTR; i++)           /* dispatch buffers                           */
+        for (i = 0; i < NUM_UTR; i++)       /* UTR i receives into ring block i           */
+        {
+            utr = asif->utr[i];
+            uac_ring_map(asif->ring, utr, i);
+            for (j = 0; j < IF_PER_UTR; j++)
+                utr->iso_xlen[j] = ep->wMaxPacketSize;
+        }
+    }
+    else
     {
-        /* divide buffer equally                      */
-        utr = asif->utr[i];
-        utr->buff = buff + (ep->wMaxPacketSize * IF_PER_UTR * i);
-        utr->data_len = ep->wMaxPacketSize * IF_PER_UTR;
-        for (j = 0; j < IF_PER_UTR; j++)
+        buff = (uint8_t *)usbh_alloc_mem(ep->wMaxPacketSize * IF_PER_UTR * NUM_UTR);
+        if (buff == NULL)
         {
-            utr->iso_xlen[j] = ep->wMaxPacketSize;
-            utr->iso_buff[j] = utr->buff + (ep->wMaxPacketSize * j);
+            ret = USBH_ERR_MEMORY_OUT;      /* memory allocate failed                     */
+            goto err_out;                   /* abort                                      */
+        }
+
+        for (i = 0; i < NUM_UTR; i++)       /* dispatch buffers                           */
+        {
+            /* divide buffer equally                      */
+            utr = asif->utr[i];
+            utr->buff = buff + (ep->wMaxPacketSize * IF_PER_UTR * i);
+            utr->data_len = ep->wMaxPacketSize * IF_PER_UTR;
+            for (j = 0; j < IF_PER_UTR; j++)
+            {
+                utr->iso_xlen[j] = ep->wMaxPacketSize;
+                utr->iso_buff[j] = utr->buff + (ep->wMaxPacketSize * j);
+            }
         }
     }
 
@@ -680,8 +837,10 @@ err_out:
     }
     asif->flag_streaming = 0;
     /* free USB transfer buffer                   */
-    if ((asif->utr[0] != NULL) &&
-            (asif->utr[0]->buff != NULL))
+    if (asif->ring != NULL)
+        uac_ring_free(asif);
+    else if ((asif->utr[0] != NULL) &&
+             (asif->utr[0]->buff != NULL))
         usbh_free_mem(asif->utr[0]->buff, asif->utr[0]->data_len * NUM_UTR);
 
     for (i = 0; i < NUM_UTR; i++)           /* free all UTRs                              */
@@ -693,6 +852,43 @@ err_out:
     return ret;
 }
 
+/// @endcond HIDDEN_SYMBOLS
+
+
+/**
+ *  @brief  Start to receive audio data from UAC device. (Microphone)
+ *  @param[in] uac        Audio Class device
+ *  @param[in] func       Audio in callback function.
+ *  @return   Success or not.
+ *  @retval    0          Success
+ *  @retval    Otherwise  Failed
+ */
+int usbh_uac_start_audio_in(UAC_DEV_T *uac, UAC_CB_FUNC *func)
+{
+    return uac_start_audio_in(uac, func, 0);
+}
+
+/**
+ *  @brief  Start to receive audio data from UAC device into a PCM ring. (Microphone)
+ *  @param[in] uac        Audio Class device
+ *  @param[in] blk_num    Number of ring blocks, NUM_UTR+1 ~ \ref UAC_RING_MAX_BLK. A block holds
+ *                        IF_PER_UTR frames of wMaxPacketSize bytes.
+ *  @return   Success or not.
+ *  @retval    0          Success
+ *  @retval    Otherwise  Failed
+ *  @note     Frames are received straight into ring blocks, no callback is called. Read them
+ *            with usbh_uac_ring_get_frame()/usbh_uac_ring_put_frame() or usbh_uac_ring_read().
+ *            If the application falls behind, the newest frames are dropped and counted
+ *            as overrun.
+ */
+int usbh_uac_start_audio_in_ring(UAC_DEV_T *uac, int blk_num)
+{
+    if ((blk_num <= NUM_UTR) || (blk_num > UAC_RING_MAX_BLK))
+        return UAC_RET_INVALID;
+
+    return uac_start_audio_in(uac, NULL, blk_num);
+}
+
 /**
  *  @brief  Stop UAC device audio in data stream.
  *  @param[in] uac      Audio Class device
@@ -723,8 +919,10 @@ int usbh_uac_stop_audio_in(UAC_DEV_T *uac)
             usbh_quit_utr(asif->utr[i]);
     }
 
-    if ((asif->utr[0] != NULL) &&
-            (asif->utr[0]->buff != NULL))       /* free audio buffer                          */
+    if (asif->ring != NULL)                 /* free audio buffer                          */
+        uac_ring_free(asif);
+    else if ((asif->utr[0] != NULL) &&
+             (asif->utr[0]->buff != NULL))
         usbh_free_mem(asif->utr[0]->buff, asif->utr[0]->data_len * NUM_UTR);
 
     for (i = 0; i < NUM_UTR; i++)           /* free all UTRs                              */
@@ -751,6 +949,7 @@ int usbh_uac_stop_audio_in(UAC_DEV_T *uac)
 static void iso_out_irq(UTR_T *utr)
 {
     UAC_DEV_T   *uac = (UAC_DEV_T *)utr->context;
+    UAC_RING_T  *ring;
     int         i, ret;
 
     /* We don't want to do anything if we are about to be removed! */
@@ -764,6 +963,8 @@ static void iso_out_irq(UTR_T *utr)
 
     utr->bIsoNewSched = 0;
 
+    ring = uac->asif_out.ring;
+
     for (i = 0; i < IF_PER_UTR; i++)
     {
         if (utr->iso_status[i] != 0)
@@ -772,28 +973,20 @@ static void iso_out_irq(UTR_T *utr)
             if ((utr->iso_status[i] == USBH_ERR_NOT_ACCESS0) || (utr->iso_status[i] == USBH_ERR_NOT_ACCESS1))
                 utr->bIsoNewSched = 1;
         }
-        utr->iso_xlen[i] = uac->func_au_out(uac, utr->iso_buff[i], utr->ep->wMaxPacketSize);
+        if (ring == NULL)
+            utr->iso_xlen[i] = uac->func_au_out(uac, utr->iso_buff[i], utr->ep->wMaxPacketSize);
     }
 
+    if (ring != NULL)
+        uac_ring_out_irq(ring, utr);
+
     /* schedule the following isochronous transfers */
     ret = usbh_iso_xfer(utr);
     if (ret < 0)
         UAC_DBGMSG("usbh_iso_xfer failed!\n");
 }
 
-/// @endcond HIDDEN_SYMBOLS
-
-
-/**
- *  @brief  Start to transmit audio data to UAC device. (Speaker)
- *  @param[in] uac      Audio Class device
- *  @param[in] func     Audio out call-back function. UAC driver call this function to get audio
- *                      out stream data from user application.
- *  @return   Success or not.
- *  @retval    0          Success
- *  @retval    Otherwise  Failed
- */
-int usbh_uac_start_audio_out(UAC_DEV_T *uac, UAC_CB_FUNC *func)
+static int uac_start_audio_out(UAC_DEV_T *uac, UAC_CB_FUNC *func, int blk_num, int frame_len)
 {
     UDEV_T       *udev = uac->udev;
     AS_IF_T      *asif = &uac->asif_out;
@@ -805,7 +998,7 @@ int usbh_uac_start_audio_out(UAC_DEV_T *uac, UAC_CB_FUNC *func)
     uint8_t      bAlternateSetting;
     int          i, j, ret;
 
-    if (!uac || !func || !iface)
+    if (!uac || (!func && !blk_num) || !iface)
         return UAC_RET_DEV_NOT_FOUND;
 
     if (asif->flag_streaming)
@@ -869,18 +1062,40 @@ int usbh_uac_start_audio_out(UAC_DEV_T *uac, UAC_CB_FUNC *func)
         }
     }
 
-    buff = (uint8_t *)usbh_alloc_mem(ep->wMaxPacketSize * IF_PER_UTR * NUM_UTR);
-    if (buff == NULL)
+    if (blk_num > 0)
     {
-        ret = USBH_ERR_MEMORY_OUT;          /* memory allocate failed                     */
-        goto err_out;                       /* abort                                      */
-    }
+        if (frame_len > ep->wMaxPacketSize)
+        {
+            ret = UAC_RET_DATA_LEN;
+            goto err_out;                   /* abort                                      */
+        }
+
+        ret = uac_ring_alloc(asif, ep, blk_num, 0);
+        if (ret < 0)
+            goto err_out;                   /* abort                                      */
 
-    for (i = 0; i < NUM_UTR; i++)           /* dispatch buffers                           */
+        asif->ring->frame_len = frame_len;
+        for (i = 0; i < IF_PER_UTR; i++)    /* silent block                               */
+            asif->ring->xlen[blk_num * IF_PER_UTR + i] = frame_len;
+
+        for (i = 0; i < NUM_UTR; i++)       /* send silence until application has data    */
+            uac_ring_map(asif->ring, asif->utr[i], blk_num);
+    }
+    else
     {
-        /* divide buffer equally                      */
-        asif->utr[i]->buff = buff + (ep->wMaxPacketSize * IF_PER_UTR * i);
-        asif->utr[i]->data_len = ep->wMaxPacketSize * IF_PER_UTR;
+        buff = (uint8_t *)usbh_alloc_mem(ep->wMaxPacketSize * IF_PER_UTR * NUM_UTR);
+        if (buff == NULL)
+        {
+            ret = USBH_ERR_MEMORY_OUT;      /* memory allocate failed                     */
+            goto err_out;                   /* abort                                      */
+        }
+
+        for (i = 0; i < NUM_UTR; i++)       /* dispatch buffers                           */
+        {
+            /* divide buffer equally                      */
+            asif->utr[i]->buff = buff + (ep->wMaxPacketSize * IF_PER_UTR * i);
+            asif->utr[i]->data_len = ep->wMaxPacketSize * IF_PER_UTR;
+        }
     }
 
     /*------------------------------------------------------------------------------------*/
@@ -899,7 +1114,10 @@ int usbh_uac_start_audio_out(UAC_DEV_T *uac, UAC_CB_FUNC *func)
         for (j = 0; j < IF_PER_UTR; j++)    /* get audio out data from user               */
         {
             utr->iso_buff[j] = utr->buff + (ep->wMaxPacketSize * j);
-            utr->iso_xlen[j] = uac->func_au_out(uac, utr->iso_buff[j], ep->wMaxPacketSize);
+            if (asif->ring != NULL)
+                utr->iso_xlen[j] = frame_len;
+            else
+                utr->iso_xlen[j] = uac->func_au_out(uac, utr->iso_buff[j], ep->wMaxPacketSize);
         }
 
         ret = usbh_iso_xfer(utr);
@@ -923,8 +1141,10 @@ err_out:
     }
     asif->flag_streaming = 0;
 
-    if ((asif->utr[0] != NULL) &&           /* free USB transfer buffer                   */
-            (asif->utr[0]->buff != NULL))
+    if (asif->ring != NULL)                 /* free USB transfer buffer                   */
+        uac_ring_free(asif);
+    else if ((asif->utr[0] != NULL) &&
+             (asif->utr[0]->buff != NULL))
         usbh_free_mem(asif->utr[0]->buff, asif->utr[0]->data_len * NUM_UTR);
 
     for (i = 0; i < NUM_UTR; i++)           /* free all UTRs                              */
@@ -936,6 +1156,46 @@ err_out:
     return ret;
 }
 
+/// @endcond HIDDEN_SYMBOLS
+
+
+/**
+ *  @brief  Start to transmit audio data to UAC device. (Speaker)
+ *  @param[in] uac      Audio Class device
+ *  @param[in] func     Audio out call-back function. UAC driver call this function to get audio
+ *                      out stream data from user application.
+ *  @return   Success or not.
+ *  @retval    0          Success
+ *  @retval    Otherwise  Failed
+ */
+int usbh_uac_start_audio_out(UAC_DEV_T *uac, UAC_CB_FUNC *func)
+{
+    return uac_start_audio_out(uac, func, 0, 0);
+}
+
+/**
+ *  @brief  Start to transmit audio data from a PCM ring to UAC device. (Speaker)
+ *  @param[in] uac        Audio Class device
+ *  @param[in] blk_num    Number of ring blocks, NUM_UTR+1 ~ \ref UAC_RING_MAX_BLK. A block holds
+ *                        IF_PER_UTR frames.
+ *  @param[in] frame_len  Audio data bytes sent in each frame, for example 192 for 48 KHz 16-bit
+ *                        stereo on a full speed device. Must not exceed wMaxPacketSize.
+ *  @return   Success or not.
+ *  @retval    0          Success
+ *  @retval    Otherwise  Failed
+ *  @note     Frames are sent straight from ring blocks, no callback is called. Fill them with
+ *            usbh_uac_ring_get_frame()/usbh_uac_ring_put_frame() or usbh_uac_ring_write().
+ *            A block is sent once all of its IF_PER_UTR frames are filled. If the ring runs
+ *            empty, silent frames are sent and counted as underrun.
+ */
+int usbh_uac_start_audio_out_ring(UAC_DEV_T *uac, int blk_num, int frame_len)
+{
+    if ((blk_num <= NUM_UTR) || (blk_num > UAC_RING_MAX_BLK) || (frame_len <= 0))
+        return UAC_RET_INVALID;
+
+    return uac_start_audio_out(uac, NULL, blk_num, frame_len);
+}
+
 /**
  *  @brief  Stop UAC device audio out data stream.
  *  @param[in] uac      Audio Class device
@@ -964,8 +1224,10 @@ int usbh_uac_stop_audio_out(UAC_DEV_T *uac)
             usbh_quit_utr(asif->utr[i]);
     }
 
-    if ((asif->utr[0] != NULL) &&
-            (asif->utr[0]->buff != NULL))       /* free audio buffer                          */
+    if (asif->ring != NULL)                 /* free audio buffer                          */
+        uac_ring_free(asif);
+    else if ((asif->utr[0] != NULL) &&
+             (asif->utr[0]->buff != NULL))
         usbh_free_mem(asif->utr[0]->buff, asif->utr[0]->data_len * NUM_UTR);
 
     for (i = 0; i < NUM_UTR; i++)           /* free all UTRs                              */
@@ -987,6 +1249,216 @@ int usbh_uac_stop_audio_out(UAC_DEV_T *uac)
     return UAC_RET_OK;
 }
 
+/// @cond HIDDEN_SYMBOLS
+
+static UAC_RING_T * uac_get_ring(UAC_DEV_T *uac, uint8_t target)
+{
+    if (uac == NULL)
+        return NULL;
+    if (target == UAC_SPEAKER)
+        return uac->asif_out.ring;
+    return uac->asif_in.ring;
+}
+
+/*
+ *  Application side moves to the next frame. A finished block is queued to q.
+ */
+static void  uac_ring_next_frame(UAC_RING_T *ring, UAC_BLK_Q_T *q)
+{
+    ring->cur_off = 0;
+    if (++ring->cur_frame >= IF_PER_UTR)
+    {
+        uac_q_push(q, ring->cur_blk);
+        ring->cur_blk = -1;
+    }
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+
+/**
+ *  @brief  Get the current frame of a PCM ring without copying.
+ *  @param[in]  uac       Audio Class device
+ *  @param[in]  target    - \ref UAC_MICROPHONE : get the next received audio data.
+ *                        - \ref UAC_SPEAKER : get the next free space to fill audio data.
+ *  @param[out] frame     Start address of audio data or free space in the frame.
+ *  @return   Bytes of audio data or free space in the frame, or error code.
+ *  @retval   0           No audio data received, or no free space to fill.
+ *  @retval   < 0         The stream was not started by usbh_uac_start_audio_in_ring() or
+ *                        usbh_uac_start_audio_out_ring().
+ *  @note     Call usbh_uac_ring_put_frame() to tell how many bytes have been used.
+ */
+int usbh_uac_ring_get_frame(UAC_DEV_T *uac, uint8_t target, uint8_t **frame)
+{
+    UAC_RING_T   *ring;
+    int          id, len;
+
+    ring = uac_get_ring(uac, target);
+    if (ring == NULL)
+        return UAC_RET_INVALID;
+
+    while (1)
+    {
+        if (ring->cur_blk < 0)
+        {
+            if (target == UAC_SPEAKER)
+            {
+                id = uac_q_pop(&ring->free_q);
+            }
+            else
+            {
+                id = uac_q_pop(&ring->full_q);
+                if (id >= 0)
+                {
+                    ring->stat.frames += IF_PER_UTR;
+                    uac_ring_latency(ring, (ring->full_q.head - ring->full_q.tail + 1) * IF_PER_UTR);
+                }
+            }
+            if (id < 0)
+                return 0;
+            ring->cur_blk = id;
+            ring->cur_frame = 0;
+            ring->cur_off = 0;
+        }
+
+        if (target == UAC_SPEAKER)
+            len = ring->frame_len;
+        else
+            len = ring->xlen[ring->cur_blk * IF_PER_UTR + ring->cur_frame];
+
+        if (len > ring->cur_off)
+        {
+            *frame = ring->buff + ring->blk_size * ring->cur_blk +
+                     ring->pkt_size * ring->cur_frame + ring->cur_off;
+            return len - ring->cur_off;
+        }
+        uac_ring_next_frame(ring, &ring->free_q);   /* empty audio in frame, skip it      */
+    }
+}
+
+/**
+ *  @brief  Release bytes obtained by usbh_uac_ring_get_frame().
+ *  @param[in]  uac       Audio Class device
+ *  @param[in]  target    - \ref UAC_MICROPHONE : len bytes of audio data have been consumed.
+ *                        - \ref UAC_SPEAKER : len bytes of audio data have been filled.
+ *  @param[in]  len       Number of bytes. Must not exceed the length returned by
+ *                        usbh_uac_ring_get_frame().
+ *  @return   Success or not.
+ *  @retval    0          Success
+ *  @retval    Otherwise  Failed
+ */
+int usbh_uac_ring_put_frame(UAC_DEV_T *uac, uint8_t target, int len)
+{
+    UAC_RING_T   *ring;
+    int          flen;
+
+    ring = uac_get_ring(uac, target);
+    if ((ring == NULL) || (ring->cur_blk < 0) || (len < 0))
+        return UAC_RET_INVALID;
+
+    if (target == UAC_SPEAKER)
+        flen = ring->frame_len;
+    else
+        flen = ring->xlen[ring->cur_blk * IF_PER_UTR + ring->cur_frame];
+
+    if (ring->cur_off + len > flen)
+        return UAC_RET_DATA_LEN;
+
+    ring->cur_off += len;
+    if (ring->cur_off == flen)
+    {
+        if (target == UAC_SPEAKER)
+        {
+            ring->xlen[ring->cur_blk * IF_PER_UTR + ring->cur_frame] = flen;
+            uac_ring_next_frame(ring, &ring->full_q);
+        }
+        else
+        {
+            uac_ring_next_frame(ring, &ring->free_q);
+        }
+    }
+    return UAC_RET_OK;
+}
+
+/**
+ *  @brief  Read received audio data from the PCM ring of audio in stream.
+ *  @param[in]  uac       Audio Class device
+ *  @param[out] buff      Buffer to receive audio data.
+ *  @param[in]  len       Size of buff.
+ *  @return   Bytes read, or error code.
+ */
+int usbh_uac_ring_read(UAC_DEV_T *uac, uint8_t *buff, int len)
+{
+    uint8_t   *frame;
+    int       cnt = 0, n;
+
+    while (cnt < len)
+    {
+        n = usbh_uac_ring_get_frame(uac, UAC_MICROPHONE, &frame);
+        if (n <= 0)
+            return (cnt > 0) ? cnt : n;
+        if (n > len - cnt)
+            n = len - cnt;
+        memcpy(buff + cnt, frame, n);
+        usbh_uac_ring_put_frame(uac, UAC_MICROPHONE, n);
+        cnt += n;
+    }
+    return cnt;
+}
+
+/**
+ *  @brief  Write audio data to the PCM ring of audio out stream.
+ *  @param[in]  uac       Audio Class device
+ *  @param[in]  buff      Audio data.
+ *  @param[in]  len       Length of audio data.
+ *  @return   Bytes written, or error code. Less than len if the ring is full.
+ */
+int usbh_uac_ring_write(UAC_DEV_T *uac, uint8_t *buff, int len)
+{
+    uint8_t   *frame;
+    int       cnt = 0, n;
+
+    while (cnt < len)
+    {
+        n = usbh_uac_ring_get_frame(uac, UAC_SPEAKER, &frame);
+        if (n <= 0)
+            return (cnt > 0) ? cnt : n;
+        if (n > len - cnt)
+            n = len - cnt;
+        memcpy(frame, buff + cnt, n);
+        usbh_uac_ring_put_frame(uac, UAC_SPEAKER, n);
+        cnt += n;
+    }
+    return cnt;
+}
+
+/**
+ *  @brief  Get statistics of a PCM ring.
+ *  @param[in]  uac       Audio Class device
+ *  @param[in]  target    \ref UAC_MICROPHONE or \ref UAC_SPEAKER
+ *  @param[out] stat      Statistics of the ring.
+ *  @param[in]  clear     1: clear counters after read.
+ *  @return   Success or not.
+ *  @retval    0          Success
+ *  @retval    Otherwise  Failed
+ *  @note     latency is the audio buffered in ring when a block was last taken out of it,
+ *            by application for audio in, or by USB for audio out.
+ */
+int usbh_uac_ring_get_stat(UAC_DEV_T *uac, uint8_t target, UAC_RING_STAT_T *stat, int clear)
+{
+    UAC_RING_T   *ring;
+
+    ring = uac_get_ring(uac, target);
+    if (ring == NULL)
+        return UAC_RET_INVALID;
+
+    if (stat != NULL)
+        memcpy(stat, &ring->stat, sizeof(*stat));
+    if (clear)
+        memset(&ring->stat, 0, sizeof(ring->stat));
+    return UAC_RET_OK;
+}
+
 /**
  *  @brief   Open an connected UAC device.
  *  @param[in] uac        Audio Class device
@@ -0,0 +1,493 @@
+/**************************************************************************//**
+ * @file     dsp_pipe.c
+ * @version  V1.00
+ * @brief    Block-processing DSP pipeline for EADC sample streams
+ *
+ * A pipeline is a chain of stages run over every block handed to
+ * DSPP_ProcessAdc(). Stage 0 turns 12-bit EADC codes into Q15; the stages
+ * added after it filter, decimate and analyse the block in two ping-pong
+ * work buffers, so no stage allocates memory. A channel block delivered by
+ * the EADC acquisition engine can be passed in as it is.
+ *
+ * Every stage has two kernels: the CMSIS-DSP Q15/Q31 functions, which use
+ * the Cortex-M4 packed-SIMD instructions, and the portable C reference in
+ * dsp_ref.c. Both keep the CMSIS state layout, so the kernel can be switched
+ * between blocks without a glitch. Filter and level results are bit-exact
+ * between the two; the FFT agrees to a few LSB.
+ *
+ * With DSPP_PROFILE the DWT cycle counter is read around every stage, so
+ * the application can report cycles per sample of each stage.
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+
+#include "dsp_pipe.h"
+
+#if DSPP_PROFILE
+#define DSPP_CYCLES()       (DWT->CYCCNT)
+#else
+#define DSPP_CYCLES()       0UL
+#endif
+
+/* Add a stage of type u32Type, returning it or NULL if the pipeline is full */
+static DSPP_STAGE_T *DSPP_NewStage(DSPP_T *psPipe, uint32_t u32Type)
+{
+    DSPP_STAGE_T *psStage;
+
+    if (psPipe->u32StageNum > DSPP_STAGE_MAX)
+        return NULL;
+
+    psStage = &psPipe->asStage[psPipe->u32StageNum];
+    memset(psStage, 0, sizeof(DSPP_STAGE_T));
+    psStage->u32Type = u32Type;
+
+    return psStage;
+}
+
+/* Hand a result to the application; the time spent in the callback is not charged to the stage */
+static void DSPP_Result(DSPP_T *psPipe, uint32_t u32Stage, uint32_t *pu32Start)
+{
+    uint32_t u32Start;
+
+    psPipe->asStage[u32Stage].u32Results++;
+    if (psPipe->pfnCallback)
+    {
+        u32Start = DSPP_CYCLES();
+        psPipe->pfnCallback(psPipe, u32Stage);
+        *pu32Start += DSPP_CYCLES() - u32Start;
+    }
+}
+
+/* Sum of squares, maximum and minimum in one pass, two samples per load */
+static void DSPP_LevelSimd(const q15_t *pSrc, uint32_t u32Len, q63_t *pq63Power, q15_t *pq15Max, q15_t *pq15Min)
+{
+    const q31_t *pIn = (const q31_t *)pSrc;
+    q63_t sum = 0;
+    q31_t in, lo, hi;
+    q15_t mx = -32768, mn = 32767;
+    uint32_t i;
+
+    for (i = u32Len >> 1; i > 0; i--)
+    {
+        in = *pIn++;
+        sum = __SMLALD(in, in, sum);
+        lo = (q15_t)in;
+        hi = in >> 16;
+        if (lo > mx) mx = (q15_t)lo;
+        if (lo < mn) mn = (q15_t)lo;
+        if (hi > mx) mx = (q15_t)hi;
+        if (hi < mn) mn = (q15_t)hi;
+    }
+
+    *pq63Power = sum;
+    *pq15Max = mx;
+    *pq15Min = mn;
+}
+
+/**
+  * @brief      Initialize an empty pipeline
+  * @param[out] psPipe          Pipeline
+  * @param[in]  u32Kernel       DSPP_KERNEL_SIMD or DSPP_KERNEL_REF
+  * @param[in]  pfnCallback     Result callback, may be NULL
+  * @return     None
+  * @details    With DSPP_PROFILE the DWT cycle counter is started as well.
+  */
+void DSPP_Init(DSPP_T *psPipe, uint32_t u32Kernel, DSPP_CB_T pfnCallback)
+{
+    memset(psPipe, 0, sizeof(DSPP_T));
+    psPipe->u32Kernel = u32Kernel;
+    psPipe->pfnCallback = pfnCallback;
+    /* Every stage sees a multiple of 4 samples, so the CMSIS kernels only run their unrolled loops */
+    psPipe->u32LenDiv = 4;
+    psPipe->asStage[0].u32Type = DSPP_STAGE_INPUT;
+    psPipe->u32StageNum = 1;
+
+#if DSPP_PROFILE
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+  * @brief      Add a FIR decimator
+  * @param[in]  psPipe          Pipeline
+  * @param[in]  u32Taps         Number of taps, a multiple of 4. Pad with zero taps if needed.
+  * @param[in]  u32M            Decimation factor, 1 keeps every sample
+  * @param[in]  pq15Coeffs      u32Taps coefficients in time-reversed order, as CMSIS arm_fir_decimate_q15
+  * @param[in]  pq15State       u32Taps + DSPP_BLK_MAX - 1 samples of state
+  * @return     Stage index, or DSPP_ERR_PARAM / DSPP_ERR_FULL
+  * @details    Input block lengths must then be multiples of 4 * u32M times the factors of earlier decimators.
+  */
+int32_t DSPP_AddFirDecim(DSPP_T *psPipe, uint32_t u32Taps, uint32_t u32M, const q15_t *pq15Coeffs, q15_t *pq15State)
+{
+    DSPP_STAGE_T *psStage;
+
+    if ((u32Taps == 0) || (u32Taps & 3) || (u32M == 0) || (u32M > DSPP_BLK_MAX / 4) ||
+            (pq15Coeffs == NULL) || (pq15State == NULL))
+        return DSPP_ERR_PARAM;
+    if ((psStage = DSPP_NewStage(psPipe, DSPP_STAGE_FIR_DECIM)) == NULL)
+        return DSPP_ERR_FULL;
+
+    if (arm_fir_decimate_init_q15(&psStage->u.sFir, (uint16_t)u32Taps, (uint8_t)u32M, (q15_t *)pq15Coeffs,
+                                  pq15State, u32M) != ARM_MATH_SUCCESS)
+        return DSPP_ERR_PARAM;
+    memset(pq15State, 0, (u32Taps + DSPP_BLK_MAX - 1) * sizeof(q15_t));
+
+    psPipe->u32LenDiv *= u32M;
+    return (int32_t)psPipe->u32StageNum++;
+}
+
+/**
+  * @brief      Add a Q15 biquad cascade (direct form I)
+  * @param[in]  psPipe          Pipeline
+  * @param[in]  u32Sections     Number of second order sections
+  * @param[in]  pq15Coeffs      {b0, 0, b1, b2, a1, a2} for each section, as CMSIS arm_biquad_cascade_df1_q15
+  * @param[in]  pq15State       4 * u32Sections samples of state
+  * @param[in]  i32PostShift    Coefficient scaling shift, 0 ~ 14
+  * @return     Stage index, or DSPP_ERR_PARAM / DSPP_ERR_FULL
+  */
+int32_t DSPP_AddBiquadQ15(DSPP_T *psPipe, uint32_t u32Sections, const q15_t *pq15Coeffs, q15_t *pq15State, int32_t i32PostShift)
+{
+    DSPP_STAGE_T *psStage;
+
+    if ((u32Sections == 0) || (u32Sections > 255) || (i32PostShift < 0) || (i32PostShift > 14) ||
+            (pq15Coeffs == NULL) || (pq15State == NULL))
+        return DSPP_ERR_PARAM;
+    if ((psStage = DSPP_NewStage(psPipe, DSPP_STAGE_BIQUAD_Q15)) == NULL)
+        return DSPP_ERR_FULL;
+
+    arm_biquad_cascade_df1_init_q15(&psStage->u.sBiq15, (uint8_t)u32Sections, (q15_t *)pq15Coeffs,
+                                    pq15State, (int8_t)i32PostShift);
+
+    return (int32_t)psPipe->u32StageNum++;
+}
+
+/**
+  * @brief      Add a Q31 biquad cascade with 64-bit state, for low cut-off frequencies
+  * @param[in]  psPipe          Pipeline
+  * @param[in]  u32Sections     Number of second order sections
+  * @param[in]  pq31Coeffs      {b0, b1, b2, a1, a2} for each section, as CMSIS arm_biquad_cas_df1_32x64_q31
+  * @param[in]  pq63State       4 * u32Sections words of state
+  * @param[in]  u32PostShift    Coefficient scaling shift, 0 ~ 30
+  * @return     Stage index, or DSPP_ERR_PARAM / DSPP_ERR_FULL
+  * @details    The block is widened to Q31 for the filter and narrowed back to Q15 after it.
+  */
+int32_t DSPP_AddBiquadQ31(DSPP_T *psPipe, uint32_t u32Sections, const q31_t *pq31Coeffs, q63_t *pq63State, uint32_t u32PostShift)
+{
+    DSPP_STAGE_T *psStage;
+
+    if ((u32Sections == 0) || (u32Sections > 255) || (u32PostShift > 30) ||
+            (pq31Coeffs == NULL) || (pq63State == NULL))
+        return DSPP_ERR_PARAM;
+    if ((psStage = DSPP_NewStage(psPipe, DSPP_STAGE_BIQUAD_Q31)) == NULL)
+        return DSPP_ERR_FULL;
+
+    arm_biquad_cas_df1_32x64_init_q31(&psStage->u.sBiq31, (uint8_t)u32Sections, (q31_t *)pq31Coeffs,
+                                      pq63State, (uint8_t)u32PostShift);
+
+    return (int32_t)psPipe->u32StageNum++;
+}
+
+/**
+  * @brief      Add a level meter: RMS, peak, maximum and minimum of every block
+  * @param[in]  psPipe          Pipeline
+  * @return     Stage index, or DSPP_ERR_FULL
+  * @details    The result is in asStage[index].u.sLevel when the callback is called. The block passes unchanged.
+  */
+int32_t DSPP_AddLevel(DSPP_T *psPipe)
+{
+    if (DSPP_NewStage(psPipe, DSPP_STAGE_LEVEL) == NULL)
+        return DSPP_ERR_FULL;
+
+    return (int32_t)psPipe->u32StageNum++;
+}
+
+/**
+  * @brief      Add a windowed real FFT
+  * @param[in]  psPipe          Pipeline
+  * @param[in]  u32Len          FFT length, 32 ~ 2048, a power of 2
+  * @param[in]  pq15Win         Window of u32Len samples, NULL for a rectangular window
+  * @param[in]  pq15Frame       u32Len samples to collect the input
+  * @param[in]  pq15Out         2 * u32Len samples for the complex spectrum
+  * @param[in]  pq15Mag         u32Len / 2 bin magnitudes, 2.14 format of the spectrum scaled by 1 / u32Len
+  * @return     Stage index, or DSPP_ERR_PARAM / DSPP_ERR_FULL
+  * @details    Samples are collected over blocks; the callback is called each time u32Len of them
+  *             have been transformed. Frames do not overlap. The block passes unchanged.
+  */
+int32_t DSPP_AddRfft(DSPP_T *psPipe, uint32_t u32Len, const q15_t *pq15Win, q15_t *pq15Frame, q15_t *pq15Out, q15_t *pq15Mag)
+{
+    DSPP_STAGE_T *psStage;
+
+    if ((u32Len < 32) || (u32Len > 2048) || (u32Len & (u32Len - 1)) ||
+            (pq15Frame == NULL) || (pq15Out == NULL) || (pq15Mag == NULL))
+        return DSPP_ERR_PARAM;
+    if ((psStage = DSPP_NewStage(psPipe, DSPP_STAGE_RFFT)) == NULL)
+        return DSPP_ERR_FULL;
+
+    if (arm_rfft_init_q15(&psStage->u.sFft.sInst, u32Len, 0, 1) != ARM_MATH_SUCCESS)
+        return DSPP_ERR_PARAM;
+    psStage->u.sFft.pq15Win = pq15Win;
+    psStage->u.sFft.pq15Frame = pq15Frame;
+    psStage->u.sFft.pq15Out = pq15Out;
+    psStage->u.sFft.pq15Mag = pq15Mag;
+    psStage->u.sFft.u32Len = u32Len;
+
+    return (int32_t)psPipe->u32StageNum++;
+}
+
+/**
+  * @brief      Select the kernels used from the next block on
+  * @param[in]  psPipe          Pipeline
+  * @param[in]  u32Kernel       DSPP_KERNEL_SIMD or DSPP_KERNEL_REF
+  * @return     None
+  * @details    Both kernels share the filter state, so the stream continues without a glitch.
+  */
+void DSPP_SetKernel(DSPP_T *psPipe, uint32_t u32Kernel)
+{
+    psPipe->u32Kernel = u32Kernel;
+}
+
+/**
+  * @brief      Clear the filter states, the partial FFT frame and the results
+  * @param[in]  psPipe          Pipeline
+  * @return     None
+  */
+void DSPP_Reset(DSPP_T *psPipe)
+{
+    DSPP_STAGE_T *psStage;
+    uint32_t i;
+
+    for (i = 1; i < psPipe->u32StageNum; i++)
+    {
+        psStage = &psPipe->asStage[i];
+        switch (psStage->u32Type)
+        {
+        case DSPP_STAGE_FIR_DECIM:
+            memset(psStage->u.sFir.pState, 0, (psStage->u.sFir.numTaps + DSPP_BLK_MAX - 1) * sizeof(q15_t));
+            break;
+        case DSPP_STAGE_BIQUAD_Q15:
+            memset(psStage->u.sBiq15.pState, 0, 4 * psStage->u.sBiq15.numStages * sizeof(q15_t));
+            break;
+        case DSPP_STAGE_BIQUAD_Q31:
+            memset(psStage->u.sBiq31.pState, 0, 4 * psStage->u.sBiq31.numStages * sizeof(q63_t));
+            break;
+        case DSPP_STAGE_LEVEL:
+            memset(&psStage->u.sLevel, 0, sizeof(DSPP_LEVEL_T));
+            break;
+        case DSPP_STAGE_RFFT:
+            psStage->u.sFft.u32Fill = 0;
+            break;
+        default:
+            break;
+        }
+        psStage->u32Results = 0;
+    }
+    psPipe->pq15Out = NULL;
+    psPipe->u32OutLen = 0;
+}
+
+/**
+  * @brief      Clear the cycle and sample counts of all stages
+  * @param[in]  psPipe          Pipeline
+  * @return     None
+  */
+void DSPP_ClearProfile(DSPP_T *psPipe)
+{
+    uint32_t i;
+
+    for (i = 0; i < psPipe->u32StageNum; i++)
+    {
+        psPipe->asStage[i].u32Cycles = 0;
+        psPipe->asStage[i].u32Samples = 0;
+    }
+}
+
+/* Run stages 1 ~ N over the Q15 block in aq15Buf[0] */
+static int32_t DSPP_Run(DSPP_T *psPipe, uint32_t u32Len)
+{
+    DSPP_STAGE_T *psStage;
+    q15_t *pCur = psPipe->aq15Buf[0];
+    q15_t *pAlt = psPipe->aq15Buf[1];
+    q15_t *pTmp;
+    q63_t q63Power;
+    uint32_t u32Simd = (psPipe->u32Kernel == DSPP_KERNEL_SIMD);
+    uint32_t u32Start, u32In, u32Off, u32Part, i;
+
+    for (i = 1; i < psPipe->u32StageNum; i++)
+    {
+        psStage = &psPipe->asStage[i];
+        u32In = u32Len;
+        u32Start = DSPP_CYCLES();
+
+        switch (psStage->u32Type)
+        {
+        case DSPP_STAGE_FIR_DECIM:
+            if (u32Simd)
+                arm_fir_decimate_q15(&psStage->u.sFir, pCur, pAlt, u32Len);
+            else
+                REF_FirDecimQ15(&psStage->u.sFir, pCur, pAlt, u32Len);
+            u32Len /= psStage->u.sFir.M;
+            pTmp = pCur;
+            pCur = pAlt;
+            pAlt = pTmp;
+            break;
+
+        case DSPP_STAGE_BIQUAD_Q15:
+            if (u32Simd)
+                arm_biquad_cascade_df1_q15(&psStage->u.sBiq15, pCur, pCur, u32Len);
+            else
+                REF_BiquadQ15(&psStage->u.sBiq15, pCur, pCur, u32Len);
+            break;
+
+        case DSPP_STAGE_BIQUAD_Q31:
+            if (u32Simd)
+            {
+                arm_q15_to_q31(pCur, psPipe->aq31Buf, u32Len);
+                arm_biquad_cas_df1_32x64_q31(&psStage->u.sBiq31, psPipe->aq31Buf, psPipe->aq31Buf, u32Len);
+                arm_q31_to_q15(psPipe->aq31Buf, pCur, u32Len);
+            }
+            else
+            {
+                for (u32Off = 0; u32Off < u32Len; u32Off++)
+                    psPipe->aq31Buf[u32Off] = (q31_t)pCur[u32Off] << 16;
+                REF_BiquadQ31(&psStage->u.sBiq31, psPipe->aq31Buf, psPipe->aq31Buf, u32Len);
+                for (u32Off = 0; u32Off < u32Len; u32Off++)
+                    pCur[u32Off] = (q15_t)(psPipe->aq31Buf[u32Off] >> 16);
+            }
+            break;
+
+        case DSPP_STAGE_LEVEL:
+            if (u32Simd)
+                DSPP_LevelSimd(pCur, u32Len, &q63Power, &psStage->u.sLevel.q15Max, &psStage->u.sLevel.q15Min);
+            else
+                REF_LevelQ15(pCur, u32Len, &q63Power, &psStage->u.sLevel.q15Max, &psStage->u.sLevel.q15Min);
+            /* Mean square is Q30, its root Q15 */
+            u32Off = REF_Isqrt64((uint64_t)q63Power / u32Len);
+            psStage->u.sLevel.q15Rms = (q15_t)((u32Off > 0x7FFF) ? 0x7FFF : u32Off);
+            psStage->u.sLevel.q15Peak = (psStage->u.sLevel.q15Min == -32768) ? 0x7FFF :
+                                        ((psStage->u.sLevel.q15Max > -psStage->u.sLevel.q15Min) ?
+                                         psStage->u.sLevel.q15Max : -psStage->u.sLevel.q15Min);
+            DSPP_Result(psPipe, i, &u32Start);
+            break;
+
+        case DSPP_STAGE_RFFT:
+            for (u32Off = 0; u32Off < u32Len; u32Off += u32Part)
+            {
+                u32Part = psStage->u.sFft.u32Len - psStage->u.sFft.u32Fill;
+                if (u32Part > u32Len - u32Off)
+                    u32Part = u32Len - u32Off;
+                memcpy(&psStage->u.sFft.pq15Frame[psStage->u.sFft.u32Fill], &pCur[u32Off], u32Part * sizeof(q15_t));
+                psStage->u.sFft.u32Fill += u32Part;
+                if (psStage->u.sFft.u32Fill < psStage->u.sFft.u32Len)
+                    break;
+
+                psStage->u.sFft.u32Fill = 0;
+                if (u32Simd)
+                {
+                    if (psStage->u.sFft.pq15Win)
+                        arm_mult_q15(psStage->u.sFft.pq15Frame, (q15_t *)psStage->u.sFft.pq15Win,
+                                     psStage->u.sFft.pq15Frame, psStage->u.sFft.u32Len);
+                    arm_rfft_q15(&psStage->u.sFft.sInst, psStage->u.sFft.pq15Frame, psStage->u.sFft.pq15Out);
+                    arm_cmplx_mag_q15(psStage->u.sFft.pq15Out, psStage->u.sFft.pq15Mag, psStage->u.sFft.u32Len / 2);
+                }
+                else
+                {
+                    REF_RfftMagQ15(psStage->u.sFft.pq15Frame, psStage->u.sFft.pq15Win, psStage->u.sFft.pq15Out,
+                                   psStage->u.sFft.pq15Mag, psStage->u.sFft.u32Len);
+                }
+                DSPP_Result(psPipe, i, &u32Start);
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        psStage->u32Cycles += DSPP_CYCLES() - u32Start;
+        psStage->u32Samples += u32In;
+    }
+
+    psPipe->pq15Out = pCur;
+    psPipe->u32OutLen = u32Len;
+
+    return DSPP_OK;
+}
+
+/**
+  * @brief      Run the pipeline over one block of EADC conversion results
+  * @param[in]  psPipe          Pipeline
+  * @param[in]  pu16Adc         12-bit conversion results, e.g. one channel block of the acquisition engine
+  * @param[in]  u32Len          Number of results, up to DSPP_BLK_MAX and a multiple of psPipe->u32LenDiv
+  * @retval     DSPP_OK         Block processed; the output of the last stage is at psPipe->pq15Out
+  * @retval     DSPP_ERR_LEN    Invalid block length
+  * @details    Codes are centred on 0x800 and scaled to full Q15 range.
+  */
+int32_t DSPP_ProcessAdc(DSPP_T *psPipe, const uint16_t *pu16Adc, uint32_t u32Len)
+{
+    const uint32_t *pu32In;
+    uint32_t *pu32Out;
+    q15_t *pDst = psPipe->aq15Buf[0];
+    uint32_t u32Start, i;
+
+    if ((u32Len == 0) || (u32Len > DSPP_BLK_MAX) || (u32Len % psPipe->u32LenDiv))
+        return DSPP_ERR_LEN;
+
+    u32Start = DSPP_CYCLES();
+
+    if ((psPipe->u32Kernel == DSPP_KERNEL_SIMD) && (((uint32_t)pu16Adc & 3) == 0))
+    {
+        /*
+         * Two codes per word: flipping bit 11 gives 12-bit two's complement and the shift
+         * moves it to the top of each halfword. The mask clears the upper 4 bits of each
+         * code, so nothing crosses from the low halfword into the high one.
+         */
+        pu32In = (const uint32_t *)pu16Adc;
+        pu32Out = (uint32_t *)pDst;
+        for (i = u32Len >> 2; i > 0; i--)
+        {
+            pu32Out[0] = ((pu32In[0] & 0x0FFF0FFFUL) ^ 0x08000800UL) << 4;
+            pu32Out[1] = ((pu32In[1] & 0x0FFF0FFFUL) ^ 0x08000800UL) << 4;
+            pu32In += 2;
+            pu32Out += 2;
+        }
+    }
+    else
+    {
+        for (i = 0; i < u32Len; i++)
+            pDst[i] = (q15_t)(((pu16Adc[i] & 0xFFF) ^ 0x800) << 4);
+    }
+
+    psPipe->asStage[0].u32Cycles += DSPP_CYCLES() - u32Start;
+    psPipe->asStage[0].u32Samples += u32Len;
+
+    return DSPP_Run(psPipe, u32Len);
+}
+
+/**
+  * @brief      Run the pipeline over one block of Q15 samples
+  * @param[in]  psPipe          Pipeline
+  * @param[in]  pq15In          Samples
+  * @param[in]  u32Len          Number of samples, up to DSPP_BLK_MAX and a multiple of psPipe->u32LenDiv
+  * @retval     DSPP_OK         Block processed; the output of the last stage is at psPipe->pq15Out
+  * @retval     DSPP_ERR_LEN    Invalid block length
+  */
+int32_t DSPP_ProcessQ15(DSPP_T *psPipe, const q15_t *pq15In, uint32_t u32Len)
+{
+    uint32_t u32Start;
+
+    if ((u32Len == 0) || (u32Len > DSPP_BLK_MAX) || (u32Len % psPipe->u32LenDiv))
+        return DSPP_ERR_LEN;
+
+    u32Start = DSPP_CYCLES();
+    memcpy(psPipe->aq15Buf[0], pq15In, u32Len * sizeof(q15_t));
+    psPipe->asStage[0].u32Cycles += DSPP_CYCLES() - u32Start;
+    psPipe->asStage[0].u32Samples += u32Len;
+
+    return DSPP_Run(psPipe, u32Len);
+}
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
@@ -0,0 +1,142 @@
+/**************************************************************************//**
+ * @file     dsp_pipe.h
+ * @version  V1.00
+ * @brief    Block-processing DSP pipeline for EADC sample streams header file
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef __DSP_PIPE_H__
+#define __DSP_PIPE_H__
+
+#include "arm_math.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Configuration                                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+#define DSPP_STAGE_MAX          8           /*!< Maximum number of stages in one pipeline                 */
+#define DSPP_BLK_MAX            256         /*!< Maximum samples per block entering the pipeline          */
+#ifndef DSPP_PROFILE
+#define DSPP_PROFILE            1           /*!< 1: count cycles of every stage with DWT_CYCCNT           */
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Kernels                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+#define DSPP_KERNEL_SIMD        0           /*!< CMSIS-DSP Q15/Q31 kernels and packed-SIMD code           */
+#define DSPP_KERNEL_REF         1           /*!< Portable C reference kernels                             */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Stage types                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#define DSPP_STAGE_INPUT        0           /*!< 12-bit EADC code to Q15 conversion, always first         */
+#define DSPP_STAGE_FIR_DECIM    1           /*!< Q15 FIR filter and decimator                             */
+#define DSPP_STAGE_BIQUAD_Q15   2           /*!< Q15 biquad cascade                                       */
+#define DSPP_STAGE_BIQUAD_Q31   3           /*!< Q31 biquad cascade with 64-bit state                     */
+#define DSPP_STAGE_LEVEL        4           /*!< RMS, peak, maximum and minimum of each block             */
+#define DSPP_STAGE_RFFT         5           /*!< Windowed Q15 real FFT magnitude                          */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Error codes                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#define DSPP_OK                 0           /*!< No error                                                 */
+#define DSPP_ERR_PARAM          -1          /*!< Invalid parameter                                        */
+#define DSPP_ERR_FULL           -2          /*!< DSPP_STAGE_MAX stages already added                      */
+#define DSPP_ERR_LEN            -3          /*!< Block length does not fit the stages                     */
+
+/**
+  * @brief  Level of the last block seen by a DSPP_STAGE_LEVEL stage
+  */
+typedef struct
+{
+    q15_t q15Rms;               /*!< Root mean square                                         */
+    q15_t q15Peak;              /*!< Largest magnitude, saturated to 0x7FFF                   */
+    q15_t q15Max;               /*!< Largest sample                                           */
+    q15_t q15Min;               /*!< Smallest sample                                          */
+} DSPP_LEVEL_T;
+
+/**
+  * @brief  One stage. Filled by the DSPP_Add functions; the result fields may be read by the application.
+  */
+typedef struct
+{
+    uint32_t u32Type;           /*!< DSPP_STAGE_xxx                                           */
+    union
+    {
+        arm_fir_decimate_instance_q15 sFir;         /*!< DSPP_STAGE_FIR_DECIM                     */
+        arm_biquad_casd_df1_inst_q15 sBiq15;        /*!< DSPP_STAGE_BIQUAD_Q15                    */
+        arm_biquad_cas_df1_32x64_ins_q31 sBiq31;    /*!< DSPP_STAGE_BIQUAD_Q31                    */
+        DSPP_LEVEL_T sLevel;                        /*!< DSPP_STAGE_LEVEL result                  */
+        struct
+        {
+            arm_rfft_instance_q15 sInst;
+            const q15_t *pq15Win;   /*!< Window of u32Len samples, NULL for none              */
+            q15_t *pq15Frame;       /*!< u32Len samples being collected                       */
+            q15_t *pq15Out;         /*!< 2 * u32Len, complex spectrum scaled by 1 / u32Len    */
+            q15_t *pq15Mag;         /*!< u32Len / 2 bin magnitudes in 2.14 format, the result */
+            uint32_t u32Len;        /*!< FFT length                                           */
+            uint32_t u32Fill;       /*!< Samples collected in pq15Frame                       */
+        } sFft;                                     /*!< DSPP_STAGE_RFFT                          */
+    } u;
+    uint32_t u32Results;        /*!< Results produced by a level or FFT stage                 */
+    uint32_t u32Cycles;         /*!< Cycles spent in the stage since DSPP_ClearProfile        */
+    uint32_t u32Samples;        /*!< Samples entering the stage since DSPP_ClearProfile       */
+} DSPP_STAGE_T;
+
+struct dspp;
+
+/**
+  * @brief  Result callback, called when a level stage finishes a block or an FFT stage a spectrum.
+  * @param  psPipe      Pipeline
+  * @param  u32Stage    Index of the stage in psPipe->asStage
+  */
+typedef void (*DSPP_CB_T)(struct dspp *psPipe, uint32_t u32Stage);
+
+/**
+  * @brief  Pipeline. Stage 0 is the input conversion.
+  */
+typedef struct dspp
+{
+    uint32_t u32Kernel;                     /*!< DSPP_KERNEL_SIMD or DSPP_KERNEL_REF                 */
+    uint32_t u32StageNum;                   /*!< Stages in asStage, including the input stage        */
+    uint32_t u32LenDiv;                     /*!< Input block lengths must be multiples of this       */
+    DSPP_CB_T pfnCallback;                  /*!< Result callback, may be NULL                        */
+    DSPP_STAGE_T asStage[DSPP_STAGE_MAX + 1];
+    q15_t *pq15Out;                         /*!< Output of the last stage for the last block         */
+    uint32_t u32OutLen;                     /*!< Samples at pq15Out                                  */
+    q15_t aq15Buf[2][DSPP_BLK_MAX];         /*!< Ping-pong work buffers                              */
+    q31_t aq31Buf[DSPP_BLK_MAX];            /*!< Q31 work buffer of the Q31 biquad                   */
+} DSPP_T;
+
+void DSPP_Init(DSPP_T *psPipe, uint32_t u32Kernel, DSPP_CB_T pfnCallback);
+int32_t DSPP_AddFirDecim(DSPP_T *psPipe, uint32_t u32Taps, uint32_t u32M, const q15_t *pq15Coeffs, q15_t *pq15State);
+int32_t DSPP_AddBiquadQ15(DSPP_T *psPipe, uint32_t u32Sections, const q15_t *pq15Coeffs, q15_t *pq15State, int32_t i32PostShift);
+int32_t DSPP_AddBiquadQ31(DSPP_T *psPipe, uint32_t u32Sections, const q31_t *pq31Coeffs, q63_t *pq63State, uint32_t u32PostShift);
+int32_t DSPP_AddLevel(DSPP_T *psPipe);
+int32_t DSPP_AddRfft(DSPP_T *psPipe, uint32_t u32Len, const q15_t *pq15Win, q15_t *pq15Frame, q15_t *pq15Out, q15_t *pq15Mag);
+void DSPP_SetKernel(DSPP_T *psPipe, uint32_t u32Kernel);
+void DSPP_Reset(DSPP_T *psPipe);
+void DSPP_ClearProfile(DSPP_T *psPipe);
+int32_t DSPP_ProcessAdc(DSPP_T *psPipe, const uint16_t *pu16Adc, uint32_t u32Len);
+int32_t DSPP_ProcessQ15(DSPP_T *psPipe, const q15_t *pq15In, uint32_t u32Len);
+
+/* Portable C reference kernels, dsp_ref.c */
+void REF_FirDecimQ15(const arm_fir_decimate_instance_q15 *S, const q15_t *pSrc, q15_t *pDst, uint32_t u32Len);
+void REF_BiquadQ15(const arm_biquad_casd_df1_inst_q15 *S, const q15_t *pSrc, q15_t *pDst, uint32_t u32Len);
+void REF_BiquadQ31(const arm_biquad_cas_df1_32x64_ins_q31 *S, const q31_t *pSrc, q31_t *pDst, uint32_t u32Len);
+void REF_LevelQ15(const q15_t *pSrc, uint32_t u32Len, q63_t *pq63Power, q15_t *pq15Max, q15_t *pq15Min);
+void REF_RfftMagQ15(const q15_t *pSrc, const q15_t *pWin, q15_t *pOut, q15_t *pMag, uint32_t u32Len);
+uint32_t REF_Isqrt64(uint64_t u64X);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __DSP_PIPE_H__ */
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
@@ -0,0 +1,277 @@
+/**************************************************************************//**
+ * @file     dsp_ref.c
+ * @version  V1.00
+ * @brief    Portable C reference kernels of the DSP pipeline
+ *
+ * Plain C with no intrinsics, one sample at a time. The filters use the
+ * CMSIS instance structures and state layout and reproduce the CMSIS
+ * arithmetic, so their output is bit-exact with the SIMD kernels. The FFT
+ * is an in-place radix-2 transform on the CMSIS Q15 twiddle table.
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#include <string.h>
+#include "arm_math.h"
+#include "arm_common_tables.h"
+
+#include "dsp_pipe.h"
+
+static q15_t REF_Sat16(q31_t x)
+{
+    return (q15_t)((x > 32767) ? 32767 : ((x < -32768) ? -32768 : x));
+}
+
+/**
+  * @brief      Integer square root
+  * @param[in]  u64X    Value
+  * @return     floor(sqrt(u64X))
+  */
+uint32_t REF_Isqrt64(uint64_t u64X)
+{
+    uint64_t u64Root = 0, u64Bit = (uint64_t)1 << 62;
+
+    while (u64Bit > u64X)
+        u64Bit >>= 2;
+
+    while (u64Bit)
+    {
+        if (u64X >= u64Root + u64Bit)
+        {
+            u64X -= u64Root + u64Bit;
+            u64Root = (u64Root >> 1) + u64Bit;
+        }
+        else
+        {
+            u64Root >>= 1;
+        }
+        u64Bit >>= 2;
+    }
+
+    return (uint32_t)u64Root;
+}
+
+/**
+  * @brief      FIR filter and decimator, same result as arm_fir_decimate_q15
+  * @param[in]  S           CMSIS instance
+  * @param[in]  pSrc        u32Len input samples
+  * @param[out] pDst        u32Len / S->M output samples
+  * @param[in]  u32Len      Input length, a multiple of S->M
+  * @return     None
+  */
+void REF_FirDecimQ15(const arm_fir_decimate_instance_q15 *S, const q15_t *pSrc, q15_t *pDst, uint32_t u32Len)
+{
+    q15_t *pState = S->pState;
+    uint32_t u32Taps = S->numTaps;
+    uint32_t i, n;
+    q63_t acc;
+
+    /* The state holds numTaps - 1 older samples followed by the block */
+    memcpy(&pState[u32Taps - 1], pSrc, u32Len * sizeof(q15_t));
+
+    for (n = 0; n < u32Len / S->M; n++)
+    {
+        acc = 0;
+        for (i = 0; i < u32Taps; i++)
+            acc += (q31_t)pState[n * S->M + i] * S->pCoeffs[i];
+        pDst[n] = REF_Sat16((q31_t)(acc >> 15));
+    }
+
+    memmove(pState, &pState[u32Len], (u32Taps - 1) * sizeof(q15_t));
+}
+
+/**
+  * @brief      Q15 biquad cascade, same result as arm_biquad_cascade_df1_q15
+  * @param[in]  S           CMSIS instance
+  * @param[in]  pSrc        Input samples
+  * @param[out] pDst        Output samples, may be pSrc
+  * @param[in]  u32Len      Number of samples
+  * @return     None
+  */
+void REF_BiquadQ15(const arm_biquad_casd_df1_inst_q15 *S, const q15_t *pSrc, q15_t *pDst, uint32_t u32Len)
+{
+    const q15_t *pIn = pSrc;
+    const q15_t *pCoeffs = S->pCoeffs;
+    q15_t *pState = S->pState;
+    int32_t i32Shift = 15 - S->postShift;
+    uint32_t u32Section, n;
+    q31_t x, x1, x2, y, y1, y2;
+    q63_t acc;
+
+    for (u32Section = 0; u32Section < S->numStages; u32Section++)
+    {
+        x1 = pState[0];
+        x2 = pState[1];
+        y1 = pState[2];
+        y2 = pState[3];
+
+        for (n = 0; n < u32Len; n++)
+        {
+            x = pIn[n];
+            /* {b0, 0, b1, b2, a1, a2}; a1 and a2 are already negated */
+            acc = (q63_t)pCoeffs[0] * x + (q63_t)pCoeffs[2] * x1 + (q63_t)pCoeffs[3] * x2 +
+                  (q63_t)pCoeffs[4] * y1 + (q63_t)pCoeffs[5] * y2;
+            y = REF_Sat16((q31_t)(acc >> i32Shift));
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+            pDst[n] = (q15_t)y;
+        }
+
+        pState[0] = (q15_t)x1;
+        pState[1] = (q15_t)x2;
+        pState[2] = (q15_t)y1;
+        pState[3] = (q15_t)y2;
+        pState += 4;
+        pCoeffs += 6;
+        pIn = pDst;
+    }
+}
+
+/* 64 x 32 bit product scaled down by 2^32, as CMSIS mult32x64 */
+static q63_t REF_Mult32x64(q63_t x, q31_t y)
+{
+    return (((q63_t)(x & 0xFFFFFFFF) * y) >> 32) + ((x >> 32) * y);
+}
+
+/**
+  * @brief      Q31 biquad cascade with 64-bit state, same result as arm_biquad_cas_df1_32x64_q31
+  * @param[in]  S           CMSIS instance
+  * @param[in]  pSrc        Input samples
+  * @param[out] pDst        Output samples, may be pSrc
+  * @param[in]  u32Len      Number of samples
+  * @return     None
+  */
+void REF_BiquadQ31(const arm_biquad_cas_df1_32x64_ins_q31 *S, const q31_t *pSrc, q31_t *pDst, uint32_t u32Len)
+{
+    const q31_t *pIn = pSrc;
+    const q31_t *pCoeffs = S->pCoeffs;
+    q63_t *pState = S->pState;
+    int32_t i32Shift = S->postShift + 1;
+    uint32_t u32Section, n;
+    q31_t x, x1, x2;
+    q63_t acc, y1, y2;
+
+    for (u32Section = 0; u32Section < S->numStages; u32Section++)
+    {
+        x1 = (q31_t)pState[0];
+        x2 = (q31_t)pState[1];
+        y1 = pState[2];
+        y2 = pState[3];
+
+        for (n = 0; n < u32Len; n++)
+        {
+            x = pIn[n];
+            acc = (q63_t)x * pCoeffs[0] + (q63_t)x1 * pCoeffs[1] + (q63_t)x2 * pCoeffs[2] +
+                  REF_Mult32x64(y1, pCoeffs[3]) + REF_Mult32x64(y2, pCoeffs[4]);
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            /* The state keeps the full precision output, the sample its top 32 bits */
+            y1 = (q63_t)((uint64_t)acc << i32Shift);
+            pDst[n] = (q31_t)(acc >> (32 - i32Shift));
+        }
+
+        pState[0] = x1;
+        pState[1] = x2;
+        pState[2] = y1;
+        pState[3] = y2;
+        pState += 4;
+        pCoeffs += 5;
+        pIn = pDst;
+    }
+}
+
+/**
+  * @brief      Sum of squares, maximum and minimum of a block
+  * @param[in]  pSrc        Samples
+  * @param[in]  u32Len      Number of samples
+  * @param[out] pq63Power   Sum of squares, 34.30 format
+  * @param[out] pq15Max     Largest sample
+  * @param[out] pq15Min     Smallest sample
+  * @return     None
+  */
+void REF_LevelQ15(const q15_t *pSrc, uint32_t u32Len, q63_t *pq63Power, q15_t *pq15Max, q15_t *pq15Min)
+{
+    q63_t sum = 0;
+    q15_t mx = -32768, mn = 32767;
+    uint32_t n;
+
+    for (n = 0; n < u32Len; n++)
+    {
+        sum += (q31_t)pSrc[n] * pSrc[n];
+        if (pSrc[n] > mx)
+            mx = pSrc[n];
+        if (pSrc[n] < mn)
+            mn = pSrc[n];
+    }
+
+    *pq63Power = sum;
+    *pq15Max = mx;
+    *pq15Min = mn;
+}
+
+/**
+  * @brief      Windowed real FFT and bin magnitudes, in the scaling of arm_rfft_q15 and arm_cmplx_mag_q15
+  * @param[in]  pSrc        u32Len samples
+  * @param[in]  pWin        u32Len window samples, NULL for none
+  * @param[out] pOut        2 * u32Len values, interleaved complex spectrum scaled by 1 / u32Len
+  * @param[out] pMag        u32Len / 2 magnitudes in 2.14 format
+  * @param[in]  u32Len      FFT length, 32 ~ 2048, a power of 2
+  * @return     None
+  * @details    Radix-2 decimation in time on u32Len complex points, halving every stage.
+  */
+void REF_RfftMagQ15(const q15_t *pSrc, const q15_t *pWin, q15_t *pOut, q15_t *pMag, uint32_t u32Len)
+{
+    uint32_t u32Step = 4096 / u32Len;
+    uint32_t u32Size, u32Half, i, j, k, a, b, t;
+    q31_t re, im, tr, ti, c, s;
+
+    /* Load the samples in bit-reversed order as complex values */
+    for (i = 0, j = 0; i < u32Len; i++)
+    {
+        pOut[2 * j] = pWin ? REF_Sat16(((q31_t)pSrc[i] * pWin[i]) >> 15) : pSrc[i];
+        pOut[2 * j + 1] = 0;
+        for (t = u32Len >> 1; j & t; t >>= 1)
+            j ^= t;
+        j |= t;
+    }
+
+    for (u32Size = 2; u32Size <= u32Len; u32Size <<= 1)
+    {
+        u32Half = u32Size >> 1;
+        for (i = 0; i < u32Len; i += u32Size)
+        {
+            for (k = 0; k < u32Half; k++)
+            {
+                /* W = cos - j sin of 2 * pi * k / u32Size */
+                t = 2 * k * (u32Len / u32Size) * u32Step;
+                c = twiddleCoef_4096_q15[t];
+                s = twiddleCoef_4096_q15[t + 1];
+                a = 2 * (i + k);
+                b = 2 * (i + k + u32Half);
+                tr = (pOut[b] * c + pOut[b + 1] * s) >> 15;
+                ti = (pOut[b + 1] * c - pOut[b] * s) >> 15;
+                re = pOut[a];
+                im = pOut[a + 1];
+                pOut[a] = REF_Sat16((re + tr) >> 1);
+                pOut[a + 1] = REF_Sat16((im + ti) >> 1);
+                pOut[b] = REF_Sat16((re - tr) >> 1);
+                pOut[b + 1] = REF_Sat16((im - ti) >> 1);
+            }
+        }
+    }
+
+    /* Halving every stage scales by 1 / u32Len, the same as arm_rfft_q15 */
+    for (i = 0; i < u32Len / 2; i++)
+    {
+        re = pOut[2 * i];
+        im = pOut[2 * i + 1];
+        /* Power truncated to Q15 before the root, as arm_cmplx_mag_q15 does */
+        t = (uint32_t)(((q63_t)re * re + (q63_t)im * im) >> 17);
+        pMag[i] = REF_Sat16((q31_t)REF_Isqrt64((uint64_t)t << 15));
+    }
+}
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
@@ -0,0 +1,289 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Benchmark a DSP block pipeline (FIR decimation, biquads, RMS/peak, real FFT)
+ *           over EADC-format sample blocks with CMSIS-DSP SIMD and portable C kernels.
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "NuMicro.h"
+#include "arm_math.h"
+#include "dsp_pipe.h"
+
+#define SAMPLE_RATE     20000       /* Input sample rate, Hz */
+#define BLK_LEN         256         /* EADC samples per block */
+#define BENCH_BLOCKS    64          /* Blocks run through each pipeline */
+#define DECIM           4           /* FIR decimation factor */
+#define FIR_TAPS        32          /* FIR length, a multiple of 4 */
+#define HPF_HZ          10          /* Q31 biquad high-pass corner, removes DC and drift */
+#define LPF_HZ          1000        /* Q15 biquad low-pass corner */
+#define LPF_SECTIONS    2           /* 4th order Butterworth */
+#define FFT_LEN         256         /* FFT length at the decimated rate */
+#define FFT_TOLERANCE   4           /* Largest bin power difference allowed between the kernels, Q15 LSB */
+
+/* Everything one pipeline needs besides DSPP_T */
+typedef struct
+{
+    DSPP_T sPipe;
+    q15_t aq15FirState[FIR_TAPS + DSPP_BLK_MAX - 1];
+    q63_t aq63HpfState[4];
+    q15_t aq15LpfState[4 * LPF_SECTIONS];
+    q15_t aq15Frame[FFT_LEN];
+    q15_t aq15Spec[2 * FFT_LEN];
+    q15_t aq15Mag[FFT_LEN / 2];
+    int32_t i32LevelStage, i32FftStage;
+    DSPP_LEVEL_T sLevel;
+    uint32_t u32FftReady;
+} BENCH_PIPE_T;
+
+static BENCH_PIPE_T s_asBench[2];
+static q15_t s_aq15Fir[FIR_TAPS];
+static q31_t s_aq31Hpf[5];
+static q15_t s_aq15Lpf[6 * LPF_SECTIONS];
+static q15_t s_aq15Win[FFT_LEN];
+static uint16_t s_au16Adc[BLK_LEN];
+
+static const char *s_apcStageName[] =
+{
+    "EADC to Q15", "FIR decimate", "Biquad Q15", "Biquad Q31", "RMS/peak", "Real FFT"
+};
+
+void SYS_Init(void)
+{
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Set XT1_OUT(PF.2) and XT1_IN(PF.3) to input mode */
+    PF->MODE &= ~(GPIO_MODE_MODE2_Msk | GPIO_MODE_MODE3_Msk);
+
+    /* Enable External XTAL (4~24 MHz) */
+    CLK_EnableXtalRC(CLK_PWRCTL_HXTEN_Msk);
+
+    /* Waiting for 12MHz clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HXTSTB_Msk);
+
+    /* Set core clock as PLL_CLOCK from PLL */
+    CLK_SetCoreClock(FREQ_192MHZ);
+
+    /* Set both PCLK0 and PCLK1 as HCLK/2 */
+    CLK->PCLKDIV = CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2;
+
+    /* Enable IP clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select IP clock source */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HXT, CLK_CLKDIV0_UART0(1));
+
+    /* Update System Core Clock */
+    /* User can use SystemCoreClockUpdate() to calculate SystemCoreClock. */
+    SystemCoreClockUpdate();
+
+    /* Set GPB multi-function pins for UART0 RXD and TXD */
+    SYS->GPB_MFPH &= ~(SYS_GPB_MFPH_PB12MFP_Msk | SYS_GPB_MFPH_PB13MFP_Msk);
+    SYS->GPB_MFPH |= (SYS_GPB_MFPH_PB12MFP_UART0_RXD | SYS_GPB_MFPH_PB13MFP_UART0_TXD);
+
+    /* Lock protected registers */
+    SYS_LockReg();
+}
+
+void UART_Init()
+{
+    UART_Open(UART0, 115200);
+}
+
+/* Hamming-windowed sinc low-pass, stored time reversed for arm_fir_decimate_q15 */
+void DesignFir(q15_t *pq15Coeffs, uint32_t u32Taps, float fCutoff)
+{
+    float fSum = 0, afTap[FIR_TAPS];
+    float fMid = (u32Taps - 1) / 2.0f;
+    uint32_t i;
+
+    for (i = 0; i < u32Taps; i++)
+    {
+        float x = (float)i - fMid;
+        afTap[i] = (x == 0) ? 2 * fCutoff : sinf(2 * PI * fCutoff * x) / (PI * x);
+        afTap[i] *= 0.54f - 0.46f * cosf(2 * PI * i / (u32Taps - 1));
+        fSum += afTap[i];
+    }
+    for (i = 0; i < u32Taps; i++)
+        pq15Coeffs[u32Taps - 1 - i] = (q15_t)(afTap[i] / fSum * 32767);
+}
+
+/* RBJ cookbook biquad, coefficients halved for postShift 1 and a1, a2 negated as CMSIS expects */
+void DesignBiquad(float *pfCoeffs, uint32_t u32HighPass, float fCorner, float fQ)
+{
+    float w0 = 2 * PI * fCorner / (SAMPLE_RATE / DECIM);
+    float fCos = cosf(w0), fAlpha = sinf(w0) / (2 * fQ), a0 = 1 + fAlpha;
+
+    pfCoeffs[0] = (u32HighPass ? (1 + fCos) : (1 - fCos)) / 2 / a0 / 2;
+    pfCoeffs[1] = (u32HighPass ? -(1 + fCos) : (1 - fCos)) / a0 / 2;
+    pfCoeffs[2] = pfCoeffs[0];
+    pfCoeffs[3] = 2 * fCos / a0 / 2;
+    pfCoeffs[4] = -(1 - fAlpha) / a0 / 2;
+}
+
+void DesignFilters(void)
+{
+    static const float afButterworthQ[LPF_SECTIONS] = {0.5412f, 1.3066f};
+    float afCoeffs[5];
+    uint32_t i;
+
+    DesignFir(s_aq15Fir, FIR_TAPS, 0.8f / (2 * DECIM));
+
+    DesignBiquad(afCoeffs, 1, HPF_HZ, 0.7071f);
+    for (i = 0; i < 5; i++)
+        s_aq31Hpf[i] = (q31_t)(afCoeffs[i] * 2147483647.0f);
+
+    for (i = 0; i < LPF_SECTIONS; i++)
+    {
+        DesignBiquad(afCoeffs, 0, LPF_HZ, afButterworthQ[i]);
+        s_aq15Lpf[6 * i + 0] = (q15_t)(afCoeffs[0] * 32767);
+        s_aq15Lpf[6 * i + 1] = 0;
+        s_aq15Lpf[6 * i + 2] = (q15_t)(afCoeffs[1] * 32767);
+        s_aq15Lpf[6 * i + 3] = (q15_t)(afCoeffs[2] * 32767);
+        s_aq15Lpf[6 * i + 4] = (q15_t)(afCoeffs[3] * 32767);
+        s_aq15Lpf[6 * i + 5] = (q15_t)(afCoeffs[4] * 32767);
+    }
+
+    /* Hann window */
+    for (i = 0; i < FFT_LEN; i++)
+        s_aq15Win[i] = (q15_t)(16383.5f * (1 - cosf(2 * PI * i / FFT_LEN)));
+}
+
+/* Keep the results of each kernel for comparison */
+void PipeCallback(DSPP_T *psPipe, uint32_t u32Stage)
+{
+    BENCH_PIPE_T *psBench = (BENCH_PIPE_T *)psPipe;
+
+    if ((int32_t)u32Stage == psBench->i32LevelStage)
+        psBench->sLevel = psPipe->asStage[u32Stage].u.sLevel;
+    else if ((int32_t)u32Stage == psBench->i32FftStage)
+        psBench->u32FftReady = 1;
+}
+
+/* Decimating low-pass, DC removal in Q31, band limit in Q15, then level and spectrum */
+int32_t BuildPipe(BENCH_PIPE_T *psBench, uint32_t u32Kernel)
+{
+    DSPP_T *psPipe = &psBench->sPipe;
+
+    DSPP_Init(psPipe, u32Kernel, PipeCallback);
+    if ((DSPP_AddFirDecim(psPipe, FIR_TAPS, DECIM, s_aq15Fir, psBench->aq15FirState) < 0) ||
+            (DSPP_AddBiquadQ31(psPipe, 1, s_aq31Hpf, psBench->aq63HpfState, 1) < 0) ||
+            (DSPP_AddBiquadQ15(psPipe, LPF_SECTIONS, s_aq15Lpf, psBench->aq15LpfState, 1) < 0))
+        return -1;
+    if ((psBench->i32LevelStage = DSPP_AddLevel(psPipe)) < 0)
+        return -1;
+    if ((psBench->i32FftStage = DSPP_AddRfft(psPipe, FFT_LEN, s_aq15Win, psBench->aq15Frame,
+                                psBench->aq15Spec, psBench->aq15Mag)) < 0)
+        return -1;
+    DSPP_Reset(psPipe);
+
+    return 0;
+}
+
+/* 12-bit codes: 120 Hz and 600 Hz tones, a 7 kHz tone above the band, DC offset and noise */
+void MakeBlock(uint16_t *pu16Adc, uint32_t u32Len, uint32_t u32Start)
+{
+    static uint32_t u32Seed = 1;
+    uint32_t i;
+    float t, v;
+
+    for (i = 0; i < u32Len; i++)
+    {
+        t = (float)(u32Start + i) / SAMPLE_RATE;
+        u32Seed = u32Seed * 1103515245 + 12345;
+        v = 2148 + 700 * sinf(2 * PI * 120 * t) + 300 * sinf(2 * PI * 600 * t) +
+            400 * sinf(2 * PI * 7000 * t) + (float)((u32Seed >> 16) & 31) - 16;
+        pu16Adc[i] = (uint16_t)v;
+    }
+}
+
+int main()
+{
+    DSPP_T *psSimd = &s_asBench[DSPP_KERNEL_SIMD].sPipe;
+    DSPP_T *psRef = &s_asBench[DSPP_KERNEL_REF].sPipe;
+    uint32_t u32Blk, u32Mismatch = 0, u32FftDiff = 0, u32Diff, u32Peak = 0, i;
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    SYS_Init();
+    UART_Init();
+
+    printf("\n\n");
+    printf("+----------------------------------------+\n");
+    printf("|      DSP Block Pipeline Benchmark      |\n");
+    printf("+----------------------------------------+\n");
+    printf("%d blocks of %d samples at %d Hz\n", BENCH_BLOCKS, BLK_LEN, SAMPLE_RATE);
+
+    DesignFilters();
+    if ((BuildPipe(&s_asBench[DSPP_KERNEL_SIMD], DSPP_KERNEL_SIMD) != 0) ||
+            (BuildPipe(&s_asBench[DSPP_KERNEL_REF], DSPP_KERNEL_REF) != 0))
+    {
+        printf("Pipeline setup failed!\n");
+        while (1);
+    }
+
+    for (u32Blk = 0; u32Blk < BENCH_BLOCKS; u32Blk++)
+    {
+        MakeBlock(s_au16Adc, BLK_LEN, u32Blk * BLK_LEN);
+        DSPP_ProcessAdc(psSimd, s_au16Adc, BLK_LEN);
+        DSPP_ProcessAdc(psRef, s_au16Adc, BLK_LEN);
+
+        /* Filters and level must agree exactly, the spectra within FFT_TOLERANCE */
+        if ((psSimd->u32OutLen != psRef->u32OutLen) ||
+                memcmp(psSimd->pq15Out, psRef->pq15Out, psRef->u32OutLen * sizeof(q15_t)) ||
+                memcmp(&s_asBench[0].sLevel, &s_asBench[1].sLevel, sizeof(DSPP_LEVEL_T)))
+            u32Mismatch++;
+
+        if (s_asBench[0].u32FftReady && s_asBench[1].u32FftReady)
+        {
+            for (i = 0; i < FFT_LEN / 2; i++)
+            {
+                /* arm_cmplx_mag_q15 roots a Q15 power, so compare powers rather than magnitudes */
+                u32Diff = abs((q31_t)s_asBench[0].aq15Mag[i] * s_asBench[0].aq15Mag[i] -
+                              (q31_t)s_asBench[1].aq15Mag[i] * s_asBench[1].aq15Mag[i]) >> 15;
+                if (u32Diff > u32FftDiff)
+                    u32FftDiff = u32Diff;
+                if (s_asBench[0].aq15Mag[i] > s_asBench[0].aq15Mag[u32Peak])
+                    u32Peak = i;
+            }
+            s_asBench[0].u32FftReady = s_asBench[1].u32FftReady = 0;
+        }
+    }
+
+    printf("\n%-14s %12s %12s %8s\n", "Stage", "SIMD cyc/smp", "C cyc/smp", "Speedup");
+    for (i = 0; i < psSimd->u32StageNum; i++)
+    {
+        uint32_t u32Simd = psSimd->asStage[i].u32Cycles * 10 / psSimd->asStage[i].u32Samples;
+        uint32_t u32Ref = psRef->asStage[i].u32Cycles * 10 / psRef->asStage[i].u32Samples;
+
+        if (u32Simd == 0)
+            u32Simd = 1;
+
+        printf("%-14s %10d.%d %10d.%d %6d.%02dx\n", s_apcStageName[psSimd->asStage[i].u32Type],
+               u32Simd / 10, u32Simd % 10, u32Ref / 10, u32Ref % 10,
+               u32Ref / u32Simd, (u32Ref % u32Simd) * 100 / u32Simd);
+    }
+
+    printf("\nLast block: RMS 0x%04X, peak 0x%04X, spectrum peak %d Hz\n",
+           s_asBench[0].sLevel.q15Rms, s_asBench[0].sLevel.q15Peak,
+           u32Peak * SAMPLE_RATE / DECIM / FFT_LEN);
+    printf("Filter/level mismatches: %d, largest FFT bin power difference: %d\n", u32Mismatch, u32FftDiff);
+
+    if ((u32Mismatch == 0) && (u32FftDiff <= FFT_TOLERANCE))
+        printf("DSP pipeline test ok!\n");
+    else
+        printf("ERROR: SIMD and reference kernels disagree!\n");
+
+    while (SYS->PDID);
+}
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
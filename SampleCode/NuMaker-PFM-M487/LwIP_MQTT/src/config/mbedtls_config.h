@@ -46,10 +46,18 @@ extern void print_hex(uint8_t *hex, int len);
 /**
  *  Nuvoton Crypto hardware engine enable
  */
-#define NUVOTON_ENABLE_AES
 #define NUVOTON_ENABLE_DES
-#define NUVOTON_ENABLE_SHA
-#define NUVOTON_ENABLE_ECC
+
+/*
+ *  AES, AES-GCM, ECDSA and ECDH use the ALT layer in src/mbedtls_app
+ *  (aes_alt.c, gcm_alt.c, ecp_alt.c) instead of the NUVOTON_ENABLE_AES/ECC
+ *  patches in the library sources. See MBEDTLS_AES_ALT below.
+ *
+ *  SHA-224/256 stays in software: the engine cannot save or reload an
+ *  intermediate digest, so it could only hash messages held whole in RAM,
+ *  while the handshake checksum, HMAC and cloned contexts are interleaved
+ *  and stream far more data than is worth buffering per context.
+ */
 
 extern volatile int g_Crypto_Int_done;
 
@@ -322,7 +330,7 @@ extern void platform_alt_free(void *);
  *            digests and ciphers instead.
  *
  */
-//#define MBEDTLS_AES_ALT
+#define MBEDTLS_AES_ALT
 //#define MBEDTLS_ARC4_ALT
 //#define MBEDTLS_ARIA_ALT
 //#define MBEDTLS_BLOWFISH_ALT
@@ -334,7 +342,7 @@ extern void platform_alt_free(void *);
 //#define MBEDTLS_DES_ALT
 //#define MBEDTLS_DHM_ALT
 //#define MBEDTLS_ECJPAKE_ALT
-//#define MBEDTLS_GCM_ALT
+#define MBEDTLS_GCM_ALT
 //#define MBEDTLS_NIST_KW_ALT
 //#define MBEDTLS_MD2_ALT
 //#define MBEDTLS_MD4_ALT
@@ -407,10 +415,10 @@ extern void platform_alt_free(void *);
 //#define MBEDTLS_AES_SETKEY_DEC_ALT
 //#define MBEDTLS_AES_ENCRYPT_ALT
 //#define MBEDTLS_AES_DECRYPT_ALT
-//#define MBEDTLS_ECDH_GEN_PUBLIC_ALT
-//#define MBEDTLS_ECDH_COMPUTE_SHARED_ALT
-//#define MBEDTLS_ECDSA_VERIFY_ALT
-//#define MBEDTLS_ECDSA_SIGN_ALT
+#define MBEDTLS_ECDH_GEN_PUBLIC_ALT
+#define MBEDTLS_ECDH_COMPUTE_SHARED_ALT
+#define MBEDTLS_ECDSA_VERIFY_ALT
+#define MBEDTLS_ECDSA_SIGN_ALT
 //#define MBEDTLS_ECDSA_GENKEY_ALT
 
 /**
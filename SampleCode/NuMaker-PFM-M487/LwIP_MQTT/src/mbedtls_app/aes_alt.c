@@ -0,0 +1,625 @@
+/**
+    @file       aes_alt.c
+    @brief  MBEDTLS_AES_ALT implementation on the M480 crypto engine
+
+    Whole buffers are pushed through the AES DMA in NU_AES_DMA_BUF_SIZE chunks instead of one
+    block per engine start. ECB and CBC run on the engine directly. CTR, CFB and OFB are built
+    on top of ECB so the mbed TLS offset/stream block semantics are kept exactly.
+
+    The engine reports completion through CRYPTO_IRQHandler(), which must set g_Crypto_Int_done
+    on AES_GET_INT_FLAG(), and AES_ENABLE_INT() must have been called (see main.c). Every engine
+    run, together with the DMA bounce buffers, is done under nu_crypto_lock().
+
+    With NU_CRYPTO_SW_FALLBACK the engine is replaced by a compact table based software core.
+*/
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_AES_ALT)
+
+#include <string.h>
+#include "mbedtls/aes.h"
+#include "mbedtls/platform_util.h"
+
+#if !NU_CRYPTO_SW_FALLBACK
+#include "NuMicro.h"
+#include "threading_alt.h"
+#else
+#define nu_crypto_lock()
+#define nu_crypto_unlock()
+#endif
+
+#if defined(MBEDTLS_CIPHER_MODE_XTS)
+#error "aes_alt.c does not implement MBEDTLS_CIPHER_MODE_XTS"
+#endif
+
+#if (NU_AES_DMA_BUF_SIZE < 16) || (NU_AES_DMA_BUF_SIZE % 16)
+#error "NU_AES_DMA_BUF_SIZE must be a non-zero multiple of 16"
+#endif
+
+#define GET_UINT32_BE(n,b,i)                            \
+{                                                       \
+    (n) = ( (uint32_t) (b)[(i) + 3]       )             \
+        | ( (uint32_t) (b)[(i) + 2] <<  8 )             \
+        | ( (uint32_t) (b)[(i) + 1] << 16 )             \
+        | ( (uint32_t) (b)[(i)    ] << 24 );            \
+}
+
+#if NU_CRYPTO_SW_FALLBACK
+
+/* Forward S-box */
+static const unsigned char FSb[256] =
+{
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+/* Reverse S-box */
+static const unsigned char RSb[256] =
+{
+    0x52, 0x09, 0x6A, 0xD5, 0x30, 0x36, 0xA5, 0x38, 0xBF, 0x40, 0xA3, 0x9E, 0x81, 0xF3, 0xD7, 0xFB,
+    0x7C, 0xE3, 0x39, 0x82, 0x9B, 0x2F, 0xFF, 0x87, 0x34, 0x8E, 0x43, 0x44, 0xC4, 0xDE, 0xE9, 0xCB,
+    0x54, 0x7B, 0x94, 0x32, 0xA6, 0xC2, 0x23, 0x3D, 0xEE, 0x4C, 0x95, 0x0B, 0x42, 0xFA, 0xC3, 0x4E,
+    0x08, 0x2E, 0xA1, 0x66, 0x28, 0xD9, 0x24, 0xB2, 0x76, 0x5B, 0xA2, 0x49, 0x6D, 0x8B, 0xD1, 0x25,
+    0x72, 0xF8, 0xF6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xD4, 0xA4, 0x5C, 0xCC, 0x5D, 0x65, 0xB6, 0x92,
+    0x6C, 0x70, 0x48, 0x50, 0xFD, 0xED, 0xB9, 0xDA, 0x5E, 0x15, 0x46, 0x57, 0xA7, 0x8D, 0x9D, 0x84,
+    0x90, 0xD8, 0xAB, 0x00, 0x8C, 0xBC, 0xD3, 0x0A, 0xF7, 0xE4, 0x58, 0x05, 0xB8, 0xB3, 0x45, 0x06,
+    0xD0, 0x2C, 0x1E, 0x8F, 0xCA, 0x3F, 0x0F, 0x02, 0xC1, 0xAF, 0xBD, 0x03, 0x01, 0x13, 0x8A, 0x6B,
+    0x3A, 0x91, 0x11, 0x41, 0x4F, 0x67, 0xDC, 0xEA, 0x97, 0xF2, 0xCF, 0xCE, 0xF0, 0xB4, 0xE6, 0x73,
+    0x96, 0xAC, 0x74, 0x22, 0xE7, 0xAD, 0x35, 0x85, 0xE2, 0xF9, 0x37, 0xE8, 0x1C, 0x75, 0xDF, 0x6E,
+    0x47, 0xF1, 0x1A, 0x71, 0x1D, 0x29, 0xC5, 0x89, 0x6F, 0xB7, 0x62, 0x0E, 0xAA, 0x18, 0xBE, 0x1B,
+    0xFC, 0x56, 0x3E, 0x4B, 0xC6, 0xD2, 0x79, 0x20, 0x9A, 0xDB, 0xC0, 0xFE, 0x78, 0xCD, 0x5A, 0xF4,
+    0x1F, 0xDD, 0xA8, 0x33, 0x88, 0x07, 0xC7, 0x31, 0xB1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xEC, 0x5F,
+    0x60, 0x51, 0x7F, 0xA9, 0x19, 0xB5, 0x4A, 0x0D, 0x2D, 0xE5, 0x7A, 0x9F, 0x93, 0xC9, 0x9C, 0xEF,
+    0xA0, 0xE0, 0x3B, 0x4D, 0xAE, 0x2A, 0xF5, 0xB0, 0xC8, 0xEB, 0xBB, 0x3C, 0x83, 0x53, 0x99, 0x61,
+    0x17, 0x2B, 0x04, 0x7E, 0xBA, 0x77, 0xD6, 0x26, 0xE1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0C, 0x7D
+};
+
+#define XTIME(x)    ((unsigned char)(((x) << 1) ^ (((x) & 0x80) ? 0x1B : 0x00)))
+
+static unsigned char gf_mul(unsigned char a, unsigned char b)
+{
+    unsigned char p = 0;
+
+    while (b)
+    {
+        if (b & 1)
+            p ^= a;
+        a = XTIME(a);
+        b >>= 1;
+    }
+    return p;
+}
+
+static void sw_aes_expand_key(mbedtls_aes_context *ctx)
+{
+    int      i, nk = (ctx->nr - 6);
+    uint32_t t;
+    unsigned char rcon = 0x01;
+
+    for (i = 0; i < nk; i++)
+        ctx->rk[i] = ctx->key[i];
+
+    for ( ; i < 4 * (ctx->nr + 1); i++)
+    {
+        t = ctx->rk[i - 1];
+        if ((i % nk) == 0)
+        {
+            t = ((uint32_t)FSb[(t >> 16) & 0xFF] << 24) | ((uint32_t)FSb[(t >> 8) & 0xFF] << 16) |
+                ((uint32_t)FSb[t & 0xFF] << 8) | (uint32_t)FSb[t >> 24];
+            t ^= (uint32_t)rcon << 24;
+            rcon = XTIME(rcon);
+        }
+        else if ((nk > 6) && ((i % nk) == 4))
+        {
+            t = ((uint32_t)FSb[t >> 24] << 24) | ((uint32_t)FSb[(t >> 16) & 0xFF] << 16) |
+                ((uint32_t)FSb[(t >> 8) & 0xFF] << 8) | (uint32_t)FSb[t & 0xFF];
+        }
+        ctx->rk[i] = ctx->rk[i - nk] ^ t;
+    }
+}
+
+static void sw_aes_add_round_key(unsigned char s[16], const uint32_t *rk)
+{
+    int  c;
+
+    for (c = 0; c < 4; c++)
+    {
+        s[4*c]   ^= (unsigned char)(rk[c] >> 24);
+        s[4*c+1] ^= (unsigned char)(rk[c] >> 16);
+        s[4*c+2] ^= (unsigned char)(rk[c] >> 8);
+        s[4*c+3] ^= (unsigned char)(rk[c]);
+    }
+}
+
+/* SubBytes + ShiftRows (or their inverses) in one pass; row r rotates by r columns. */
+static void sw_aes_sub_shift(unsigned char s[16], const unsigned char *sbox, int inverse)
+{
+    unsigned char t[16];
+    int  r, c;
+
+    for (c = 0; c < 4; c++)
+        for (r = 0; r < 4; r++)
+            t[4*c+r] = sbox[s[4*((inverse ? (c + 4 - r) : (c + r)) % 4) + r]];
+    memcpy(s, t, 16);
+}
+
+static void sw_aes_block(mbedtls_aes_context *ctx, int mode, const unsigned char in[16], unsigned char out[16])
+{
+    unsigned char s[16], a0, a1, a2, a3;
+    int  round, c;
+
+    memcpy(s, in, 16);
+
+    if (mode == MBEDTLS_AES_ENCRYPT)
+    {
+        sw_aes_add_round_key(s, &ctx->rk[0]);
+        for (round = 1; round <= ctx->nr; round++)
+        {
+            sw_aes_sub_shift(s, FSb, 0);
+            if (round != ctx->nr)
+            {
+                for (c = 0; c < 16; c += 4)
+                {
+                    a0 = s[c]; a1 = s[c+1]; a2 = s[c+2]; a3 = s[c+3];
+                    s[c]   = XTIME(a0) ^ XTIME(a1) ^ a1 ^ a2 ^ a3;
+                    s[c+1] = a0 ^ XTIME(a1) ^ XTIME(a2) ^ a2 ^ a3;
+                    s[c+2] = a0 ^ a1 ^ XTIME(a2) ^ XTIME(a3) ^ a3;
+                    s[c+3] = XTIME(a0) ^ a0 ^ a1 ^ a2 ^ XTIME(a3);
+                }
+            }
+            sw_aes_add_round_key(s, &ctx->rk[4 * round]);
+        }
+    }
+    else
+    {
+        sw_aes_add_round_key(s, &ctx->rk[4 * ctx->nr]);
+        for (round = ctx->nr - 1; round >= 0; round--)
+        {
+            sw_aes_sub_shift(s, RSb, 1);
+            sw_aes_add_round_key(s, &ctx->rk[4 * round]);
+            if (round != 0)
+            {
+                for (c = 0; c < 16; c += 4)
+                {
+                    a0 = s[c]; a1 = s[c+1]; a2 = s[c+2]; a3 = s[c+3];
+                    s[c]   = gf_mul(a0, 14) ^ gf_mul(a1, 11) ^ gf_mul(a2, 13) ^ gf_mul(a3, 9);
+                    s[c+1] = gf_mul(a0, 9) ^ gf_mul(a1, 14) ^ gf_mul(a2, 11) ^ gf_mul(a3, 13);
+                    s[c+2] = gf_mul(a0, 13) ^ gf_mul(a1, 9) ^ gf_mul(a2, 14) ^ gf_mul(a3, 11);
+                    s[c+3] = gf_mul(a0, 11) ^ gf_mul(a1, 13) ^ gf_mul(a2, 9) ^ gf_mul(a3, 14);
+                }
+            }
+        }
+    }
+    memcpy(out, s, 16);
+    mbedtls_platform_zeroize(s, sizeof(s));
+}
+
+/*
+ * Software stand-in for one engine run: ECB, or CBC when iv is not NULL.
+ */
+static int nu_aes_run(mbedtls_aes_context *ctx, int mode, unsigned char iv[16],
+                      const unsigned char *input, unsigned char *output, size_t length)
+{
+    unsigned char  temp[16];
+    int  i;
+
+    for ( ; length > 0; input += 16, output += 16, length -= 16)
+    {
+        if (iv == NULL)
+        {
+            sw_aes_block(ctx, mode, input, output);
+        }
+        else if (mode == MBEDTLS_AES_ENCRYPT)
+        {
+            for (i = 0; i < 16; i++)
+                temp[i] = input[i] ^ iv[i];
+            sw_aes_block(ctx, mode, temp, output);
+            memcpy(iv, output, 16);
+        }
+        else
+        {
+            memcpy(temp, input, 16);
+            sw_aes_block(ctx, mode, input, output);
+            for (i = 0; i < 16; i++)
+                output[i] ^= iv[i];
+            memcpy(iv, temp, 16);
+        }
+    }
+    return 0;
+}
+
+#else  /* !NU_CRYPTO_SW_FALLBACK */
+
+#ifdef __ICCARM__
+#pragma data_alignment=4
+static uint8_t s_src_dma_buf[NU_AES_DMA_BUF_SIZE];
+#pragma data_alignment=4
+static uint8_t s_dst_dma_buf[NU_AES_DMA_BUF_SIZE];
+#else
+static uint8_t s_src_dma_buf[NU_AES_DMA_BUF_SIZE] __attribute__((aligned (4)));
+static uint8_t s_dst_dma_buf[NU_AES_DMA_BUF_SIZE] __attribute__((aligned (4)));
+#endif
+
+/*
+ * Run ECB (iv == NULL) or CBC over a multiple of 16 bytes on AES channel 0.
+ * The channel is reprogrammed for every chunk, so contexts may be freely interleaved.
+ * On return iv holds the chaining value for the next call, as mbedtls_aes_crypt_cbc() requires.
+ * The caller holds nu_crypto_lock().
+ */
+static int nu_aes_run(mbedtls_aes_context *ctx, int mode, unsigned char iv[16],
+                      const unsigned char *input, unsigned char *output, size_t length)
+{
+    uint32_t  au32IV[4];
+    size_t    n;
+    int       i;
+
+    while (length > 0)
+    {
+        n = (length > NU_AES_DMA_BUF_SIZE) ? NU_AES_DMA_BUF_SIZE : length;
+        memcpy(s_src_dma_buf, input, n);
+
+        AES_Open(CRPT, 0, (mode == MBEDTLS_AES_ENCRYPT) ? 1 : 0,
+                 (iv != NULL) ? AES_MODE_CBC : AES_MODE_ECB, ctx->keysz, AES_IN_OUT_SWAP);
+        AES_SetKey(CRPT, 0, ctx->key, ctx->keysz);
+        if (iv != NULL)
+        {
+            for (i = 0; i < 4; i++)
+                GET_UINT32_BE(au32IV[i], iv, i << 2);
+            AES_SetInitVect(CRPT, 0, au32IV);
+        }
+        AES_SetDMATransfer(CRPT, 0, (uint32_t)s_src_dma_buf, (uint32_t)s_dst_dma_buf, n);
+
+        g_Crypto_Int_done = 0;
+        AES_Start(CRPT, 0, CRYPTO_DMA_ONE_SHOT);
+        while (g_Crypto_Int_done == 0);
+
+        if (iv != NULL)
+            memcpy(iv, (mode == MBEDTLS_AES_ENCRYPT) ? &s_dst_dma_buf[n - 16] : &s_src_dma_buf[n - 16], 16);
+
+        memcpy(output, s_dst_dma_buf, n);
+        input += n;
+        output += n;
+        length -= n;
+    }
+    return 0;
+}
+
+#endif /* NU_CRYPTO_SW_FALLBACK */
+
+static int nu_aes_crypt(mbedtls_aes_context *ctx, int mode, unsigned char iv[16],
+                        const unsigned char *input, unsigned char *output, size_t length)
+{
+    int ret;
+
+    nu_crypto_lock();
+    ret = nu_aes_run(ctx, mode, iv, input, output, length);
+    nu_crypto_unlock();
+    return ret;
+}
+
+/* Key stream of one CTR request, shared by all contexts under nu_crypto_lock() */
+static unsigned char s_ctr_ks[NU_AES_DMA_BUF_SIZE];
+
+void mbedtls_aes_init( mbedtls_aes_context *ctx )
+{
+    memset( ctx, 0, sizeof( mbedtls_aes_context ) );
+}
+
+void mbedtls_aes_free( mbedtls_aes_context *ctx )
+{
+    if( ctx == NULL )
+        return;
+
+    mbedtls_platform_zeroize( ctx, sizeof( mbedtls_aes_context ) );
+}
+
+int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
+                            unsigned int keybits )
+{
+    unsigned int i;
+
+    switch( keybits )
+    {
+        case 128: ctx->nr = 10; break;
+        case 192: ctx->nr = 12; break;
+        case 256: ctx->nr = 14; break;
+        default : return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
+    }
+
+    ctx->keysz = (keybits - 128) / 64;      /* AES_KEY_SIZE_128/192/256 */
+    memset( ctx->key, 0, sizeof( ctx->key ) );
+    for( i = 0; i < keybits / 32; i++ )
+        GET_UINT32_BE( ctx->key[i], key, i << 2 );
+
+#if NU_CRYPTO_SW_FALLBACK
+    sw_aes_expand_key( ctx );
+#endif
+    return( 0 );
+}
+
+/*
+ * Both directions use the same raw key; the engine derives the decryption schedule itself.
+ */
+int mbedtls_aes_setkey_dec( mbedtls_aes_context *ctx, const unsigned char *key,
+                            unsigned int keybits )
+{
+    return( mbedtls_aes_setkey_enc( ctx, key, keybits ) );
+}
+
+int mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
+                                  const unsigned char input[16],
+                                  unsigned char output[16] )
+{
+    return( nu_aes_crypt( ctx, MBEDTLS_AES_ENCRYPT, NULL, input, output, 16 ) );
+}
+
+int mbedtls_internal_aes_decrypt( mbedtls_aes_context *ctx,
+                                  const unsigned char input[16],
+                                  unsigned char output[16] )
+{
+    return( nu_aes_crypt( ctx, MBEDTLS_AES_DECRYPT, NULL, input, output, 16 ) );
+}
+
+#if !defined(MBEDTLS_DEPRECATED_REMOVED)
+void mbedtls_aes_encrypt( mbedtls_aes_context *ctx,
+                          const unsigned char input[16],
+                          unsigned char output[16] )
+{
+    mbedtls_internal_aes_encrypt( ctx, input, output );
+}
+
+void mbedtls_aes_decrypt( mbedtls_aes_context *ctx,
+                          const unsigned char input[16],
+                          unsigned char output[16] )
+{
+    mbedtls_internal_aes_decrypt( ctx, input, output );
+}
+#endif /* !MBEDTLS_DEPRECATED_REMOVED */
+
+int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
+                           int mode,
+                           const unsigned char input[16],
+                           unsigned char output[16] )
+{
+    return( nu_aes_crypt( ctx, mode, NULL, input, output, 16 ) );
+}
+
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+int mbedtls_aes_crypt_cbc( mbedtls_aes_context *ctx,
+                           int mode,
+                           size_t length,
+                           unsigned char iv[16],
+                           const unsigned char *input,
+                           unsigned char *output )
+{
+    if( length % 16 )
+        return( MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH );
+
+    if( length == 0 )
+        return( 0 );
+
+    return( nu_aes_crypt( ctx, mode, iv, input, output, length ) );
+}
+#endif /* MBEDTLS_CIPHER_MODE_CBC */
+
+#if defined(MBEDTLS_CIPHER_MODE_CFB)
+int mbedtls_aes_crypt_cfb128( mbedtls_aes_context *ctx,
+                              int mode,
+                              size_t length,
+                              size_t *iv_off,
+                              unsigned char iv[16],
+                              const unsigned char *input,
+                              unsigned char *output )
+{
+    int c;
+    size_t n = *iv_off;
+
+    if( n > 15 )
+        return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
+
+    while( length-- )
+    {
+        if( n == 0 )
+            nu_aes_crypt( ctx, MBEDTLS_AES_ENCRYPT, NULL, iv, iv, 16 );
+
+        if( mode == MBEDTLS_AES_DECRYPT )
+        {
+            c = *input++;
+            *output++ = (unsigned char)( c ^ iv[n] );
+            iv[n] = (unsigned char) c;
+        }
+        else
+        {
+            iv[n] = *output++ = (unsigned char)( iv[n] ^ *input++ );
+        }
+
+        n = ( n + 1 ) & 0x0F;
+    }
+
+    *iv_off = n;
+
+    return( 0 );
+}
+
+int mbedtls_aes_crypt_cfb8( mbedtls_aes_context *ctx,
+                            int mode,
+                            size_t length,
+                            unsigned char iv[16],
+                            const unsigned char *input,
+                            unsigned char *output )
+{
+    unsigned char c;
+    unsigned char ov[17];
+
+    while( length-- )
+    {
+        memcpy( ov, iv, 16 );
+        nu_aes_crypt( ctx, MBEDTLS_AES_ENCRYPT, NULL, iv, iv, 16 );
+
+        if( mode == MBEDTLS_AES_DECRYPT )
+            ov[16] = *input;
+
+        c = *output++ = (unsigned char)( iv[0] ^ *input++ );
+
+        if( mode == MBEDTLS_AES_ENCRYPT )
+            ov[16] = c;
+
+        memcpy( iv, ov + 1, 16 );
+    }
+
+    return( 0 );
+}
+#endif /* MBEDTLS_CIPHER_MODE_CFB */
+
+#if defined(MBEDTLS_CIPHER_MODE_OFB)
+int mbedtls_aes_crypt_ofb( mbedtls_aes_context *ctx,
+                           size_t length,
+                           size_t *iv_off,
+                           unsigned char iv[16],
+                           const unsigned char *input,
+                           unsigned char *output )
+{
+    size_t n = *iv_off;
+
+    if( n > 15 )
+        return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
+
+    while( length-- )
+    {
+        if( n == 0 )
+            nu_aes_crypt( ctx, MBEDTLS_AES_ENCRYPT, NULL, iv, iv, 16 );
+
+        *output++ = *input++ ^ iv[n];
+
+        n = ( n + 1 ) & 0x0F;
+    }
+
+    *iv_off = n;
+
+    return( 0 );
+}
+#endif /* MBEDTLS_CIPHER_MODE_OFB */
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+/*
+ * The key stream for all whole blocks of a request is produced by a single ECB pass over
+ * consecutive counter values, so the engine runs once per NU_AES_DMA_BUF_SIZE bytes.
+ */
+int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
+                           size_t length,
+                           size_t *nc_off,
+                           unsigned char nonce_counter[16],
+                           unsigned char stream_block[16],
+                           const unsigned char *input,
+                           unsigned char *output )
+{
+    unsigned char *ks = s_ctr_ks;
+    size_t n = *nc_off;
+    size_t blocks, i, j;
+    int k;
+
+    if( n > 15 )
+        return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
+
+    /* Use up what is left of the previous stream block */
+    while( n != 0 && length > 0 )
+    {
+        *output++ = *input++ ^ stream_block[n];
+        n = ( n + 1 ) & 0x0F;
+        length--;
+    }
+
+    nu_crypto_lock();
+    while( length > 0 )
+    {
+        blocks = ( length + 15 ) / 16;
+        if( blocks > NU_AES_DMA_BUF_SIZE / 16 )
+            blocks = NU_AES_DMA_BUF_SIZE / 16;
+
+        for( i = 0; i < blocks; i++ )
+        {
+            memcpy( &ks[i * 16], nonce_counter, 16 );
+            for( k = 16; k > 0; k-- )
+                if( ++nonce_counter[k - 1] != 0 )
+                    break;
+        }
+        nu_aes_run( ctx, MBEDTLS_AES_ENCRYPT, NULL, ks, ks, blocks * 16 );
+
+        for( j = 0; j < blocks * 16 && length > 0; j++, length-- )
+            *output++ = *input++ ^ ks[j];
+
+        /* A partial final block leaves its key stream for the next call */
+        n = j & 0x0F;
+        if( n != 0 )
+            memcpy( stream_block, &ks[j - n], 16 );
+    }
+
+    mbedtls_platform_zeroize( ks, NU_AES_DMA_BUF_SIZE );
+    nu_crypto_unlock();
+    *nc_off = n;
+
+    return( 0 );
+}
+#endif /* MBEDTLS_CIPHER_MODE_CTR */
+
+/*
+ * CTR with the 32-bit big-endian counter of GCM in the last four bytes of counter. The counter
+ * is incremented before each block is encrypted, as mbedtls_gcm_update() does. A trailing
+ * partial block uses the front of its key stream block. Whole blocks of a request share one
+ * engine run per NU_AES_DMA_BUF_SIZE bytes.
+ */
+int nu_aes_crypt_ctr32( mbedtls_aes_context *ctx,
+                        size_t length,
+                        unsigned char counter[16],
+                        const unsigned char *input,
+                        unsigned char *output )
+{
+    unsigned char *ks = s_ctr_ks;
+    size_t blocks, i, j;
+    int k;
+
+    nu_crypto_lock();
+    while( length > 0 )
+    {
+        blocks = ( length + 15 ) / 16;
+        if( blocks > NU_AES_DMA_BUF_SIZE / 16 )
+            blocks = NU_AES_DMA_BUF_SIZE / 16;
+
+        for( i = 0; i < blocks; i++ )
+        {
+            for( k = 16; k > 12; k-- )
+                if( ++counter[k - 1] != 0 )
+                    break;
+            memcpy( &ks[i * 16], counter, 16 );
+        }
+        nu_aes_run( ctx, MBEDTLS_AES_ENCRYPT, NULL, ks, ks, blocks * 16 );
+
+        for( j = 0; j < blocks * 16 && length > 0; j++, length-- )
+            *output++ = *input++ ^ ks[j];
+    }
+
+    mbedtls_platform_zeroize( ks, NU_AES_DMA_BUF_SIZE );
+    nu_crypto_unlock();
+
+    return( 0 );
+}
+
+#endif /* MBEDTLS_AES_C && MBEDTLS_AES_ALT */
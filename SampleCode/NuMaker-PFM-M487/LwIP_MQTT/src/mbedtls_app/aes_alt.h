@@ -0,0 +1,48 @@
+/**
+    @file       aes_alt.h
+    @brief  AES context for MBEDTLS_AES_ALT, backed by the M480 crypto engine
+*/
+#ifndef __AES_ALT_H__
+#define __AES_ALT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * Define NU_CRYPTO_SW_FALLBACK to 1 to build aes_alt.c, gcm_alt.c and ecp_alt.c without the
+ * crypto engine, e.g. to run the mbed TLS self tests and test_suit_* vectors on a host.
+ */
+#ifndef NU_CRYPTO_SW_FALLBACK
+#define NU_CRYPTO_SW_FALLBACK   0
+#endif
+
+/*!
+ * Size of the word aligned bounce buffer handed to the AES DMA. Requests longer than this are
+ * split into several DMA transfers. Must be a multiple of 16.
+ */
+#ifndef NU_AES_DMA_BUF_SIZE
+#define NU_AES_DMA_BUF_SIZE     512
+#endif
+
+/*!
+ * The crypto engine expands the key by itself, so the context only keeps the raw key.
+ */
+typedef struct mbedtls_aes_context
+{
+    int nr;                     /*!< The number of rounds. */
+    uint32_t keysz;             /*!< AES_KEY_SIZE_128/192/256 */
+    uint32_t key[8];            /*!< Raw key as big-endian words */
+#if NU_CRYPTO_SW_FALLBACK
+    uint32_t rk[60];            /*!< Expanded key schedule of the software core */
+#endif
+}
+mbedtls_aes_context;
+
+/*!
+ * Encrypt or decrypt length bytes in CTR mode with the 32-bit counter of GCM, used by gcm_alt.c
+ * to run the blocks of a request through the engine together. See aes_alt.c.
+ */
+int nu_aes_crypt_ctr32(mbedtls_aes_context *ctx, size_t length, unsigned char counter[16],
+                       const unsigned char *input, unsigned char *output);
+
+#endif
@@ -0,0 +1,455 @@
+/**
+    @file       ecp_alt.c
+    @brief  ECDSA and ECDH on the M480 crypto engine
+
+    Provides the function level replacements enabled by MBEDTLS_ECDSA_SIGN_ALT,
+    MBEDTLS_ECDSA_VERIFY_ALT, MBEDTLS_ECDH_GEN_PUBLIC_ALT and MBEDTLS_ECDH_COMPUTE_SHARED_ALT.
+    The ecp module itself is left untouched. Curves known to the engine go through
+    ECC_GenerateSignature(), ECC_VerifySignature() and ECC_Mutiply(); every other curve, and the
+    NU_CRYPTO_SW_FALLBACK build, use the mbed TLS point arithmetic.
+
+    The ECC driver waits for ECC_Complete(), so CRYPTO_IRQHandler() must call it and
+    ECC_ENABLE_INT() must have been called (see main.c). The engine and the s_hex_* strings are
+    only touched under nu_crypto_lock(), and the strings are wiped before the lock is released
+    because they hold private keys, nonces and shared secrets.
+*/
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_ECP_C) && \
+    ( defined(MBEDTLS_ECDSA_SIGN_ALT) || defined(MBEDTLS_ECDSA_VERIFY_ALT) || \
+      defined(MBEDTLS_ECDH_GEN_PUBLIC_ALT) || defined(MBEDTLS_ECDH_COMPUTE_SHARED_ALT) )
+
+#include <string.h>
+#include "mbedtls/ecp.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/ecdh.h"
+#include "mbedtls/platform_util.h"
+
+#ifndef NU_CRYPTO_SW_FALLBACK
+#define NU_CRYPTO_SW_FALLBACK   0
+#endif
+
+#if !NU_CRYPTO_SW_FALLBACK
+#include "NuMicro.h"
+#include "threading_alt.h"
+
+/* A coordinate or scalar as a hex string, plus sign and terminator */
+#define NU_ECC_HEX_LEN      (2 * MBEDTLS_ECP_MAX_BYTES + 4)
+
+static char s_hex_x1[NU_ECC_HEX_LEN];
+static char s_hex_y1[NU_ECC_HEX_LEN];
+static char s_hex_k[NU_ECC_HEX_LEN];
+static char s_hex_x2[NU_ECC_HEX_LEN];
+static char s_hex_y2[NU_ECC_HEX_LEN];
+
+static const struct
+{
+    mbedtls_ecp_group_id  id;
+    E_ECC_CURVE           curve;
+}
+s_curve_map[] =
+{
+    { MBEDTLS_ECP_DP_SECP192R1,  CURVE_P_192  },
+    { MBEDTLS_ECP_DP_SECP224R1,  CURVE_P_224  },
+    { MBEDTLS_ECP_DP_SECP256R1,  CURVE_P_256  },
+    { MBEDTLS_ECP_DP_SECP384R1,  CURVE_P_384  },
+    { MBEDTLS_ECP_DP_SECP521R1,  CURVE_P_521  },
+    { MBEDTLS_ECP_DP_SECP192K1,  CURVE_KO_192 },
+    { MBEDTLS_ECP_DP_SECP224K1,  CURVE_KO_224 },
+    { MBEDTLS_ECP_DP_SECP256K1,  CURVE_KO_256 },
+    { MBEDTLS_ECP_DP_BP256R1,    CURVE_BP_256 },
+    { MBEDTLS_ECP_DP_BP384R1,    CURVE_BP_384 },
+    { MBEDTLS_ECP_DP_BP512R1,    CURVE_BP_512 },
+};
+
+static E_ECC_CURVE nu_ecc_curve(mbedtls_ecp_group_id id)
+{
+    unsigned int  i;
+
+    for (i = 0; i < sizeof(s_curve_map) / sizeof(s_curve_map[0]); i++)
+    {
+        if (s_curve_map[i].id == id)
+            return s_curve_map[i].curve;
+    }
+    return CURVE_UNDEF;
+}
+
+/*
+ * Clear the scalars and results left in the hex strings. Call with the lock held.
+ */
+static void nu_ecc_wipe(void)
+{
+    mbedtls_platform_zeroize(s_hex_x1, sizeof(s_hex_x1));
+    mbedtls_platform_zeroize(s_hex_y1, sizeof(s_hex_y1));
+    mbedtls_platform_zeroize(s_hex_k, sizeof(s_hex_k));
+    mbedtls_platform_zeroize(s_hex_x2, sizeof(s_hex_x2));
+    mbedtls_platform_zeroize(s_hex_y2, sizeof(s_hex_y2));
+}
+
+static int nu_mpi_to_hex(const mbedtls_mpi *X, char *buf)
+{
+    size_t  olen;
+
+    return mbedtls_mpi_write_string(X, 16, buf, NU_ECC_HEX_LEN, &olen);
+}
+
+/*
+ * R = k * P on the engine. P must already be validated for grp.
+ */
+static int nu_ecc_mul(E_ECC_CURVE curve, mbedtls_ecp_point *R, const mbedtls_mpi *k,
+                      const mbedtls_ecp_point *P)
+{
+    int ret;
+
+    nu_crypto_lock();
+
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( &P->X, s_hex_x1 ) );
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( &P->Y, s_hex_y1 ) );
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( k, s_hex_k ) );
+
+    if( ECC_Mutiply( CRPT, curve, s_hex_x1, s_hex_y1, s_hex_k, s_hex_x2, s_hex_y2 ) != 0 )
+    {
+        ret = MBEDTLS_ERR_ECP_HW_ACCEL_FAILED;
+        goto cleanup;
+    }
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &R->X, 16, s_hex_x2 ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &R->Y, 16, s_hex_y2 ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_lset( &R->Z, 1 ) );
+
+cleanup:
+    nu_ecc_wipe();
+    nu_crypto_unlock();
+    return( ret );
+}
+
+#if defined(MBEDTLS_ECDSA_SIGN_ALT)
+/*
+ * r = (kG).x mod n and s = k^-1 (e + rd) mod n, both computed by the engine.
+ */
+static int nu_ecc_sign(E_ECC_CURVE curve, mbedtls_mpi *r, mbedtls_mpi *s, const mbedtls_mpi *e,
+                       const mbedtls_mpi *d, const mbedtls_mpi *k)
+{
+    int ret;
+
+    nu_crypto_lock();
+
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( e, s_hex_x1 ) );
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( d, s_hex_y1 ) );
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( k, s_hex_k ) );
+
+    if( ECC_GenerateSignature( CRPT, curve, s_hex_x1, s_hex_y1, s_hex_k,
+                               s_hex_x2, s_hex_y2 ) != 0 )
+    {
+        ret = MBEDTLS_ERR_ECP_HW_ACCEL_FAILED;
+        goto cleanup;
+    }
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( r, 16, s_hex_x2 ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( s, 16, s_hex_y2 ) );
+
+cleanup:
+    nu_ecc_wipe();
+    nu_crypto_unlock();
+    return( ret );
+}
+#endif
+
+#if defined(MBEDTLS_ECDSA_VERIFY_ALT)
+static int nu_ecc_verify(E_ECC_CURVE curve, const mbedtls_mpi *e, const mbedtls_ecp_point *Q,
+                         const mbedtls_mpi *r, const mbedtls_mpi *s)
+{
+    int ret;
+
+    nu_crypto_lock();
+
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( e, s_hex_k ) );
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( &Q->X, s_hex_x1 ) );
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( &Q->Y, s_hex_y1 ) );
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( r, s_hex_x2 ) );
+    MBEDTLS_MPI_CHK( nu_mpi_to_hex( s, s_hex_y2 ) );
+
+    if( ECC_VerifySignature( CRPT, curve, s_hex_k, s_hex_x1, s_hex_y1,
+                             s_hex_x2, s_hex_y2 ) != 0 )
+        ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+
+cleanup:
+    nu_ecc_wipe();
+    nu_crypto_unlock();
+    return( ret );
+}
+#endif
+#endif /* !NU_CRYPTO_SW_FALLBACK */
+
+#if defined(MBEDTLS_ECDSA_SIGN_ALT) || \
+    ( defined(MBEDTLS_ECDH_GEN_PUBLIC_ALT) && !NU_CRYPTO_SW_FALLBACK )
+/*
+ * Draw a scalar uniformly in [1, N-1] (short Weierstrass curves only).
+ */
+static int nu_ecp_gen_scalar(const mbedtls_ecp_group *grp, mbedtls_mpi *d,
+                             int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+{
+    int ret, count = 0;
+    size_t n_size = ( grp->nbits + 7 ) / 8;
+
+    do
+    {
+        MBEDTLS_MPI_CHK( mbedtls_mpi_fill_random( d, n_size, f_rng, p_rng ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_shift_r( d, 8 * n_size - grp->nbits ) );
+
+        if( ++count > 30 )
+            return( MBEDTLS_ERR_ECP_RANDOM_FAILED );
+    }
+    while( mbedtls_mpi_cmp_int( d, 1 ) < 0 ||
+           mbedtls_mpi_cmp_mpi( d, &grp->N ) >= 0 );
+
+cleanup:
+    return( ret );
+}
+#endif
+
+#if defined(MBEDTLS_ECDSA_SIGN_ALT) || defined(MBEDTLS_ECDSA_VERIFY_ALT)
+/*
+ * Derive a suitable integer for group grp from a buffer of length len
+ * SEC1 4.1.3 step 5 aka SEC1 4.1.4 step 3
+ */
+static int derive_mpi( const mbedtls_ecp_group *grp, mbedtls_mpi *x,
+                       const unsigned char *buf, size_t blen )
+{
+    int ret;
+    size_t n_size = ( grp->nbits + 7 ) / 8;
+    size_t use_size = blen > n_size ? n_size : blen;
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_binary( x, buf, use_size ) );
+    if( use_size * 8 > grp->nbits )
+        MBEDTLS_MPI_CHK( mbedtls_mpi_shift_r( x, use_size * 8 - grp->nbits ) );
+
+    /* While at it, reduce modulo N */
+    if( mbedtls_mpi_cmp_mpi( x, &grp->N ) >= 0 )
+        MBEDTLS_MPI_CHK( mbedtls_mpi_sub_mpi( x, x, &grp->N ) );
+
+cleanup:
+    return( ret );
+}
+#endif
+
+#if defined(MBEDTLS_ECDSA_SIGN_ALT)
+/*
+ * Compute ECDSA signature of a hashed message (SEC1 4.1.3)
+ */
+int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
+                const mbedtls_mpi *d, const unsigned char *buf, size_t blen,
+                int (*f_rng)(void *, unsigned char *, size_t), void *p_rng )
+{
+    int ret, sign_tries = 0;
+    mbedtls_ecp_point R;
+    mbedtls_mpi k, e;
+#if !NU_CRYPTO_SW_FALLBACK
+    E_ECC_CURVE curve = nu_ecc_curve( grp->id );
+#endif
+
+    /* Fail cleanly on curves such as Curve25519 that can't be used for ECDSA */
+    if( grp->N.p == NULL )
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    /* Make sure d is in range 1..n-1 */
+    if( mbedtls_mpi_cmp_int( d, 1 ) < 0 || mbedtls_mpi_cmp_mpi( d, &grp->N ) >= 0 )
+        return( MBEDTLS_ERR_ECP_INVALID_KEY );
+
+    mbedtls_ecp_point_init( &R );
+    mbedtls_mpi_init( &k ); mbedtls_mpi_init( &e );
+
+    MBEDTLS_MPI_CHK( derive_mpi( grp, &e, buf, blen ) );
+
+    do
+    {
+        if( sign_tries++ > 10 )
+        {
+            ret = MBEDTLS_ERR_ECP_RANDOM_FAILED;
+            goto cleanup;
+        }
+
+        MBEDTLS_MPI_CHK( nu_ecp_gen_scalar( grp, &k, f_rng, p_rng ) );
+
+#if !NU_CRYPTO_SW_FALLBACK
+        if( curve != CURVE_UNDEF )
+        {
+            MBEDTLS_MPI_CHK( nu_ecc_sign( curve, r, s, &e, d, &k ) );
+            continue;
+        }
+#endif
+        MBEDTLS_MPI_CHK( mbedtls_ecp_mul( grp, &R, &k, &grp->G, f_rng, p_rng ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( r, &R.X, &grp->N ) );
+        if( mbedtls_mpi_cmp_int( r, 0 ) == 0 )
+        {
+            MBEDTLS_MPI_CHK( mbedtls_mpi_lset( s, 0 ) );
+            continue;
+        }
+
+        /* s = (e + r * d) / k mod n */
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( s, r, d ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_add_mpi( s, s, &e ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_inv_mod( &k, &k, &grp->N ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( s, s, &k ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( s, s, &grp->N ) );
+    }
+    while( mbedtls_mpi_cmp_int( r, 0 ) == 0 || mbedtls_mpi_cmp_int( s, 0 ) == 0 );
+
+cleanup:
+    mbedtls_ecp_point_free( &R );
+    mbedtls_mpi_free( &k ); mbedtls_mpi_free( &e );
+
+    return( ret );
+}
+#endif /* MBEDTLS_ECDSA_SIGN_ALT */
+
+#if defined(MBEDTLS_ECDSA_VERIFY_ALT)
+/*
+ * Verify ECDSA signature of hashed message (SEC1 4.1.4)
+ */
+int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
+                  const unsigned char *buf, size_t blen,
+                  const mbedtls_ecp_point *Q, const mbedtls_mpi *r, const mbedtls_mpi *s)
+{
+    int ret;
+    mbedtls_mpi e, s_inv, u1, u2;
+    mbedtls_ecp_point R;
+#if !NU_CRYPTO_SW_FALLBACK
+    E_ECC_CURVE curve = nu_ecc_curve( grp->id );
+#endif
+
+    /* Fail cleanly on curves such as Curve25519 that can't be used for ECDSA */
+    if( grp->N.p == NULL )
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    mbedtls_ecp_point_init( &R );
+    mbedtls_mpi_init( &e ); mbedtls_mpi_init( &s_inv ); mbedtls_mpi_init( &u1 ); mbedtls_mpi_init( &u2 );
+
+    /* Make sure r and s are in range 1..n-1 */
+    if( mbedtls_mpi_cmp_int( r, 1 ) < 0 || mbedtls_mpi_cmp_mpi( r, &grp->N ) >= 0 ||
+        mbedtls_mpi_cmp_int( s, 1 ) < 0 || mbedtls_mpi_cmp_mpi( s, &grp->N ) >= 0 )
+    {
+        ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+        goto cleanup;
+    }
+
+    /* Additional precaution: make sure Q is valid */
+    MBEDTLS_MPI_CHK( mbedtls_ecp_check_pubkey( grp, Q ) );
+
+    MBEDTLS_MPI_CHK( derive_mpi( grp, &e, buf, blen ) );
+
+#if !NU_CRYPTO_SW_FALLBACK
+    if( curve != CURVE_UNDEF )
+    {
+        ret = nu_ecc_verify( curve, &e, Q, r, s );
+        goto cleanup;
+    }
+#endif
+
+    /* u1 = e / s mod n, u2 = r / s mod n */
+    MBEDTLS_MPI_CHK( mbedtls_mpi_inv_mod( &s_inv, s, &grp->N ) );
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &u1, &e, &s_inv ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &u1, &u1, &grp->N ) );
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &u2, r, &s_inv ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &u2, &u2, &grp->N ) );
+
+    /* R = u1 G + u2 Q */
+    MBEDTLS_MPI_CHK( mbedtls_ecp_muladd( grp, &R, &u1, &grp->G, &u2, Q ) );
+
+    if( mbedtls_ecp_is_zero( &R ) )
+    {
+        ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+        goto cleanup;
+    }
+
+    /* Check that (xR mod n) == r; reuse u1 for xR mod n */
+    MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &u1, &R.X, &grp->N ) );
+
+    if( mbedtls_mpi_cmp_mpi( &u1, r ) != 0 )
+    {
+        ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+        goto cleanup;
+    }
+
+cleanup:
+    mbedtls_ecp_point_free( &R );
+    mbedtls_mpi_free( &e ); mbedtls_mpi_free( &s_inv ); mbedtls_mpi_free( &u1 ); mbedtls_mpi_free( &u2 );
+
+    return( ret );
+}
+#endif /* MBEDTLS_ECDSA_VERIFY_ALT */
+
+#if defined(MBEDTLS_ECDH_GEN_PUBLIC_ALT)
+/*
+ * Generate public key Q = d G
+ */
+int mbedtls_ecdh_gen_public( mbedtls_ecp_group *grp, mbedtls_mpi *d, mbedtls_ecp_point *Q,
+                     int (*f_rng)(void *, unsigned char *, size_t),
+                     void *p_rng )
+{
+#if !NU_CRYPTO_SW_FALLBACK
+    int ret;
+    E_ECC_CURVE curve = nu_ecc_curve( grp->id );
+
+    if( curve == CURVE_UNDEF )
+        return( mbedtls_ecp_gen_keypair( grp, d, Q, f_rng, p_rng ) );
+
+    MBEDTLS_MPI_CHK( nu_ecp_gen_scalar( grp, d, f_rng, p_rng ) );
+    MBEDTLS_MPI_CHK( nu_ecc_mul( curve, Q, d, &grp->G ) );
+
+cleanup:
+    return( ret );
+#else
+    return( mbedtls_ecp_gen_keypair( grp, d, Q, f_rng, p_rng ) );
+#endif
+}
+#endif /* MBEDTLS_ECDH_GEN_PUBLIC_ALT */
+
+#if defined(MBEDTLS_ECDH_COMPUTE_SHARED_ALT)
+/*
+ * Compute shared secret (SEC1 3.3.1)
+ */
+int mbedtls_ecdh_compute_shared( mbedtls_ecp_group *grp, mbedtls_mpi *z,
+                         const mbedtls_ecp_point *Q, const mbedtls_mpi *d,
+                         int (*f_rng)(void *, unsigned char *, size_t),
+                         void *p_rng )
+{
+    int ret;
+    mbedtls_ecp_point P;
+#if !NU_CRYPTO_SW_FALLBACK
+    E_ECC_CURVE curve = nu_ecc_curve( grp->id );
+#endif
+
+    mbedtls_ecp_point_init( &P );
+
+    /* Make sure Q is a valid pubkey before using it */
+    MBEDTLS_MPI_CHK( mbedtls_ecp_check_pubkey( grp, Q ) );
+
+#if !NU_CRYPTO_SW_FALLBACK
+    if( curve != CURVE_UNDEF )
+        MBEDTLS_MPI_CHK( nu_ecc_mul( curve, &P, d, Q ) );
+    else
+#endif
+        MBEDTLS_MPI_CHK( mbedtls_ecp_mul( grp, &P, d, Q, f_rng, p_rng ) );
+
+    if( mbedtls_ecp_is_zero( &P ) )
+    {
+        ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_copy( z, &P.X ) );
+
+cleanup:
+    mbedtls_ecp_point_free( &P );
+
+    return( ret );
+}
+#endif /* MBEDTLS_ECDH_COMPUTE_SHARED_ALT */
+
+#endif /* MBEDTLS_ECP_C && (ECDSA/ECDH ALT) */
@@ -0,0 +1,446 @@
+/**
+    @file       gcm_alt.c
+    @brief  MBEDTLS_GCM_ALT implementation on the M480 crypto engine
+
+    Same algorithm as library/gcm.c (Shoup's 4-bit tables for GHASH), but the counter blocks of
+    an update call are encrypted together by nu_aes_crypt_ctr32(), so a TLS record costs one
+    engine run per NU_AES_DMA_BUF_SIZE bytes instead of one per 16 byte block. GHASH stays in
+    software. Ciphers other than AES (Camellia, ARIA) still encrypt one block per
+    mbedtls_cipher_update() call.
+*/
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_GCM_C) && defined(MBEDTLS_GCM_ALT)
+
+#include <string.h>
+#include "mbedtls/gcm.h"
+#include "mbedtls/aes.h"
+#include "mbedtls/platform_util.h"
+
+#if !defined(MBEDTLS_AES_ALT)
+#error "gcm_alt.c needs MBEDTLS_AES_ALT (aes_alt.c)"
+#endif
+
+#define GET_UINT32_BE(n,b,i)                            \
+{                                                       \
+    (n) = ( (uint32_t) (b)[(i)    ] << 24 )             \
+        | ( (uint32_t) (b)[(i) + 1] << 16 )             \
+        | ( (uint32_t) (b)[(i) + 2] <<  8 )             \
+        | ( (uint32_t) (b)[(i) + 3]       );            \
+}
+
+#define PUT_UINT32_BE(n,b,i)                            \
+{                                                       \
+    (b)[(i)    ] = (unsigned char) ( (n) >> 24 );       \
+    (b)[(i) + 1] = (unsigned char) ( (n) >> 16 );       \
+    (b)[(i) + 2] = (unsigned char) ( (n) >>  8 );       \
+    (b)[(i) + 3] = (unsigned char) ( (n)       );       \
+}
+
+/*
+ * Shoup's method for multiplication use this table with
+ *      last4[x] = x times P^128
+ */
+static const uint64_t last4[16] =
+{
+    0x0000, 0x1c20, 0x3840, 0x2460,
+    0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560,
+    0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+/*
+ * Precompute small multiples of H, that is HH[i] || HL[i] = H times i.
+ */
+static int gcm_gen_table(mbedtls_gcm_context *ctx)
+{
+    int ret, i, j;
+    uint64_t hi, lo;
+    uint64_t vl, vh;
+    unsigned char h[16];
+    size_t olen = 0;
+
+    memset(h, 0, 16);
+    if ((ret = mbedtls_cipher_update(&ctx->cipher_ctx, h, 16, h, &olen)) != 0)
+        return ret;
+
+    GET_UINT32_BE(hi, h,  0);
+    GET_UINT32_BE(lo, h,  4);
+    vh = (uint64_t) hi << 32 | lo;
+
+    GET_UINT32_BE(hi, h,  8);
+    GET_UINT32_BE(lo, h,  12);
+    vl = (uint64_t) hi << 32 | lo;
+
+    ctx->HL[8] = vl;
+    ctx->HH[8] = vh;
+    ctx->HH[0] = 0;
+    ctx->HL[0] = 0;
+
+    for (i = 4; i > 0; i >>= 1)
+    {
+        uint32_t T = (vl & 1) * 0xe1000000U;
+        vl  = (vh << 63) | (vl >> 1);
+        vh  = (vh >> 1) ^ ((uint64_t) T << 32);
+
+        ctx->HL[i] = vl;
+        ctx->HH[i] = vh;
+    }
+
+    for (i = 2; i <= 8; i *= 2)
+    {
+        uint64_t *HiL = ctx->HL + i, *HiH = ctx->HH + i;
+        vh = *HiH;
+        vl = *HiL;
+        for (j = 1; j < i; j++)
+        {
+            HiH[j] = vh ^ ctx->HH[j];
+            HiL[j] = vl ^ ctx->HL[j];
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Sets output to x times H using the precomputed tables.
+ */
+static void gcm_mult(mbedtls_gcm_context *ctx, const unsigned char x[16], unsigned char output[16])
+{
+    int i;
+    unsigned char lo, hi, rem;
+    uint64_t zh, zl;
+
+    lo = x[15] & 0xf;
+
+    zh = ctx->HH[lo];
+    zl = ctx->HL[lo];
+
+    for (i = 15; i >= 0; i--)
+    {
+        lo = x[i] & 0xf;
+        hi = x[i] >> 4;
+
+        if (i != 15)
+        {
+            rem = (unsigned char) zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4);
+            zh ^= (uint64_t) last4[rem] << 48;
+            zh ^= ctx->HH[lo];
+            zl ^= ctx->HL[lo];
+        }
+
+        rem = (unsigned char) zl & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4);
+        zh ^= (uint64_t) last4[rem] << 48;
+        zh ^= ctx->HH[hi];
+        zl ^= ctx->HL[hi];
+    }
+
+    PUT_UINT32_BE(zh >> 32, output, 0);
+    PUT_UINT32_BE(zh, output, 4);
+    PUT_UINT32_BE(zl >> 32, output, 8);
+    PUT_UINT32_BE(zl, output, 12);
+}
+
+/*
+ * Fold data into the GHASH accumulator, 16 bytes at a time; a trailing partial block is
+ * zero padded as in library/gcm.c.
+ */
+static void gcm_ghash(mbedtls_gcm_context *ctx, const unsigned char *data, size_t length)
+{
+    size_t i, use_len;
+
+    while (length > 0)
+    {
+        use_len = (length < 16) ? length : 16;
+
+        for (i = 0; i < use_len; i++)
+            ctx->buf[i] ^= data[i];
+
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+
+        length -= use_len;
+        data += use_len;
+    }
+}
+
+/*
+ * Counter mode for ciphers without a batched path: one cipher call per block.
+ */
+static int gcm_ctr_blocks(mbedtls_gcm_context *ctx, size_t length,
+                          const unsigned char *input, unsigned char *output)
+{
+    int ret;
+    unsigned char ectr[16];
+    size_t i, use_len, olen = 0;
+
+    while (length > 0)
+    {
+        use_len = (length < 16) ? length : 16;
+
+        for (i = 16; i > 12; i--)
+            if (++ctx->y[i - 1] != 0)
+                break;
+
+        if ((ret = mbedtls_cipher_update(&ctx->cipher_ctx, ctx->y, 16, ectr, &olen)) != 0)
+            return ret;
+
+        for (i = 0; i < use_len; i++)
+            output[i] = ectr[i] ^ input[i];
+
+        length -= use_len;
+        input += use_len;
+        output += use_len;
+    }
+    return 0;
+}
+
+void mbedtls_gcm_init( mbedtls_gcm_context *ctx )
+{
+    memset( ctx, 0, sizeof( mbedtls_gcm_context ) );
+}
+
+int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
+                        mbedtls_cipher_id_t cipher,
+                        const unsigned char *key,
+                        unsigned int keybits )
+{
+    int ret;
+    const mbedtls_cipher_info_t *cipher_info;
+
+    cipher_info = mbedtls_cipher_info_from_values( cipher, keybits, MBEDTLS_MODE_ECB );
+    if( cipher_info == NULL )
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+
+    if( cipher_info->block_size != 16 )
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+
+    mbedtls_cipher_free( &ctx->cipher_ctx );
+
+    if( ( ret = mbedtls_cipher_setup( &ctx->cipher_ctx, cipher_info ) ) != 0 )
+        return( ret );
+
+    if( ( ret = mbedtls_cipher_setkey( &ctx->cipher_ctx, key, keybits,
+                                       MBEDTLS_ENCRYPT ) ) != 0 )
+    {
+        return( ret );
+    }
+
+    /* The AES wrapper keeps a plain mbedtls_aes_context in cipher_ctx.cipher_ctx */
+    ctx->is_aes = ( cipher == MBEDTLS_CIPHER_ID_AES );
+
+    return( gcm_gen_table( ctx ) );
+}
+
+int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
+                        int mode,
+                        const unsigned char *iv,
+                        size_t iv_len,
+                        const unsigned char *add,
+                        size_t add_len )
+{
+    int ret;
+    unsigned char work_buf[16];
+    size_t olen = 0;
+
+    /* IV and AD are limited to 2^64 bits, so 2^61 bytes */
+    /* IV is not allowed to be zero length */
+    if( iv_len == 0 ||
+        ( (uint64_t) iv_len  ) >> 61 != 0 ||
+        ( (uint64_t) add_len ) >> 61 != 0 )
+    {
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+    }
+
+    memset( ctx->y, 0x00, sizeof( ctx->y ) );
+    memset( ctx->buf, 0x00, sizeof( ctx->buf ) );
+
+    ctx->mode = mode;
+    ctx->len = 0;
+    ctx->add_len = 0;
+
+    if( iv_len == 12 )
+    {
+        memcpy( ctx->y, iv, iv_len );
+        ctx->y[15] = 1;
+    }
+    else
+    {
+        /* y = GHASH(IV || 0-pad || [len(IV)]64), accumulated in the still empty buf */
+        gcm_ghash( ctx, iv, iv_len );
+        memset( work_buf, 0x00, 16 );
+        PUT_UINT32_BE( iv_len * 8, work_buf, 12 );
+        gcm_ghash( ctx, work_buf, 16 );
+
+        memcpy( ctx->y, ctx->buf, 16 );
+        memset( ctx->buf, 0x00, 16 );
+    }
+
+    if( ( ret = mbedtls_cipher_update( &ctx->cipher_ctx, ctx->y, 16, ctx->base_ectr,
+                                       &olen ) ) != 0 )
+    {
+        return( ret );
+    }
+
+    ctx->add_len = add_len;
+    gcm_ghash( ctx, add, add_len );
+
+    return( 0 );
+}
+
+int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
+                        size_t length,
+                        const unsigned char *input,
+                        unsigned char *output )
+{
+    int ret;
+    size_t use_len;
+
+    if( output > input && (size_t) ( output - input ) < length )
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+
+    /* Total length is restricted to 2^39 - 256 bits, ie 2^36 - 2^5 bytes
+     * Also check for possible overflow */
+    if( ctx->len + length < ctx->len ||
+        (uint64_t) ctx->len + length > 0xFFFFFFFE0ull )
+    {
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+    }
+
+    ctx->len += length;
+
+    while( length > 0 )
+    {
+        use_len = ( length < NU_AES_DMA_BUF_SIZE ) ? length : NU_AES_DMA_BUF_SIZE;
+
+        /* Hash the cipher text before it may be overwritten in place */
+        if( ctx->mode == MBEDTLS_GCM_DECRYPT )
+            gcm_ghash( ctx, input, use_len );
+
+        if( ctx->is_aes )
+            ret = nu_aes_crypt_ctr32( (mbedtls_aes_context *) ctx->cipher_ctx.cipher_ctx,
+                                      use_len, ctx->y, input, output );
+        else
+            ret = gcm_ctr_blocks( ctx, use_len, input, output );
+        if( ret != 0 )
+            return( ret );
+
+        if( ctx->mode == MBEDTLS_GCM_ENCRYPT )
+            gcm_ghash( ctx, output, use_len );
+
+        length -= use_len;
+        input += use_len;
+        output += use_len;
+    }
+
+    return( 0 );
+}
+
+int mbedtls_gcm_finish( mbedtls_gcm_context *ctx,
+                        unsigned char *tag,
+                        size_t tag_len )
+{
+    unsigned char work_buf[16];
+    size_t i;
+    uint64_t orig_len = ctx->len * 8;
+    uint64_t orig_add_len = ctx->add_len * 8;
+
+    if( tag_len > 16 || tag_len < 4 )
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+
+    memcpy( tag, ctx->base_ectr, tag_len );
+
+    if( orig_len || orig_add_len )
+    {
+        memset( work_buf, 0x00, 16 );
+
+        PUT_UINT32_BE( ( orig_add_len >> 32 ), work_buf, 0  );
+        PUT_UINT32_BE( ( orig_add_len       ), work_buf, 4  );
+        PUT_UINT32_BE( ( orig_len     >> 32 ), work_buf, 8  );
+        PUT_UINT32_BE( ( orig_len           ), work_buf, 12 );
+
+        for( i = 0; i < 16; i++ )
+            ctx->buf[i] ^= work_buf[i];
+
+        gcm_mult( ctx, ctx->buf, ctx->buf );
+
+        for( i = 0; i < tag_len; i++ )
+            tag[i] ^= ctx->buf[i];
+    }
+
+    return( 0 );
+}
+
+int mbedtls_gcm_crypt_and_tag( mbedtls_gcm_context *ctx,
+                               int mode,
+                               size_t length,
+                               const unsigned char *iv,
+                               size_t iv_len,
+                               const unsigned char *add,
+                               size_t add_len,
+                               const unsigned char *input,
+                               unsigned char *output,
+                               size_t tag_len,
+                               unsigned char *tag )
+{
+    int ret;
+
+    if( ( ret = mbedtls_gcm_starts( ctx, mode, iv, iv_len, add, add_len ) ) != 0 )
+        return( ret );
+
+    if( ( ret = mbedtls_gcm_update( ctx, length, input, output ) ) != 0 )
+        return( ret );
+
+    return( mbedtls_gcm_finish( ctx, tag, tag_len ) );
+}
+
+int mbedtls_gcm_auth_decrypt( mbedtls_gcm_context *ctx,
+                              size_t length,
+                              const unsigned char *iv,
+                              size_t iv_len,
+                              const unsigned char *add,
+                              size_t add_len,
+                              const unsigned char *tag,
+                              size_t tag_len,
+                              const unsigned char *input,
+                              unsigned char *output )
+{
+    int ret;
+    unsigned char check_tag[16];
+    size_t i;
+    int diff;
+
+    if( ( ret = mbedtls_gcm_crypt_and_tag( ctx, MBEDTLS_GCM_DECRYPT, length,
+                                           iv, iv_len, add, add_len,
+                                           input, output, tag_len, check_tag ) ) != 0 )
+    {
+        return( ret );
+    }
+
+    /* Check tag in "constant-time" */
+    for( diff = 0, i = 0; i < tag_len; i++ )
+        diff |= tag[i] ^ check_tag[i];
+
+    if( diff != 0 )
+    {
+        mbedtls_platform_zeroize( output, length );
+        return( MBEDTLS_ERR_GCM_AUTH_FAILED );
+    }
+
+    return( 0 );
+}
+
+void mbedtls_gcm_free( mbedtls_gcm_context *ctx )
+{
+    mbedtls_cipher_free( &ctx->cipher_ctx );
+    mbedtls_platform_zeroize( ctx, sizeof( mbedtls_gcm_context ) );
+}
+
+#endif /* MBEDTLS_GCM_C && MBEDTLS_GCM_ALT */
@@ -0,0 +1,26 @@
+/**
+    @file       gcm_alt.h
+    @brief  GCM context for MBEDTLS_GCM_ALT, batching the AES-CTR blocks on the M480 crypto engine
+*/
+#ifndef __GCM_ALT_H__
+#define __GCM_ALT_H__
+
+#include <stdint.h>
+#include "mbedtls/cipher.h"
+
+typedef struct mbedtls_gcm_context
+{
+    mbedtls_cipher_context_t cipher_ctx;  /*!< The cipher context used. */
+    uint64_t HL[16];                      /*!< Precalculated HTable low. */
+    uint64_t HH[16];                      /*!< Precalculated HTable high. */
+    uint64_t len;                         /*!< The total length of the encrypted data. */
+    uint64_t add_len;                     /*!< The total length of the additional data. */
+    unsigned char base_ectr[16];          /*!< The first ECTR for tag. */
+    unsigned char y[16];                  /*!< The Y working value. */
+    unsigned char buf[16];                /*!< The buf working value. */
+    int mode;                             /*!< MBEDTLS_GCM_ENCRYPT or MBEDTLS_GCM_DECRYPT */
+    int is_aes;                           /*!< 1: cipher_ctx is an aes_alt.c context */
+}
+mbedtls_gcm_context;
+
+#endif
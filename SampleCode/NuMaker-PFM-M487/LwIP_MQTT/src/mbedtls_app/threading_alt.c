@@ -17,10 +17,32 @@ static void threading_alt_mutex_free(mbedtls_threading_mutex_t * m);
 static int threading_alt_mutex_lock(mbedtls_threading_mutex_t * m);
 static int threading_alt_mutex_unlock(mbedtls_threading_mutex_t * m);
 
+static mbedtls_threading_mutex_t crypto_lock;
+
 void threading_alt_init()
 {
     mbedtls_threading_set_alt(threading_alt_mutex_init, threading_alt_mutex_free, threading_alt_mutex_lock,
                               threading_alt_mutex_unlock);
+    if(crypto_lock == NULL)
+    {
+        threading_alt_mutex_init(&crypto_lock);
+    }
+}
+
+void nu_crypto_lock()
+{
+    if(crypto_lock)
+    {
+        threading_alt_mutex_lock(&crypto_lock);
+    }
+}
+
+void nu_crypto_unlock()
+{
+    if(crypto_lock)
+    {
+        threading_alt_mutex_unlock(&crypto_lock);
+    }
 }
 
 static void threading_alt_mutex_init(mbedtls_threading_mutex_t * m)
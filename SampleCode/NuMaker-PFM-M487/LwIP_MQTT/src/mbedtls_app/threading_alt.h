@@ -24,4 +24,20 @@ typedef void * mbedtls_threading_mutex_t;
 	@note		Call this function before starting to work on mbedtls, called from lwip_tls_init.
 */
 void threading_alt_init(void);
+
+/**
+	@fn			nu_crypto_lock
+	@brief	take exclusive use of the crypto engine, its DMA buffers and g_Crypto_Int_done.
+
+	@see		nu_crypto_unlock
+	@note		Held by aes_alt.c and ecp_alt.c around each engine operation. Calls must not
+					nest. Does nothing until threading_alt_init has run.
+*/
+void nu_crypto_lock(void);
+
+/**
+	@fn			nu_crypto_unlock
+	@brief	release the crypto engine taken by nu_crypto_lock.
+*/
+void nu_crypto_unlock(void);
 #endif
@@ -66,4 +66,7 @@
 
 #define MEM_SIZE                        10000
 
+#define LWIP_SUPPORT_CUSTOM_PBUF        1
+#define ETH_ZERO_COPY                   1   /* Rx/Tx frames are passed without copy, see m480_eth.h */
+
 #endif /* __LWIPOPTS_H__ */
@@ -67,8 +67,37 @@
 #define ADVERTISE_LPACK         0x4000  /* Ack link partners response  */
 #define ADVERTISE_NPAGE         0x8000  /* Next page bit               */
 
+// Descriptor ring depth, could be overridden in lwipopts.h
+#ifndef RX_DESCRIPTOR_NUM
 #define RX_DESCRIPTOR_NUM 4    // Max Number of Rx Frame Descriptors
+#endif
+#ifndef TX_DESCRIPTOR_NUM
 #define TX_DESCRIPTOR_NUM 4    // Max number of Tx Frame Descriptors
+#endif
+
+// Set ETH_ZERO_COPY to 1 in lwipopts.h to pass Rx descriptor buffers to lwIP as
+// custom pbufs, and to transmit single, word aligned pbufs from their payload directly.
+// A descriptor handing its buffer to lwIP takes one of ETH_RX_SPARE_NUM spare buffers, so the
+// Rx ring never shrinks. Frames arriving while all spare buffers are with lwIP are copied.
+#ifndef ETH_ZERO_COPY
+#define ETH_ZERO_COPY 0
+#endif
+#ifndef ETH_RX_SPARE_NUM
+#define ETH_RX_SPARE_NUM 8    // Rx buffers lwIP could hold at the same time without copy
+#endif
+
+// Multicast filter for the groups lwIP joins through igmp_mac_filter/mld_mac_filter.
+// Joined groups take CAM entries 1~12 (entry 0 is our address, 13~15 are for PAUSE frames),
+// then EMAC only receives multicast frames of these groups. Once more groups are joined,
+// EMAC receives all multicast frames again and Rx ISR drops the ones not matching a 64 bucket
+// hash of the groups before they are copied into a pbuf.
+// Without IGMP and MLD all multicast frames are received as before.
+#ifndef ETH_MCAST_FILTER
+#define ETH_MCAST_FILTER (LWIP_IGMP || (LWIP_IPV6 && LWIP_IPV6_MLD))
+#endif
+#ifndef ETH_MCAST_TABLE_SIZE
+#define ETH_MCAST_TABLE_SIZE 24    // Groups tracked to move into a CAM entry when one is freed, more groups stay in the hash only
+#endif
 
 #define PACKET_BUFFER_SIZE  1520
 
@@ -124,8 +153,25 @@ void ETH_setinc(void);
 
 #endif
 
+// Frames dropped by Rx ISR before they reach lwIP
+struct eth_rx_drop_stats
+{
+    u32_t mcast;    // Multicast frames of groups not joined, counted only while the hash filter is in use
+    u32_t vlan;     // VLAN tagged frames lwIP would drop, see ETHARP_SUPPORT_VLAN and ETHARP_VLAN_CHECK
+    u32_t type;     // Frames of an EtherType lwIP doesn't handle
+};
+
 extern void ETH_init(u8_t *mac_addr);
 extern u8_t *ETH_get_tx_buf(void);
 extern void ETH_trigger_tx(u16_t length, struct pbuf *p);
+#if ETH_ZERO_COPY
+extern struct pbuf *ETH_get_rx_pbuf(u16_t length);
+extern s32_t ETH_trigger_tx_pbuf(struct pbuf *p);
+extern void ETH_tx_reclaim(void);
+#endif
+#if ETH_MCAST_FILTER
+extern s32_t ETH_mcast_filter(const u8_t *addr, u8_t add);
+#endif
+extern void ETH_get_rx_drop_stats(struct eth_rx_drop_stats *stats, u8_t clear);
 
 #endif  /* _M480_ETH_ */
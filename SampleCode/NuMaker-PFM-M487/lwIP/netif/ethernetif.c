@@ -77,6 +77,60 @@ struct ethernetif
 };
 
 
+#if ETH_MCAST_FILTER && LWIP_IPV4 && LWIP_IGMP
+/**
+ * Add or remove the MAC address of an IPv4 multicast group to the EMAC Rx filter.
+ * 01:00:5E followed by the lower 23 bits of the group address.
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ * @param group the IPv4 multicast group
+ * @param action NETIF_ADD_MAC_FILTER or NETIF_DEL_MAC_FILTER
+ * @return ERR_OK or the error of ETH_mcast_filter()
+ */
+static err_t
+igmp_mac_filter(struct netif *netif, const ip4_addr_t *group, enum netif_mac_filter_action action)
+{
+    u8_t addr[6];
+    u32_t ip = lwip_ntohl(ip4_addr_get_u32(group));
+
+    addr[0] = 0x01;
+    addr[1] = 0x00;
+    addr[2] = 0x5E;
+    addr[3] = (ip >> 16) & 0x7F;
+    addr[4] = (ip >> 8) & 0xFF;
+    addr[5] = ip & 0xFF;
+
+    return (err_t)ETH_mcast_filter(addr, action == NETIF_ADD_MAC_FILTER);
+}
+#endif
+
+#if ETH_MCAST_FILTER && LWIP_IPV6 && LWIP_IPV6_MLD
+/**
+ * Add or remove the MAC address of an IPv6 multicast group to the EMAC Rx filter.
+ * 33:33 followed by the last 32 bits of the group address.
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ * @param group the IPv6 multicast group
+ * @param action NETIF_ADD_MAC_FILTER or NETIF_DEL_MAC_FILTER
+ * @return ERR_OK or the error of ETH_mcast_filter()
+ */
+static err_t
+mld_mac_filter(struct netif *netif, const ip6_addr_t *group, enum netif_mac_filter_action action)
+{
+    u8_t addr[6];
+    u32_t ip = lwip_ntohl(group->addr[3]);
+
+    addr[0] = 0x33;
+    addr[1] = 0x33;
+    addr[2] = (ip >> 24) & 0xFF;
+    addr[3] = (ip >> 16) & 0xFF;
+    addr[4] = (ip >> 8) & 0xFF;
+    addr[5] = ip & 0xFF;
+
+    return (err_t)ETH_mcast_filter(addr, action == NETIF_ADD_MAC_FILTER);
+}
+#endif
+
 /**
  * In this function, the hardware should be initialized.
  * Called from ethernetif_init().
@@ -104,11 +158,24 @@ low_level_init(struct netif *netif)
 
     /* device capabilities */
     netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
-#ifdef LWIP_IGMP
+#if LWIP_IGMP
     netif->flags |= NETIF_FLAG_IGMP;
+#endif
+#if ETH_MCAST_FILTER && LWIP_IPV4 && LWIP_IGMP
+    netif_set_igmp_mac_filter(netif, igmp_mac_filter);
+#endif
+#if ETH_MCAST_FILTER && LWIP_IPV6 && LWIP_IPV6_MLD
+    netif_set_mld_mac_filter(netif, mld_mac_filter);
 #endif
     // TODO: enable clock & configure GPIO function
     ETH_init(netif->hwaddr);
+#if ETH_MCAST_FILTER && LWIP_IPV6 && LWIP_IPV6_MLD
+    {
+        /* lwIP never joins the all-nodes group FF02::1 through mld_mac_filter */
+        static const u8_t allnodes[6] = {0x33, 0x33, 0x00, 0x00, 0x00, 0x01};
+        ETH_mcast_filter(allnodes, 1);
+    }
+#endif
 }
 
 /**
@@ -134,6 +201,22 @@ low_level_output(struct netif *netif, struct pbuf *p)
     u8_t *buf = NULL;
     u16_t len = 0;
 
+#if ETH_ZERO_COPY
+    ETH_tx_reclaim();
+
+    /* Single pbuf owned by lwIP could be sent by EMAC DMA without copy.
+       Chained or application referenced (ROM/REF) pbufs are copied below. */
+    if((p->next == NULL) &&
+            ((p->type == PBUF_RAM) || (p->type == PBUF_POOL)) &&
+            (((u32_t)p->payload & 3) == 0))
+    {
+        if(ETH_trigger_tx_pbuf(p) != ERR_OK)
+            return ERR_MEM;
+
+        LINK_STATS_INC(link.xmit);
+        return ERR_OK;
+    }
+#endif
 
     buf = ETH_get_tx_buf();
     if(buf == NULL)
@@ -175,6 +258,17 @@ low_level_input(struct netif *netif, u16_t len, u8_t *buf)
 {
     struct pbuf *p, *q;
 
+#if ETH_ZERO_COPY
+    /* Hand the Rx descriptor buffer to lwIP, it becomes a spare buffer in pbuf_free().
+       The frame is copied below if no spare buffer is left. */
+    p = ETH_get_rx_pbuf(len);
+    if (p != NULL)
+    {
+        LINK_STATS_INC(link.recv);
+        return p;
+    }
+#endif
+
 #if ETH_PAD_SIZE
     len += ETH_PAD_SIZE; /* allow room for Ethernet padding */
 #endif
@@ -249,6 +343,12 @@ ethernetif_input(u16_t len, u8_t *buf, u32_t s, u32_t ns)
     /* IP or ARP packet? */
     case ETHTYPE_IP:
     case ETHTYPE_ARP:
+#if LWIP_IPV6
+    case ETHTYPE_IPV6:
+#endif /* LWIP_IPV6 */
+#if ETHARP_SUPPORT_VLAN
+    case ETHTYPE_VLAN:
+#endif /* ETHARP_SUPPORT_VLAN */
 #if PPPOE_SUPPORT
     /* PPPoE packet? */
     case ETHTYPE_PPPOEDISC:
@@ -284,6 +384,12 @@ ethernetif_loopback_input(struct pbuf *p)           // TODO: make sure packet no
     /* IP or ARP packet? */
     case ETHTYPE_IP:
     case ETHTYPE_ARP:
+#if LWIP_IPV6
+    case ETHTYPE_IPV6:
+#endif /* LWIP_IPV6 */
+#if ETHARP_SUPPORT_VLAN
+    case ETHTYPE_VLAN:
+#endif /* ETHARP_SUPPORT_VLAN */
 #if PPPOE_SUPPORT
     /* PPPoE packet? */
     case ETHTYPE_PPPOEDISC:
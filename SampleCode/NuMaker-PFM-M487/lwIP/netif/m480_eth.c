@@ -2,6 +2,9 @@
  * Copyright (c) 2016 Nuvoton Technology Corp.
  * Description:   M480 EMAC driver file
  */
+#include <string.h>
+#include "lwip/sys.h"
+#include "lwip/prot/ethernet.h"
 #include "netif/m480_eth.h"
 #include "arch/sys_arch.h"
 
@@ -22,9 +25,31 @@ struct eth_descriptor tx_desc[TX_DESCRIPTOR_NUM] __attribute__ ((aligned(4)));
 #endif
 struct eth_descriptor volatile *cur_tx_desc_ptr, *cur_rx_desc_ptr, *fin_tx_desc_ptr;
 
-u8_t rx_buf[RX_DESCRIPTOR_NUM][PACKET_BUFFER_SIZE];
+#if ETH_ZERO_COPY
+#define RX_BUFFER_NUM   (RX_DESCRIPTOR_NUM + ETH_RX_SPARE_NUM)
+#else
+#define RX_BUFFER_NUM   RX_DESCRIPTOR_NUM
+#endif
+
+u8_t rx_buf[RX_BUFFER_NUM][PACKET_BUFFER_SIZE];
 u8_t tx_buf[TX_DESCRIPTOR_NUM][PACKET_BUFFER_SIZE];
 
+#if ETH_ZERO_COPY
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error "ETH_ZERO_COPY requires LWIP_SUPPORT_CUSTOM_PBUF"
+#endif
+#if defined(TIME_STAMPING) || ETH_PAD_SIZE
+#error "ETH_ZERO_COPY does not support TIME_STAMPING or ETH_PAD_SIZE"
+#endif
+
+// Rx buffer lent to lwIP. The descriptor takes a spare buffer in exchange and stays in the ring,
+// the lent buffer becomes a spare one while the pbuf is freed.
+static struct pbuf_custom rx_pbuf[RX_BUFFER_NUM];
+static u8_t rx_spare[ETH_RX_SPARE_NUM];     // indexes of spare buffers in rx_buf
+static volatile u32_t rx_spare_cnt;
+static struct pbuf *tx_pbuf[TX_DESCRIPTOR_NUM];  // pbuf transmitted without copy, freed by ETH_tx_reclaim()
+#endif
+
 extern void ethernetif_input(u16_t len, u8_t *buf, u32_t s, u32_t ns);
 extern void ethernetif_loopback_input(struct pbuf *p);
 
@@ -152,6 +177,9 @@ static void init_tx_desc(void)
 #ifdef    TIME_STAMPING
         tx_desc[i].backup1 = (u32_t)tx_desc[i].buf;
         tx_desc[i].backup2 = (u32_t)tx_desc[i].next;
+#endif
+#if ETH_ZERO_COPY
+        tx_pbuf[i] = NULL;
 #endif
     }
     EMAC->TXDSA = (unsigned int)&tx_desc[0];
@@ -176,24 +204,287 @@ static void init_rx_desc(void)
         rx_desc[i].backup2 = (u32_t)rx_desc[i].next;
 #endif
     }
+#if ETH_ZERO_COPY
+    for(i = 0; i < ETH_RX_SPARE_NUM; i++)
+        rx_spare[i] = RX_DESCRIPTOR_NUM + i;
+    rx_spare_cnt = ETH_RX_SPARE_NUM;
+#endif
     EMAC->RXDSA = (unsigned int)&rx_desc[0];
     return;
 }
 
-static void set_mac_addr(u8_t *addr)
+static void set_cam_entry(u32_t entry, const u8_t *addr)
+{
+    volatile uint32_t *cam = &EMAC->CAM0M + entry * 2;
+
+    cam[0] = (addr[0] << 24) |
+             (addr[1] << 16) |
+             (addr[2] << 8) |
+             addr[3];
+
+    cam[1] = (addr[4] << 24) |
+             (addr[5] << 16);
+}
+
+#if ETH_MCAST_FILTER
+
+#define MCAST_CAM_FIRST     1       // CAM entries of multicast groups
+#define MCAST_CAM_LAST      12
+#define MCAST_HASH_SIZE     64
+
+// Joined group. Different IP groups may share a MAC address, so it's reference counted.
+struct eth_mcast
+{
+    u8_t addr[6];
+    u8_t cam;       // CAM entry, 0: none
+    u8_t ref;
+};
+
+// Only the lwIP thread changes them, Rx ISR reads mcast_hash and mcast_overflow only
+static struct eth_mcast mcast_tab[ETH_MCAST_TABLE_SIZE];
+static u16_t mcast_hash[MCAST_HASH_SIZE];   // groups per bucket, all groups are in it
+static u32_t mcast_cam_used;                // bit map of CAM entries in use
+static u32_t mcast_untracked;               // groups not fitting in mcast_tab
+static volatile u32_t mcast_overflow;       // groups without CAM entry, Rx ISR checks the hash if not 0
+
+// Bucket of a multicast address, top 6 bits of its Ethernet CRC
+static u32_t mcast_hash_index(const u8_t *addr)
+{
+    u32_t crc = 0xFFFFFFFF;
+    u32_t i, j;
+
+    for(i = 0; i < 6; i++)
+    {
+        crc ^= addr[i];
+        for(j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return(crc >> 26);
+}
+
+static u32_t mcast_alloc_cam(void)
+{
+    u32_t i;
+
+    for(i = MCAST_CAM_FIRST; i <= MCAST_CAM_LAST; i++)
+    {
+        if(!(mcast_cam_used & (1 << i)))
+        {
+            mcast_cam_used |= (1 << i);
+            return(i);
+        }
+    }
+    return(0);
+}
+
+// EMAC receives all multicast frames while a group has no CAM entry
+static void mcast_update_camctl(void)
+{
+    if(mcast_overflow)
+        EMAC->CAMCTL |= EMAC_CAMCTL_AMP_Msk;
+    else
+        EMAC->CAMCTL &= ~EMAC_CAMCTL_AMP_Msk;
+}
+
+/**
+ * Add or remove a multicast address from the Rx filter.
+ * Called by the igmp_mac_filter and mld_mac_filter functions of the netif.
+ *
+ * @param addr multicast MAC address
+ * @param add 1 to add, 0 to remove
+ * @return ERR_OK, ERR_VAL if the address to remove was never added
+ */
+s32_t ETH_mcast_filter(const u8_t *addr, u8_t add)
 {
+    struct eth_mcast *m = NULL, *free_m = NULL;
+    u32_t i, bucket = mcast_hash_index(addr);
+
+    for(i = 0; i < ETH_MCAST_TABLE_SIZE; i++)
+    {
+        if(mcast_tab[i].ref == 0)
+        {
+            if(free_m == NULL)
+                free_m = &mcast_tab[i];
+        }
+        else if(memcmp(mcast_tab[i].addr, addr, 6) == 0)
+        {
+            m = &mcast_tab[i];
+            break;
+        }
+    }
+
+    if(add)
+    {
+        if(m != NULL)
+        {
+            m->ref++;
+            return ERR_OK;
+        }
+
+        // Hash first, Rx ISR checks it as soon as EMAC accepts all multicast frames
+        mcast_hash[bucket]++;
+        if(free_m != NULL)
+        {
+            memcpy(free_m->addr, addr, 6);
+            free_m->ref = 1;
+            free_m->cam = mcast_alloc_cam();
+            if(free_m->cam)
+            {
+                set_cam_entry(free_m->cam, addr);
+                EMAC->CAMEN |= (1 << free_m->cam);
+            }
+            else
+                mcast_overflow++;
+        }
+        else
+        {
+            mcast_untracked++;
+            mcast_overflow++;
+        }
+    }
+    else
+    {
+        if(m == NULL)
+        {
+            // lwIP removes only what it added, so it must be a group in the hash only
+            if(mcast_untracked == 0)
+                return ERR_VAL;
+            mcast_untracked--;
+            mcast_overflow--;
+        }
+        else
+        {
+            if(--m->ref)
+                return ERR_OK;
+
+            if(m->cam)
+            {
+                EMAC->CAMEN &= ~(1 << m->cam);
+                // Hand the CAM entry to a group waiting for one
+                for(i = 0; i < ETH_MCAST_TABLE_SIZE; i++)
+                {
+                    if(mcast_tab[i].ref && (mcast_tab[i].cam == 0))
+                    {
+                        mcast_tab[i].cam = m->cam;
+                        set_cam_entry(m->cam, mcast_tab[i].addr);
+                        EMAC->CAMEN |= (1 << m->cam);
+                        mcast_overflow--;
+                        break;
+                    }
+                }
+                if(i == ETH_MCAST_TABLE_SIZE)
+                    mcast_cam_used &= ~(1 << m->cam);
+                m->cam = 0;
+            }
+            else
+                mcast_overflow--;
+        }
+        mcast_hash[bucket]--;
+    }
+
+    mcast_update_camctl();
+
+    return ERR_OK;
+}
 
-    EMAC->CAM0M = (addr[0] << 24) |
-                  (addr[1] << 16) |
-                  (addr[2] << 8) |
-                  addr[3];
+#endif
+
+static void set_mac_addr(u8_t *addr)
+{
+#if ETH_MCAST_FILTER
+    u32_t i;
+#endif
 
-    EMAC->CAM0L = (addr[4] << 24) |
-                  (addr[5] << 16);
+    set_cam_entry(0, addr);
 
     EMAC->CAMCTL = EMAC_CAMCTL_CMPEN_Msk | EMAC_CAMCTL_AMP_Msk | EMAC_CAMCTL_ABP_Msk;
     EMAC->CAMEN = 1;    // Enable CAM entry 0
 
+#if ETH_MCAST_FILTER
+    // Restore joined groups after EMAC reset
+    for(i = 0; i < ETH_MCAST_TABLE_SIZE; i++)
+    {
+        if(mcast_tab[i].ref && mcast_tab[i].cam)
+        {
+            set_cam_entry(mcast_tab[i].cam, mcast_tab[i].addr);
+            EMAC->CAMEN |= (1 << mcast_tab[i].cam);
+        }
+    }
+    mcast_update_camctl();
+#endif
+}
+
+static struct eth_rx_drop_stats rx_drop;
+
+// Check a received frame before it's copied into a pbuf. Return 0 to drop it.
+static int rx_accept(const u8_t *buf, u16_t len)
+{
+    u16_t type;
+
+    if(len < 14)
+    {
+        rx_drop.type++;
+        return(0);
+    }
+
+#if ETH_MCAST_FILTER
+    // Group addresses have bit 0 of the first byte set, broadcast passes the check
+    if(mcast_overflow && (buf[0] & 1) &&
+            ((buf[0] & buf[1] & buf[2] & buf[3] & buf[4] & buf[5]) != 0xFF) &&
+            (mcast_hash[mcast_hash_index(buf)] == 0))
+    {
+        rx_drop.mcast++;
+        return(0);
+    }
+#endif
+
+    type = (buf[12] << 8) | buf[13];
+    switch(type)
+    {
+    case ETHTYPE_IP:
+    case ETHTYPE_ARP:
+#if LWIP_IPV6
+    case ETHTYPE_IPV6:
+#endif
+#if PPPOE_SUPPORT
+    case ETHTYPE_PPPOEDISC:
+    case ETHTYPE_PPPOE:
+#endif
+        return(1);
+
+    case ETHTYPE_VLAN:
+#if ETHARP_SUPPORT_VLAN
+#ifdef ETHARP_VLAN_CHECK
+        if((len >= 18) && ((((buf[14] << 8) | buf[15]) & 0xFFF) == ETHARP_VLAN_CHECK))
+            return(1);
+#else
+        return(1);
+#endif
+#endif
+        rx_drop.vlan++;
+        return(0);
+
+    default:
+        rx_drop.type++;
+        return(0);
+    }
+}
+
+/**
+ * Read the counters of frames dropped before they reach lwIP.
+ *
+ * @param stats where to store the counters
+ * @param clear 1 to clear the counters after reading
+ */
+void ETH_get_rx_drop_stats(struct eth_rx_drop_stats *stats, u8_t clear)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    *stats = rx_drop;
+    if(clear)
+        memset(&rx_drop, 0, sizeof(rx_drop));
+    SYS_ARCH_UNPROTECT(lev);
 }
 
 
@@ -267,7 +558,9 @@ void EMAC_RX_IRQHandler(void)
                 cur_rx_desc_ptr->next = (struct eth_descriptor *)fin_tx_desc_ptr->backup2;
             }
 #endif
-            ethernetif_input(status & 0xFFFF, cur_rx_desc_ptr->buf, cur_rx_desc_ptr->status2, (u32_t)cur_rx_desc_ptr->next);
+            // Frames lwIP would drop never take a pbuf
+            if(rx_accept(cur_rx_desc_ptr->buf, status & 0xFFFF))
+                ethernetif_input(status & 0xFFFF, cur_rx_desc_ptr->buf, cur_rx_desc_ptr->status2, (u32_t)cur_rx_desc_ptr->next);
 
 
         }
@@ -352,6 +645,75 @@ void ETH_trigger_tx(u16_t length, struct pbuf *p)
 
 }
 
+#if ETH_ZERO_COPY
+
+static void rx_pbuf_free(struct pbuf *p)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    rx_spare[rx_spare_cnt++] = (struct pbuf_custom *)p - rx_pbuf;
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+// Wrap current Rx descriptor buffer in a custom pbuf and give the descriptor a spare buffer.
+// Return NULL if no spare buffer is left, the caller copies the frame then. Must be called from Rx ISR only.
+struct pbuf *ETH_get_rx_pbuf(u16_t length)
+{
+    struct pbuf_custom *pc;
+    struct pbuf *p;
+
+    if(rx_spare_cnt == 0)
+        return(NULL);
+
+    pc = &rx_pbuf[(cur_rx_desc_ptr->buf - &rx_buf[0][0]) / PACKET_BUFFER_SIZE];
+    pc->custom_free_function = rx_pbuf_free;
+    p = pbuf_alloced_custom(PBUF_RAW, length, PBUF_REF, pc, cur_rx_desc_ptr->buf, PACKET_BUFFER_SIZE);
+    if(p != NULL)
+        cur_rx_desc_ptr->buf = &rx_buf[rx_spare[--rx_spare_cnt]][0];
+
+    return(p);
+}
+
+// Release pbufs of completed zero-copy transmission. Called from thread context, never from ISR.
+void ETH_tx_reclaim(void)
+{
+    u32_t i;
+
+    for(i = 0; i < TX_DESCRIPTOR_NUM; i++)
+    {
+        if((tx_pbuf[i] != NULL) && !(tx_desc[i].status1 & OWNERSHIP_EMAC))
+        {
+            tx_desc[i].buf = &tx_buf[i][0];
+            pbuf_free(tx_pbuf[i]);
+            tx_pbuf[i] = NULL;
+        }
+    }
+}
+
+// Transmit pbuf payload directly. pbuf is held until ETH_tx_reclaim() finds it sent.
+s32_t ETH_trigger_tx_pbuf(struct pbuf *p)
+{
+    u32_t i;
+
+    if(cur_tx_desc_ptr->status1 & OWNERSHIP_EMAC)
+        return ERR_MEM;
+
+    i = cur_tx_desc_ptr - tx_desc;
+    if(tx_pbuf[i] != NULL)
+    {
+        tx_desc[i].buf = &tx_buf[i][0];
+        pbuf_free(tx_pbuf[i]);
+    }
+    pbuf_ref(p);
+    tx_pbuf[i] = p;
+    cur_tx_desc_ptr->buf = (u8_t *)p->payload;
+    ETH_trigger_tx(p->len, NULL);
+
+    return ERR_OK;
+}
+
+#endif
 
 #ifdef TIME_STAMPING
 
@@ -0,0 +1,893 @@
+/**************************************************************************//**
+ * @file     can_queue.c
+ * @version  V1.00
+ * @brief    Interrupt-driven CAN message queue
+ *
+ * The queue owns all 32 message objects of one C_CAN controller and only
+ * touches the message RAM from CANQ_IRQHandler() or with the controller
+ * interrupt masked, so it drives the IF1 interface directly and needs none
+ * of the interface locking and busy-wait retries of the standard driver.
+ *
+ * Objects 0 ~ u32TxObjNum - 1 transmit. CANQ_Send() puts the frame into a
+ * software heap ordered like bus arbitration, and each free transmit object
+ * that keeps the loaded frames in priority order is loaded with the highest
+ * priority frame, ID, control and data in one interface transfer. The TX
+ * interrupt of an object reloads it and clears its pending flag in the same
+ * transfer. A frame waits behind at most one lower priority frame already
+ * loaded, and frames of one ID always leave in the order queued.
+ *
+ * The other objects receive. CANQ_SetFilters() compiles the filter list
+ * into groups, merging the closest filters when there are more filters than
+ * objects allow, and chains the objects of each group into one hardware
+ * FIFO. A new frame lands in the lowest free object of its FIFO, so the
+ * interrupt reads the FIFO as a ring from the object holding the oldest
+ * frame, using the NDAT registers to find the filled objects. Frames that a
+ * merged group let through but no listed filter matches are dropped there.
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+
+#include "can_queue.h"
+
+#define CANQ_IF                 0ul         /* message interface used by the queue */
+#define CANQ_IF_TIMEOUT         1000ul      /* a transfer takes a few CAN clocks */
+#define CANQ_ANY_ID             0xFFu       /* group accepting both ID types */
+#define CANQ_INT_MASK           (CAN_CON_IE_Msk | CAN_CON_SIE_Msk | CAN_CON_EIE_Msk)
+#define CANQ_FRAME_TAIL_BITS    13ul        /* CRC delimiter, ACK, EOF and intermission */
+
+/* Mask the controller interrupt; returns the enable bits to restore */
+static uint32_t CANQ_Lock(CAN_T *tCAN)
+{
+    uint32_t u32IntMask = tCAN->CON & CANQ_INT_MASK;
+
+    tCAN->CON = tCAN->CON & ~CANQ_INT_MASK;
+    return u32IntMask;
+}
+
+static void CANQ_Unlock(CAN_T *tCAN, uint32_t u32IntMask)
+{
+    tCAN->CON |= u32IntMask;
+}
+
+/* Start a transfer between the interface and message object u32Obj and wait for it */
+static int32_t CANQ_IfRun(CAN_T *tCAN, uint32_t u32Obj)
+{
+    uint32_t i;
+
+    tCAN->IF[CANQ_IF].CREQ = 1ul + u32Obj;
+    for (i = 0; i < CANQ_IF_TIMEOUT; i++)
+    {
+        if ((tCAN->IF[CANQ_IF].CREQ & CAN_IF_CREQ_BUSY_Msk) == 0)
+            return CANQ_OK;
+    }
+
+    return CANQ_ERR_IF;
+}
+
+static uint32_t CANQ_PopCount(uint32_t u32X)
+{
+    uint32_t u32Num = 0;
+
+    while (u32X)
+    {
+        u32X &= u32X - 1;
+        u32Num++;
+    }
+
+    return u32Num;
+}
+
+static uint32_t CANQ_LowestBit(uint32_t u32X)
+{
+    uint32_t u32Bit = 0;
+
+    while ((u32X & 1ul) == 0)
+    {
+        u32X >>= 1;
+        u32Bit++;
+    }
+
+    return u32Bit;
+}
+
+/* Frame order of bus arbitration: base ID, then SRR/RTR, IDE, extended ID and RTR. Lower wins. */
+static uint32_t CANQ_Key(const STR_CANMSG_T *psMsg)
+{
+    uint32_t u32Rtr = (psMsg->FrameType == CAN_REMOTE_FRAME) ? 1ul : 0ul;
+
+    if (psMsg->IdType == CAN_STD_ID)
+        return ((psMsg->Id & 0x7FFul) << 21) | (u32Rtr << 20);
+
+    return (((psMsg->Id >> 18) & 0x7FFul) << 21) | (1ul << 20) | (1ul << 19) |
+           ((psMsg->Id & 0x3FFFFul) << 1) | u32Rtr;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Frame length                                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+typedef struct
+{
+    uint32_t u32Crc;
+    uint32_t u32Last;
+    uint32_t u32Run;
+    uint32_t u32Stuff;
+} CANQ_BITS_T;
+
+/* Feed the u32Num low bits of u32Val, MSB first, through the CRC-15 and the bit stuffing rule */
+static void CANQ_PutBits(CANQ_BITS_T *psBits, uint32_t u32Val, uint32_t u32Num, uint32_t u32Crc)
+{
+    uint32_t u32Bit;
+
+    while (u32Num--)
+    {
+        u32Bit = (u32Val >> u32Num) & 1ul;
+
+        if (u32Crc)
+        {
+            u32Crc = u32Bit ^ ((psBits->u32Crc >> 14) & 1ul);
+            psBits->u32Crc = (psBits->u32Crc << 1) & 0x7FFFul;
+            if (u32Crc)
+                psBits->u32Crc ^= 0x4599ul;
+            u32Crc = 1;
+        }
+
+        if (u32Bit == psBits->u32Last)
+        {
+            if (++psBits->u32Run == 5)
+            {
+                /* The stuff bit is the complement and starts the next run */
+                psBits->u32Stuff++;
+                psBits->u32Last = u32Bit ^ 1ul;
+                psBits->u32Run = 1;
+            }
+        }
+        else
+        {
+            psBits->u32Last = u32Bit;
+            psBits->u32Run = 1;
+        }
+    }
+}
+
+/**
+  * @brief      Bits a frame occupies on the bus
+  * @param[in]  psMsg   Frame
+  * @return     Bits from SOF to the end of the intermission, stuff bits included
+  */
+uint32_t CANQ_FrameBits(const STR_CANMSG_T *psMsg)
+{
+    CANQ_BITS_T sBits;
+    uint32_t u32Rtr = (psMsg->FrameType == CAN_REMOTE_FRAME) ? 1ul : 0ul;
+    uint32_t u32Len = (psMsg->DLC > 8) ? 8 : psMsg->DLC;
+    uint32_t u32Bits, i;
+
+    sBits.u32Crc = 0;
+    sBits.u32Last = 2;
+    sBits.u32Run = 0;
+    sBits.u32Stuff = 0;
+
+    CANQ_PutBits(&sBits, 0, 1, 1);                                  /* SOF */
+    if (psMsg->IdType == CAN_STD_ID)
+    {
+        CANQ_PutBits(&sBits, psMsg->Id & 0x7FFul, 11, 1);
+        CANQ_PutBits(&sBits, u32Rtr << 2, 3, 1);                     /* RTR, IDE, r0 */
+        u32Bits = 15;
+    }
+    else
+    {
+        CANQ_PutBits(&sBits, (psMsg->Id >> 18) & 0x7FFul, 11, 1);
+        CANQ_PutBits(&sBits, 3, 2, 1);                              /* SRR, IDE */
+        CANQ_PutBits(&sBits, psMsg->Id & 0x3FFFFul, 18, 1);
+        CANQ_PutBits(&sBits, u32Rtr << 2, 3, 1);                     /* RTR, r1, r0 */
+        u32Bits = 35;
+    }
+    CANQ_PutBits(&sBits, psMsg->DLC & 0xFul, 4, 1);
+    u32Bits += 4;
+
+    if (!u32Rtr)
+    {
+        for (i = 0; i < u32Len; i++)
+            CANQ_PutBits(&sBits, psMsg->Data[i], 8, 1);
+        u32Bits += 8 * u32Len;
+    }
+
+    CANQ_PutBits(&sBits, sBits.u32Crc, 15, 0);
+
+    return u32Bits + 15 + sBits.u32Stuff + CANQ_FRAME_TAIL_BITS;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Transmission                                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+static int CANQ_TxBefore(const CANQ_TXENT_T *psA, const CANQ_TXENT_T *psB)
+{
+    if (psA->u32Key != psB->u32Key)
+        return psA->u32Key < psB->u32Key;
+
+    return (int32_t)(psA->u32Seq - psB->u32Seq) < 0;
+}
+
+static void CANQ_TxPush(CANQ_T *psQ, const STR_CANMSG_T *psMsg)
+{
+    CANQ_TXENT_T sEnt;
+    uint32_t i = psQ->u32TxNum++, p;
+
+    sEnt.sMsg = *psMsg;
+    sEnt.u32Key = CANQ_Key(psMsg);
+    sEnt.u32Seq = psQ->u32TxSeq++;
+
+    while (i)
+    {
+        p = (i - 1) / 2;
+        if (!CANQ_TxBefore(&sEnt, &psQ->asTx[p]))
+            break;
+        psQ->asTx[i] = psQ->asTx[p];
+        i = p;
+    }
+    psQ->asTx[i] = sEnt;
+}
+
+static void CANQ_TxPop(CANQ_T *psQ)
+{
+    CANQ_TXENT_T *psLast = &psQ->asTx[--psQ->u32TxNum];
+    uint32_t i = 0, c;
+
+    while ((c = 2 * i + 1) < psQ->u32TxNum)
+    {
+        if ((c + 1 < psQ->u32TxNum) && CANQ_TxBefore(&psQ->asTx[c + 1], &psQ->asTx[c]))
+            c++;
+        if (!CANQ_TxBefore(&psQ->asTx[c], psLast))
+            break;
+        psQ->asTx[i] = psQ->asTx[c];
+        i = c;
+    }
+    psQ->asTx[i] = *psLast;
+}
+
+/* Write a frame into transmit object u32Obj and request its transmission */
+static int32_t CANQ_TxWrite(CAN_T *tCAN, uint32_t u32Obj, const STR_CANMSG_T *psMsg)
+{
+    uint32_t u32Dir = (psMsg->FrameType == CAN_REMOTE_FRAME) ? 0ul : CAN_IF_ARB2_DIR_Msk;
+
+    tCAN->IF[CANQ_IF].CMASK = CAN_IF_CMASK_WRRD_Msk | CAN_IF_CMASK_ARB_Msk | CAN_IF_CMASK_CONTROL_Msk |
+                              CAN_IF_CMASK_DATAA_Msk | CAN_IF_CMASK_DATAB_Msk;
+
+    if (psMsg->IdType == CAN_STD_ID)
+    {
+        tCAN->IF[CANQ_IF].ARB1 = 0ul;
+        tCAN->IF[CANQ_IF].ARB2 = ((psMsg->Id & 0x7FFul) << 2) | u32Dir | CAN_IF_ARB2_MSGVAL_Msk;
+    }
+    else
+    {
+        tCAN->IF[CANQ_IF].ARB1 = psMsg->Id & 0xFFFFul;
+        tCAN->IF[CANQ_IF].ARB2 = ((psMsg->Id & 0x1FFF0000ul) >> 16) | u32Dir | CAN_IF_ARB2_XTD_Msk | CAN_IF_ARB2_MSGVAL_Msk;
+    }
+
+    tCAN->IF[CANQ_IF].DAT_A1 = (uint32_t)psMsg->Data[0] | ((uint32_t)psMsg->Data[1] << 8);
+    tCAN->IF[CANQ_IF].DAT_A2 = (uint32_t)psMsg->Data[2] | ((uint32_t)psMsg->Data[3] << 8);
+    tCAN->IF[CANQ_IF].DAT_B1 = (uint32_t)psMsg->Data[4] | ((uint32_t)psMsg->Data[5] << 8);
+    tCAN->IF[CANQ_IF].DAT_B2 = (uint32_t)psMsg->Data[6] | ((uint32_t)psMsg->Data[7] << 8);
+
+    /* TxRqst in the control word starts the transmission; IntPnd is written 0 */
+    tCAN->IF[CANQ_IF].MCON = CAN_IF_MCON_NEWDAT_Msk | CAN_IF_MCON_TxRqst_Msk | CAN_IF_MCON_TXIE_Msk |
+                             CAN_IF_MCON_EOB_Msk | (psMsg->DLC & CAN_IF_MCON_DLC_Msk);
+
+    return CANQ_IfRun(tCAN, u32Obj);
+}
+
+/*
+ * Load free transmit objects from the head of the heap. The controller sends the
+ * lowest numbered pending object first, so loaded frames are kept in ascending
+ * key order across the objects: a frame goes into a free object above every
+ * loaded frame that must leave before it and below every loaded frame it
+ * beats. A frame of an ID already loaded thus goes above it. If the interface
+ * stays busy, the frame stays on the heap and the object free, and loading is
+ * tried again on the next send or transmit done.
+ */
+static void CANQ_TxFill(CANQ_T *psQ)
+{
+    uint32_t u32Lo, u32Hi, u32Fit, u32Obj, i;
+
+    while (psQ->u32TxNum)
+    {
+        u32Lo = 0;
+        u32Hi = psQ->u32TxObjNum;
+        for (i = 0; i < psQ->u32TxObjNum; i++)
+        {
+            if ((psQ->u32TxBusy & (1ul << i)) == 0)
+                continue;
+            if (psQ->au32TxKey[i] <= psQ->asTx[0].u32Key)
+                u32Lo = i + 1;
+            else if (u32Hi == psQ->u32TxObjNum)
+                u32Hi = i;
+        }
+
+        u32Fit = ~psQ->u32TxBusy & ((1ul << u32Hi) - 1) & ~((1ul << u32Lo) - 1);
+        if (u32Fit == 0)
+            break;
+
+        u32Obj = CANQ_LowestBit(u32Fit);
+        if (CANQ_TxWrite(psQ->tCAN, u32Obj, &psQ->asTx[0].sMsg) != CANQ_OK)
+            break;
+        psQ->au32TxKey[u32Obj] = psQ->asTx[0].u32Key;
+        psQ->au32TxBits[u32Obj] = CANQ_FrameBits(&psQ->asTx[0].sMsg);
+        psQ->u32TxBusy |= 1ul << u32Obj;
+        CANQ_TxPop(psQ);
+    }
+}
+
+static void CANQ_TxDone(CANQ_T *psQ, uint32_t u32Obj)
+{
+    CAN_T *tCAN = psQ->tCAN;
+
+    if (psQ->u32TxBusy & (1ul << u32Obj))
+    {
+        psQ->u32TxBusy &= ~(1ul << u32Obj);
+        psQ->sStat.u32TxFrames++;
+        psQ->sStat.u32Bits += psQ->au32TxBits[u32Obj];
+    }
+
+    CANQ_TxFill(psQ);
+
+    /* Reloading the object cleared IntPnd, otherwise clear it here */
+    if ((psQ->u32TxBusy & (1ul << u32Obj)) == 0)
+    {
+        tCAN->IF[CANQ_IF].CMASK = CAN_IF_CMASK_CLRINTPND_Msk;
+        CANQ_IfRun(tCAN, u32Obj);
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Reception                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t CANQ_RxMcon(const CANQ_GROUP_T *psGroup, uint32_t u32Obj)
+{
+    uint32_t u32Mcon = CAN_IF_MCON_UMASK_Msk | CAN_IF_MCON_RXIE_Msk;
+
+    if (u32Obj == (uint32_t)psGroup->u8First + psGroup->u8Num - 1)
+        u32Mcon |= CAN_IF_MCON_EOB_Msk;
+
+    return u32Mcon;
+}
+
+/* Merged groups accept more than the filters and may overlap, so check the whole list */
+static int CANQ_RxMatch(const CANQ_T *psQ, const STR_CANMSG_T *psMsg)
+{
+    const CANQ_FILTER_T *psFilter;
+    uint32_t i;
+
+    for (i = 0; i < psQ->u32FilterNum; i++)
+    {
+        psFilter = &psQ->asFilter[i];
+        if ((psFilter->u32IdType == psMsg->IdType) && (((psMsg->Id ^ psFilter->u32Id) & psFilter->u32Mask) == 0))
+            return 1;
+    }
+
+    return 0;
+}
+
+/* Read receive object u32Obj, release it and put the frame into the RX ring */
+static void CANQ_RxRead(CANQ_T *psQ, uint32_t u32Group, uint32_t u32Obj)
+{
+    CAN_T *tCAN = psQ->tCAN;
+    STR_CANMSG_T *psMsg;
+    uint32_t u32Mcon, u32Head = psQ->u32RxHead;
+
+    tCAN->IF[CANQ_IF].CMASK = CAN_IF_CMASK_ARB_Msk | CAN_IF_CMASK_CONTROL_Msk | CAN_IF_CMASK_CLRINTPND_Msk |
+                              CAN_IF_CMASK_TXRQSTNEWDAT_Msk | CAN_IF_CMASK_DATAA_Msk | CAN_IF_CMASK_DATAB_Msk;
+    if (CANQ_IfRun(tCAN, u32Obj) != CANQ_OK)
+        return;
+
+    u32Mcon = tCAN->IF[CANQ_IF].MCON;
+    if (u32Mcon & CAN_IF_MCON_MsgLst_Msk)
+    {
+        /* The FIFO was full and the last object overwritten */
+        psQ->sStat.u32RxLost++;
+        tCAN->IF[CANQ_IF].CMASK = CAN_IF_CMASK_WRRD_Msk | CAN_IF_CMASK_CONTROL_Msk;
+        tCAN->IF[CANQ_IF].MCON = CANQ_RxMcon(&psQ->asGroup[u32Group], u32Obj);
+        CANQ_IfRun(tCAN, u32Obj);     /* the other interface registers keep the frame */
+    }
+
+    if ((u32Head - psQ->u32RxTail) >= CANQ_RX_QUEUE_SIZE)
+    {
+        psQ->sStat.u32RxDropped++;
+        return;
+    }
+
+    psMsg = &psQ->asRx[u32Head & (CANQ_RX_QUEUE_SIZE - 1)];
+    psMsg->FrameType = CAN_DATA_FRAME;
+    if ((tCAN->IF[CANQ_IF].ARB2 & CAN_IF_ARB2_XTD_Msk) == 0)
+    {
+        psMsg->IdType = CAN_STD_ID;
+        psMsg->Id = (tCAN->IF[CANQ_IF].ARB2 & CAN_IF_ARB2_ID_Msk) >> 2;
+    }
+    else
+    {
+        psMsg->IdType = CAN_EXT_ID;
+        psMsg->Id = ((tCAN->IF[CANQ_IF].ARB2 & CAN_IF_ARB2_ID_Msk) << 16) | tCAN->IF[CANQ_IF].ARB1;
+    }
+    psMsg->DLC = (uint8_t)(u32Mcon & CAN_IF_MCON_DLC_Msk);
+    if (psMsg->DLC > 8)
+        psMsg->DLC = 8;
+    psMsg->Data[0] = (uint8_t)tCAN->IF[CANQ_IF].DAT_A1;
+    psMsg->Data[1] = (uint8_t)(tCAN->IF[CANQ_IF].DAT_A1 >> 8);
+    psMsg->Data[2] = (uint8_t)tCAN->IF[CANQ_IF].DAT_A2;
+    psMsg->Data[3] = (uint8_t)(tCAN->IF[CANQ_IF].DAT_A2 >> 8);
+    psMsg->Data[4] = (uint8_t)tCAN->IF[CANQ_IF].DAT_B1;
+    psMsg->Data[5] = (uint8_t)(tCAN->IF[CANQ_IF].DAT_B1 >> 8);
+    psMsg->Data[6] = (uint8_t)tCAN->IF[CANQ_IF].DAT_B2;
+    psMsg->Data[7] = (uint8_t)(tCAN->IF[CANQ_IF].DAT_B2 >> 8);
+
+    psQ->sStat.u32Bits += CANQ_FrameBits(psMsg);
+
+    if (psQ->asGroup[u32Group].u8Merged && !CANQ_RxMatch(psQ, psMsg))
+    {
+        psQ->sStat.u32RxFiltered++;
+        return;
+    }
+
+    psQ->u32RxHead = ++u32Head;
+    psQ->sStat.u32RxFrames++;
+    if ((u32Head - psQ->u32RxTail) > psQ->sStat.u32RxMaxQueued)
+        psQ->sStat.u32RxMaxQueued = u32Head - psQ->u32RxTail;
+}
+
+static uint32_t CANQ_NewData(CAN_T *tCAN)
+{
+    return (tCAN->NDAT1 & 0xFFFFul) | ((tCAN->NDAT2 & 0xFFFFul) << 16);
+}
+
+/* Read every filled object of a FIFO, oldest first */
+static void CANQ_RxDrain(CANQ_T *psQ, uint32_t u32Group)
+{
+    CANQ_GROUP_T *psGroup = &psQ->asGroup[u32Group];
+    uint32_t u32Mask = ((1ul << psGroup->u8Num) - 1) << psGroup->u8First;
+    uint32_t u32Pend = CANQ_NewData(psQ->tCAN) & u32Mask;
+    uint32_t u32Obj = psGroup->u8Next;
+    uint32_t u32Count;
+
+    /*
+     * A new frame takes the lowest free object, so an emptied FIFO fills again
+     * from the bottom. Objects freed while the FIFO is being read are refilled
+     * behind the read position, so reading goes on as a ring from there, and
+     * an empty object at the read position means the rest is at the bottom.
+     */
+    for (u32Count = 0; u32Count < 2ul * psGroup->u8Num; u32Count++)
+    {
+        if (u32Pend == 0)
+        {
+            u32Pend = CANQ_NewData(psQ->tCAN) & u32Mask;
+            if (u32Pend == 0)
+            {
+                u32Obj = psGroup->u8First;
+                break;
+            }
+        }
+
+        if ((u32Pend & (1ul << u32Obj)) == 0)
+            u32Obj = CANQ_LowestBit(u32Pend);
+
+        CANQ_RxRead(psQ, u32Group, u32Obj);
+        u32Pend &= ~(1ul << u32Obj);
+
+        if (++u32Obj == (uint32_t)psGroup->u8First + psGroup->u8Num)
+            u32Obj = psGroup->u8First;
+    }
+
+    psGroup->u8Next = (uint8_t)u32Obj;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Acceptance filters                                                                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+/* Merge the two groups that lose the fewest mask bits together */
+static void CANQ_MergeClosest(CANQ_T *psQ)
+{
+    CANQ_GROUP_T *psA, *psB;
+    uint32_t i, j, u32Mask, u32Best = 0, u32BestMask = 0;
+    int32_t i32Score, i32Best = -2;
+
+    for (i = 0; i < psQ->u32GroupNum; i++)
+    {
+        for (j = i + 1; j < psQ->u32GroupNum; j++)
+        {
+            psA = &psQ->asGroup[i];
+            psB = &psQ->asGroup[j];
+            if ((psA->u8IdType != psB->u8IdType) || (psA->u8IdType == CANQ_ANY_ID))
+            {
+                /* Only an accept-all group covers both ID types */
+                u32Mask = 0;
+                i32Score = -1;
+            }
+            else
+            {
+                u32Mask = psA->u32Mask & psB->u32Mask & ~(psA->u32Id ^ psB->u32Id);
+                i32Score = (int32_t)CANQ_PopCount(u32Mask);
+            }
+
+            if (i32Score > i32Best)
+            {
+                i32Best = i32Score;
+                u32Best = (i << 8) | j;
+                u32BestMask = u32Mask;
+            }
+        }
+    }
+
+    i = u32Best >> 8;
+    j = u32Best & 0xFFul;
+    psA = &psQ->asGroup[i];
+    if (i32Best < 0)
+        psA->u8IdType = CANQ_ANY_ID;
+    psA->u32Mask = u32BestMask;
+    psA->u32Id &= u32BestMask;
+    psA->u8Merged = 1;
+
+    for (i = j; i + 1 < psQ->u32GroupNum; i++)
+        psQ->asGroup[i] = psQ->asGroup[i + 1];
+    psQ->u32GroupNum--;
+}
+
+/* Program receive object u32Obj as a member of the FIFO of group u32Group */
+static void CANQ_RxSetup(CANQ_T *psQ, uint32_t u32Group, uint32_t u32Obj)
+{
+    CAN_T *tCAN = psQ->tCAN;
+    CANQ_GROUP_T *psGroup = &psQ->asGroup[u32Group];
+
+    tCAN->IF[CANQ_IF].CMASK = CAN_IF_CMASK_WRRD_Msk | CAN_IF_CMASK_MASK_Msk | CAN_IF_CMASK_ARB_Msk |
+                              CAN_IF_CMASK_CONTROL_Msk;
+
+    if (psGroup->u8IdType == CAN_STD_ID)
+    {
+        tCAN->IF[CANQ_IF].ARB1 = 0ul;
+        tCAN->IF[CANQ_IF].ARB2 = CAN_IF_ARB2_MSGVAL_Msk | ((psGroup->u32Id & 0x7FFul) << 2);
+        tCAN->IF[CANQ_IF].MASK1 = 0ul;
+        tCAN->IF[CANQ_IF].MASK2 = CAN_IF_MASK2_MXTD_Msk | CAN_IF_MASK2_MDIR_Msk | ((psGroup->u32Mask & 0x7FFul) << 2);
+    }
+    else if (psGroup->u8IdType == CAN_EXT_ID)
+    {
+        tCAN->IF[CANQ_IF].ARB1 = psGroup->u32Id & 0xFFFFul;
+        tCAN->IF[CANQ_IF].ARB2 = CAN_IF_ARB2_MSGVAL_Msk | CAN_IF_ARB2_XTD_Msk | ((psGroup->u32Id >> 16) & 0x1FFFul);
+        tCAN->IF[CANQ_IF].MASK1 = psGroup->u32Mask & 0xFFFFul;
+        tCAN->IF[CANQ_IF].MASK2 = CAN_IF_MASK2_MXTD_Msk | CAN_IF_MASK2_MDIR_Msk | ((psGroup->u32Mask >> 16) & 0x1FFFul);
+    }
+    else
+    {
+        tCAN->IF[CANQ_IF].ARB1 = 0ul;
+        tCAN->IF[CANQ_IF].ARB2 = CAN_IF_ARB2_MSGVAL_Msk;
+        tCAN->IF[CANQ_IF].MASK1 = 0ul;
+        tCAN->IF[CANQ_IF].MASK2 = CAN_IF_MASK2_MDIR_Msk;
+    }
+
+    /* NewDat, MsgLst and IntPnd are written 0 */
+    tCAN->IF[CANQ_IF].MCON = CANQ_RxMcon(psGroup, u32Obj);
+
+    CANQ_IfRun(tCAN, u32Obj);
+}
+
+/**
+  * @brief      Compile acceptance filters into hardware FIFOs
+  * @param[in]  psQ         Queue
+  * @param[in]  psFilter    Filters, NULL to accept every frame
+  * @param[in]  u32Num      Number of filters, 0 ~ CANQ_FILTER_MAX
+  * @param[in]  u32FifoMin  Fewest message objects in one FIFO. Filters are merged until every FIFO gets this many.
+  * @retval     CANQ_OK         Success
+  * @retval     CANQ_ERR_PARAM  Invalid parameter
+  * @details    The receive objects are shared out evenly between the FIFOs. Frames held by the
+  *             receive objects are discarded.
+  */
+int32_t CANQ_SetFilters(CANQ_T *psQ, const CANQ_FILTER_T *psFilter, uint32_t u32Num, uint32_t u32FifoMin)
+{
+    CANQ_GROUP_T *psGroup;
+    uint32_t u32RxObj = CANQ_MSG_OBJ_NUM - psQ->u32TxObjNum;
+    uint32_t u32Width, u32IntMask, u32Obj, i, j;
+
+    if ((u32Num > CANQ_FILTER_MAX) || ((u32Num != 0) && (psFilter == NULL)) ||
+            (u32FifoMin == 0) || (u32FifoMin > u32RxObj))
+        return CANQ_ERR_PARAM;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        if ((psFilter[i].u32IdType != CAN_STD_ID) && (psFilter[i].u32IdType != CAN_EXT_ID))
+            return CANQ_ERR_PARAM;
+    }
+
+    u32IntMask = CANQ_Lock(psQ->tCAN);
+
+    /* One group per distinct filter */
+    psQ->u32GroupNum = 0;
+    psQ->u32FilterNum = u32Num;
+    for (i = 0; i < u32Num; i++)
+    {
+        u32Width = (psFilter[i].u32IdType == CAN_STD_ID) ? 0x7FFul : 0x1FFFFFFFul;
+        psQ->asFilter[i].u32IdType = psFilter[i].u32IdType;
+        psQ->asFilter[i].u32Mask = psFilter[i].u32Mask & u32Width;
+        psQ->asFilter[i].u32Id = psFilter[i].u32Id & psQ->asFilter[i].u32Mask;
+
+        for (j = 0; j < psQ->u32GroupNum; j++)
+        {
+            psGroup = &psQ->asGroup[j];
+            if ((psGroup->u8IdType == psQ->asFilter[i].u32IdType) && (psGroup->u32Mask == psQ->asFilter[i].u32Mask) &&
+                    (psGroup->u32Id == psQ->asFilter[i].u32Id))
+                break;
+        }
+
+        if (j == psQ->u32GroupNum)
+        {
+            psGroup = &psQ->asGroup[psQ->u32GroupNum++];
+            psGroup->u32Id = psQ->asFilter[i].u32Id;
+            psGroup->u32Mask = psQ->asFilter[i].u32Mask;
+            psGroup->u8IdType = (uint8_t)psQ->asFilter[i].u32IdType;
+            psGroup->u8Merged = 0;
+        }
+    }
+
+    if (psQ->u32GroupNum == 0)
+    {
+        psGroup = &psQ->asGroup[psQ->u32GroupNum++];
+        psGroup->u32Id = 0;
+        psGroup->u32Mask = 0;
+        psGroup->u8IdType = CANQ_ANY_ID;
+        psGroup->u8Merged = 0;
+    }
+
+    while (psQ->u32GroupNum > u32RxObj / u32FifoMin)
+        CANQ_MergeClosest(psQ);
+
+    /* Share the receive objects out and chain each share into a FIFO */
+    u32Obj = psQ->u32TxObjNum;
+    for (i = 0; i < psQ->u32GroupNum; i++)
+    {
+        psGroup = &psQ->asGroup[i];
+        psGroup->u8First = (uint8_t)u32Obj;
+        psGroup->u8Num = (uint8_t)(u32RxObj / psQ->u32GroupNum + ((i < u32RxObj % psQ->u32GroupNum) ? 1 : 0));
+        psGroup->u8Next = psGroup->u8First;
+
+        for (j = 0; j < psGroup->u8Num; j++, u32Obj++)
+        {
+            psQ->au8ObjGroup[u32Obj] = (uint8_t)i;
+            CANQ_RxSetup(psQ, i, u32Obj);
+        }
+    }
+
+    CANQ_Unlock(psQ->tCAN, u32IntMask);
+
+    return CANQ_OK;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Interface                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+/**
+  * @brief      Take over a CAN controller
+  * @param[in]  psQ             Queue to initialize
+  * @param[in]  tCAN            Controller, opened with CAN_Open in CAN_NORMAL_MODE
+  * @param[in]  u32TxObjNum     Message objects used to transmit, 1 ~ CANQ_TX_OBJ_MAX
+  * @param[in]  pfnRxCallback   RX callback, may be NULL
+  * @retval     CANQ_OK         Success
+  * @retval     CANQ_ERR_PARAM  Invalid parameter
+  * @details    All receive objects form one FIFO accepting every frame until CANQ_SetFilters is called.
+  *             The module and error interrupts are enabled; the application enables the NVIC
+  *             line and calls CANQ_IRQHandler from the controller's IRQ handler.
+  */
+int32_t CANQ_Open(CANQ_T *psQ, CAN_T *tCAN, uint32_t u32TxObjNum, CANQ_CB_T pfnRxCallback)
+{
+    uint32_t u32Obj;
+
+    if ((psQ == NULL) || (tCAN == NULL) || (u32TxObjNum == 0) || (u32TxObjNum > CANQ_TX_OBJ_MAX))
+        return CANQ_ERR_PARAM;
+
+    memset(psQ, 0, sizeof(CANQ_T));
+    psQ->tCAN = tCAN;
+    psQ->u32TxObjNum = u32TxObjNum;
+    psQ->pfnRxCallback = pfnRxCallback;
+
+    CANQ_Lock(tCAN);
+
+    for (u32Obj = 0; u32Obj < u32TxObjNum; u32Obj++)
+    {
+        tCAN->IF[CANQ_IF].CMASK = CAN_IF_CMASK_WRRD_Msk | CAN_IF_CMASK_ARB_Msk | CAN_IF_CMASK_CONTROL_Msk;
+        tCAN->IF[CANQ_IF].ARB1 = 0ul;
+        tCAN->IF[CANQ_IF].ARB2 = 0ul;
+        tCAN->IF[CANQ_IF].MCON = 0ul;
+        CANQ_IfRun(tCAN, u32Obj);
+    }
+
+    CANQ_SetFilters(psQ, NULL, 0, 1);
+
+    psQ->u32Status = tCAN->STATUS;
+    tCAN->STATUS &= ~(CAN_STATUS_RXOK_Msk | CAN_STATUS_TXOK_Msk);
+    CAN_EnableInt(tCAN, CAN_CON_IE_Msk | CAN_CON_EIE_Msk);
+
+    return CANQ_OK;
+}
+
+/**
+  * @brief      Stop the queue
+  * @param[in]  psQ     Queue
+  * @return     None
+  * @details    Disables the controller interrupts and invalidates all message objects. Queued frames are discarded.
+  */
+void CANQ_Close(CANQ_T *psQ)
+{
+    CAN_T *tCAN = psQ->tCAN;
+    uint32_t u32Obj;
+
+    CAN_DisableInt(tCAN, CANQ_INT_MASK);
+
+    for (u32Obj = 0; u32Obj < CANQ_MSG_OBJ_NUM; u32Obj++)
+    {
+        tCAN->IF[CANQ_IF].CMASK = CAN_IF_CMASK_WRRD_Msk | CAN_IF_CMASK_ARB_Msk | CAN_IF_CMASK_CONTROL_Msk;
+        tCAN->IF[CANQ_IF].ARB1 = 0ul;
+        tCAN->IF[CANQ_IF].ARB2 = 0ul;
+        tCAN->IF[CANQ_IF].MCON = 0ul;
+        CANQ_IfRun(tCAN, u32Obj);
+    }
+
+    psQ->u32TxNum = 0;
+    psQ->u32TxBusy = 0;
+    psQ->u32RxTail = psQ->u32RxHead;
+}
+
+/**
+  * @brief      Queue a frame for transmission
+  * @param[in]  psQ     Queue
+  * @param[in]  psMsg   Frame, copied
+  * @retval     CANQ_OK         Queued
+  * @retval     CANQ_ERR_FULL   CANQ_TX_QUEUE_SIZE frames already waiting; the frame is dropped and counted
+  * @details    Frames leave in bus priority order, lowest ID first.
+  */
+int32_t CANQ_Send(CANQ_T *psQ, const STR_CANMSG_T *psMsg)
+{
+    uint32_t u32IntMask;
+    int32_t i32Ret = CANQ_OK;
+
+    u32IntMask = CANQ_Lock(psQ->tCAN);
+
+    if (psQ->u32TxNum == CANQ_TX_QUEUE_SIZE)
+    {
+        psQ->sStat.u32TxDropped++;
+        i32Ret = CANQ_ERR_FULL;
+    }
+    else
+    {
+        CANQ_TxPush(psQ, psMsg);
+        if (psQ->u32TxNum > psQ->sStat.u32TxMaxQueued)
+            psQ->sStat.u32TxMaxQueued = psQ->u32TxNum;
+        CANQ_TxFill(psQ);
+    }
+
+    CANQ_Unlock(psQ->tCAN, u32IntMask);
+
+    return i32Ret;
+}
+
+/**
+  * @brief      Take the oldest received frame
+  * @param[in]  psQ     Queue
+  * @param[out] psMsg   Frame
+  * @retval     CANQ_OK         A frame was copied
+  * @retval     CANQ_ERR_EMPTY  No frame
+  */
+int32_t CANQ_Receive(CANQ_T *psQ, STR_CANMSG_T *psMsg)
+{
+    uint32_t u32Tail = psQ->u32RxTail;
+
+    if (u32Tail == psQ->u32RxHead)
+        return CANQ_ERR_EMPTY;
+
+    *psMsg = psQ->asRx[u32Tail & (CANQ_RX_QUEUE_SIZE - 1)];
+    psQ->u32RxTail = u32Tail + 1;
+
+    return CANQ_OK;
+}
+
+/**
+  * @brief      Frames waiting in the RX ring
+  * @param[in]  psQ     Queue
+  * @return     Number of frames
+  */
+uint32_t CANQ_GetRxCount(CANQ_T *psQ)
+{
+    return psQ->u32RxHead - psQ->u32RxTail;
+}
+
+/**
+  * @brief      Frames not transmitted yet
+  * @param[in]  psQ     Queue
+  * @return     Frames in the TX queue and the transmit objects
+  */
+uint32_t CANQ_GetTxCount(CANQ_T *psQ)
+{
+    return psQ->u32TxNum + CANQ_PopCount(psQ->u32TxBusy);
+}
+
+/**
+  * @brief      Read the statistics
+  * @param[in]  psQ         Queue
+  * @param[out] psStat      Copy of the statistics
+  * @param[in]  u32Clear    1: clear the statistics after the copy
+  * @return     None
+  * @details    The bus load seen by this node is u32Bits divided by the bit rate times the elapsed time.
+  */
+void CANQ_GetStat(CANQ_T *psQ, CANQ_STAT_T *psStat, uint32_t u32Clear)
+{
+    uint32_t u32IntMask = CANQ_Lock(psQ->tCAN);
+
+    *psStat = psQ->sStat;
+    if (u32Clear)
+        memset(&psQ->sStat, 0, sizeof(CANQ_STAT_T));
+
+    CANQ_Unlock(psQ->tCAN, u32IntMask);
+}
+
+/**
+  * @brief      Interrupt service of the queue
+  * @param[in]  psQ     Queue
+  * @return     None
+  * @details    Call from the IRQ handler of the controller.
+  */
+void CANQ_IRQHandler(CANQ_T *psQ)
+{
+    CAN_T *tCAN = psQ->tCAN;
+    uint32_t u32IntId, u32Status, u32Obj, u32Rx = psQ->u32RxHead, u32Loop;
+
+    for (u32Loop = 0; u32Loop < 2 * CANQ_MSG_OBJ_NUM; u32Loop++)
+    {
+        u32IntId = tCAN->IIDR & CAN_IIDR_IntId_Msk;
+        if (u32IntId == 0)
+            break;
+
+        if (u32IntId == 0x8000ul)
+        {
+            /* Reading STATUS clears the status interrupt */
+            u32Status = tCAN->STATUS;
+
+            if ((u32Status & CAN_STATUS_EWARN_Msk) && !(psQ->u32Status & CAN_STATUS_EWARN_Msk))
+                psQ->sStat.u32ErrWarn++;
+            if ((u32Status & CAN_STATUS_EPASS_Msk) && !(psQ->u32Status & CAN_STATUS_EPASS_Msk))
+                psQ->sStat.u32ErrPassive++;
+            if ((u32Status & CAN_STATUS_BOFF_Msk) && !(psQ->u32Status & CAN_STATUS_BOFF_Msk))
+            {
+                /* The controller stopped itself; leaving init starts the bus-off recovery */
+                psQ->sStat.u32BusOff++;
+                tCAN->CON &= ~CAN_CON_INIT_Msk;
+            }
+
+            psQ->u32Status = u32Status;
+            tCAN->STATUS &= ~(CAN_STATUS_RXOK_Msk | CAN_STATUS_TXOK_Msk);
+        }
+        else if (u32IntId <= CANQ_MSG_OBJ_NUM)
+        {
+            u32Obj = u32IntId - 1;
+            if (u32Obj < psQ->u32TxObjNum)
+            {
+                CANQ_TxDone(psQ, u32Obj);
+            }
+            else
+            {
+                CANQ_RxDrain(psQ, psQ->au8ObjGroup[u32Obj]);
+
+                /* An object set with no new data would keep the interrupt asserted */
+                if ((tCAN->IIDR & CAN_IIDR_IntId_Msk) == u32IntId)
+                {
+                    tCAN->IF[CANQ_IF].CMASK = CAN_IF_CMASK_CLRINTPND_Msk;
+                    CANQ_IfRun(tCAN, u32Obj);
+                }
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if ((psQ->u32RxHead != u32Rx) && psQ->pfnRxCallback)
+        psQ->pfnRxCallback(psQ);
+}
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
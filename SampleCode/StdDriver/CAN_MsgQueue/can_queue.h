@@ -0,0 +1,137 @@
+/**************************************************************************//**
+ * @file     can_queue.h
+ * @version  V1.00
+ * @brief    Interrupt-driven CAN message queue header file
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef __CAN_QUEUE_H__
+#define __CAN_QUEUE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Configuration                                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CANQ_MSG_OBJ_NUM        32          /*!< Message objects of one C_CAN controller                  */
+#define CANQ_TX_OBJ_MAX         8           /*!< Maximum message objects used for transmission            */
+#define CANQ_TX_QUEUE_SIZE      32          /*!< Frames waiting in the software TX priority queue         */
+#define CANQ_RX_QUEUE_SIZE      64          /*!< Frames in the software RX ring, a power of 2             */
+#define CANQ_FILTER_MAX         32          /*!< Maximum acceptance filters passed to CANQ_SetFilters     */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Error codes                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CANQ_OK                 0           /*!< No error                                                 */
+#define CANQ_ERR_PARAM          -1          /*!< Invalid parameter                                        */
+#define CANQ_ERR_FULL           -2          /*!< TX queue is full, the frame was dropped                  */
+#define CANQ_ERR_EMPTY          -3          /*!< No frame in the RX ring                                  */
+#define CANQ_ERR_IF             -4          /*!< Message interface stayed busy                            */
+
+/**
+  * @brief  Acceptance filter. A frame is accepted if (Id & u32Mask) == (u32Id & u32Mask).
+  */
+typedef struct
+{
+    uint32_t u32Id;             /*!< Identifier, right aligned                                */
+    uint32_t u32Mask;           /*!< 1 bits must match, right aligned; 0 accepts any ID       */
+    uint32_t u32IdType;         /*!< CAN_STD_ID or CAN_EXT_ID                                 */
+} CANQ_FILTER_T;
+
+/**
+  * @brief  Queue statistics
+  */
+typedef struct
+{
+    uint32_t u32TxFrames;       /*!< Frames transmitted                                       */
+    uint32_t u32RxFrames;       /*!< Frames put into the RX ring                              */
+    uint32_t u32Bits;           /*!< Bus bits of those frames, stuff bits and IFS included    */
+    uint32_t u32TxDropped;      /*!< Frames refused by CANQ_Send because the queue was full   */
+    uint32_t u32RxDropped;      /*!< Frames lost because the RX ring was full                 */
+    uint32_t u32RxLost;         /*!< Overwrites in a full hardware FIFO (MsgLst), 1 or more frames each */
+    uint32_t u32RxFiltered;     /*!< Frames passed by a merged filter but matching no filter  */
+    uint32_t u32TxMaxQueued;    /*!< Most frames waiting in the TX queue at once              */
+    uint32_t u32RxMaxQueued;    /*!< Most frames waiting in the RX ring at once               */
+    uint32_t u32ErrWarn;        /*!< Error warning events                                     */
+    uint32_t u32ErrPassive;     /*!< Error passive events                                     */
+    uint32_t u32BusOff;         /*!< Bus-off events, each recovered automatically             */
+} CANQ_STAT_T;
+
+struct canq;
+
+/**
+  * @brief  RX callback, called from CANQ_IRQHandler after frames were put into the RX ring.
+  * @param  psQ     Queue
+  */
+typedef void (*CANQ_CB_T)(struct canq *psQ);
+
+/** @cond HIDDEN_SYMBOLS */
+typedef struct
+{
+    STR_CANMSG_T sMsg;
+    uint32_t u32Key;            /* bus arbitration order, lower wins */
+    uint32_t u32Seq;            /* queueing order among equal keys */
+} CANQ_TXENT_T;
+
+typedef struct
+{
+    uint32_t u32Id;
+    uint32_t u32Mask;
+    uint8_t u8IdType;           /* CAN_STD_ID, CAN_EXT_ID or 0xFF for both */
+    uint8_t u8Merged;           /* accepts more than its filters */
+    uint8_t u8First;            /* first message object of the hardware FIFO */
+    uint8_t u8Num;              /* message objects in the FIFO */
+    uint8_t u8Next;             /* object holding the oldest frame */
+} CANQ_GROUP_T;
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief  Queue of one CAN controller
+  */
+typedef struct canq
+{
+    CAN_T *tCAN;                /*!< Controller                                               */
+    uint32_t u32TxObjNum;       /*!< Message objects 0 ~ u32TxObjNum - 1 transmit             */
+    CANQ_CB_T pfnRxCallback;    /*!< RX callback, may be NULL                                 */
+    CANQ_STAT_T sStat;          /*!< Statistics                                               */
+    /** @cond HIDDEN_SYMBOLS */
+    CANQ_TXENT_T asTx[CANQ_TX_QUEUE_SIZE];  /* binary heap */
+    uint32_t u32TxNum;
+    uint32_t u32TxSeq;
+    uint32_t u32TxBusy;                     /* loaded transmit objects */
+    uint32_t au32TxKey[CANQ_TX_OBJ_MAX];
+    uint32_t au32TxBits[CANQ_TX_OBJ_MAX];
+    STR_CANMSG_T asRx[CANQ_RX_QUEUE_SIZE];
+    volatile uint32_t u32RxHead;
+    volatile uint32_t u32RxTail;
+    CANQ_GROUP_T asGroup[CANQ_MSG_OBJ_NUM];
+    uint32_t u32GroupNum;
+    uint8_t au8ObjGroup[CANQ_MSG_OBJ_NUM];  /* group of each receive object */
+    CANQ_FILTER_T asFilter[CANQ_FILTER_MAX];
+    uint32_t u32FilterNum;
+    uint32_t u32Status;                     /* STATUS at the last status interrupt */
+    /** @endcond HIDDEN_SYMBOLS */
+} CANQ_T;
+
+int32_t CANQ_Open(CANQ_T *psQ, CAN_T *tCAN, uint32_t u32TxObjNum, CANQ_CB_T pfnRxCallback);
+int32_t CANQ_SetFilters(CANQ_T *psQ, const CANQ_FILTER_T *psFilter, uint32_t u32Num, uint32_t u32FifoMin);
+void CANQ_Close(CANQ_T *psQ);
+int32_t CANQ_Send(CANQ_T *psQ, const STR_CANMSG_T *psMsg);
+int32_t CANQ_Receive(CANQ_T *psQ, STR_CANMSG_T *psMsg);
+uint32_t CANQ_GetRxCount(CANQ_T *psQ);
+uint32_t CANQ_GetTxCount(CANQ_T *psQ);
+void CANQ_GetStat(CANQ_T *psQ, CANQ_STAT_T *psStat, uint32_t u32Clear);
+uint32_t CANQ_FrameBits(const STR_CANMSG_T *psMsg);
+void CANQ_IRQHandler(CANQ_T *psQ);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __CAN_QUEUE_H__ */
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
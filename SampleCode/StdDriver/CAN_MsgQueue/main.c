@@ -0,0 +1,286 @@
+/******************************************************************************
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Demonstrate the interrupt-driven CAN message queue. CAN0 sends
+ *           bursts through the TX priority queue and CAN1 receives them
+ *           through filtered hardware FIFOs; both are connected to the same
+ *           CAN bus.
+ *
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <stdio.h>
+#include "NuMicro.h"
+
+#include "can_queue.h"
+
+#define CAN_BIT_RATE    500000      /* bit/s */
+#define BURST_FRAMES    4000        /* frames of the load test */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Global variables                                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+static CANQ_T s_sTxQ, s_sRxQ;
+static volatile uint32_t s_u32RxEvents;
+
+/* Receive filters of CAN1: one exact ID, a block of 16 IDs, a list of 20 IDs and two extended PGN groups */
+static CANQ_FILTER_T s_asFilter[] =
+{
+    {0x080,      0x7FF,      CAN_STD_ID},
+    {0x100,      0x7F0,      CAN_STD_ID},
+    {0x201, 0x7FF, CAN_STD_ID}, {0x203, 0x7FF, CAN_STD_ID}, {0x207, 0x7FF, CAN_STD_ID}, {0x20B, 0x7FF, CAN_STD_ID},
+    {0x211, 0x7FF, CAN_STD_ID}, {0x213, 0x7FF, CAN_STD_ID}, {0x217, 0x7FF, CAN_STD_ID}, {0x21B, 0x7FF, CAN_STD_ID},
+    {0x221, 0x7FF, CAN_STD_ID}, {0x223, 0x7FF, CAN_STD_ID}, {0x227, 0x7FF, CAN_STD_ID}, {0x22B, 0x7FF, CAN_STD_ID},
+    {0x231, 0x7FF, CAN_STD_ID}, {0x233, 0x7FF, CAN_STD_ID}, {0x237, 0x7FF, CAN_STD_ID}, {0x23B, 0x7FF, CAN_STD_ID},
+    {0x241, 0x7FF, CAN_STD_ID}, {0x243, 0x7FF, CAN_STD_ID}, {0x247, 0x7FF, CAN_STD_ID}, {0x24B, 0x7FF, CAN_STD_ID},
+    {0x18FEF100, 0x1FFFFF00, CAN_EXT_ID},
+    {0x0CF00400, 0x1FFFFF00, CAN_EXT_ID},
+};
+
+#define FILTER_NUM      (sizeof(s_asFilter) / sizeof(s_asFilter[0]))
+
+void CAN0_IRQHandler(void)
+{
+    CANQ_IRQHandler(&s_sTxQ);
+}
+
+void CAN1_IRQHandler(void)
+{
+    CANQ_IRQHandler(&s_sRxQ);
+}
+
+static void RxCallback(CANQ_T *psQ)
+{
+    (void)psQ;
+    s_u32RxEvents++;
+}
+
+void SYS_Init(void)
+{
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Set XT1_OUT(PF.2) and XT1_IN(PF.3) to input mode */
+    PF->MODE &= ~(GPIO_MODE_MODE2_Msk | GPIO_MODE_MODE3_Msk);
+
+    CLK->PWRCTL |= CLK_PWRCTL_HXTEN_Msk;
+
+    CLK_WaitClockReady(CLK_STATUS_HXTSTB_Msk);
+
+    /* Set core clock as PLL_CLOCK from PLL */
+    CLK_SetCoreClock(192000000);
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2); // PCLK divider set 2
+
+    // Enable IP clock
+    CLK->APBCLK0 |= CLK_APBCLK0_TMR0CKEN_Msk;
+    CLK->APBCLK0 |= CLK_APBCLK0_UART0CKEN_Msk; // UART0 Clock Enable
+    CLK->APBCLK0 |= CLK_APBCLK0_CAN0CKEN_Msk | CLK_APBCLK0_CAN1CKEN_Msk;
+
+    /* Select IP clock source */
+    CLK->CLKSEL1 &= ~(CLK_CLKSEL1_UART0SEL_Msk | CLK_CLKSEL1_TMR0SEL_Msk);
+    CLK->CLKSEL1 |= (0x0 << CLK_CLKSEL1_UART0SEL_Pos);// Clock source from external 12 MHz or 32 KHz crystal clock
+
+    /* Set GPB multi-function pins for UART0 RXD and TXD */
+    SYS->GPB_MFPH &= ~(SYS_GPB_MFPH_PB12MFP_Msk | SYS_GPB_MFPH_PB13MFP_Msk);
+    SYS->GPB_MFPH |= (SYS_GPB_MFPH_PB12MFP_UART0_RXD | SYS_GPB_MFPH_PB13MFP_UART0_TXD);
+
+    /* Set PA multi-function pins for CAN0 RXD(PA.4) and TXD(PA.5) */
+    SYS->GPA_MFPL = (SYS->GPA_MFPL & ~(SYS_GPA_MFPL_PA4MFP_Msk | SYS_GPA_MFPL_PA5MFP_Msk)) |
+                    (SYS_GPA_MFPL_PA4MFP_CAN0_RXD | SYS_GPA_MFPL_PA5MFP_CAN0_TXD);
+
+    /* Set PE multi-function pins for CAN1 TXD(PE.7) and RXD(PE.6) */
+    SYS->GPE_MFPL = (SYS->GPE_MFPL & ~(SYS_GPE_MFPL_PE6MFP_Msk | SYS_GPE_MFPL_PE7MFP_Msk)) |
+                    (SYS_GPE_MFPL_PE6MFP_CAN1_RXD | SYS_GPE_MFPL_PE7MFP_CAN1_TXD);
+
+    /* Lock protected registers */
+    SYS_LockReg();
+}
+
+/* TIMER0 counts microseconds from the 12 MHz crystal */
+static void Timer_Init(void)
+{
+    TIMER0->CTL = 0;
+    TIMER0->CMP = 0xFFFFFF;
+    TIMER0->CTL = TIMER_CONTINUOUS_MODE | (11 << TIMER_CTL_PSC_Pos) | TIMER_CTL_CNTEN_Msk;
+}
+
+static uint32_t Timer_Elapsed(uint32_t u32Start)
+{
+    return (TIMER0->CNT - u32Start) & 0xFFFFFF;
+}
+
+static void MakeFrame(STR_CANMSG_T *psMsg, uint32_t u32IdType, uint32_t u32Id, uint32_t u32Seq)
+{
+    uint32_t i;
+
+    psMsg->FrameType = CAN_DATA_FRAME;
+    psMsg->IdType = u32IdType;
+    psMsg->Id = u32Id;
+    psMsg->DLC = 8;
+    psMsg->Data[0] = (uint8_t)u32Seq;
+    psMsg->Data[1] = (uint8_t)(u32Seq >> 8);
+    for (i = 2; i < 8; i++)
+        psMsg->Data[i] = (uint8_t)(u32Id + i);
+}
+
+static void ShowStat(char *pcName, CANQ_T *psQ, uint32_t u32Us)
+{
+    CANQ_STAT_T sStat;
+    uint32_t u32Load;
+
+    CANQ_GetStat(psQ, &sStat, 1);
+
+    /* Bits on the bus over bits the bus could carry in the same time, 0.1% */
+    u32Load = (uint32_t)((uint64_t)sStat.u32Bits * 1000 * 1000000 / ((uint64_t)CAN_BIT_RATE * u32Us));
+
+    printf("%s: TX %d, RX %d, bus load %d.%d%%\n", pcName, sStat.u32TxFrames, sStat.u32RxFrames, u32Load / 10, u32Load % 10);
+    printf("      dropped TX %d / RX %d, FIFO overwrites %d, filtered %d, queue peak TX %d / RX %d\n",
+           sStat.u32TxDropped, sStat.u32RxDropped, sStat.u32RxLost, sStat.u32RxFiltered,
+           sStat.u32TxMaxQueued, sStat.u32RxMaxQueued);
+    printf("      error warning %d, error passive %d, bus-off %d\n", sStat.u32ErrWarn, sStat.u32ErrPassive, sStat.u32BusOff);
+}
+
+/* Queue frames in descending priority; CAN1 must see them in ascending ID order */
+static void Test_Priority(void)
+{
+    STR_CANMSG_T sMsg;
+    uint32_t u32Id, u32Last = 0, u32Num = 0, u32Err = 0;
+    int32_t i;
+
+    printf("\nPriority: queue 0x10F ~ 0x100, then 0x080\n");
+
+    for (i = 15; i >= 0; i--)
+    {
+        MakeFrame(&sMsg, CAN_STD_ID, 0x100 + i, i);
+        CANQ_Send(&s_sTxQ, &sMsg);
+    }
+    MakeFrame(&sMsg, CAN_STD_ID, 0x080, 0);
+    CANQ_Send(&s_sTxQ, &sMsg);
+
+    while (CANQ_GetTxCount(&s_sTxQ));
+    while (u32Num < 17)
+    {
+        if (CANQ_Receive(&s_sRxQ, &sMsg) != CANQ_OK)
+            continue;
+
+        u32Id = sMsg.Id;
+        printf("%03X ", u32Id);
+        /* The first frames were loaded before the higher priority ones arrived */
+        if ((u32Num > 4) && (u32Id < u32Last))
+            u32Err++;
+        u32Last = u32Id;
+        u32Num++;
+    }
+    printf("\n%s\n", u32Err ? "Order error!" : "Frames left in priority order after the first loaded ones.");
+}
+
+/* Back-to-back frames, part of them outside the filters */
+static void Test_Burst(void)
+{
+    STR_CANMSG_T sMsg;
+    CANQ_STAT_T sStat;
+    uint32_t u32Sent = 0, u32Expect = 0, u32Got = 0, u32Start, u32Us, u32Id, u32IdType;
+
+    printf("\nBurst: %d frames\n", BURST_FRAMES);
+
+    /* Start the statistics from zero */
+    CANQ_GetStat(&s_sTxQ, &sStat, 1);
+    CANQ_GetStat(&s_sRxQ, &sStat, 1);
+    s_u32RxEvents = 0;
+    u32Start = TIMER0->CNT;
+
+    while ((u32Sent < BURST_FRAMES) || CANQ_GetTxCount(&s_sTxQ))
+    {
+        /* Keep the TX queue topped up, the interrupt keeps the transmit objects busy */
+        while ((u32Sent < BURST_FRAMES) && (CANQ_GetTxCount(&s_sTxQ) < CANQ_TX_QUEUE_SIZE))
+        {
+            switch (u32Sent % 8)
+            {
+                case 0:
+                    u32IdType = CAN_EXT_ID;
+                    u32Id = 0x18FEF100 | (u32Sent & 0xFF);
+                    break;
+                case 1:
+                    u32IdType = CAN_EXT_ID;
+                    u32Id = 0x18FEF200 | (u32Sent & 0xFF);      /* not listed */
+                    break;
+                case 2:
+                    u32IdType = CAN_STD_ID;
+                    u32Id = 0x205;                              /* not listed */
+                    break;
+                case 3:
+                case 4:
+                    u32IdType = CAN_STD_ID;
+                    u32Id = 0x100 | (u32Sent & 0xF);
+                    break;
+                default:
+                    u32IdType = CAN_STD_ID;
+                    u32Id = s_asFilter[2 + u32Sent % 20].u32Id;
+                    break;
+            }
+            if ((u32Sent % 8 != 1) && (u32Sent % 8 != 2))
+                u32Expect++;
+
+            MakeFrame(&sMsg, u32IdType, u32Id, u32Sent);
+            CANQ_Send(&s_sTxQ, &sMsg);
+            u32Sent++;
+        }
+
+        while (CANQ_Receive(&s_sRxQ, &sMsg) == CANQ_OK)
+            u32Got++;
+    }
+
+    u32Us = Timer_Elapsed(u32Start);
+    while (CANQ_Receive(&s_sRxQ, &sMsg) == CANQ_OK)
+        u32Got++;
+
+    printf("%d frames in %d us, received %d of %d listed, %d RX interrupts with frames\n",
+           u32Sent, u32Us, u32Got, u32Expect, s_u32RxEvents);
+    ShowStat("CAN0", &s_sTxQ, u32Us);
+    ShowStat("CAN1", &s_sRxQ, u32Us);
+
+    if (u32Got == u32Expect)
+        printf("CAN queue test ok!\n");
+    else
+        printf("ERROR: frames lost!\n");
+}
+
+int main()
+{
+    SYS_Init();
+    UART_Open(UART0, 115200);
+    Timer_Init();
+
+    printf("\n");
+    printf("+-------------------------------------------------------------------+\n");
+    printf("|  CAN message queue sample                                         |\n");
+    printf("+-------------------------------------------------------------------+\n");
+    printf("|  Connect CAN0 and CAN1 through transceivers to the same CAN bus   |\n");
+    printf("|  with terminal resistors. CAN0 sends, CAN1 receives.              |\n");
+    printf("+-------------------------------------------------------------------+\n");
+
+    CAN_Open(CAN0, CAN_BIT_RATE, CAN_NORMAL_MODE);
+    CAN_Open(CAN1, CAN_BIT_RATE, CAN_NORMAL_MODE);
+
+    CANQ_Open(&s_sTxQ, CAN0, 4, NULL);
+    CANQ_Open(&s_sRxQ, CAN1, 1, RxCallback);
+    if (CANQ_SetFilters(&s_sRxQ, s_asFilter, FILTER_NUM, 3) != CANQ_OK)
+    {
+        printf("Filter setting failed!\n");
+        while (1);
+    }
+    printf("%d filters compiled into %d hardware FIFOs\n", (int)FILTER_NUM, s_sRxQ.u32GroupNum);
+
+    NVIC_EnableIRQ(CAN0_IRQn);
+    NVIC_EnableIRQ(CAN1_IRQn);
+
+    printf("Press any key to continue ...\n");
+    getchar();
+
+    Test_Priority();
+    Test_Burst();
+
+    while (1);
+}
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
@@ -11,6 +11,8 @@
 #define HAVE_STDDEF_H 1
 #define HAVE_STDLIB_H 1
 #define HAVE_LOCALE_H 1
+/* Forward DCT on the Cortex-M4 DSP instructions, bit-exact with JDCT_ISLOW */
+#define JDCT_DEFAULT JDCT_ISLOW_DSP
 /* #undef NEED_BSD_STRINGS */
 /* #undef NEED_SYS_TYPES_H */
 /* #undef NEED_FAR_POINTERS */
@@ -36,6 +38,7 @@ typedef unsigned char boolean;
 
 /* #undef RIGHT_SHIFT_IS_UNSIGNED */
 #define INLINE __inline
+#define DCT_ISLOW_DSP_SUPPORTED	/* jfdctdsp.c */
 /* These are for configuring the JPEG memory manager. */
 /* #undef DEFAULT_MAX_MEM */
 /* #undef NO_MKTEMP */
@@ -0,0 +1,175 @@
+/*
+ * jmemarena.c
+ *
+ * This file provides a static-arena implementation of the system-
+ * dependent portion of the JPEG memory manager, in place of jmemnobs.c
+ * or jmemansi.c.  All objects come from one array of JPEG_ARENA_SIZE
+ * bytes, so the library never calls malloc() and its worst case RAM use
+ * is fixed at link time.
+ *
+ * Objects are stacked in allocation order.  Freeing an object only marks
+ * it; the top of the stack is then popped past every freed object.  The
+ * memory manager releases the image pool at the end of each image while
+ * the permanent pool (allocated first) stays, so the arena returns to
+ * the same level after every frame and does not fragment.
+ *
+ * No backing store is available: images that need virtual arrays larger
+ * than the free arena space fail with JERR_NO_BACKING_STORE.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jmemsys.h"		/* import the system-dependent declarations */
+#include "jpeg_stream.h"	/* JPEG_ARENA_SIZE */
+
+
+typedef struct {
+  size_t prev;			/* offset of the previous object's header */
+  size_t size;			/* bytes taken by this object, header included */
+  size_t freed;			/* nonzero once released */
+  size_t pad;			/* keep objects 8-byte aligned on 32-bit targets */
+} arena_hdr;
+
+#define ARENA_NONE  ((size_t) -1)
+#define ARENA_ALIGN(n)  (((n) + 7) & ~((size_t) 7))
+
+static union {
+  double align;			/* force alignment of the arena */
+  char mem[JPEG_ARENA_SIZE];
+} arena;
+
+static size_t arena_top = 0;		/* first unused byte */
+static size_t arena_last = ARENA_NONE;	/* header of the topmost object */
+static size_t arena_peak = 0;		/* highest arena_top seen */
+
+
+LOCAL(void *)
+arena_get (size_t sizeofobject)
+{
+  size_t need = SIZEOF(arena_hdr) + ARENA_ALIGN(sizeofobject);
+  arena_hdr * hdr;
+
+  if (need > (size_t) JPEG_ARENA_SIZE - arena_top)
+    return NULL;		/* jmemmgr retries smaller or reports the error */
+
+  hdr = (arena_hdr *) &arena.mem[arena_top];
+  hdr->prev = arena_last;
+  hdr->size = need;
+  hdr->freed = 0;
+  arena_last = arena_top;
+  arena_top += need;
+  if (arena_top > arena_peak)
+    arena_peak = arena_top;
+
+  return (void *) (hdr + 1);
+}
+
+LOCAL(void)
+arena_free (void * object)
+{
+  arena_hdr * hdr = (arena_hdr *) object - 1;
+
+  hdr->freed = 1;
+  while (arena_last != ARENA_NONE) {
+    hdr = (arena_hdr *) &arena.mem[arena_last];
+    if (! hdr->freed)
+      break;
+    arena_top = arena_last;
+    arena_last = hdr->prev;
+  }
+}
+
+
+/*
+ * Small and large objects both come from the arena.
+ */
+
+GLOBAL(void *)
+jpeg_get_small (j_common_ptr cinfo, size_t sizeofobject)
+{
+  return arena_get(sizeofobject);
+}
+
+GLOBAL(void)
+jpeg_free_small (j_common_ptr cinfo, void * object, size_t sizeofobject)
+{
+  arena_free(object);
+}
+
+GLOBAL(void FAR *)
+jpeg_get_large (j_common_ptr cinfo, size_t sizeofobject)
+{
+  return (void FAR *) arena_get(sizeofobject);
+}
+
+GLOBAL(void)
+jpeg_free_large (j_common_ptr cinfo, void FAR * object, size_t sizeofobject)
+{
+  arena_free((void *) object);
+}
+
+
+/*
+ * This routine computes the total memory space available for allocation.
+ * Only what is left in the arena can be promised.
+ */
+
+GLOBAL(long)
+jpeg_mem_available (j_common_ptr cinfo, long min_bytes_needed,
+		    long max_bytes_needed, long already_allocated)
+{
+  long avail = (long) (JPEG_ARENA_SIZE - arena_top) - 4 * (long) SIZEOF(arena_hdr);
+
+  if (avail < 0)
+    avail = 0;
+  return (max_bytes_needed < avail) ? max_bytes_needed : avail;
+}
+
+
+/*
+ * Backing store (temporary file) management.
+ * There is no file system to spill to, so this is an error.
+ */
+
+GLOBAL(void)
+jpeg_open_backing_store (j_common_ptr cinfo, backing_store_ptr info,
+			 long total_bytes_needed)
+{
+  ERREXIT(cinfo, JERR_NO_BACKING_STORE);
+}
+
+
+/*
+ * These routines take care of any system-dependent initialization and
+ * cleanup required.
+ */
+
+GLOBAL(long)
+jpeg_mem_init (j_common_ptr cinfo)
+{
+  return (long) JPEG_ARENA_SIZE;	/* max_memory_to_use is the arena */
+}
+
+GLOBAL(void)
+jpeg_mem_term (j_common_ptr cinfo)
+{
+  /* no work */
+}
+
+
+/*
+ * Arena statistics for the application.
+ */
+
+GLOBAL(size_t)
+jpeg_arena_used (void)
+{
+  return arena_top;
+}
+
+GLOBAL(size_t)
+jpeg_arena_peak (void)
+{
+  return arena_peak;
+}
@@ -0,0 +1,280 @@
+/**************************************************************************//**
+ * @file     jpeg_stream.c
+ * @version  V1.00
+ * @brief    Strip-oriented greyscale JPEG encoder for CCAP packet frames.
+ *           Lines are encoded straight from the CCAP packet buffer in strips
+ *           of JPEG_STRIP_LINES as soon as capture has written them, libjpeg
+ *           memory comes from the static arena in jmemarena.c and the JPEG
+ *           stream goes into a caller-supplied ring.
+ *
+ * @copyright (C) 2019 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <setjmp.h>
+#include "jpeglib.h"
+#include "jpeg_stream.h"
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Error manager. libjpeg errors jump back to the API call instead of calling exit().                     */
+/*---------------------------------------------------------------------------------------------------------*/
+typedef struct
+{
+    struct jpeg_error_mgr pub;
+    jmp_buf jmpJump;
+} STREAM_ERR_T;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Destination manager writing into a JPEG_RING_T                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+typedef struct
+{
+    struct jpeg_destination_mgr pub;
+    JPEG_RING_T *psRing;
+    uint32_t u32Chunk;                      /* Bytes handed to libjpeg by the last RingDest_Next          */
+} RING_DEST_T;
+
+static struct jpeg_compress_struct s_sCinfo;
+static STREAM_ERR_T s_sErr;
+static RING_DEST_T s_sDest;
+static uint32_t s_u32Width, s_u32Height;
+static uint8_t s_u8Open = 0;
+
+static void Stream_ErrorExit(j_common_ptr cinfo)
+{
+    STREAM_ERR_T *psErr = (STREAM_ERR_T *)cinfo->err;
+
+    (*cinfo->err->output_message)(cinfo);
+    longjmp(psErr->jmpJump, 1);
+}
+
+/* Give libjpeg the largest contiguous free part of the ring, waiting for room if it is full.
+   Only called inside JpegStream_EncodeFrame, which catches the timeout jump. */
+static void RingDest_Next(RING_DEST_T *psDest)
+{
+    JPEG_RING_T *psRing = psDest->psRing;
+    uint32_t u32Off, u32Free, u32TimeOutCnt = JPEG_STREAM_TIMEOUT;
+
+    while((psRing->u32Head - psRing->u32Tail) == psRing->u32Size)
+    {
+        if(psRing->pfnDrain)
+            psRing->pfnDrain(psRing);
+        if(--u32TimeOutCnt == 0)
+            longjmp(s_sErr.jmpJump, JPEG_STREAM_ERR_TIMEOUT);
+    }
+
+    u32Off = psRing->u32Head % psRing->u32Size;
+    u32Free = psRing->u32Size - (psRing->u32Head - psRing->u32Tail);
+    psDest->u32Chunk = (u32Free < psRing->u32Size - u32Off) ? u32Free : (psRing->u32Size - u32Off);
+
+    psDest->pub.next_output_byte = &psRing->pu8Buf[u32Off];
+    psDest->pub.free_in_buffer = psDest->u32Chunk;
+}
+
+static void RingDest_Init(j_compress_ptr cinfo)
+{
+    RingDest_Next((RING_DEST_T *)cinfo->dest);
+}
+
+static boolean RingDest_Empty(j_compress_ptr cinfo)
+{
+    RING_DEST_T *psDest = (RING_DEST_T *)cinfo->dest;
+
+    /* libjpeg only calls this with the whole chunk filled */
+    psDest->psRing->u32Head += psDest->u32Chunk;
+    RingDest_Next(psDest);
+
+    return TRUE;
+}
+
+static void RingDest_Term(j_compress_ptr cinfo)
+{
+    RING_DEST_T *psDest = (RING_DEST_T *)cinfo->dest;
+
+    psDest->psRing->u32Head += psDest->u32Chunk - (uint32_t)psDest->pub.free_in_buffer;
+    psDest->u32Chunk = 0;
+}
+
+/**
+  * @brief      Initialize an output ring
+  * @param[in]  psRing      Ring to initialize
+  * @param[in]  pu8Buf      Ring storage
+  * @param[in]  u32Size     Ring size in bytes
+  * @param[in]  pfnDrain    Called by the encoder while the ring is full. It should consume bytes with
+  *                         JpegRing_Read. Pass NULL if the ring is drained from an interrupt.
+  * @return     None
+  */
+void JpegRing_Init(JPEG_RING_T *psRing, uint8_t *pu8Buf, uint32_t u32Size, void (*pfnDrain)(JPEG_RING_T *psRing))
+{
+    psRing->pu8Buf = pu8Buf;
+    psRing->u32Size = u32Size;
+    psRing->u32Head = 0;
+    psRing->u32Tail = 0;
+    psRing->pfnDrain = pfnDrain;
+}
+
+/**
+  * @brief      Take JPEG bytes out of an output ring
+  * @param[in]  psRing      Ring to read
+  * @param[out] pu8Dst      Destination buffer, or NULL to discard the bytes
+  * @param[in]  u32Max      Maximum number of bytes to take
+  * @return     Number of bytes taken
+  * @details    Consecutive frames follow each other in the ring, each one starting with SOI and ending with EOI.
+  */
+uint32_t JpegRing_Read(JPEG_RING_T *psRing, uint8_t *pu8Dst, uint32_t u32Max)
+{
+    uint32_t u32Len = psRing->u32Head - psRing->u32Tail;
+    uint32_t u32Off, u32Part;
+
+    if(u32Len > u32Max)
+        u32Len = u32Max;
+
+    if(pu8Dst)
+    {
+        u32Off = psRing->u32Tail % psRing->u32Size;
+        u32Part = psRing->u32Size - u32Off;
+        if(u32Part > u32Len)
+            u32Part = u32Len;
+        memcpy(pu8Dst, &psRing->pu8Buf[u32Off], u32Part);
+        memcpy(pu8Dst + u32Part, psRing->pu8Buf, u32Len - u32Part);
+    }
+
+    psRing->u32Tail += u32Len;
+
+    return u32Len;
+}
+
+/**
+  * @brief      Create the encoder for greyscale frames
+  * @param[in]  u32Width    Frame width, a multiple of JPEG_STRIP_LINES
+  * @param[in]  u32Height   Frame height, a multiple of JPEG_STRIP_LINES
+  * @param[in]  i32Quality  JPEG quality, 1 to 100
+  * @param[in]  psRing      Ring receiving the JPEG stream
+  * @retval     JPEG_STREAM_OK          Success
+  * @retval     JPEG_STREAM_ERR_PARAM   Frame size is not a multiple of JPEG_STRIP_LINES
+  * @retval     JPEG_STREAM_ERR_LIB     libjpeg could not be set up, e.g. JPEG_ARENA_SIZE is too small
+  * @details    Tables and encoder state are built once here and kept in the permanent pool of the arena,
+  *             so each frame only allocates and frees the per-image pool.
+  */
+int32_t JpegStream_Open(uint32_t u32Width, uint32_t u32Height, int32_t i32Quality, JPEG_RING_T *psRing)
+{
+    if((u32Width == 0) || (u32Height == 0) ||
+            (u32Width % JPEG_STRIP_LINES) || (u32Height % JPEG_STRIP_LINES))
+        return JPEG_STREAM_ERR_PARAM;
+
+    s_sCinfo.err = jpeg_std_error(&s_sErr.pub);
+    s_sErr.pub.error_exit = Stream_ErrorExit;
+    if(setjmp(s_sErr.jmpJump))
+    {
+        jpeg_destroy_compress(&s_sCinfo);
+        return JPEG_STREAM_ERR_LIB;
+    }
+
+    jpeg_create_compress(&s_sCinfo);
+    s_sCinfo.image_width = u32Width;
+    s_sCinfo.image_height = u32Height;
+    s_sCinfo.input_components = 1;
+    s_sCinfo.in_color_space = JCS_GRAYSCALE;
+    jpeg_set_defaults(&s_sCinfo);
+    jpeg_set_quality(&s_sCinfo, i32Quality, TRUE);
+
+    /* Feed downsampled data directly: the CCAP Y-only packet frame already is the component plane */
+    s_sCinfo.raw_data_in = TRUE;
+
+    s_sDest.pub.init_destination = RingDest_Init;
+    s_sDest.pub.empty_output_buffer = RingDest_Empty;
+    s_sDest.pub.term_destination = RingDest_Term;
+    s_sDest.psRing = psRing;
+    s_sDest.u32Chunk = 0;
+    s_sCinfo.dest = &s_sDest.pub;
+
+    s_u32Width = u32Width;
+    s_u32Height = u32Height;
+    s_u8Open = 1;
+
+    return JPEG_STREAM_OK;
+}
+
+/**
+  * @brief      Encode one frame strip by strip while it is being captured
+  * @param[in]  pu8Frame    CCAP packet buffer of the frame, one byte per pixel, stride equal to the width
+  * @param[in]  pu32Lines   Running count of lines captured, over all frames, updated by the CCAP interrupt
+  * @param[in]  u32Base     Value of *pu32Lines when capture of this frame started
+  * @retval     JPEG_STREAM_OK          Frame written to the ring
+  * @retval     JPEG_STREAM_ERR_OVERRUN Capture of the next frame overwrote lines of this frame before they were
+  *                                     encoded. The partial frame stays in the ring without EOI.
+  * @retval     JPEG_STREAM_ERR_TIMEOUT No strip was captured, or the ring stayed full, for JPEG_STREAM_TIMEOUT
+  *                                     loops. The partial frame stays in the ring without EOI.
+  * @retval     JPEG_STREAM_ERR_LIB     libjpeg error
+  * @details    Each strip of JPEG_STRIP_LINES lines is passed to jpeg_write_raw_data as soon as
+  *             *pu32Lines - u32Base covers it, so encoding overlaps capture and no frame copy is made.
+  */
+int32_t JpegStream_EncodeFrame(const uint8_t *pu8Frame, volatile uint32_t *pu32Lines, uint32_t u32Base)
+{
+    JSAMPROW apRows[JPEG_STRIP_LINES];
+    JSAMPARRAY apPlanes[1];
+    uint32_t u32Row, i, u32TimeOutCnt;
+
+    if(!s_u8Open)
+        return JPEG_STREAM_ERR_PARAM;
+
+    switch(setjmp(s_sErr.jmpJump))
+    {
+    case 0:
+        break;
+    case JPEG_STREAM_ERR_TIMEOUT:
+        jpeg_abort_compress(&s_sCinfo);
+        return JPEG_STREAM_ERR_TIMEOUT;
+    default:
+        jpeg_abort_compress(&s_sCinfo);
+        return JPEG_STREAM_ERR_LIB;
+    }
+
+    jpeg_start_compress(&s_sCinfo, TRUE);
+    apPlanes[0] = apRows;
+
+    for(u32Row = 0; u32Row < s_u32Height; u32Row += JPEG_STRIP_LINES)
+    {
+        /* Wait for capture to finish the strip */
+        u32TimeOutCnt = JPEG_STREAM_TIMEOUT;
+        while((uint32_t)(*pu32Lines - u32Base) < u32Row + JPEG_STRIP_LINES)
+        {
+            if(--u32TimeOutCnt == 0)
+            {
+                jpeg_abort_compress(&s_sCinfo);
+                return JPEG_STREAM_ERR_TIMEOUT;
+            }
+        }
+
+        for(i = 0; i < JPEG_STRIP_LINES; i++)
+            apRows[i] = (JSAMPROW)&pu8Frame[(u32Row + i) * s_u32Width];
+        jpeg_write_raw_data(&s_sCinfo, apPlanes, JPEG_STRIP_LINES);
+
+        /* The strip must not have been overwritten by the next frame while it was encoded */
+        if((uint32_t)(*pu32Lines - u32Base) >= s_u32Height + u32Row)
+        {
+            jpeg_abort_compress(&s_sCinfo);
+            return JPEG_STREAM_ERR_OVERRUN;
+        }
+    }
+
+    jpeg_finish_compress(&s_sCinfo);
+
+    return JPEG_STREAM_OK;
+}
+
+/**
+  * @brief      Destroy the encoder and return all arena memory
+  * @return     None
+  */
+void JpegStream_Close(void)
+{
+    if(s_u8Open)
+    {
+        jpeg_destroy_compress(&s_sCinfo);
+        s_u8Open = 0;
+    }
+}
+
+/*** (C) COPYRIGHT 2019 Nuvoton Technology Corp. ***/
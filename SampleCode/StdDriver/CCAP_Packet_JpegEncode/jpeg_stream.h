@@ -0,0 +1,75 @@
+/**************************************************************************//**
+ * @file     jpeg_stream.h
+ * @version  V1.00
+ * @brief    Strip-oriented greyscale JPEG encoder for CCAP packet frames
+ *
+ * @copyright (C) 2019 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef __JPEG_STREAM_H__
+#define __JPEG_STREAM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Configuration                                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+#define JPEG_STRIP_MODE         1           /*!< 1: encode strips while capturing, 0: encode one frame after capture */
+#define JPEG_STRIP_LINES        8           /*!< Lines per strip, one greyscale MCU row                    */
+#define JPEG_FRAME_NUM          100         /*!< Frames encoded by the strip mode demo                     */
+#define JPEG_RING_SIZE          4096        /*!< Output ring size in bytes                                 */
+#define JPEG_STREAM_TIMEOUT     0x2000000   /*!< Busy-wait loops for a strip or for ring room, over a frame time */
+
+#ifndef JPEG_ARENA_SIZE
+#if JPEG_STRIP_MODE
+#define JPEG_ARENA_SIZE         (10*1024)   /*!< Static memory for libjpeg, replaces the heap              */
+#else
+#define JPEG_ARENA_SIZE         (16*1024)   /*!< Whole-frame encode also needs the pre-processing buffers  */
+#endif
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Error codes                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#define JPEG_STREAM_OK          0           /*!< No error                                                  */
+#define JPEG_STREAM_ERR_PARAM   -1          /*!< Frame size is not a multiple of JPEG_STRIP_LINES          */
+#define JPEG_STREAM_ERR_LIB     -2          /*!< libjpeg error, e.g. arena too small                       */
+#define JPEG_STREAM_ERR_OVERRUN -3          /*!< Capture overwrote lines before they were encoded          */
+#define JPEG_STREAM_ERR_TIMEOUT -4          /*!< Capture or the ring consumer stopped                       */
+
+/**
+  * @brief  Output ring. The encoder adds bytes at u32Head; the consumer takes them from u32Tail.
+  *         Both are running byte counts, so u32Head - u32Tail is the number of bytes queued.
+  */
+typedef struct jpeg_ring
+{
+    uint8_t *pu8Buf;                        /*!< Ring storage                                              */
+    uint32_t u32Size;                       /*!< Ring size in bytes                                        */
+    volatile uint32_t u32Head;              /*!< Bytes written by the encoder                              */
+    volatile uint32_t u32Tail;              /*!< Bytes taken by the consumer                               */
+    void (*pfnDrain)(struct jpeg_ring *psRing); /*!< Called when the ring is full, NULL to wait for an ISR consumer */
+} JPEG_RING_T;
+
+void JpegRing_Init(JPEG_RING_T *psRing, uint8_t *pu8Buf, uint32_t u32Size, void (*pfnDrain)(JPEG_RING_T *psRing));
+uint32_t JpegRing_Read(JPEG_RING_T *psRing, uint8_t *pu8Dst, uint32_t u32Max);
+
+int32_t JpegStream_Open(uint32_t u32Width, uint32_t u32Height, int32_t i32Quality, JPEG_RING_T *psRing);
+int32_t JpegStream_EncodeFrame(const uint8_t *pu8Frame, volatile uint32_t *pu32Lines, uint32_t u32Base);
+void JpegStream_Close(void);
+
+size_t jpeg_arena_used(void);
+size_t jpeg_arena_peak(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __JPEG_STREAM_H__ */
+
+/*** (C) COPYRIGHT 2019 Nuvoton Technology Corp. ***/
@@ -10,6 +10,7 @@
  ******************************************************************************/
 #include "NuMicro.h"
 #include "sensor.h"
+#include "jpeg_stream.h"
 #include <stdio.h>
 
 extern void JpegEncode(unsigned char* image, unsigned char* jBuf,unsigned long *jSize,int width,int height);
@@ -18,6 +19,19 @@ extern void JpegEncode(unsigned char* image, unsigned char* jBuf,unsigned long *
 /*------------------------------------------------------------------------------------------*/
 #define PLL_CLOCK       192000000
 
+#define SENSOR_IN_WIDTH             640
+#define SENSOR_IN_HEIGHT            480
+#define SYSTEM_WIDTH                160
+#define SYSTEM_HEIGHT               120
+uint8_t u8FrameBuffer[SYSTEM_WIDTH*SYSTEM_HEIGHT+SYSTEM_WIDTH];
+
+/*------------------------------------------------------------------------------------------*/
+/* Lines captured since start over all frames. The address match interrupt adds a strip    */
+/* each time CCAP passes CMPADDR; the frame end interrupt moves it to the frame boundary.   */
+/*------------------------------------------------------------------------------------------*/
+volatile uint32_t u32CapLines = 0;
+volatile uint32_t u32CapFrameBase = 0;
+
 /*------------------------------------------------------------------------------------------*/
 /* To run CCAPInterruptHandler, when CAP frame end interrupt                                */
 /*------------------------------------------------------------------------------------------*/
@@ -35,17 +49,28 @@ void CCAP_IRQHandler(void)
 {
     uint32_t u32CapInt;
     u32CapInt = CCAP->INT;
+
+    /* Strip end comes before frame end when both are pending */
+    if((u32CapInt & (CCAP_INT_ADDRMIEN_Msk|CCAP_INT_ADDRMINTF_Msk)) == (CCAP_INT_ADDRMIEN_Msk|CCAP_INT_ADDRMINTF_Msk))
+    {
+        CCAP->INT |= CCAP_INT_ADDRMINTF_Msk; /* Clear Address match interrupt */
+        u32CapLines += JPEG_STRIP_LINES;
+        if(u32CapLines - u32CapFrameBase < SYSTEM_HEIGHT - JPEG_STRIP_LINES)
+            CCAP->CMPADDR += SYSTEM_WIDTH*JPEG_STRIP_LINES;    /* Next strip end */
+    }
+
     if( (u32CapInt & (CCAP_INT_VIEN_Msk | CCAP_INT_VINTF_Msk )) == (CCAP_INT_VIEN_Msk | CCAP_INT_VINTF_Msk))
     {
         CCAPInterruptHandler();
         CCAP->INT |= CCAP_INT_VINTF_Msk;        /* Clear Frame end interrupt */
-    }
 
-    if((u32CapInt & (CCAP_INT_ADDRMIEN_Msk|CCAP_INT_ADDRMINTF_Msk)) == (CCAP_INT_ADDRMIEN_Msk|CCAP_INT_ADDRMINTF_Msk))
-    {
-        CCAP->INT |= CCAP_INT_ADDRMINTF_Msk; /* Clear Address match interrupt */
+        /* All lines are in. Next frame restarts at the top of the packet buffer. */
+        u32CapFrameBase += SYSTEM_HEIGHT;
+        u32CapLines = u32CapFrameBase;
+        CCAP->CMPADDR = (uint32_t)u8FrameBuffer + SYSTEM_WIDTH*JPEG_STRIP_LINES;
     }
 
+
     if ((u32CapInt & (CCAP_INT_MEIEN_Msk|CCAP_INT_MEINTF_Msk)) == (CCAP_INT_MEIEN_Msk|CCAP_INT_MEINTF_Msk))
     {
         CCAP->INT |= CCAP_INT_MEINTF_Msk;    /* Clear Memory error interrupt */
@@ -165,12 +190,6 @@ void UART0_Init(void)
     UART_Open(UART0,115200);
 }
 
-#define SENSOR_IN_WIDTH             640
-#define SENSOR_IN_HEIGHT            480
-#define SYSTEM_WIDTH                160
-#define SYSTEM_HEIGHT               120
-uint8_t u8FrameBuffer[SYSTEM_WIDTH*SYSTEM_HEIGHT+SYSTEM_WIDTH];
-
 #define DataFormatAndOrder (CCAP_PAR_INDATORD_YUYV | CCAP_PAR_INFMT_YUV422 | CCAP_PAR_OUTFMT_ONLY_Y)
 
 int PacketFormatDownScale(void)
@@ -221,13 +240,105 @@ int PacketFormatDownScale(void)
 }
 
 
+#if JPEG_STRIP_MODE
+/*------------------------------------------------------------------------------------------*/
+/* Strip mode: each frame is encoded while it is being captured, 8 lines at a time, into a  */
+/* ring. Only the packet buffer, the ring and the libjpeg arena are needed.                 */
+/*------------------------------------------------------------------------------------------*/
+uint8_t u8JpegRing[JPEG_RING_SIZE];
+JPEG_RING_T sJpegRing;
+uint32_t u32JpegBytes = 0;
+
+/* Called by the encoder when the ring is full. A real application sends the bytes to its   */
+/* storage or link here, or drains the ring from an interrupt and passes NULL instead.      */
+void JpegRingDrain(JPEG_RING_T *psRing)
+{
+    u32JpegBytes += JpegRing_Read(psRing, NULL, psRing->u32Size);
+}
+
+int PacketFormatStripEncode(void)
+{
+    uint32_t u32Encoded = 0, u32Overrun = 0, u32Frame;
+    int32_t i32Ret;
+
+    /* Initialize NT99141 sensor and set NT99141 output YUV422 format  */
+    if(InitNT99141_VGA_YUV422()==FALSE) return -1;
+
+    JpegRing_Init(&sJpegRing, u8JpegRing, sizeof(u8JpegRing), JpegRingDrain);
+    if(JpegStream_Open(SYSTEM_WIDTH, SYSTEM_HEIGHT, 85, &sJpegRing) != JPEG_STREAM_OK) return -1;
+
+    /* Enable External CAP Interrupt */
+    NVIC_EnableIRQ(CCAP_IRQn);
+
+    /* Enable frame end and address match interrupt. Address match reports each strip. */
+    CCAP_EnableInt(CCAP_INT_VIEN_Msk | CCAP_INT_ADDRMIEN_Msk);
+
+    /* Set Vsync polarity, Hsync polarity, pixel clock polarity, Sensor Format and Order */
+    CCAP_Open(NT99141SensorPolarity | DataFormatAndOrder, CCAP_CTL_PKTEN );
+
+    /* Set Cropping Window Vertical/Horizontal Starting Address and Cropping Window Size */
+    CCAP_SetCroppingWindow(0,0,SENSOR_IN_HEIGHT,SENSOR_IN_WIDTH);
+
+    /* Set System Memory Packet Base Address Register */
+    CCAP_SetPacketBuf((uint32_t)u8FrameBuffer);
+
+    /* First strip ends where the line after it starts */
+    CCAP->CMPADDR = (uint32_t)u8FrameBuffer + SYSTEM_WIDTH*JPEG_STRIP_LINES;
+
+    /* Set Packet Scaling Vertical/Horizontal Factor Register */
+    CCAP_SetPacketScaling(SYSTEM_HEIGHT,SENSOR_IN_HEIGHT,SYSTEM_WIDTH,SENSOR_IN_WIDTH);
+
+    /* Set Packet Frame Output Pixel Stride Width */
+    CCAP_SetPacketStride(SYSTEM_WIDTH);
+
+    /* Start Image Capture Interface */
+    CCAP_Start();
+
+    /* Skip the frame in progress, then encode each frame as it is captured */
+    u32Frame = u32FramePass;
+    while(u32FramePass == u32Frame);
+    u32Frame = u32FramePass;
+
+    while(u32Encoded + u32Overrun < JPEG_FRAME_NUM)
+    {
+        i32Ret = JpegStream_EncodeFrame(u8FrameBuffer, &u32CapLines, u32CapFrameBase);
+        if(i32Ret == JPEG_STREAM_OK)
+            u32Encoded++;
+        else if(i32Ret == JPEG_STREAM_ERR_OVERRUN)
+            u32Overrun++;
+        else
+        {
+            printf("JPEG stream error %d\n", i32Ret);
+            break;
+        }
+    }
+    u32Frame = u32FramePass - u32Frame;
+
+    /* Stop capturing images */
+    CCAP_Stop(TRUE);
+    JpegStream_Close();
+    JpegRingDrain(&sJpegRing);
+
+    printf("Encoded %d JPEG frames (%d overrun) in %d captured frames\n", u32Encoded, u32Overrun, u32Frame);
+    if(u32Encoded)
+        printf("Average JPEG size %d bytes, libjpeg arena peak %d of %d bytes\n",
+               u32JpegBytes / u32Encoded, (uint32_t)jpeg_arena_peak(), JPEG_ARENA_SIZE);
+    return 0;
+}
+#endif
+
+
 /*---------------------------------------------------------------------------------------------------------*/
 /*  Main Function                                                                                          */
 /*---------------------------------------------------------------------------------------------------------*/
+#if !JPEG_STRIP_MODE
 uint8_t u8JpegBuffer[SYSTEM_WIDTH*SYSTEM_HEIGHT];
+#endif
 int32_t main (void)
 {
+#if !JPEG_STRIP_MODE
     unsigned long u32JpegSize = sizeof(u8JpegBuffer);
+#endif
 
     /* Init System, IP clock and multi-function I/O */
     SYS_Init();
@@ -238,11 +349,16 @@ int32_t main (void)
     /* Init Engine clock and Sensor clock */
     CCAPSetFreq(12000000,12000000);
 
+#if JPEG_STRIP_MODE
+    /* Using Packet format to Image down scale, jpeg encode while capturing */
+    PacketFormatStripEncode();
+#else
     /* Using Packet format to Image down scale */
     if(PacketFormatDownScale()>=0){
         /* jpeg encode */
         JpegEncode(u8FrameBuffer, u8JpegBuffer, &u32JpegSize, SYSTEM_WIDTH, SYSTEM_HEIGHT);
     }
+#endif
 
     while(1);
 }
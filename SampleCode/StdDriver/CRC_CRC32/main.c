@@ -104,10 +104,25 @@ uint32_t GetPDMAChecksum(uint32_t u32Address, uint32_t u32Size)
     return CRC->CHECKSUM;
 }
 
+/* Count CPU cycles with SysTick, enough for up to 2^24 cycles */
+void TimerStart(void)
+{
+    SysTick->LOAD = 0xFFFFFF;
+    SysTick->VAL  = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+uint32_t TimerGet(void)
+{
+    return 0xFFFFFF - SysTick->VAL;
+}
+
 
 int main(void)
 {
-    volatile uint32_t addr, size, u32FMCChecksum, u32CRC32Checksum, u32PDMAChecksum;
+    volatile uint32_t addr, size, u32FMCChecksum, u32CRC32Checksum, u32PDMAChecksum, u32StreamChecksum, u32SwChecksum;
+    uint32_t u32CPUTicks, u32StreamTicks, u32SwTicks;
+    CRC_CTX_T sCtx;
 
     /* Unlock protected registers */
     SYS_UnlockReg();
@@ -127,6 +142,8 @@ int main(void)
     printf("|          a.) FMC checksum command                   |\n");
     printf("|          b.) CPU write CRC data register directly   |\n");
     printf("|          c.) PDMA write CRC data register           |\n");
+    printf("|          d.) CRC context fed by PDMA, 512 bytes/call|\n");
+    printf("|          e.) CRC context fed by software table      |\n");
     printf("+-----------------------------------------------------+\n\n");
 
 
@@ -144,23 +161,53 @@ int main(void)
     /* Configure CRC controller for CRC-CRC32 mode */
     CRC_Open(CRC_32, (CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM), 0xFFFFFFFF, CRC_CPU_WDATA_32);
     /* Start to execute CRC-CRC32 operation */
+    TimerStart();
     for(addr=0; addr<size; addr+=4)
     {
         CRC_WRITE_DATA(inpw(addr));
     }
     u32CRC32Checksum = CRC_GetChecksum();
+    u32CPUTicks = TimerGet();
 
     /*  Case c. */
     /* Configure CRC controller for CRC-CRC32 mode */
     CRC_Open(CRC_32, (CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM), 0xFFFFFFFF, CRC_CPU_WDATA_32);
     u32PDMAChecksum = GetPDMAChecksum(0x0, size);
 
+    /*  Case d. */
+    /* Feed a CRC context in pieces, as an image read from a file would be, with PDMA channel 0 */
+    TimerStart();
+    CRC_Init(&sCtx, CRC_32, (CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM), 0xFFFFFFFF, 0);
+    for(addr=0; addr<size; addr+=512)
+    {
+        if(CRC_Update(&sCtx, (void *)addr, 512) != 0)
+        {
+            printf("\n[PDMA transfer time-out]\n");
+            while(1);
+        }
+    }
+    u32StreamChecksum = CRC_Final(&sCtx);
+    u32StreamTicks = TimerGet();
+
+    /*  Case e. */
+    /* Same context API without CRC engine. The first call also builds the lookup table. */
+    CRC_Init(&sCtx, CRC_32, (CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM), 0xFFFFFFFF, CRC_PDMA_NONE);
+    CRC_SwUpdate(&sCtx, (void *)0x0, 0);
+    TimerStart();
+    CRC_SwUpdate(&sCtx, (void *)0x0, size);
+    u32SwChecksum = CRC_Final(&sCtx);
+    u32SwTicks = TimerGet();
+
     printf("APROM first %d bytes checksum:\n", size);
     printf("   - by FMC command: 0x%08X\n", u32FMCChecksum);
     printf("   - by CPU write:   0x%08X\n", u32CRC32Checksum);
     printf("   - by PDMA write:  0x%08X\n", u32PDMAChecksum);
+    printf("   - by CRC context: 0x%08X\n", u32StreamChecksum);
+    printf("   - by software:    0x%08X\n", u32SwChecksum);
+    printf("CPU cycles: CPU write %d, CRC context %d, software %d\n", u32CPUTicks, u32StreamTicks, u32SwTicks);
 
-    if((u32FMCChecksum == u32CRC32Checksum) && (u32CRC32Checksum == u32PDMAChecksum))
+    if((u32FMCChecksum == u32CRC32Checksum) && (u32CRC32Checksum == u32PDMAChecksum) &&
+            (u32PDMAChecksum == u32StreamChecksum) && (u32StreamChecksum == u32SwChecksum))
     {
         if((u32FMCChecksum == 0) || (u32FMCChecksum == 0xFFFFFFFF))
         {
@@ -0,0 +1,366 @@
+/**************************************************************************//**
+ * @file     eadc_acq.c
+ * @version  V1.00
+ * @brief    Continuous multi-channel EADC acquisition engine
+ *
+ * Sample modules 0 ~ N-1 convert the configured channels on a common trigger,
+ * so every trigger produces one frame of N results in module order. The PDMA
+ * moves each result from EADC_CURDAT into a raw ring of two blocks, walking a
+ * ring of EACQ_DESC_NUM scatter-gather descriptors of half a block each, and
+ * never stops between blocks while the interrupt keeps up.
+ *
+ * Each time a descriptor finishes, EACQ_IRQHandler() de-interleaves that half
+ * block into the per-channel rings, re-arms the descriptor and calls the
+ * callback: EACQ_EVT_HALF after the first half, EACQ_EVT_FULL after the
+ * second. From EACQ_EVT_FULL the block belongs to the application until it
+ * calls EACQ_ReleaseBlock(). A block that would land on a slot still held is
+ * dropped and counted; acquisition itself goes on without a gap.
+ *
+ * The descriptor re-armed last, the one just behind the oldest half not yet
+ * processed, is the guard: it is armed in basic mode, so the PDMA stops after
+ * it instead of overwriting that half. Re-arming the next descriptor moves the
+ * guard on. The interrupt may therefore run up to EACQ_DESC_NUM - 1 half
+ * blocks late; any later and the PDMA stops on the guard, the halves already
+ * captured are still delivered, and EACQ_EVT_OVERRUN ends the acquisition.
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+
+#include "eadc_acq.h"
+
+#define EACQ_DESC_CTL       (PDMA_WIDTH_16 | PDMA_SAR_FIX | PDMA_DAR_INC | PDMA_REQ_SINGLE)
+
+#ifdef __ICCARM__
+#pragma data_alignment=32
+static DSCT_T s_asDesc[EACQ_DESC_NUM];
+#else
+static DSCT_T s_asDesc[EACQ_DESC_NUM] __attribute__((aligned(32)));
+#endif
+
+static EACQ_CFG_T s_sCfg;
+static uint32_t s_u32Opened = 0;
+static volatile uint32_t s_u32Running = 0;
+static uint32_t s_u32HalfLen;               /* halfwords per descriptor */
+static uint32_t s_u32NextDesc;              /* oldest descriptor not processed yet */
+static uint32_t s_u32Blk;                   /* channel ring block being filled */
+static uint32_t s_u32Drop;                  /* current block is being discarded */
+static volatile uint8_t s_au8Held[EACQ_BLK_NUM_MAX];
+static EACQ_STAT_T s_sStat;
+
+/* Load descriptor u32Desc to fill its half of the raw ring; a guard ends the chain there */
+static void EACQ_ArmDesc(uint32_t u32Desc, uint32_t u32Guard)
+{
+    s_asDesc[u32Desc].DA = (uint32_t)&s_sCfg.pu16Raw[u32Desc * s_u32HalfLen];
+    s_asDesc[u32Desc].CTL = ((s_u32HalfLen - 1) << PDMA_DSCT_CTL_TXCNT_Pos) | EACQ_DESC_CTL |
+                            (u32Guard ? PDMA_OP_BASIC : PDMA_OP_SCATTER);
+}
+
+/* Turn the EADC PDMA request on or off for the sample modules of the session */
+static void EACQ_EadcPdma(uint32_t u32On)
+{
+    uint32_t u32Mask = (1UL << s_sCfg.u32ChNum) - 1;
+
+    if (SYS->CSERVER & SYS_CSERVER_VERSION_Msk) /* M480LD */
+    {
+        if (u32On)
+            EADC_ENABLE_SAMPLE_MODULE_PDMA(EADC, u32Mask);
+        else
+            EADC_DISABLE_SAMPLE_MODULE_PDMA(EADC, u32Mask);
+    }
+    else /* M480 */
+    {
+        if (u32On)
+            EADC_ENABLE_PDMA(EADC);
+        else
+            EADC_DISABLE_PDMA(EADC);
+    }
+}
+
+/* Copy raw half u32Desc into the channel rings, one sample per channel per frame */
+static void EACQ_Deinterleave(uint32_t u32Desc, uint32_t u32Half)
+{
+    const uint16_t *pu16Src = &s_sCfg.pu16Raw[u32Desc * s_u32HalfLen];
+    uint32_t u32Frames = s_sCfg.u32BlkFrames / 2;
+    uint32_t u32Off = s_u32Blk * s_sCfg.u32BlkFrames + u32Half * u32Frames;
+    uint32_t u32ChNum = s_sCfg.u32ChNum;
+    uint32_t c, i;
+
+    for (c = 0; c < u32ChNum; c++)
+    {
+        const uint16_t *pu16In = pu16Src + c;
+        uint16_t *pu16Out = s_sCfg.apu16Ch[c] + u32Off;
+
+        for (i = 0; i < u32Frames; i++)
+        {
+            pu16Out[i] = *pu16In;
+            pu16In += u32ChNum;
+        }
+    }
+}
+
+/* Deliver one finished half block */
+static void EACQ_ProcessHalf(uint32_t u32Desc)
+{
+    uint32_t u32Half = u32Desc & 1;
+    uint16_t *apu16Blk[EACQ_CH_MAX];
+    uint32_t c;
+
+    if (u32Half == 0)
+    {
+        /* A new block starts; keep it only if the application gave its slot back */
+        s_u32Drop = s_au8Held[s_u32Blk];
+        if (s_u32Drop)
+            s_sStat.u32Dropped++;
+    }
+
+    if (!s_u32Drop)
+    {
+        EACQ_Deinterleave(u32Desc, u32Half);
+
+        for (c = 0; c < s_sCfg.u32ChNum; c++)
+            apu16Blk[c] = s_sCfg.apu16Ch[c] + s_u32Blk * s_sCfg.u32BlkFrames;
+
+        if (u32Half)
+        {
+            s_au8Held[s_u32Blk] = 1;
+            s_sStat.u32Blocks++;
+        }
+        if (s_sCfg.pfnCallback)
+            s_sCfg.pfnCallback(u32Half ? EACQ_EVT_FULL : EACQ_EVT_HALF, s_u32Blk, apu16Blk);
+    }
+
+    if (u32Half)
+        s_u32Blk = (s_u32Blk + 1) % s_sCfg.u32BlkNum;
+}
+
+/**
+  * @brief      Prepare an acquisition session
+  * @param[in]  psCfg           Session configuration. It is copied, so it may be discarded afterwards.
+  *                             The EADC must be opened by the caller; its trigger source is started
+  *                             by the caller after EACQ_Start.
+  * @retval     EACQ_OK         Success
+  * @retval     EACQ_ERR_PARAM  Invalid parameter
+  * @retval     EACQ_ERR_BUSY   The engine is running
+  */
+int32_t EACQ_Open(const EACQ_CFG_T *psCfg)
+{
+    uint32_t i;
+
+    if (s_u32Running)
+        return EACQ_ERR_BUSY;
+
+    if ((psCfg == NULL) || (psCfg->pu16Raw == NULL) ||
+            (psCfg->u32ChNum == 0) || (psCfg->u32ChNum > EACQ_CH_MAX) ||
+            (psCfg->u32PdmaCh >= PDMA_CH_MAX) ||
+            (psCfg->u32BlkFrames < 2) || (psCfg->u32BlkFrames & 1) ||
+            (psCfg->u32BlkFrames / 2 * psCfg->u32ChNum > 0x10000) ||
+            (psCfg->u32BlkNum < 2) || (psCfg->u32BlkNum > EACQ_BLK_NUM_MAX))
+        return EACQ_ERR_PARAM;
+    for (i = 0; i < psCfg->u32ChNum; i++)
+    {
+        if (psCfg->apu16Ch[i] == NULL)
+            return EACQ_ERR_PARAM;
+    }
+
+    s_sCfg = *psCfg;
+    s_u32HalfLen = s_sCfg.u32BlkFrames / 2 * s_sCfg.u32ChNum;
+
+    /* The descriptors form a fixed ring; only their count is reloaded at run time */
+    for (i = 0; i < EACQ_DESC_NUM; i++)
+    {
+        s_asDesc[i].SA = (uint32_t)&EADC->CURDAT;
+        s_asDesc[i].NEXT = (uint32_t)&s_asDesc[(i + 1) % EACQ_DESC_NUM] - (PDMA->SCATBA);
+    }
+
+    /* Sample module n converts channel n of the session; a common trigger keeps the frame order */
+    for (i = 0; i < s_sCfg.u32ChNum; i++)
+        EADC_ConfigSampleModule(EADC, i, s_sCfg.u32Trigger, s_sCfg.au8Ch[i]);
+
+    s_u32Opened = 1;
+    EACQ_GetStat(NULL, 1);
+
+    return EACQ_OK;
+}
+
+/**
+  * @brief      Stop the engine and release the EADC sample modules and PDMA channel
+  * @details    The sample modules go back to software trigger, so the session trigger no
+  *             longer starts conversions. The PDMA channel is left disabled by EACQ_Stop.
+  */
+void EACQ_Close(void)
+{
+    uint32_t i;
+
+    EACQ_Stop();
+
+    if (s_u32Opened)
+    {
+        for (i = 0; i < s_sCfg.u32ChNum; i++)
+            EADC->SCTL[i] &= ~(EADC_SCTL_EXTFEN_Msk | EADC_SCTL_EXTREN_Msk | EADC_SCTL_TRGSEL_Msk);
+        s_u32Opened = 0;
+    }
+}
+
+/**
+  * @brief      Start acquiring
+  * @retval     EACQ_OK         Success
+  * @retval     EACQ_ERR_PARAM  EACQ_Open was not called
+  * @retval     EACQ_ERR_BUSY   Already running
+  * @details    All blocks are released. Start the trigger source after this call so the
+  *             first PDMA request is the first sample module of a frame.
+  */
+int32_t EACQ_Start(void)
+{
+    uint32_t i, u32Mask;
+
+    if (!s_u32Opened)
+        return EACQ_ERR_PARAM;
+    if (s_u32Running)
+        return EACQ_ERR_BUSY;
+
+    /* The last descriptor is the first guard */
+    for (i = 0; i < EACQ_DESC_NUM; i++)
+        EACQ_ArmDesc(i, i == EACQ_DESC_NUM - 1);
+    for (i = 0; i < EACQ_BLK_NUM_MAX; i++)
+        s_au8Held[i] = 0;
+    s_u32NextDesc = 0;
+    s_u32Blk = 0;
+    s_u32Drop = 0;
+
+    u32Mask = 1UL << s_sCfg.u32PdmaCh;
+    PDMA_CLR_TD_FLAG(PDMA, u32Mask);
+    PDMA_Open(PDMA, u32Mask);
+    PDMA_SetTransferMode(PDMA, s_sCfg.u32PdmaCh, PDMA_EADC0_RX, 1, (uint32_t)&s_asDesc[0]);
+    PDMA_EnableInt(PDMA, s_sCfg.u32PdmaCh, PDMA_INT_TRANS_DONE);
+    NVIC_EnableIRQ(PDMA_IRQn);
+
+    s_u32Running = 1;
+
+    EACQ_EadcPdma(1);
+
+    return EACQ_OK;
+}
+
+/**
+  * @brief      Stop acquiring at once
+  * @details    The half block in progress is discarded. Blocks already delivered stay held
+  *             until they are released or the engine is started again. Stop the trigger
+  *             source first if the EADC is to stay quiet.
+  */
+void EACQ_Stop(void)
+{
+    if (!s_u32Running)
+        return;
+
+    EACQ_EadcPdma(0);
+
+    PDMA_DisableInt(PDMA, s_sCfg.u32PdmaCh, PDMA_INT_TRANS_DONE);
+    PDMA_STOP(PDMA, s_sCfg.u32PdmaCh);
+    PDMA->CHCTL &= ~(1UL << s_sCfg.u32PdmaCh);
+    PDMA_CLR_TD_FLAG(PDMA, 1UL << s_sCfg.u32PdmaCh);
+
+    s_u32Running = 0;
+}
+
+/**
+  * @brief      Give a block delivered by EACQ_EVT_FULL back to the engine
+  * @param[in]  u32Blk  Block index passed to the callback. May be called from the callback.
+  */
+void EACQ_ReleaseBlock(uint32_t u32Blk)
+{
+    if (u32Blk < EACQ_BLK_NUM_MAX)
+        s_au8Held[u32Blk] = 0;
+}
+
+/**
+  * @brief      Check whether the engine is acquiring
+  * @return     1 if acquiring, 0 otherwise. An overrun stops the engine.
+  */
+uint32_t EACQ_IsRunning(void)
+{
+    return s_u32Running;
+}
+
+/**
+  * @brief      Get the acquisition statistics
+  * @param[out] psStat      Statistics, may be NULL
+  * @param[in]  u32Clear    1 to clear the statistics after reading them
+  */
+void EACQ_GetStat(EACQ_STAT_T *psStat, uint32_t u32Clear)
+{
+    uint32_t u32Primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (psStat != NULL)
+        *psStat = s_sStat;
+    if (u32Clear)
+        memset(&s_sStat, 0, sizeof(s_sStat));
+    __set_PRIMASK(u32Primask);
+}
+
+/**
+  * @brief      PDMA interrupt service for the engine. Call it from PDMA_IRQHandler.
+  * @details    Only the transfer done flag of the engine channel is handled and cleared.
+  *             Every half block finished since the last call is delivered, so a late
+  *             interrupt that covers several descriptors loses nothing.
+  */
+void EACQ_IRQHandler(void)
+{
+    uint32_t u32Mask = 1UL << s_sCfg.u32PdmaCh;
+    uint32_t u32Cur, u32Pending, u32Stopped, u32Guard;
+
+    if (!(PDMA_GET_INT_STATUS(PDMA) & PDMA_INTSTS_TDIF_Msk) || !(PDMA_GET_TD_STS(PDMA) & u32Mask))
+        return;
+    PDMA_CLR_TD_FLAG(PDMA, u32Mask);
+
+    if (!s_u32Running)
+        return;
+
+    /*
+     * The PDMA cannot pass the guard, so it is at most EACQ_DESC_NUM - 1 descriptors ahead
+     * and every descriptor before the current one is finished. Once it has stopped, the
+     * current descriptor is a guard and is finished as well. The state is read before the
+     * position so a stop between the two reads is only seen at the next interrupt.
+     */
+    u32Stopped = ((PDMA->DSCT[s_sCfg.u32PdmaCh].CTL & PDMA_DSCT_CTL_OPMODE_Msk) == PDMA_OP_STOP);
+    u32Cur = (PDMA->CURSCAT[s_sCfg.u32PdmaCh] - (uint32_t)&s_asDesc[0]) / sizeof(DSCT_T);
+    u32Pending = (u32Cur + EACQ_DESC_NUM - s_u32NextDesc) % EACQ_DESC_NUM + u32Stopped;
+    if (u32Pending > s_sStat.u32MaxPending)
+        s_sStat.u32MaxPending = u32Pending;
+
+    u32Guard = (s_u32NextDesc + EACQ_DESC_NUM - 1) % EACQ_DESC_NUM;
+    if (u32Pending && !u32Stopped)
+    {
+        /* Re-arm the processed halves with a new guard at the end, then release the old one */
+        while (u32Pending--)
+        {
+            EACQ_ProcessHalf(s_u32NextDesc);
+            EACQ_ArmDesc(s_u32NextDesc, u32Pending == 0);
+            s_u32NextDesc = (s_u32NextDesc + 1) % EACQ_DESC_NUM;
+        }
+        EACQ_ArmDesc(u32Guard, 0);
+    }
+    else
+    {
+        while (u32Pending--)
+        {
+            EACQ_ProcessHalf(s_u32NextDesc);
+            s_u32NextDesc = (s_u32NextDesc + 1) % EACQ_DESC_NUM;
+        }
+    }
+
+    if (u32Stopped)
+    {
+        /* Frames were lost while the PDMA stood still, and the module order can no longer be trusted */
+        s_sStat.u32Overruns++;
+        EACQ_Stop();
+        if (s_sCfg.pfnCallback)
+            s_sCfg.pfnCallback(EACQ_EVT_OVERRUN, s_u32Blk, NULL);
+    }
+}
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
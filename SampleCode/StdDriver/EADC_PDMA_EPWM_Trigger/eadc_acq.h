@@ -0,0 +1,88 @@
+/**************************************************************************//**
+ * @file     eadc_acq.h
+ * @version  V1.00
+ * @brief    Continuous multi-channel EADC acquisition engine header file
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef __EADC_ACQ_H__
+#define __EADC_ACQ_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Configuration                                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+#define EACQ_CH_MAX             8           /*!< Maximum number of channels, one sample module each     */
+#define EACQ_BLK_NUM_MAX        16          /*!< Maximum number of blocks in the per-channel rings      */
+#define EACQ_DESC_NUM           4           /*!< Half-block descriptors in the PDMA ring (two blocks)   */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Error codes                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#define EACQ_OK                 0           /*!< No error                                               */
+#define EACQ_ERR_PARAM          -1          /*!< Invalid parameter                                      */
+#define EACQ_ERR_BUSY           -2          /*!< Engine is already running                              */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Callback events                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+#define EACQ_EVT_HALF           1           /*!< First half of every channel of the block is ready      */
+#define EACQ_EVT_FULL           2           /*!< Whole block is ready and owned by the application      */
+#define EACQ_EVT_OVERRUN        3           /*!< Interrupt was too late, the PDMA stopped; acquisition ended */
+
+/**
+  * @brief  Block callback, called from the PDMA interrupt.
+  * @param  u32Event    EACQ_EVT_HALF, EACQ_EVT_FULL or EACQ_EVT_OVERRUN
+  * @param  u32Blk      Block index in the per-channel rings
+  * @param  ppu16Ch     Start of the block in each channel buffer
+  */
+typedef void (*EACQ_CB_T)(uint32_t u32Event, uint32_t u32Blk, uint16_t * const *ppu16Ch);
+
+/**
+  * @brief  Session configuration
+  */
+typedef struct
+{
+    uint32_t u32ChNum;          /*!< Number of channels, 1 ~ EACQ_CH_MAX. Sample module n converts au8Ch[n]. */
+    uint8_t au8Ch[EACQ_CH_MAX]; /*!< Analog input channel of each sample module               */
+    uint32_t u32Trigger;        /*!< Trigger source of all sample modules, e.g. EADC_EPWM0TG0_TRIGGER */
+    uint32_t u32PdmaCh;         /*!< PDMA channel used for the transfer                       */
+    uint16_t *pu16Raw;          /*!< 2 * u32BlkFrames * u32ChNum halfwords of interleaved PDMA ring */
+    uint32_t u32BlkFrames;      /*!< Samples per channel per block, even, 2 ~ 65536 / u32ChNum * 2 */
+    uint32_t u32BlkNum;         /*!< Blocks in each channel ring, 2 ~ EACQ_BLK_NUM_MAX        */
+    uint16_t *apu16Ch[EACQ_CH_MAX]; /*!< Channel rings of u32BlkNum * u32BlkFrames samples each */
+    EACQ_CB_T pfnCallback;      /*!< Block callback, may be NULL                              */
+} EACQ_CFG_T;
+
+/**
+  * @brief  Acquisition statistics
+  */
+typedef struct
+{
+    uint32_t u32Blocks;         /*!< Blocks delivered with EACQ_EVT_FULL                      */
+    uint32_t u32Dropped;        /*!< Blocks discarded because the application still held the ring slot */
+    uint32_t u32Overruns;       /*!< PDMA stops because the interrupt did not re-arm in time  */
+    uint32_t u32MaxPending;     /*!< Most half blocks waiting at one interrupt, 1 is on time  */
+} EACQ_STAT_T;
+
+int32_t EACQ_Open(const EACQ_CFG_T *psCfg);
+void EACQ_Close(void);
+int32_t EACQ_Start(void);
+void EACQ_Stop(void);
+void EACQ_ReleaseBlock(uint32_t u32Blk);
+uint32_t EACQ_IsRunning(void);
+void EACQ_GetStat(EACQ_STAT_T *psStat, uint32_t u32Clear);
+void EACQ_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __EADC_ACQ_H__ */
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
@@ -6,10 +6,18 @@
  * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
  ******************************************************************************/
 #include <stdio.h>
+#include <string.h>
 #include "NuMicro.h"
+#include "eadc_acq.h"
 
 #define PLL_CLOCK       192000000
 
+#define ACQ_CH_NUM      4           /* PB.0 ~ PB.3, EADC0_CH0 ~ EADC0_CH3 */
+#define ACQ_BLK_FRAMES  256         /* Samples per channel per block */
+#define ACQ_BLK_NUM     4           /* Blocks in each channel ring */
+#define ACQ_RUN_BLOCKS  200         /* Blocks consumed by the continuous acquisition test */
+#define ACQ_EPWM_CNR    4799        /* 96 MHz / 4800 = 20 kHz frame rate */
+
 /*---------------------------------------------------------------------------------------------------------*/
 /* Define global variables and constants                                                                   */
 /*---------------------------------------------------------------------------------------------------------*/
@@ -18,6 +26,13 @@ volatile uint32_t g_u32IsTestOver = 0;
 int16_t  g_i32ConversionData[6] = {0};
 uint32_t g_u32SampleModuleNum = 0;
 
+/* Continuous acquisition buffers */
+uint16_t g_au16AcqRaw[2 * ACQ_BLK_FRAMES * ACQ_CH_NUM];
+uint16_t g_au16AcqCh[ACQ_CH_NUM][ACQ_BLK_NUM * ACQ_BLK_FRAMES];
+volatile uint8_t g_au8AcqQueue[ACQ_BLK_NUM];
+volatile uint32_t g_u32AcqHead = 0, g_u32AcqTail = 0;
+volatile uint32_t g_u32AcqOverrun = 0;
+
 
 void EADC00_IRQHandler(void)
 {
@@ -147,6 +162,93 @@ void ReloadPDMA()
 }
 
 
+/* Called from the PDMA interrupt: queue full blocks for the main loop */
+void AcqCallback(uint32_t u32Event, uint32_t u32Blk, uint16_t * const *ppu16Ch)
+{
+    if(u32Event == EACQ_EVT_FULL)
+    {
+        g_au8AcqQueue[g_u32AcqHead % ACQ_BLK_NUM] = (uint8_t)u32Blk;
+        g_u32AcqHead++;
+    }
+    else if(u32Event == EACQ_EVT_OVERRUN)
+        g_u32AcqOverrun = 1;
+}
+
+void EADC_ContinuousTest()
+{
+    EACQ_CFG_T sCfg;
+    EACQ_STAT_T sStat;
+    uint32_t au32Sum[ACQ_CH_NUM] = {0};
+    uint32_t u32Blk, u32Count = 0, c, i;
+
+    memset(&sCfg, 0, sizeof(sCfg));
+    sCfg.u32ChNum = ACQ_CH_NUM;
+    for(c = 0; c < ACQ_CH_NUM; c++)
+    {
+        sCfg.au8Ch[c] = (uint8_t)c;
+        sCfg.apu16Ch[c] = g_au16AcqCh[c];
+    }
+    sCfg.u32Trigger = EADC_EPWM0TG0_TRIGGER;
+    sCfg.u32PdmaCh = 2;
+    sCfg.pu16Raw = g_au16AcqRaw;
+    sCfg.u32BlkFrames = ACQ_BLK_FRAMES;
+    sCfg.u32BlkNum = ACQ_BLK_NUM;
+    sCfg.pfnCallback = AcqCallback;
+
+    /* Set input mode as single-end and enable the A/D converter */
+    EADC_Open(EADC, EADC_CTL_DIFFEN_SINGLE_END);
+
+    if(EACQ_Open(&sCfg) != EACQ_OK)
+    {
+        printf("EACQ_Open failed!\n");
+        return;
+    }
+
+    g_u32AcqHead = g_u32AcqTail = 0;
+    g_u32AcqOverrun = 0;
+    EACQ_Start();
+
+    /* Sample 4 channels at 20 kHz */
+    EPWM_SET_CNR(EPWM0, 0, ACQ_EPWM_CNR);
+    EPWM_SET_CMR(EPWM0, 0, ACQ_EPWM_CNR / 2);
+    EPWM_Start(EPWM0, BIT0);
+
+    while((u32Count < ACQ_RUN_BLOCKS) && !g_u32AcqOverrun)
+    {
+        if(g_u32AcqHead == g_u32AcqTail)
+            continue;
+
+        /* The block stays valid until it is released */
+        u32Blk = g_au8AcqQueue[g_u32AcqTail % ACQ_BLK_NUM];
+        for(c = 0; c < ACQ_CH_NUM; c++)
+        {
+            const uint16_t *pu16Data = &g_au16AcqCh[c][u32Blk * ACQ_BLK_FRAMES];
+            for(i = 0; i < ACQ_BLK_FRAMES; i++)
+                au32Sum[c] += pu16Data[i];
+        }
+        EACQ_ReleaseBlock(u32Blk);
+        g_u32AcqTail++;
+        u32Count++;
+    }
+
+    EPWM_ForceStop(EPWM0, BIT0);
+    EACQ_Close();
+
+    /* Restore the settings of the single conversion tests */
+    EPWM_SET_CNR(EPWM0, 0, 216);
+    EPWM_SET_CMR(EPWM0, 0, 108);
+    PDMA_Init();
+
+    EACQ_GetStat(&sStat, 1);
+    printf("Blocks: %d, dropped: %d, overruns: %d, max pending halves: %d\n",
+           sStat.u32Blocks, sStat.u32Dropped, sStat.u32Overruns, sStat.u32MaxPending);
+    if(u32Count)
+    {
+        for(c = 0; c < ACQ_CH_NUM; c++)
+            printf("  Channel %d mean: 0x%X\n", c, au32Sum[c] / (u32Count * ACQ_BLK_FRAMES));
+    }
+}
+
 void EADC_FunctionTest()
 {
     uint8_t  u8Option;
@@ -166,6 +268,7 @@ void EADC_FunctionTest()
         printf("Select input mode:\n");
         printf("  [1] Single end input (channel 2 only)\n");
         printf("  [2] Differential input (channel pair 1 only(channel 2 and 3))\n");
+        printf("  [3] Continuous acquisition (channel 0 ~ 3, 20 kHz)\n");
         printf("  Other keys: exit single mode test\n");
         u8Option = getchar();
         if(u8Option == '1')
@@ -232,6 +335,10 @@ void EADC_FunctionTest()
                 printf("                                0x%X (%d)\n", g_i32ConversionData[g_u32COVNUMFlag], g_i32ConversionData[g_u32COVNUMFlag]);
 
         }
+        else if(u8Option == '3')
+        {
+            EADC_ContinuousTest();
+        }
         else
             return ;
 
@@ -244,6 +351,13 @@ void PDMA_IRQHandler(void)
 {
     uint32_t status = PDMA_GET_INT_STATUS(PDMA);
 
+    /* Continuous acquisition owns channel 2 while it runs */
+    if(EACQ_IsRunning())
+    {
+        EACQ_IRQHandler();
+        return;
+    }
+
     if(status & PDMA_INTSTS_ABTIF_Msk)    /* abort */
     {
         if(PDMA_GET_ABORT_STS(PDMA) & PDMA_ABTSTS_ABTIF2_Msk)
@@ -0,0 +1,175 @@
+/*************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    An IEEE 1588 (PTPv2) ordinary clock on the EMAC time stamp
+ *           counter. The board becomes master if it hears no better clock,
+ *           or synchronizes its counter to the master. Offset and path
+ *           delay statistics are printed every few seconds. Run ptp4l on a
+ *           PC on the same link, e.g. "ptp4l -i eth0 -m", to test it.
+ *
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+
+#include "lwip/netif.h"
+#include "lwip/sys.h"
+#include "lwip/timeouts.h"
+#include "lwip/init.h"
+#include "ptp_port.h"
+
+#define STAT_PERIOD     8000    /* Statistics print period in ms */
+
+// Our MAC address
+uint8_t g_au8MacAddr[6] = {0x00, 0x00, 0x00, 0x59, 0x16, 0x88};
+
+static PTP_T s_sPtp;
+
+void SYS_Init(void)
+{
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Set XT1_OUT(PF.2) and XT1_IN(PF.3) to input mode */
+    PF->MODE &= ~(GPIO_MODE_MODE2_Msk | GPIO_MODE_MODE3_Msk);
+
+    /* Enable External XTAL (4~24 MHz) */
+    CLK_EnableXtalRC(CLK_PWRCTL_HXTEN_Msk);
+
+    /* Waiting for 12MHz clock ready */
+    CLK_WaitClockReady( CLK_STATUS_HXTSTB_Msk);
+
+    /* Set core clock as PLL_CLOCK from PLL */
+    CLK_SetCoreClock(FREQ_192MHZ);
+
+    /* Set both PCLK0 and PCLK1 as HCLK/2 */
+    CLK->PCLKDIV = CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2;
+
+    /* Enable IP clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+    CLK_EnableModuleClock(EMAC_MODULE);
+    CLK_EnableModuleClock(TMR0_MODULE);
+
+    /* Select IP clock source */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HXT, CLK_CLKDIV0_UART0(1));
+    CLK_SetModuleClock(TMR0_MODULE, CLK_CLKSEL1_TMR0SEL_HXT, 0);
+
+    // Configure MDC clock rate to HCLK / (127 + 1) = 1.5 MHz if system is running at 192 MHz
+    CLK_SetModuleClock(EMAC_MODULE, 0, CLK_CLKDIV3_EMAC(127));
+
+    /* Update System Core Clock */
+    /* User can use SystemCoreClockUpdate() to calculate SystemCoreClock. */
+    SystemCoreClockUpdate();
+
+    /* Set GPB multi-function pins for UART0 RXD and TXD */
+    SYS->GPB_MFPH &= ~(SYS_GPB_MFPH_PB12MFP_Msk | SYS_GPB_MFPH_PB13MFP_Msk);
+    SYS->GPB_MFPH |= (SYS_GPB_MFPH_PB12MFP_UART0_RXD | SYS_GPB_MFPH_PB13MFP_UART0_TXD);
+    // Configure RMII pins
+    SYS->GPA_MFPL |= SYS_GPA_MFPL_PA6MFP_EMAC_RMII_RXERR | SYS_GPA_MFPL_PA7MFP_EMAC_RMII_CRSDV;
+    SYS->GPC_MFPL |= SYS_GPC_MFPL_PC6MFP_EMAC_RMII_RXD1 | SYS_GPC_MFPL_PC7MFP_EMAC_RMII_RXD0;
+    SYS->GPC_MFPH |= SYS_GPC_MFPH_PC8MFP_EMAC_RMII_REFCLK;
+    SYS->GPE_MFPH |= SYS_GPE_MFPH_PE8MFP_EMAC_RMII_MDC |
+                     SYS_GPE_MFPH_PE9MFP_EMAC_RMII_MDIO |
+                     SYS_GPE_MFPH_PE10MFP_EMAC_RMII_TXD0 |
+                     SYS_GPE_MFPH_PE11MFP_EMAC_RMII_TXD1 |
+                     SYS_GPE_MFPH_PE12MFP_EMAC_RMII_TXEN;
+
+    // Enable high slew rate on all RMII TX output pins
+    PE->SLEWCTL = (GPIO_SLEWCTL_HIGH << GPIO_SLEWCTL_HSREN10_Pos) |
+                  (GPIO_SLEWCTL_HIGH << GPIO_SLEWCTL_HSREN11_Pos) |
+                  (GPIO_SLEWCTL_HIGH << GPIO_SLEWCTL_HSREN12_Pos);
+    /* Lock protected registers */
+    SYS_LockReg();
+
+}
+
+void PrintStat(void)
+{
+    static const char *const s_apcState[] = {"listening", "master", "slave"};
+    static const char *const s_apcServo[] = {"unlocked", "tracking", "locked"};
+    PTP_STAT_T sStat;
+    uint32_t u32Sec, u32Nsec;
+
+    PTP_GetStat(&s_sPtp, &sStat, 1);
+    EMAC_GetTime(&u32Sec, &u32Nsec);
+
+    printf("[%6d.%09d] %s", u32Sec, u32Nsec, s_apcState[sStat.u32State]);
+    if (sStat.u32State == PTP_STATE_SLAVE)
+    {
+        printf(" %s, %d offsets: last %d mean %d rms %d min %d max %d ns, delay %d (%d~%d) ns, %d ppb, %d steps, %d outliers",
+               s_apcServo[sStat.u32Servo], sStat.u32Samples, sStat.i32OffsetLast, sStat.i32OffsetMean, sStat.u32OffsetRms,
+               sStat.i32OffsetMin, sStat.i32OffsetMax, sStat.i32DelayMean, sStat.i32DelayMin, sStat.i32DelayMax,
+               sStat.i32Ppb, sStat.u32Steps, sStat.u32Outliers);
+    }
+    printf("\n");
+}
+
+int main(void)
+{
+    struct netif netif;
+    ip_addr_t ipaddr;
+    ip_addr_t netmask;
+    ip_addr_t gw;
+    uint32_t u32StatDue;
+
+    SYS_Init();
+    UART_Open(UART0, 115200);
+
+    // Set timer frequency to 100HZ
+    TIMER_Open(TIMER0, TIMER_PERIODIC_MODE, 100);
+
+    // Enable timer interrupt
+    TIMER_EnableInt(TIMER0);
+    NVIC_EnableIRQ(TMR0_IRQn);
+
+    // Start Timer 0
+    TIMER_Start(TIMER0);
+
+    printf("M480 PTP sample code start\n");
+
+    IP4_ADDR(&gw, 192, 168, 0, 99);
+    IP4_ADDR(&ipaddr, 192, 168, 0, 227);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+
+    lwip_init();
+    // The MAC address is the netif state, PTPPort_NetifInit() opens the EMAC with it
+    netif_add(&netif, &ipaddr, &netmask, &gw, g_au8MacAddr, PTPPort_NetifInit, netif_input);
+    netif.name[0] = 'e';
+    netif.name[1] = '0';
+
+    netif_set_default(&netif);
+    netif_set_up(&netif);
+    netif_set_link_up(&netif);
+
+    PTP_Init(&s_sPtp, &g_sPtpPort, g_au8MacAddr, sys_now());
+    if (PTPPort_Open(&s_sPtp, &netif) < 0)
+    {
+        printf("Failed to open PTP ports\n");
+        while (1);
+    }
+
+    u32StatDue = sys_now() + STAT_PERIOD;
+    while (1)
+    {
+        /* Received frames and Tx time stamps */
+        PTPPort_Poll(&netif);
+
+        /* Cyclic lwIP timers check */
+        sys_check_timeouts();
+
+        /* Sync, Announce and Delay_Req timers */
+        PTP_Poll(&s_sPtp, sys_now());
+
+        if ((int32_t)(sys_now() - u32StatDue) >= 0)
+        {
+            u32StatDue += STAT_PERIOD;
+            PrintStat();
+        }
+    }
+}
+
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,595 @@
+/**************************************************************************//**
+ * @file     ptp.c
+ * @version  V1.00
+ * @brief    IEEE 1588-2008 (PTPv2) ordinary clock.
+ *
+ *           As master, the clock sends two-step Sync, Follow_Up and Announce
+ *           messages and answers Delay_Req. As slave, each Sync/Follow_Up pair
+ *           gives t1 and t2, each Delay_Req/Delay_Resp pair gives t3 and t4:
+ *             path delay = ((t2 - t1) + (t4 - t3)) / 2
+ *             offset     = t2 - t1 - path delay
+ *           An offset beyond PTP_STEP_THRESHOLD steps the clock, smaller ones
+ *           go to a PI servo which sets the clock rate.
+ *
+ *           Master election is reduced to the comparison of the Announce data
+ *           set (priority1, clock quality, priority2, identity). The clock is
+ *           slave of the best master it hears of, if that one is better than
+ *           itself, and master otherwise.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <string.h>
+
+#include "ptp.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+#define PTP_MSG_SYNC            0x0
+#define PTP_MSG_DELAY_REQ       0x1
+#define PTP_MSG_FOLLOW_UP       0x8
+#define PTP_MSG_DELAY_RESP      0x9
+#define PTP_MSG_ANNOUNCE        0xB
+
+#define PTP_HDR_SIZE            34
+#define PTP_SYNC_SIZE           44      /* also Delay_Req and Follow_Up */
+#define PTP_DELAY_RESP_SIZE     54
+#define PTP_ANNOUNCE_SIZE       64
+
+#define PTP_FLAG_TWO_STEP       0x02    /* flagField[0] */
+#define PTP_DS_OFFSET           47      /* Announce grandmasterPriority1 ~ grandmasterIdentity */
+#define PTP_DS_SIZE             14
+
+#define NSEC_PER_SEC            1000000000LL
+
+static void PutU16(uint8_t *pu8, uint32_t u32)
+{
+    pu8[0] = (uint8_t)(u32 >> 8);
+    pu8[1] = (uint8_t)u32;
+}
+
+static void PutU32(uint8_t *pu8, uint32_t u32)
+{
+    pu8[0] = (uint8_t)(u32 >> 24);
+    pu8[1] = (uint8_t)(u32 >> 16);
+    pu8[2] = (uint8_t)(u32 >> 8);
+    pu8[3] = (uint8_t)u32;
+}
+
+static uint32_t GetU16(const uint8_t *pu8)
+{
+    return ((uint32_t)pu8[0] << 8) | pu8[1];
+}
+
+static uint32_t GetU32(const uint8_t *pu8)
+{
+    return ((uint32_t)pu8[0] << 24) | ((uint32_t)pu8[1] << 16) | ((uint32_t)pu8[2] << 8) | pu8[3];
+}
+
+/* correctionField is ns * 2^16 */
+static int64_t GetCorrection(const uint8_t *pu8Msg)
+{
+    int64_t i64 = (int64_t)(((uint64_t)GetU32(pu8Msg + 8) << 32) | GetU32(pu8Msg + 12));
+    return i64 / 65536;
+}
+
+static int64_t TimeToNs(const PTP_TIME_T *psTime)
+{
+    return (int64_t)psTime->u32Sec * NSEC_PER_SEC + psTime->u32Nsec;
+}
+
+/* 10 byte Timestamp, the upper 16 bits of the 48 bit seconds are dropped */
+static int64_t GetTimestamp(const uint8_t *pu8)
+{
+    PTP_TIME_T sTime;
+
+    sTime.u32Sec = GetU32(pu8 + 2);
+    sTime.u32Nsec = GetU32(pu8 + 6);
+    return TimeToNs(&sTime);
+}
+
+static void PutTimestamp(uint8_t *pu8, const PTP_TIME_T *psTime)
+{
+    PutU16(pu8, 0);
+    PutU32(pu8 + 2, psTime->u32Sec);
+    PutU32(pu8 + 6, psTime->u32Nsec);
+}
+
+static uint32_t IntervalMs(int32_t i32Log)
+{
+    return (i32Log >= 0) ? (1000UL << i32Log) : (1000UL >> -i32Log);
+}
+
+static uint32_t IsDue(uint32_t u32NowMs, uint32_t u32Due)
+{
+    return ((int32_t)(u32NowMs - u32Due) >= 0) ? 1 : 0;
+}
+
+static uint32_t Isqrt(uint64_t u64)
+{
+    uint64_t r = 0, b = (uint64_t)1 << 62;
+
+    while (b > u64)
+        b >>= 2;
+    while (b != 0)
+    {
+        if (u64 >= r + b)
+        {
+            u64 -= r + b;
+            r = (r >> 1) + b;
+        }
+        else
+            r >>= 1;
+        b >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+static void BuildHeader(PTP_T *psPtp, uint8_t *pu8Msg, uint32_t u32Type, uint32_t u32Len, uint32_t u32Seq,
+                        uint32_t u32Control, int32_t i32LogInterval)
+{
+    memset(pu8Msg, 0, u32Len);
+    pu8Msg[0] = (uint8_t)u32Type;
+    pu8Msg[1] = 2;                                  /* versionPTP */
+    PutU16(pu8Msg + 2, u32Len);
+    pu8Msg[4] = PTP_DOMAIN;
+    memcpy(pu8Msg + 20, psPtp->au8PortId, 10);
+    PutU16(pu8Msg + 30, u32Seq);
+    pu8Msg[32] = (uint8_t)u32Control;
+    pu8Msg[33] = (uint8_t)i32LogInterval;
+}
+
+/* Our own Announce data set, in the order of PTP_DS_OFFSET */
+static void GetOwnDs(PTP_T *psPtp, uint8_t au8Ds[PTP_DS_SIZE])
+{
+    au8Ds[0] = PTP_PRIORITY1;
+    au8Ds[1] = PTP_CLOCK_CLASS;
+    au8Ds[2] = PTP_CLOCK_ACCURACY;
+    PutU16(&au8Ds[3], PTP_CLOCK_VARIANCE);
+    au8Ds[5] = PTP_PRIORITY2;
+    memcpy(&au8Ds[6], psPtp->au8PortId, 8);
+}
+
+static void ClearMeasure(PTP_T *psPtp)
+{
+    psPtp->u32SyncValid = 0;
+    psPtp->u32PairValid = 0;
+    psPtp->u32T3Valid = 0;
+    psPtp->u32T4Valid = 0;
+    psPtp->u32TxPending = 0;
+}
+
+static void EnterMaster(PTP_T *psPtp, uint32_t u32NowMs)
+{
+    psPtp->u32State = PTP_STATE_MASTER;
+    psPtp->u32AnnounceDue = u32NowMs;
+    psPtp->u32SyncDue = u32NowMs;
+    ClearMeasure(psPtp);
+}
+
+static void EnterSlave(PTP_T *psPtp, const uint8_t *pu8Msg, uint32_t u32NowMs)
+{
+    psPtp->u32State = PTP_STATE_SLAVE;
+    memcpy(psPtp->au8ParentId, pu8Msg + 20, 10);
+    psPtp->u32DelayReqDue = u32NowMs;
+    psPtp->u32DelayValid = 0;
+    psPtp->u32Servo = PTP_SERVO_UNLOCKED;
+    ClearMeasure(psPtp);
+}
+
+static void SendAnnounce(PTP_T *psPtp)
+{
+    uint8_t au8Msg[PTP_ANNOUNCE_SIZE];
+    PTP_TIME_T sTime;
+
+    BuildHeader(psPtp, au8Msg, PTP_MSG_ANNOUNCE, PTP_ANNOUNCE_SIZE, psPtp->u16AnnounceSeq++, 5, PTP_LOG_ANNOUNCE_INTERVAL);
+    psPtp->psPort->pfnGetTime(&sTime);
+    PutTimestamp(au8Msg + 34, &sTime);
+    PutU16(au8Msg + 44, 37);                        /* currentUtcOffset */
+    GetOwnDs(psPtp, au8Msg + PTP_DS_OFFSET);
+    PutU16(au8Msg + 61, 0);                         /* stepsRemoved */
+    au8Msg[63] = 0xA0;                              /* timeSource: internal oscillator */
+    psPtp->psPort->pfnSend(0, au8Msg, PTP_ANNOUNCE_SIZE);
+}
+
+/* Send Sync or Delay_Req. Its Tx time stamp comes by PTP_TxStamp(). */
+static void SendEvent(PTP_T *psPtp, uint32_t u32Type, uint16_t u16Seq)
+{
+    uint8_t au8Msg[PTP_SYNC_SIZE];
+    PTP_TIME_T sTime;
+
+    if (u32Type == PTP_MSG_SYNC)
+    {
+        BuildHeader(psPtp, au8Msg, PTP_MSG_SYNC, PTP_SYNC_SIZE, u16Seq, 0, PTP_LOG_SYNC_INTERVAL);
+        au8Msg[6] = PTP_FLAG_TWO_STEP;
+    }
+    else
+        BuildHeader(psPtp, au8Msg, PTP_MSG_DELAY_REQ, PTP_SYNC_SIZE, u16Seq, 1, 0x7F);
+
+    psPtp->psPort->pfnGetTime(&sTime);
+    PutTimestamp(au8Msg + 34, &sTime);              /* rough originTimestamp */
+
+    psPtp->u32TxPending = u32Type + 1;
+    psPtp->u16TxSeq = u16Seq;
+    psPtp->i64TxSent = TimeToNs(&sTime);
+    if (psPtp->psPort->pfnSend(1, au8Msg, PTP_SYNC_SIZE) != 0)
+        psPtp->u32TxPending = 0;
+}
+
+static void UpdateStat(PTP_T *psPtp, int32_t i32Offset)
+{
+    PTP_STAT_T *psStat = &psPtp->sStat;
+
+    if (psStat->u32Samples == 0)
+        psStat->i32OffsetMin = psStat->i32OffsetMax = i32Offset;
+    if (i32Offset < psStat->i32OffsetMin)
+        psStat->i32OffsetMin = i32Offset;
+    if (i32Offset > psStat->i32OffsetMax)
+        psStat->i32OffsetMax = i32Offset;
+    psStat->i32OffsetLast = i32Offset;
+    psStat->u32Samples++;
+    psPtp->i64OffsetSum += i32Offset;
+    psPtp->u64OffsetSq += (uint64_t)((int64_t)i32Offset * i32Offset);
+}
+
+/* PI servo. Offset is slave minus master in ns, fInterval is the Sync interval in seconds. */
+static void Servo(PTP_T *psPtp, int64_t i64Offset, float fInterval)
+{
+    float fPpb;
+
+    if ((psPtp->u32Servo == PTP_SERVO_UNLOCKED) || (i64Offset > PTP_STEP_THRESHOLD) || (i64Offset < -PTP_STEP_THRESHOLD))
+    {
+        psPtp->psPort->pfnStepTime(-i64Offset);
+        psPtp->sStat.u32Steps++;
+        psPtp->u32Servo = PTP_SERVO_TRACKING;
+        /* time stamps taken before the step don't fit with the later ones */
+        ClearMeasure(psPtp);
+        return;
+    }
+
+    if ((psPtp->u32Servo == PTP_SERVO_LOCKED) && ((i64Offset > PTP_OUTLIER_NS) || (i64Offset < -PTP_OUTLIER_NS)) &&
+            (psPtp->u32OffsetOutliers < PTP_OUTLIER_MAX))
+    {
+        psPtp->u32OffsetOutliers++;
+        psPtp->sStat.u32Outliers++;
+        return;
+    }
+    psPtp->u32OffsetOutliers = 0;
+
+    UpdateStat(psPtp, (int32_t)i64Offset);
+
+    psPtp->fFreq += PTP_SERVO_KI * (float)i64Offset / fInterval;
+    if (psPtp->fFreq > PTP_SERVO_MAX_PPB)
+        psPtp->fFreq = PTP_SERVO_MAX_PPB;
+    else if (psPtp->fFreq < -PTP_SERVO_MAX_PPB)
+        psPtp->fFreq = -PTP_SERVO_MAX_PPB;
+
+    /* slave ahead of master, slow down */
+    fPpb = -(psPtp->fFreq + PTP_SERVO_KP * (float)i64Offset / fInterval);
+    if (fPpb > PTP_SERVO_MAX_PPB)
+        fPpb = PTP_SERVO_MAX_PPB;
+    else if (fPpb < -PTP_SERVO_MAX_PPB)
+        fPpb = -PTP_SERVO_MAX_PPB;
+
+    psPtp->i32Ppb = (int32_t)fPpb;
+    psPtp->psPort->pfnAdjFreq(psPtp->i32Ppb);
+
+    if ((i64Offset < PTP_LOCK_THRESHOLD) && (i64Offset > -PTP_LOCK_THRESHOLD))
+        psPtp->u32Servo = PTP_SERVO_LOCKED;
+    else
+        psPtp->u32Servo = PTP_SERVO_TRACKING;
+}
+
+/* t1 and t2 are known */
+static void SyncDone(PTP_T *psPtp, int32_t i32LogInterval)
+{
+    psPtp->u32PairValid = 1;
+    if (psPtp->u32DelayValid)
+        Servo(psPtp, psPtp->i64T2 - psPtp->i64T1 - psPtp->i32Delay, (i32LogInterval >= 0) ?
+              (float)(1UL << i32LogInterval) : 1.0f / (float)(1UL << -i32LogInterval));
+}
+
+/* t3 and t4 are known */
+static void DelayDone(PTP_T *psPtp)
+{
+    PTP_STAT_T *psStat = &psPtp->sStat;
+    int32_t i32Delay;
+
+    psPtp->u32T3Valid = 0;
+    psPtp->u32T4Valid = 0;
+    if (!psPtp->u32PairValid)
+        return;
+
+    i32Delay = (int32_t)(((psPtp->i64T2 - psPtp->i64T1) + (psPtp->i64T4 - psPtp->i64T3)) / 2);
+    if (i32Delay < 0)
+        return;     /* not possible for a valid pair */
+
+    if (!psPtp->u32DelayValid)
+    {
+        psPtp->i32Delay = i32Delay;
+        psStat->i32DelayMin = psStat->i32DelayMax = i32Delay;
+        psPtp->u32DelayValid = 1;
+    }
+    else if ((i32Delay > psPtp->i32Delay + PTP_OUTLIER_NS) && (psPtp->u32DelayOutliers < PTP_OUTLIER_MAX))
+    {
+        psPtp->u32DelayOutliers++;
+        psStat->u32Outliers++;
+        return;
+    }
+    else
+        psPtp->i32Delay += (i32Delay - psPtp->i32Delay) / (1 << PTP_DELAY_FILTER);
+    psPtp->u32DelayOutliers = 0;
+
+    if (i32Delay < psStat->i32DelayMin)
+        psStat->i32DelayMin = i32Delay;
+    if (i32Delay > psStat->i32DelayMax)
+        psStat->i32DelayMax = i32Delay;
+}
+
+static void AnnounceInput(PTP_T *psPtp, const uint8_t *pu8Msg, uint32_t u32NowMs)
+{
+    uint8_t au8Own[PTP_DS_SIZE];
+    const uint8_t *pu8Ds = pu8Msg + PTP_DS_OFFSET;
+    uint32_t u32Timeout = PTP_ANNOUNCE_TIMEOUT * IntervalMs((int8_t)pu8Msg[33]);
+
+    GetOwnDs(psPtp, au8Own);
+
+    if ((psPtp->u32State == PTP_STATE_SLAVE) && (memcmp(pu8Msg + 20, psPtp->au8ParentId, 10) == 0))
+    {
+        memcpy(psPtp->au8ParentDs, pu8Ds, PTP_DS_SIZE);
+        psPtp->u32AnnounceDue = u32NowMs + u32Timeout;
+        if ((memcmp(pu8Ds, au8Own, PTP_DS_SIZE) > 0) && !PTP_SLAVE_ONLY)
+            EnterMaster(psPtp, u32NowMs);           /* master got worse than us */
+        return;
+    }
+
+    if (memcmp(pu8Ds, au8Own, PTP_DS_SIZE) >= 0)
+        return;                                     /* we are better */
+
+    if ((psPtp->u32State != PTP_STATE_SLAVE) || (memcmp(pu8Ds, psPtp->au8ParentDs, PTP_DS_SIZE) < 0))
+    {
+        EnterSlave(psPtp, pu8Msg, u32NowMs);
+        memcpy(psPtp->au8ParentDs, pu8Ds, PTP_DS_SIZE);
+        psPtp->u32AnnounceDue = u32NowMs + u32Timeout;
+    }
+}
+
+static void DelayReqInput(PTP_T *psPtp, const uint8_t *pu8Msg, const PTP_TIME_T *psRxTime)
+{
+    uint8_t au8Msg[PTP_DELAY_RESP_SIZE];
+
+    BuildHeader(psPtp, au8Msg, PTP_MSG_DELAY_RESP, PTP_DELAY_RESP_SIZE, GetU16(pu8Msg + 30), 3, PTP_LOG_DELAY_REQ_INTERVAL);
+    memcpy(au8Msg + 8, pu8Msg + 8, 8);              /* correctionField */
+    PutTimestamp(au8Msg + 34, psRxTime);
+    memcpy(au8Msg + 44, pu8Msg + 20, 10);           /* requestingPortIdentity */
+    psPtp->psPort->pfnSend(0, au8Msg, PTP_DELAY_RESP_SIZE);
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief      Initialize the clock. It listens for a master first.
+  * @param[in]  psPtp       Clock instance
+  * @param[in]  psPort      Clock and network access
+  * @param[in]  au8Mac      MAC address, the clock identity is made of it
+  * @param[in]  u32NowMs    Current time in ms, e.g. sys_now() of lwIP
+  * @return     None
+  */
+void PTP_Init(PTP_T *psPtp, const PTP_PORT_T *psPort, const uint8_t au8Mac[6], uint32_t u32NowMs)
+{
+    memset(psPtp, 0, sizeof(PTP_T));
+    psPtp->psPort = psPort;
+
+    /* EUI-64 from EUI-48, port number 1 */
+    memcpy(&psPtp->au8PortId[0], &au8Mac[0], 3);
+    psPtp->au8PortId[3] = 0xFF;
+    psPtp->au8PortId[4] = 0xFE;
+    memcpy(&psPtp->au8PortId[5], &au8Mac[3], 3);
+    PutU16(&psPtp->au8PortId[8], 1);
+
+    psPtp->u32State = PTP_STATE_LISTENING;
+    psPtp->u32AnnounceDue = u32NowMs + PTP_ANNOUNCE_TIMEOUT * IntervalMs(PTP_LOG_ANNOUNCE_INTERVAL);
+}
+
+/**
+  * @brief      Run the timers, call it at least every few ms.
+  * @param[in]  psPtp       Clock instance
+  * @param[in]  u32NowMs    Current time in ms
+  * @return     None
+  */
+void PTP_Poll(PTP_T *psPtp, uint32_t u32NowMs)
+{
+    switch (psPtp->u32State)
+    {
+        case PTP_STATE_LISTENING:
+            if (IsDue(u32NowMs, psPtp->u32AnnounceDue) && !PTP_SLAVE_ONLY)
+                EnterMaster(psPtp, u32NowMs);
+            break;
+
+        case PTP_STATE_MASTER:
+            if (IsDue(u32NowMs, psPtp->u32AnnounceDue))
+            {
+                psPtp->u32AnnounceDue = u32NowMs + IntervalMs(PTP_LOG_ANNOUNCE_INTERVAL);
+                SendAnnounce(psPtp);
+            }
+            if (IsDue(u32NowMs, psPtp->u32SyncDue))
+            {
+                /* a Sync whose time stamp never came is given up */
+                psPtp->u32SyncDue = u32NowMs + IntervalMs(PTP_LOG_SYNC_INTERVAL);
+                SendEvent(psPtp, PTP_MSG_SYNC, psPtp->u16SyncSeq++);
+            }
+            break;
+
+        case PTP_STATE_SLAVE:
+            if (IsDue(u32NowMs, psPtp->u32AnnounceDue))
+            {
+                /* master is gone */
+                psPtp->u32State = PTP_STATE_LISTENING;
+                psPtp->u32AnnounceDue = u32NowMs;
+                memset(psPtp->au8ParentDs, 0xFF, PTP_DS_SIZE);
+                ClearMeasure(psPtp);
+                break;
+            }
+            if (IsDue(u32NowMs, psPtp->u32DelayReqDue) && psPtp->u32PairValid)
+            {
+                psPtp->u32DelayReqDue = u32NowMs + IntervalMs(PTP_LOG_DELAY_REQ_INTERVAL);
+                psPtp->u32T3Valid = 0;
+                psPtp->u32T4Valid = 0;
+                SendEvent(psPtp, PTP_MSG_DELAY_REQ, psPtp->u16DelayReqSeq++);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+  * @brief      Handle a received PTP message.
+  * @param[in]  psPtp       Clock instance
+  * @param[in]  pu8Msg      UDP payload
+  * @param[in]  u32Len      Bytes of pu8Msg
+  * @param[in]  psRxTime    Rx time stamp of the frame, NULL if not available
+  * @param[in]  u32NowMs    Current time in ms
+  * @return     None
+  */
+void PTP_Input(PTP_T *psPtp, const uint8_t *pu8Msg, uint32_t u32Len, const PTP_TIME_T *psRxTime, uint32_t u32NowMs)
+{
+    uint32_t u32Type;
+    uint16_t u16Seq;
+    uint32_t u32FromParent;
+
+    if ((u32Len < PTP_HDR_SIZE) || ((pu8Msg[1] & 0x0F) != 2) || (pu8Msg[4] != PTP_DOMAIN))
+        return;
+    if (memcmp(pu8Msg + 20, psPtp->au8PortId, 10) == 0)
+        return;                                     /* our own */
+
+    u32Type = pu8Msg[0] & 0x0F;
+    u16Seq = (uint16_t)GetU16(pu8Msg + 30);
+    u32FromParent = ((psPtp->u32State == PTP_STATE_SLAVE) && (memcmp(pu8Msg + 20, psPtp->au8ParentId, 10) == 0)) ? 1 : 0;
+
+    switch (u32Type)
+    {
+        case PTP_MSG_ANNOUNCE:
+            if (u32Len >= PTP_ANNOUNCE_SIZE)
+                AnnounceInput(psPtp, pu8Msg, u32NowMs);
+            break;
+
+        case PTP_MSG_SYNC:
+            if (!u32FromParent || (u32Len < PTP_SYNC_SIZE) || (psRxTime == NULL))
+                break;
+            psPtp->i64T2 = TimeToNs(psRxTime);
+            psPtp->u32PairValid = 0;
+            if (pu8Msg[6] & PTP_FLAG_TWO_STEP)
+            {
+                /* the Sync correction is added to the Follow_Up one, keep it in t1 until then */
+                psPtp->i64T1 = GetCorrection(pu8Msg);
+                psPtp->u16RxSyncSeq = u16Seq;
+                psPtp->u32SyncValid = 1;
+            }
+            else
+            {
+                psPtp->i64T1 = GetTimestamp(pu8Msg + 34) + GetCorrection(pu8Msg);
+                psPtp->u32SyncValid = 0;
+                SyncDone(psPtp, (int8_t)pu8Msg[33]);
+            }
+            break;
+
+        case PTP_MSG_FOLLOW_UP:
+            if (!u32FromParent || (u32Len < PTP_SYNC_SIZE) || !psPtp->u32SyncValid || (u16Seq != psPtp->u16RxSyncSeq))
+                break;
+            psPtp->i64T1 += GetTimestamp(pu8Msg + 34) + GetCorrection(pu8Msg);
+            psPtp->u32SyncValid = 0;
+            SyncDone(psPtp, (int8_t)pu8Msg[33]);
+            break;
+
+        case PTP_MSG_DELAY_REQ:
+            if ((psPtp->u32State == PTP_STATE_MASTER) && (u32Len >= PTP_SYNC_SIZE) && (psRxTime != NULL))
+                DelayReqInput(psPtp, pu8Msg, psRxTime);
+            break;
+
+        case PTP_MSG_DELAY_RESP:
+            if (!u32FromParent || (u32Len < PTP_DELAY_RESP_SIZE) || (memcmp(pu8Msg + 44, psPtp->au8PortId, 10) != 0))
+                break;
+            if (psPtp->u32T3Valid)
+            {
+                if (u16Seq != psPtp->u16TxSeq)
+                    break;
+            }
+            else if ((psPtp->u32TxPending != PTP_MSG_DELAY_REQ + 1) || (u16Seq != psPtp->u16TxSeq))
+                break;
+            psPtp->i64T4 = GetTimestamp(pu8Msg + 34) - GetCorrection(pu8Msg);
+            psPtp->u32T4Valid = 1;
+            /* the Tx time stamp of Delay_Req may come later than the answer */
+            if (psPtp->u32T3Valid)
+                DelayDone(psPtp);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+  * @brief      Report the Tx time stamp of the last event message sent by PTP_PORT_T::pfnSend.
+  * @param[in]  psPtp       Clock instance
+  * @param[in]  psTxTime    Tx time stamp
+  * @return     None
+  * @note       Call it from the same context as PTP_Poll() and PTP_Input(), not from the EMAC interrupt.
+  */
+void PTP_TxStamp(PTP_T *psPtp, const PTP_TIME_T *psTxTime)
+{
+    uint8_t au8Msg[PTP_SYNC_SIZE];
+    int64_t i64Stamp = TimeToNs(psTxTime);
+    uint32_t u32Pending = psPtp->u32TxPending;
+
+    psPtp->u32TxPending = 0;
+
+    /* a stamp of another frame can't be in the window */
+    if ((i64Stamp < psPtp->i64TxSent) || (i64Stamp > psPtp->i64TxSent + PTP_TX_STAMP_WINDOW))
+        return;
+
+    if ((u32Pending == PTP_MSG_SYNC + 1) && (psPtp->u32State == PTP_STATE_MASTER))
+    {
+        BuildHeader(psPtp, au8Msg, PTP_MSG_FOLLOW_UP, PTP_SYNC_SIZE, psPtp->u16TxSeq, 2, PTP_LOG_SYNC_INTERVAL);
+        PutTimestamp(au8Msg + 34, psTxTime);
+        psPtp->psPort->pfnSend(0, au8Msg, PTP_SYNC_SIZE);
+    }
+    else if ((u32Pending == PTP_MSG_DELAY_REQ + 1) && (psPtp->u32State == PTP_STATE_SLAVE))
+    {
+        psPtp->i64T3 = i64Stamp;
+        psPtp->u32T3Valid = 1;
+        if (psPtp->u32T4Valid)
+            DelayDone(psPtp);
+    }
+}
+
+/**
+  * @brief      Get the offset and path delay statistics.
+  * @param[in]  psPtp       Clock instance
+  * @param[out] psStat      Statistics since the last clear
+  * @param[in]  u32Clear    1: start a new statistics period
+  * @return     None
+  */
+void PTP_GetStat(PTP_T *psPtp, PTP_STAT_T *psStat, uint32_t u32Clear)
+{
+    *psStat = psPtp->sStat;
+    if (psStat->u32Samples)
+    {
+        psStat->i32OffsetMean = (int32_t)(psPtp->i64OffsetSum / (int64_t)psStat->u32Samples);
+        psStat->u32OffsetRms = Isqrt(psPtp->u64OffsetSq / psStat->u32Samples);
+    }
+    psStat->i32DelayMean = psPtp->u32DelayValid ? psPtp->i32Delay : 0;
+    psStat->i32Ppb = psPtp->i32Ppb;
+    psStat->u32State = psPtp->u32State;
+    psStat->u32Servo = psPtp->u32Servo;
+
+    if (u32Clear)
+    {
+        memset(&psPtp->sStat, 0, sizeof(PTP_STAT_T));
+        psPtp->sStat.i32DelayMin = psPtp->sStat.i32DelayMax = psPtp->i32Delay;
+        psPtp->i64OffsetSum = 0;
+        psPtp->u64OffsetSq = 0;
+    }
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
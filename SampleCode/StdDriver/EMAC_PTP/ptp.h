@@ -0,0 +1,167 @@
+/**************************************************************************//**
+ * @file     ptp.h
+ * @version  V1.00
+ * @brief    IEEE 1588-2008 (PTPv2) ordinary clock header file.
+ *
+ *           The engine handles the messages of one port, runs a reduced best
+ *           master clock algorithm and, as slave, a PI servo on the offsets
+ *           measured with the end to end delay mechanism. It uses no hardware
+ *           and no network stack directly, a port (PTP_PORT_T) connects it
+ *           to a clock and to UDP.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __PTP_H__
+#define __PTP_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Clock settings                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+#define PTP_DOMAIN                  0       /*!< domainNumber                                         */
+#define PTP_PRIORITY1               128     /*!< priority1, lower wins the master election            */
+#define PTP_PRIORITY2               128     /*!< priority2                                            */
+#define PTP_CLOCK_CLASS             248     /*!< clockClass of a free running clock                   */
+#define PTP_CLOCK_ACCURACY          0xFE    /*!< clockAccuracy, unknown                               */
+#define PTP_CLOCK_VARIANCE          0xFFFF  /*!< offsetScaledLogVariance, unknown                     */
+#define PTP_SLAVE_ONLY              0       /*!< 1: never become master                               */
+#define PTP_LOG_SYNC_INTERVAL       (-1)    /*!< Sync every 2^n s as master                           */
+#define PTP_LOG_ANNOUNCE_INTERVAL   1       /*!< Announce every 2^n s as master                       */
+#define PTP_LOG_DELAY_REQ_INTERVAL  0       /*!< Delay_Req every 2^n s as slave                       */
+#define PTP_ANNOUNCE_TIMEOUT        3       /*!< Announce intervals without Announce to lose a master */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Servo settings                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+#define PTP_SERVO_KP                0.7f    /*!< Part of the offset removed in the next Sync interval */
+#define PTP_SERVO_KI                0.3f    /*!< Part of the offset added to the frequency estimation */
+#define PTP_SERVO_MAX_PPB           500000  /*!< Frequency adjustment limit, 500 ppm                  */
+#define PTP_STEP_THRESHOLD          1000000 /*!< Offsets beyond it in ns step the clock               */
+#define PTP_LOCK_THRESHOLD          1000    /*!< Offsets within it in ns count as locked              */
+#define PTP_DELAY_FILTER            3       /*!< Path delay is filtered with weight 1/2^n             */
+#define PTP_OUTLIER_NS              2000    /*!< Locked offsets and path delays beyond it in ns are
+                                                 dropped, e.g. frames queued in a switch            */
+#define PTP_OUTLIER_MAX             3       /*!< Outliers in a row are taken as a real change         */
+#define PTP_TX_STAMP_WINDOW         10000000    /*!< Tx time stamp may be this much in ns after send  */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Protocol constants                                                                                     */
+/*---------------------------------------------------------------------------------------------------------*/
+#define PTP_EVENT_PORT              319     /*!< UDP port of Sync and Delay_Req                       */
+#define PTP_GENERAL_PORT            320     /*!< UDP port of the other messages                       */
+#define PTP_MSG_MAX                 64      /*!< Longest message the engine sends, Announce           */
+
+#define PTP_STATE_LISTENING         0       /*!< Waiting for Announce messages                        */
+#define PTP_STATE_MASTER            1       /*!< Sending Sync, Follow_Up and Announce                 */
+#define PTP_STATE_SLAVE             2       /*!< Synchronizing to a master                            */
+
+#define PTP_SERVO_UNLOCKED          0       /*!< Servo waits for the first offset                     */
+#define PTP_SERVO_TRACKING          1       /*!< Servo adjusts the frequency                          */
+#define PTP_SERVO_LOCKED            2       /*!< Offset stays within PTP_LOCK_THRESHOLD               */
+
+/*! A time of the PTP clock. Seconds above 32 bits are dropped. */
+typedef struct ptp_time_t
+{
+    uint32_t    u32Sec;                 /*!< Seconds                                                  */
+    uint32_t    u32Nsec;                /*!< Nanoseconds, 0 ~ 999999999                               */
+} PTP_TIME_T;
+
+/*! How the engine reaches its clock and the network */
+typedef struct ptp_port_t
+{
+    void     (*pfnGetTime)(PTP_TIME_T *psTime);                     /*!< Read the clock               */
+    void     (*pfnStepTime)(int64_t i64Nsec);                       /*!< Add an offset to the clock   */
+    void     (*pfnAdjFreq)(int32_t i32Ppb);                         /*!< Set the rate offset          */
+    int32_t  (*pfnSend)(uint32_t u32Event, const uint8_t *pu8Msg, uint32_t u32Len);
+                                        /*!< Send to the PTP multicast group, to PTP_EVENT_PORT if u32Event.
+                                             The Tx time stamp of an event message is reported later by
+                                             PTP_TxStamp(). 0: message is queued.                  */
+} PTP_PORT_T;
+
+/*! Offset and path delay statistics of the slave */
+typedef struct ptp_stat_t
+{
+    uint32_t    u32Samples;             /*!< Offsets measured                                         */
+    int32_t     i32OffsetLast;          /*!< Offset from master in ns, the latest                     */
+    int32_t     i32OffsetMin;           /*!< Offset minimum in ns                                     */
+    int32_t     i32OffsetMax;           /*!< Offset maximum in ns                                     */
+    int32_t     i32OffsetMean;          /*!< Offset mean in ns                                        */
+    uint32_t    u32OffsetRms;           /*!< Offset root mean square in ns                            */
+    int32_t     i32DelayMean;           /*!< Filtered mean path delay in ns                           */
+    int32_t     i32DelayMin;            /*!< Path delay minimum in ns                                 */
+    int32_t     i32DelayMax;            /*!< Path delay maximum in ns                                 */
+    int32_t     i32Ppb;                 /*!< Frequency adjustment in ppb                              */
+    uint32_t    u32Steps;               /*!< Clock steps                                              */
+    uint32_t    u32Outliers;            /*!< Offsets and path delays dropped as outliers              */
+    uint32_t    u32State;               /*!< PTP_STATE_xxx                                            */
+    uint32_t    u32Servo;               /*!< PTP_SERVO_xxx                                            */
+} PTP_STAT_T;
+
+/// @cond HIDDEN_SYMBOLS
+
+typedef struct ptp_t
+{
+    const PTP_PORT_T *psPort;
+    uint8_t     au8PortId[10];          /* our clockIdentity and portNumber */
+    uint8_t     au8ParentId[10];        /* port identity of the master */
+    uint8_t     au8ParentDs[14];        /* Announce fields of the master, in compare order */
+    uint32_t    u32State;
+
+    /* timers in ms */
+    uint32_t    u32AnnounceDue;         /* master: next Announce, else: Announce timeout */
+    uint32_t    u32SyncDue;
+    uint32_t    u32DelayReqDue;
+
+    uint16_t    u16SyncSeq;
+    uint16_t    u16AnnounceSeq;
+    uint16_t    u16DelayReqSeq;
+
+    /* event message waiting for its Tx time stamp */
+    uint32_t    u32TxPending;           /* message type + 1, 0: none */
+    uint16_t    u16TxSeq;
+    int64_t     i64TxSent;              /* clock when it was sent */
+
+    /* slave measurement */
+    uint16_t    u16RxSyncSeq;
+    uint32_t    u32SyncValid;           /* 1: t2 of u16RxSyncSeq is waiting for t1 */
+    int64_t     i64T1, i64T2, i64T3, i64T4;     /* t1 includes Sync and Follow_Up corrections */
+    uint32_t    u32T3Valid;
+    uint32_t    u32T4Valid;             /* Delay_Resp came before the Tx time stamp of Delay_Req */
+    uint32_t    u32PairValid;           /* 1: i64T1 and i64T2 are a pair */
+    int32_t     i32Delay;
+    uint32_t    u32DelayValid;
+    uint32_t    u32OffsetOutliers;      /* in a row */
+    uint32_t    u32DelayOutliers;       /* in a row */
+
+    /* servo */
+    uint32_t    u32Servo;
+    float       fFreq;                  /* integral part, ppb */
+    int32_t     i32Ppb;
+
+    /* statistics */
+    PTP_STAT_T  sStat;
+    int64_t     i64OffsetSum;
+    uint64_t    u64OffsetSq;
+} PTP_T;
+
+/// @endcond HIDDEN_SYMBOLS
+
+void     PTP_Init(PTP_T *psPtp, const PTP_PORT_T *psPort, const uint8_t au8Mac[6], uint32_t u32NowMs);
+void     PTP_Poll(PTP_T *psPtp, uint32_t u32NowMs);
+void     PTP_Input(PTP_T *psPtp, const uint8_t *pu8Msg, uint32_t u32Len, const PTP_TIME_T *psRxTime, uint32_t u32NowMs);
+void     PTP_TxStamp(PTP_T *psPtp, const PTP_TIME_T *psTxTime);
+void     PTP_GetStat(PTP_T *psPtp, PTP_STAT_T *psStat, uint32_t u32Clear);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __PTP_H__ */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,276 @@
+/**************************************************************************//**
+ * @file     ptp_port.c
+ * @version  V1.00
+ * @brief    Connects the PTP engine to the EMAC time stamp counter and to
+ *           lwIP UDP.
+ *
+ *           The EMAC stamps every frame it sends and receives. The Rx
+ *           interrupt queues each frame with its stamp, the main loop feeds
+ *           it to lwIP and the PTP event socket hands the stamp to the
+ *           engine. On Tx, a tag per frame in descriptor order tells the Tx
+ *           interrupt which stamp belongs to the event message the engine
+ *           waits for.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "lwip/igmp.h"
+#include "lwip/etharp.h"
+#include "lwip/sys.h"
+#include "lwip/timeouts.h"
+#include "ptp_port.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+typedef struct
+{
+    struct pbuf *p;
+    PTP_TIME_T  sTime;
+} RX_ENTRY_T;
+
+static PTP_T *s_psPtp;
+static struct udp_pcb *s_psEventPcb, *s_psGeneralPcb;
+static ip4_addr_t s_sGroup;
+
+/* Rx frames from the interrupt to the main loop */
+static uint8_t s_au8RxFrame[EMAC_MAX_PKT_SIZE];
+static RX_ENTRY_T s_asRxQueue[PTP_PORT_RX_QUEUE_SIZE];
+static volatile uint32_t s_u32RxHead, s_u32RxTail;
+static const PTP_TIME_T *s_psRxTime;    /* stamp of the frame lwIP is processing */
+
+/* one tag per frame in the Tx ring, 1: the engine waits for its stamp */
+static uint8_t s_au8TxTag[EMAC_TX_DESC_SIZE];
+static volatile uint32_t s_u32TxHead, s_u32TxTail;
+static uint32_t s_u32TxEvent;           /* next frame sent is an event message */
+static volatile uint32_t s_u32TxStampReady;
+static PTP_TIME_T s_sTxStamp;
+
+void EMAC_RX_IRQHandler(void)
+{
+    uint32_t u32Size, u32Sec, u32Nsec, u32Next;
+    struct pbuf *p;
+
+    while (EMAC_RecvPktTS(s_au8RxFrame, &u32Size, &u32Sec, &u32Nsec) == 1)
+    {
+        u32Next = (s_u32RxHead + 1) % PTP_PORT_RX_QUEUE_SIZE;
+
+        /* Allocate pbuf from pool (avoid using heap in interrupts) */
+        if ((u32Next != s_u32RxTail) && ((p = pbuf_alloc(PBUF_RAW, (u16_t)u32Size, PBUF_POOL)) != NULL))
+        {
+            pbuf_take(p, s_au8RxFrame, (u16_t)u32Size);
+            s_asRxQueue[s_u32RxHead].p = p;
+            s_asRxQueue[s_u32RxHead].sTime.u32Sec = u32Sec;
+            s_asRxQueue[s_u32RxHead].sTime.u32Nsec = u32Nsec;
+            s_u32RxHead = u32Next;
+        }
+
+        EMAC_RecvPktDone();
+    }
+}
+
+void EMAC_TX_IRQHandler(void)
+{
+    uint32_t u32Sec, u32Nsec, u32Err;
+
+    /* A frame the MAC gave up on has no stamp, but its tag is popped all the same
+       so the next stamp is matched with the frame it belongs to */
+    while (EMAC_SendPktReclaimTS(&u32Sec, &u32Nsec, &u32Err) == 1)
+    {
+        if (s_u32TxTail == s_u32TxHead)
+            continue;
+
+        if (s_au8TxTag[s_u32TxTail % EMAC_TX_DESC_SIZE] && (u32Err == 0))
+        {
+            s_sTxStamp.u32Sec = u32Sec;
+            s_sTxStamp.u32Nsec = u32Nsec;
+            s_u32TxStampReady = 1;
+        }
+        s_u32TxTail++;
+    }
+}
+
+static err_t EMAC_LinkOutput(struct netif *netif, struct pbuf *p)
+{
+    static uint8_t au8Frame[EMAC_MAX_PKT_SIZE];
+    uint32_t u32Size;
+    err_t err = ERR_OK;
+
+    u32Size = pbuf_copy_partial(p, au8Frame, sizeof(au8Frame), 0);
+
+    __disable_irq();
+    if (EMAC_SendPkt(au8Frame, u32Size))
+    {
+        /* At most EMAC_TX_DESC_SIZE frames are in the ring, an older tag is one the Tx interrupt missed */
+        if (s_u32TxHead - s_u32TxTail == EMAC_TX_DESC_SIZE)
+            s_u32TxTail++;
+        s_au8TxTag[s_u32TxHead % EMAC_TX_DESC_SIZE] = (uint8_t)s_u32TxEvent;
+        s_u32TxHead++;
+    }
+    else
+    {
+        err = ERR_MEM;
+    }
+    __enable_irq();
+
+    return err;
+}
+
+static void GetTime(PTP_TIME_T *psTime)
+{
+    EMAC_GetTime(&psTime->u32Sec, &psTime->u32Nsec);
+}
+
+static void StepTime(int64_t i64Nsec)
+{
+    uint32_t u32Neg = 0;
+
+    if (i64Nsec < 0)
+    {
+        u32Neg = 1;
+        i64Nsec = -i64Nsec;
+    }
+    EMAC_UpdateTime(u32Neg, (uint32_t)(i64Nsec / 1000000000LL), (uint32_t)(i64Nsec % 1000000000LL));
+}
+
+static int32_t Send(uint32_t u32Event, const uint8_t *pu8Msg, uint32_t u32Len)
+{
+    struct pbuf *p;
+    err_t err;
+
+    p = pbuf_alloc(PBUF_TRANSPORT, (u16_t)u32Len, PBUF_RAM);
+    if (p == NULL)
+        return -1;
+    pbuf_take(p, pu8Msg, (u16_t)u32Len);
+
+    /* Multicast needs no ARP, so udp_sendto() reaches EMAC_LinkOutput() before it returns */
+    s_u32TxEvent = u32Event;
+    if (u32Event)
+        err = udp_sendto(s_psEventPcb, p, &s_sGroup, PTP_EVENT_PORT);
+    else
+        err = udp_sendto(s_psGeneralPcb, p, &s_sGroup, PTP_GENERAL_PORT);
+    s_u32TxEvent = 0;
+
+    pbuf_free(p);
+    return (err == ERR_OK) ? 0 : -1;
+}
+
+static void PtpRecv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    uint8_t au8Msg[128];
+    uint32_t u32Len;
+
+    u32Len = pbuf_copy_partial(p, au8Msg, sizeof(au8Msg), 0);
+    PTP_Input(s_psPtp, au8Msg, u32Len, (pcb == s_psEventPcb) ? s_psRxTime : NULL, sys_now());
+    pbuf_free(p);
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/*! Clock and network of the PTP engine */
+const PTP_PORT_T g_sPtpPort =
+{
+    GetTime,
+    StepTime,
+    EMAC_AdjustFreq,
+    Send
+};
+
+/**
+  * @brief      lwIP init function of the EMAC interface.
+  * @param[in]  netif   Interface, its state is the MAC address
+  * @retval     ERR_OK
+  * @details    Opens the EMAC, starts its time stamp counter at 0 s and
+  *             enables its interrupts.
+  */
+err_t PTPPort_NetifInit(struct netif *netif)
+{
+    netif->linkoutput = EMAC_LinkOutput;
+    netif->output     = etharp_output;
+    netif->mtu        = 1500;
+    /* EMAC_Open() accepts all multicast frames, so IGMP needs no MAC filter */
+    netif->flags      = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET | NETIF_FLAG_IGMP;
+
+    SMEMCPY(netif->hwaddr, netif->state, sizeof(netif->hwaddr));
+    netif->hwaddr_len = sizeof(netif->hwaddr);
+
+    EMAC_Open((uint8_t *)netif->state);
+    if (EMAC_PhyInit() < 0)
+        printf("Link is down\n");
+    EMAC_EnableTS(0, 0);
+
+    NVIC_EnableIRQ(EMAC_TX_IRQn);
+    NVIC_EnableIRQ(EMAC_RX_IRQn);
+    EMAC_ENABLE_RX();
+    EMAC_ENABLE_TX();
+
+    return ERR_OK;
+}
+
+/**
+  * @brief      Open the PTP sockets and join the PTP multicast group.
+  * @param[in]  psPtp   Clock instance, initialized by PTP_Init()
+  * @param[in]  netif   The EMAC interface
+  * @retval     0       Success
+  * @retval     -1      Out of memory or port in use
+  */
+int32_t PTPPort_Open(PTP_T *psPtp, struct netif *netif)
+{
+    s_psPtp = psPtp;
+    IP4_ADDR(&s_sGroup, 224, 0, 1, 129);
+
+    s_psEventPcb = udp_new();
+    s_psGeneralPcb = udp_new();
+    if ((s_psEventPcb == NULL) || (s_psGeneralPcb == NULL))
+        return -1;
+    if ((udp_bind(s_psEventPcb, IP_ADDR_ANY, PTP_EVENT_PORT) != ERR_OK) ||
+            (udp_bind(s_psGeneralPcb, IP_ADDR_ANY, PTP_GENERAL_PORT) != ERR_OK))
+        return -1;
+    udp_recv(s_psEventPcb, PtpRecv, NULL);
+    udp_recv(s_psGeneralPcb, PtpRecv, NULL);
+
+    if (igmp_joingroup_netif(netif, &s_sGroup) != ERR_OK)
+        return -1;
+
+    return 0;
+}
+
+/**
+  * @brief      Feed received frames to lwIP and Tx stamps to the engine.
+  * @param[in]  netif   The EMAC interface
+  * @return     None
+  * @details    Call it from the main loop. The engine runs inside it, never
+  *             in interrupt context.
+  */
+void PTPPort_Poll(struct netif *netif)
+{
+    PTP_TIME_T sTime;
+    RX_ENTRY_T sEntry;
+
+    while (s_u32RxTail != s_u32RxHead)
+    {
+        sEntry = s_asRxQueue[s_u32RxTail];
+        s_u32RxTail = (s_u32RxTail + 1) % PTP_PORT_RX_QUEUE_SIZE;
+
+        /* NO_SYS lwIP calls PtpRecv() before netif->input() returns */
+        s_psRxTime = &sEntry.sTime;
+        if (netif->input(sEntry.p, netif) != ERR_OK)
+            pbuf_free(sEntry.p);
+        s_psRxTime = NULL;
+    }
+
+    if (s_u32TxStampReady)
+    {
+        __disable_irq();
+        sTime = s_sTxStamp;
+        s_u32TxStampReady = 0;
+        __enable_irq();
+        PTP_TxStamp(s_psPtp, &sTime);
+    }
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,26 @@
+/**************************************************************************//**
+ * @file     ptp_port.h
+ * @version  V1.00
+ * @brief    Connects the PTP engine to the EMAC time stamp counter and to
+ *           lwIP UDP.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __PTP_PORT_H__
+#define __PTP_PORT_H__
+
+#include "lwip/err.h"
+#include "lwip/netif.h"
+#include "ptp.h"
+
+#define PTP_PORT_RX_QUEUE_SIZE  16      /*!< Received frames waiting for the main loop */
+
+err_t    PTPPort_NetifInit(struct netif *netif);
+int32_t  PTPPort_Open(PTP_T *psPtp, struct netif *netif);
+void     PTPPort_Poll(struct netif *netif);
+
+extern const PTP_PORT_T g_sPtpPort;
+
+#endif  /* __PTP_PORT_H__ */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,218 @@
+/*************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Compare the frame rate of the per packet EMAC Tx/Rx functions with
+ *           the burst ones. Each test runs for one second and prints frames
+ *           per second. Tx tests send minimum size broadcast frames with the
+ *           local experimental EtherType 0x88B5. Rx tests count the frames
+ *           received, flood the port from a PC during them.
+ *
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+
+#define BURST_NUM       EMAC_TX_DESC_SIZE   /* Most frames given to each burst call */
+#define TEST_FRAME_SIZE 60                  /* Minimum frame size without CRC */
+#define TEST_TICKS      1000                /* Length of each test in SysTick, 1 ms */
+
+// Our MAC address
+uint8_t g_au8MacAddr[6] = {0x00, 0x00, 0x00, 0x59, 0x16, 0x88};
+
+static uint8_t s_au8TxFrame[TEST_FRAME_SIZE];
+static uint8_t s_au8RxBuf[BURST_NUM][1514];
+
+static volatile uint32_t s_u32Ticks;
+
+void SysTick_Handler(void)
+{
+    s_u32Ticks++;
+}
+
+void SYS_Init(void)
+{
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Set XT1_OUT(PF.2) and XT1_IN(PF.3) to input mode */
+    PF->MODE &= ~(GPIO_MODE_MODE2_Msk | GPIO_MODE_MODE3_Msk);
+
+    /* Enable External XTAL (4~24 MHz) */
+    CLK_EnableXtalRC(CLK_PWRCTL_HXTEN_Msk);
+
+    /* Waiting for 12MHz clock ready */
+    CLK_WaitClockReady( CLK_STATUS_HXTSTB_Msk);
+
+    /* Switch HCLK clock source to HXT */
+    CLK_SetHCLK(CLK_CLKSEL0_HCLKSEL_HXT,CLK_CLKDIV0_HCLK(1));
+
+    /* Set core clock as PLL_CLOCK from PLL */
+    CLK_SetCoreClock(FREQ_192MHZ);
+
+    /* Set both PCLK0 and PCLK1 as HCLK/2 */
+    CLK->PCLKDIV = CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2;
+
+    /* Enable IP clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+    CLK_EnableModuleClock(EMAC_MODULE);
+
+    /* Select IP clock source */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HXT, CLK_CLKDIV0_UART0(1));
+
+    // Configure MDC clock rate to HCLK / (127 + 1) = 1.5 MHz if system is running at 192 MHz
+    CLK_SetModuleClock(EMAC_MODULE, 0, CLK_CLKDIV3_EMAC(127));
+
+    /* Update System Core Clock */
+    /* User can use SystemCoreClockUpdate() to calculate SystemCoreClock. */
+    SystemCoreClockUpdate();
+
+    /* Set GPB multi-function pins for UART0 RXD and TXD */
+    SYS->GPB_MFPH &= ~(SYS_GPB_MFPH_PB12MFP_Msk | SYS_GPB_MFPH_PB13MFP_Msk);
+    SYS->GPB_MFPH |= (SYS_GPB_MFPH_PB12MFP_UART0_RXD | SYS_GPB_MFPH_PB13MFP_UART0_TXD);
+    // Configure RMII pins
+    SYS->GPA_MFPL |= SYS_GPA_MFPL_PA6MFP_EMAC_RMII_RXERR | SYS_GPA_MFPL_PA7MFP_EMAC_RMII_CRSDV;
+    SYS->GPC_MFPL |= SYS_GPC_MFPL_PC6MFP_EMAC_RMII_RXD1 | SYS_GPC_MFPL_PC7MFP_EMAC_RMII_RXD0;
+    SYS->GPC_MFPH |= SYS_GPC_MFPH_PC8MFP_EMAC_RMII_REFCLK;
+    SYS->GPE_MFPH |= SYS_GPE_MFPH_PE8MFP_EMAC_RMII_MDC |
+                     SYS_GPE_MFPH_PE9MFP_EMAC_RMII_MDIO |
+                     SYS_GPE_MFPH_PE10MFP_EMAC_RMII_TXD0 |
+                     SYS_GPE_MFPH_PE11MFP_EMAC_RMII_TXD1 |
+                     SYS_GPE_MFPH_PE12MFP_EMAC_RMII_TXEN;
+
+    // Enable high slew rate on all RMII TX output pins
+    PE->SLEWCTL = (GPIO_SLEWCTL_HIGH << GPIO_SLEWCTL_HSREN10_Pos) |
+                  (GPIO_SLEWCTL_HIGH << GPIO_SLEWCTL_HSREN11_Pos) |
+                  (GPIO_SLEWCTL_HIGH << GPIO_SLEWCTL_HSREN12_Pos);
+
+    /* Lock protected registers */
+    SYS_LockReg();
+
+}
+
+// Send with EMAC_SendPkt(), one trigger per frame. Sent descriptors are reclaimed by polling EMAC_SendPktDone().
+uint32_t TxSingle(void)
+{
+    uint32_t u32Frames = 0;
+    uint32_t u32End = s_u32Ticks + TEST_TICKS;
+
+    while ((int32_t)(u32End - s_u32Ticks) > 0)
+    {
+        if (EMAC_SendPkt(s_au8TxFrame, TEST_FRAME_SIZE))
+            u32Frames++;
+        else
+            EMAC_SendPktDone();
+    }
+    return u32Frames;
+}
+
+// Send with EMAC_SendPktBurst(), one trigger per call. Descriptors are reclaimed inside it.
+uint32_t TxBurst(void)
+{
+    uint8_t *apu8Data[BURST_NUM];
+    uint32_t au32Size[BURST_NUM];
+    uint32_t i, u32Frames = 0;
+    uint32_t u32End = s_u32Ticks + TEST_TICKS;
+
+    for (i = 0; i < BURST_NUM; i++)
+    {
+        apu8Data[i] = s_au8TxFrame;
+        au32Size[i] = TEST_FRAME_SIZE;
+    }
+
+    while ((int32_t)(u32End - s_u32Ticks) > 0)
+        u32Frames += EMAC_SendPktBurst(apu8Data, au32Size, BURST_NUM);
+
+    return u32Frames;
+}
+
+// Receive with EMAC_RecvPkt() and EMAC_RecvPktDone(), one trigger per frame.
+uint32_t RxSingle(void)
+{
+    uint32_t u32Size, u32Frames = 0;
+    uint32_t u32End = s_u32Ticks + TEST_TICKS;
+
+    while ((int32_t)(u32End - s_u32Ticks) > 0)
+    {
+        if (EMAC_RecvPkt(s_au8RxBuf[0], &u32Size) == 1)
+        {
+            u32Frames++;
+            EMAC_RecvPktDone();
+        }
+    }
+    return u32Frames;
+}
+
+// Receive with EMAC_RecvPktBurst(), one trigger per call.
+uint32_t RxBurst(void)
+{
+    uint8_t *apu8Data[BURST_NUM];
+    uint32_t au32Size[BURST_NUM];
+    uint32_t i, u32Ret, u32Frames = 0;
+    uint32_t u32End = s_u32Ticks + TEST_TICKS;
+
+    for (i = 0; i < BURST_NUM; i++)
+        apu8Data[i] = s_au8RxBuf[i];
+
+    while ((int32_t)(u32End - s_u32Ticks) > 0)
+    {
+        u32Ret = EMAC_RecvPktBurst(apu8Data, au32Size, BURST_NUM);
+        if (u32Ret != (uint32_t)EMAC_BUS_ERR)
+            u32Frames += u32Ret;
+    }
+    return u32Frames;
+}
+
+int main(void)
+{
+    uint32_t u32Single, u32Burst;
+
+    SYS_Init();
+    UART_Open(UART0, 115200);
+
+    printf("\nEMAC burst Tx/Rx sample, %d descriptors, up to %d frames per burst\n", (int)EMAC_TX_DESC_SIZE, (int)BURST_NUM);
+
+    /* Broadcast frame with local experimental EtherType, payload is all zero */
+    memset(s_au8TxFrame, 0, sizeof(s_au8TxFrame));
+    memset(s_au8TxFrame, 0xFF, 6);
+    memcpy(&s_au8TxFrame[6], g_au8MacAddr, 6);
+    s_au8TxFrame[12] = 0x88;
+    s_au8TxFrame[13] = 0xB5;
+
+    if (SysTick_Config(SystemCoreClock / 1000))
+    {
+        printf("Set system tick error!!\n");
+        while (1);
+    }
+
+    // Select RMII interface by default
+    EMAC_Open(g_au8MacAddr);
+
+    // Init phy
+    if (EMAC_PhyInit() < 0)
+        printf("Link is down, plug in the cable to see the wire limited rates\n");
+
+    // No interrupt, everything is polled
+    EMAC_ENABLE_RX();
+    EMAC_ENABLE_TX();
+
+    while (1)
+    {
+        printf("\nPress any key to run the tests\n");
+        getchar();
+
+        u32Single = TxSingle();
+        u32Burst = TxBurst();
+        printf("Tx %d byte frames/s: single %d, burst %d\n", TEST_FRAME_SIZE, u32Single, u32Burst);
+
+        u32Single = RxSingle();
+        u32Burst = RxBurst();
+        printf("Rx frames/s: single %d, burst %d\n", u32Single, u32Burst);
+    }
+
+}
+
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -50,5 +50,8 @@
 #define LWIP_NETCONN                    0
 #define LWIP_SOCKET                     0
 
+#define LWIP_SUPPORT_CUSTOM_PBUF        1
+#define ETH_ZERO_COPY                   1   /* Rx frames are passed to lwIP without copy, see m480_emac.h */
+
 
 #endif /* __LWIPOPTS_H__ */
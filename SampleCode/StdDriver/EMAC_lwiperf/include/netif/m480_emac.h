@@ -74,6 +74,16 @@
 #define RX_DESCRIPTOR_NUM 8    // Max Number of Rx Frame Descriptors
 #define TX_DESCRIPTOR_NUM 8    // Max number of Tx Frame Descriptors
 
+// Set ETH_ZERO_COPY to 1 in lwipopts.h to pass Rx descriptor buffers to lwIP as custom pbufs.
+// A descriptor handing its buffer to lwIP takes one of ETH_RX_SPARE_NUM spare buffers, so the
+// Rx ring never shrinks. Frames arriving while all spare buffers are with lwIP are copied.
+#ifndef ETH_ZERO_COPY
+#define ETH_ZERO_COPY 0
+#endif
+#ifndef ETH_RX_SPARE_NUM
+#define ETH_RX_SPARE_NUM 8    // Rx buffers lwIP could hold at the same time without copy
+#endif
+
 #define PACKET_BUFFER_SIZE  1520
 
 #define CONFIG_PHY_ADDR     1
@@ -117,5 +127,8 @@ extern unsigned int link_is_up(void);
 extern u8_t *EMAC_get_tx_buf(void);
 extern void EMAC_trigger_tx(u16_t length);
 extern void EMAC_init(u8_t *mac_addr);
+#if ETH_ZERO_COPY
+extern u32_t EMAC_get_rx_copied(void);
+#endif
 
 #endif  /* __M480_EMAC_H__ */
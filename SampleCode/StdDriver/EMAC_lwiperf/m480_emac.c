@@ -7,6 +7,7 @@
  * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
 *****************************************************************************/
 #include "NuMicro.h"
+#include "lwip/sys.h"
 #include "netif/m480_emac.h"
 
 
@@ -27,14 +28,67 @@ static struct eth_descriptor tx_desc[TX_DESCRIPTOR_NUM] __attribute__ ((aligned(
 #endif
 struct eth_descriptor volatile *cur_tx_desc_ptr, *cur_rx_desc_ptr, *fin_tx_desc_ptr;
 
-static u8_t rx_buf[RX_DESCRIPTOR_NUM][PACKET_BUFFER_SIZE];
+#if ETH_ZERO_COPY
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error "ETH_ZERO_COPY requires LWIP_SUPPORT_CUSTOM_PBUF"
+#endif
+#define RX_BUFFER_NUM   (RX_DESCRIPTOR_NUM + ETH_RX_SPARE_NUM)
+#else
+#define RX_BUFFER_NUM   RX_DESCRIPTOR_NUM
+#endif
+
+static u8_t rx_buf[RX_BUFFER_NUM][PACKET_BUFFER_SIZE];
 static u8_t tx_buf[TX_DESCRIPTOR_NUM][PACKET_BUFFER_SIZE];
 static int plugged = 0;
 
+#if ETH_ZERO_COPY
+// Rx buffer lent to lwIP. The descriptor takes a spare buffer in exchange and stays in the ring,
+// the lent buffer becomes a spare one while the pbuf is freed.
+static struct pbuf_custom rx_pbuf[RX_BUFFER_NUM];
+static u8_t rx_spare[ETH_RX_SPARE_NUM];     // indexes of spare buffers in rx_buf
+static volatile u32_t rx_spare_cnt;
+static u32_t rx_copied;                     // frames copied because no spare buffer was left
+#endif
+
 //extern void ethernetif_input(u16_t len, u8_t *buf);
 //extern void ethernetif_loopback_input(struct pbuf *p);
 extern uint32_t queue_try_put(struct pbuf *p);
 
+#if ETH_ZERO_COPY
+static void rx_pbuf_free(struct pbuf *p)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    rx_spare[rx_spare_cnt++] = (struct pbuf_custom *)p - rx_pbuf;
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+// Wrap current Rx descriptor buffer in a custom pbuf and give the descriptor a spare buffer.
+// Return NULL if no spare buffer is left.
+static struct pbuf *rx_get_pbuf(u16_t length)
+{
+    struct pbuf_custom *pc;
+    struct pbuf *p;
+
+    if(rx_spare_cnt == 0)
+        return(NULL);
+
+    pc = &rx_pbuf[(cur_rx_desc_ptr->buf - &rx_buf[0][0]) / PACKET_BUFFER_SIZE];
+    pc->custom_free_function = rx_pbuf_free;
+    p = pbuf_alloced_custom(PBUF_RAW, length, PBUF_REF, pc, cur_rx_desc_ptr->buf, PACKET_BUFFER_SIZE);
+    if(p != NULL)
+        cur_rx_desc_ptr->buf = &rx_buf[rx_spare[--rx_spare_cnt]][0];
+
+    return(p);
+}
+
+u32_t EMAC_get_rx_copied(void)
+{
+    return rx_copied;
+}
+#endif
+
 void EMAC_RX_IRQHandler(void)
 {
     unsigned int status;
@@ -57,13 +111,28 @@ void EMAC_RX_IRQHandler(void)
 
         if (status & RXFD_RXGD)
         {
-            /* Allocate pbuf from pool (avoid using heap in interrupts) */
-            struct pbuf* p = pbuf_alloc(PBUF_RAW, status & 0xFFFF, PBUF_POOL);
+            struct pbuf* p;
+
+#if ETH_ZERO_COPY
+            /* Pass the descriptor buffer without copy while a spare buffer is left */
+            p = rx_get_pbuf(status & 0xFFFF);
+            if(p == NULL)
+#endif
+            {
+                /* Allocate pbuf from pool (avoid using heap in interrupts) */
+                p = pbuf_alloc(PBUF_RAW, status & 0xFFFF, PBUF_POOL);
+                if(p != NULL)
+                {
+                    /* Copy ethernet frame into pbuf */
+                    pbuf_take(p, cur_rx_desc_ptr->buf, status & 0xFFFF);
+#if ETH_ZERO_COPY
+                    rx_copied++;
+#endif
+                }
+            }
 
             if(p != NULL)
             {
-                /* Copy ethernet frame into pbuf */
-                pbuf_take(p, cur_rx_desc_ptr->buf, status & 0xFFFF);
 
                 /* Put in a queue which is processed in main loop */
                 if(!queue_try_put(p))
@@ -248,6 +317,11 @@ static void init_rx_desc(void)
         rx_desc[i].status2 = 0;
         rx_desc[i].next = (struct eth_descriptor *)(&rx_desc[(i + 1) % RX_DESCRIPTOR_NUM]);
     }
+#if ETH_ZERO_COPY
+    for(i = 0; i < ETH_RX_SPARE_NUM; i++)
+        rx_spare[i] = RX_DESCRIPTOR_NUM + i;
+    rx_spare_cnt = ETH_RX_SPARE_NUM;
+#endif
     EMAC->RXDSA = (unsigned int)&rx_desc[0];
     return;
 }
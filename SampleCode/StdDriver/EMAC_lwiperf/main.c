@@ -26,7 +26,7 @@ unsigned char my_mac_addr[6] = {0x00, 0x00, 0x00, 0x55, 0x66, 0x77};
 static err_t netif_output(struct netif *netif, struct pbuf *p)
 {
     uint16_t len = 0;
-    uint8_t *buf
+    uint8_t *buf;
 
     LINK_STATS_INC(link.xmit);
 
@@ -42,6 +42,18 @@ static err_t netif_output(struct netif *netif, struct pbuf *p)
     return ERR_OK;
 }
 
+/* Print the result of each iperf session, and how many frames had to be copied */
+static void lwiperf_report(void *arg, enum lwiperf_report_type report_type,
+                           const ip_addr_t* local_addr, u16_t local_port, const ip_addr_t* remote_addr, u16_t remote_port,
+                           u32_t bytes_transferred, u32_t ms_duration, u32_t bandwidth_kbitpsec)
+{
+    printf("iperf %s: %d bytes in %d ms, %d kbit/s\n", ip4addr_ntoa(remote_addr),
+           bytes_transferred, ms_duration, bandwidth_kbitpsec);
+#if ETH_ZERO_COPY
+    printf("Rx frames copied: %d\n", EMAC_get_rx_copied());
+#endif
+}
+
 #if 0
 static void netif_status_callback(struct netif *netif)
 {
@@ -161,7 +173,7 @@ int main(void)
     NVIC_EnableIRQ(EMAC_TX_IRQn);
     NVIC_EnableIRQ(EMAC_RX_IRQn);
 
-    lwiperf_start_tcp_server_default(NULL, NULL);
+    lwiperf_start_tcp_server_default(lwiperf_report, NULL);
 
     while (1)
     {
@@ -0,0 +1,471 @@
+/**************************************************************************//**
+ * @file     fwdiff.c
+ * @version  V1.00
+ * @brief    Host tool. Makes a delta compressed update image of a new firmware
+ *           against the firmware running on the device, checks it with the
+ *           device decoder and prints the transfer and flash page figures.
+ *
+ *           Build:  gcc -O2 -o fwdiff fwdiff.c ../fwdelta.c
+ *           Usage:  fwdiff <running.bin> <new.bin> <update.fwd>
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../fwdelta.h"
+
+#define BASE_ADDR           0x00000UL       /* Running image, APROM bank 0                  */
+#define DST_ADDR            0x40000UL       /* New image, APROM bank 1                      */
+#define IMAGE_MAX           0x40000UL       /* Bank size                                    */
+#define UART_BAUD           115200UL        /* Link the benchmark is given for              */
+
+#define HASH_BITS           16
+#define HASH_SIZE           (1UL << HASH_BITS)
+#define CHAIN_MAX           64              /* Candidates tried per hash chain              */
+#define MATCH_MIN           4               /* Shortest copy worth a command                */
+
+static uint8_t  *s_pu8Base, *s_pu8New, *s_pu8Out;
+static uint32_t s_u32BaseLen, s_u32NewLen, s_u32OutLen, s_u32OutMax;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  SHA-256                                                                                                */
+/*---------------------------------------------------------------------------------------------------------*/
+static const uint32_t s_au32K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(uint32_t au32H[8], const uint8_t *pu8Blk)
+{
+    uint32_t w[64], a, b, c, d, e, f, g, h, t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++)
+        w[i] = ((uint32_t)pu8Blk[i * 4] << 24) | ((uint32_t)pu8Blk[i * 4 + 1] << 16) |
+               ((uint32_t)pu8Blk[i * 4 + 2] << 8) | pu8Blk[i * 4 + 3];
+    for (i = 16; i < 64; i++)
+        w[i] = w[i - 16] + (ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+               w[i - 7] + (ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+
+    a = au32H[0]; b = au32H[1]; c = au32H[2]; d = au32H[3];
+    e = au32H[4]; f = au32H[5]; g = au32H[6]; h = au32H[7];
+    for (i = 0; i < 64; i++)
+    {
+        t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) + ((e & f) ^ (~e & g)) + s_au32K[i] + w[i];
+        t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    au32H[0] += a; au32H[1] += b; au32H[2] += c; au32H[3] += d;
+    au32H[4] += e; au32H[5] += f; au32H[6] += g; au32H[7] += h;
+}
+
+static void sha256(const uint8_t *pu8Buf, uint32_t u32Len, uint8_t au8Digest[])
+{
+    uint32_t au32H[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    uint8_t au8Blk[128];
+    uint32_t i, n, u32Bits = u32Len * 8;
+
+    for (i = 0; i + 64 <= u32Len; i += 64)
+        sha256_block(au32H, pu8Buf + i);
+
+    n = u32Len - i;
+    memset(au8Blk, 0, sizeof(au8Blk));
+    memcpy(au8Blk, pu8Buf + i, n);
+    au8Blk[n] = 0x80;
+    n = (n < 56) ? 64 : 128;
+    au8Blk[n - 4] = (uint8_t)(u32Bits >> 24);
+    au8Blk[n - 3] = (uint8_t)(u32Bits >> 16);
+    au8Blk[n - 2] = (uint8_t)(u32Bits >> 8);
+    au8Blk[n - 1] = (uint8_t)u32Bits;
+    sha256_block(au32H, au8Blk);
+    if (n == 128)
+        sha256_block(au32H, au8Blk + 64);
+
+    for (i = 0; i < 8; i++)
+    {
+        au8Digest[i * 4] = (uint8_t)(au32H[i] >> 24);
+        au8Digest[i * 4 + 1] = (uint8_t)(au32H[i] >> 16);
+        au8Digest[i * 4 + 2] = (uint8_t)(au32H[i] >> 8);
+        au8Digest[i * 4 + 3] = (uint8_t)au32H[i];
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Encoder                                                                                                */
+/*---------------------------------------------------------------------------------------------------------*/
+static void put8(uint32_t u32Val)
+{
+    if (s_u32OutLen >= s_u32OutMax)
+    {
+        s_u32OutMax *= 2;
+        s_pu8Out = realloc(s_pu8Out, s_u32OutMax);
+        if (s_pu8Out == NULL)
+        {
+            printf("Out of memory!\n");
+            exit(1);
+        }
+    }
+    s_pu8Out[s_u32OutLen++] = (uint8_t)u32Val;
+}
+
+static void put32(uint32_t u32Val)
+{
+    put8(u32Val);
+    put8(u32Val >> 8);
+    put8(u32Val >> 16);
+    put8(u32Val >> 24);
+}
+
+static void put_var(uint32_t u32Val)
+{
+    while (u32Val >= 0x80)
+    {
+        put8(u32Val | 0x80);
+        u32Val >>= 7;
+    }
+    put8(u32Val);
+}
+
+static uint32_t var_len(uint32_t u32Val)
+{
+    uint32_t n = 1;
+
+    while (u32Val >= 0x80)
+    {
+        u32Val >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static uint32_t zigzag(int32_t i32Val)
+{
+    return ((uint32_t)i32Val << 1) ^ (uint32_t)(i32Val >> 31);
+}
+
+static uint32_t hash4(const uint8_t *p)
+{
+    uint32_t u32Key = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+
+    return (uint32_t)(u32Key * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static uint32_t match_len(const uint8_t *p, const uint8_t *q, uint32_t u32Max)
+{
+    uint32_t n = 0;
+
+    while ((n < u32Max) && (p[n] == q[n]))
+        n++;
+    return n;
+}
+
+static void flush_literal(uint32_t u32Start, uint32_t u32End)
+{
+    if (u32End == u32Start)
+        return;
+    put8(FWD_OP_LITERAL);
+    put_var(u32End - u32Start);
+    while (u32Start < u32End)
+        put8(s_pu8New[u32Start++]);
+}
+
+/*
+ *  Greedy parse. At each position the longest copy from the running image (same offset as the
+ *  last block first, then hash candidates) or from the new image within FWD_WINDOW is taken if
+ *  it is shorter to code than the bytes it replaces.
+ */
+static void encode(void)
+{
+    int32_t  *pi32BaseHead, *pi32BasePrev, *pi32NewHead, *pi32NewPrev, i32Cand, i32Delta = 0;
+    uint32_t p, u32Lit = 0, u32Max, u32Len, u32Cost, i, k;
+    uint32_t u32BestLen, u32BestOp, u32BestArg;
+    int32_t  i32BestScore, i32Score;
+    uint8_t  au8Sha[FWD_SHA_SIZE];
+
+    pi32BaseHead = malloc(HASH_SIZE * sizeof(int32_t));
+    pi32NewHead = malloc(HASH_SIZE * sizeof(int32_t));
+    pi32BasePrev = malloc((s_u32BaseLen + 1) * sizeof(int32_t));
+    pi32NewPrev = malloc((s_u32NewLen + 1) * sizeof(int32_t));
+    for (i = 0; i < HASH_SIZE; i++)
+        pi32BaseHead[i] = pi32NewHead[i] = -1;
+    for (i = 0; i + 4 <= s_u32BaseLen; i++)
+    {
+        k = hash4(&s_pu8Base[i]);
+        pi32BasePrev[i] = pi32BaseHead[k];
+        pi32BaseHead[k] = (int32_t)i;
+    }
+
+    put32(FWD_MAGIC);
+    put32(s_u32BaseLen);
+    put32(s_u32NewLen);
+    put32(FWD_WINDOW);
+    sha256(s_pu8Base, s_u32BaseLen, au8Sha);
+    for (i = 0; i < FWD_SHA_SIZE; i++)
+        put8(au8Sha[i]);
+    sha256(s_pu8New, s_u32NewLen, au8Sha);
+    for (i = 0; i < FWD_SHA_SIZE; i++)
+        put8(au8Sha[i]);
+
+    for (p = 0; p < s_u32NewLen; )
+    {
+        u32Max = s_u32NewLen - p;
+        u32BestLen = 0;
+        u32BestOp = 0;
+        u32BestArg = 0;
+        i32BestScore = 0;
+
+        /* Same offset as the last block copied from the running image */
+        if (((int64_t)p + i32Delta >= 0) && ((int64_t)p + i32Delta < s_u32BaseLen))
+        {
+            k = p + i32Delta;
+            u32Len = match_len(&s_pu8New[p], &s_pu8Base[k], (u32Max < s_u32BaseLen - k) ? u32Max : s_u32BaseLen - k);
+            i32Score = (int32_t)u32Len - (int32_t)(1 + var_len(u32Len) + var_len(zigzag(i32Delta)));
+            if ((u32Len >= MATCH_MIN) && (i32Score > i32BestScore))
+            {
+                i32BestScore = i32Score;
+                u32BestLen = u32Len;
+                u32BestOp = FWD_OP_BASE;
+                u32BestArg = zigzag(i32Delta);
+            }
+        }
+
+        if (u32Max >= 4)
+        {
+            /* Running image */
+            i32Cand = pi32BaseHead[hash4(&s_pu8New[p])];
+            for (i = 0; (i < CHAIN_MAX) && (i32Cand >= 0); i++, i32Cand = pi32BasePrev[i32Cand])
+            {
+                k = (uint32_t)i32Cand;
+                u32Len = match_len(&s_pu8New[p], &s_pu8Base[k], (u32Max < s_u32BaseLen - k) ? u32Max : s_u32BaseLen - k);
+                u32Cost = 1 + var_len(u32Len) + var_len(zigzag((int32_t)(k - p)));
+                i32Score = (int32_t)u32Len - (int32_t)u32Cost;
+                if ((u32Len >= MATCH_MIN) && (i32Score > i32BestScore))
+                {
+                    i32BestScore = i32Score;
+                    u32BestLen = u32Len;
+                    u32BestOp = FWD_OP_BASE;
+                    u32BestArg = zigzag((int32_t)(k - p));
+                }
+            }
+
+            /* New image within the window */
+            i32Cand = pi32NewHead[hash4(&s_pu8New[p])];
+            for (i = 0; (i < CHAIN_MAX) && (i32Cand >= 0) && (p - (uint32_t)i32Cand <= FWD_WINDOW);
+                    i++, i32Cand = pi32NewPrev[i32Cand])
+            {
+                k = (uint32_t)i32Cand;
+                u32Len = match_len(&s_pu8New[p], &s_pu8New[k], u32Max);
+                u32Cost = 1 + var_len(u32Len) + var_len(p - k);
+                i32Score = (int32_t)u32Len - (int32_t)u32Cost;
+                if ((u32Len >= MATCH_MIN) && (i32Score > i32BestScore))
+                {
+                    i32BestScore = i32Score;
+                    u32BestLen = u32Len;
+                    u32BestOp = FWD_OP_MATCH;
+                    u32BestArg = p - k;
+                }
+            }
+        }
+
+        /* A short copy inside a literal run costs the op and length of a second run */
+        if ((u32Lit < p) && (i32BestScore <= 2))
+            u32BestOp = 0;
+
+        if (u32BestOp)
+        {
+            flush_literal(u32Lit, p);
+            put8(u32BestOp);
+            put_var(u32BestLen);
+            put_var(u32BestArg);
+            if (u32BestOp == FWD_OP_BASE)
+                i32Delta = (int32_t)((u32BestArg >> 1) ^ (0UL - (u32BestArg & 1)));
+        }
+        else
+        {
+            u32BestLen = 1;
+        }
+
+        for (i = 0; i < u32BestLen; i++, p++)
+        {
+            if (p + 4 <= s_u32NewLen)
+            {
+                k = hash4(&s_pu8New[p]);
+                pi32NewPrev[p] = pi32NewHead[k];
+                pi32NewHead[k] = (int32_t)p;
+            }
+        }
+        if (u32BestOp)
+            u32Lit = p;
+    }
+    flush_literal(u32Lit, p);
+    put8(FWD_OP_END);
+
+    free(pi32BaseHead);
+    free(pi32BasePrev);
+    free(pi32NewHead);
+    free(pi32NewPrev);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Check with the device decoder on a model of the two flash banks                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint8_t  s_au8Flash[2 * IMAGE_MAX];
+static uint32_t s_u32PagesChanged;
+
+static uint8_t *flash_ptr(uint32_t u32Addr)
+{
+    return &s_au8Flash[u32Addr];
+}
+
+static int host_program(uint32_t u32Addr, const uint32_t *pu32Buf, uint32_t u32Len)
+{
+    /* FMC_WriteImage leaves a page that already holds the data alone */
+    if (memcmp(flash_ptr(u32Addr), pu32Buf, u32Len) != 0)
+        s_u32PagesChanged++;
+    memcpy(flash_ptr(u32Addr), pu32Buf, u32Len);
+    return 0;
+}
+
+static void host_read(uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    memcpy(pu8Buf, flash_ptr(u32Addr), u32Len);
+}
+
+static int host_sha256(uint32_t u32Addr, uint32_t u32Len, uint8_t au8Digest[])
+{
+    sha256(flash_ptr(u32Addr), u32Len, au8Digest);
+    return 0;
+}
+
+static const FWD_FLASH_T s_sHostFlash = { host_program, host_read, host_sha256 };
+
+/*
+ *  Apply the update image in pieces of varying size, with bank 1 blank or holding the running image.
+ */
+static int check(int i32BankHoldsBase, FWD_STAT_T *psStat)
+{
+    static FWD_T sD;
+    uint32_t i, n, u32Seed = 1;
+    int i32Ret = FWD_OK;
+
+    memset(s_au8Flash, 0xFF, sizeof(s_au8Flash));
+    memcpy(flash_ptr(BASE_ADDR), s_pu8Base, s_u32BaseLen);
+    if (i32BankHoldsBase)
+        memcpy(flash_ptr(DST_ADDR), s_pu8Base, s_u32BaseLen);
+    s_u32PagesChanged = 0;
+
+    FWD_Init(&sD, &s_sHostFlash, BASE_ADDR, IMAGE_MAX, DST_ADDR, IMAGE_MAX);
+    for (i = 0; (i < s_u32OutLen) && (i32Ret == FWD_OK); i += n)
+    {
+        u32Seed = u32Seed * 1103515245 + 12345;
+        n = 1 + (u32Seed >> 16) % 700;
+        if (n > s_u32OutLen - i)
+            n = s_u32OutLen - i;
+        i32Ret = FWD_Input(&sD, s_pu8Out + i, n);
+    }
+    *psStat = sD.sStat;
+
+    if ((i32Ret != FWD_DONE) || memcmp(flash_ptr(DST_ADDR), s_pu8New, s_u32NewLen))
+    {
+        printf("Decoder check failed, %d\n", i32Ret);
+        return -1;
+    }
+    return 0;
+}
+
+static uint8_t *load(const char *pcName, uint32_t *pu32Len)
+{
+    FILE *fp;
+    uint8_t *pu8Buf;
+    long lLen;
+
+    fp = fopen(pcName, "rb");
+    if (fp == NULL)
+    {
+        printf("Cannot open %s\n", pcName);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    lLen = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if ((lLen <= 0) || ((unsigned long)lLen > IMAGE_MAX))
+    {
+        printf("%s: size must be 1 to %lu bytes\n", pcName, IMAGE_MAX);
+        fclose(fp);
+        return NULL;
+    }
+    pu8Buf = malloc((size_t)lLen);
+    if ((pu8Buf == NULL) || (fread(pu8Buf, 1, (size_t)lLen, fp) != (size_t)lLen))
+    {
+        printf("Cannot read %s\n", pcName);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    *pu32Len = (uint32_t)lLen;
+    return pu8Buf;
+}
+
+int main(int argc, char *argv[])
+{
+    FWD_STAT_T sStat;
+    FILE *fp;
+    uint32_t u32Pages, u32PagesSame;
+
+    if (argc != 4)
+    {
+        printf("Usage: fwdiff <running.bin> <new.bin> <update.fwd>\n");
+        return 1;
+    }
+
+    s_pu8Base = load(argv[1], &s_u32BaseLen);
+    s_pu8New = load(argv[2], &s_u32NewLen);
+    if ((s_pu8Base == NULL) || (s_pu8New == NULL))
+        return 1;
+
+    s_u32OutMax = 0x10000;
+    s_pu8Out = malloc(s_u32OutMax);
+    encode();
+
+    if (check(0, &sStat) != 0)
+        return 1;
+    u32Pages = s_u32PagesChanged;
+    if (check(1, &sStat) != 0)
+        return 1;
+    u32PagesSame = s_u32PagesChanged;
+
+    fp = fopen(argv[3], "wb");
+    if ((fp == NULL) || (fwrite(s_pu8Out, 1, s_u32OutLen, fp) != s_u32OutLen))
+    {
+        printf("Cannot write %s\n", argv[3]);
+        return 1;
+    }
+    fclose(fp);
+
+    printf("Running image     %7u bytes\n", s_u32BaseLen);
+    printf("New image         %7u bytes\n", s_u32NewLen);
+    printf("Update image      %7u bytes, %u.%u%% of the new image, %u commands\n", s_u32OutLen,
+           (unsigned)((uint64_t)s_u32OutLen * 100 / s_u32NewLen), (unsigned)((uint64_t)s_u32OutLen * 1000 / s_u32NewLen % 10),
+           sStat.u32Commands);
+    printf("  literal %u, from running image %u, from new image %u bytes\n",
+           sStat.u32LitBytes, sStat.u32BaseBytes, sStat.u32MatchBytes);
+    printf("Transfer at %u bps: full image %u ms, update image %u ms\n", (unsigned)UART_BAUD,
+           (unsigned)((uint64_t)s_u32NewLen * 10000 / UART_BAUD), (unsigned)((uint64_t)s_u32OutLen * 10000 / UART_BAUD));
+    printf("Flash pages: %u in the image, programmed into a blank bank %u, into a bank holding the running image %u\n",
+           (unsigned)((s_u32NewLen + FWD_PAGE_SIZE - 1) / FWD_PAGE_SIZE), u32Pages, u32PagesSame);
+    return 0;
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,327 @@
+/**************************************************************************//**
+ * @file     fwdelta.c
+ * @version  V1.00
+ * @brief    Streaming decoder of delta compressed firmware update images.
+ *
+ *           The update image is fed in pieces of any size as it arrives. Each
+ *           command builds the new image from literal bytes, blocks of the
+ *           running image, or earlier bytes of the new image within
+ *           FWD_WINDOW. The new image is assembled one flash page at a time,
+ *           so the decoder needs one page of RAM whatever the image size.
+ *           Plain C, also built into the host side encoder to check its output.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <string.h>
+
+#include "fwdelta.h"
+
+enum
+{
+    FWD_ST_HDR,                 /* Reading the header                 */
+    FWD_ST_OP,                  /* Waiting for an op byte             */
+    FWD_ST_LEN,                 /* Reading the length varint          */
+    FWD_ST_ARG,                 /* Reading the offset/distance varint */
+    FWD_ST_LIT,                 /* Reading literal bytes              */
+    FWD_ST_END                  /* Finished, i32Ret holds the result  */
+};
+
+#define FWD_PAGE(psD)   ((uint8_t *)(psD)->au32Page)
+
+/**
+  * @brief      Initialize a decoder.
+  * @param      psD             Decoder
+  * @param      psFlash         Flash port
+  * @param      u32BaseAddr     Address of the running image
+  * @param      u32BaseSize     Largest running image length accepted
+  * @param      u32DstAddr      Address the new image is programmed to, FWD_PAGE_SIZE aligned
+  * @param      u32DstSize      Largest new image length accepted
+  * @return     None
+  * @details    The destination must not overlap the running image.
+  */
+void FWD_Init(FWD_T *psD, const FWD_FLASH_T *psFlash, uint32_t u32BaseAddr, uint32_t u32BaseSize,
+              uint32_t u32DstAddr, uint32_t u32DstSize)
+{
+    memset(psD, 0, sizeof(FWD_T));
+    psD->psFlash = psFlash;
+    psD->u32BaseAddr = u32BaseAddr;
+    psD->u32BaseSize = u32BaseSize;
+    psD->u32DstAddr = u32DstAddr;
+    psD->u32DstSize = u32DstSize;
+    psD->u32State = FWD_ST_HDR;
+}
+
+/** @cond HIDDEN_SYMBOLS */
+
+static uint32_t FWD_Get32(const uint8_t *pu8Buf)
+{
+    return (uint32_t)pu8Buf[0] | ((uint32_t)pu8Buf[1] << 8) | ((uint32_t)pu8Buf[2] << 16) | ((uint32_t)pu8Buf[3] << 24);
+}
+
+/*
+ *  Check the header and that the running image is the one the delta was made against.
+ */
+static int FWD_Header(FWD_T *psD)
+{
+    uint8_t au8Digest[FWD_SHA_SIZE];
+
+    if (FWD_Get32(&psD->au8Hdr[0]) != FWD_MAGIC)
+        return FWD_ERR_FORMAT;
+
+    psD->u32BaseLen = FWD_Get32(&psD->au8Hdr[4]);
+    psD->u32NewLen = FWD_Get32(&psD->au8Hdr[8]);
+    if ((psD->u32NewLen == 0) || (psD->u32NewLen > psD->u32DstSize) || (FWD_Get32(&psD->au8Hdr[12]) > FWD_WINDOW))
+        return FWD_ERR_FORMAT;
+    if (psD->u32BaseLen > psD->u32BaseSize)
+        return FWD_ERR_BASE;
+
+    if (psD->psFlash->pfnSha256(psD->u32BaseAddr, psD->u32BaseLen, au8Digest) != 0)
+        return FWD_ERR_VERIFY;
+    if (memcmp(au8Digest, &psD->au8Hdr[16], FWD_SHA_SIZE) != 0)
+        return FWD_ERR_BASE;
+
+    return FWD_OK;
+}
+
+/*
+ *  Program the page holding the last decoded byte, padded with 0xFF to a word.
+ */
+static int FWD_Flush(FWD_T *psD)
+{
+    uint32_t u32Page, u32Len;
+
+    u32Page = (psD->u32Out - 1) & ~(FWD_PAGE_SIZE - 1);
+    u32Len = psD->u32Out - u32Page;
+    while (u32Len & 3)
+        FWD_PAGE(psD)[u32Len++] = 0xFF;
+
+    psD->sStat.u32Pages++;
+    if (psD->psFlash->pfnProgram(psD->u32DstAddr + u32Page, psD->au32Page, u32Len) != 0)
+        return FWD_ERR_PROGRAM;
+    return FWD_OK;
+}
+
+/*
+ *  Execute FWD_OP_BASE or FWD_OP_MATCH. u32Src is the offset in the running or new image.
+ */
+static int FWD_Copy(FWD_T *psD, uint32_t u32Op, uint32_t u32Src, uint32_t u32Len)
+{
+    uint32_t u32Pos, u32PageStart, n;
+
+    while (u32Len)
+    {
+        u32Pos = psD->u32Out % FWD_PAGE_SIZE;
+        u32PageStart = psD->u32Out - u32Pos;
+        n = FWD_PAGE_SIZE - u32Pos;
+        if (n > u32Len)
+            n = u32Len;
+
+        if (u32Op == FWD_OP_BASE)
+        {
+            psD->psFlash->pfnRead(psD->u32BaseAddr + u32Src, FWD_PAGE(psD) + u32Pos, n);
+        }
+        else
+        {
+            /* Copy at most one distance at a time, so an overlapping match repeats its bytes */
+            if (n > psD->u32Out - u32Src)
+                n = psD->u32Out - u32Src;
+
+            if (u32Src >= u32PageStart)
+            {
+                memcpy(FWD_PAGE(psD) + u32Pos, FWD_PAGE(psD) + (u32Src - u32PageStart), n);
+            }
+            else
+            {
+                /* Earlier bytes are already programmed */
+                if (n > u32PageStart - u32Src)
+                    n = u32PageStart - u32Src;
+                psD->psFlash->pfnRead(psD->u32DstAddr + u32Src, FWD_PAGE(psD) + u32Pos, n);
+            }
+        }
+
+        u32Src += n;
+        u32Len -= n;
+        psD->u32Out += n;
+        if ((psD->u32Out % FWD_PAGE_SIZE) == 0)
+        {
+            if (FWD_Flush(psD) != FWD_OK)
+                return FWD_ERR_PROGRAM;
+        }
+    }
+    return FWD_OK;
+}
+
+/*
+ *  Execute a command whose varints are complete.
+ */
+static int FWD_Command(FWD_T *psD)
+{
+    uint32_t u32Src;
+
+    if (psD->u32Op == FWD_OP_BASE)
+    {
+        /* Zigzag: 0, -1, 1, -2, ... */
+        u32Src = psD->u32Out + ((psD->u32Var >> 1) ^ (0UL - (psD->u32Var & 1)));
+        if ((u32Src > psD->u32BaseLen) || (psD->u32Len > psD->u32BaseLen - u32Src))
+            return FWD_ERR_FORMAT;
+        psD->sStat.u32BaseBytes += psD->u32Len;
+    }
+    else
+    {
+        if ((psD->u32Var == 0) || (psD->u32Var > FWD_WINDOW) || (psD->u32Var > psD->u32Out))
+            return FWD_ERR_FORMAT;
+        u32Src = psD->u32Out - psD->u32Var;
+        psD->sStat.u32MatchBytes += psD->u32Len;
+    }
+    return FWD_Copy(psD, psD->u32Op, u32Src, psD->u32Len);
+}
+
+/*
+ *  FWD_OP_END: program the last page and check the SHA-256 of the new image in flash.
+ */
+static int FWD_Finish(FWD_T *psD)
+{
+    uint8_t au8Digest[FWD_SHA_SIZE];
+
+    if (psD->u32Out != psD->u32NewLen)
+        return FWD_ERR_FORMAT;
+
+    if (psD->u32Out % FWD_PAGE_SIZE)
+    {
+        if (FWD_Flush(psD) != FWD_OK)
+            return FWD_ERR_PROGRAM;
+    }
+
+    if ((psD->psFlash->pfnSha256(psD->u32DstAddr, psD->u32NewLen, au8Digest) != 0) ||
+            (memcmp(au8Digest, &psD->au8Hdr[48], FWD_SHA_SIZE) != 0))
+        return FWD_ERR_VERIFY;
+
+    return FWD_DONE;
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief      Feed the next piece of the update image.
+  * @param      psD         Decoder set up by FWD_Init
+  * @param      pu8Buf      Update image data
+  * @param      u32Len      Bytes in pu8Buf, any number
+  * @retval     FWD_OK              More data expected
+  * @retval     FWD_DONE            New image programmed and its SHA-256 verified
+  * @retval     FWD_ERR_FORMAT      Bad header or command
+  * @retval     FWD_ERR_BASE        Running image does not match the one the delta was made against
+  * @retval     FWD_ERR_PROGRAM     Flash program failed
+  * @retval     FWD_ERR_VERIFY      SHA-256 of the new image does not match
+  * @details    The running image is checked before anything is programmed. Once finished, the
+  *             same result is returned for further data.
+  */
+int FWD_Input(FWD_T *psD, const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint32_t i = 0, n, u32Pos;
+    uint8_t u8Byte;
+    int i32Ret = FWD_OK;
+
+    while ((i < u32Len) && (psD->u32State != FWD_ST_END))
+    {
+        switch (psD->u32State)
+        {
+        case FWD_ST_HDR:
+            n = FWD_HDR_SIZE - psD->u32Len;
+            if (n > u32Len - i)
+                n = u32Len - i;
+            memcpy(&psD->au8Hdr[psD->u32Len], &pu8Buf[i], n);
+            psD->u32Len += n;
+            i += n;
+            if (psD->u32Len == FWD_HDR_SIZE)
+            {
+                i32Ret = FWD_Header(psD);
+                psD->u32State = FWD_ST_OP;
+            }
+            break;
+
+        case FWD_ST_OP:
+            u8Byte = pu8Buf[i++];
+            psD->sStat.u32Commands++;
+            if (u8Byte == FWD_OP_END)
+            {
+                i32Ret = FWD_Finish(psD);
+            }
+            else if (u8Byte <= FWD_OP_MATCH)
+            {
+                psD->u32Op = u8Byte;
+                psD->u32Var = 0;
+                psD->u32Shift = 0;
+                psD->u32State = FWD_ST_LEN;
+            }
+            else
+            {
+                i32Ret = FWD_ERR_FORMAT;
+            }
+            break;
+
+        case FWD_ST_LEN:
+        case FWD_ST_ARG:
+            u8Byte = pu8Buf[i++];
+            if (psD->u32Shift > 28)
+            {
+                i32Ret = FWD_ERR_FORMAT;
+                break;
+            }
+            psD->u32Var |= (uint32_t)(u8Byte & 0x7F) << psD->u32Shift;
+            psD->u32Shift += 7;
+            if (u8Byte & 0x80)
+                break;
+
+            if (psD->u32State == FWD_ST_LEN)
+            {
+                if ((psD->u32Var == 0) || (psD->u32Var > psD->u32NewLen - psD->u32Out))
+                {
+                    i32Ret = FWD_ERR_FORMAT;
+                    break;
+                }
+                psD->u32Len = psD->u32Var;
+                psD->u32Var = 0;
+                psD->u32Shift = 0;
+                psD->u32State = (psD->u32Op == FWD_OP_LITERAL) ? FWD_ST_LIT : FWD_ST_ARG;
+            }
+            else
+            {
+                i32Ret = FWD_Command(psD);
+                psD->u32State = FWD_ST_OP;
+            }
+            break;
+
+        case FWD_ST_LIT:
+            u32Pos = psD->u32Out % FWD_PAGE_SIZE;
+            n = FWD_PAGE_SIZE - u32Pos;
+            if (n > psD->u32Len)
+                n = psD->u32Len;
+            if (n > u32Len - i)
+                n = u32Len - i;
+            memcpy(FWD_PAGE(psD) + u32Pos, &pu8Buf[i], n);
+            i += n;
+            psD->u32Len -= n;
+            psD->u32Out += n;
+            psD->sStat.u32LitBytes += n;
+            if ((psD->u32Out % FWD_PAGE_SIZE) == 0)
+                i32Ret = FWD_Flush(psD);
+            if (psD->u32Len == 0)
+                psD->u32State = FWD_ST_OP;
+            break;
+
+        default:
+            break;
+        }
+
+        if (i32Ret != FWD_OK)
+        {
+            psD->i32Ret = i32Ret;
+            psD->u32State = FWD_ST_END;
+        }
+    }
+
+    psD->sStat.u32InBytes += i;
+    return (psD->u32State == FWD_ST_END) ? psD->i32Ret : FWD_OK;
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,105 @@
+/**************************************************************************//**
+ * @file     fwdelta.h
+ * @version  V1.00
+ * @brief    Streaming decoder of delta compressed firmware update images
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __FWDELTA_H__
+#define __FWDELTA_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ *  Update image format. All numbers are little endian.
+ *
+ *  Header, FWD_HDR_SIZE bytes:
+ *      0   magic       FWD_MAGIC
+ *      4   base_len    length of the running image the delta was made against
+ *      8   new_len     length of the new image
+ *      12  window      largest FWD_OP_MATCH distance used, at most FWD_WINDOW
+ *      16  base_sha    SHA-256 of the running image
+ *      48  new_sha     SHA-256 of the new image
+ *
+ *  Commands, an op byte followed by LEB128 varints:
+ *      FWD_OP_END                  end of the image
+ *      FWD_OP_LITERAL  len         len bytes follow
+ *      FWD_OP_BASE     len, delta  copy len bytes of the running image from output position + delta,
+ *                                  delta zigzag coded; an unchanged block is delta 0
+ *      FWD_OP_MATCH    len, dist   copy len bytes of the new image from dist bytes back, may overlap
+ */
+#define FWD_MAGIC           0x31445746UL    /*!< "FWD1"                                              */
+#define FWD_HDR_SIZE        80UL            /*!< Header size                                         */
+#define FWD_SHA_SIZE        32UL            /*!< SHA-256 digest size                                 */
+#define FWD_PAGE_SIZE       4096UL          /*!< Output is programmed in pages of this size          */
+#define FWD_WINDOW          4096UL          /*!< Largest FWD_OP_MATCH distance the decoder accepts   */
+
+#define FWD_OP_END          0x00            /*!< End of image                                        */
+#define FWD_OP_LITERAL      0x01            /*!< Literal bytes                                       */
+#define FWD_OP_BASE         0x02            /*!< Copy from the running image                         */
+#define FWD_OP_MATCH        0x03            /*!< Copy from the new image already decoded             */
+
+#define FWD_OK              0               /*!< Input consumed, more expected                       */
+#define FWD_DONE            1               /*!< Image complete and verified                         */
+#define FWD_ERR_FORMAT      (-1)            /*!< Bad header or command                               */
+#define FWD_ERR_BASE        (-2)            /*!< Running image does not match the delta              */
+#define FWD_ERR_PROGRAM     (-3)            /*!< Flash program failed                                */
+#define FWD_ERR_VERIFY      (-4)            /*!< SHA-256 of the new image does not match             */
+
+/*
+ *  Flash port. Addresses are those given to FWD_Init.
+ */
+typedef struct
+{
+    int  (*pfnProgram)(uint32_t u32Addr, const uint32_t *pu32Buf, uint32_t u32Len); /*!< Program up to one page at a page aligned address, 0 on success */
+    void (*pfnRead)(uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len);             /*!< Read flash */
+    int  (*pfnSha256)(uint32_t u32Addr, uint32_t u32Len, uint8_t au8Digest[]);        /*!< SHA-256 of flash, 0 on success */
+} FWD_FLASH_T;
+
+typedef struct
+{
+    uint32_t u32InBytes;        /*!< Update image bytes consumed        */
+    uint32_t u32Commands;       /*!< Commands decoded                   */
+    uint32_t u32LitBytes;       /*!< Bytes from FWD_OP_LITERAL          */
+    uint32_t u32BaseBytes;      /*!< Bytes from FWD_OP_BASE             */
+    uint32_t u32MatchBytes;     /*!< Bytes from FWD_OP_MATCH            */
+    uint32_t u32Pages;          /*!< Pages handed to pfnProgram         */
+} FWD_STAT_T;
+
+typedef struct
+{
+    const FWD_FLASH_T *psFlash;         /*!< Flash port                                   */
+    uint32_t u32BaseAddr;               /*!< Running image address                        */
+    uint32_t u32BaseSize;               /*!< Largest running image                        */
+    uint32_t u32DstAddr;                /*!< New image address, page aligned              */
+    uint32_t u32DstSize;                /*!< Largest new image                            */
+    uint8_t  au8Hdr[FWD_HDR_SIZE];      /*!< Header as received                           */
+    uint32_t u32BaseLen;                /*!< Running image length from the header         */
+    uint32_t u32NewLen;                 /*!< New image length from the header             */
+    uint32_t u32State;                  /*!< Parser state                                 */
+    uint32_t u32Op;                     /*!< Command being parsed                         */
+    uint32_t u32Var;                    /*!< Varint being parsed                          */
+    uint32_t u32Shift;                  /*!< Bit position in u32Var                       */
+    uint32_t u32Len;                    /*!< Length of the command, or header bytes read  */
+    uint32_t u32Out;                    /*!< New image bytes decoded                      */
+    int32_t  i32Ret;                    /*!< FWD_DONE or the error once finished          */
+    uint32_t au32Page[FWD_PAGE_SIZE / 4]; /*!< Page being assembled                       */
+    FWD_STAT_T sStat;                   /*!< Statistics                                   */
+} FWD_T;
+
+void FWD_Init(FWD_T *psD, const FWD_FLASH_T *psFlash, uint32_t u32BaseAddr, uint32_t u32BaseSize,
+              uint32_t u32DstAddr, uint32_t u32DstSize);
+int  FWD_Input(FWD_T *psD, const uint8_t *pu8Buf, uint32_t u32Len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __FWDELTA_H__ */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,299 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Receive a delta compressed firmware update image from UART0 and
+ *           apply it to APROM bank1 while running from bank0. The running
+ *           image in bank0 is the base of the delta. Both the running image
+ *           and the new image are verified by SHA-256 with the crypto engine.
+ *           Update images are made by HostTool/fwdiff.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "fwdelta.h"
+
+#define APROM_BANK0_BASE            0x00000      /* Running image                            */
+#define APROM_BANK1_BASE            0x40000      /* APROM bank1 base address for 512KB size. */
+#define APROM_BANK_SIZE             0x40000      /* Largest image                            */
+
+#define UART_BAUD                   115200       /* Update image link                        */
+#define RX_BUF_SIZE                 4096         /* Holds data arriving while a page is programmed */
+#define RX_IDLE_MS                  3000         /* Give up when no data arrives for this long */
+#define SHA_CHUNK_SIZE              4096         /* Flash bytes copied to SRAM per SHA DMA   */
+#define SHA_TIMEOUT                 0x1000000    /* Polls of one SHA DMA                     */
+
+
+static uint8_t  s_au8RxBuf[RX_BUF_SIZE];         /* UART0 receive ring                       */
+static volatile uint32_t s_u32RxHead;            /* Written by UART0_IRQHandler              */
+static volatile uint32_t s_u32RxOverflow;        /* Bytes lost because the ring was full     */
+static volatile uint32_t s_u32RxTail;            /* Read by UART0_IRQHandler                 */
+
+static uint32_t s_au32ShaBuf[SHA_CHUNK_SIZE / 4];   /* SHA DMA source                        */
+static FMC_IMG_STAT_T s_sImgStat;                   /* FMC_WriteImage counters               */
+static FWD_T s_sFwd;                                /* Update image decoder                  */
+
+volatile uint32_t  g_u32Ticks;                   /* 1 ms ticks                               */
+
+
+void SysTick_Handler(void)
+{
+    g_u32Ticks++;
+}
+
+void UART0_IRQHandler(void)
+{
+    uint32_t u32Head = s_u32RxHead;
+
+    while (!UART_GET_RX_EMPTY(UART0))
+    {
+        if (((u32Head + 1) % RX_BUF_SIZE) == s_u32RxTail)
+        {
+            (void)UART0->DAT;
+            s_u32RxOverflow++;
+            continue;
+        }
+        s_au8RxBuf[u32Head] = (uint8_t)UART0->DAT;
+        u32Head = (u32Head + 1) % RX_BUF_SIZE;
+    }
+    s_u32RxHead = u32Head;
+}
+
+/*
+ *  Flash port of the decoder
+ */
+static int FwdProgram(uint32_t u32Addr, const uint32_t *pu32Buf, uint32_t u32Len)
+{
+    return (FMC_WriteImage(u32Addr, pu32Buf, u32Len, &s_sImgStat) == 0) ? 0 : -1;
+}
+
+static void FwdRead(uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    memcpy(pu8Buf, (void *)u32Addr, u32Len);
+}
+
+/*
+ *  SHA-256 of flash with the crypto engine, SHA_CHUNK_SIZE bytes per DMA cascade step.
+ *  Input and output are swapped so the digest bytes are in the usual order.
+ */
+static int FwdSha256(uint32_t u32Addr, uint32_t u32Len, uint8_t au8Digest[])
+{
+    uint32_t au32Digest[8], u32Mode, n, u32Timeout;
+    uint32_t u32Done = 0;
+
+    if (u32Len == 0)
+        return -1;
+
+    SHA_Open(CRPT, SHA_MODE_SHA256, SHA_IN_OUT_SWAP, 0);
+
+    while (u32Done < u32Len)
+    {
+        n = u32Len - u32Done;
+        if (n > SHA_CHUNK_SIZE)
+            n = SHA_CHUNK_SIZE;
+        memcpy(s_au32ShaBuf, (void *)(u32Addr + u32Done), n);
+
+        if (u32Done == 0)
+            u32Mode = (n == u32Len) ? CRYPTO_DMA_ONE_SHOT : CRYPTO_DMA_FIRST;
+        else
+            u32Mode = (u32Done + n == u32Len) ? CRYPTO_DMA_LAST : CRYPTO_DMA_CONTINUE;
+
+        SHA_CLR_INT_FLAG(CRPT);
+        SHA_SetDMATransfer(CRPT, (uint32_t)s_au32ShaBuf, n);
+        SHA_Start(CRPT, u32Mode);
+
+        for (u32Timeout = SHA_TIMEOUT; !SHA_GET_INT_FLAG(CRPT); u32Timeout--)
+        {
+            if (u32Timeout == 0)
+                return -1;
+        }
+        if (CRPT->INTSTS & CRPT_INTSTS_HMACEIF_Msk)
+            return -1;
+
+        u32Done += n;
+    }
+    SHA_CLR_INT_FLAG(CRPT);
+
+    SHA_Read(CRPT, au32Digest);
+    memcpy(au8Digest, au32Digest, FWD_SHA_SIZE);
+    return 0;
+}
+
+static const FWD_FLASH_T s_sFwdFlash = { FwdProgram, FwdRead, FwdSha256 };
+
+
+void SYS_Init(void)
+{
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Set XT1_OUT(PF.2) and XT1_IN(PF.3) to input mode */
+    PF->MODE &= ~(GPIO_MODE_MODE2_Msk | GPIO_MODE_MODE3_Msk);
+
+    /* Enable HXT clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HXTEN_Msk);
+
+    /* Wait for HXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HXTSTB_Msk);
+
+    /* Switch HCLK clock source to HXT */
+    CLK_SetHCLK(CLK_CLKSEL0_HCLKSEL_HXT,CLK_CLKDIV0_HCLK(1));
+
+    /* Set core clock as PLL_CLOCK from PLL */
+    CLK_SetCoreClock(FREQ_192MHZ);
+
+    /* Set both PCLK0 and PCLK1 as HCLK/2 */
+    CLK->PCLKDIV = CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2;
+
+    /* Enable UART module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART module clock source as HXT and UART module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HXT, CLK_CLKDIV0_UART0(1));
+
+    /* Enable crypto engine clock for SHA-256 */
+    CLK_EnableModuleClock(CRPT_MODULE);
+
+    /* Update System Core Clock */
+    SystemCoreClockUpdate();
+
+    /* Set GPB multi-function pins for UART0 RXD and TXD */
+    SYS->GPB_MFPH &= ~(SYS_GPB_MFPH_PB12MFP_Msk | SYS_GPB_MFPH_PB13MFP_Msk);
+    SYS->GPB_MFPH |= (SYS_GPB_MFPH_PB12MFP_UART0_RXD | SYS_GPB_MFPH_PB13MFP_UART0_TXD);
+
+    /* Lock protected registers */
+    SYS_LockReg();
+}
+
+void UART0_Init(void)
+{
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, UART_BAUD);
+}
+
+/*
+ *  Feed received data to the decoder until it finishes or the data stops.
+ */
+static int receive_update(uint32_t *pu32Ms)
+{
+    uint32_t u32Head, u32Start = 0, u32Last, n;
+    int i32Ret = FWD_OK;
+
+    s_u32RxHead = s_u32RxTail = 0;
+    s_u32RxOverflow = 0;
+    UART_ENABLE_INT(UART0, UART_INTEN_RDAIEN_Msk | UART_INTEN_RXTOIEN_Msk);
+    NVIC_EnableIRQ(UART0_IRQn);
+
+    u32Last = g_u32Ticks;
+    while (i32Ret == FWD_OK)
+    {
+        u32Head = s_u32RxHead;
+        if (u32Head == s_u32RxTail)
+        {
+            /* Wait for the first byte as long as it takes */
+            if ((s_sFwd.sStat.u32InBytes != 0) && (g_u32Ticks - u32Last > RX_IDLE_MS))
+                break;
+            continue;
+        }
+
+        if (s_sFwd.sStat.u32InBytes == 0)
+            u32Start = g_u32Ticks;
+        u32Last = g_u32Ticks;
+
+        /* Contiguous part of the ring */
+        n = (u32Head > s_u32RxTail) ? (u32Head - s_u32RxTail) : (RX_BUF_SIZE - s_u32RxTail);
+        i32Ret = FWD_Input(&s_sFwd, &s_au8RxBuf[s_u32RxTail], n);
+        s_u32RxTail = (s_u32RxTail + n) % RX_BUF_SIZE;
+
+        if (s_u32RxOverflow)
+        {
+            printf("UART0 receive buffer overflow!\n");
+            i32Ret = FWD_ERR_FORMAT;
+        }
+    }
+
+    NVIC_DisableIRQ(UART0_IRQn);
+    UART_DISABLE_INT(UART0, UART_INTEN_RDAIEN_Msk | UART_INTEN_RXTOIEN_Msk);
+    *pu32Ms = g_u32Ticks - u32Start;
+    return i32Ret;
+}
+
+int main()
+{
+    uint32_t    u32Ms;                 /* update time in ms                              */
+    int         i32Ret;
+
+    SYS_Init();                        /* Init System, IP clock and multi-function I/O   */
+
+    UART0_Init();                      /* Initialize UART0                               */
+
+    if ((SYS->CSERVER & SYS_CSERVER_VERSION_Msk) == 0x1)
+    {
+        printf("M480LD does not support dual bank!\n");
+        while (1);
+    }
+
+    printf("+------------------------------------------+\n");
+    printf("|    M480 FMC Delta Update Sample Demo     |\n");
+    printf("+------------------------------------------+\n");
+
+    SysTick_Config(SystemCoreClock / 1000);
+
+    SYS_UnlockReg();                   /* Unlock register lock protect                   */
+
+    FMC_Open();                        /* Enable FMC ISP function                        */
+    FMC_ENABLE_AP_UPDATE();            /* Enable FMC erase/program APROM                 */
+
+    printf("Running image at 0x%x, new image goes to bank1 at 0x%x.\n", APROM_BANK0_BASE, APROM_BANK1_BASE);
+    printf("Send the update image made by fwdiff to UART0 as raw binary...\n");
+
+    memset(&s_sImgStat, 0, sizeof(s_sImgStat));
+    FWD_Init(&s_sFwd, &s_sFwdFlash, APROM_BANK0_BASE, APROM_BANK_SIZE, APROM_BANK1_BASE, APROM_BANK_SIZE);
+
+    i32Ret = receive_update(&u32Ms);
+
+    switch (i32Ret)
+    {
+    case FWD_DONE:
+        printf("\nNew image of %d bytes programmed and SHA-256 verified.\n", s_sFwd.u32NewLen);
+        break;
+    case FWD_OK:
+        printf("\nUpdate image incomplete, %d bytes received.\n", s_sFwd.sStat.u32InBytes);
+        break;
+    case FWD_ERR_BASE:
+        printf("\nThe update image was not made against the running image!\n");
+        break;
+    case FWD_ERR_PROGRAM:
+        printf("\nFlash program failed!\n");
+        break;
+    case FWD_ERR_VERIFY:
+        printf("\nSHA-256 of the new image does not match!\n");
+        break;
+    default:
+        printf("\nBad update image!\n");
+        break;
+    }
+
+    if (s_sFwd.u32NewLen)
+    {
+        printf("Update image %d bytes in %d ms; the full image is %d bytes, %d ms at %d bps.\n",
+               s_sFwd.sStat.u32InBytes, u32Ms, s_sFwd.u32NewLen, s_sFwd.u32NewLen * 10000UL / UART_BAUD, UART_BAUD);
+        printf("Bytes: literal %d, from running image %d, from new image %d.\n",
+               s_sFwd.sStat.u32LitBytes, s_sFwd.sStat.u32BaseBytes, s_sFwd.sStat.u32MatchBytes);
+        printf("Pages: %d decoded, %d unchanged, %d blank, %d erased, %d program commands.\n",
+               s_sImgStat.u32Pages, s_sImgStat.u32SamePages, s_sImgStat.u32BlankPages,
+               s_sImgStat.u32Erases, s_sImgStat.u32ProgCalls);
+    }
+
+    FMC_Close();                       /* Disable FMC ISP function                       */
+
+    SYS_LockReg();                     /* Lock protected registers                       */
+
+    printf("\nFMC Sample Code Completed.\n");
+
+    while (1);
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -13,6 +13,7 @@
 #include <string.h>
 #include "NuMicro.h"
 #include "massstorage.h"
+#include "msc_pipe.h"
 
 /*--------------------------------------------------------------------------*/
 /* Global variables for Control Pipe */
@@ -30,7 +31,6 @@ uint32_t g_u32LbaAddress;
 uint32_t g_u32DataTransferSector;
 uint32_t g_u32MassBase, g_u32StorageBase;
 uint8_t gMassBuf[256];
-uint8_t gStorageBuf[USBD_MAX_SD_LEN];
 
 uint32_t g_u32EpMaxPacketSize;
 uint32_t g_u32CbwSize = 0;
@@ -39,8 +39,6 @@ uint32_t g_u32CbwSize = 0;
 struct CBW g_sCBW;
 struct CSW g_sCSW;
 
-extern uint8_t volatile g_u8SdInitFlag;
-
 /*--------------------------------------------------------------------------*/
 uint8_t g_au8InquiryID[36] =
 {
@@ -386,9 +384,9 @@ void MSC_Init(void)
     MSC_InitForHighSpeed();
 
     g_sCSW.dCSWSignature = CSW_SIGNATURE;
-    if (g_u8SdInitFlag)
+    if (MSCP_IsReady())
     {
-        g_TotalSectors = SD0.totalSectorN;
+        g_TotalSectors = MSCP_GetSectors();
         g_au8SenseKey[0] = 0x0;
         g_au8SenseKey[1] = 0x0;
         g_au8SenseKey[2] = 0x0;
@@ -401,7 +399,7 @@ void MSC_Init(void)
         g_au8SenseKey[2] = 0x01;
     }
     g_u32MassBase = (uint32_t)gMassBuf;
-    g_u32StorageBase = (uint32_t)gStorageBuf;
+    g_u32StorageBase = (uint32_t)MSCP_GetBuffer();
 
     printf("total %d\n", g_TotalSectors);
 }
@@ -479,13 +477,7 @@ void MSC_RequestSense(void)
     } else
         *(uint8_t *)(g_u32MassBase) = 0xf0;
 
-    if (SD0.IsCardInsert)
-    {
-        g_au8SenseKey[0] = 0x0;
-        g_au8SenseKey[1] = 0x0;
-        g_au8SenseKey[2] = 0x0;
-    }
-    else
+    if (!MSCP_IsReady())
     {
         g_au8SenseKey[0] = 0x02;
         g_au8SenseKey[1] = 0x3a;
@@ -496,6 +488,11 @@ void MSC_RequestSense(void)
     *(uint8_t *)(g_u32MassBase + 7) = 0x0a;
     *(uint8_t *)(g_u32MassBase + 12) = g_au8SenseKey[1];
     *(uint8_t *)(g_u32MassBase + 13) = g_au8SenseKey[2];
+
+    /* Sense data of a failed READ/WRITE is reported once */
+    g_au8SenseKey[0] = 0x0;
+    g_au8SenseKey[1] = 0x0;
+    g_au8SenseKey[2] = 0x0;
     MSC_BulkIn(g_u32MassBase, g_sCBW.dCBWDataTransferLength);
 }
 
@@ -623,6 +620,29 @@ void MSC_ModeSense6(void)
     MSC_BulkIn(g_u32MassBase, g_sCBW.dCBWDataTransferLength);
 }
 
+/* Fail the command and set the sense data for an error of msc_pipe.c */
+static void MSC_SetPipeError(int32_t i32Err, uint8_t u8Asc)
+{
+    g_u8Prevent = 1;
+    g_sCSW.bCSWStatus = 0x01;
+    if (i32Err == MSCP_ERR_RANGE)
+    {
+        g_au8SenseKey[0] = 0x05;    /* Illegal request, LBA out of range */
+        g_au8SenseKey[1] = 0x21;
+    }
+    else if (i32Err == MSCP_ERR_NOT_READY)
+    {
+        g_au8SenseKey[0] = 0x02;    /* Not ready, medium not present */
+        g_au8SenseKey[1] = 0x3a;
+    }
+    else
+    {
+        g_au8SenseKey[0] = 0x03;    /* Medium error */
+        g_au8SenseKey[1] = u8Asc;
+    }
+    g_au8SenseKey[2] = 0x00;
+}
+
 void MSC_BulkOut(uint32_t u32Addr, uint32_t u32Len)
 {
     uint32_t u32Loop;
@@ -720,8 +740,9 @@ void MSC_ReceiveCBW(uint32_t u32Buf, uint32_t u32Len)
 
 void MSC_ProcessCmd(void)
 {
-    uint32_t i, count;
+    uint32_t i;
     uint32_t Hcount, Dcount;
+    int32_t i32Ret;
 
     if (g_u8MscOutPacket)
     {
@@ -800,28 +821,10 @@ void MSC_ProcessCmd(void)
                 /* Get LBA address */
                 g_u32LbaAddress = get_be32(&g_sCBW.au8Data[0]);
                 g_u32DataTransferSector = g_sCBW.dCBWDataTransferLength / USBD_SECTOR_SIZE;
-                if (Hcount > USBD_MAX_SD_LEN)
-                {
-                    count = g_sCBW.dCBWDataTransferLength / USBD_MAX_SD_LEN;
-                    for (i=0; i<count; i++)
-                    {
-                        MSC_ReadMedia(g_u32LbaAddress+i*USBD_MAX_SD_SECTOR, USBD_MAX_SD_SECTOR, (uint8_t *)g_u32StorageBase);
-                        MSC_BulkIn(g_u32StorageBase, USBD_MAX_SD_LEN);                            
-                    }
-
-                    if ((g_sCBW.dCBWDataTransferLength % USBD_MAX_SD_LEN) != 0)
-                    {
-                        MSC_ReadMedia(g_u32LbaAddress+i*USBD_MAX_SD_SECTOR, g_u32DataTransferSector % USBD_MAX_SD_SECTOR, (uint8_t *)g_u32StorageBase);
-                        MSC_BulkIn(g_u32StorageBase, g_sCBW.dCBWDataTransferLength % USBD_MAX_SD_LEN);
-                    }
-                }
-                else
-                {
-                    //--- read data from SD card address g_u32LbaAddress to buffer in SRAM (g_u32StorageBase).
-                    MSC_ReadMedia(g_u32LbaAddress, g_u32DataTransferSector, (uint8_t *)g_u32StorageBase);
-                    MSC_BulkIn(g_u32StorageBase, g_sCBW.dCBWDataTransferLength);
-                    break;
-                }
+                //--- media reads overlap the bulk IN DMA of the data read before
+                i32Ret = MSCP_Read(g_u32LbaAddress, g_sCBW.dCBWDataTransferLength);
+                if (i32Ret != MSCP_OK)
+                    MSC_SetPipeError(i32Ret, 0x11);     /* unrecovered read error */
                 g_sCSW.dCSWDataResidue = 0;
                 break;
             }
@@ -853,27 +856,10 @@ void MSC_ProcessCmd(void)
                     }
                     g_u32LbaAddress = get_be32(&g_sCBW.au8Data[0]);
                     g_u32DataTransferSector = g_sCBW.dCBWDataTransferLength / USBD_SECTOR_SIZE;
-                    if (Hcount > USBD_MAX_SD_LEN)
-                    {
-                        count = g_sCBW.dCBWDataTransferLength / USBD_MAX_SD_LEN;
-                        for (i=0; i<count; i++)
-                        {
-                            MSC_BulkOut(g_u32StorageBase, USBD_MAX_SD_LEN);
-                            MSC_WriteMedia(g_u32LbaAddress+i*USBD_MAX_SD_SECTOR, USBD_MAX_SD_SECTOR, (uint8_t *)g_u32StorageBase);
-                        }
-
-                        if ((g_sCBW.dCBWDataTransferLength % USBD_MAX_SD_LEN) != 0)
-                        {
-                            MSC_BulkOut(g_u32StorageBase, g_sCBW.dCBWDataTransferLength % USBD_MAX_SD_LEN);
-                            MSC_WriteMedia(g_u32LbaAddress+i*USBD_MAX_SD_SECTOR, g_u32DataTransferSector % USBD_MAX_SD_SECTOR, (uint8_t *)g_u32StorageBase);
-                        }
-                    }
-                    else
-                    {
-                        MSC_BulkOut(g_u32StorageBase, g_sCBW.dCBWDataTransferLength);
-                        //--- write data from buffer in SRAM (g_u32StorageBase) to SD card address g_u32LbaAddress.
-                        MSC_WriteMedia(g_u32LbaAddress, g_u32DataTransferSector, (uint8_t *)g_u32StorageBase);
-                    }
+                    //--- bulk OUT DMA of the next data overlaps the media writes of the data received before
+                    i32Ret = MSCP_Write(g_u32LbaAddress, g_sCBW.dCBWDataTransferLength);
+                    if (i32Ret != MSCP_OK)
+                        MSC_SetPipeError(i32Ret, 0x0C);     /* write error */
                     g_sCSW.dCSWDataResidue = 0;
                 }
                 else     /* Hi <> Do (Case 8) */
@@ -941,10 +927,18 @@ void MSC_ProcessCmd(void)
                 {
                     g_u8Remove = 1;
                 }
+                MSCP_Flush();
                 g_sCSW.dCSWDataResidue = 0;
                 g_sCSW.bCSWStatus = 0;
                 break;
             }
+            case UFI_SYNCHRONIZE_CACHE_10:
+            {
+                if (MSCP_Flush() != MSCP_OK)
+                    MSC_SetPipeError(MSCP_ERR_MEDIA, 0x0C);
+                g_sCSW.dCSWDataResidue = 0;
+                break;
+            }
             case UFI_VERIFY_10:
             {
                 g_sCSW.dCSWDataResidue = 0;
@@ -1091,7 +1085,7 @@ void MSC_ActiveDMA(uint32_t u32Addr, uint32_t u32Len)
 void MSC_AckCmd()
 {
     g_sCSW.bCSWStatus = g_u8Prevent;
-    if (SD0.IsCardInsert == 0)
+    if (!MSCP_IsReady())
     {
         if ((g_sCBW.u8OPCode == UFI_INQUIRY) || (g_sCBW.u8OPCode == UFI_REQUEST_SENSE))
             g_sCSW.bCSWStatus = 0x00;
@@ -1104,13 +1098,3 @@ void MSC_AckCmd()
     g_u8MscOutPacket = 0;
 }
 
-void MSC_ReadMedia(uint32_t addr, uint32_t size, uint8_t *buffer)
-{
-    SDH_Read(SDH0, buffer, addr, size);
-}
-
-void MSC_WriteMedia(uint32_t addr, uint32_t size, uint8_t *buffer)
-{
-    SDH_Write(SDH0, buffer, addr, size);
-}
-
@@ -12,6 +12,7 @@
 #include <string.h>
 #include "NuMicro.h"
 #include "massstorage.h"
+#include "msc_pipe.h"
 
 uint8_t volatile g_u8SdInitFlag = 0;
 extern int32_t g_TotalSectors;
@@ -36,6 +37,8 @@ void SDH0_IRQHandler(void)
         // block down
         SD0.DataReadyFlag = TRUE;
         SDH0->INTSTS = SDH_INTSTS_BLKDIF_Msk;
+        // go on with the queued slot transfers of msc_pipe.c
+        SDH_QueueHandler(SDH0);
     }
 
     if (isr & SDH_INTSTS_CDIF_Msk)
@@ -69,7 +72,7 @@ void SDH0_IRQHandler(void)
             else
             {
                 g_u8SdInitFlag = 1;
-                g_TotalSectors = SD0.totalSectorN;
+                g_TotalSectors = MSCP_GetSectors();
             }
         }
         SDH0->INTSTS = SDH_INTSTS_CDIF_Msk;
@@ -202,6 +205,12 @@ int32_t main (void)
     else
         g_u8SdInitFlag = 1;
 
+#if (MSC_RAMDISK_SECTORS > 0)
+    MSCP_Init(&g_sMscMediaRam);
+#else
+    MSCP_Init(&g_sMscMediaSD);
+#endif
+
     HSUSBD_Open(&gsHSInfo, MSC_ClassRequest, NULL);
 
     /* Endpoint configuration */
@@ -21,10 +21,11 @@
 /* Define sector size */
 #define USBD_SECTOR_SIZE    512
 
-// Define SD Card Maximum Transfer length 
-// The real buffer space is from g_u32StorageBase to (g_u32StorageBase + USBD_MAX_SD_SECTOR * 512) 
-#define USBD_MAX_SD_SECTOR  64      // unit is sector, 64 sectors = 32KB
-#define USBD_MAX_SD_LEN     32768   // unit is byte, MUST keep USBD_MAX_SD_LEN = USBD_MAX_SD_SECTOR * USBD_SECTOR_SIZE
+// READ/WRITE data is buffered in the slots of msc_pipe.c, see MSCP_SLOT_NUM and MSCP_SLOT_SECTORS.
+// Other data phases use the same memory through g_u32StorageBase.
+
+// Size of the RAM disk used instead of the SD card, unit is sector. 0: use the SD card
+#define MSC_RAMDISK_SECTORS 0
 
 /* Define EP maximum packet size */
 #define CEP_MAX_PKT_SIZE        64
@@ -74,6 +75,7 @@
 #define UFI_WRITE_10                            0x2A
 #define UFI_WRITE_12                            0xAA
 #define UFI_VERIFY_10                           0x2F
+#define UFI_SYNCHRONIZE_CACHE_10                0x35
 #define UFI_MODE_SELECT_10                      0x55
 #define UFI_MODE_SENSE_10                       0x5A
 
@@ -132,9 +134,6 @@ void MSC_BulkOut(uint32_t u32Addr, uint32_t u32Len);
 void MSC_BulkIn(uint32_t u32Addr, uint32_t u32Len);
 void MSC_AckCmd(void);
 
-void MSC_ReadMedia(uint32_t addr, uint32_t size, uint8_t *buffer);
-void MSC_WriteMedia(uint32_t addr, uint32_t size, uint8_t *buffer);
-
 #endif  /* __MASSSTORAGE_H_ */
 
 /*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
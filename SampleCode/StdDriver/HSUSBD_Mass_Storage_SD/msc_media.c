@@ -0,0 +1,136 @@
+/**************************************************************************//**
+ * @file     msc_media.c
+ * @version  V1.00
+ * @brief    Media backends of the mass storage pipeline.
+ *
+ *           g_sMscMediaSD queues the slots to the SDH0 request queue. The SDH
+ *           driver keeps the multiple block command open between contiguous
+ *           requests, so consecutive slots stream without new commands.
+ *           g_sMscMediaRam is a RAM disk with blocking transfers, it shows the
+ *           USB side alone and is how other blocking media plug in.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "massstorage.h"
+#include "msc_pipe.h"
+
+extern uint8_t volatile g_u8SdInitFlag;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  SD card on SDH0                                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+static SDH_REQ_T s_asSdReq[MSCP_SLOT_NUM];
+
+static void SD_ReqDone(SDH_REQ_T *psReq)
+{
+    MSCP_MediaDone((MSCP_SLOT_T *)psReq->pvUserData, psReq->i32Status);
+}
+
+static int32_t SD_Start(MSCP_SLOT_T *psSlot, uint32_t u32Dir)
+{
+    SDH_REQ_T *psReq = &s_asSdReq[psSlot->u32Index];
+
+    psReq->u32Dir = u32Dir;
+    psReq->pu8BufAddr = psSlot->pu8Buf;
+    psReq->u32StartSec = psSlot->u32Lba;
+    psReq->u32SecCount = psSlot->u32SecCnt;
+    psReq->pfnComplete = SD_ReqDone;
+    psReq->pvUserData = psSlot;
+    return SDH_SubmitRequest(SDH0, psReq);
+}
+
+static uint32_t SD_IsReady(void)
+{
+    return (g_u8SdInitFlag && SD0.IsCardInsert) ? 1 : 0;
+}
+
+static uint32_t SD_GetSectors(void)
+{
+    return SD0.totalSectorN;
+}
+
+static int32_t SD_Read(MSCP_SLOT_T *psSlot)
+{
+    return SD_Start(psSlot, SDH_REQ_READ);
+}
+
+static int32_t SD_Write(MSCP_SLOT_T *psSlot)
+{
+    return SD_Start(psSlot, SDH_REQ_WRITE);
+}
+
+static int32_t SD_Flush(void)
+{
+    return SDH_FlushQueue(SDH0);
+}
+
+static void SD_Poll(void)
+{
+    /* queued requests can't finish without the card, abort them */
+    if (!SDH_IS_CARD_PRESENT(SDH0))
+        SDH_FlushQueue(SDH0);
+}
+
+const MSCP_MEDIA_T g_sMscMediaSD =
+{
+    SD_IsReady,
+    SD_GetSectors,
+    SD_Read,
+    SD_Write,
+    SD_Flush,
+    SD_Poll
+};
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  RAM disk                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+#if (MSC_RAMDISK_SECTORS > 0)
+
+#ifdef __ICCARM__
+#pragma data_alignment=4
+static uint8_t s_au8RamDisk[MSC_RAMDISK_SECTORS * USBD_SECTOR_SIZE];
+#else
+static uint8_t s_au8RamDisk[MSC_RAMDISK_SECTORS * USBD_SECTOR_SIZE] __attribute__((aligned(4)));
+#endif
+
+static uint32_t Ram_IsReady(void)
+{
+    return 1;
+}
+
+static uint32_t Ram_GetSectors(void)
+{
+    return MSC_RAMDISK_SECTORS;
+}
+
+static int32_t Ram_Read(MSCP_SLOT_T *psSlot)
+{
+    memcpy(psSlot->pu8Buf, &s_au8RamDisk[psSlot->u32Lba * USBD_SECTOR_SIZE], psSlot->u32SecCnt * USBD_SECTOR_SIZE);
+    MSCP_MediaDone(psSlot, 0);
+    return 0;
+}
+
+static int32_t Ram_Write(MSCP_SLOT_T *psSlot)
+{
+    memcpy(&s_au8RamDisk[psSlot->u32Lba * USBD_SECTOR_SIZE], psSlot->pu8Buf, psSlot->u32SecCnt * USBD_SECTOR_SIZE);
+    MSCP_MediaDone(psSlot, 0);
+    return 0;
+}
+
+const MSCP_MEDIA_T g_sMscMediaRam =
+{
+    Ram_IsReady,
+    Ram_GetSectors,
+    Ram_Read,
+    Ram_Write,
+    NULL,
+    NULL
+};
+
+#endif  /* MSC_RAMDISK_SECTORS */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
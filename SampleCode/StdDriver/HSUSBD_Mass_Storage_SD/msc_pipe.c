@@ -0,0 +1,275 @@
+/**************************************************************************//**
+ * @file     msc_pipe.c
+ * @version  V1.00
+ * @brief    HSUSBD mass storage data phase pipeline.
+ *
+ *           A READ data phase queues media reads of up to MSCP_SLOT_NUM slots
+ *           ahead. Each slot goes out by bulk IN DMA as soon as it is read, and
+ *           is queued again for a later part of the transfer right after.
+ *           A WRITE data phase receives each slot by bulk OUT DMA and queues
+ *           its media write at once, so the next slot is received while the
+ *           media writes the previous ones. The CSW is only sent when all
+ *           writes of the command are done.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "massstorage.h"
+#include "msc_pipe.h"
+
+#ifdef __ICCARM__
+#pragma data_alignment=4
+static uint8_t s_au8SlotBuf[MSCP_SLOT_NUM][MSCP_SLOT_SIZE];
+#else
+static uint8_t s_au8SlotBuf[MSCP_SLOT_NUM][MSCP_SLOT_SIZE] __attribute__((aligned(4)));
+#endif
+
+static MSCP_SLOT_T s_asSlot[MSCP_SLOT_NUM];
+static const MSCP_MEDIA_T *s_psMedia;
+static volatile int32_t s_i32MediaErr;          /* first media error of the command */
+
+/**
+  * @brief      Initialize the pipeline.
+  * @param[in]  psMedia     Media backend
+  * @return     None
+  */
+void MSCP_Init(const MSCP_MEDIA_T *psMedia)
+{
+    uint32_t i;
+
+    memset(s_asSlot, 0, sizeof(s_asSlot));
+    for (i = 0; i < MSCP_SLOT_NUM; i++)
+    {
+        s_asSlot[i].u32Index = i;
+        s_asSlot[i].pu8Buf = s_au8SlotBuf[i];
+    }
+    s_psMedia = psMedia;
+}
+
+/**
+  * @brief      Check whether the media can be accessed.
+  * @return     Non-zero if the media is ready
+  */
+uint32_t MSCP_IsReady(void)
+{
+    return s_psMedia->pfnIsReady();
+}
+
+/**
+  * @brief      Get the media capacity.
+  * @return     Number of sectors
+  */
+uint32_t MSCP_GetSectors(void)
+{
+    return s_psMedia->pfnGetSectors();
+}
+
+/**
+  * @brief      Get the slot memory, MSCP_SLOT_NUM * MSCP_SLOT_SIZE bytes, for data phases of other commands.
+  * @return     Buffer address
+  * @note       It must not be used while a MSCP_Read or MSCP_Write is in progress.
+  */
+uint8_t *MSCP_GetBuffer(void)
+{
+    return s_au8SlotBuf[0];
+}
+
+/**
+  * @brief      Report the media transfer of a slot done. Called by the backend, also from interrupt.
+  * @param[in]  psSlot      The slot
+  * @param[in]  i32Status   0 on success, otherwise the transfer failed
+  * @return     None
+  */
+void MSCP_MediaDone(MSCP_SLOT_T *psSlot, int32_t i32Status)
+{
+    if ((i32Status != 0) && (s_i32MediaErr == MSCP_OK))
+        s_i32MediaErr = MSCP_ERR_MEDIA;
+    psSlot->u32Busy = 0;
+}
+
+/// @cond HIDDEN_SYMBOLS
+
+static void MSCP_WaitSlot(MSCP_SLOT_T *psSlot)
+{
+    while (psSlot->u32Busy)
+    {
+        if (s_psMedia->pfnPoll != NULL)
+            s_psMedia->pfnPoll();
+    }
+}
+
+static void MSCP_WaitAll(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < MSCP_SLOT_NUM; i++)
+        MSCP_WaitSlot(&s_asSlot[i]);
+}
+
+static void MSCP_StartSlot(MSCP_SLOT_T *psSlot, uint32_t u32Dir, uint32_t u32Lba, uint32_t u32SecCnt)
+{
+    int32_t i32Ret;
+
+    psSlot->u32Dir = u32Dir;
+    psSlot->u32Lba = u32Lba;
+    psSlot->u32SecCnt = u32SecCnt;
+    psSlot->u32Busy = 1;
+
+    if (u32Dir == MSCP_DIR_READ)
+        i32Ret = s_psMedia->pfnRead(psSlot);
+    else
+        i32Ret = s_psMedia->pfnWrite(psSlot);
+
+    if (i32Ret != 0)
+        MSCP_MediaDone(psSlot, i32Ret);     /* not started */
+}
+
+/* Clear the error of the last command and check the LBA range of this one. */
+static int32_t MSCP_Begin(uint32_t u32Lba, uint32_t u32Len)
+{
+    uint32_t u32SecCnt = (u32Len + USBD_SECTOR_SIZE - 1) / USBD_SECTOR_SIZE;
+
+    s_i32MediaErr = MSCP_OK;
+    if (!s_psMedia->pfnIsReady())
+        s_i32MediaErr = MSCP_ERR_NOT_READY;
+    else if ((u32Lba >= s_psMedia->pfnGetSectors()) || (u32SecCnt > s_psMedia->pfnGetSectors() - u32Lba))
+        s_i32MediaErr = MSCP_ERR_RANGE;
+    return s_i32MediaErr;
+}
+
+static uint32_t MSCP_IsUsbUp(void)
+{
+    return (g_hsusbd_Configured && HSUSBD_IS_ATTACHED()) ? 1 : 0;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief      Do the data phase of a READ command.
+  * @param[in]  u32Lba      Start sector
+  * @param[in]  u32Len      Bytes of the data phase, dCBWDataTransferLength
+  * @retval     MSCP_OK             Success
+  * @retval     MSCP_ERR_MEDIA      Media read failed
+  * @retval     MSCP_ERR_RANGE      The range is beyond the media
+  * @retval     MSCP_ERR_NOT_READY  No media
+  * @retval     MSCP_ERR_ABORT      The data phase is broken by USB
+  * @details    On error, the rest of the data phase is still sent, with undefined content,
+  *             so that the host gets the CSW where it expects it.
+  */
+int32_t MSCP_Read(uint32_t u32Lba, uint32_t u32Len)
+{
+    MSCP_SLOT_T *psSlot;
+    uint32_t u32SecCnt, u32Queued, u32Sent, u32Bytes, u32Head, n;
+
+    MSCP_Begin(u32Lba, u32Len);
+
+    u32SecCnt = (u32Len + USBD_SECTOR_SIZE - 1) / USBD_SECTOR_SIZE;
+    u32Queued = 0;
+
+    /* fill the pipeline */
+    for (u32Head = 0; (u32Head < MSCP_SLOT_NUM) && (u32Queued < u32SecCnt) && (s_i32MediaErr == MSCP_OK); u32Head++)
+    {
+        n = u32SecCnt - u32Queued;
+        if (n > MSCP_SLOT_SECTORS)
+            n = MSCP_SLOT_SECTORS;
+        MSCP_StartSlot(&s_asSlot[u32Head], MSCP_DIR_READ, u32Lba + u32Queued, n);
+        u32Queued += n;
+    }
+
+    u32Head = 0;
+
+    for (u32Sent = 0; u32Sent < u32Len; u32Sent += u32Bytes)
+    {
+        psSlot = &s_asSlot[u32Head];
+        u32Head = (u32Head + 1) % MSCP_SLOT_NUM;
+
+        u32Bytes = u32Len - u32Sent;
+        if (u32Bytes > MSCP_SLOT_SIZE)
+            u32Bytes = MSCP_SLOT_SIZE;
+
+        MSCP_WaitSlot(psSlot);
+        MSC_BulkIn((uint32_t)psSlot->pu8Buf, u32Bytes);
+        if (!MSCP_IsUsbUp())
+            break;
+
+        /* the slot is sent, read the part MSCP_SLOT_NUM slots later into it */
+        if ((s_i32MediaErr == MSCP_OK) && (u32Queued < u32SecCnt))
+        {
+            n = u32SecCnt - u32Queued;
+            if (n > MSCP_SLOT_SECTORS)
+                n = MSCP_SLOT_SECTORS;
+            MSCP_StartSlot(psSlot, MSCP_DIR_READ, u32Lba + u32Queued, n);
+            u32Queued += n;
+        }
+    }
+
+    MSCP_WaitAll();
+
+    if ((u32Sent < u32Len) && (s_i32MediaErr == MSCP_OK))
+        s_i32MediaErr = MSCP_ERR_ABORT;
+    return s_i32MediaErr;
+}
+
+/**
+  * @brief      Do the data phase of a WRITE command.
+  * @param[in]  u32Lba      Start sector
+  * @param[in]  u32Len      Bytes of the data phase, dCBWDataTransferLength
+  * @retval     MSCP_OK             Success, all data is written to the media
+  * @retval     MSCP_ERR_MEDIA      Media write failed
+  * @retval     MSCP_ERR_RANGE      The range is beyond the media
+  * @retval     MSCP_ERR_NOT_READY  No media
+  * @retval     MSCP_ERR_ABORT      The data phase is broken by USB
+  * @details    On error, the rest of the data phase is still received and dropped.
+  *             A trailing partial sector is not written.
+  */
+int32_t MSCP_Write(uint32_t u32Lba, uint32_t u32Len)
+{
+    MSCP_SLOT_T *psSlot;
+    uint32_t u32Recv, u32Bytes, u32Head;
+
+    MSCP_Begin(u32Lba, u32Len);
+
+    u32Head = 0;
+    for (u32Recv = 0; u32Recv < u32Len; u32Recv += u32Bytes)
+    {
+        psSlot = &s_asSlot[u32Head];
+        u32Head = (u32Head + 1) % MSCP_SLOT_NUM;
+
+        u32Bytes = u32Len - u32Recv;
+        if (u32Bytes > MSCP_SLOT_SIZE)
+            u32Bytes = MSCP_SLOT_SIZE;
+
+        /* the media write queued into this slot MSCP_SLOT_NUM slots ago must be done */
+        MSCP_WaitSlot(psSlot);
+        MSC_BulkOut((uint32_t)psSlot->pu8Buf, u32Bytes);
+        if (!MSCP_IsUsbUp())
+            break;
+
+        if ((s_i32MediaErr == MSCP_OK) && (u32Bytes >= USBD_SECTOR_SIZE))
+            MSCP_StartSlot(psSlot, MSCP_DIR_WRITE, u32Lba + u32Recv / USBD_SECTOR_SIZE, u32Bytes / USBD_SECTOR_SIZE);
+    }
+
+    MSCP_WaitAll();
+
+    if ((u32Recv < u32Len) && (s_i32MediaErr == MSCP_OK))
+        s_i32MediaErr = MSCP_ERR_ABORT;
+    return s_i32MediaErr;
+}
+
+/**
+  * @brief      Finish writes buffered by the media, e.g. for SYNCHRONIZE CACHE or eject.
+  * @retval     MSCP_OK             Success
+  * @retval     MSCP_ERR_MEDIA      Media failed
+  */
+int32_t MSCP_Flush(void)
+{
+    MSCP_WaitAll();
+    if ((s_psMedia->pfnFlush != NULL) && (s_psMedia->pfnFlush() != 0))
+        return MSCP_ERR_MEDIA;
+    return MSCP_OK;
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
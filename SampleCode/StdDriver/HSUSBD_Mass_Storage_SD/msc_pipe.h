@@ -0,0 +1,89 @@
+/**************************************************************************//**
+ * @file     msc_pipe.h
+ * @version  V1.00
+ * @brief    HSUSBD mass storage data phase pipeline header file.
+ *
+ *           READ/WRITE data phases are split into slots. Media transfers of
+ *           some slots run while the bulk DMA of another slot moves data on
+ *           the USB bus. The media is reached through a backend, see MSCP_MEDIA_T.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __MSC_PIPE_H__
+#define __MSC_PIPE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Pipeline settings                                                                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+#define MSCP_SLOT_NUM           4       /*!< Number of slots, 2 makes a ping-pong buffer              */
+#define MSCP_SLOT_SECTORS       16      /*!< Sectors of each slot                                     */
+#define MSCP_SLOT_SIZE          (MSCP_SLOT_SECTORS * USBD_SECTOR_SIZE)  /*!< Bytes of each slot       */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Error codes                                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+#define MSCP_OK                 0       /*!< No error                                                 */
+#define MSCP_ERR_MEDIA          (-1)    /*!< Media failed to transfer a slot                          */
+#define MSCP_ERR_RANGE          (-2)    /*!< LBA range is beyond the media                            */
+#define MSCP_ERR_NOT_READY      (-3)    /*!< Media is not present                                     */
+#define MSCP_ERR_ABORT          (-4)    /*!< USB bus reset or cable detached during the data phase    */
+
+#define MSCP_DIR_READ           0       /*!< Slot is read from media                                  */
+#define MSCP_DIR_WRITE          1       /*!< Slot is written to media                                 */
+
+/*! A slot of the pipeline. The backend gets it with a media transfer to do. */
+typedef struct mscp_slot_t
+{
+    uint32_t    u32Index;               /*!< Slot number, 0 ~ MSCP_SLOT_NUM - 1                       */
+    uint8_t     *pu8Buf;                /*!< Word aligned slot buffer                                 */
+    uint32_t    u32Dir;                 /*!< MSCP_DIR_READ or MSCP_DIR_WRITE                          */
+    uint32_t    u32Lba;                 /*!< Start sector of the transfer                             */
+    uint32_t    u32SecCnt;              /*!< Sectors to transfer                                      */
+    volatile uint32_t u32Busy;          /*!< 1 while the backend owns the slot                        */
+} MSCP_SLOT_T;
+
+/*!
+ *  Media backend. pfnRead and pfnWrite start the transfer of a slot and return. Once the transfer is
+ *  done, the backend calls MSCP_MediaDone(), which may be from an interrupt handler. A backend with a
+ *  blocking driver (SRAM, DataFlash, SPIM) simply does the transfer and calls MSCP_MediaDone() before
+ *  it returns; the USB side then waits for it, as without the pipeline.
+ */
+typedef struct mscp_media_t
+{
+    uint32_t (*pfnIsReady)(void);                       /*!< Non-zero if the media can be accessed    */
+    uint32_t (*pfnGetSectors)(void);                    /*!< Capacity in sectors                      */
+    int32_t  (*pfnRead)(MSCP_SLOT_T *psSlot);           /*!< Start reading a slot. 0: started         */
+    int32_t  (*pfnWrite)(MSCP_SLOT_T *psSlot);          /*!< Start writing a slot. 0: started         */
+    int32_t  (*pfnFlush)(void);                         /*!< Finish buffered writes. 0: success       */
+    void     (*pfnPoll)(void);                          /*!< Called while waiting for a slot, or NULL */
+} MSCP_MEDIA_T;
+
+void     MSCP_Init(const MSCP_MEDIA_T *psMedia);
+uint32_t MSCP_IsReady(void);
+uint32_t MSCP_GetSectors(void);
+uint8_t  *MSCP_GetBuffer(void);
+int32_t  MSCP_Read(uint32_t u32Lba, uint32_t u32Len);
+int32_t  MSCP_Write(uint32_t u32Lba, uint32_t u32Len);
+int32_t  MSCP_Flush(void);
+void     MSCP_MediaDone(MSCP_SLOT_T *psSlot, int32_t i32Status);
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Backends of this sample, msc_media.c                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+extern const MSCP_MEDIA_T g_sMscMediaSD;
+#if (MSC_RAMDISK_SECTORS > 0)
+extern const MSCP_MEDIA_T g_sMscMediaRam;
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __MSC_PIPE_H__ */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -8,9 +8,13 @@
 #include <stdio.h>
 #include <string.h>
 #include "NuMicro.h"
+#include "rndis.h"
+#include "rndis_bridge.h"
 
+#if (RNDIS_BRIDGE_MODE == 0)
 extern uint8_t rndis_indata[EMAC_RX_DESC_SIZE + 1][1580];
 extern uint32_t u32CurrentRxBuf;
+#endif
 
 
 /** @addtogroup Standard_Driver Standard Driver
@@ -126,6 +130,9 @@ static volatile EMAC_DESCRIPTOR_T tx_desc[EMAC_TX_DESC_SIZE];
 
 
 static uint32_t u32NextTxDesc, u32CurrentRxDesc;
+#if RNDIS_BRIDGE_MODE
+static uint32_t u32DoneTxDesc, u32TxBusy;  /* oldest Tx descriptor given to EMAC, and number of them */
+#endif
 
 
 static void EMAC_MdioWrite(uint32_t u32Reg, uint32_t u32Addr, uint32_t u32Data);
@@ -277,6 +284,10 @@ static void EMAC_TxDescInit(void)
     /* Get Frame descriptor's base address. */
     EMAC->TXDSA = (uint32_t)&tx_desc[0];
     u32NextTxDesc = (uint32_t)&tx_desc[0];
+#if RNDIS_BRIDGE_MODE
+    u32DoneTxDesc = (uint32_t)&tx_desc[0];
+    u32TxBusy = 0UL;
+#endif
 
     for(i = 0UL; i < EMAC_TX_DESC_SIZE; i++)
     {
@@ -305,7 +316,11 @@ static void EMAC_RxDescInit(void)
     for(i = 0UL; i < EMAC_RX_DESC_SIZE; i++)
     {
         rx_desc[i].u32Status1 = EMAC_DESC_OWN_EMAC;
+#if RNDIS_BRIDGE_MODE
+        rx_desc[i].u32Data = (uint32_t)RNDB_RxSlotAlloc();
+#else
         rx_desc[i].u32Data = (uint32_t)(&rndis_indata[i][44]);
+#endif
         rx_desc[i].u32Status2 = 0UL;
         rx_desc[i].u32Next = (uint32_t)&rx_desc[(i + 1UL) % EMAC_RX_DESC_SIZE];
     }
@@ -422,6 +437,7 @@ void EMAC_DisableCamEntry(uint32_t u32Entry)
 }
 
 
+#if (RNDIS_BRIDGE_MODE == 0)
 /**
   * @brief Receive an Ethernet packet
   * @param[in] pu8Data Pointer to a buffer to store received packet (4 byte CRC removed)
@@ -456,9 +472,50 @@ uint32_t My_EMAC_RecvPkt(void)
     }
     return u32Count;
 }
+#endif
 
 
 
+#if RNDIS_BRIDGE_MODE
+/**
+  * @brief Get the frame of the current Rx descriptor, without giving the descriptor back to EMAC
+  * @param[out] ppu8Data Buffer of the descriptor, holds the frame (4 byte CRC removed)
+  * @param[out] pu32Size Frame size
+  * @retval 0 No frame received
+  * @retval 1 A good frame
+  * @retval -1 A bad frame, the buffer still has to be given back by \ref My_EMAC_RecvRefill
+  */
+int32_t My_EMAC_RecvFrame(uint8_t **ppu8Data, uint32_t *pu32Size)
+{
+    EMAC_DESCRIPTOR_T *desc = (EMAC_DESCRIPTOR_T *)u32CurrentRxDesc;
+    uint32_t status = desc->u32Status1;
+
+    if ((status & EMAC_DESC_OWN_EMAC) == EMAC_DESC_OWN_EMAC)
+        return 0;
+
+    *ppu8Data = (uint8_t *)desc->u32Data;
+    *pu32Size = status & 0xFFFFUL;
+    if ((((status >> 16) & EMAC_RXFD_RXGD) == 0UL) || (*pu32Size == 0UL))
+        return -1;
+    return 1;
+}
+
+/**
+  * @brief Give the current Rx descriptor back to EMAC with a new buffer, and move to the next one
+  * @param[in] pu8Data Buffer to receive into, at least \ref RNDB_FRAME_MAX bytes
+  * @return None
+  */
+void My_EMAC_RecvRefill(uint8_t *pu8Data)
+{
+    EMAC_DESCRIPTOR_T *desc = (EMAC_DESCRIPTOR_T *)u32CurrentRxDesc;
+
+    desc->u32Data = (uint32_t)pu8Data;
+    desc->u32Status1 = EMAC_DESC_OWN_EMAC;
+    EMAC_TRIGGER_RX();
+    u32CurrentRxDesc = desc->u32Next;
+}
+#endif
+
 /**
   * @brief Send an Ethernet packet
   * @param[in] pu8Data Pointer to a buffer holds the packet to transmit
@@ -491,6 +548,9 @@ uint32_t My_EMAC_SendPkt(uint8_t *pu8Data, uint32_t u32Size)
 
         /* Get next Tx descriptor */
         u32NextTxDesc = (uint32_t)(desc->u32Next);
+#if RNDIS_BRIDGE_MODE
+        u32TxBusy++;
+#endif
 
         ret = 1UL;
         /* Trigger EMAC to send the packet */
@@ -500,6 +560,31 @@ uint32_t My_EMAC_SendPkt(uint8_t *pu8Data, uint32_t u32Size)
 }
 
 
+#if RNDIS_BRIDGE_MODE
+/**
+  * @brief Check whether the oldest packet given to \ref My_EMAC_SendPkt is sent
+  * @param None
+  * @retval 0 No packet is sent since the last call, or no packet is waiting
+  * @retval 1 The oldest packet is sent, its buffer can be reused
+  * @retval -1 The oldest packet failed, its buffer can be reused
+  * @note Packets finish in the order they are given, call it until it returns 0.
+  */
+int32_t My_EMAC_SendDone(void)
+{
+    EMAC_DESCRIPTOR_T *desc = (EMAC_DESCRIPTOR_T *)u32DoneTxDesc;
+    uint32_t status;
+
+    if ((u32TxBusy == 0UL) || (desc->u32Status1 & EMAC_DESC_OWN_EMAC))
+        return 0;
+
+    status = desc->u32Status2 >> 16UL;
+    u32TxBusy--;
+    u32DoneTxDesc = desc->u32Next;
+    return (status & EMAC_TXFD_TXCP) ? 1 : -1;
+}
+
+#endif
+
 /**
   * @brief  Check Ethernet link status
   * @param  None
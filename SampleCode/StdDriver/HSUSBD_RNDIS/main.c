@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include "M480.h"
 #include "rndis.h"
+#include "rndis_bridge.h"
 
 // Our MAC address
 uint8_t g_au8MacAddr[6] = {0x00, 0x00, 0x00, 0x59, 0x16, 0x88};
@@ -19,6 +20,7 @@ uint32_t u32TxCnt = 0, u32RxCnt = 0;
 // Descriptor pointers holds current Tx and Rx used by IRQ handler here.
 uint32_t u32CurrentTxDesc, u32CurrentRxDesc;
 
+#if (RNDIS_BRIDGE_MODE == 0)
 // allocate 5 buffers for tx and other 5 for rx.
 // 1 for usb, the other 4 for emac. 4 is the descriptor number allocated in this sample
 // these buffers are shared between usb and emac so no memory copy is required while
@@ -36,6 +38,7 @@ uint8_t rndis_indata[EMAC_RX_DESC_SIZE + 1][1580] __attribute__((aligned(32)));
 //for usb
 uint32_t u32CurrentTxBuf = 0;
 uint32_t u32CurrentRxBuf = 0;
+#endif
 
 
 void SYS_Init(void)
@@ -104,18 +107,38 @@ void SYS_Init(void)
 }
 
 extern uint32_t My_EMAC_RecvPkt(void);
+
+#if RNDIS_BRIDGE_MODE
+void ShowBridgeStat(void)
+{
+    RNDB_STAT_T sStat;
+
+    RNDB_GetStat(&sStat, 0);
+    printf("USB->EMAC: %u frames in %u transfers, %u dropped\n", sStat.u32TxFrames, sStat.u32TxXfers, sStat.u32TxDrops);
+    printf("EMAC->USB: %u frames in %u transfers, %u dropped\n", sStat.u32RxFrames, sStat.u32RxXfers, sStat.u32RxDrops);
+}
+#endif
+
 /*---------------------------------------------------------------------------------------------------------*/
 /*  Main Function                                                                                          */
 /*---------------------------------------------------------------------------------------------------------*/
 int32_t main (void)
 {
+#if (RNDIS_BRIDGE_MODE == 0)
     unsigned int i;
+#endif
 
     SYS_Init();
     UART_Open(UART0, 115200);
 
     printf("NuMicro HSUSBD RNDIS\n");
 
+#if RNDIS_BRIDGE_MODE
+    printf("Zero-copy bridge, press any key to show frame counters.\n");
+    /* Rx slots must be ready before EMAC_Open() gives them to the descriptors */
+    RNDB_Init();
+#endif
+
     // Select RMII interface by default
     EMAC_Open(g_au8MacAddr);
     EMAC_ENABLE_RX();
@@ -128,11 +151,13 @@ int32_t main (void)
     RNDIS_Init();
     NVIC_EnableIRQ(USBD20_IRQn);
 
+#if (RNDIS_BRIDGE_MODE == 0)
     for (i = 0; i < EMAC_RX_DESC_SIZE + 1; i++)
     {
         *(uint32_t *)&rndis_indata[i][0] = 0x00000001; /* message type */
         *(uint32_t *)&rndis_indata[i][8] = 0x24;       /* data offset */
     }
+#endif
 
 
     /* Start transaction */
@@ -145,6 +170,18 @@ int32_t main (void)
         }
     }
 
+#if RNDIS_BRIDGE_MODE
+    while(1)
+    {
+        RNDB_Poll();
+
+        if (!UART_GET_RX_EMPTY(UART0))
+        {
+            getchar();
+            ShowBridgeStat();
+        }
+    }
+#else
     while(1)
     {
         // Rx
@@ -159,6 +196,7 @@ int32_t main (void)
         // Tx
         RNDIS_ProcessOutData();
     }
+#endif
 }
 
 
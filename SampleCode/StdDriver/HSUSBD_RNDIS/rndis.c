@@ -7,12 +7,15 @@
 #include <string.h>
 #include "M480.h"
 #include "rndis.h"
+#include "rndis_bridge.h"
 
 
+#if (RNDIS_BRIDGE_MODE == 0)
 extern uint8_t rndis_outdata[EMAC_TX_DESC_SIZE + 1][1580];
 extern uint8_t rndis_indata[EMAC_RX_DESC_SIZE + 1][1580];
 extern uint32_t u32CurrentTxBuf;
 extern uint32_t u32CurrentRxBuf;
+#endif
 
 
 #ifdef __ICCARM__
@@ -111,6 +114,9 @@ void USBD20_IRQHandler(void)
             HSUSBD_ResetDMA();
             HSUSBD->EP[EPA].EPRSPCTL = HSUSBD_EPRSPCTL_FLUSH_Msk;
             HSUSBD->EP[EPB].EPRSPCTL = HSUSBD_EPRSPCTL_FLUSH_Msk;
+#if RNDIS_BRIDGE_MODE
+            RNDB_UsbReset();
+#endif
 
             if (HSUSBD->OPER & 0x04)  /* high speed */
                 RNDIS_InitForHighSpeed();
@@ -145,7 +151,9 @@ void USBD20_IRQHandler(void)
         {
             g_hsusbd_DmaDone = 1;
             HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_DMADONEIF_Msk);
-            HSUSBD->EP[EPA].EPRSPCTL = (HSUSBD->EP[EPA].EPRSPCTL & 0x10) | HSUSBD_EP_RSPCTL_SHORTTXEN;    // packet end
+            /* the bridge sends a transfer by several DMAs, only the last one ends it */
+            if (g_hsusbd_ShortPacket)
+                HSUSBD->EP[EPA].EPRSPCTL = (HSUSBD->EP[EPA].EPRSPCTL & 0x10) | HSUSBD_EP_RSPCTL_SHORTTXEN;    // packet end
         }
 
         if (IrqSt & HSUSBD_BUSINTSTS_PHYCLKVLDIF_Msk)
@@ -287,7 +295,8 @@ void USBD20_IRQHandler(void)
         HSUSBD_ENABLE_EP_INT(EPA, 0);
         HSUSBD_CLR_EP_INT_FLAG(EPA, IrqSt);
     }
-    /* bulk out */
+    /* bulk out, the bridge polls EPB and takes its packets by DMA instead */
+#if (RNDIS_BRIDGE_MODE == 0)
     if (IrqStL & HSUSBD_GINTSTS_EPBIF_Msk)
     {
         volatile int i, len;
@@ -300,6 +309,7 @@ void USBD20_IRQHandler(void)
         gRndisOutData = 1;
         HSUSBD_CLR_EP_INT_FLAG(EPB, IrqSt);
     }
+#endif
     /* interrupt in */
     if (IrqStL & HSUSBD_GINTSTS_EPCIF_Msk)
     {
@@ -376,7 +386,9 @@ void RNDIS_InitForHighSpeed(void)
     HSUSBD_SetEpBufAddr(EPB, EPB_BUF_BASE, EPB_BUF_LEN);
     HSUSBD_SET_MAX_PAYLOAD(EPB, EPB_MAX_PKT_SIZE);
     HSUSBD_ConfigEp(EPB, BULK_OUT_EP_NUM, HSUSBD_EP_CFG_TYPE_BULK, HSUSBD_EP_CFG_DIR_OUT);
+#if (RNDIS_BRIDGE_MODE == 0)
     HSUSBD_ENABLE_EP_INT(EPB, HSUSBD_EPINTEN_RXPKIEN_Msk | HSUSBD_EPINTEN_SHORTRXIEN_Msk);
+#endif
 
     /* EPC ==> Interrupt IN endpoint, address 3 */
     HSUSBD_SetEpBufAddr(EPC, EPC_BUF_BASE, EPC_BUF_LEN);
@@ -398,7 +410,9 @@ void RNDIS_InitForFullSpeed(void)
     HSUSBD_SetEpBufAddr(EPB, EPB_BUF_BASE, EPB_BUF_LEN);
     HSUSBD_SET_MAX_PAYLOAD(EPB, EPB_OTHER_MAX_PKT_SIZE);
     HSUSBD_ConfigEp(EPB, BULK_OUT_EP_NUM, HSUSBD_EP_CFG_TYPE_BULK, HSUSBD_EP_CFG_DIR_OUT);
+#if (RNDIS_BRIDGE_MODE == 0)
     HSUSBD_ENABLE_EP_INT(EPB, HSUSBD_EPINTEN_RXPKIEN_Msk | HSUSBD_EPINTEN_SHORTRXIEN_Msk);
+#endif
 
     /* EPC ==> Interrupt IN endpoint, address 3 */
     HSUSBD_SetEpBufAddr(EPC, EPC_BUF_BASE, EPC_BUF_LEN);
@@ -538,9 +552,16 @@ void RNDIS_ProcessClassCmd(void)
             *(ptr+5) = 0x00000000;      /* MinorVersion */
             *(ptr+6) = 0x00000001;      /* DeviceFlags */
             *(ptr+7) = 0x00000000;      /* Medium */
+#if RNDIS_BRIDGE_MODE
+            *(ptr+8) = RNDB_OUT_MAX_FRAMES;     /* max packets per transfer */
+            *(ptr+9) = RNDB_OUT_BUF_SIZE;       /* max transfer size */
+            *(ptr+10) = RNDB_ALIGN_FACTOR;      /* PacketAlignmentFactor */
+            RNDB_Start(*(pMsg + 5));            /* MaxTransferSize of the host */
+#else
             *(ptr+8) = 0x00000001;      /* max packets per transfer */
             *(ptr+9) = 0x0000062C;      /* max transfer size */
             *(ptr+10) = 0x00000000;     /* PacketAlignmentFactor */
+#endif
             *(ptr+11) = 0x00000000;     /* AFListOffset */
             *(ptr+12) = 0x00000000;     /* AFListSize */
             break;
@@ -578,6 +599,9 @@ void RNDIS_ProcessClassCmd(void)
             break;
 
         case REMOTE_NDIS_HALT_MSG:
+#if RNDIS_BRIDGE_MODE
+            RNDB_Stop();
+#endif
             break;
 
         default:
@@ -585,6 +609,7 @@ void RNDIS_ProcessClassCmd(void)
     }
 }
 
+#if (RNDIS_BRIDGE_MODE == 0)
 extern uint32_t My_EMAC_SendPkt(uint8_t *pu8Data, uint32_t u32Size);
 void RNDIS_ProcessOutData(void)
 {
@@ -663,6 +688,7 @@ void RNDIS_InData(unsigned int u32PktLen)
             return;
     }
 }
+#endif
 
 void RNDIS_IsAvaiable(void)
 {
@@ -691,6 +717,11 @@ void RNDIS_ProcessQueryOID(uint32_t oid)
 {
     int volatile i;
     uint32_t *ptr = (uint32_t *)rndis_response;
+#if RNDIS_BRIDGE_MODE
+    RNDB_STAT_T sStat;
+
+    RNDB_GetStat(&sStat, 0);
+#endif
 
     switch (oid)
     {
@@ -805,21 +836,33 @@ void RNDIS_ProcessQueryOID(uint32_t oid)
             *(ptr+1) = 24+4;    /* message len = 24 + info len */
             *(ptr+4) = 4;       /* InformationBufferLength */
             *(ptr+5) = 0x10;    /* InformationBufferOffset */
+#if RNDIS_BRIDGE_MODE
+            *(ptr+6) = sStat.u32TxFrames;
+#else
             *(ptr+6) = u32TxCnt;
+#endif
             break;
 
         case OID_GEN_RCV_OK:
             *(ptr+1) = 24+4;    /* message len = 24 + info len */
             *(ptr+4) = 4;       /* InformationBufferLength */
             *(ptr+5) = 0x10;    /* InformationBufferOffset */
+#if RNDIS_BRIDGE_MODE
+            *(ptr+6) = sStat.u32RxFrames;
+#else
             *(ptr+6) = u32RxCnt;
+#endif
             break;
 
         case OID_GEN_XMIT_ERROR:
             *(ptr+1) = 24+4;    /* message len = 24 + info len */
             *(ptr+4) = 4;       /* InformationBufferLength */
             *(ptr+5) = 0x10;    /* InformationBufferOffset */
+#if RNDIS_BRIDGE_MODE
+            *(ptr+6) = sStat.u32TxDrops;
+#else
             *(ptr+6) = 0x00000000;
+#endif
             break;
 
         case OID_GEN_RCV_ERROR:
@@ -833,7 +876,11 @@ void RNDIS_ProcessQueryOID(uint32_t oid)
             *(ptr+1) = 24+4;    /* message len = 24 + info len */
             *(ptr+4) = 4;       /* InformationBufferLength */
             *(ptr+5) = 0x10;    /* InformationBufferOffset */
+#if RNDIS_BRIDGE_MODE
+            *(ptr+6) = sStat.u32RxDrops;
+#else
             *(ptr+6) = 0x00000000;
+#endif
             break;
 
         case OID_802_3_PERMANENT_ADDRESS:
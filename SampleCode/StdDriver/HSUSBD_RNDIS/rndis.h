@@ -7,6 +7,9 @@
 #ifndef __RNDIS_H__
 #define __RNDIS_H__
 
+/* 1: zero-copy bridge with multi-packet transfers, see rndis_bridge.c. 0: one frame per transfer */
+#define RNDIS_BRIDGE_MODE   1
+
 /* Define the vendor id and product id */
 #define USBD_VID        0x0416
 #define USBD_PID        0xB055
@@ -0,0 +1,527 @@
+/**************************************************************************//**
+ * @file     rndis_bridge.c
+ * @version  V1.00
+ * @brief    Zero-copy RNDIS to EMAC bridge.
+ *
+ *           Ethernet to USB: each EMAC Rx descriptor points RNDB_HDR_SIZE bytes
+ *           into a slot. A received frame is queued with its slot and the
+ *           descriptor gets a free slot, so the EMAC keeps receiving while the
+ *           frame waits for USB. Up to RNDB_IN_MAX_FRAMES queued slots are sent
+ *           as one bulk IN transfer: the header of each is filled in front of
+ *           the frame and the DMA moves the slots one after another into the
+ *           endpoint buffer. Only the last DMA ends the transfer with a short
+ *           packet.
+ *
+ *           USB to Ethernet: bulk OUT transfers are received by DMA into one of
+ *           RNDB_OUT_BUF_NUM buffers. The frames of its REMOTE_NDIS_PACKET_MSGs
+ *           are given to EMAC Tx descriptors where they are. The buffer is
+ *           reused when the EMAC has sent all of them, the other buffers
+ *           receive the next transfers meanwhile.
+ *
+ *           All work is done by RNDB_Poll() from the main loop. The interrupt
+ *           handler only reports DMA done and bus reset.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "rndis.h"
+#include "rndis_bridge.h"
+
+#if RNDIS_BRIDGE_MODE
+
+extern int32_t  My_EMAC_RecvFrame(uint8_t **ppu8Data, uint32_t *pu32Size);
+extern void     My_EMAC_RecvRefill(uint8_t *pu8Data);
+extern uint32_t My_EMAC_SendPkt(uint8_t *pu8Data, uint32_t u32Size);
+extern int32_t  My_EMAC_SendDone(void);
+
+/// @cond HIDDEN_SYMBOLS
+
+#define RNDB_DMA_IDLE       0       /* DMA is free */
+#define RNDB_DMA_IN         1       /* DMA sends the slots of s_au8InSlot */
+#define RNDB_DMA_OUT        2       /* DMA receives a packet into s_asOut[s_u32OutFill] */
+
+#define RNDB_BUF_FREE       0       /* receiving, or ready to receive, a transfer */
+#define RNDB_BUF_SEND       1       /* transfer received, its frames are being given to EMAC */
+#define RNDB_BUF_WAIT       2       /* all frames given to EMAC, waiting for them to be sent */
+
+typedef struct
+{
+    uint32_t    u32State;           /* RNDB_BUF_xxx */
+    uint32_t    u32Len;             /* bytes received */
+    uint32_t    u32Parse;           /* offset of the next message to send */
+    uint32_t    u32Refs;            /* frames the EMAC has not sent yet */
+} RNDB_OUT_T;
+
+typedef struct
+{
+    uint8_t     au8Item[RNDB_RX_SLOT_NUM];
+    uint32_t    u32Head;
+    uint32_t    u32Count;
+} RNDB_RING_T;
+
+#ifdef __ICCARM__
+#pragma data_alignment=32
+static uint8_t s_au8RxSlot[RNDB_RX_SLOT_NUM][RNDB_SLOT_SIZE];
+#pragma data_alignment=32
+static uint8_t s_au8OutBuf[RNDB_OUT_BUF_NUM][RNDB_OUT_BUF_SIZE];
+#else
+static uint8_t s_au8RxSlot[RNDB_RX_SLOT_NUM][RNDB_SLOT_SIZE] __attribute__((aligned(32)));
+static uint8_t s_au8OutBuf[RNDB_OUT_BUF_NUM][RNDB_OUT_BUF_SIZE] __attribute__((aligned(32)));
+#endif
+
+static uint16_t     s_au16RxLen[RNDB_RX_SLOT_NUM];  /* frame length of each queued slot */
+static RNDB_RING_T  s_sRxFree;                      /* slots nobody uses */
+static RNDB_RING_T  s_sRxReady;                     /* slots holding a frame for the host */
+
+static uint8_t      s_au8InSlot[RNDB_IN_MAX_FRAMES];
+static uint32_t     s_u32InNum, s_u32InNext;        /* slots of the IN transfer, and the one being sent */
+static uint32_t     s_u32InDrain;                   /* last IN transfer may still be in the endpoint buffer */
+
+static RNDB_OUT_T   s_asOut[RNDB_OUT_BUF_NUM];
+static uint32_t     s_u32OutFill;                   /* buffer receiving */
+static uint32_t     s_u32OutSend;                   /* oldest buffer in RNDB_BUF_SEND */
+static uint32_t     s_u32OutDmaLen;
+static uint8_t      s_au8TxOwner[EMAC_TX_DESC_SIZE];/* buffer of each frame given to EMAC, in order */
+static uint32_t     s_u32TxHead, s_u32TxCount;
+
+static uint32_t     s_u32DmaState;
+static volatile uint32_t s_u32HostMaxXfer;          /* 0 while RNDIS is not initialized */
+static volatile uint32_t s_u32UsbReset;
+static RNDB_STAT_T  s_sStat;
+
+static void RNDB_RingPut(RNDB_RING_T *psRing, uint32_t u32Item)
+{
+    psRing->au8Item[(psRing->u32Head + psRing->u32Count) % RNDB_RX_SLOT_NUM] = (uint8_t)u32Item;
+    psRing->u32Count++;
+}
+
+static uint32_t RNDB_RingGet(RNDB_RING_T *psRing)
+{
+    uint32_t u32Item = psRing->au8Item[psRing->u32Head];
+
+    psRing->u32Head = (psRing->u32Head + 1) % RNDB_RX_SLOT_NUM;
+    psRing->u32Count--;
+    return u32Item;
+}
+
+static uint32_t RNDB_SlotOf(uint8_t *pu8Frame)
+{
+    return (uint32_t)(pu8Frame - RNDB_HDR_SIZE - s_au8RxSlot[0]) / RNDB_SLOT_SIZE;
+}
+
+static uint32_t RNDB_IsUsbUp(void)
+{
+    return (g_hsusbd_Configured && HSUSBD_IS_ATTACHED()) ? 1 : 0;
+}
+
+static void RNDB_DmaStart(uint32_t u32Ep, uint32_t u32IsIn, uint8_t *pu8Buf, uint32_t u32Len, uint32_t u32Short)
+{
+    if (u32IsIn)
+        HSUSBD_SET_DMA_READ(u32Ep);
+    else
+        HSUSBD_SET_DMA_WRITE(u32Ep);
+    HSUSBD_ENABLE_BUS_INT(HSUSBD_BUSINTEN_DMADONEIEN_Msk|HSUSBD_BUSINTEN_SUSPENDIEN_Msk|HSUSBD_BUSINTEN_RSTIEN_Msk|HSUSBD_BUSINTEN_VBUSDETIEN_Msk);
+    HSUSBD_SET_DMA_ADDR((uint32_t)pu8Buf);
+    HSUSBD_SET_DMA_LEN(u32Len);
+    g_hsusbd_DmaDone = 0;
+    g_hsusbd_ShortPacket = (uint8_t)u32Short;     /* USBD20_IRQHandler ends the IN transfer on DMA done */
+    HSUSBD_ENABLE_DMA();
+}
+
+/* Give up the DMA in progress, after bus reset or detach */
+static void RNDB_Abort(void)
+{
+    uint32_t i;
+
+    if (s_u32DmaState == RNDB_DMA_IN)
+    {
+        for (i = 0; i < s_u32InNum; i++)
+            RNDB_RingPut(&s_sRxFree, s_au8InSlot[i]);
+        s_sStat.u32RxDrops += s_u32InNum;
+        s_u32InNum = 0;
+    }
+    s_asOut[s_u32OutFill].u32Len = 0;
+    s_u32DmaState = RNDB_DMA_IDLE;
+    s_u32InDrain = 0;
+}
+
+/* Ethernet to USB: take received frames from the EMAC */
+static void RNDB_RxFromEmac(void)
+{
+    uint8_t *pu8Frame;
+    uint32_t u32Size, u32Slot, i;
+    int32_t i32Ret;
+
+    for (i = 0; i < EMAC_RX_DESC_SIZE; i++)
+    {
+        i32Ret = My_EMAC_RecvFrame(&pu8Frame, &u32Size);
+        if (i32Ret == 0)
+            break;
+
+        if ((i32Ret < 0) || (s_u32HostMaxXfer == 0) || (s_sRxFree.u32Count == 0))
+        {
+            /* bad frame, nobody to send it to, or all slots wait for USB: receive into the same slot again */
+            s_sStat.u32RxDrops++;
+            My_EMAC_RecvRefill(pu8Frame);
+            continue;
+        }
+
+        u32Slot = RNDB_SlotOf(pu8Frame);
+        s_au16RxLen[u32Slot] = (uint16_t)u32Size;
+        RNDB_RingPut(&s_sRxReady, u32Slot);
+        My_EMAC_RecvRefill(&s_au8RxSlot[RNDB_RingGet(&s_sRxFree)][RNDB_HDR_SIZE]);
+    }
+}
+
+/* Ethernet to USB: start an IN transfer of the queued frames */
+static void RNDB_InStart(void)
+{
+    uint32_t *pu32Hdr;
+    uint32_t u32Total, u32MsgLen, u32Slot, u32MaxPkt;
+
+    u32Total = 0;
+    pu32Hdr = NULL;
+    s_u32InNum = 0;
+    while ((s_sRxReady.u32Count > 0) && (s_u32InNum < RNDB_IN_MAX_FRAMES))
+    {
+        u32Slot = s_sRxReady.au8Item[s_sRxReady.u32Head];
+        u32MsgLen = (RNDB_HDR_SIZE + s_au16RxLen[u32Slot] + 3) & ~3UL;
+        if ((s_u32InNum > 0) && (u32Total + u32MsgLen + 4 > s_u32HostMaxXfer))
+            break;
+
+        RNDB_RingGet(&s_sRxReady);
+        pu32Hdr = (uint32_t *)s_au8RxSlot[u32Slot];
+        memset(pu32Hdr, 0, RNDB_HDR_SIZE);
+        pu32Hdr[0] = REMOTE_NDIS_PACKET_MSG;
+        pu32Hdr[1] = u32MsgLen;
+        pu32Hdr[2] = RNDB_HDR_SIZE - 8;         /* DataOffset, from the DataOffset field */
+        pu32Hdr[3] = s_au16RxLen[u32Slot];      /* DataLength */
+        s_au8InSlot[s_u32InNum++] = (uint8_t)u32Slot;
+        u32Total += u32MsgLen;
+    }
+
+    /* A transfer of whole packets would need a zero length packet. Pad the last message instead. */
+    u32MaxPkt = HSUSBD->EP[EPA].EPMPS & 0x7FF;
+    if ((u32MaxPkt != 0) && ((u32Total % u32MaxPkt) == 0))
+        pu32Hdr[1] += 4;
+
+    s_u32InNext = 0;
+    s_u32DmaState = RNDB_DMA_IN;
+    pu32Hdr = (uint32_t *)s_au8RxSlot[s_au8InSlot[0]];
+    RNDB_DmaStart(BULK_IN_EP_NUM, 1, (uint8_t *)pu32Hdr, pu32Hdr[1], (s_u32InNum == 1));
+}
+
+/* Ethernet to USB: a slot of the IN transfer is in the endpoint buffer */
+static void RNDB_InDone(void)
+{
+    uint32_t *pu32Hdr;
+    uint32_t i;
+
+    if (++s_u32InNext < s_u32InNum)
+    {
+        pu32Hdr = (uint32_t *)s_au8RxSlot[s_au8InSlot[s_u32InNext]];
+        RNDB_DmaStart(BULK_IN_EP_NUM, 1, (uint8_t *)pu32Hdr, pu32Hdr[1], (s_u32InNext == s_u32InNum - 1));
+        return;
+    }
+
+    for (i = 0; i < s_u32InNum; i++)
+        RNDB_RingPut(&s_sRxFree, s_au8InSlot[i]);
+    s_sStat.u32RxFrames += s_u32InNum;
+    s_sStat.u32RxXfers++;
+    s_u32InNum = 0;
+    s_u32InDrain = 1;
+    s_u32DmaState = RNDB_DMA_IDLE;
+}
+
+/* USB to Ethernet: the OUT transfer in s_asOut[s_u32OutFill] is complete */
+static void RNDB_OutEnd(void)
+{
+    RNDB_OUT_T *psOut = &s_asOut[s_u32OutFill];
+
+    psOut->u32Parse = 0;
+    psOut->u32State = RNDB_BUF_SEND;
+    s_sStat.u32TxXfers++;
+    s_u32OutFill = (s_u32OutFill + 1) % RNDB_OUT_BUF_NUM;
+}
+
+/* USB to Ethernet: receive the packet waiting in the bulk OUT endpoint */
+static void RNDB_OutStart(void)
+{
+    RNDB_OUT_T *psOut = &s_asOut[s_u32OutFill];
+    uint32_t u32Cnt;
+
+    if ((psOut->u32State != RNDB_BUF_FREE) || (psOut->u32Refs != 0))
+        return;
+
+    u32Cnt = HSUSBD->EP[EPB].EPDATCNT & 0xFFFF;
+    if (u32Cnt == 0)
+    {
+        /* a zero length packet ends a transfer of whole packets */
+        if (HSUSBD->EP[EPB].EPINTSTS & HSUSBD_EPINTSTS_SHORTRXIF_Msk)
+        {
+            HSUSBD_CLR_EP_INT_FLAG(EPB, HSUSBD_EPINTSTS_SHORTRXIF_Msk);
+            if (psOut->u32Len > 0)
+                RNDB_OutEnd();
+        }
+        return;
+    }
+
+    if (psOut->u32Len + u32Cnt > RNDB_OUT_BUF_SIZE)
+    {
+        /* the host sent more than RNDB_OUT_BUF_SIZE, send what we have */
+        RNDB_OutEnd();
+        return;
+    }
+
+    s_u32OutDmaLen = u32Cnt;
+    s_u32DmaState = RNDB_DMA_OUT;
+    RNDB_DmaStart(BULK_OUT_EP_NUM, 0, &s_au8OutBuf[s_u32OutFill][psOut->u32Len], u32Cnt, 0);
+}
+
+static void RNDB_OutDone(void)
+{
+    RNDB_OUT_T *psOut = &s_asOut[s_u32OutFill];
+
+    s_u32DmaState = RNDB_DMA_IDLE;
+    psOut->u32Len += s_u32OutDmaLen;
+    if (s_u32OutDmaLen < (HSUSBD->EP[EPB].EPMPS & 0x7FF))
+    {
+        HSUSBD_CLR_EP_INT_FLAG(EPB, HSUSBD_EPINTSTS_RXPKIF_Msk | HSUSBD_EPINTSTS_SHORTRXIF_Msk);
+        RNDB_OutEnd();
+        return;
+    }
+
+    /* a short packet flag seen now is of the zero length packet after this one, keep it */
+    HSUSBD_CLR_EP_INT_FLAG(EPB, HSUSBD_EPINTSTS_RXPKIF_Msk);
+    if (psOut->u32Len == RNDB_OUT_BUF_SIZE)
+        RNDB_OutEnd();
+}
+
+/* USB to Ethernet: give the frames of received transfers to the EMAC */
+static void RNDB_TxToEmac(void)
+{
+    RNDB_OUT_T *psOut;
+    uint8_t *pu8Msg, *pu8Frame;
+    uint32_t *pu32Hdr;
+    uint32_t u32MsgLen, u32DataOff, u32DataLen;
+    int32_t i32Ret;
+
+    /* reclaim sent frames first */
+    while ((s_u32TxCount > 0) && ((i32Ret = My_EMAC_SendDone()) != 0))
+    {
+        psOut = &s_asOut[s_au8TxOwner[s_u32TxHead]];
+        s_u32TxHead = (s_u32TxHead + 1) % EMAC_TX_DESC_SIZE;
+        s_u32TxCount--;
+        if (i32Ret > 0)
+            s_sStat.u32TxFrames++;
+        else
+            s_sStat.u32TxDrops++;
+        if ((--psOut->u32Refs == 0) && (psOut->u32State == RNDB_BUF_WAIT))
+            psOut->u32State = RNDB_BUF_FREE;
+    }
+
+    psOut = &s_asOut[s_u32OutSend];
+    while (psOut->u32State == RNDB_BUF_SEND)
+    {
+        if (psOut->u32Parse + RNDB_HDR_SIZE > psOut->u32Len)
+        {
+            /* done, bytes left are padding the host added to avoid a zero length packet */
+            psOut->u32Len = 0;
+            psOut->u32State = (psOut->u32Refs == 0) ? RNDB_BUF_FREE : RNDB_BUF_WAIT;
+            s_u32OutSend = (s_u32OutSend + 1) % RNDB_OUT_BUF_NUM;
+            psOut = &s_asOut[s_u32OutSend];
+            continue;
+        }
+
+        pu8Msg = &s_au8OutBuf[s_u32OutSend][psOut->u32Parse];
+        pu32Hdr = (uint32_t *)pu8Msg;
+        u32MsgLen = pu32Hdr[1];
+        u32DataOff = pu32Hdr[2] + 8;
+        u32DataLen = pu32Hdr[3];
+
+        if ((pu32Hdr[0] != REMOTE_NDIS_PACKET_MSG) || (u32MsgLen < RNDB_HDR_SIZE) ||
+                (u32MsgLen > psOut->u32Len - psOut->u32Parse) || (u32DataOff < RNDB_HDR_SIZE) ||
+                (u32DataOff > u32MsgLen) || (u32DataLen > u32MsgLen - u32DataOff) ||
+                (u32DataLen < 14) || (u32DataLen > RNDB_FRAME_MAX))
+        {
+            /* not a message we can send, the rest of the transfer can't be trusted either */
+            s_sStat.u32TxDrops++;
+            psOut->u32Parse = psOut->u32Len;
+            continue;
+        }
+
+        if (s_u32TxCount == EMAC_TX_DESC_SIZE)
+            break;                              /* all Tx descriptors are busy */
+
+        pu8Frame = (uint8_t *)((uint32_t)(pu8Msg + u32DataOff) & ~3UL);
+        if (pu8Frame != pu8Msg + u32DataOff)
+        {
+            /* EMAC DMA needs a word aligned frame, move it down over the reserved end of its header */
+            memmove(pu8Frame, pu8Msg + u32DataOff, u32DataLen);
+        }
+
+        if (My_EMAC_SendPkt(pu8Frame, u32DataLen) == 0)
+        {
+            /* EMAC is busy, put the frame back where the header says it is for the next pass */
+            if (pu8Frame != pu8Msg + u32DataOff)
+                memmove(pu8Msg + u32DataOff, pu8Frame, u32DataLen);
+            break;
+        }
+
+        s_au8TxOwner[(s_u32TxHead + s_u32TxCount) % EMAC_TX_DESC_SIZE] = (uint8_t)s_u32OutSend;
+        s_u32TxCount++;
+        psOut->u32Refs++;
+        psOut->u32Parse += u32MsgLen;
+    }
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief      Initialize the bridge. Call it before EMAC_Open(), which takes the first Rx slots.
+  * @return     None
+  */
+void RNDB_Init(void)
+{
+    uint32_t i;
+
+    memset(&s_sRxFree, 0, sizeof(s_sRxFree));
+    memset(&s_sRxReady, 0, sizeof(s_sRxReady));
+    for (i = 0; i < RNDB_RX_SLOT_NUM; i++)
+        RNDB_RingPut(&s_sRxFree, i);
+
+    memset(s_asOut, 0, sizeof(s_asOut));
+    s_u32OutFill = 0;
+    s_u32OutSend = 0;
+    s_u32TxHead = 0;
+    s_u32TxCount = 0;
+    s_u32InNum = 0;
+    s_u32InDrain = 0;
+    s_u32DmaState = RNDB_DMA_IDLE;
+    s_u32HostMaxXfer = 0;
+    s_u32UsbReset = 0;
+    memset(&s_sStat, 0, sizeof(s_sStat));
+}
+
+/**
+  * @brief      Take a free Rx slot for an EMAC Rx descriptor. Used by EMAC_Open().
+  * @return     Where the EMAC writes the frame, RNDB_HDR_SIZE bytes into the slot
+  */
+uint8_t *RNDB_RxSlotAlloc(void)
+{
+    return &s_au8RxSlot[RNDB_RingGet(&s_sRxFree)][RNDB_HDR_SIZE];
+}
+
+/**
+  * @brief      Start bridging, on REMOTE_NDIS_INITIALIZE_MSG.
+  * @param[in]  u32HostMaxXfer  MaxTransferSize of the host, the longest bulk IN transfer it takes
+  * @return     None
+  */
+void RNDB_Start(uint32_t u32HostMaxXfer)
+{
+    if (u32HostMaxXfer < RNDB_SLOT_SIZE)
+        u32HostMaxXfer = RNDB_SLOT_SIZE;       /* one frame per transfer at least */
+    s_u32HostMaxXfer = u32HostMaxXfer;
+}
+
+/**
+  * @brief      Stop sending received frames to the host, on REMOTE_NDIS_HALT_MSG.
+  * @return     None
+  */
+void RNDB_Stop(void)
+{
+    s_u32HostMaxXfer = 0;
+}
+
+/**
+  * @brief      Report a USB bus reset. Called by USBD20_IRQHandler after HSUSBD_ResetDMA().
+  * @return     None
+  */
+void RNDB_UsbReset(void)
+{
+    s_u32HostMaxXfer = 0;
+    s_u32UsbReset = 1;
+}
+
+/**
+  * @brief      Move frames in both directions. Call it from the main loop.
+  * @return     None
+  */
+void RNDB_Poll(void)
+{
+    if (s_u32UsbReset)
+    {
+        s_u32UsbReset = 0;
+        RNDB_Abort();
+    }
+
+    RNDB_RxFromEmac();
+    RNDB_TxToEmac();
+
+    if (s_u32DmaState != RNDB_DMA_IDLE)
+    {
+        if (!RNDB_IsUsbUp())
+        {
+            RNDB_Abort();
+            return;
+        }
+        if (!g_hsusbd_DmaDone)
+            return;
+
+        if (s_u32DmaState == RNDB_DMA_IN)
+            RNDB_InDone();
+        else
+            RNDB_OutDone();
+        if (s_u32DmaState != RNDB_DMA_IDLE)
+            return;                             /* next slot of the IN transfer started */
+    }
+
+    if ((s_u32HostMaxXfer == 0) || !RNDB_IsUsbUp())
+    {
+        /* nobody takes the queued frames */
+        while (s_sRxReady.u32Count > 0)
+        {
+            RNDB_RingPut(&s_sRxFree, RNDB_RingGet(&s_sRxReady));
+            s_sStat.u32RxDrops++;
+        }
+        return;
+    }
+
+    /* the DMA is free, bulk OUT goes first as it is a packet at most */
+    if ((HSUSBD->EP[EPB].EPDATCNT & 0xFFFF) || (HSUSBD->EP[EPB].EPINTSTS & HSUSBD_EPINTSTS_SHORTRXIF_Msk))
+    {
+        RNDB_OutStart();
+        if (s_u32DmaState != RNDB_DMA_IDLE)
+            return;
+    }
+
+    if (s_u32InDrain)
+    {
+        if (HSUSBD->EP[EPA].EPDATCNT & 0xFFFF)
+            return;                             /* short packet of the last IN transfer not taken yet */
+        s_u32InDrain = 0;
+    }
+
+    if (s_sRxReady.u32Count > 0)
+        RNDB_InStart();
+}
+
+/**
+  * @brief      Get the frame counters.
+  * @param[out] psStat      Counters
+  * @param[in]  u32Clear    Non-zero to clear the counters after reading
+  * @return     None
+  */
+void RNDB_GetStat(RNDB_STAT_T *psStat, uint32_t u32Clear)
+{
+    *psStat = s_sStat;
+    if (u32Clear)
+        memset(&s_sStat, 0, sizeof(s_sStat));
+}
+
+#endif  /* RNDIS_BRIDGE_MODE */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
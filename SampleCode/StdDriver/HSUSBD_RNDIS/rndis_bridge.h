@@ -0,0 +1,62 @@
+/**************************************************************************//**
+ * @file     rndis_bridge.h
+ * @version  V1.00
+ * @brief    Zero-copy RNDIS to EMAC bridge header file.
+ *
+ *           Frames are never copied between USB and EMAC. Received frames are
+ *           written by the EMAC into slots that already have room for the RNDIS
+ *           header, and the bulk IN DMA sends a batch of slots back to back as
+ *           one transfer. Bulk OUT transfers are received by DMA into transfer
+ *           buffers and each REMOTE_NDIS_PACKET_MSG in them is handed to an EMAC
+ *           Tx descriptor in place.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __RNDIS_BRIDGE_H__
+#define __RNDIS_BRIDGE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Bridge settings                                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+#define RNDB_HDR_SIZE           44      /*!< REMOTE_NDIS_PACKET_MSG header, data follows it           */
+#define RNDB_FRAME_MAX          1518    /*!< Longest frame the EMAC writes, EMAC->MRFL                */
+#define RNDB_SLOT_SIZE          1568    /*!< Header + frame + padding, multiple of 32                 */
+#define RNDB_RX_SLOT_NUM        (EMAC_RX_DESC_SIZE * 3)    /*!< Rx slots, EMAC_RX_DESC_SIZE are always
+                                                                 owned by the EMAC                   */
+#define RNDB_IN_MAX_FRAMES      8       /*!< Most frames sent in one bulk IN transfer                 */
+#define RNDB_OUT_BUF_NUM        3       /*!< Bulk OUT transfer buffers                                */
+#define RNDB_OUT_BUF_SIZE       12800   /*!< Bytes of each, reported as the RNDIS MaxTransferSize     */
+#define RNDB_OUT_MAX_FRAMES     8       /*!< Reported as the RNDIS MaxPacketsPerTransfer              */
+#define RNDB_ALIGN_FACTOR       2       /*!< Reported PacketAlignmentFactor, messages are 4 byte aligned */
+
+/*! Per direction frame counters. Tx is USB to Ethernet, Rx is Ethernet to USB. */
+typedef struct rndb_stat_t
+{
+    uint32_t    u32TxFrames;            /*!< Frames handed to the EMAC                                */
+    uint32_t    u32TxDrops;             /*!< Bad messages, EMAC Tx errors and bytes beyond the buffer */
+    uint32_t    u32TxXfers;             /*!< Bulk OUT transfers received                              */
+    uint32_t    u32RxFrames;            /*!< Frames sent to the host                                  */
+    uint32_t    u32RxDrops;             /*!< Bad frames and frames dropped for lack of a free slot    */
+    uint32_t    u32RxXfers;             /*!< Bulk IN transfers sent                                   */
+} RNDB_STAT_T;
+
+void     RNDB_Init(void);
+void     RNDB_Poll(void);
+void     RNDB_Start(uint32_t u32HostMaxXfer);
+void     RNDB_Stop(void);
+void     RNDB_UsbReset(void);
+uint8_t  *RNDB_RxSlotAlloc(void);
+void     RNDB_GetStat(RNDB_STAT_T *psStat, uint32_t u32Clear);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __RNDIS_BRIDGE_H__ */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -144,6 +144,10 @@ void SYS_Init(void)
     /* Select UART module clock source as HXT and UART module clock divider as 1 */
     CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HXT, CLK_CLKDIV0_UART0(1));
 
+    /* Enable CRC and PDMA module clock for image CRC check */
+    CLK_EnableModuleClock(CRC_MODULE);
+    CLK_EnableModuleClock(PDMA_MODULE);
+
     /* Enable USBH module clock */
     CLK_EnableModuleClock(USBH_MODULE);
 
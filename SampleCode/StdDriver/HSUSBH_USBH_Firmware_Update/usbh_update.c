@@ -20,12 +20,17 @@
 #define SPROM_FILE_NAME     "SP.BIN"        /* pre-defined SPROM firmware update image    */
 #define DATA_FILE_NAME      "DATA.BIN"      /* pre-defined Data Flash update image        */
 
+#define IMAGE_CRC_PDMA_CH   0               /* PDMA channel feeding image data to CRC     */
+#define IMAGE_CRC_ATTR      (CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM) /* CRC-32   */
+
 
 TCHAR   usbh_path[] = { '3', ':', 0 };      /* USB drive started from 3                   */
 
 uint8_t   _Buff[FMC_FLASH_PAGE_SIZE];
 FILINFO   Finfo;
 FIL       file1;
+CRC_CTX_T image_crc;                        /* CRC-32 of image pages read from file       */
+FMC_IMG_STAT_T image_stat;                  /* FMC_WriteImage counters of the image       */
 
 
 int  do_dir()
@@ -76,6 +81,50 @@ int  do_dir()
 }
 
 
+/*
+ *  Read a flash page size of data from file into _Buff and add it to image_crc.
+ *  A short last page is padded with 0xFF, so that _Buff matches the flash page after
+ *  programming and image_crc matches the FMC checksum command over whole pages.
+ */
+FRESULT read_image_page(UINT *cnt)
+{
+    FRESULT   res;
+
+    *cnt = FMC_FLASH_PAGE_SIZE;
+    res = f_read(&file1, _Buff, FMC_FLASH_PAGE_SIZE, cnt);
+    if ((res != FR_OK) || (*cnt == 0))
+        return res;
+
+    if (*cnt < FMC_FLASH_PAGE_SIZE)
+        memset(&_Buff[*cnt], 0xFF, FMC_FLASH_PAGE_SIZE - *cnt);
+
+    if (CRC_Update(&image_crc, _Buff, FMC_FLASH_PAGE_SIZE) != 0)
+        return FR_INT_ERR;                  /* PDMA time-out                              */
+    return FR_OK;
+}
+
+
+/*
+ *  Compare image_crc with the CRC-32 of flash pages calculated by FMC checksum command.
+ */
+int  verify_image_crc(uint32_t flash_addr, uint32_t size)
+{
+    uint32_t  chksum;
+
+    if (size == 0)
+        return 0;
+
+    printf("Pages %d, unchanged %d, erased %d, program bursts %d\n", image_stat.u32Pages,
+           image_stat.u32SamePages, image_stat.u32Erases, image_stat.u32ProgCalls);
+
+    chksum = FMC_GetChkSum(flash_addr, size);
+    printf("Image CRC-32 0x%08x, flash CRC-32 0x%08x\n", CRC_Final(&image_crc), chksum);
+    if ((g_FMC_i32ErrCode != 0) || (chksum != CRC_Final(&image_crc)))
+        return -1;
+    return 0;
+}
+
+
 int  program_flash_page(uint32_t page_addr, uint32_t *buff, int count)
 {
     uint32_t  addr;                         /* flash address                              */
@@ -83,10 +132,16 @@ int  program_flash_page(uint32_t page_addr, uint32_t *buff, int count)
 
     printf("Program page 0x%x, count=%d\n", page_addr, count);
 
-    if (page_addr == FMC_SPROM_BASE)        /* is going to erase SPROM?                   */
-        FMC_Erase_SPROM();                  /* Erase the SPROM page                       */
-    else
-        FMC_Erase(page_addr);               /* Erase an APROM page                        */
+    /*
+     *  APROM and Data Flash pages go through FMC_WriteImage. The page read from file is
+     *  padded with 0xFF, so the count is rounded up to words. A page that already holds
+     *  the data is skipped and a blank page is not erased. The image is verified by
+     *  CRC-32 after the whole image is programmed.
+     */
+    if (page_addr != FMC_SPROM_BASE)
+        return (FMC_WriteImage(page_addr, buff, (count + 3) & ~3, &image_stat) == 0) ? 0 : -1;
+
+    FMC_Erase_SPROM();                      /* Erase the SPROM page                       */
 
     for (addr = page_addr; addr < page_addr+count; addr += 4, p++)      /* loop page      */
     {
@@ -131,11 +186,12 @@ void usbh_firmware_update()
     {
         printf("APROM image [%s] found, start update APROM firmware...\n", APROM_FILE_NAME);
         FMC_ENABLE_AP_UPDATE();             /* enable APROM update                        */
+        CRC_Init(&image_crc, CRC_32, IMAGE_CRC_ATTR, 0xFFFFFFFF, IMAGE_CRC_PDMA_CH);
+        memset(&image_stat, 0, sizeof(image_stat));
 
         for (addr = 0; ; addr += FMC_FLASH_PAGE_SIZE)
         {
-            cnt = FMC_FLASH_PAGE_SIZE;      /* read a flash page size data from file      */
-            res = f_read(&file1, _Buff, cnt, &cnt);   /* read file                        */
+            res = read_image_page(&cnt);    /* read a flash page size data from file      */
             if ((res == FR_OK) && cnt)      /* read operation success?                    */
             {
                 /* update APROM firmware page                 */
@@ -149,7 +205,7 @@ void usbh_firmware_update()
                 break;                      /* read file failed or reached end-of-file    */
         }
 
-        if (f_eof(&file1))                  /* reach end-of-file?                         */
+        if (f_eof(&file1) && (verify_image_crc(0, addr) == 0))    /* end-of-file and CRC ok? */
             printf("APROM update success.\n");     /* firmware update success             */
         else
             printf("APROM update failed!\n");      /* firmware update failed              */
@@ -212,10 +268,11 @@ void usbh_firmware_update()
     else
     {
         /* Data image found, start updating...        */
+        CRC_Init(&image_crc, CRC_32, IMAGE_CRC_ATTR, 0xFFFFFFFF, IMAGE_CRC_PDMA_CH);
+        memset(&image_stat, 0, sizeof(image_stat));
         for (addr = dfba; ; addr += FMC_FLASH_PAGE_SIZE)   /* flash page loop             */
         {
-            cnt = FMC_FLASH_PAGE_SIZE;      /* will program a flash page                  */
-            res = f_read(&file1, _Buff, cnt, &cnt);   /* Read a page size from file       */
+            res = read_image_page(&cnt);    /* Read a page size from file                 */
             if ((res == FR_OK) && cnt)
             {
                 /* file read success, program to flash        */
@@ -230,7 +287,7 @@ void usbh_firmware_update()
                 break;
         }
 
-        if (f_eof(&file1))                  /* is end-of-file?                            */
+        if (f_eof(&file1) && (verify_image_crc(dfba, addr - dfba) == 0))  /* EOF and CRC ok? */
             printf("Data Flash update success.\n");   /* Data flash update success        */
         else
             printf("Data Flash update failed!\n");    /* Data Flash update failed         */
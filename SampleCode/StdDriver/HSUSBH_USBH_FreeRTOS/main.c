@@ -0,0 +1,299 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Run the USB Host library under FreeRTOS (USBH_USE_RTOS = 1). The USB
+ *           host task calls back transfers finished by the USB IRQ handlers and
+ *           enumerates devices. Each connected HID device is served by its own
+ *           worker task, which issues blocking class requests while interrupt-in
+ *           reports are passed to it through a queue.
+ *
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#include "usbh_lib.h"
+#include "usbh_hid.h"
+
+#define USBH_TASK_PRIORITY      (tskIDLE_PRIORITY + 3)
+#define HID_TASK_PRIORITY       (tskIDLE_PRIORITY + 2)
+#define USBH_TASK_STACK         512             /* in words                             */
+#define HID_TASK_STACK          384             /* in words                             */
+
+#define HID_WORKERS             2               /* HID devices served at the same time  */
+#define HID_REPORT_MAX          16              /* report bytes passed to the worker    */
+#define HID_REPORT_QUEUE        8
+#define HID_IDLE_MS             1000            /* a GET_IDLE request if no reports     */
+
+typedef struct
+{
+    uint16_t    len;
+    uint8_t     data[HID_REPORT_MAX];
+} HID_REPORT_T;
+
+typedef struct
+{
+    int             id;
+    HID_DEV_T       *hdev;                      /* device served, NULL if none          */
+    volatile int    removed;                    /* set by the disconnect callback       */
+    QueueHandle_t   report_q;
+    uint32_t        reports;
+    uint32_t        requests;
+} HID_WORKER_T;
+
+static HID_WORKER_T  s_worker[HID_WORKERS];
+static QueueHandle_t s_conn_q;                  /* HID devices waiting for a worker     */
+
+
+/*
+ *  Interrupt-in callback, runs in the USB host task. Passes the report to the worker.
+ */
+static void  int_read_callback(HID_DEV_T *hdev, uint16_t ep_addr, int status, uint8_t *rdata, uint32_t data_len)
+{
+    HID_REPORT_T  report;
+    int           i;
+
+    if (status < 0)
+        return;
+
+    for (i = 0; i < HID_WORKERS; i++)
+    {
+        if (s_worker[i].hdev == hdev)
+        {
+            report.len = (data_len > HID_REPORT_MAX) ? HID_REPORT_MAX : data_len;
+            memcpy(report.data, rdata, report.len);
+            xQueueSend(s_worker[i].report_q, &report, 0);      /* drop it if the worker lags */
+            return;
+        }
+    }
+}
+
+/*
+ *  Device connect callback, runs in the USB host task after the class drivers probed the device.
+ */
+static void  conn_callback(struct udev_t *udev, int param)
+{
+    HID_DEV_T   *hdev;
+
+    for (hdev = usbh_hid_get_device_list(); hdev != NULL; hdev = hdev->next)
+    {
+        if (((IFACE_T *)hdev->iface)->udev == udev)
+            xQueueSend(s_conn_q, &hdev, 0);
+    }
+}
+
+/*
+ *  Device disconnect callback, runs in the USB host task before the device is removed.
+ */
+static void  disconn_callback(struct udev_t *udev, int param)
+{
+    int   i;
+
+    for (i = 0; i < HID_WORKERS; i++)
+    {
+        if ((s_worker[i].hdev != NULL) && (((IFACE_T *)s_worker[i].hdev->iface)->udev == udev))
+            s_worker[i].removed = 1;
+    }
+}
+
+/*
+ *  Serve one HID device until it is removed. The class requests block this task only;
+ *  other workers and the USB host task keep running.
+ */
+static void  hid_serve(HID_WORKER_T *w)
+{
+    HID_DEV_T     *hdev = w->hdev;
+    HID_REPORT_T  report;
+    uint8_t       protocol, idle_rate;
+    int           ret;
+
+    printf("[HID%d] VID 0x%x, PID 0x%x\n", w->id, hdev->idVendor, hdev->idProduct);
+
+    ret = usbh_hid_get_protocol(hdev, &protocol);
+    printf("[HID%d] GET_PROTOCOL ret = %d, protocol = %d\n", w->id, ret, protocol);
+
+    /* use ping-pong buffer transfer */
+    if ((usbh_hid_start_int_read(hdev, 0, int_read_callback) != HID_RET_OK) ||
+            (usbh_hid_start_int_read(hdev, 0, int_read_callback) != HID_RET_OK))
+    {
+        printf("[HID%d] usbh_hid_start_int_read failed!\n", w->id);
+        return;
+    }
+
+    while (!w->removed)
+    {
+        if (xQueueReceive(w->report_q, &report, pdMS_TO_TICKS(HID_IDLE_MS)) == pdTRUE)
+        {
+            w->reports++;
+            continue;
+        }
+
+        ret = usbh_hid_get_idle(hdev, 0, &idle_rate);
+        w->requests++;
+        printf("[HID%d] %d reports, GET_IDLE ret = %d\n", w->id, w->reports, ret);
+        w->reports = 0;
+        if ((ret < 0) && (ret != USBH_ERR_STALL))
+            break;
+    }
+}
+
+static void  vHidTask(void *pvParameters)
+{
+    HID_WORKER_T  *w = (HID_WORKER_T *)pvParameters;
+    HID_DEV_T     *hdev;
+
+    for (;;)
+    {
+        xQueueReceive(s_conn_q, &hdev, portMAX_DELAY);
+
+        xQueueReset(w->report_q);
+        w->removed = 0;
+        w->reports = 0;
+        w->hdev = hdev;
+
+        hid_serve(w);
+
+        w->hdev = NULL;
+        printf("[HID%d] device removed\n", w->id);
+    }
+}
+
+static void  vStatTask(void *pvParameters)
+{
+    for (;;)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10000));
+        usbh_memory_used();
+        printf("FreeRTOS heap free: %d\n", (int)xPortGetFreeHeapSize());
+    }
+}
+
+void SYS_Init(void)
+{
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Set XT1_OUT(PF.2) and XT1_IN(PF.3) to input mode */
+    PF->MODE &= ~(GPIO_MODE_MODE2_Msk | GPIO_MODE_MODE3_Msk);
+
+    /* Enable HXT clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HXTEN_Msk);
+
+    /* Wait for HXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HXTSTB_Msk);
+
+    /* Switch HCLK clock source to HXT */
+    CLK_SetHCLK(CLK_CLKSEL0_HCLKSEL_HXT,CLK_CLKDIV0_HCLK(1));
+
+    /* Set core clock as PLL_CLOCK from PLL */
+    CLK_SetCoreClock(FREQ_192MHZ);
+
+    /* Set both PCLK0 and PCLK1 as HCLK/2 */
+    CLK->PCLKDIV = CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2;
+
+    /* Enable UART module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART module clock source as HXT and UART module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HXT, CLK_CLKDIV0_UART0(1));
+
+    /* Enable USBH module clock */
+    CLK_EnableModuleClock(USBH_MODULE);
+
+    /* USB Host desired input clock is 48 MHz. Set as PLL divided by 4 (192/4 = 48) */
+    CLK->CLKDIV0 = (CLK->CLKDIV0 & ~CLK_CLKDIV0_USBDIV_Msk) | CLK_CLKDIV0_USB(4);
+
+    /* Enable USBD and OTG clock */
+    CLK->APBCLK0 |= CLK_APBCLK0_USBDCKEN_Msk | CLK_APBCLK0_OTGCKEN_Msk;
+
+    /* Set OTG as USB Host role */
+    SYS->USBPHY = SYS_USBPHY_HSUSBEN_Msk | (0x1 << SYS_USBPHY_HSUSBROLE_Pos) | SYS_USBPHY_USBEN_Msk | SYS_USBPHY_SBO_Msk | (0x1 << SYS_USBPHY_USBROLE_Pos);
+    delay_us(20);
+    SYS->USBPHY |= SYS_USBPHY_HSUSBACT_Msk;
+
+    /* Update System Core Clock */
+    SystemCoreClockUpdate();
+
+    /* Set GPB multi-function pins for UART0 RXD and TXD */
+    SYS->GPB_MFPH &= ~(SYS_GPB_MFPH_PB12MFP_Msk | SYS_GPB_MFPH_PB13MFP_Msk);
+    SYS->GPB_MFPH |= (SYS_GPB_MFPH_PB12MFP_UART0_RXD | SYS_GPB_MFPH_PB13MFP_UART0_TXD);
+
+    /* USB_VBUS_EN (USB 1.1 VBUS power enable pin) multi-function pin - PB.15     */
+    SYS->GPB_MFPH = (SYS->GPB_MFPH & ~SYS_GPB_MFPH_PB15MFP_Msk) | SYS_GPB_MFPH_PB15MFP_USB_VBUS_EN;
+
+    /* USB_VBUS_ST (USB 1.1 over-current detect pin) multi-function pin - PC.14   */
+    SYS->GPC_MFPH = (SYS->GPC_MFPH & ~SYS_GPC_MFPH_PC14MFP_Msk) | SYS_GPC_MFPH_PC14MFP_USB_VBUS_ST;
+
+    /* HSUSB_VBUS_EN (USB 2.0 VBUS power enable pin) multi-function pin - PB.10   */
+    SYS->GPB_MFPH = (SYS->GPB_MFPH & ~SYS_GPB_MFPH_PB10MFP_Msk) | SYS_GPB_MFPH_PB10MFP_HSUSB_VBUS_EN;
+
+    /* HSUSB_VBUS_ST (USB 2.0 over-current detect pin) multi-function pin - PB.11 */
+    SYS->GPB_MFPH = (SYS->GPB_MFPH & ~SYS_GPB_MFPH_PB11MFP_Msk) | SYS_GPB_MFPH_PB11MFP_HSUSB_VBUS_ST;
+
+    /* USB 1.1 port multi-function pin VBUS, D+, D-, and ID pins */
+    SYS->GPA_MFPH &= ~(SYS_GPA_MFPH_PA12MFP_Msk | SYS_GPA_MFPH_PA13MFP_Msk |
+                       SYS_GPA_MFPH_PA14MFP_Msk | SYS_GPA_MFPH_PA15MFP_Msk);
+    SYS->GPA_MFPH |= SYS_GPA_MFPH_PA12MFP_USB_VBUS | SYS_GPA_MFPH_PA13MFP_USB_D_N |
+                     SYS_GPA_MFPH_PA14MFP_USB_D_P | SYS_GPA_MFPH_PA15MFP_USB_OTG_ID;
+
+    /* Lock protected registers */
+    SYS_LockReg();
+}
+
+void UART0_Init(void)
+{
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+
+int32_t main(void)
+{
+    int   i;
+
+    SYS_Init();                        /* Init System, IP clock and multi-function I/O */
+
+    UART0_Init();                      /* Initialize UART0 */
+
+    printf("\n\n");
+    printf("+-------------------------------------------+\n");
+    printf("|                                           |\n");
+    printf("|     USB Host under FreeRTOS sample demo   |\n");
+    printf("|                                           |\n");
+    printf("+-------------------------------------------+\n");
+
+    /* The USB IRQ handlers wake tasks, so they must not preempt the FreeRTOS critical sections */
+    NVIC_SetPriority(USBH_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+    NVIC_SetPriority(HSUSBH_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+
+    usbh_core_init();
+    usbh_hid_init();
+    usbh_install_conn_callback(conn_callback, disconn_callback);
+
+    s_conn_q = xQueueCreate(CONFIG_HID_MAX_DEV, sizeof(HID_DEV_T *));
+    for (i = 0; i < HID_WORKERS; i++)
+    {
+        s_worker[i].id = i;
+        s_worker[i].report_q = xQueueCreate(HID_REPORT_QUEUE, sizeof(HID_REPORT_T));
+        xTaskCreate(vHidTask, "HID", HID_TASK_STACK, &s_worker[i], HID_TASK_PRIORITY, NULL);
+    }
+    xTaskCreate(usbh_task, "USBH", USBH_TASK_STACK, NULL, USBH_TASK_PRIORITY, NULL);
+    xTaskCreate(vStatTask, "Stat", configMINIMAL_STACK_SIZE * 2, NULL, tskIDLE_PRIORITY + 1, NULL);
+
+    /* Start the scheduler. */
+    vTaskStartScheduler();
+
+    /* Only reached if there was not enough FreeRTOS heap to create the idle task */
+    printf("FreeRTOS heap too small!\n");
+    while (1);
+}
+
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,106 @@
+/**************************************************************************//**
+ * @file     usbh_os.c
+ * @version  V1.00
+ * @brief    FreeRTOS port of the USB Host library (USBH_USE_RTOS = 1).
+ *
+ *           The USB Host library lock is a recursive mutex. A task waiting for
+ *           the USB stack blocks on its task notification, which the USB IRQ
+ *           handlers and the USB host task give. get_ticks() and delay_us() of
+ *           the library are also based on the FreeRTOS tick.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "NuMicro.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "usbh_lib.h"
+
+
+static SemaphoreHandle_t  s_usbh_mutex;
+
+
+void usbh_os_init(void)
+{
+    if (s_usbh_mutex == NULL)
+        s_usbh_mutex = xSemaphoreCreateRecursiveMutex();
+    configASSERT(s_usbh_mutex);
+}
+
+void usbh_os_lock(void)
+{
+    /* USB stack calls made before the scheduler starts need no lock */
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+        xSemaphoreTakeRecursive(s_usbh_mutex, portMAX_DELAY);
+}
+
+void usbh_os_unlock(void)
+{
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+        xSemaphoreGiveRecursive(s_usbh_mutex);
+}
+
+void *usbh_os_task_self(void)
+{
+    return (void *)xTaskGetCurrentTaskHandle();
+}
+
+void usbh_os_task_wait(uint32_t ms)
+{
+    TickType_t  ticks = pdMS_TO_TICKS(ms);
+
+    if (ticks == 0)
+        ticks = 1;
+    /* A notification given before this call is not lost, it makes the call return at once */
+    ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+void usbh_os_task_wake(void *task)
+{
+    xTaskNotifyGive((TaskHandle_t)task);
+}
+
+void usbh_os_task_wake_from_isr(void *task)
+{
+    BaseType_t  xHigherPriorityTaskWoken = pdFALSE;
+
+    vTaskNotifyGiveFromISR((TaskHandle_t)task, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/*
+ *  USB Host library time base, one tick per 10 ms.
+ */
+uint32_t get_ticks(void)
+{
+    return (uint32_t)(xTaskGetTickCount() / pdMS_TO_TICKS(10));
+}
+
+/*
+ *  Delays of 1 ms or longer block the calling task once the scheduler runs. Shorter
+ *  ones, and those before the scheduler starts, busy wait on Timer0.
+ */
+void delay_us(int usec)
+{
+    if ((usec >= 1000) && (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING))
+    {
+        vTaskDelay(pdMS_TO_TICKS((usec + 999) / 1000));
+        return;
+    }
+
+    /* TIMER0 clock from HXT, prescale 12 */
+    CLK->CLKSEL1 = (CLK->CLKSEL1 & (~CLK_CLKSEL1_TMR0SEL_Msk)) | CLK_CLKSEL1_TMR0SEL_HXT;
+    CLK->APBCLK0 |= CLK_APBCLK0_TMR0CKEN_Msk;
+    TIMER0->CTL = 0;        /* disable timer */
+    TIMER0->INTSTS = (TIMER_INTSTS_TIF_Msk | TIMER_INTSTS_TWKF_Msk);   /* write 1 to clear for safety */
+    TIMER0->CMP = usec;
+    TIMER0->CTL = (11 << TIMER_CTL_PSC_Pos) | TIMER_ONESHOT_MODE | TIMER_CTL_CNTEN_Msk;
+
+    while (!TIMER0->INTSTS);
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
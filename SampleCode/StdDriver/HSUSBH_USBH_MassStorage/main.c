@@ -396,6 +396,65 @@ void iso_xfer_read(uint8_t *data_buff, int data_len)
     iso_in_cnt++;
 }
 
+
+/*--------------------------------------------------------------------------*/
+/* Bulk-only transport throughput test                                      */
+
+#define BENCH_BUFF_SIZE     (32*1024)
+
+#ifdef __ICCARM__
+#pragma data_alignment=32
+uint8_t  Bench_Buff[BENCH_BUFF_SIZE];
+#else
+uint8_t  Bench_Buff[BENCH_BUFF_SIZE] __attribute__((aligned(32)));
+#endif
+
+/*
+ *  Read or write 'kbytes' KB of USB disk 'drv_no' from sector 'lba' once with each
+ *  transfer size from 4 KB up to BENCH_BUFF_SIZE, and print the throughput of each.
+ *  The write test overwrites the disk content!
+ */
+void umas_bench(int drv_no, uint32_t lba, uint32_t kbytes, int is_write)
+{
+    UMAS_STAT_T  stat;
+    uint32_t     xfer, done, t, rate;
+    int          ret = 0;
+
+    for (xfer = 4*1024; xfer <= BENCH_BUFF_SIZE; xfer *= 2)
+    {
+        usbh_umas_get_stat(drv_no, NULL, 1);
+        t = get_ticks();
+        for (done = 0; done < kbytes * 1024; done += xfer)
+        {
+            if (is_write)
+                ret = usbh_umas_write(drv_no, lba + done / 512, xfer / 512, Bench_Buff);
+            else
+                ret = usbh_umas_read(drv_no, lba + done / 512, xfer / 512, Bench_Buff);
+            if (ret != 0)
+                break;
+        }
+        t = get_ticks() - t;
+        if (ret != 0)
+        {
+            printf("%s failed at sector %d, ret=%d\n", is_write ? "Write" : "Read", lba + done / 512, ret);
+            return;
+        }
+        if (t == 0)
+            t = 1;
+
+        /* MB/s x 100, get_ticks() runs at 100 Hz */
+        rate = (done / 1024) * 10000 / 1024 / t;
+
+        usbh_umas_get_stat(drv_no, &stat, 0);
+        if (is_write)
+            printf("write %2d KB x %5d: %3d.%02d MB/s, longest %d ms\n", xfer / 1024, done / xfer,
+                   rate / 100, rate % 100, stat.wr_ticks_max * 10);
+        else
+            printf("read  %2d KB x %5d: %3d.%02d MB/s, longest %d ms, readahead hit %d\n", xfer / 1024, done / xfer,
+                   rate / 100, rate % 100, stat.rd_ticks_max * 10, stat.ra_hit);
+    }
+}
+
 void SYS_Init(void)
 {
     /* Unlock protected registers */
@@ -638,6 +697,20 @@ int32_t main(void)
                 printf("Raw write speed: %d KB/s\n", ((0x800000 * 100) / p1)/1024);
                 break;
 
+            case 'b' :  /* db <lba> [<KB>] [w] - bulk-only read (or write) throughput test */
+                if (!xatoi(&ptr, &p1))
+                {
+                    printf("db <lba> [<KB>] [w]\n");
+                    break;
+                }
+                if (!xatoi(&ptr, &p2) || (p2 <= 0))
+                    p2 = 8192;
+                while (*ptr == ' ') ptr++;
+                if (*ptr == 'w')
+                    printf("Writing %d KB from sector %d, the disk content is lost!\n", p2, p1);
+                umas_bench(3, p1, p2, (*ptr == 'w'));
+                break;
+
             case 'z' :  /* dz - file read/write performance test */
 #if 0
                 printf("File write performance test...\n");
@@ -1107,6 +1180,7 @@ int32_t main(void)
             printf(
                 _T("n: - Change default drive (USB drive is 3~7)\n")
                 _T("dd [<lba>] - Dump sector\n")
+                _T("db <lba> [<KB>] [w] - Bulk-only read (or write) throughput\n")
                 //_T("ds <pd#> - Show disk status\n")
                 _T("\n")
                 _T("bd <ofs> - Dump working buffer\n")
@@ -16,12 +16,14 @@
 #include "usbh_lib.h"
 #include "ff.h"
 #include "diskio.h"
+#include "spim_writer.h"
 
 
 #define BUFF_SIZE                 2048      /* Working buffer size                        */
 #define SPIM_FLASH_MAX_SIZE       0x8000000 /* Assumed maximum flash size 128 MB          */
 #define SPIM_FLASH_PAGE_SIZE      0x10000   /* SPIM flash page size, depend on flash      */
 #define IS_4BYTES_ADDR            0         /* W25Q20 does not support 4-bytes address mode. */
+#define CRC_PDMA_CH               0         /* PDMA channel feeding the CRC engine        */
 
 typedef void (FUNC_PTR)(void);
 
@@ -41,6 +43,7 @@ char      Line[128];                        /* Console input buffer
 
 FILINFO   Finfo;
 FIL       file;
+SPIW_T    writer;                           /* Double-buffered SPIM flash writer          */
 
 
 volatile uint32_t  g_tick_cnt;              /* SYSTICK timer counter                      */
@@ -143,6 +146,10 @@ void SYS_Init(void)
     /* Enable SPIM module clock */
     CLK_EnableModuleClock(SPIM_MODULE);
 
+    /* Enable CRC and PDMA module clock for image verification */
+    CLK_EnableModuleClock(CRC_MODULE);
+    CLK_EnableModuleClock(PDMA_MODULE);
+
     /* Update System Core Clock */
     SystemCoreClockUpdate();
 
@@ -381,6 +388,44 @@ int  show_root_dir()
     return 0;
 }
 
+/*
+ *  SPIM flash port of the writer. Erase and page program are started without waiting.
+ */
+static void spiw_erase(uint32_t u32Addr, uint32_t u32Size)
+{
+    SPIM_EraseBlock(u32Addr, IS_4BYTES_ADDR, (u32Size == SPIW_BLOCK_SIZE) ? OPCODE_BE_64K : OPCODE_SE_4K, 1, 0);
+}
+
+static void spiw_program(uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    SPIM_DMA_WritePage(u32Addr, IS_4BYTES_ADDR, u32Len, pu8Buf, CMD_NORMAL_PAGE_PROGRAM, 0);
+}
+
+static int spiw_is_busy(void)
+{
+    return !SPIM_IsWriteDone(1);
+}
+
+static void spiw_read(uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    SPIM_DMA_Read(u32Addr, IS_4BYTES_ADDR, u32Len, pu8Buf, CMD_DMA_FAST_READ, 1);
+}
+
+static const SPIW_FLASH_T spiw_port = { spiw_erase, spiw_program, spiw_is_busy, spiw_read };
+
+/*
+ *  Writer fill callback, reads the next part of the opened file.
+ */
+static int spiw_fill(void *pvArg, uint8_t *pu8Buf, uint32_t u32Size, uint32_t *pu32Len)
+{
+    UINT        len;
+    FRESULT     res;
+
+    res = f_read((FIL *)pvArg, pu8Buf, u32Size, &len);
+    *pu32Len = len;
+    return (res != FR_OK) ? -1 : 0;
+}
+
 /*
  *  w <file> <addr>
  */
@@ -388,9 +433,11 @@ int  write_file_to_flash(char *cmdline)
 {
     char        *ptr = cmdline;             /* command string pointer                     */
     char        fname[64];                  /* file name string pointer                   */
-    uint32_t    faddr, page_addr, addr;     /* flash address                              */
+    uint32_t    faddr;                      /* flash address                              */
+    uint32_t    fsize, ticks;               /* file size and elapsed ticks                */
     UINT        len;                        /* data length                                */
     FRESULT     res;                        /* FATFS operation return code                */
+    int         ret;                        /* writer return code                         */
 
     while (*ptr == ' ') ptr++;              /* skip space characters                      */
 
@@ -417,75 +464,45 @@ int  write_file_to_flash(char *cmdline)
         return -1;                          /* Abort...                                   */
     }
 
+    fsize = f_size(&file);
+    if ((faddr >= SPIM_FLASH_MAX_SIZE) || (fsize > SPIM_FLASH_MAX_SIZE - faddr))
+    {
+        printf("File too large!\n");
+        f_close(&file);                     /* close file                                 */
+        return -1;
+    }
+
     SPIM_ReadJedecId(idBuf, sizeof (idBuf), 1);
     printf("Flash ID=0x%02X, 0x%02X, 0x%02X\n", idBuf[0], idBuf[1], idBuf[2]);
 
     SPIM_Enable_4Bytes_Mode(IS_4BYTES_ADDR, 1);  /* Enable 4-bytes address mode?          */
 
     /*
-     *  Erase SPIM flash page and program...
+     *  Erase ahead, program one buffer while the other is read from USB disk,
+     *  and verify the CRC-32 of the flash contents.
      */
-    for (page_addr = faddr; page_addr < SPIM_FLASH_MAX_SIZE; page_addr += SPIM_FLASH_PAGE_SIZE)
+    printf("Erase, program and verify %d bytes...\n", fsize);
+    SPIW_Init(&writer, &spiw_port, Buff1, Buff2, CRC_PDMA_CH);
+    ticks = get_ticks();
+    ret = SPIW_Write(&writer, faddr, fsize, spiw_fill, &file);
+    ticks = get_ticks() - ticks;
+    f_close(&file);                         /* close file                                 */
+
+    if (ret != SPIW_OK)
     {
-        if (f_eof(&file))
-        {
-            printf("OK [%d]\n", res);
-            f_close(&file);             /* close file                                 */
-            return 0;                   /* done                                       */
-        }
-
-        /* Erase SPIM flash */
-        printf("Erase flash page 0x%x...\n", page_addr);
-        SPIM_EraseBlock(page_addr, IS_4BYTES_ADDR, OPCODE_BE_64K, 1, 1);
-
-        memset(Buff2, 0xff, BUFF_SIZE);     /* prepared compare buffer                    */
-
-        /* Verify erased page */
-        printf("Verify erased page...");
-        for (addr = page_addr; addr < page_addr+SPIM_FLASH_PAGE_SIZE; addr += BUFF_SIZE)
-        {
-            memset(Buff1, 0x11, BUFF_SIZE); /* fill buffer with non-0xFF                  */
-
-            /* DMA read SPIM flash                                                        */
-            SPIM_DMA_Read(addr, IS_4BYTES_ADDR, BUFF_SIZE, Buff1, CMD_DMA_FAST_READ, 1);
-
-            if (memcmp(Buff1, Buff2, BUFF_SIZE) != 0)
-            {
-                printf("Verify address 0x%x failed!\n", addr);
-                f_close(&file);             /* close file                                 */
-                return -1;                  /* non-0xFF data found, erase failed          */
-            }
-        }
-        printf("OK.\n");
-
-        printf("Program page and verify...");
-        for (addr = page_addr; addr < page_addr+SPIM_FLASH_PAGE_SIZE; addr += BUFF_SIZE)
-        {
-            res = f_read(&file, Buff1, BUFF_SIZE, &len);
-
-            if (res || (len == 0))
-            {
-                printf("OK [%d]\n", res);
-                f_close(&file);             /* close file                                 */
-                return 0;                   /* done                                       */
-            }
-            /* DMA write SPIM flash                       */
-            SPIM_DMA_Write(addr, IS_4BYTES_ADDR, BUFF_SIZE, Buff1, CMD_NORMAL_PAGE_PROGRAM);
-
-            memset(Buff2, 0, BUFF_SIZE);
-            /* DMA read SPIM flash                        */
-            SPIM_DMA_Read(addr, IS_4BYTES_ADDR, BUFF_SIZE, Buff2, CMD_DMA_FAST_READ, 1);
-
-            if (memcmp(Buff1, Buff2, BUFF_SIZE) != 0)
-            {
-                printf("Failed at address 0x%x!\n", addr);
-                f_close(&file);             /* close file                                 */
-                return -1;
-            }
-            printf(".");
-        }
-        printf("OK\n");
+        printf("Failed [%d], %d bytes programmed!\n", ret, writer.sStat.u32Bytes);
+        return -1;
     }
+
+    if (ticks == 0)
+        ticks = 1;
+    printf("OK, CRC32 0x%08x. %d.%02d seconds, %d KB/s\n", writer.sStat.u32Crc,
+           ticks / 100, ticks % 100, (fsize / 1024) * 100 / ticks);
+    printf("%d pages, %d sectors and %d blocks erased\n",
+           writer.sStat.u32Pages, writer.sStat.u32Sectors, writer.sStat.u32Blocks);
+    printf("Status polls %d (busy %d), flash idle %d, buffers full %d\n",
+           writer.sStat.u32Polls, writer.sStat.u32BusyPolls,
+           writer.sStat.u32IdlePolls, writer.sStat.u32FullPolls);
     return 0;
 }
 
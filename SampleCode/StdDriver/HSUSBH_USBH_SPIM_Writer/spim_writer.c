@@ -0,0 +1,258 @@
+/**************************************************************************//**
+ * @file     spim_writer.c
+ * @version  V1.00
+ * @brief    Double-buffered SPI NOR flash writer with overlapped erase/program.
+ *
+ *           The image is read into one buffer while the pages of the other are
+ *           programmed. Erase and program are only started, and the flash
+ *           status is polled between fill calls, so the flash works while the
+ *           data source is read. When no page is ready the flash erases ahead,
+ *           by 4 KB sector up to the first 64 KB boundary and by 64 KB block
+ *           from there, unless the rest of the image needs only a few
+ *           sectors. The image CRC-32 is accumulated by the CRC engine as it
+ *           is read, and compared with the CRC of the flash read back at the
+ *           end.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "spim_writer.h"
+
+enum
+{
+    SPIW_BUF_FREE,
+    SPIW_BUF_FILL,
+    SPIW_BUF_READY
+};
+
+enum
+{
+    SPIW_OP_NONE,
+    SPIW_OP_ERASE,
+    SPIW_OP_PROGRAM
+};
+
+/**
+  * @brief      Initialize a writer.
+  * @param      psW         Writer
+  * @param      psFlash     Flash port
+  * @param      pu8Buf0     First buffer, SPIW_BUF_SIZE bytes
+  * @param      pu8Buf1     Second buffer, SPIW_BUF_SIZE bytes
+  * @param      u32PdmaCh   PDMA channel for CRC_Update, or CRC_PDMA_NONE
+  * @return     None
+  */
+void SPIW_Init(SPIW_T *psW, const SPIW_FLASH_T *psFlash, uint8_t *pu8Buf0, uint8_t *pu8Buf1, uint32_t u32PdmaCh)
+{
+    memset(psW, 0, sizeof(SPIW_T));
+    psW->psFlash = psFlash;
+    psW->asBuf[0].pu8Data = pu8Buf0;
+    psW->asBuf[1].pu8Data = pu8Buf1;
+    psW->u32PdmaCh = u32PdmaCh;
+}
+
+/*
+ *  Poll the operation in progress and, if the flash is idle, start the next one.
+ *  A ready page goes first; the erase only runs ahead when no page can be programmed.
+ */
+static int SPIW_Pump(SPIW_T *psW)
+{
+    SPIW_BUF_T *psBuf;
+    uint32_t u32Addr, u32Len;
+
+    if (psW->u32Op != SPIW_OP_NONE)
+    {
+        psW->sStat.u32Polls++;
+        if (psW->psFlash->pfnIsBusy())
+        {
+            psW->sStat.u32BusyPolls++;
+            if (++psW->u32OpPolls >= SPIW_POLL_LIMIT)
+                return SPIW_ERR_TIMEOUT;
+            return SPIW_OK;
+        }
+
+        if (psW->u32Op == SPIW_OP_PROGRAM)
+        {
+            psBuf = &psW->asBuf[psW->u32Prog];
+            psBuf->u32Done += psW->u32OpLen;
+            psW->sStat.u32Bytes += psW->u32OpLen;
+            if (psBuf->u32Done == psBuf->u32Len)
+            {
+                psBuf->u32State = SPIW_BUF_FREE;
+                psW->u32Prog ^= 1;
+            }
+        }
+        psW->u32Op = SPIW_OP_NONE;
+    }
+
+    psW->u32OpPolls = 0;
+    psBuf = &psW->asBuf[psW->u32Prog];
+
+    if ((psBuf->u32State == SPIW_BUF_READY) && (psBuf->u32Addr + psBuf->u32Done < psW->u32ErsAddr))
+    {
+        /* Erase units are whole pages, so the page is erased up to its end */
+        u32Addr = psBuf->u32Addr + psBuf->u32Done;
+        u32Len = SPIW_PAGE_SIZE - (u32Addr % SPIW_PAGE_SIZE);
+        if (u32Len > psBuf->u32Len - psBuf->u32Done)
+            u32Len = psBuf->u32Len - psBuf->u32Done;
+
+        psW->psFlash->pfnProgram(u32Addr, psBuf->pu8Data + psBuf->u32Done, u32Len);
+        psW->u32Op = SPIW_OP_PROGRAM;
+        psW->u32OpLen = u32Len;
+        psW->sStat.u32Pages++;
+    }
+    else if (psW->u32ErsAddr < psW->u32End)
+    {
+        /* A block erase takes about as long as SPIW_SECTOR_MAX sector erases */
+        if (((psW->u32ErsAddr % SPIW_BLOCK_SIZE) == 0) &&
+                (psW->u32End - psW->u32ErsAddr > SPIW_SECTOR_MAX * SPIW_SECTOR_SIZE))
+        {
+            psW->psFlash->pfnErase(psW->u32ErsAddr, SPIW_BLOCK_SIZE);
+            psW->u32ErsAddr += SPIW_BLOCK_SIZE;
+            psW->sStat.u32Blocks++;
+        }
+        else
+        {
+            psW->psFlash->pfnErase(psW->u32ErsAddr, SPIW_SECTOR_SIZE);
+            psW->u32ErsAddr += SPIW_SECTOR_SIZE;
+            psW->sStat.u32Sectors++;
+        }
+        psW->u32Op = SPIW_OP_ERASE;
+    }
+    else
+    {
+        psW->sStat.u32IdlePolls++;
+    }
+    return SPIW_OK;
+}
+
+/**
+  * @brief      Erase, program and verify an image.
+  * @param      psW         Writer set up by SPIW_Init
+  * @param      u32Addr     Flash address, SPIW_SECTOR_SIZE aligned
+  * @param      u32Len      Image length
+  * @param      pfnFill     Reads the image in order, SPIW_FILL_SIZE bytes or the rest at a time
+  * @param      pvArg       Argument of pfnFill
+  * @retval     SPIW_OK             Image written and verified
+  * @retval     SPIW_ERR_PARAM      u32Addr is not sector aligned
+  * @retval     SPIW_ERR_FILL       pfnFill failed or returned less data
+  * @retval     SPIW_ERR_TIMEOUT    An erase or page program did not finish
+  * @retval     SPIW_ERR_VERIFY     The flash read back does not match
+  * @details    The flash from u32Addr up to the end of the image is erased; the rest of the last 64 KB
+  *             block is erased too when the image covers more than SPIW_SECTOR_MAX sectors of it. psW->sStat holds the
+  *             statistics afterwards; u32Crc is the CRC-32 of the image.
+  */
+int SPIW_Write(SPIW_T *psW, uint32_t u32Addr, uint32_t u32Len, SPIW_FILL_T pfnFill, void *pvArg)
+{
+    CRC_CTX_T sCrc, sReadCrc;
+    SPIW_BUF_T *psBuf;
+    uint32_t u32FillAddr, u32Size, u32Got, i;
+    int i32Ret = SPIW_OK;
+
+    if (u32Addr % SPIW_SECTOR_SIZE)
+        return SPIW_ERR_PARAM;
+
+    memset(&psW->sStat, 0, sizeof(SPIW_STAT_T));
+    for (i = 0; i < 2; i++)
+    {
+        psW->asBuf[i].u32State = SPIW_BUF_FREE;
+        psW->asBuf[i].u32Len = 0;
+        psW->asBuf[i].u32Done = 0;
+    }
+    psW->u32Fill = 0;
+    psW->u32Prog = 0;
+    psW->u32End = u32Addr + u32Len;
+    psW->u32ErsAddr = u32Addr;
+    psW->u32Op = SPIW_OP_NONE;
+    u32FillAddr = u32Addr;
+
+    CRC_Init(&sCrc, CRC_32, CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM, 0xFFFFFFFFUL, psW->u32PdmaCh);
+
+    while (psW->sStat.u32Bytes < u32Len)
+    {
+        i32Ret = SPIW_Pump(psW);
+        if (i32Ret != SPIW_OK)
+            break;
+
+        psBuf = &psW->asBuf[psW->u32Fill];
+        if (u32FillAddr >= psW->u32End)
+            continue;
+        if (psBuf->u32State != SPIW_BUF_FREE)
+        {
+            psW->sStat.u32FullPolls++;
+            continue;
+        }
+
+        psBuf->u32State = SPIW_BUF_FILL;
+        psBuf->u32Addr = u32FillAddr;
+        psBuf->u32Len = 0;
+        psBuf->u32Done = 0;
+        while ((psBuf->u32Len < SPIW_BUF_SIZE) && (u32FillAddr < psW->u32End))
+        {
+            u32Size = SPIW_FILL_SIZE;
+            if (u32Size > psW->u32End - u32FillAddr)
+                u32Size = psW->u32End - u32FillAddr;
+
+            if (pfnFill(pvArg, psBuf->pu8Data + psBuf->u32Len, u32Size, &u32Got) || (u32Got != u32Size))
+            {
+                i32Ret = SPIW_ERR_FILL;
+                break;
+            }
+            if (CRC_Update(&sCrc, psBuf->pu8Data + psBuf->u32Len, u32Size) != 0)
+            {
+                i32Ret = SPIW_ERR_VERIFY;
+                break;
+            }
+            psBuf->u32Len += u32Size;
+            u32FillAddr += u32Size;
+
+            i32Ret = SPIW_Pump(psW);
+            if (i32Ret != SPIW_OK)
+                break;
+        }
+        if (i32Ret != SPIW_OK)
+            break;
+
+        psBuf->u32State = SPIW_BUF_READY;
+        psW->u32Fill ^= 1;
+    }
+
+    /* Let an operation in progress finish before the flash is read or used otherwise */
+    while ((psW->u32Op != SPIW_OP_NONE) && (psW->u32OpPolls < SPIW_POLL_LIMIT))
+    {
+        psW->sStat.u32Polls++;
+        if (!psW->psFlash->pfnIsBusy())
+            break;
+        psW->sStat.u32BusyPolls++;
+        psW->u32OpPolls++;
+    }
+    psW->u32Op = SPIW_OP_NONE;
+
+    if (i32Ret != SPIW_OK)
+        return i32Ret;
+
+    psW->sStat.u32Crc = CRC_Final(&sCrc);
+
+    /* Read back through the first buffer and compare the CRC */
+    CRC_Init(&sReadCrc, CRC_32, CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM, 0xFFFFFFFFUL, psW->u32PdmaCh);
+    psBuf = &psW->asBuf[0];
+    for (u32FillAddr = u32Addr; u32FillAddr < psW->u32End; u32FillAddr += u32Size)
+    {
+        u32Size = SPIW_BUF_SIZE;
+        if (u32Size > psW->u32End - u32FillAddr)
+            u32Size = psW->u32End - u32FillAddr;
+
+        psW->psFlash->pfnRead(u32FillAddr, psBuf->pu8Data, u32Size);
+        if (CRC_Update(&sReadCrc, psBuf->pu8Data, u32Size) != 0)
+            return SPIW_ERR_VERIFY;
+    }
+
+    if (CRC_Final(&sReadCrc) != psW->sStat.u32Crc)
+        return SPIW_ERR_VERIFY;
+
+    return SPIW_OK;
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,94 @@
+/**************************************************************************//**
+ * @file     spim_writer.h
+ * @version  V1.00
+ * @brief    Double-buffered SPI NOR flash writer with overlapped erase/program
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __SPIM_WRITER_H__
+#define __SPIM_WRITER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SPIW_BUF_SIZE       2048UL      /*!< Size of each of the two data buffers             */
+#define SPIW_FILL_SIZE      512UL       /*!< Bytes per fill call; the flash is polled in between */
+#define SPIW_PAGE_SIZE      256UL       /*!< Flash program page size                         */
+#define SPIW_SECTOR_SIZE    0x1000UL    /*!< Flash sector erase size                         */
+#define SPIW_BLOCK_SIZE     0x10000UL   /*!< Flash block erase size                          */
+#define SPIW_SECTOR_MAX     4UL         /*!< Most sector erases before a block erase is used */
+#define SPIW_POLL_LIMIT     10000000UL  /*!< Status polls before one erase/program times out */
+
+#define SPIW_OK             0           /*!< Success                                         */
+#define SPIW_ERR_PARAM      (-1)        /*!< Address not sector aligned                      */
+#define SPIW_ERR_FILL       (-2)        /*!< Fill callback failed or ran out of data         */
+#define SPIW_ERR_TIMEOUT    (-3)        /*!< Erase/program did not finish                    */
+#define SPIW_ERR_VERIFY     (-4)        /*!< Read back CRC does not match                    */
+
+/*
+ *  Flash port. The erase and program functions only start the operation;
+ *  pfnIsBusy is one status poll.
+ */
+typedef struct
+{
+    void (*pfnErase)(uint32_t u32Addr, uint32_t u32Size);                   /*!< Start erasing the SPIW_SECTOR_SIZE or SPIW_BLOCK_SIZE unit at u32Addr */
+    void (*pfnProgram)(uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len); /*!< Start programming u32Len bytes within one page */
+    int  (*pfnIsBusy)(void);                                                /*!< Read the status once, nonzero while erase/program is in progress */
+    void (*pfnRead)(uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len);    /*!< Read flash, blocking */
+} SPIW_FLASH_T;
+
+/*
+ *  Fill callback. Reads u32Size bytes of the image into pu8Buf and returns 0,
+ *  or nonzero on error. *pu32Len is the number of bytes actually read.
+ */
+typedef int (*SPIW_FILL_T)(void *pvArg, uint8_t *pu8Buf, uint32_t u32Size, uint32_t *pu32Len);
+
+typedef struct
+{
+    uint8_t  *pu8Data;          /*!< Buffer memory, SPIW_BUF_SIZE bytes   */
+    uint32_t u32State;          /*!< Free, filling or ready               */
+    uint32_t u32Addr;           /*!< Flash address of the first byte      */
+    uint32_t u32Len;            /*!< Bytes filled                         */
+    uint32_t u32Done;           /*!< Bytes programmed                     */
+} SPIW_BUF_T;
+
+typedef struct
+{
+    uint32_t u32Bytes;          /*!< Bytes programmed                                   */
+    uint32_t u32Pages;          /*!< Page program operations                            */
+    uint32_t u32Sectors;        /*!< Sector erase operations                            */
+    uint32_t u32Blocks;         /*!< Block erase operations                             */
+    uint32_t u32Polls;          /*!< Flash status polls                                 */
+    uint32_t u32BusyPolls;      /*!< Status polls that found the flash busy             */
+    uint32_t u32IdlePolls;      /*!< Pump calls that found the flash idle with no work  */
+    uint32_t u32FullPolls;      /*!< Pump calls made while both buffers were full       */
+    uint32_t u32Crc;            /*!< CRC-32 of the image                                */
+} SPIW_STAT_T;
+
+typedef struct
+{
+    const SPIW_FLASH_T *psFlash;    /*!< Flash port                               */
+    SPIW_BUF_T  asBuf[2];           /*!< The two data buffers                     */
+    uint32_t    u32Fill;            /*!< Index of the buffer to fill next         */
+    uint32_t    u32Prog;            /*!< Index of the buffer to program next      */
+    uint32_t    u32End;             /*!< End address of the image                 */
+    uint32_t    u32ErsAddr;         /*!< Everything below is erased               */
+    uint32_t    u32Op;              /*!< Flash operation in progress              */
+    uint32_t    u32OpLen;           /*!< Bytes of the page program in progress    */
+    uint32_t    u32OpPolls;         /*!< Status polls of the operation so far     */
+    uint32_t    u32PdmaCh;          /*!< PDMA channel for CRC_Update              */
+    SPIW_STAT_T sStat;              /*!< Statistics of the last SPIW_Write        */
+} SPIW_T;
+
+void SPIW_Init(SPIW_T *psW, const SPIW_FLASH_T *psFlash, uint8_t *pu8Buf0, uint8_t *pu8Buf1, uint32_t u32PdmaCh);
+int  SPIW_Write(SPIW_T *psW, uint32_t u32Addr, uint32_t u32Len, SPIW_FILL_T pfnFill, void *pvArg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __SPIM_WRITER_H__ */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
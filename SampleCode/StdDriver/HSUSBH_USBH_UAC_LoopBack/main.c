@@ -14,6 +14,9 @@
 #include "usbh_lib.h"
 #include "usbh_uac.h"
 
+#define USE_PCM_RING        1       /* 1: stream through PCM rings; 0: copy in UAC callbacks */
+#define PCM_RING_BLK_NUM    8       /* number of PCM ring blocks, 8 frames each              */
+
 static uint16_t  vol_max, vol_min, vol_res, vol_cur;
 #ifdef DEBUG_ENABLE_SEMIHOST
 #error This sample cannot execute with semihost enabled
@@ -27,6 +30,7 @@ extern volatile uint32_t g_UacPlayCnt;         /* Counter UAC playback data
 extern void ResetAudioLoopBack(void);
 extern int audio_in_callback(UAC_DEV_T *dev, uint8_t *data, int len);
 extern int audio_out_callback(UAC_DEV_T *dev, uint8_t *data, int len);
+extern void uac_ring_loopback(UAC_DEV_T *dev);
 
 
 volatile uint32_t  g_tick_cnt;
@@ -481,6 +485,9 @@ int32_t main(void)
     UAC_DEV_T  *uac_dev;
     int        ch;
     uint16_t   val16;
+#if USE_PCM_RING
+    UAC_RING_STAT_T  ring_stat;
+#endif
 
     SYS_Init();                        /* Init System, IP clock and multi-function I/O */
 
@@ -519,9 +526,15 @@ int32_t main(void)
 
                 ResetAudioLoopBack();
 
+#if USE_PCM_RING
+                usbh_uac_start_audio_out_ring(uac_dev, PCM_RING_BLK_NUM, 192);  /* 48000 Hz stereo */
+
+                usbh_uac_start_audio_in_ring(uac_dev, PCM_RING_BLK_NUM);
+#else
                 usbh_uac_start_audio_out(uac_dev, audio_out_callback);
 
                 usbh_uac_start_audio_in(uac_dev, audio_in_callback);
+#endif
             }
         }
 
@@ -536,6 +549,10 @@ int32_t main(void)
             continue;
         }
 
+#if USE_PCM_RING
+        uac_ring_loopback(uac_dev);
+#endif
+
         if (!kbhit())
         {
             ch = getchar();
@@ -574,6 +591,12 @@ int32_t main(void)
             else
             {
                 printf("IN: %d, OUT: %d\n", g_UacRecCnt, g_UacPlayCnt);
+#if USE_PCM_RING
+                if (usbh_uac_ring_get_stat(uac_dev, UAC_MICROPHONE, &ring_stat, 1) == UAC_RET_OK)
+                    printf("IN ring: overrun %d, latency %d us (max %d us)\n", ring_stat.overrun, ring_stat.latency, ring_stat.latency_max);
+                if (usbh_uac_ring_get_stat(uac_dev, UAC_SPEAKER, &ring_stat, 1) == UAC_RET_OK)
+                    printf("OUT ring: underrun %d, latency %d us (max %d us)\n", ring_stat.underrun, ring_stat.latency, ring_stat.latency_max);
+#endif
                 usbh_memory_used();
             }
 
@@ -48,6 +48,66 @@ void ResetAudioLoopBack(void)
 }
 
 
+/**
+ *  @brief  Move audio data from the audio in PCM ring to the audio out PCM ring.
+ *          Used instead of audio_in_callback() and audio_out_callback() when the streams
+ *          are started with usbh_uac_start_audio_in_ring() and usbh_uac_start_audio_out_ring().
+ *          Audio data is copied once, in main loop, between ring frames.
+ *  @param[in] dev    Audio Class device
+ *  @return   None
+ */
+void uac_ring_loopback(UAC_DEV_T *dev)
+{
+    uint8_t    *in, *out;
+    uint16_t   *dptr, *bptr;
+    int        in_len, out_len, len, i;
+
+    while (1)
+    {
+        out_len = usbh_uac_ring_get_frame(dev, UAC_SPEAKER, &out);
+        if (out_len <= 0)
+            break;                          /* audio out ring full                        */
+
+        in_len = usbh_uac_ring_get_frame(dev, UAC_MICROPHONE, &in);
+        if (in_len <= 0)
+            break;                          /* no audio in data                           */
+
+        if (in_len < 2)
+        {
+            /* odd byte left in the audio in frame, drop it to move on to the next frame */
+            usbh_uac_ring_put_frame(dev, UAC_MICROPHONE, in_len);
+            continue;
+        }
+
+        if (g_bMicIsMono)
+        {
+            len = ((in_len * 2 < out_len) ? in_len : out_len / 2) & ~1;
+            dptr = (uint16_t *)in;
+            bptr = (uint16_t *)out;
+            for (i = 0; i < len; i += 2)
+            {
+                *bptr++ = *dptr;            /* 16-bit PCM data                            */
+                *bptr++ = *dptr++;          /* duplicate PCM data                         */
+            }
+            usbh_uac_ring_put_frame(dev, UAC_MICROPHONE, len);
+            usbh_uac_ring_put_frame(dev, UAC_SPEAKER, len * 2);
+        }
+        else
+        {
+            len = ((in_len < out_len) ? in_len : out_len) & ~1;
+            memcpy(out, in, len);
+            usbh_uac_ring_put_frame(dev, UAC_MICROPHONE, len);
+            usbh_uac_ring_put_frame(dev, UAC_SPEAKER, len);
+        }
+        if (len == 0)
+            break;
+
+        g_UacRecCnt += len;
+        g_UacPlayCnt += g_bMicIsMono ? len * 2 : len;
+    }
+}
+
+
 /**
  *  @brief  USB UAC audio-in data callback function.
  *          UAC driver deleivers an audio in data packet received from UAC device.
@@ -0,0 +1,351 @@
+/**************************************************************************//**
+ * @file     audio_out.c
+ * @version  V1.00
+ * @brief    Double-buffered PDMA I2S audio output engine
+ *
+ * The caller gives the engine N blocks of 32-bit PCM words (one stereo 16-bit
+ * sample per word). The decoder takes a free block with AOUT_GetBuffer(),
+ * fills it and queues it with AOUT_PutBuffer(). The PDMA walks a ring of
+ * AOUT_DESC_NUM scatter-gather descriptors. Each time one descriptor finishes,
+ * AOUT_IRQHandler() returns its block to the free queue and re-arms the same
+ * descriptor with the next queued block while the PDMA plays the following
+ * one. If nothing is queued, the descriptor is armed with a block of silence
+ * read from a fixed zero word, and the shortfall is counted as an underrun.
+ *
+ * Free and queued blocks travel between the decoder and the ISR through two
+ * single-producer single-consumer index queues, so neither side masks
+ * interrupts.
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+
+#include "audio_out.h"
+
+#define AOUT_SILENCE        0xFF            /* descriptor carries silence instead of a block */
+
+#define AOUT_DESC_CTL       (PDMA_WIDTH_32 | PDMA_DAR_FIX | PDMA_REQ_SINGLE | PDMA_OP_SCATTER)
+
+typedef struct
+{
+    volatile uint8_t u8Head;                /* next slot written by the producer */
+    volatile uint8_t u8Tail;                /* next slot read by the consumer */
+    uint8_t au8Id[AOUT_BLK_NUM_MAX + 1];
+} AOUT_Q_T;
+
+#ifdef __ICCARM__
+#pragma data_alignment=32
+static DSCT_T s_asDesc[AOUT_DESC_NUM];
+#else
+static DSCT_T s_asDesc[AOUT_DESC_NUM] __attribute__((aligned(32)));
+#endif
+
+static I2S_T *s_pI2S;
+static uint32_t s_u32PdmaCh;
+static uint32_t s_u32Peripheral;
+static uint32_t s_u32SampleRate;
+static uint32_t *s_pu32Buf;
+static uint32_t s_u32BlkLen;
+static uint32_t s_u32BlkNum;
+static uint32_t s_au32Len[AOUT_BLK_NUM_MAX];
+static uint8_t s_au8DescBlk[AOUT_DESC_NUM];
+static uint32_t s_u32DescIdx;
+static uint32_t s_u32Zero = 0;
+static volatile uint32_t s_u32Playing = 0;
+static AOUT_Q_T s_sFreeQ, s_sFullQ;
+static AOUT_STAT_T s_sStat;
+
+static uint32_t AOUT_QCount(AOUT_Q_T *psQ)
+{
+    return (psQ->u8Head + (AOUT_BLK_NUM_MAX + 1) - psQ->u8Tail) % (AOUT_BLK_NUM_MAX + 1);
+}
+
+static void AOUT_QPush(AOUT_Q_T *psQ, uint8_t u8Id)
+{
+    uint8_t u8Head = psQ->u8Head;
+
+    psQ->au8Id[u8Head] = u8Id;
+    __DMB();                                /* publish the entry before the index */
+    psQ->u8Head = (u8Head + 1) % (AOUT_BLK_NUM_MAX + 1);
+}
+
+static int32_t AOUT_QPop(AOUT_Q_T *psQ, uint8_t *pu8Id)
+{
+    uint8_t u8Tail = psQ->u8Tail;
+
+    if (u8Tail == psQ->u8Head)
+        return -1;
+    __DMB();
+    *pu8Id = psQ->au8Id[u8Tail];
+    psQ->u8Tail = (u8Tail + 1) % (AOUT_BLK_NUM_MAX + 1);
+    return 0;
+}
+
+/* Put every block back on the free queue. Only called while the PDMA is idle. */
+static void AOUT_Reclaim(void)
+{
+    uint32_t i;
+
+    s_sFreeQ.u8Head = s_sFreeQ.u8Tail = 0;
+    s_sFullQ.u8Head = s_sFullQ.u8Tail = 0;
+    for (i = 0; i < s_u32BlkNum; i++)
+        AOUT_QPush(&s_sFreeQ, (uint8_t)i);
+    for (i = 0; i < AOUT_DESC_NUM; i++)
+        s_au8DescBlk[i] = AOUT_SILENCE;
+}
+
+/* Load descriptor u32Desc with the next queued block, or with silence if there is none */
+static void AOUT_ArmDesc(uint32_t u32Desc)
+{
+    DSCT_T *psDesc = &s_asDesc[u32Desc];
+    uint8_t u8Blk;
+
+    if (AOUT_QPop(&s_sFullQ, &u8Blk) == 0)
+    {
+        psDesc->SA = (uint32_t)&s_pu32Buf[u8Blk * s_u32BlkLen];
+        psDesc->CTL = ((s_au32Len[u8Blk] - 1) << PDMA_DSCT_CTL_TXCNT_Pos) | PDMA_SAR_INC | AOUT_DESC_CTL;
+    }
+    else
+    {
+        u8Blk = AOUT_SILENCE;
+        psDesc->SA = (uint32_t)&s_u32Zero;
+        psDesc->CTL = ((s_u32BlkLen - 1) << PDMA_DSCT_CTL_TXCNT_Pos) | PDMA_SAR_FIX | AOUT_DESC_CTL;
+    }
+    s_au8DescBlk[u32Desc] = u8Blk;
+}
+
+/**
+  * @brief      Prepare the output engine
+  * @param[in]  i2s             The I2S module that plays the PCM data. It must be opened and its
+  *                             clocks set up by the caller.
+  * @param[in]  u32PdmaCh       PDMA channel used for the transfer
+  * @param[in]  u32Peripheral   PDMA request source of the I2S TX FIFO, e.g. PDMA_I2S0_TX
+  * @param[in]  u32SampleRate   Sample rate in Hz, used to convert the statistics to time
+  * @param[in]  pu32Buf         u32BlkNum * u32BlkLen words of PCM buffer
+  * @param[in]  u32BlkLen       Words per block, 1 ~ 65536
+  * @param[in]  u32BlkNum       Number of blocks, AOUT_DESC_NUM ~ AOUT_BLK_NUM_MAX
+  * @retval     AOUT_OK         Success
+  * @retval     AOUT_ERR_PARAM  Invalid parameter
+  * @retval     AOUT_ERR_BUSY   The engine is playing
+  */
+int32_t AOUT_Open(I2S_T *i2s, uint32_t u32PdmaCh, uint32_t u32Peripheral, uint32_t u32SampleRate,
+                  uint32_t *pu32Buf, uint32_t u32BlkLen, uint32_t u32BlkNum)
+{
+    uint32_t i;
+
+    if (s_u32Playing)
+        return AOUT_ERR_BUSY;
+
+    if ((pu32Buf == NULL) || (u32PdmaCh >= PDMA_CH_MAX) || (u32BlkLen == 0) || (u32BlkLen > 0x10000) ||
+            (u32BlkNum < AOUT_DESC_NUM) || (u32BlkNum > AOUT_BLK_NUM_MAX) || (u32SampleRate == 0))
+        return AOUT_ERR_PARAM;
+
+    s_pI2S = i2s;
+    s_u32PdmaCh = u32PdmaCh;
+    s_u32Peripheral = u32Peripheral;
+    s_u32SampleRate = u32SampleRate;
+    s_pu32Buf = pu32Buf;
+    s_u32BlkLen = u32BlkLen;
+    s_u32BlkNum = u32BlkNum;
+
+    /* The descriptors form a fixed ring; only their source and count change at run time */
+    for (i = 0; i < AOUT_DESC_NUM; i++)
+    {
+        s_asDesc[i].DA = (uint32_t)&i2s->TXFIFO;
+        s_asDesc[i].NEXT = (uint32_t)&s_asDesc[(i + 1) % AOUT_DESC_NUM] - (PDMA->SCATBA);
+    }
+
+    AOUT_Reclaim();
+    AOUT_GetStat(NULL, 1);
+
+    I2S_SetFIFO(i2s, AOUT_TX_FIFO_TH, (i2s->CTL1 & I2S_CTL1_RXTH_Msk) >> I2S_CTL1_RXTH_Pos);
+
+    return AOUT_OK;
+}
+
+/**
+  * @brief      Stop the engine and release the I2S module and PDMA channel
+  */
+void AOUT_Close(void)
+{
+    AOUT_Stop();
+    s_pu32Buf = NULL;
+}
+
+/**
+  * @brief      Start playing
+  * @retval     AOUT_OK         Success
+  * @retval     AOUT_ERR_PARAM  AOUT_Open was not called
+  * @retval     AOUT_ERR_BUSY   Already playing
+  * @details    Blocks queued before this call are played first. Queue at least AOUT_DESC_NUM
+  *             blocks beforehand, otherwise playback starts with silence.
+  */
+int32_t AOUT_Start(void)
+{
+    uint32_t i, u32Mask;
+
+    if (s_pu32Buf == NULL)
+        return AOUT_ERR_PARAM;
+    if (s_u32Playing)
+        return AOUT_ERR_BUSY;
+
+    for (i = 0; i < AOUT_DESC_NUM; i++)
+        AOUT_ArmDesc(i);
+    s_u32DescIdx = 0;
+
+    u32Mask = 1UL << s_u32PdmaCh;
+    PDMA_CLR_TD_FLAG(PDMA, u32Mask);
+    PDMA_Open(PDMA, u32Mask);
+    PDMA_SetTransferMode(PDMA, s_u32PdmaCh, s_u32Peripheral, 1, (uint32_t)&s_asDesc[0]);
+    PDMA_EnableInt(PDMA, s_u32PdmaCh, PDMA_INT_TRANS_DONE);
+    NVIC_EnableIRQ(PDMA_IRQn);
+
+    s_u32Playing = 1;
+
+    I2S_ENABLE_TXDMA(s_pI2S);
+    I2S_ENABLE_TX(s_pI2S);
+
+    return AOUT_OK;
+}
+
+/**
+  * @brief      Stop playing at once
+  * @details    Queued blocks that have not been played are dropped and every block is free again.
+  *             Wait for AOUT_GetQueued() to reach 0 first to play out the tail of a stream.
+  */
+void AOUT_Stop(void)
+{
+    if (!s_u32Playing)
+        return;
+
+    I2S_DISABLE_TX(s_pI2S);
+    I2S_DISABLE_TXDMA(s_pI2S);
+
+    PDMA_DisableInt(PDMA, s_u32PdmaCh, PDMA_INT_TRANS_DONE);
+    PDMA_STOP(PDMA, s_u32PdmaCh);
+    PDMA->CHCTL &= ~(1UL << s_u32PdmaCh);
+    PDMA_CLR_TD_FLAG(PDMA, 1UL << s_u32PdmaCh);
+
+    I2S_CLR_TX_FIFO(s_pI2S);
+
+    s_u32Playing = 0;
+    AOUT_Reclaim();
+}
+
+/**
+  * @brief      Get a free block to fill
+  * @return     Start of a block of the length given to AOUT_Open, or NULL if every block is queued
+  *             or playing. The same block is returned until it is handed over by AOUT_PutBuffer.
+  */
+uint32_t *AOUT_GetBuffer(void)
+{
+    uint8_t u8Tail = s_sFreeQ.u8Tail;
+
+    if (u8Tail == s_sFreeQ.u8Head)
+        return NULL;
+    __DMB();
+    return &s_pu32Buf[s_sFreeQ.au8Id[u8Tail] * s_u32BlkLen];
+}
+
+/**
+  * @brief      Queue the block returned by AOUT_GetBuffer for playing
+  * @param[in]  u32Len  Number of valid words in the block. A short block is played as is, so
+  *                     the last block of a stream does not need padding. 0 keeps the block.
+  */
+void AOUT_PutBuffer(uint32_t u32Len)
+{
+    uint8_t u8Blk;
+
+    if ((u32Len == 0) || (AOUT_QPop(&s_sFreeQ, &u8Blk) != 0))
+        return;
+
+    s_au32Len[u8Blk] = (u32Len < s_u32BlkLen) ? u32Len : s_u32BlkLen;
+    AOUT_QPush(&s_sFullQ, u8Blk);
+}
+
+/**
+  * @brief      Get the number of blocks queued or being played
+  */
+uint32_t AOUT_GetQueued(void)
+{
+    return s_u32BlkNum - AOUT_QCount(&s_sFreeQ);
+}
+
+/**
+  * @brief      Check whether the engine is playing
+  * @return     1 if playing, 0 otherwise
+  */
+uint32_t AOUT_IsPlaying(void)
+{
+    return s_u32Playing;
+}
+
+/**
+  * @brief      Get the playback statistics
+  * @param[out] psStat      Statistics, may be NULL
+  * @param[in]  u32Clear    1 to clear the statistics after reading them
+  */
+void AOUT_GetStat(AOUT_STAT_T *psStat, uint32_t u32Clear)
+{
+    uint32_t u32Primask = __get_PRIMASK();
+
+    __disable_irq();
+    if ((psStat != NULL) && (s_u32SampleRate != 0))
+    {
+        *psStat = s_sStat;
+        psStat->u32PlayMs = (uint32_t)(((uint64_t)s_sStat.u32Samples * 1000) / s_u32SampleRate);
+        psStat->u32UnderrunMs = (uint32_t)(((uint64_t)s_sStat.u32SilentSamples * 1000) / s_u32SampleRate);
+    }
+    if (u32Clear)
+    {
+        memset(&s_sStat, 0, sizeof(s_sStat));
+        s_sStat.u32MinQueued = s_u32BlkNum;
+    }
+    __set_PRIMASK(u32Primask);
+}
+
+/**
+  * @brief      PDMA interrupt service for the engine. Call it from PDMA_IRQHandler.
+  * @details    Only the transfer done flag of the engine channel is handled and cleared.
+  */
+void AOUT_IRQHandler(void)
+{
+    uint32_t u32Mask = 1UL << s_u32PdmaCh;
+    uint32_t u32Desc, u32Queued;
+    uint8_t u8Blk;
+
+    if (!(PDMA_GET_INT_STATUS(PDMA) & PDMA_INTSTS_TDIF_Msk) || !(PDMA_GET_TD_STS(PDMA) & u32Mask))
+        return;
+    PDMA_CLR_TD_FLAG(PDMA, u32Mask);
+
+    if (!s_u32Playing)
+        return;
+
+    /* The PDMA already runs the next descriptor; account for this one and refill it behind */
+    u32Desc = s_u32DescIdx;
+    u8Blk = s_au8DescBlk[u32Desc];
+    if (u8Blk == AOUT_SILENCE)
+    {
+        s_sStat.u32Underruns++;
+        s_sStat.u32Samples += s_u32BlkLen;
+        s_sStat.u32SilentSamples += s_u32BlkLen;
+    }
+    else
+    {
+        s_sStat.u32Blocks++;
+        s_sStat.u32Samples += s_au32Len[u8Blk];
+        AOUT_QPush(&s_sFreeQ, u8Blk);
+    }
+
+    AOUT_ArmDesc(u32Desc);
+    s_u32DescIdx = (u32Desc + 1) % AOUT_DESC_NUM;
+
+    u32Queued = AOUT_QCount(&s_sFullQ);
+    if (u32Queued < s_sStat.u32MinQueued)
+        s_sStat.u32MinQueued = u32Queued;
+}
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
@@ -0,0 +1,64 @@
+/**************************************************************************//**
+ * @file     audio_out.h
+ * @version  V1.00
+ * @brief    Double-buffered PDMA I2S audio output engine header file
+ *
+ * @copyright (C) 2016 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef __AUDIO_OUT_H__
+#define __AUDIO_OUT_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Configuration                                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+#define AOUT_BLK_NUM_MAX        8           /*!< Maximum number of PCM blocks handed to AOUT_Open  */
+#define AOUT_DESC_NUM           2           /*!< Scatter-gather descriptors walked by the PDMA      */
+#define AOUT_TX_FIFO_TH         4           /*!< I2S TX FIFO threshold in words                     */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Error codes                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#define AOUT_OK                 0           /*!< No error                                           */
+#define AOUT_ERR_PARAM          -1          /*!< Invalid parameter                                  */
+#define AOUT_ERR_BUSY           -2          /*!< Engine is already playing                          */
+
+/**
+  * @brief  Playback statistics. Every figure is derived from the number of samples clocked out
+  *         by the PDMA, so it is locked to the I2S sample rate rather than to the CPU clock.
+  */
+typedef struct
+{
+    uint32_t u32Blocks;         /*!< Decoded blocks played                                  */
+    uint32_t u32Underruns;      /*!< Silent blocks inserted because no decoded block was queued */
+    uint32_t u32Samples;        /*!< Samples clocked out, silence included                  */
+    uint32_t u32SilentSamples;  /*!< Samples of silence inserted on underrun                */
+    uint32_t u32PlayMs;         /*!< u32Samples in milliseconds at the open sample rate     */
+    uint32_t u32UnderrunMs;     /*!< u32SilentSamples in milliseconds at the open sample rate */
+    uint32_t u32MinQueued;      /*!< Fewest decoded blocks left queued when a block finished */
+} AOUT_STAT_T;
+
+int32_t AOUT_Open(I2S_T *i2s, uint32_t u32PdmaCh, uint32_t u32Peripheral, uint32_t u32SampleRate,
+                  uint32_t *pu32Buf, uint32_t u32BlkLen, uint32_t u32BlkNum);
+void AOUT_Close(void);
+int32_t AOUT_Start(void);
+void AOUT_Stop(void);
+uint32_t *AOUT_GetBuffer(void);
+void AOUT_PutBuffer(uint32_t u32Len);
+uint32_t AOUT_GetQueued(void);
+uint32_t AOUT_IsPlaying(void);
+void AOUT_GetStat(AOUT_STAT_T *psStat, uint32_t u32Clear);
+void AOUT_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __AUDIO_OUT_H__ */
+
+/*** (C) COPYRIGHT 2016 Nuvoton Technology Corp. ***/
@@ -15,7 +15,8 @@
 #define USE_SDH
 //#define USE_USBH
 
-#define PCM_BUFFER_SIZE        2304
+#define PCM_BUFFER_SIZE        2304     /* words per output block, two MP3 frames */
+#define PCM_BLK_NUM            4        /* output blocks queued ahead of the PDMA */
 #define FILE_IO_BUFFER_SIZE    4096
 
 struct mp3Header
@@ -46,20 +47,9 @@ struct AudioInfoObject
     unsigned int mp3Playing;
 };
 
-typedef struct dma_desc_t
-{
-    uint32_t ctl;
-    uint32_t src;
-    uint32_t dest;
-    uint32_t offset;
-} DMA_DESC_T;
-
-
-void PDMA_Reset_SCTable(uint8_t id);
 void NAU88L25_ConfigSampleRate(uint32_t u32SampleRate);
 
 int mp3CountV1L3Headers(unsigned char *pBytes, size_t size);
-extern void PDMA_Init(void);
 extern void NAU88L25_Setup(void);
 extern void MP3Player(void);
 #endif
@@ -10,9 +10,7 @@
 #include "NuMicro.h"
 
 #include "config.h"
-
-extern volatile uint8_t aPCMBuffer_Full[2];
-volatile uint8_t u8PCMBuffer_Playing=0;
+#include "audio_out.h"
 
 void PDMA_IRQHandler(void)
 {
@@ -20,14 +18,8 @@ void PDMA_IRQHandler(void)
 
     if (u32Status & 0x2)   /* done */
     {
-        if (PDMA_GET_TD_STS(PDMA) & 0x4)
-        {
-            if(aPCMBuffer_Full[u8PCMBuffer_Playing^1] != 1)
-                printf("underflow!!\n");
-            aPCMBuffer_Full[u8PCMBuffer_Playing] = 0;       //set empty flag
-            u8PCMBuffer_Playing ^= 1;
-        }
-        PDMA_CLR_TD_FLAG(PDMA,PDMA_TDSTS_TDIF2_Msk);
+        /* underflows are counted by the output engine, see AOUT_GetStat() */
+        AOUT_IRQHandler();
     }
     else if(u32Status & 0x400)     /* Timeout */
     {
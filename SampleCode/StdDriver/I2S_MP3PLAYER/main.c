@@ -19,14 +19,10 @@ FATFS FatFs[FF_VOLUMES];               /* File system object for logical drive *
 #ifdef __ICCARM__
 #pragma data_alignment=32
 BYTE Buff[16] ;                   /* Working buffer */
-DMA_DESC_T DMA_DESC[2];
 #else
 BYTE Buff[16] __attribute__((aligned(32)));       /* Working buffer */
-DMA_DESC_T DMA_DESC[2] __attribute__((aligned(32)));
 #endif
 
-uint8_t bAudioPlaying = 0;
-extern signed int aPCMBuffer[2][PCM_BUFFER_SIZE];
 extern uint32_t volatile sd_init_ok;
 
 /*---------------------------------------------------------*/
@@ -209,27 +205,6 @@ void I2C2_Init(void)
     I2C_Open(I2C2, 100000);
 }
 
-// Configure PDMA to Scatter Gather mode */
-void PDMA_Init(void)
-{
-    DMA_DESC[0].ctl = ((PCM_BUFFER_SIZE-1)<<PDMA_DSCT_CTL_TXCNT_Pos)|PDMA_WIDTH_32|PDMA_SAR_INC|PDMA_DAR_FIX|PDMA_REQ_SINGLE|PDMA_OP_SCATTER;
-    DMA_DESC[0].src = (uint32_t)&aPCMBuffer[0][0];
-    DMA_DESC[0].dest = (uint32_t)&I2S0->TXFIFO;
-    DMA_DESC[0].offset = (uint32_t)&DMA_DESC[1] - (PDMA->SCATBA);
-
-    DMA_DESC[1].ctl = ((PCM_BUFFER_SIZE-1)<<PDMA_DSCT_CTL_TXCNT_Pos)|PDMA_WIDTH_32|PDMA_SAR_INC|PDMA_DAR_FIX|PDMA_REQ_SINGLE|PDMA_OP_SCATTER;
-    DMA_DESC[1].src = (uint32_t)&aPCMBuffer[1][0];
-    DMA_DESC[1].dest = (uint32_t)&I2S0->TXFIFO;
-    DMA_DESC[1].offset = (uint32_t)&DMA_DESC[0] - (PDMA->SCATBA);
-
-    PDMA_Open(PDMA,1 << 2);
-    PDMA_SetTransferMode(PDMA,2, PDMA_I2S0_TX, 1, (uint32_t)&DMA_DESC[0]);
-
-    PDMA_EnableInt(PDMA,2, 0);
-    NVIC_EnableIRQ(PDMA_IRQn);
-}
-
-
 int32_t main (void)
 {
     TCHAR sd_path[] = { '0', ':', 0 };    /* SD drive started from 0 */
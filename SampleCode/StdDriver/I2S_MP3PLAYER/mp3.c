@@ -25,6 +25,7 @@
 #include "NuMicro.h"
 
 #include "config.h"
+#include "audio_out.h"
 #include "diskio.h"
 #include "ff.h"
 #include "mad.h"
@@ -59,15 +60,12 @@ FSIZE_t         id3v2Size = 0;
 FSIZE_t         id3v1Size = 128;
 
 extern void NAU88L25_Reset(void);
-// I2S PCM buffer x2
-signed int aPCMBuffer[2][PCM_BUFFER_SIZE];
+// I2S PCM blocks handed to the output engine
+uint32_t aPCMBuffer[PCM_BLK_NUM][PCM_BUFFER_SIZE];
 // File IO buffer for MP3 library
 unsigned char MadInputBuffer[FILE_IO_BUFFER_SIZE+MAD_BUFFER_GUARD];
-// buffer full flag x2
-volatile uint8_t aPCMBuffer_Full[2]= {0,0};
 // audio information structure
 struct AudioInfoObject audioInfo;
-extern volatile uint8_t u8PCMBuffer_Playing;
 
 /**
  * MP3 frame can be attached with either ID3v1 or v2, or both
@@ -177,9 +175,7 @@ void MP3_ParseHeaderInfo(uint8_t *pFileName)
 void StartPlay(void)
 {
     printf("Start playing ...\n");
-    PDMA_Init();
-    I2S_ENABLE_TXDMA(I2S0);
-    I2S_ENABLE_TX(I2S0);
+    AOUT_Start();
 
     // enable sound output
     //PI3 = 0;
@@ -189,15 +185,20 @@ void StartPlay(void)
 // Disable I2S TX with PDMA function
 void StopPlay(void)
 {
-    I2S_DISABLE_TXDMA(I2S0);
-    I2S_DISABLE_TX(I2S0);
+    AOUT_STAT_T sStat;
 
-    PDMA_Close(PDMA);
+    // play out the queued blocks before stopping
+    if(audioInfo.mp3Playing)
+        while(AOUT_GetQueued());
+
+    AOUT_GetStat(&sStat, 1);
+    AOUT_Close();
 
     // disable sound output
 //    PI3 = 1;
     audioInfo.mp3Playing = 0;
-    printf("Stop ...\n");
+    printf("Stop ... played %d ms, %d underruns (%d ms), min. queued %d\n",
+           sStat.u32PlayMs, sStat.u32Underruns, sStat.u32UnderrunMs, sStat.u32MinQueued);
 }
 
 // MP3 decode player
@@ -206,17 +207,14 @@ void MP3Player(void)
     FRESULT res;
     uint8_t *ReadStart;
     uint8_t *GuardPtr;
-    volatile uint8_t u8PCMBufferTargetIdx = 0;
+    uint32_t *pu32PCM = NULL;
     volatile uint32_t pcmbuf_idx, i;
     volatile unsigned int Mp3FileOffset=0;
     uint16_t sampleL, sampleR;
 
     pcmbuf_idx = 0;
-    u8PCMBuffer_Playing = 0;
     memset((void *)&audioInfo, 0, sizeof(audioInfo));
     memset((void *)MadInputBuffer, 0, sizeof(MadInputBuffer));
-    memset((void *)aPCMBuffer, 0, sizeof(aPCMBuffer));
-    memset((void *)aPCMBuffer_Full, 0, sizeof(aPCMBuffer_Full));
 
     /* Parse MP3 header */
     MP3_ParseHeaderInfo(MP3_FILE);
@@ -260,6 +258,9 @@ void MP3Player(void)
     /* Configure NAU88L25 to specific sample rate */
     NAU88L25_ConfigSampleRate(audioInfo.mp3SampleRate);
 
+    /* PCM blocks go out through I2S0 TX on PDMA channel 2 */
+    AOUT_Open(I2S0, 2, PDMA_I2S0_TX, audioInfo.mp3SampleRate, &aPCMBuffer[0][0], PCM_BUFFER_SIZE, PCM_BLK_NUM);
+
     while(1)
     {
         if(Stream.buffer==NULL || Stream.error==MAD_ERROR_BUFLEN)
@@ -347,47 +348,43 @@ void MP3Player(void)
         // decode finished, try to copy pcm data to audio buffer
         //
 
-        if(audioInfo.mp3Playing)
-        {
-            //if next buffer is still full (playing), wait until it's empty
-            if(aPCMBuffer_Full[u8PCMBufferTargetIdx] == 1)
-                while(aPCMBuffer_Full[u8PCMBufferTargetIdx]);
-        }
-        else
+        for(i=0; i<(int)Synth.pcm.length; i++)
         {
-
-            if((aPCMBuffer_Full[0] == 1) && (aPCMBuffer_Full[1] == 1 ))         //all buffers are full, wait
+            /* Get a free block; once all blocks are queued start playing and wait for one */
+            if(pu32PCM == NULL)
             {
-                StartPlay();
+                while((pu32PCM = AOUT_GetBuffer()) == NULL)
+                {
+                    if(!audioInfo.mp3Playing)
+                        StartPlay();
+                }
+                pcmbuf_idx = 0;
             }
-        }
 
-        for(i=0; i<(int)Synth.pcm.length; i++)
-        {
             /* Get the left/right samples */
             sampleL = Synth.pcm.samples[0][i];
             sampleR = Synth.pcm.samples[1][i];
 
             /* Fill PCM data to I2S(PDMA) buffer */
-            aPCMBuffer[u8PCMBufferTargetIdx][pcmbuf_idx++] = sampleR | (sampleL << 16);
+            pu32PCM[pcmbuf_idx++] = sampleR | (sampleL << 16);
 
-            /* Need change buffer ? */
+            /* Hand the full block over to the PDMA */
             if(pcmbuf_idx == PCM_BUFFER_SIZE)
             {
-                aPCMBuffer_Full[u8PCMBufferTargetIdx] = 1;      //set full flag
-                u8PCMBufferTargetIdx ^= 1;
-
-                pcmbuf_idx = 0;
-                //printf("change to ==>%d ..\n", u8PCMBufferTargetIdx);
-                /* if next buffer is still full (playing), wait until it's empty */
-                if((aPCMBuffer_Full[u8PCMBufferTargetIdx] == 1) && (audioInfo.mp3Playing))
-                    while(aPCMBuffer_Full[u8PCMBufferTargetIdx]);
+                AOUT_PutBuffer(PCM_BUFFER_SIZE);
+                pu32PCM = NULL;
             }
         }
     }
 
 stop:
 
+    /* queue the last partial block, and start playing if the file was shorter than the buffers */
+    if(pu32PCM != NULL)
+        AOUT_PutBuffer(pcmbuf_idx);
+    if(!audioInfo.mp3Playing && AOUT_GetQueued())
+        StartPlay();
+
     printf("Exit MP3\r\n");
 
     mad_synth_finish(&Synth);
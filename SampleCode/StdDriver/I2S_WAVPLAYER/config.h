@@ -15,18 +15,9 @@
 #define BUFF_LEN    32
 #define BUFF_HALF_LEN   (BUFF_LEN/2)
 
-#define PCM_BUFFER_SIZE 4*1024
+#define PCM_BUFFER_SIZE 4*1024      /* words per output block */
+#define PCM_BLK_NUM     3           /* output blocks queued ahead of the PDMA */
 
-typedef struct dma_desc_t
-{
-    uint32_t ctl;
-    uint32_t endsrc;
-    uint32_t enddest;
-    uint32_t offset;
-} DMA_DESC_T;
-
-
-void PDMA_Reset_SCTable(uint8_t id);
 void WAVPlayer(void);
 void NAU88L25_ConfigSampleRate(uint32_t u32SampleRate);
 
@@ -10,9 +10,7 @@
 #include "NuMicro.h"
 
 #include "config.h"
-
-extern volatile uint8_t aPCMBuffer_Full[2];
-extern volatile uint8_t u8PCMBuffer_Playing;
+#include "audio_out.h"
 
 void PDMA_IRQHandler(void)
 {
@@ -20,12 +18,7 @@ void PDMA_IRQHandler(void)
 
     if (u32Status & 0x2)   /* done */
     {
-        if (PDMA_GET_TD_STS(PDMA) & 0x4)
-        {
-            aPCMBuffer_Full[u8PCMBuffer_Playing] = 0;       //set empty flag
-            u8PCMBuffer_Playing ^= 1;
-        }
-        PDMA_CLR_TD_FLAG(PDMA,PDMA_TDSTS_TDIF2_Msk);
+        AOUT_IRQHandler();
     }
     else if(u32Status & 0x400)     /* Timeout */
     {
@@ -18,8 +18,6 @@
 
 #define NAU8822_ADDR        0x1A                /* NAU8822 Device ID */
 
-DMA_DESC_T DMA_DESC[2];
-
 //uint32_t PcmBuff[BUFF_LEN] = {0};
 uint32_t volatile u32BuffPos = 0;
 FATFS FatFs[FF_VOLUMES];      /* File system object for logical drive */
@@ -30,8 +28,6 @@ BYTE Buff[1024] ;       /* Working buffer */
 BYTE Buff[1024] __attribute__((aligned(32)));       /* Working buffer */
 #endif
 
-uint8_t bAudioPlaying = 0;
-extern signed int aPCMBuffer[2][PCM_BUFFER_SIZE];
 
 /*---------------------------------------------------------*/
 /* User Provided RTC Function for FatFs module             */
@@ -405,26 +401,6 @@ void I2C2_Init(void)
     printf("I2C clock %d Hz\n", I2C_GetBusClockFreq(I2C2));
 }
 
-void PDMA_Init(void)
-{
-    DMA_DESC[0].ctl = ((PCM_BUFFER_SIZE-1)<<PDMA_DSCT_CTL_TXCNT_Pos)|PDMA_WIDTH_32|PDMA_SAR_INC|PDMA_DAR_FIX|PDMA_REQ_SINGLE|PDMA_OP_SCATTER;
-    DMA_DESC[0].endsrc = (uint32_t)&aPCMBuffer[0][0];
-    DMA_DESC[0].enddest = (uint32_t)&I2S0->TXFIFO;
-    DMA_DESC[0].offset = (uint32_t)&DMA_DESC[1] - (PDMA->SCATBA);
-
-    DMA_DESC[1].ctl = ((PCM_BUFFER_SIZE-1)<<PDMA_DSCT_CTL_TXCNT_Pos)|PDMA_WIDTH_32|PDMA_SAR_INC|PDMA_DAR_FIX|PDMA_REQ_SINGLE|PDMA_OP_SCATTER;
-    DMA_DESC[1].endsrc = (uint32_t)&aPCMBuffer[1][0];
-    DMA_DESC[1].enddest = (uint32_t)&I2S0->TXFIFO;
-    DMA_DESC[1].offset = (uint32_t)&DMA_DESC[0] - (PDMA->SCATBA);
-
-    PDMA_Open(PDMA,1 << 2);
-    PDMA_SetTransferMode(PDMA,2, PDMA_I2S0_TX, 1, (uint32_t)&DMA_DESC[0]);
-
-    PDMA_EnableInt(PDMA,2, 0);
-    NVIC_EnableIRQ(PDMA_IRQn);
-}
-
-
 int32_t main (void)
 {
     TCHAR       sd_path[] = { '0', ':', 0 };    /* SD drive started from 0 */
@@ -473,9 +449,6 @@ int32_t main (void)
     CLK_SysTickDelay(20000);
     NAU88L25_Setup();
 
-    /* Configure PDMA and use Scatter-Gather mode */
-    PDMA_Init();
-
     while(1)
     {
         WAVPlayer();
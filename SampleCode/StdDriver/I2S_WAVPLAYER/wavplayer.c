@@ -12,6 +12,7 @@
 #include "NuMicro.h"
 
 #include "config.h"
+#include "audio_out.h"
 
 #include "diskio.h"
 #include "ff.h"
@@ -28,18 +29,15 @@
 FIL    wavFileObject;
 size_t ReturnSize;
 
-signed int aPCMBuffer[2][PCM_BUFFER_SIZE];
-volatile uint8_t aPCMBuffer_Full[2]= {0,0};
-volatile uint8_t u8PCMBuffer_Playing=0;
+uint32_t aPCMBuffer[PCM_BLK_NUM][PCM_BUFFER_SIZE];
 uint32_t aWavHeader[11];
 
-extern uint8_t bAudioPlaying;
-
 void WAVPlayer(void)
 {
     FRESULT res;
-    uint8_t u8PCMBufferTargetIdx = 0;
+    uint32_t *pu32PCM;
     uint32_t u32WavSamplingRate;
+    AOUT_STAT_T sStat;
 
     res = f_open(&wavFileObject, "0:\\test.wav", FA_OPEN_EXISTING | FA_READ);       //USBH:0 , SD0: 1
     if (res != FR_OK)
@@ -61,47 +59,40 @@ void WAVPlayer(void)
     I2S_EnableMCLK(I2S0, 12000000);
     I2S0->CTL0 |= I2S_CTL0_ORDER_Msk;
 
+    /* PCM blocks go out through I2S0 TX on PDMA channel 2 */
+    AOUT_Open(I2S0, 2, PDMA_I2S0_TX, u32WavSamplingRate, &aPCMBuffer[0][0], PCM_BUFFER_SIZE, PCM_BLK_NUM);
+
     while(1)
     {
-        if((aPCMBuffer_Full[0] == 1) && (aPCMBuffer_Full[1] == 1 ))         //all buffers are full, wait
+        /* Get a free block; once all blocks are queued start playing and wait for one */
+        while((pu32PCM = AOUT_GetBuffer()) == NULL)
         {
-            if(!bAudioPlaying)
+            if(!AOUT_IsPlaying())
             {
-                bAudioPlaying = 1;
-                I2S_ENABLE_TXDMA(I2S0);
-                I2S_ENABLE_TX(I2S0);
+                AOUT_Start();
                 printf("Start Playing ...\n");
             }
-
-            while((aPCMBuffer_Full[0] == 1) && (aPCMBuffer_Full[1] == 1));
-            //printf(".");
         }
 
-        res = f_read(&wavFileObject, &aPCMBuffer[u8PCMBufferTargetIdx][0], PCM_BUFFER_SIZE*4, &ReturnSize);
-        if (ReturnSize < PCM_BUFFER_SIZE*4)
-            memset(&aPCMBuffer[u8PCMBufferTargetIdx][ReturnSize], 0, PCM_BUFFER_SIZE*4 - ReturnSize);
-
-        if(f_eof(&wavFileObject) && (ReturnSize == 0))
+        res = f_read(&wavFileObject, pu32PCM, PCM_BUFFER_SIZE*4, &ReturnSize);
+        if((res != FR_OK) || (ReturnSize < 4))
             break;
-        aPCMBuffer_Full[u8PCMBufferTargetIdx] = 1;
 
-        if(bAudioPlaying)
-        {
-            if(aPCMBuffer_Full[u8PCMBufferTargetIdx^1] == 1)
-                while(aPCMBuffer_Full[u8PCMBufferTargetIdx^1]);
-        }
+        /* a short block at the end of the file is played as is */
+        AOUT_PutBuffer(ReturnSize / 4);
+    }
 
-        u8PCMBufferTargetIdx ^= 1;
+    /* play out the queued blocks, also when the file was shorter than the buffers */
+    if(!AOUT_IsPlaying() && AOUT_GetQueued())
+        AOUT_Start();
+    while(AOUT_GetQueued());
 
-        //printf("change to ==>%d\n", u8PCMBufferTargetIdx);
-    }
+    AOUT_GetStat(&sStat, 1);
+    AOUT_Close();
+    printf("Played %d ms, %d underruns (%d ms), min. queued %d\n",
+           sStat.u32PlayMs, sStat.u32Underruns, sStat.u32UnderrunMs, sStat.u32MinQueued);
 
     printf("Done..\n");
-    I2S_DISABLE_TX(I2S0);
-    I2S_DISABLE_TXDMA(I2S0);
     f_close(&wavFileObject);
-    bAudioPlaying = 0;
-    aPCMBuffer_Full[0] = 0;
-    aPCMBuffer_Full[1] = 0; 
 }
 
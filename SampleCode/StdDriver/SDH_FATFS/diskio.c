@@ -30,6 +30,43 @@ uint32_t Tmp_Buffer[Sector_Size];
 
 /* Definitions of physical drive number for each media */
 
+
+/*-----------------------------------------------------------------------*/
+/* Queue a request and wait for it. The multiple block command stays     */
+/* open afterwards, so a following contiguous run streams on without     */
+/* selecting the card again. CTRL_SYNC stops it.                         */
+/*-----------------------------------------------------------------------*/
+
+static void disk_req_done(SDH_REQ_T *psReq)
+{
+    *(volatile uint32_t *)psReq->pvUserData = 1;
+}
+
+static DRESULT disk_queue_io(SDH_T *sdh, uint32_t u32Dir, BYTE *buff, DWORD sector, UINT count)
+{
+    SDH_REQ_T sReq;
+    volatile uint32_t u32Done = 0;
+
+    sReq.u32Dir = u32Dir;
+    sReq.pu8BufAddr = buff;
+    sReq.u32StartSec = sector;
+    sReq.u32SecCount = count;
+    sReq.pfnComplete = disk_req_done;
+    sReq.pvUserData = (void *)&u32Done;
+
+    if (SDH_SubmitRequest(sdh, &sReq) != Successful)
+        return RES_ERROR;
+
+    while (!u32Done)
+    {
+        /* the request can't finish without the card, abort it */
+        if (!SDH_IS_CARD_PRESENT(sdh))
+            SDH_FlushQueue(sdh);
+    }
+
+    return (sReq.i32Status == Successful) ? RES_OK : RES_ERROR;
+}
+
 /*-----------------------------------------------------------------------*/
 /* Initialize a Drive                                                    */
 /*-----------------------------------------------------------------------*/
@@ -113,7 +150,7 @@ DRESULT disk_read (
             }
         }
         else
-            ret = (DRESULT) SDH_Read(SDH0, buff, sector, count);
+            ret = disk_queue_io(SDH0, SDH_REQ_READ, buff, sector, count);
     }
     else if (pdrv == 1)
     {
@@ -134,7 +171,7 @@ DRESULT disk_read (
             }
         }
         else
-            ret = (DRESULT) SDH_Read(SDH1, buff, sector, count);
+            ret = disk_queue_io(SDH1, SDH_REQ_READ, buff, sector, count);
     }
     return ret;
 }
@@ -187,7 +224,7 @@ DRESULT disk_write (
             }
         }
         else
-            ret = (DRESULT) SDH_Write(SDH0, (uint8_t *)buff, sector, count);
+            ret = disk_queue_io(SDH0, SDH_REQ_WRITE, (BYTE *)buff, sector, count);
     }
     else if (pdrv == 1)
     {
@@ -213,7 +250,7 @@ DRESULT disk_write (
             }
         }
         else
-            ret = (DRESULT) SDH_Write(SDH1, (uint8_t *)buff, sector, count);
+            ret = disk_queue_io(SDH1, SDH_REQ_WRITE, (BYTE *)buff, sector, count);
     }
 
     return ret;
@@ -236,6 +273,8 @@ DRESULT disk_ioctl (
     switch(cmd)
     {
     case CTRL_SYNC:
+        if (SDH_FlushQueue((pdrv == 1) ? SDH1 : SDH0) != Successful)
+            res = RES_ERROR;
         break;
     case GET_SECTOR_COUNT:
         *(DWORD*)buff = SD0.totalSectorN;
@@ -12,6 +12,9 @@
 #include "NuMicro.h"
 #include "diskio.h"
 #include "ff.h"
+#if FF_USE_CACHE
+#include "ffcache.h"
+#endif
 
 #define DEF_CARD_DETECT_SOURCE       CardDetect_From_GPIO
 //#define DEF_CARD_DETECT_SOURCE       CardDetect_From_DAT3
@@ -310,6 +313,8 @@ void SDH0_IRQHandler(void)
         // block down
         SD0.DataReadyFlag = TRUE;
         SDH0->INTSTS = SDH_INTSTS_BLKDIF_Msk;
+        // go on with queued requests of disk_read()/disk_write()
+        SDH_QueueHandler(SDH0);
     }
 
     if ((ier & SDH_INTEN_CDIEN_Msk) &&
@@ -589,6 +594,35 @@ int32_t main(void)
                 printf("rc=%d\n", disk_write(SD_Drv, Buff, p2, p3));
                 break;
 
+            case 's' :  /* bs <sector> <n> [<write>] - Measure raw streaming speed */
+                if (!xatoi(&ptr, &p2) || !xatoi(&ptr, &p3)) break;
+                if (!xatoi(&ptr, &p1)) p1 = 0;
+                res = FR_OK;
+                ofs = get_timer_value();
+                for (cnt = 0; cnt < (UINT)p3; cnt += s1)
+                {
+                    s1 = (UINT)p3 - cnt;
+                    if (s1 > BUFF_SIZE / 512) s1 = BUFF_SIZE / 512;
+                    if (p1)
+                        res = (FRESULT)disk_write(SD_Drv, Buff, p2 + cnt, s1);
+                    else
+                        res = (FRESULT)disk_read(SD_Drv, Buff, p2 + cnt, s1);
+                    if (res) break;
+                }
+                if (disk_ioctl(SD_Drv, CTRL_SYNC, 0) && !res) res = FR_DISK_ERR;
+                ofs = get_timer_value() - ofs;    /* ms */
+                if (res)
+                {
+                    printf("rc=%d\n", (WORD)res);
+                    break;
+                }
+                if (ofs == 0) ofs = 1;
+                sect = (DWORD)(((uint64_t)cnt * 512) / ofs);   /* bytes per ms */
+                printf("%u sectors %s in %lu ms, %lu.%02lu MB/sec.\n", cnt, p1 ? "written" : "read",
+                       ofs, sect / 1000, (sect % 1000) / 10);
+                sect = p2 + cnt;
+                break;
+
             case 'f' :  /* bf <n> - Fill working buffer */
                 if (!xatoi(&ptr, &p1)) break;
                 memset(Buff, (int)p1, BUFF_SIZE);
@@ -726,7 +760,7 @@ int32_t main(void)
             case 'r' :  /* fr <len> - read file */
                 if (!xatoi(&ptr, &p1)) break;
                 p2 = 0;
-//                timer_init();
+                p3 = get_timer_value();
                 while (p1)
                 {
                     if ((UINT)p1 >= blen)
@@ -748,16 +782,16 @@ int32_t main(void)
                     p2 += s2;
                     if (cnt != s2) break;
                 }
-//                p1 = get_timer_value()/1000;
+                p1 = get_timer_value() - p3;
                 if (p1)
-                    printf("%lu bytes read with %lu kB/sec.\n", p2, ((p2 * 100) / p1)/1024);
+                    printf("%lu bytes read with %lu kB/sec.\n", p2, p2 / p1);
                 break;
 
             case 'w' :  /* fw <len> <val> - write file */
                 if (!xatoi(&ptr, &p1) || !xatoi(&ptr, &p2)) break;
                 memset(Buff, (BYTE)p2, blen);
                 p2 = 0;
-//                timer_init();
+                p3 = get_timer_value();
                 while (p1)
                 {
                     if ((UINT)p1 >= blen)
@@ -779,10 +813,53 @@ int32_t main(void)
                     p2 += s2;
                     if (cnt != s2) break;
                 }
-//                p1 = get_timer_value()/1000;
+                p1 = get_timer_value() - p3;
                 if (p1)
-                    printf("%lu bytes written with %lu kB/sec.\n", p2, ((p2 * 100) / p1)/1024);
+                    printf("%lu bytes written with %lu kB/sec.\n", p2, p2 / p1);
+                break;
+
+            case 'b' :  /* fb <files> <lines> - Log lines to files, each line appended and synced */
+            {
+                char log[40];
+                UINT bw;
+
+                if (!xatoi(&ptr, &p1) || !xatoi(&ptr, &p2)) break;
+#if FF_USE_CACHE
+                ff_cache_stat(SD_Drv, 0, 1);
+#endif
+                res = FR_OK;
+                p3 = get_timer_value();
+                for (s1 = 0; s1 < (UINT)p1 && res == FR_OK; s1++)
+                {
+                    sprintf(log, "LOG%05u.TXT", s1);
+                    res = f_open(&file2, log, FA_WRITE | FA_OPEN_APPEND);
+                    if (res) break;
+                    for (s2 = 0; s2 < (UINT)p2 && res == FR_OK; s2++)
+                    {
+                        cnt = sprintf(log, "%08lu log line %u\r\n", (unsigned long)get_timer_value(), s2);
+                        res = f_write(&file2, log, cnt, &bw);
+                        if (res == FR_OK) res = f_sync(&file2);
+                    }
+                    f_close(&file2);
+                }
+                p3 = get_timer_value() - p3;
+                if (res)
+                {
+                    put_rc(res);
+                    break;
+                }
+                printf("%lu lines to %lu files in %lu ms.\n", p1 * p2, p1, p3);
+#if FF_USE_CACHE
+                {
+                    FFCACHE_STAT st;
+
+                    ff_cache_stat(SD_Drv, &st, 0);
+                    printf("Cache read hit/miss = %lu/%lu, write hit/miss = %lu/%lu, written back = %lu\n",
+                           st.rd_hit, st.rd_miss, st.wr_hit, st.wr_miss, st.wr_back);
+                }
+#endif
                 break;
+            }
 
             case 'n' :  /* fn <old_name> <new_name> - Change file/dir name */
                 while (*ptr == ' ') ptr++;
@@ -902,6 +979,7 @@ int32_t main(void)
                 _T("br <pd#> <sect> [<num>] - Read disk into working buffer\n")
                 _T("bw <pd#> <sect> [<num>] - Write working buffer into disk\n")
                 _T("bf <val> - Fill working buffer\n")
+                _T("bs <sect> <num> [<1:write>] - Measure raw sector read/write speed\n")
                 _T("\n")
                 _T("fs - Show volume status\n")
                 _T("fl [<path>] - Show a directory\n")
@@ -912,6 +990,7 @@ int32_t main(void)
                 _T("fd <len> - Read and dump the file\n")
                 _T("fr <len> - Read the file\n")
                 _T("fw <len> <val> - Write to the file\n")
+                _T("fb <files> <lines> - Log lines to files, show time and cache counters\n")
                 _T("fn <object name> <new name> - Rename an object\n")
                 _T("fu <object name> - Unlink an object\n")
                 _T("fv - Truncate the file at current fp\n")
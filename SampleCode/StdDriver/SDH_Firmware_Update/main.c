@@ -175,6 +175,8 @@ void SYS_Init(void)
     /* Enable IP clock */
     CLK_EnableModuleClock(SDH0_MODULE);
     CLK_EnableModuleClock(UART0_MODULE);
+    CLK_EnableModuleClock(CRC_MODULE);
+    CLK_EnableModuleClock(PDMA_MODULE);
 
     /* User can use SystemCoreClockUpdate() to calculate PllClock, SystemCoreClock and CycylesPerUs automatically. */
     SystemCoreClockUpdate();
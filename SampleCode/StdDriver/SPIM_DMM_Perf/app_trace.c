@@ -0,0 +1,166 @@
+/**************************************************************************//**
+ * @file     app_trace.c
+ * @version  V1.00
+ * @brief    Simulated instruction fetch trace of an application in SPIM flash.
+ *
+ *           The application is a table of functions with the sizes a map file
+ *           would list, laid out in SPIM flash in table order, and a 1 ms tick
+ *           that calls them in chains: control loop, network receive, logging,
+ *           display, hashing and file system. Its code is larger than the SPIM
+ *           cache, so the profile shows which functions cause the misses.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "NuMicro.h"
+#include "spim_prof.h"
+#include "app_trace.h"
+
+enum
+{
+    F_SYSTICK, F_SCHED, F_SELFTEST, F_ADC_ISR, F_FILTER_Q15, F_PID, F_PWM_UPDATE,
+    F_CONFIG_LOAD, F_UART_ISR, F_UART_WRITE, F_LOG_PRINTF, F_VSNPRINTF, F_ETH_ISR,
+    F_EMAC_RX, F_PBUF_ALLOC, F_MEMCPY, F_IP_INPUT, F_TCP_INPUT, F_TCP_OUTPUT,
+    F_APP_PARSE, F_JSON_PARSE, F_SHA256, F_LCD_TEXT, F_FONT_LOOKUP, F_LCD_BLIT,
+    F_FS_WRITE, F_FS_ALLOC, F_SDH_WRITE, F_NUM
+};
+
+/* Sizes as in a map file; addresses are assigned by AppTrace_Init */
+static SPROF_FUNC_T s_asFunc[F_NUM] =
+{
+    {"SysTick_Handler", 0,   96},
+    {"sched_run",       0,  620},
+    {"selftest",        0, 9800},
+    {"ADC_IRQHandler",  0,  180},
+    {"filter_q15",      0,  740},
+    {"pid_update",      0,  460},
+    {"pwm_update",      0,  310},
+    {"config_load",     0, 7400},
+    {"UART_IRQHandler", 0,  420},
+    {"uart_write",      0,  260},
+    {"log_printf",      0,  340},
+    {"vsnprintf_core",  0, 3600},
+    {"EMAC_IRQHandler", 0,  240},
+    {"emac_rx",         0, 1150},
+    {"pbuf_alloc",      0,  690},
+    {"memcpy",          0,  380},
+    {"ip_input",        0, 2300},
+    {"tcp_input",       0, 5200},
+    {"tcp_output",      0, 3900},
+    {"app_parse",       0, 2700},
+    {"json_parse",      0, 4400},
+    {"sha256_block",    0, 2900},
+    {"lcd_draw_text",   0, 1300},
+    {"font_lookup",     0,  520},
+    {"lcd_blit",        0, 1800},
+    {"fs_write",        0, 6100},
+    {"fs_alloc_cluster", 0, 2200},
+    {"sdh_write",       0, 1700},
+};
+
+static uint32_t s_u32Seed;
+
+static uint32_t AppTrace_Rand(uint32_t u32Range)
+{
+    s_u32Seed = s_u32Seed * 1664525 + 1013904223;
+    return (s_u32Seed >> 8) % u32Range;
+}
+
+/**
+  * @brief      Lay out the simulated application in SPIM flash.
+  * @param      ppsFunc     Function table for SPROF_Init
+  * @param      pu32End     End of the code
+  * @return     Number of functions
+  */
+uint32_t AppTrace_Init(SPROF_FUNC_T **ppsFunc, uint32_t *pu32End)
+{
+    uint32_t i, u32Addr = SPIM_DMM_MAP_ADDR + 0x100;
+
+    for (i = 0; i < F_NUM; i++)
+    {
+        s_asFunc[i].u32Addr = u32Addr;
+        s_asFunc[i].u32InSram = 0;
+        u32Addr += (s_asFunc[i].u32Size + 3) & ~3UL;
+    }
+    *ppsFunc = s_asFunc;
+    *pu32End = u32Addr;
+    return F_NUM;
+}
+
+/**
+  * @brief      Feed the fetches of the simulated application to the profiler.
+  * @param      psProf      Profiler set up by SPROF_Init with the AppTrace_Init table
+  * @param      u32Ticks    1 ms ticks to run
+  * @return     None
+  * @details    The same seed is used on every run, so runs with different settings see the same trace.
+  */
+void AppTrace_Run(SPROF_T *psProf, uint32_t u32Ticks)
+{
+    uint32_t t, i;
+
+    s_u32Seed = 1;
+
+    SPROF_Call(psProf, F_CONFIG_LOAD);
+    SPROF_Call(psProf, F_SELFTEST);
+
+    for (t = 0; t < u32Ticks; t++)
+    {
+        SPROF_Call(psProf, F_SYSTICK);
+        SPROF_Call(psProf, F_SCHED);
+
+        /* Control loop, every tick */
+        SPROF_Call(psProf, F_ADC_ISR);
+        SPROF_Call(psProf, F_FILTER_Q15);
+        SPROF_Call(psProf, F_PID);
+        SPROF_Call(psProf, F_PWM_UPDATE);
+
+        if ((t & 3) == 0)
+            SPROF_Call(psProf, F_UART_ISR);
+
+        /* A packet in one tick of three */
+        if (AppTrace_Rand(3) == 0)
+        {
+            SPROF_Call(psProf, F_ETH_ISR);
+            SPROF_Call(psProf, F_EMAC_RX);
+            SPROF_Call(psProf, F_PBUF_ALLOC);
+            SPROF_Call(psProf, F_MEMCPY);
+            SPROF_Call(psProf, F_IP_INPUT);
+            SPROF_Call(psProf, F_TCP_INPUT);
+            SPROF_Call(psProf, F_APP_PARSE);
+            SPROF_Call(psProf, F_JSON_PARSE);
+            SPROF_Call(psProf, F_TCP_OUTPUT);
+            SPROF_Call(psProf, F_MEMCPY);
+        }
+
+        if ((t % 16) == 0)
+        {
+            SPROF_Call(psProf, F_LOG_PRINTF);
+            SPROF_Call(psProf, F_VSNPRINTF);
+            SPROF_Call(psProf, F_UART_WRITE);
+        }
+
+        if ((t % 20) == 0)
+        {
+            SPROF_Call(psProf, F_LCD_TEXT);
+            for (i = 0; i < 8; i++)
+                SPROF_Call(psProf, F_FONT_LOOKUP);
+            SPROF_Call(psProf, F_LCD_BLIT);
+        }
+
+        if (AppTrace_Rand(50) == 0)
+        {
+            for (i = 0; i < 4; i++)
+                SPROF_Call(psProf, F_SHA256);
+        }
+
+        if ((t % 100) == 0)
+        {
+            SPROF_Call(psProf, F_FS_WRITE);
+            SPROF_Call(psProf, F_FS_ALLOC);
+            SPROF_Call(psProf, F_SDH_WRITE);
+        }
+    }
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
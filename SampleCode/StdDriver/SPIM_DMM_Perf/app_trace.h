@@ -0,0 +1,25 @@
+/**************************************************************************//**
+ * @file     app_trace.h
+ * @version  V1.00
+ * @brief    Simulated instruction fetch trace of an application in SPIM flash
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __APP_TRACE_H__
+#define __APP_TRACE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+uint32_t AppTrace_Init(SPROF_FUNC_T **ppsFunc, uint32_t *pu32End);
+void AppTrace_Run(SPROF_T *psProf, uint32_t u32Ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __APP_TRACE_H__ */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,231 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Tune SPIM DMM mode for code running on SPI flash. Time a workload on
+ *           SPI flash under several cache and read settings, run its hot filter
+ *           from SRAM, and profile DMM cache misses per function of a simulated
+ *           application to choose the functions for SRAM.
+ *
+ *           Program SPIM.bin at SPI flash offset 0 and SPIM_HOT.bin at offset
+ *           0x10000 (SPIM_HOT_LOAD_ADDR) besides APROM.bin.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "NuMicro.h"
+#include "spim_hot.h"
+#include "spim_prof.h"
+#include "app_trace.h"
+
+#define WORKLOAD_ROUNDS     16          /* workload rounds per measurement */
+#define TRACE_TICKS         2000        /* 1 ms ticks of the simulated application */
+#define SRAM_BUDGET         0x2000      /* SRAM bytes offered to the simulated application */
+
+uint32_t spim_workload(uint32_t u32Rounds, uint32_t u32HotFir);
+
+typedef struct
+{
+    char *pcName;
+    SPIM_DMM_CFG_T sCfg;
+} DMM_SETTING_T;
+
+/* Read command, 4-byte address, idle, cache, options, mode bits, dummy cycles, deselect time */
+static const DMM_SETTING_T s_asSetting[] =
+{
+    {"0x0B fast read, cache off",       {CMD_DMA_FAST_READ, 0, 0, SPIM_DMM_CACHE_OFF, 0, SPIM_DMM_DEFAULT, SPIM_DMM_DEFAULT, SPIM_DMM_DEFAULT}},
+    {"0x0B fast read, cache on",        {CMD_DMA_FAST_READ, 0, 0, SPIM_DMM_CACHE_ON, 0, SPIM_DMM_DEFAULT, SPIM_DMM_DEFAULT, SPIM_DMM_DEFAULT}},
+    {"0xBB dual I/O, cache on",         {CMD_DMA_FAST_DUAL_READ, 0, 0, SPIM_DMM_CACHE_ON, 0, SPIM_DMM_DEFAULT, SPIM_DMM_DEFAULT, SPIM_DMM_DEFAULT}},
+    {"0xEB quad I/O, cache on",         {CMD_DMA_FAST_QUAD_READ, 0, 0, SPIM_DMM_CACHE_ON, 0, SPIM_DMM_DEFAULT, SPIM_DMM_DEFAULT, SPIM_DMM_DEFAULT}},
+    {"0xEB + continuous + burst wrap",  {CMD_DMA_FAST_QUAD_READ, 0, 0, SPIM_DMM_CACHE_ON, SPIM_DMM_OPT_CONT_READ | SPIM_DMM_OPT_BURST_WRAP, SPIM_DMM_DEFAULT, SPIM_DMM_DEFAULT, SPIM_DMM_DEFAULT}},
+};
+
+#define SETTING_NUM     (sizeof(s_asSetting) / sizeof(s_asSetting[0]))
+
+static SPROF_T s_sProf;
+
+void SYS_Init(void)
+{
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Set XT1_OUT(PF.2) and XT1_IN(PF.3) to input mode */
+    PF->MODE &= ~(GPIO_MODE_MODE2_Msk | GPIO_MODE_MODE3_Msk);
+
+    /* Enable HXT clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HXTEN_Msk);
+
+    /* Wait for HXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HXTSTB_Msk);
+
+    /* Switch HCLK clock source to HXT */
+    CLK_SetHCLK(CLK_CLKSEL0_HCLKSEL_HXT,CLK_CLKDIV0_HCLK(1));
+
+    /* Set core clock (HCLK) as 160MHz from PLL. SPIM clock run at 80 MHz.            */
+    /* The maximum frequency of W25Q20 SPI flash is 80 MHz.                           */
+    /* SPIM clock source is HCLK. This will configue SPIM clock as HCLK divided by 2. */
+    CLK_SetCoreClock(FREQ_160MHZ);
+
+    /* Set both PCLK0 and PCLK1 as HCLK/2 */
+    CLK->PCLKDIV = CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2;
+
+    /* Enable UART module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART module clock source as HXT and UART module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HXT, CLK_CLKDIV0_UART0(1));
+
+    /* Enable SPIM module clock */
+    CLK_EnableModuleClock(SPIM_MODULE);
+
+    /* Update System Core Clock */
+    SystemCoreClockUpdate();
+
+    /* Set GPB multi-function pins for UART0 RXD and TXD */
+    SYS->GPB_MFPH &= ~(SYS_GPB_MFPH_PB12MFP_Msk | SYS_GPB_MFPH_PB13MFP_Msk);
+    SYS->GPB_MFPH |= (SYS_GPB_MFPH_PB12MFP_UART0_RXD | SYS_GPB_MFPH_PB13MFP_UART0_TXD);
+
+    /* Init SPIM multi-function pins, MOSI(PC.0), MISO(PC.1), CLK(PC.2), SS(PC.3), D3(PC.4), and D2(PC.5) */
+    SYS->GPC_MFPL &= ~(SYS_GPC_MFPL_PC0MFP_Msk | SYS_GPC_MFPL_PC1MFP_Msk | SYS_GPC_MFPL_PC2MFP_Msk |
+                       SYS_GPC_MFPL_PC3MFP_Msk | SYS_GPC_MFPL_PC4MFP_Msk | SYS_GPC_MFPL_PC5MFP_Msk);
+    SYS->GPC_MFPL |= SYS_GPC_MFPL_PC0MFP_SPIM_MOSI | SYS_GPC_MFPL_PC1MFP_SPIM_MISO |
+                     SYS_GPC_MFPL_PC2MFP_SPIM_CLK | SYS_GPC_MFPL_PC3MFP_SPIM_SS |
+                     SYS_GPC_MFPL_PC4MFP_SPIM_D3 | SYS_GPC_MFPL_PC5MFP_SPIM_D2;
+    PC->SMTEN |= GPIO_SMTEN_SMTEN2_Msk;
+
+    /* Set SPIM I/O pins as high slew rate up to 80 MHz. */
+    PC->SLEWCTL = (PC->SLEWCTL & 0xFFFFF000) |
+                  (0x1<<GPIO_SLEWCTL_HSREN0_Pos) | (0x1<<GPIO_SLEWCTL_HSREN1_Pos) |
+                  (0x1<<GPIO_SLEWCTL_HSREN2_Pos) | (0x1<<GPIO_SLEWCTL_HSREN3_Pos) |
+                  (0x1<<GPIO_SLEWCTL_HSREN4_Pos) | (0x1<<GPIO_SLEWCTL_HSREN5_Pos);
+
+    /* Lock protected registers */
+    SYS_LockReg();
+}
+
+void UART0_Init(void)
+{
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+/* Time the workload on SPI flash under every setting, then with the filter in SRAM */
+static void Test_Timing(void)
+{
+    uint32_t i, u32Start, u32Cycles, u32Sum, u32Ref = 0;
+
+    printf("\nWorkload timing, %d rounds\n", WORKLOAD_ROUNDS);
+
+    for (i = 0; i < SETTING_NUM; i++)
+    {
+        if (SPIM_DMM_Configure(&s_asSetting[i].sCfg) != 0)
+        {
+            printf("  %-34s not supported\n", s_asSetting[i].pcName);
+            continue;
+        }
+
+        u32Start = DWT->CYCCNT;
+        u32Sum = spim_workload(WORKLOAD_ROUNDS, 0);
+        u32Cycles = DWT->CYCCNT - u32Start;
+        if (i == 0)
+            u32Ref = u32Sum;
+        printf("  %-34s %10d cycles%s\n", s_asSetting[i].pcName, u32Cycles, (u32Sum == u32Ref) ? "" : "  checksum error!");
+
+        u32Start = DWT->CYCCNT;
+        u32Sum = spim_workload(WORKLOAD_ROUNDS, 1);
+        u32Cycles = DWT->CYCCNT - u32Start;
+        printf("  %-34s %10d cycles%s\n", "  with filter in SRAM", u32Cycles, (u32Sum == u32Ref) ? "" : "  checksum error!");
+    }
+}
+
+/* Profile the simulated application under three settings, then with hot functions in SRAM */
+static void Test_Profile(void)
+{
+    SPROF_FUNC_T *psFunc;
+    uint32_t i, u32Num, u32End, u32Used;
+    uint32_t au32Setting[] = {0, 1, SETTING_NUM - 1};
+
+    u32Num = AppTrace_Init(&psFunc, &u32End);
+    SPROF_Init(&s_sProf, psFunc, u32Num, u32End);
+
+    printf("\nSimulated application: %d functions, %d bytes of code, %d ms trace\n",
+           u32Num, u32End - SPIM_DMM_MAP_ADDR, TRACE_TICKS);
+
+    for (i = 0; i < sizeof(au32Setting) / sizeof(au32Setting[0]); i++)
+    {
+        printf("\n[%s]\n", s_asSetting[au32Setting[i]].pcName);
+        SPROF_SetTiming(&s_sProf, &s_asSetting[au32Setting[i]].sCfg, SPIM_GET_CLOCK_DIVIDER());
+        SPROF_Reset(&s_sProf);
+        AppTrace_Run(&s_sProf, TRACE_TICKS);
+        SPROF_Report(&s_sProf, 8);
+    }
+
+    u32Used = SPROF_PlanSram(&s_sProf, SRAM_BUDGET);
+    printf("\nTag SPIM_HOT to move %d bytes to SRAM:\n ", u32Used);
+    for (i = 0; i < u32Num; i++)
+    {
+        if (psFunc[i].u32InSram)
+            printf(" %s", psFunc[i].pcName);
+    }
+    printf("\n\n[%s, hot functions in SRAM]\n", s_asSetting[SETTING_NUM - 1].pcName);
+    SPROF_Reset(&s_sProf);
+    AppTrace_Run(&s_sProf, TRACE_TICKS);
+    SPROF_Report(&s_sProf, 8);
+}
+
+int main()
+{
+    uint8_t     idBuf[3];
+    uint32_t    u32Size;
+
+    SYS_Init();                        /* Init System, IP clock and multi-function I/O    */
+
+    UART0_Init();                      /* Initialize UART0                                */
+
+    printf("+--------------------------------------------------+\n");
+    printf("|    M480 SPIM DMM mode performance tuning         |\n");
+    printf("+--------------------------------------------------+\n");
+
+    SYS_UnlockReg();                   /* Unlock protected registers                      */
+
+    SPIM_SET_CLOCK_DIVIDER(1);        /* Set SPIM clock as HCLK divided by 2 */
+
+    SPIM_SET_RXCLKDLY_RDDLYSEL(0);    /* Insert 0 delay cycle. Adjust the sampling clock of received data to latch the correct data. */
+    SPIM_SET_RXCLKDLY_RDEDGE();       /* Use SPI input clock rising edge to sample received data. */
+
+    if (SPIM_InitFlash(1) != 0)        /* Initialized SPI flash */
+    {
+        printf("SPIM flash initialize failed!\n");
+        while (1);
+    }
+
+    SPIM_ReadJedecId(idBuf, sizeof (idBuf), 1);
+    printf("SPIM get JEDEC ID=0x%02X, 0x%02X, 0x%02X\n", idBuf[0], idBuf[1], idBuf[2]);
+
+    SPIM_DISABLE_CIPHER();
+
+    SPIM_SetQuadEnable(1, 1);          /* Dual and quad read commands need the quad mode of the flash */
+
+    if (SPIM_DMM_Configure(&s_asSetting[1].sCfg) != 0)
+    {
+        printf("SPIM DMM setting failed!\n");
+        while (1);
+    }
+
+    /* DMM mode is on, hot functions can be copied to SRAM */
+    u32Size = SPIM_HotCopy();
+    printf("%d bytes of hot code copied to SRAM 0x%08X\n", u32Size, SPIM_HOT_EXEC_ADDR);
+
+    /* Cycle counter for timing */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    Test_Timing();
+    Test_Profile();
+
+    printf("\nDone.\n");
+    while (1);
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,126 @@
+/**************************************************************************//**
+ * @file     spim_code.c
+ * @version  V1.00
+ * @brief    Benchmark workload running on SPIM flash. spim_fir_hot is the same
+ *           filter as spim_fir, placed in SRAM by SPIM_HOT.
+ *
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "NuMicro.h"
+#include "spim_hot.h"
+
+#define WL_LEN          256
+#define WL_TAPS         16
+#define WL_SORT_LEN     64
+
+/* In SRAM, so both filters read the same memory */
+static int16_t s_ai16Coef[WL_TAPS] =
+{
+    -120, -310, -280, 390, 1640, 3330, 4880, 5620,
+    5620, 4880, 3330, 1640, 390, -280, -310, -120
+};
+
+static int16_t s_ai16In[WL_LEN + WL_TAPS];
+static int16_t s_ai16Out[WL_LEN];
+static int32_t s_ai32Sort[WL_SORT_LEN];
+
+#define WL_IN_FLASH     /* default placement, with spim_code.o in SPI flash */
+
+/* One Q15 FIR body, built once for SPI flash and once for SRAM */
+#define WL_FIR(attr, name)                                                          \
+attr int32_t name(const int16_t *pi16In, int16_t *pi16Out, uint32_t u32Len)        \
+{                                                                                   \
+    uint32_t i, j;                                                                  \
+    int32_t i32Acc, i32Sum = 0;                                                     \
+                                                                                    \
+    for (i = 0; i < u32Len; i++)                                                    \
+    {                                                                               \
+        i32Acc = 0;                                                                 \
+        for (j = 0; j < WL_TAPS; j++)                                               \
+            i32Acc += pi16In[i + j] * s_ai16Coef[j];                                \
+        pi16Out[i] = (int16_t)(i32Acc >> 15);                                       \
+        i32Sum += pi16Out[i];                                                       \
+    }                                                                               \
+    return i32Sum;                                                                  \
+}
+
+WL_FIR(WL_IN_FLASH, spim_fir)
+WL_FIR(SPIM_HOT, spim_fir_hot)
+
+/*
+ *  Fill the input with a pseudo random signal
+ */
+static void spim_gen(int16_t *pi16Buf, uint32_t u32Len, uint32_t u32Seed)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Len; i++)
+    {
+        u32Seed = u32Seed * 1103515245 + 12345;
+        pi16Buf[i] = (int16_t)(u32Seed >> 16) >> 2;
+    }
+}
+
+/*
+ *  CRC-16/CCITT, bit by bit
+ */
+static uint32_t spim_crc16(const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint32_t i, u32Crc = 0xFFFF;
+
+    while (u32Len--)
+    {
+        u32Crc ^= (uint32_t)*pu8Buf++ << 8;
+        for (i = 0; i < 8; i++)
+            u32Crc = (u32Crc & 0x8000) ? ((u32Crc << 1) ^ 0x1021) : (u32Crc << 1);
+    }
+    return u32Crc & 0xFFFF;
+}
+
+/*
+ *  Insertion sort, returns the median
+ */
+static int32_t spim_median(int32_t *pi32Buf, uint32_t u32Len)
+{
+    uint32_t i, j;
+    int32_t i32Val;
+
+    for (i = 1; i < u32Len; i++)
+    {
+        i32Val = pi32Buf[i];
+        for (j = i; (j > 0) && (pi32Buf[j - 1] > i32Val); j--)
+            pi32Buf[j] = pi32Buf[j - 1];
+        pi32Buf[j] = i32Val;
+    }
+    return pi32Buf[u32Len / 2];
+}
+
+/*
+ *  Run the workload and return a checksum of its results, the same wherever the code runs.
+ */
+uint32_t spim_workload(uint32_t u32Rounds, uint32_t u32HotFir)
+{
+    uint32_t r, i, u32Sum = 0;
+
+    for (r = 0; r < u32Rounds; r++)
+    {
+        spim_gen(s_ai16In, WL_LEN + WL_TAPS, r);
+
+        if (u32HotFir)
+            u32Sum += (uint32_t)spim_fir_hot(s_ai16In, s_ai16Out, WL_LEN);
+        else
+            u32Sum += (uint32_t)spim_fir(s_ai16In, s_ai16Out, WL_LEN);
+
+        u32Sum += spim_crc16((uint8_t *)s_ai16Out, sizeof(s_ai16Out));
+
+        for (i = 0; i < WL_SORT_LEN; i++)
+            s_ai32Sort[i] = s_ai16Out[i * (WL_LEN / WL_SORT_LEN)];
+        u32Sum += (uint32_t)spim_median(s_ai32Sort, WL_SORT_LEN);
+    }
+    return u32Sum;
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,59 @@
+/**************************************************************************//**
+ * @file     spim_hot.c
+ * @version  V1.00
+ * @brief    Copy hot SPIM flash functions to SRAM at boot. Runs from APROM.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "NuMicro.h"
+#include "spim_hot.h"
+
+#if defined (__ICCARM__)
+#pragma section = ".spim_hot"
+#pragma section = ".spim_hot_init"
+#elif defined (__GNUC__) && !defined (__ARMCC_VERSION)
+extern uint32_t __spim_hot_load__[];
+extern uint32_t __spim_hot_start__[];
+extern uint32_t __spim_hot_end__[];
+#else
+extern uint32_t Load$$SPIM_HOT$$Base[];
+extern uint32_t Image$$SPIM_HOT$$Base[];
+extern uint32_t Image$$SPIM_HOT$$Length[];
+#endif
+
+/**
+  * @brief      Copy the SPIM_HOT section from SPI flash to SRAM.
+  * @return     Bytes copied.
+  * @details    SPIM must be in DMM mode. The section is read word by word through the
+  *             DMM window, then the CPU pipeline is flushed before any copied code runs.
+  */
+uint32_t SPIM_HotCopy(void)
+{
+    uint32_t *pu32Src, *pu32Dst;
+    uint32_t i, u32Size;
+
+#if defined (__ICCARM__)
+    pu32Src = (uint32_t *)__section_begin(".spim_hot_init");
+    pu32Dst = (uint32_t *)__section_begin(".spim_hot");
+    u32Size = __section_size(".spim_hot");
+#elif defined (__GNUC__) && !defined (__ARMCC_VERSION)
+    pu32Src = __spim_hot_load__;
+    pu32Dst = __spim_hot_start__;
+    u32Size = (uint32_t)__spim_hot_end__ - (uint32_t)__spim_hot_start__;
+#else
+    pu32Src = Load$$SPIM_HOT$$Base;
+    pu32Dst = Image$$SPIM_HOT$$Base;
+    u32Size = (uint32_t)Image$$SPIM_HOT$$Length;
+#endif
+
+    for (i = 0; i < (u32Size + 3) / 4; i++)
+        pu32Dst[i] = pu32Src[i];
+
+    __DSB();
+    __ISB();
+    return u32Size;
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,42 @@
+/**************************************************************************//**
+ * @file     spim_hot.h
+ * @version  V1.00
+ * @brief    Placement of hot SPIM flash functions in SRAM.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __SPIM_HOT_H__
+#define __SPIM_HOT_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ *  A function tagged SPIM_HOT is stored in SPI flash with the rest of spim_code.c, but
+ *  linked to run from SRAM at SPIM_HOT_EXEC_ADDR. SPIM_HotCopy() copies the section once
+ *  SPIM is in DMM mode; no SPIM_HOT function may be called before that.
+ *  The section is loaded at SPI flash offset SPIM_HOT_LOAD_ADDR - SPIM_DMM_MAP_ADDR.
+ *  Calls out of SRAM to flash go through linker veneers, so the best candidates are
+ *  leaf functions and inner loops. The addresses must match the linker files in KEIL, IAR and GCC.
+ */
+#define SPIM_HOT_LOAD_ADDR      0x08010000UL    /* load address of the hot section in SPI flash */
+#define SPIM_HOT_EXEC_ADDR      0x2001C000UL    /* run address of the hot section in SRAM */
+#define SPIM_HOT_SIZE           0x4000UL        /* SRAM reserved for hot code */
+
+#if defined (__ICCARM__)
+#define SPIM_HOT                _Pragma("location=\".spim_hot\"")
+#else
+#define SPIM_HOT                __attribute__((section(".spim_hot"), noinline))
+#endif
+
+uint32_t SPIM_HotCopy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __SPIM_HOT_H__ */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
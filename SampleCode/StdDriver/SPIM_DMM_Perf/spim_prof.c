@@ -0,0 +1,345 @@
+/**************************************************************************//**
+ * @file     spim_prof.c
+ * @version  V1.00
+ * @brief    Count SPIM DMM cache misses per function from an instruction fetch trace.
+ *
+ *           The SPIM cache is modelled as a set-associative LRU cache of 16-byte
+ *           lines. Every fetch of the trace is charged to the function holding its
+ *           address; a miss costs the HCLK cycles of one SPI flash read with the
+ *           DMM settings under test. Functions marked u32InSram are skipped, which
+ *           shows what moving them to SRAM with SPIM_HOT would save.
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "spim_prof.h"
+
+/* Function holding u32Addr, or NULL */
+static SPROF_FUNC_T *SPROF_Find(SPROF_T *psProf, uint32_t u32Addr)
+{
+    SPROF_FUNC_T *psFunc;
+    uint32_t u32Lo = 0, u32Hi = psProf->u32FuncNum, u32Mid;
+
+    /* Last function starting at or below u32Addr */
+    while (u32Hi - u32Lo > 1)
+    {
+        u32Mid = (u32Lo + u32Hi) / 2;
+        if (psProf->psFunc[psProf->au16Order[u32Mid]].u32Addr <= u32Addr)
+            u32Lo = u32Mid;
+        else
+            u32Hi = u32Mid;
+    }
+
+    if (psProf->u32FuncNum == 0)
+        return NULL;
+
+    psFunc = &psProf->psFunc[psProf->au16Order[u32Lo]];
+    if ((u32Addr < psFunc->u32Addr) || (u32Addr - psFunc->u32Addr >= psFunc->u32Size))
+        return NULL;
+    return psFunc;
+}
+
+/* Look up one line, fill it on a miss. Return 1 on a hit. */
+static uint32_t SPROF_Access(SPROF_T *psProf, uint32_t u32Line)
+{
+    uint32_t u32Set = u32Line % SPROF_SETS;
+    uint32_t i, u32Victim = 0;
+
+    psProf->u32Tick++;
+    for (i = 0; i < SPROF_WAYS; i++)
+    {
+        if (psProf->au32Used[u32Set][i] && (psProf->au32Tag[u32Set][i] == u32Line))
+        {
+            psProf->au32Used[u32Set][i] = psProf->u32Tick;
+            return 1;
+        }
+        if (psProf->au32Used[u32Set][i] < psProf->au32Used[u32Set][u32Victim])
+            u32Victim = i;
+    }
+
+    psProf->au32Tag[u32Set][u32Victim] = u32Line;
+    psProf->au32Used[u32Set][u32Victim] = psProf->u32Tick;
+    return 0;
+}
+
+/**
+  * @brief      Attach a function table to the profiler.
+  * @param      psProf      Profiler
+  * @param      psFunc      Functions. Entries with u32Size 0 get the distance to the next function.
+  * @param      u32FuncNum  Number of functions, up to SPROF_FUNC_MAX
+  * @param      u32End      End address of the last function, used when its size is 0
+  * @return     None
+  */
+void SPROF_Init(SPROF_T *psProf, SPROF_FUNC_T *psFunc, uint32_t u32FuncNum, uint32_t u32End)
+{
+    SPROF_FUNC_T *psCur;
+    uint32_t i, j;
+    uint16_t u16Idx;
+
+    if (u32FuncNum > SPROF_FUNC_MAX)
+        u32FuncNum = SPROF_FUNC_MAX;
+
+    psProf->psFunc = psFunc;
+    psProf->u32FuncNum = u32FuncNum;
+    psProf->u32CacheOn = 1;
+    psProf->u32MissStall = 1;
+    psProf->u32WordStall = 1;
+
+    /* Sort by address */
+    for (i = 0; i < u32FuncNum; i++)
+    {
+        psFunc[i].u32Addr &= ~1UL;
+        u16Idx = (uint16_t)i;
+        for (j = i; (j > 0) && (psFunc[psProf->au16Order[j - 1]].u32Addr > psFunc[u16Idx].u32Addr); j--)
+            psProf->au16Order[j] = psProf->au16Order[j - 1];
+        psProf->au16Order[j] = u16Idx;
+    }
+
+    for (i = 0; i < u32FuncNum; i++)
+    {
+        psCur = &psFunc[psProf->au16Order[i]];
+        if (psCur->u32Size == 0)
+            psCur->u32Size = ((i + 1 < u32FuncNum) ? psFunc[psProf->au16Order[i + 1]].u32Addr : u32End) - psCur->u32Addr;
+    }
+
+    SPROF_Reset(psProf);
+}
+
+/**
+  * @brief      Model the SPI flash read timing of a DMM configuration.
+  * @param      psProf      Profiler
+  * @param      psCfg       DMM settings as passed to SPIM_DMM_Configure
+  * @param      u32Divider  SPIM clock divider, SPIM_GET_CLOCK_DIVIDER()
+  * @return     None
+  */
+void SPROF_SetTiming(SPROF_T *psProf, const SPIM_DMM_CFG_T *psCfg, uint32_t u32Divider)
+{
+    psProf->u32CacheOn = (psCfg->u32CacheMode == SPIM_DMM_CACHE_ON);
+    /* Burst wrap hands the needed word over first */
+    psProf->u32MissStall = SPROF_ReadCycles(psCfg, u32Divider,
+                                            (psCfg->u32Opt & SPIM_DMM_OPT_BURST_WRAP) ? 4 : SPROF_LINE_SIZE);
+    psProf->u32WordStall = SPROF_ReadCycles(psCfg, u32Divider, 4);
+}
+
+/**
+  * @brief      Clear the counters and invalidate the modelled cache.
+  * @param      psProf      Profiler
+  * @return     None
+  */
+void SPROF_Reset(SPROF_T *psProf)
+{
+    uint32_t i;
+
+    for (i = 0; i < psProf->u32FuncNum; i++)
+    {
+        psProf->psFunc[i].u32Calls = 0;
+        psProf->psFunc[i].u32Fetch = 0;
+        psProf->psFunc[i].u32Miss = 0;
+        psProf->psFunc[i].u32Stall = 0;
+    }
+    psProf->u32Fetch = 0;
+    psProf->u32Miss = 0;
+    psProf->u32Stall = 0;
+    psProf->u32Outside = 0;
+    psProf->u32Tick = 0;
+    memset(psProf->au32Used, 0, sizeof(psProf->au32Used));
+}
+
+/**
+  * @brief      Feed a run of sequential instruction fetches.
+  * @param      psProf      Profiler
+  * @param      u32Addr     First fetched address
+  * @param      u32Len      Bytes fetched
+  * @return     None
+  */
+void SPROF_Fetch(SPROF_T *psProf, uint32_t u32Addr, uint32_t u32Len)
+{
+    SPROF_FUNC_T *psFunc;
+    uint32_t u32Step = psProf->u32CacheOn ? SPROF_LINE_SIZE : 4;
+    uint32_t u32Cur, u32End, u32Stall;
+
+    if (u32Len == 0)
+        return;
+
+    u32End = u32Addr + u32Len;
+    for (u32Cur = u32Addr; u32Cur < u32End; u32Cur = (u32Cur & ~(u32Step - 1)) + u32Step)
+    {
+        psFunc = SPROF_Find(psProf, u32Cur);
+        if (psFunc == NULL)
+        {
+            psProf->u32Outside++;
+            continue;
+        }
+        if (psFunc->u32InSram)
+            continue;
+
+        psFunc->u32Fetch++;
+        psProf->u32Fetch++;
+        if (psProf->u32CacheOn)
+        {
+            if (SPROF_Access(psProf, u32Cur / SPROF_LINE_SIZE))
+                continue;
+            u32Stall = psProf->u32MissStall;
+        }
+        else
+        {
+            u32Stall = psProf->u32WordStall;
+        }
+        psFunc->u32Miss++;
+        psFunc->u32Stall += u32Stall;
+        psProf->u32Miss++;
+        psProf->u32Stall += u32Stall;
+    }
+}
+
+/**
+  * @brief      Feed one call of a function, fetched from its first to its last byte.
+  * @param      psProf      Profiler
+  * @param      u32Func     Index into the function table given to SPROF_Init
+  * @return     None
+  * @details    Loops inside the function hit in the cache after their first pass, so
+  *             one straight pass gives the misses of a call when the cache is on.
+  */
+void SPROF_Call(SPROF_T *psProf, uint32_t u32Func)
+{
+    if (u32Func >= psProf->u32FuncNum)
+        return;
+
+    psProf->psFunc[u32Func].u32Calls++;
+    SPROF_Fetch(psProf, psProf->psFunc[u32Func].u32Addr, psProf->psFunc[u32Func].u32Size);
+}
+
+/**
+  * @brief      HCLK cycles the CPU waits for one DMM read.
+  * @param      psCfg       DMM settings as passed to SPIM_DMM_Configure
+  * @param      u32Divider  SPIM clock divider, SPIM clock = HCLK / (2 * u32Divider), 0 for HCLK
+  * @param      u32Bytes    Bytes read before the CPU continues
+  * @return     Cycles
+  * @details    Command, address, mode and dummy phases plus data, at the bus width of
+  *             each phase for the read command. Continuous read drops the command phase.
+  */
+uint32_t SPROF_ReadCycles(const SPIM_DMM_CFG_T *psCfg, uint32_t u32Divider, uint32_t u32Bytes)
+{
+    uint32_t u32Cmd = (psCfg->u32RdCmd & SPIM_CTL0_CMDCODE_Msk) >> SPIM_CTL0_CMDCODE_Pos;
+    uint32_t u32AddrW = 1, u32DataW = 1, u32Mode = 0, u32Dummy = 8, u32Clk;
+
+    switch (u32Cmd)
+    {
+        case 0x03:
+            u32Dummy = 0;
+            break;
+        case 0x3B:
+            u32DataW = 2;
+            break;
+        case 0x6B:
+            u32DataW = 4;
+            break;
+        case 0xBB:
+            u32AddrW = u32DataW = 2;
+            u32Mode = 1;
+            u32Dummy = 0;
+            break;
+        case 0xEB:
+            u32AddrW = u32DataW = 4;
+            u32Mode = 1;
+            u32Dummy = 4;
+            break;
+        case 0xE7:
+            u32AddrW = u32DataW = 4;
+            u32Mode = 1;
+            u32Dummy = 2;
+            break;
+        default:
+            break;
+    }
+    if (psCfg->u32DummyCycles != SPIM_DMM_DEFAULT)
+        u32Dummy = psCfg->u32DummyCycles;
+
+    u32Clk = ((psCfg->u32Opt & SPIM_DMM_OPT_CONT_READ) ? 0 : 8) +
+             (psCfg->u32Is4ByteAddr ? 32 : 24) / u32AddrW +
+             (u32Mode ? 8 / u32AddrW : 0) +
+             u32Dummy +
+             u32Bytes * 8 / u32DataW;
+
+    return u32Clk * (u32Divider ? 2 * u32Divider : 1) + SPROF_ACCESS_OVERHEAD;
+}
+
+/**
+  * @brief      Choose functions for SRAM from the last profile.
+  * @param      psProf      Profiler
+  * @param      u32Budget   SRAM bytes for hot code
+  * @return     Bytes of the functions chosen
+  * @details    Take functions by stall cycles per byte, highest first, while they fit,
+  *             and mark them u32InSram. Profile again to see the effect; fewer lines
+  *             competing for the cache also helps the functions left in flash.
+  */
+uint32_t SPROF_PlanSram(SPROF_T *psProf, uint32_t u32Budget)
+{
+    SPROF_FUNC_T *psFunc, *psBest;
+    uint32_t i, u32Used = 0, u32Size;
+
+    while (1)
+    {
+        psBest = NULL;
+        for (i = 0; i < psProf->u32FuncNum; i++)
+        {
+            psFunc = &psProf->psFunc[i];
+            u32Size = (psFunc->u32Size + 3) & ~3UL;
+            if (psFunc->u32InSram || (psFunc->u32Stall == 0) || (u32Used + u32Size > u32Budget))
+                continue;
+            /* a / sa > b / sb without division */
+            if ((psBest == NULL) ||
+                    ((uint64_t)psFunc->u32Stall * ((psBest->u32Size + 3) & ~3UL) > (uint64_t)psBest->u32Stall * u32Size))
+                psBest = psFunc;
+        }
+        if (psBest == NULL)
+            break;
+
+        psBest->u32InSram = 1;
+        u32Used += (psBest->u32Size + 3) & ~3UL;
+    }
+    return u32Used;
+}
+
+/**
+  * @brief      Print totals and the functions with the most stall cycles.
+  * @param      psProf      Profiler
+  * @param      u32Top      Functions to list
+  * @return     None
+  */
+void SPROF_Report(SPROF_T *psProf, uint32_t u32Top)
+{
+    SPROF_FUNC_T *psFunc;
+    uint16_t au16Rank[SPROF_FUNC_MAX];
+    uint32_t i, j, u32Hit, u32Share;
+
+    u32Hit = psProf->u32Fetch ? (uint32_t)((uint64_t)(psProf->u32Fetch - psProf->u32Miss) * 1000 / psProf->u32Fetch) : 0;
+    printf("  cache %s, %d cycles per %s read\n", psProf->u32CacheOn ? "on" : "off",
+           psProf->u32CacheOn ? psProf->u32MissStall : psProf->u32WordStall, psProf->u32CacheOn ? "line" : "word");
+    printf("  fetch %d, miss %d, hit rate %d.%d%%, stall %d cycles\n",
+           psProf->u32Fetch, psProf->u32Miss, u32Hit / 10, u32Hit % 10, psProf->u32Stall);
+
+    /* Rank by stall cycles */
+    for (i = 0; i < psProf->u32FuncNum; i++)
+    {
+        for (j = i; (j > 0) && (psProf->psFunc[au16Rank[j - 1]].u32Stall < psProf->psFunc[i].u32Stall); j--)
+            au16Rank[j] = au16Rank[j - 1];
+        au16Rank[j] = (uint16_t)i;
+    }
+
+    printf("  %-20s %6s %6s %8s %8s %10s %6s\n", "function", "size", "calls", "fetch", "miss", "stall", "share");
+    for (i = 0; (i < u32Top) && (i < psProf->u32FuncNum); i++)
+    {
+        psFunc = &psProf->psFunc[au16Rank[i]];
+        if (psFunc->u32Stall == 0)
+            break;
+        u32Share = (uint32_t)((uint64_t)psFunc->u32Stall * 1000 / psProf->u32Stall);
+        printf("  %-20s %6d %6d %8d %8d %10d %3d.%d%%\n", psFunc->pcName, psFunc->u32Size, psFunc->u32Calls,
+               psFunc->u32Fetch, psFunc->u32Miss, psFunc->u32Stall, u32Share / 10, u32Share % 10);
+    }
+}
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
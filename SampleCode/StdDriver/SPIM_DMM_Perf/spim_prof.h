@@ -0,0 +1,78 @@
+/**************************************************************************//**
+ * @file     spim_prof.h
+ * @version  V1.00
+ * @brief    SPIM DMM cache miss profiler header file
+ *
+ * @copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __SPIM_PROF_H__
+#define __SPIM_PROF_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Cache model                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#define SPROF_LINE_SIZE         SPIM_DMM_LINE_SIZE      /*!< Cache line size in bytes                       */
+#define SPROF_CACHE_SIZE        SPIM_CCM_SIZE           /*!< Modelled cache capacity in bytes               */
+#define SPROF_WAYS              4                       /*!< Modelled associativity, LRU replacement        */
+#define SPROF_SETS              (SPROF_CACHE_SIZE / SPROF_LINE_SIZE / SPROF_WAYS)
+#define SPROF_ACCESS_OVERHEAD   12                      /*!< HCLK cycles of SS deselect and AHB hand-over per SPI flash read */
+#define SPROF_FUNC_MAX          128                     /*!< Maximum functions in the profiled table        */
+
+/**
+  * @brief  One function of the profiled code
+  */
+typedef struct
+{
+    const char *pcName;         /*!< Function name                                            */
+    uint32_t u32Addr;           /*!< Start address, Thumb bit ignored                         */
+    uint32_t u32Size;           /*!< Size in bytes; 0 runs up to the next function            */
+    uint32_t u32InSram;         /*!< 1: runs from SRAM, its fetches never reach SPIM          */
+    uint32_t u32Calls;          /*!< Calls seen in the trace                                  */
+    uint32_t u32Fetch;          /*!< Cache line accesses, word accesses when the cache is off */
+    uint32_t u32Miss;           /*!< Accesses that read SPI flash                             */
+    uint32_t u32Stall;          /*!< HCLK cycles the CPU waited on those reads                */
+} SPROF_FUNC_T;
+
+/**
+  * @brief  Profiler state
+  */
+typedef struct
+{
+    SPROF_FUNC_T *psFunc;       /*!< Functions, in any order                                 */
+    uint32_t u32FuncNum;        /*!< Number of functions                                      */
+    uint32_t u32CacheOn;        /*!< 0: every word fetch reads SPI flash                      */
+    uint32_t u32MissStall;      /*!< HCLK cycles per cache line fill                          */
+    uint32_t u32WordStall;      /*!< HCLK cycles per uncached word read                       */
+    uint32_t u32Fetch;          /*!< Line accesses, all functions                             */
+    uint32_t u32Miss;           /*!< Misses, all functions                                    */
+    uint32_t u32Stall;          /*!< Stall cycles, all functions                              */
+    uint32_t u32Outside;        /*!< Line accesses outside every function                     */
+    /** @cond HIDDEN_SYMBOLS */
+    uint16_t au16Order[SPROF_FUNC_MAX];         /* functions by address */
+    uint32_t u32Tick;
+    uint32_t au32Tag[SPROF_SETS][SPROF_WAYS];
+    uint32_t au32Used[SPROF_SETS][SPROF_WAYS];  /* LRU stamp, 0 = invalid */
+    /** @endcond HIDDEN_SYMBOLS */
+} SPROF_T;
+
+void SPROF_Init(SPROF_T *psProf, SPROF_FUNC_T *psFunc, uint32_t u32FuncNum, uint32_t u32End);
+void SPROF_SetTiming(SPROF_T *psProf, const SPIM_DMM_CFG_T *psCfg, uint32_t u32Divider);
+void SPROF_Reset(SPROF_T *psProf);
+void SPROF_Fetch(SPROF_T *psProf, uint32_t u32Addr, uint32_t u32Len);
+void SPROF_Call(SPROF_T *psProf, uint32_t u32Func);
+uint32_t SPROF_ReadCycles(const SPIM_DMM_CFG_T *psCfg, uint32_t u32Divider, uint32_t u32Bytes);
+uint32_t SPROF_PlanSram(SPROF_T *psProf, uint32_t u32Budget);
+void SPROF_Report(SPROF_T *psProf, uint32_t u32Top);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __SPIM_PROF_H__ */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -21,6 +21,13 @@
 
 #include "ff.h"			/* Declarations of FatFs API */
 #include "diskio.h"		/* Declarations of device I/O functions */
+#if FF_USE_CACHE
+#include "ffcache.h"		/* Sector cache between FatFs and the device I/O functions */
+#define disk_initialize	ff_cache_initialize
+#define disk_read		ff_cache_read
+#define disk_write		ff_cache_write
+#define disk_ioctl		ff_cache_ioctl
+#endif
 
 
 /*--------------------------------------------------------------------------
@@ -0,0 +1,296 @@
+/*------------------------------------------------------------------------*/
+/* Set Associative Sector Cache for FatFs                                 */
+/*------------------------------------------------------------------------*/
+/* When FF_USE_CACHE is enabled, ff.c calls the functions in this file
+/  instead of disk_initialize(), disk_read(), disk_write() and disk_ioctl().
+/  A sector is held in set (sector % FF_CACHE_SETS) and the least recently
+/  used way of the set is replaced. Single sector writes stay in the cache
+/  until the line is replaced or CTRL_SYNC is requested, so the FAT and
+/  directory sectors updated again and again go to the disk once. Multiple
+/  sector transfers, the file data, bypass the cache.
+*/
+
+#include <string.h>
+#include "ffcache.h"
+
+
+
+#if FF_USE_CACHE
+
+#if FF_MAX_SS != FF_MIN_SS
+#error Sector cache does not support variable sector size
+#endif
+#if FF_CACHE_SETS < 1 || (FF_CACHE_SETS & (FF_CACHE_SETS - 1)) || FF_CACHE_WAYS < 1
+#error Wrong FF_CACHE_SETS or FF_CACHE_WAYS setting
+#endif
+
+#define N_LINES		(FF_CACHE_SETS * FF_CACHE_WAYS)
+
+/* Line status flags */
+#define LF_VALID	0x01
+#define LF_DIRTY	0x02
+
+typedef struct {
+	DWORD	sect;		/* Sector held in the line */
+	DWORD	stamp;		/* Last access, for LRU replacement */
+	BYTE	pdrv;		/* Physical drive of the sector */
+	BYTE	flag;		/* LF_VALID/LF_DIRTY */
+} CLINE;
+
+static CLINE Line[N_LINES];
+static DWORD LineBuf[N_LINES][FF_MAX_SS / 4];	/* Word aligned for the DMA of the disk driver */
+static DWORD Stamp;
+static FFCACHE_STAT Stat[FF_VOLUMES];
+
+#define STAT(pd, item)	do { if ((pd) < FF_VOLUMES) Stat[pd].item++; } while (0)
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Find the line holding a sector (-1: not cached)                       */
+/*-----------------------------------------------------------------------*/
+
+static int find_line (
+	BYTE pdrv,
+	DWORD sect
+)
+{
+	int i, n;
+
+
+	i = (int)(sect & (FF_CACHE_SETS - 1)) * FF_CACHE_WAYS;
+	for (n = 0; n < FF_CACHE_WAYS; n++, i++) {
+		if ((Line[i].flag & LF_VALID) && Line[i].sect == sect && Line[i].pdrv == pdrv) return i;
+	}
+	return -1;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write back a dirty line                                               */
+/*-----------------------------------------------------------------------*/
+
+static DRESULT clean_line (
+	int i
+)
+{
+	DRESULT res = RES_OK;
+
+
+	if (Line[i].flag & LF_DIRTY) {
+		res = disk_write(Line[i].pdrv, (const BYTE*)LineBuf[i], Line[i].sect, 1);
+		if (res == RES_OK) {
+			Line[i].flag &= ~LF_DIRTY;
+			STAT(Line[i].pdrv, wr_back);
+		}
+	}
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Take a line of the sector's set for the sector (-1: write back error) */
+/*-----------------------------------------------------------------------*/
+
+static int alloc_line (
+	BYTE pdrv,
+	DWORD sect
+)
+{
+	int i, n, v;
+
+
+	i = (int)(sect & (FF_CACHE_SETS - 1)) * FF_CACHE_WAYS;
+	for (v = i, n = 0; n < FF_CACHE_WAYS; n++, i++) {	/* Empty way or else the least recently used one */
+		if (!(Line[i].flag & LF_VALID)) {
+			v = i; break;
+		}
+		if ((DWORD)(Stamp - Line[i].stamp) > (DWORD)(Stamp - Line[v].stamp)) v = i;
+	}
+	if (clean_line(v) != RES_OK) return -1;
+
+	Line[v].pdrv = pdrv;
+	Line[v].sect = sect;
+	Line[v].flag = 0;
+	return v;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Initialize a Drive                                                    */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS ff_cache_initialize (
+	BYTE pdrv
+)
+{
+	int i;
+
+
+	/* Write back what is left while the device is still up, then forget the drive's sectors
+	   since the medium may be changed. Sectors that cannot be written back are discarded. */
+	if (!(disk_status(pdrv) & STA_NOINIT)) ff_cache_flush(pdrv);
+	for (i = 0; i < N_LINES; i++) {
+		if (Line[i].pdrv == pdrv) Line[i].flag = 0;
+	}
+	return disk_initialize(pdrv);
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT ff_cache_read (
+	BYTE pdrv,
+	BYTE* buff,
+	DWORD sector,
+	UINT count
+)
+{
+	DRESULT res;
+	int i;
+
+
+	if (count == 1) {
+		i = find_line(pdrv, sector);
+		if (i >= 0) {
+			STAT(pdrv, rd_hit);
+		} else {
+			STAT(pdrv, rd_miss);
+			i = alloc_line(pdrv, sector);
+			if (i < 0) return RES_ERROR;
+			res = disk_read(pdrv, (BYTE*)LineBuf[i], sector, 1);
+			if (res != RES_OK) return res;
+			Line[i].flag = LF_VALID;
+		}
+		Line[i].stamp = ++Stamp;
+		memcpy(buff, LineBuf[i], FF_MAX_SS);
+		return RES_OK;
+	}
+
+	res = disk_read(pdrv, buff, sector, count);
+	if (res == RES_OK) {
+		if (pdrv < FF_VOLUMES) Stat[pdrv].rd_miss += count;
+		for (i = 0; i < N_LINES; i++) {	/* Sectors not written back yet are newer than the disk */
+			if ((Line[i].flag & LF_DIRTY) && Line[i].pdrv == pdrv && Line[i].sect - sector < count) {
+				memcpy(buff + (Line[i].sect - sector) * FF_MAX_SS, LineBuf[i], FF_MAX_SS);
+			}
+		}
+	}
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT ff_cache_write (
+	BYTE pdrv,
+	const BYTE* buff,
+	DWORD sector,
+	UINT count
+)
+{
+	DRESULT res;
+	int i;
+
+
+	if (count == 1) {
+		i = find_line(pdrv, sector);
+		if (i >= 0) {
+			STAT(pdrv, wr_hit);
+		} else {
+			STAT(pdrv, wr_miss);
+			i = alloc_line(pdrv, sector);
+			if (i < 0) return RES_ERROR;
+		}
+		memcpy(LineBuf[i], buff, FF_MAX_SS);
+		Line[i].flag = LF_VALID | LF_DIRTY;
+		Line[i].stamp = ++Stamp;
+		return RES_OK;
+	}
+
+	res = disk_write(pdrv, buff, sector, count);
+	if (res == RES_OK) {
+		if (pdrv < FF_VOLUMES) Stat[pdrv].wr_miss += count;
+		for (i = 0; i < N_LINES; i++) {	/* Keep the cached copies up to date */
+			if ((Line[i].flag & LF_VALID) && Line[i].pdrv == pdrv && Line[i].sect - sector < count) {
+				memcpy(LineBuf[i], buff + (Line[i].sect - sector) * FF_MAX_SS, FF_MAX_SS);
+				Line[i].flag = LF_VALID;
+			}
+		}
+	}
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write back all dirty sectors of a drive in ascending sector order     */
+/*-----------------------------------------------------------------------*/
+
+DRESULT ff_cache_flush (
+	BYTE pdrv
+)
+{
+	DRESULT res;
+	int i, v;
+
+
+	for (;;) {
+		for (v = -1, i = 0; i < N_LINES; i++) {
+			if ((Line[i].flag & LF_DIRTY) && Line[i].pdrv == pdrv && (v < 0 || Line[i].sect < Line[v].sect)) v = i;
+		}
+		if (v < 0) return RES_OK;
+		res = clean_line(v);
+		if (res != RES_OK) return res;
+	}
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+DRESULT ff_cache_ioctl (
+	BYTE pdrv,
+	BYTE cmd,
+	void* buff
+)
+{
+	DRESULT res;
+
+
+	if (cmd == CTRL_SYNC) {		/* Write back the drive before the device completes its pending writes */
+		res = ff_cache_flush(pdrv);
+		if (res != RES_OK) return res;
+	}
+	return disk_ioctl(pdrv, cmd, buff);
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Get (and clear) Hit/Miss Counters of a Drive                          */
+/*-----------------------------------------------------------------------*/
+
+void ff_cache_stat (
+	BYTE pdrv,
+	FFCACHE_STAT* st,	/* Pointer to return the counters (null: no return) */
+	int clr				/* 1: Clear the counters */
+)
+{
+	if (pdrv >= FF_VOLUMES) return;
+	if (st) *st = Stat[pdrv];
+	if (clr) memset(&Stat[pdrv], 0, sizeof Stat[pdrv]);
+}
+
+#endif
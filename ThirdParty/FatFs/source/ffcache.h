@@ -0,0 +1,41 @@
+/*-----------------------------------------------------------------------/
+/  Sector cache for FatFs include file                                   /
+/-----------------------------------------------------------------------*/
+
+#ifndef FFCACHE_DEFINED
+#define FFCACHE_DEFINED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ff.h"
+#include "diskio.h"
+
+
+/* Hit/miss counters of a physical drive */
+
+typedef struct {
+	DWORD	rd_hit;		/* Sector reads served from the cache */
+	DWORD	rd_miss;	/* Sector reads from the disk */
+	DWORD	wr_hit;		/* Sector writes merged into a cached sector */
+	DWORD	wr_miss;	/* Sector writes allocating a line or written through */
+	DWORD	wr_back;	/* Cached sectors written back to the disk */
+} FFCACHE_STAT;
+
+
+/*---------------------------------------*/
+/* Prototypes for cache functions        */
+
+DSTATUS ff_cache_initialize (BYTE pdrv);
+DRESULT ff_cache_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count);
+DRESULT ff_cache_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);
+DRESULT ff_cache_ioctl (BYTE pdrv, BYTE cmd, void* buff);
+DRESULT ff_cache_flush (BYTE pdrv);
+void ff_cache_stat (BYTE pdrv, FFCACHE_STAT* st, int clr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -200,6 +200,27 @@
 /  disk_ioctl() function. */
 
 
+#ifndef FF_USE_CACHE
+#define FF_USE_CACHE	0
+#endif
+#ifndef FF_CACHE_SETS
+#define FF_CACHE_SETS	4
+#endif
+#ifndef FF_CACHE_WAYS
+#define FF_CACHE_WAYS	4
+#endif
+/* This set of options configures the sector cache placed between FatFs and the
+/  device I/O functions. (0:Disable or 1:Enable) When enable it, also ffcache.c
+/  needs to be added to the project. The options may be given on the compiler
+/  command line instead, as SDH_FATFS does with FF_USE_CACHE=1, since this
+/  file is shared by all samples. The cache holds FF_CACHE_SETS * FF_CACHE_WAYS
+/  sectors of FF_MAX_SS bytes, FF_CACHE_SETS must be power of 2. Single sector
+/  writes are held in the cache until CTRL_SYNC, which f_sync() and f_close()
+/  request, so a repeated update of a FAT or directory sector is written once.
+/  The cache is shared by all drives and is not guarded by the FF_FS_REENTRANT
+/  sync object of a volume, so only one volume may be accessed at a time. */
+
+
 #define FF_FS_NOFSINFO	0
 /* If you need to know correct free space on the FAT32 volume, set bit 0 of this
 /  option, and f_getfree() function at first time after volume mount will force
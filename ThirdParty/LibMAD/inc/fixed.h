@@ -295,6 +295,104 @@ mad_fixed_t mad_f_mul_inline(mad_fixed_t x, mad_fixed_t y)
 
 #  define MAD_F_SCALEBITS  MAD_F_FRACBITS
 
+/* --- Cortex-M4 ----------------------------------------------------------- */
+
+# elif defined(FPM_CORTEXM4)
+
+/*
+ * This ARMv7E-M version accumulates full 64-bit products with SMULL/SMLAL
+ * and rounds the least significant bit like FPM_ARM, so its output is
+ * bit-exact with FPM_ARM (and FPM_INTEL with OPT_ACCURACY). SMMUL/SMMLA
+ * are not used since dropping the low word would break that.
+ *
+ * GCC and armclang get the inline assembly below. Everything else, ARMCC
+ * and IAR included, gets the portable C reference, which those compilers
+ * turn into the same SMULL/SMLAL sequences and which also builds on a
+ * host to check the target output. No GNU statement expressions are used
+ * outside the inline assembly path, and MAD_F_MLX is left undefined so
+ * the synth does not pick the lossy OPT_DCTO path.
+ */
+#  if defined(__GNUC__) &&  \
+      (defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_7M__))
+#   define FPM_CORTEXM4_ASM
+#  endif
+
+#  if defined(FPM_CORTEXM4_ASM)
+#   define mad_f_mul(x, y)  \
+    ({ mad_fixed64hi_t __hi;  \
+       mad_fixed64lo_t __lo;  \
+       mad_fixed_t __result;  \
+       asm ("smull	%0, %1, %3, %4\n\t"  \
+	    "lsrs	%0, %0, %5\n\t"  \
+	    "adc	%2, %0, %1, lsl %6"  \
+	    : "=&r" (__lo), "=&r" (__hi), "=r" (__result)  \
+	    : "%r" (x), "r" (y),  \
+	      "i" (MAD_F_SCALEBITS), "i" (32 - MAD_F_SCALEBITS)  \
+	    : "cc");  \
+       __result;  \
+    })
+
+#   define MAD_F_ML0(hi, lo, x, y)  \
+    asm ("smull	%0, %1, %2, %3"  \
+	 : "=&r" (lo), "=&r" (hi)  \
+	 : "%r" (x), "r" (y))
+
+#   define MAD_F_MLA(hi, lo, x, y)  \
+    asm ("smlal	%0, %1, %2, %3"  \
+	 : "+r" (lo), "+r" (hi)  \
+	 : "%r" (x), "r" (y))
+
+/* Thumb-2 has no RSC: hi = hi - (hi << 1) - borrow */
+#   define MAD_F_MLN(hi, lo)  \
+    asm ("rsbs	%0, %0, #0\n\t"  \
+	 "sbc	%1, %1, %1, lsl #1"  \
+	 : "+r" (lo), "+r" (hi)  \
+	 :  \
+	 : "cc")
+
+#   define mad_f_scale64(hi, lo)  \
+    ({ mad_fixed_t __result;  \
+       asm ("lsrs	%0, %1, %3\n\t"  \
+	    "adc	%0, %0, %2, lsl %4"  \
+	    : "=&r" (__result)  \
+	    : "r" (lo), "r" (hi),  \
+	      "i" (MAD_F_SCALEBITS), "i" (32 - MAD_F_SCALEBITS)  \
+	    : "cc");  \
+       __result;  \
+    })
+#  else
+#   define mad_f_mul(x, y)  \
+    ((mad_fixed_t)  \
+     ((((mad_fixed64_t) (x) * (y)) +  \
+       (1L << (MAD_F_SCALEBITS - 1))) >> MAD_F_SCALEBITS))
+
+#   define MAD_F_ML0(hi, lo, x, y)  \
+    do {  \
+      mad_fixed64_t __acc = (mad_fixed64_t) (x) * (y);  \
+      (lo) = (mad_fixed64lo_t) __acc;  \
+      (hi) = (mad_fixed64hi_t) (__acc >> 32);  \
+    }  \
+    while (0)
+
+#   define MAD_F_MLA(hi, lo, x, y)  \
+    do {  \
+      mad_fixed64_t __acc = (mad_fixed64_t)  \
+	(((unsigned long long) (mad_fixed64lo_t) (hi) << 32) | (lo));  \
+      __acc += (mad_fixed64_t) (x) * (y);  \
+      (lo) = (mad_fixed64lo_t) __acc;  \
+      (hi) = (mad_fixed64hi_t) (__acc >> 32);  \
+    }  \
+    while (0)
+
+#   define mad_f_scale64(hi, lo)  \
+    ((mad_fixed_t)  \
+     ((((mad_fixed64lo_t) (hi) << (32 - MAD_F_SCALEBITS)) |  \
+       ((lo) >> MAD_F_SCALEBITS)) +  \
+      (((lo) >> (MAD_F_SCALEBITS - 1)) & 1)))
+#  endif
+
+#  define MAD_F_SCALEBITS  MAD_F_FRACBITS
+
 /* --- MIPS ---------------------------------------------------------------- */
 
 # elif defined(FPM_MIPS)
@@ -38,7 +38,9 @@
 #  error "cannot optimize for both speed and accuracy"
 # endif
 
-# if defined(OPT_SPEED) && !defined(OPT_SSO)
+/* SMLAL costs no more than MLA on Cortex-M4, so SSO would only lose accuracy */
+
+# if defined(OPT_SPEED) && !defined(OPT_SSO) && !defined(FPM_CORTEXM4)
 #  define OPT_SSO
 # endif
 
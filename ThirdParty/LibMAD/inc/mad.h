@@ -28,7 +28,8 @@ extern "C" {
 // #define malloc malloc_dbg
 // #define calloc calloc_dbg
 
-#ifndef __WINS__       // This only works on target machine
+#if defined(FPM_CORTEXM4)    // SMULL/SMLAL on Cortex-M4, bit-exact portable C elsewhere
+#elif !defined(__WINS__)     // This only works on target machine
 # define FPM_ARM
 //# define OPT_SPEED
 //# define FPM_DEFAULT
@@ -2071,7 +2071,7 @@ void imdct36(mad_fixed_t const X[18], mad_fixed_t x[36])
  * NAME:	III_imdct_l()
  * DESCRIPTION:	perform IMDCT and windowing for long blocks
  */
-#  ifndef __WINS__
+#  if !defined(__WINS__) && !defined(FPM_CORTEXM4)
 void III_imdct_l(mad_fixed_t const X[18], mad_fixed_t z[36], unsigned int block_type);
 #  else
 static
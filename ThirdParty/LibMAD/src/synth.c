@@ -45,6 +45,16 @@ signed int scale(mad_fixed_t sample)
   /* round */
   sample += (1L << (MAD_F_FRACBITS - 16));
 
+# if defined(FPM_CORTEXM4_ASM)
+  /* clip and quantize in one SSAT, same result as the C code below */
+  asm ("ssat	%0, #16, %1, asr %2"
+       : "=r" (sample)
+       : "r" (sample), "i" (MAD_F_FRACBITS + 1 - 16));
+
+  return sample;
+# elif defined(FPM_CORTEXM4) && defined(__CC_ARM)
+  return __ssat(sample >> (MAD_F_FRACBITS + 1 - 16), 16);
+# else
   /* clip */
   if (sample >= MAD_F_ONE)
     sample = MAD_F_ONE - 1;
@@ -53,6 +63,7 @@ signed int scale(mad_fixed_t sample)
 
   /* quantize */
   return sample >> (MAD_F_FRACBITS + 1 - 16);
+# endif
 }
 
 /*
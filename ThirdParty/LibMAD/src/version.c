@@ -52,6 +52,8 @@ char const mad_build[] = ""
   "FPM_INTEL "
 # elif defined(FPM_ARM)
   "FPM_ARM "
+# elif defined(FPM_CORTEXM4)
+  "FPM_CORTEXM4 "
 # elif defined(FPM_MIPS)
   "FPM_MIPS "
 # elif defined(FPM_SPARC)
@@ -47,6 +47,12 @@ typedef union {
 #ifdef DCT_FLOAT_SUPPORTED
   FAST_FLOAT float_array[DCTSIZE2];
 #endif
+#ifdef DCT_ISLOW_DSP_SUPPORTED
+  struct {			/* ISLOW divisors followed by ceil(2^32/divisor) */
+    DCTELEM int_array[DCTSIZE2];
+    INT32 recip_array[DCTSIZE2];
+  } dsp;
+#endif
 } divisor_table;
 
 
@@ -61,6 +67,9 @@ typedef union {
 #endif
 #endif
 
+/* The multiply-high quantizer in jfdctdsp.c is exact for divisors < 2^16. */
+#define DSP_MAX_DIVISOR  ((1L << 16) - 1)
+
 
 /*
  * Perform forward DCT on one or more blocks of a component.
@@ -131,6 +140,36 @@ forward_DCT (j_compress_ptr cinfo, jpeg_component_info * compptr,
 }
 
 
+#ifdef DCT_ISLOW_DSP_SUPPORTED
+
+METHODDEF(void)
+forward_DCT_dsp (j_compress_ptr cinfo, jpeg_component_info * compptr,
+		 JSAMPARRAY sample_data, JBLOCKROW coef_blocks,
+		 JDIMENSION start_row, JDIMENSION start_col,
+		 JDIMENSION num_blocks)
+/* This version is used for the DSP integer DCT with reciprocal divisors. */
+{
+  my_fdct_ptr fdct = (my_fdct_ptr) cinfo->fdct;
+  forward_DCT_method_ptr do_dct = fdct->do_dct[compptr->component_index];
+  divisor_table * dtbl = (divisor_table *) compptr->dct_table;
+  DCTELEM workspace[DCTSIZE2];	/* work area for FDCT subroutine */
+  JDIMENSION bi;
+
+  sample_data += start_row;	/* fold in the vertical offset once */
+
+  for (bi = 0; bi < num_blocks; bi++, start_col += compptr->DCT_h_scaled_size) {
+    /* Perform the DCT */
+    (*do_dct) (workspace, sample_data, start_col);
+
+    /* Quantize/descale the coefficients, and store into coef_blocks[] */
+    jpeg_quantize_dsp(coef_blocks[bi], workspace,
+		      dtbl->dsp.int_array, dtbl->dsp.recip_array);
+  }
+}
+
+#endif /* DCT_ISLOW_DSP_SUPPORTED */
+
+
 #ifdef DCT_FLOAT_SUPPORTED
 
 METHODDEF(void)
@@ -333,6 +372,12 @@ start_pass_fdctmgr (j_compress_ptr cinfo)
 	method = JDCT_ISLOW;
 	break;
 #endif
+#ifdef DCT_ISLOW_DSP_SUPPORTED
+      case JDCT_ISLOW_DSP:
+	fdct->do_dct[ci] = jpeg_fdct_islow_dsp;
+	method = JDCT_ISLOW_DSP;
+	break;
+#endif
 #ifdef DCT_IFAST_SUPPORTED
       case JDCT_IFAST:
 	fdct->do_dct[ci] = jpeg_fdct_ifast;
@@ -376,6 +421,32 @@ start_pass_fdctmgr (j_compress_ptr cinfo)
       fdct->pub.forward_DCT[ci] = forward_DCT;
       break;
 #endif
+#ifdef DCT_ISLOW_DSP_SUPPORTED
+    case JDCT_ISLOW_DSP:
+      {
+	/* ISLOW divisors, plus their reciprocals for the multiply-high
+	 * quantizer.  Larger divisors (only possible with non-baseline
+	 * tables) use the divide in forward_DCT instead.
+	 */
+	divisor_table * dsptbl = (divisor_table *) compptr->dct_table;
+	INT32 maxdiv = 0;
+
+	for (i = 0; i < DCTSIZE2; i++) {
+	  dsptbl->dsp.int_array[i] =
+	    ((DCTELEM) qtbl->quantval[i]) << (compptr->component_needed ? 4 : 3);
+	  if ((INT32) dsptbl->dsp.int_array[i] > maxdiv)
+	    maxdiv = (INT32) dsptbl->dsp.int_array[i];
+	  /* ceil(2^32/d) for d >= 2 without 64-bit arithmetic */
+	  dsptbl->dsp.recip_array[i] = (INT32)
+	    (0xFFFFFFFFUL / (unsigned long) dsptbl->dsp.int_array[i] + 1);
+	}
+	if (maxdiv <= DSP_MAX_DIVISOR)
+	  fdct->pub.forward_DCT[ci] = forward_DCT_dsp;
+	else
+	  fdct->pub.forward_DCT[ci] = forward_DCT;
+      }
+      break;
+#endif
 #ifdef DCT_IFAST_SUPPORTED
     case JDCT_IFAST:
       {
@@ -95,6 +95,8 @@ typedef FAST_FLOAT FLOAT_MULT_TYPE; /* preferred floating type */
 
 #ifdef NEED_SHORT_EXTERNAL_NAMES
 #define jpeg_fdct_islow		jFDislow
+#define jpeg_fdct_islow_dsp	jFDisdsp
+#define jpeg_quantize_dsp	jFQdsp
 #define jpeg_fdct_ifast		jFDifast
 #define jpeg_fdct_float		jFDfloat
 #define jpeg_fdct_7x7		jFD7x7
@@ -234,6 +236,11 @@ EXTERN(void) jpeg_fdct_2x4
     JPP((DCTELEM * data, JSAMPARRAY sample_data, JDIMENSION start_col));
 EXTERN(void) jpeg_fdct_1x2
     JPP((DCTELEM * data, JSAMPARRAY sample_data, JDIMENSION start_col));
+EXTERN(void) jpeg_fdct_islow_dsp
+    JPP((DCTELEM * data, JSAMPARRAY sample_data, JDIMENSION start_col));
+EXTERN(void) jpeg_quantize_dsp
+    JPP((JCOEFPTR output, DCTELEM * workspace,
+	 DCTELEM * divisors, INT32 * recips));
 
 EXTERN(void) jpeg_idct_islow
     JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
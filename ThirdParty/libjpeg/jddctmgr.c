@@ -229,6 +229,9 @@ start_pass (j_decompress_ptr cinfo)
     case ((DCTSIZE << 8) + DCTSIZE):
       switch (cinfo->dct_method) {
 #ifdef DCT_ISLOW_SUPPORTED
+#ifdef DCT_ISLOW_DSP_SUPPORTED
+      case JDCT_ISLOW_DSP:	/* only the FDCT has a DSP version */
+#endif
       case JDCT_ISLOW:
 	method_ptr = jpeg_idct_islow;
 	method = JDCT_ISLOW;
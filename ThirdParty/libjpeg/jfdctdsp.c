@@ -0,0 +1,365 @@
+/*
+ * jfdctdsp.c
+ *
+ * Based on jfdctint.c, Copyright (C) 1991-1996, Thomas G. Lane,
+ * modification developed 2003-2015 by Guido Vollbeding.
+ * This file is not part of the IJG distribution.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains the slow-but-accurate integer forward DCT of
+ * jfdctint.c and a divide-free quantizer, both rewritten for the packed
+ * 16-bit instructions of the ARMv7E-M DSP extension (Cortex-M4/M7):
+ * SADD16/SSUB16 do two butterflies per instruction, and SMLAD/SMUAD do
+ * two 16x16 multiplies plus the accumulate in one single-cycle instruction.
+ *
+ * The results are bit-exact with jpeg_fdct_islow and with the division in
+ * jcdctmgr.c.  LL&M splits every output into a chain of products and sums
+ * that are all exact 32-bit integer operations; only the final descale
+ * rounds.  Expanding that chain gives each output as a dot product of the
+ * four butterfly terms with combined constants, which is what SMLAD
+ * computes, and the sums are the same integers in a different order.
+ *
+ * The quantizer replaces (x + q/2) / q by a multiply-high with
+ * ceil(2^32/q).  This is exact as long as x < 2^16 and q < 2^16, which
+ * holds for 8-bit samples (outputs are within +-8K) and baseline tables.
+ * jcdctmgr.c falls back to the divide for larger divisors.
+ *
+ * If the compiler targets the DSP extension, the CMSIS intrinsics are
+ * used.  Otherwise (or with JDSP_EMULATE defined) each instruction is
+ * emulated in portable C, so the file can be checked against jfdctint.c
+ * on any host.  Defining JDSP_CYCLE_COUNT as well makes the emulation add
+ * the Cortex-M4 cycle count of every emulated instruction, load and store
+ * to jdsp_cycles, giving per-block cycle estimates off target.
+ *
+ * Requires 8-bit samples and a 32-bit int.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+
+#ifdef DCT_ISLOW_DSP_SUPPORTED
+
+
+/*
+ * This module is specialized to the case DCTSIZE = 8 and 8-bit samples.
+ */
+
+#if DCTSIZE != 8
+  Sorry, this code only copes with 8x8 DCT blocks. /* deliberate syntax err */
+#endif
+#if BITS_IN_JSAMPLE != 8
+  Sorry, this code only copes with 8-bit samples. /* deliberate syntax err */
+#endif
+
+
+/* Same scaling as jfdctint.c; see the explanation there. */
+
+#define CONST_BITS  13
+#define PASS1_BITS  2
+
+#define FIX_0_298631336  2446
+#define FIX_0_390180644  3196
+#define FIX_0_541196100  4433
+#define FIX_0_765366865  6270
+#define FIX_0_899976223  7373
+#define FIX_1_175875602  9633
+#define FIX_1_501321110  12299
+#define FIX_1_847759065  15137
+#define FIX_1_961570560  16069
+#define FIX_2_053119869  16819
+#define FIX_2_562915447  20995
+#define FIX_3_072711026  25172
+
+
+/*
+ * Packed halfword pairs.  The butterflies below keep the four sums and
+ * the four differences of a row as (t0,t2) (t1,t3) and (d0,d2) (d1,d3),
+ * because that is the order UXTB16 unpacks the samples in.
+ */
+
+typedef unsigned int JPACK;	/* two INT16 values, first one in the low half */
+
+#define PAIR(lo,hi)  ((JPACK) (((unsigned int) (hi) << 16) | ((lo) & 0xFFFF)))
+
+
+#ifndef JDSP_EMULATE
+#if defined(__TARGET_FEATURE_DSPMUL) || \
+    (defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+#define JDSP_NATIVE
+#endif
+#endif
+
+#ifdef JDSP_NATIVE
+
+#include "cmsis_compiler.h"
+
+#define DSP_SADD16(a,b)      __SADD16(a,b)
+#define DSP_SSUB16(a,b)      __SSUB16(a,b)
+#define DSP_SMUAD(a,b)       ((int) __SMUAD(a,b))
+#define DSP_SMLAD(a,b,acc)   ((int) __SMLAD(a,b,(unsigned int) (acc)))
+#define DSP_UXTB16(a)        __UXTB16(a)
+#define DSP_ROR(a,n)         __ROR(a,n)
+#define DSP_LD32(p)          __UNALIGNED_UINT32_READ(p)
+#define DSP_LD32A(p)         (*(const JPACK *) (p))
+#define DSP_UMULH(a,b)       ((unsigned int) (((unsigned long long) (a) * (b)) >> 32))
+#define DSP_TICK(n)
+
+#else /* emulation */
+
+#ifdef JDSP_CYCLE_COUNT
+GLOBAL(unsigned long) jdsp_cycles = 0;
+#define DSP_TICK(n)  (jdsp_cycles += (n))
+#else
+#define DSP_TICK(n)
+#endif
+
+#define LO(a)  ((int) (INT16) ((a) & 0xFFFF))
+#define HI(a)  ((int) (INT16) ((a) >> 16))
+
+LOCAL(JPACK)
+dsp_sadd16 (JPACK a, JPACK b)
+{
+  DSP_TICK(1);
+  return PAIR(LO(a) + LO(b), HI(a) + HI(b));
+}
+
+LOCAL(JPACK)
+dsp_ssub16 (JPACK a, JPACK b)
+{
+  DSP_TICK(1);
+  return PAIR(LO(a) - LO(b), HI(a) - HI(b));
+}
+
+LOCAL(int)
+dsp_smlad (JPACK a, JPACK b, int acc)
+{
+  DSP_TICK(1);
+  return (int) ((unsigned int) (LO(a) * LO(b)) + (unsigned int) (HI(a) * HI(b)) +
+		(unsigned int) acc);
+}
+
+LOCAL(JPACK)
+dsp_uxtb16 (JPACK a)
+{
+  DSP_TICK(1);
+  return a & 0x00FF00FF;
+}
+
+LOCAL(JPACK)
+dsp_ror (JPACK a, int n)
+{
+  DSP_TICK(1);
+  return (a >> n) | (a << (32 - n));
+}
+
+LOCAL(JPACK)
+dsp_ld32 (const void * p)
+{
+  const unsigned char * b = (const unsigned char *) p;
+
+  DSP_TICK(1);			/* LDR, pipelined with the next access */
+  return (JPACK) b[0] | ((JPACK) b[1] << 8) | ((JPACK) b[2] << 16) |
+	 ((JPACK) b[3] << 24);
+}
+
+LOCAL(unsigned int)
+dsp_umulh (unsigned int a, unsigned int b)
+{
+  DSP_TICK(1);
+  return (unsigned int) (((unsigned long long) a * b) >> 32);
+}
+
+#define DSP_SADD16(a,b)      dsp_sadd16(a,b)
+#define DSP_SSUB16(a,b)      dsp_ssub16(a,b)
+#define DSP_SMUAD(a,b)       dsp_smlad(a,b,0)
+#define DSP_SMLAD(a,b,acc)   dsp_smlad(a,b,acc)
+#define DSP_UXTB16(a)        dsp_uxtb16(a)
+#define DSP_ROR(a,n)         dsp_ror(a,n)
+#define DSP_LD32(p)          dsp_ld32(p)
+#define DSP_LD32A(p)         dsp_ld32(p)
+#define DSP_UMULH(a,b)       dsp_umulh(a,b)
+
+#endif /* JDSP_NATIVE */
+
+
+/*
+ * Constant pairs.  Each output of the LL&M flow graph in jfdctint.c is
+ * expanded into one coefficient per butterfly term; e.g. for output 1
+ *   d0*c1501 + (d0+d3)*-c0899 + (d0+d2)*-c0390 + (d0+d1+d2+d3)*c1175
+ * gives d0 the combined constant c1501-c0899-c0390+c1175.
+ */
+
+/* Even part: t0..t3 are the sums, t12 = t0-t3, t13 = t1-t2. */
+#define E4_02  PAIR(1, -1)
+#define E4_13  PAIR(-1, 1)
+#define E0_XX  PAIR(1, 1)
+#define E2_0   (FIX_0_541196100 + FIX_0_765366865)	/* t12 */
+#define E2_1   FIX_0_541196100				/* t13 */
+#define E6_0   FIX_0_541196100				/* t12 */
+#define E6_1   (FIX_0_541196100 - FIX_1_847759065)	/* t13 */
+#define E2_02  PAIR(E2_0, -E2_1)
+#define E2_13  PAIR(E2_1, -E2_0)
+#define E6_02  PAIR(E6_0, -E6_1)
+#define E6_13  PAIR(E6_1, -E6_0)
+
+/* Odd part: d0..d3 are the differences. */
+#define OC  FIX_1_175875602
+#define O1_02  PAIR(FIX_1_501321110 - FIX_0_899976223 - FIX_0_390180644 + OC, \
+		    OC - FIX_0_390180644)
+#define O1_13  PAIR(OC, OC - FIX_0_899976223)
+#define O3_02  PAIR(OC, OC - FIX_2_562915447)
+#define O3_13  PAIR(FIX_3_072711026 - FIX_2_562915447 - FIX_1_961570560 + OC, \
+		    OC - FIX_1_961570560)
+#define O5_02  PAIR(OC - FIX_0_390180644, \
+		    FIX_2_053119869 - FIX_2_562915447 - FIX_0_390180644 + OC)
+#define O5_13  PAIR(OC - FIX_2_562915447, OC)
+#define O7_02  PAIR(OC - FIX_0_899976223, OC)
+#define O7_13  PAIR(OC - FIX_1_961570560, \
+		    FIX_0_298631336 - FIX_0_899976223 - FIX_1_961570560 + OC)
+
+
+/*
+ * One 1-D DCT.  a = (e0,e2), b = (e1,e3), c = (e4,e6), d = (e5,e7);
+ * the results are still scaled by 2^CONST_BITS except out0 and out4.
+ */
+
+#define DCT_1D(a,b,c,d)  \
+  c = DSP_ROR(c, 16);			/* (e6,e4) */ \
+  d = DSP_ROR(d, 16);			/* (e7,e5) */ \
+  s02 = DSP_SADD16(a, d);		/* (t0,t2) */ \
+  s13 = DSP_SADD16(b, c);		/* (t1,t3) */ \
+  q02 = DSP_SSUB16(a, d);		/* (d0,d2) */ \
+  q13 = DSP_SSUB16(b, c);		/* (d1,d3) */ \
+  out0 = DSP_SMLAD(s13, E0_XX, DSP_SMUAD(s02, E0_XX)); \
+  out4 = DSP_SMLAD(s13, E4_13, DSP_SMUAD(s02, E4_02)); \
+  out2 = DSP_SMLAD(s13, E2_13, DSP_SMLAD(s02, E2_02, round)); \
+  out6 = DSP_SMLAD(s13, E6_13, DSP_SMLAD(s02, E6_02, round)); \
+  out1 = DSP_SMLAD(q13, O1_13, DSP_SMLAD(q02, O1_02, round)); \
+  out3 = DSP_SMLAD(q13, O3_13, DSP_SMLAD(q02, O3_02, round)); \
+  out5 = DSP_SMLAD(q13, O5_13, DSP_SMLAD(q02, O5_02, round)); \
+  out7 = DSP_SMLAD(q13, O7_13, DSP_SMLAD(q02, O7_02, round))
+
+
+/*
+ * Perform the forward DCT on one block of samples.
+ */
+
+GLOBAL(void)
+jpeg_fdct_islow_dsp (DCTELEM * data, JSAMPARRAY sample_data,
+		     JDIMENSION start_col)
+{
+  /* Pass 1 output, transposed.  Each column is stored in the order
+   * e0 e2 e1 e3 e4 e6 e5 e7 so pass 2 loads it already unpacked.
+   */
+  static const int colpos[DCTSIZE] = { 0, 2, 1, 3, 4, 6, 5, 7 };
+  union {
+    JPACK align;
+    INT16 w[DCTSIZE2];
+  } ws;
+  JPACK a, b, c, d, s02, s13, q02, q13;
+  int out0, out1, out2, out3, out4, out5, out6, out7;
+  int round;
+  INT16 *wsptr;
+  const JPACK *colptr;
+  int ctr;
+  SHIFT_TEMPS
+
+  /* Pass 1: process rows.
+   * Same scaling as jpeg_fdct_islow: up by sqrt(8) and 2**PASS1_BITS.
+   */
+
+  round = 1 << (CONST_BITS-PASS1_BITS-1);
+  for (ctr = 0; ctr < DCTSIZE; ctr++) {
+    JSAMPROW elemptr = sample_data[ctr] + start_col;
+
+    a = DSP_LD32(elemptr);
+    c = DSP_LD32(elemptr + 4);
+    b = DSP_UXTB16(DSP_ROR(a, 8));	/* (e1,e3) */
+    a = DSP_UXTB16(a);			/* (e0,e2) */
+    d = DSP_UXTB16(DSP_ROR(c, 8));	/* (e5,e7) */
+    c = DSP_UXTB16(c);			/* (e4,e6) */
+
+    DCT_1D(a, b, c, d);
+
+    wsptr = &ws.w[colpos[ctr]];
+    /* Apply unsigned->signed conversion. */
+    wsptr[DCTSIZE*0] = (INT16) ((out0 - 8 * CENTERJSAMPLE) << PASS1_BITS);
+    wsptr[DCTSIZE*4] = (INT16) (out4 << PASS1_BITS);
+    wsptr[DCTSIZE*2] = (INT16) RIGHT_SHIFT(out2, CONST_BITS-PASS1_BITS);
+    wsptr[DCTSIZE*6] = (INT16) RIGHT_SHIFT(out6, CONST_BITS-PASS1_BITS);
+    wsptr[DCTSIZE*1] = (INT16) RIGHT_SHIFT(out1, CONST_BITS-PASS1_BITS);
+    wsptr[DCTSIZE*3] = (INT16) RIGHT_SHIFT(out3, CONST_BITS-PASS1_BITS);
+    wsptr[DCTSIZE*5] = (INT16) RIGHT_SHIFT(out5, CONST_BITS-PASS1_BITS);
+    wsptr[DCTSIZE*7] = (INT16) RIGHT_SHIFT(out7, CONST_BITS-PASS1_BITS);
+    DSP_TICK(9+8+3);		/* descale, STRH, loop */
+  }
+
+  /* Pass 2: process columns.
+   * We remove the PASS1_BITS scaling, but leave the results scaled up
+   * by an overall factor of 8.
+   */
+
+  round = 1 << (CONST_BITS+PASS1_BITS-1);
+  colptr = (const JPACK *) ws.w;
+  for (ctr = 0; ctr < DCTSIZE; ctr++) {
+    a = DSP_LD32A(colptr++);
+    b = DSP_LD32A(colptr++);
+    c = DSP_LD32A(colptr++);
+    d = DSP_LD32A(colptr++);
+
+    DCT_1D(a, b, c, d);
+
+    data[DCTSIZE*0] = (DCTELEM)
+      RIGHT_SHIFT(out0 + (1 << (PASS1_BITS-1)), PASS1_BITS);
+    data[DCTSIZE*4] = (DCTELEM)
+      RIGHT_SHIFT(out4 + (1 << (PASS1_BITS-1)), PASS1_BITS);
+    data[DCTSIZE*2] = (DCTELEM) RIGHT_SHIFT(out2, CONST_BITS+PASS1_BITS);
+    data[DCTSIZE*6] = (DCTELEM) RIGHT_SHIFT(out6, CONST_BITS+PASS1_BITS);
+    data[DCTSIZE*1] = (DCTELEM) RIGHT_SHIFT(out1, CONST_BITS+PASS1_BITS);
+    data[DCTSIZE*3] = (DCTELEM) RIGHT_SHIFT(out3, CONST_BITS+PASS1_BITS);
+    data[DCTSIZE*5] = (DCTELEM) RIGHT_SHIFT(out5, CONST_BITS+PASS1_BITS);
+    data[DCTSIZE*7] = (DCTELEM) RIGHT_SHIFT(out7, CONST_BITS+PASS1_BITS);
+    DSP_TICK(10+8+3);		/* descale, STR, loop */
+
+    data++;			/* advance pointer to next column */
+  }
+}
+
+
+/*
+ * Quantize/descale one block of coefficients.
+ * divisors[] is the ISLOW divisor table, recips[i] = ceil(2^32/divisors[i]);
+ * every divisor must be below 2^16.
+ */
+
+GLOBAL(void)
+jpeg_quantize_dsp (JCOEFPTR output, DCTELEM * workspace,
+		   DCTELEM * divisors, INT32 * recips)
+{
+  int temp, sign;
+  int ctr;
+
+#define QUANTIZE(i)  \
+  temp = (int) workspace[i]; \
+  sign = (temp < 0) ? -1 : 0; \
+  temp = (temp ^ sign) - sign;		/* abs */ \
+  temp += (int) divisors[i] >> 1;	/* for rounding */ \
+  temp = (int) DSP_UMULH((unsigned int) temp, (unsigned int) recips[i]); \
+  output[i] = (JCOEF) ((temp ^ sign) - sign); \
+  DSP_TICK(4+6)			/* LDR x3 STRH, ASR EOR SUB ADD EOR SUB */
+
+  /* One row per iteration keeps the loop overhead off each coefficient */
+  for (ctr = 0; ctr < DCTSIZE; ctr++) {
+    QUANTIZE(0); QUANTIZE(1); QUANTIZE(2); QUANTIZE(3);
+    QUANTIZE(4); QUANTIZE(5); QUANTIZE(6); QUANTIZE(7);
+    DSP_TICK(3);		/* pointer updates, loop */
+    workspace += DCTSIZE;
+    divisors += DCTSIZE;
+    recips += DCTSIZE;
+    output += DCTSIZE;
+  }
+}
+
+#endif /* DCT_ISLOW_DSP_SUPPORTED */
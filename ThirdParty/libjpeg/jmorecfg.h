@@ -346,6 +346,8 @@ typedef enum { FALSE = 0, TRUE = 1 } boolean;
 #define DCT_ISLOW_SUPPORTED	/* slow but accurate integer algorithm */
 #define DCT_IFAST_SUPPORTED	/* faster, less accurate integer method */
 #define DCT_FLOAT_SUPPORTED	/* floating-point: accurate, fast on fast HW */
+/* #define DCT_ISLOW_DSP_SUPPORTED    ISLOW with packed 16-bit DSP code, needs
+ *				      jfdctdsp.c; define it in jconfig.h */
 
 /* Encoder capability options: */
 